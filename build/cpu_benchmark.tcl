@@ -0,0 +1,5 @@
+# Startup script for 'make benchmark': runs the CPU benchmark on the default
+# machine without video and sound output, prints the results and exits.
+set renderer none
+set mute on
+after boot {cpu_benchmark 10 {boot z80loop vdploop} stderr exit}
@@ -53,7 +53,7 @@ endif
 # TODO: "dist" and "createsubs" are missing
 # TODO: more missing?
 # Logical targets which require dependency files.
-DEPEND_TARGETS:=all default install run bindist
+DEPEND_TARGETS:=all default install run benchmark snapshot-benchmark bindist
 # Logical targets which do not require dependency files.
 NODEPEND_TARGETS:=clean config probe 3rdparty run-3rdparty staticbindist
 # Mark all logical targets as such.
@@ -187,6 +187,9 @@ include build/flavour-$(OPENMSX_FLAVOUR).mk
 
 UNITTEST?=false
 
+# Build a shared library instead of an executable, see src/LibOpenMSX.hh.
+SHARED_LIBRARY?=false
+
 
 # Paths
 # =====
@@ -195,6 +198,9 @@ BUILD_PATH:=derived/$(PLATFORM)-$(OPENMSX_FLAVOUR)
 ifeq ($(3RDPARTY_FLAG),true)
   BUILD_PATH:=$(BUILD_PATH)-3rd
 endif
+ifeq ($(SHARED_LIBRARY),true)
+  BUILD_PATH:=$(BUILD_PATH)-lib
+endif
 
 # Own build of 3rd party libs.
 ifeq ($(3RDPARTY_FLAG),true)
@@ -224,6 +230,9 @@ LIBRARY_FULL:=$(LIBRARY_PATH)/$(LIBRARY_FILE)
 
 ifeq ($(OPENMSX_TARGET_OS),android)
 MAIN_EXECUTABLE:=$(LIBRARY_FULL)
+else ifeq ($(SHARED_LIBRARY),true)
+MAIN_EXECUTABLE:=$(LIBRARY_FULL)
+TARGET_FLAGS+=-fPIC
 else
 MAIN_EXECUTABLE:=$(BINARY_FULL)
 endif
@@ -292,6 +301,9 @@ endif
 
 ifeq ($(UNITTEST),true)
 SOURCES_FULL:=$(filter-out src/main.cc,$(SOURCES_FULL))
+else ifeq ($(SHARED_LIBRARY),true)
+SOURCES_FULL:=$(filter-out src/main.cc,$(SOURCES_FULL))
+SOURCES_FULL:=$(filter-out src/unittest/%.cc,$(SOURCES_FULL))
 else
 SOURCES_FULL:=$(filter-out src/unittest/%.cc,$(SOURCES_FULL))
 endif
@@ -436,7 +448,11 @@ $(COMPONENTS_DEFS): $(COMPONENTS_DEFS_SCRIPT) $(PROBE_MAKE) \
 
 # Default target.
 ifeq ($(OPENMSX_TARGET_OS),darwin)
+ifeq ($(SHARED_LIBRARY),true)
+all: $(MAIN_EXECUTABLE)
+else
 all: app
+endif
 else
 all: $(MAIN_EXECUTABLE)
 endif
@@ -540,6 +556,16 @@ run: all
 	$(SUM) "Running $(notdir $(BINARY_FULL))..."
 	$(CMD)$(BINARY_FULL)
 
+# Run the CPU emulation benchmark (see 'help cpu_benchmark').
+benchmark: all
+	$(SUM) "Benchmarking $(notdir $(BINARY_FULL))..."
+	$(CMD)$(BINARY_FULL) -script build/cpu_benchmark.tcl
+
+# Run the savestate/snapshot benchmark (see 'help snapshot_benchmark').
+snapshot-benchmark: all
+	$(SUM) "Benchmarking savestates of $(notdir $(BINARY_FULL))..."
+	$(CMD)$(BINARY_FULL) -script build/snapshot_benchmark.tcl
+
 
 # Installation and Binary Packaging
 # =================================
@@ -0,0 +1,5 @@
+# Startup script for 'make snapshot-benchmark': runs the savestate/snapshot
+# benchmark without video and sound output, prints the results and exits.
+set renderer none
+set mute on
+after boot {snapshot_benchmark 10 {msx2 turbor moonsound} stderr exit}
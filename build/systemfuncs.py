@@ -20,6 +20,13 @@ class FTruncateFunction(SystemFunction):
 	def iterHeaders(cls, targetPlatform):
 		yield '<unistd.h>'
 
+class InotifyInit1Function(SystemFunction):
+	name = 'inotify_init1'
+
+	@classmethod
+	def iterHeaders(cls, targetPlatform):
+		yield '<sys/inotify.h>'
+
 class MMapFunction(SystemFunction):
 	name = 'mmap'
 
@@ -29,6 +36,13 @@ class MMapFunction(SystemFunction):
 			yield '<sys/types.h>'
 		yield '<sys/mman.h>'
 
+class PosixFadviseFunction(SystemFunction):
+	name = 'posix_fadvise'
+
+	@classmethod
+	def iterHeaders(cls, targetPlatform):
+		yield '<fcntl.h>'
+
 class PosixMemAlignFunction(SystemFunction):
 	name = 'posix_memalign'
 
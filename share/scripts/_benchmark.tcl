@@ -0,0 +1,153 @@
+namespace eval benchmark {
+
+set_help_text benchmark \
+{Measure the emulation speed of the current machine.
+
+The machine runs unthrottled for a fixed amount of emulated time. Afterwards
+the results are printed as a JSON object:
+  machine           name of the benchmarked machine
+  emulated_seconds  emulated time that was run
+  real_seconds      host (wall clock) time that it took
+  speed             emulated seconds per real second
+  frames            number of frames that were painted
+  time              the real time split over:
+    vdp             the scheduled VDP work (includes rendering)
+    sound           generating the sound of all sound chips
+    scheduler       all other scheduled devices
+    tcl             Tcl scripts (callbacks, after commands, ...)
+    cpu             everything else, mostly the CPU emulation
+The split is based on 'debug scheduler_stats' and 'script_profile'. Work
+that's done directly in an I/O access of the CPU (e.g. writing VRAM) is
+counted as CPU time.
+
+Usage:
+  benchmark [<options>]
+
+Options:
+  -duration <seconds>  emulated seconds to run (default 10)
+  -video               keep the current renderer (by default the 'none'
+                       renderer is used while benchmarking)
+  -sound               don't mute the sound (it's muted by default)
+  -channel <channel>   where to print the results (default stdout)
+  -command <command>   command that's executed when the benchmark is done
+
+The command line option '-benchmark <seconds>' runs this benchmark on the
+machine that's started and exits afterwards.
+}
+
+set_tabcompletion_proc benchmark [namespace code tab_benchmark]
+proc tab_benchmark {args} {
+	return [list -duration -video -sound -channel -command]
+}
+
+proc benchmark {args} {
+	set duration 10
+	set video false
+	set sound false
+	set channel stdout
+	set command ""
+	while {[llength $args] > 0} {
+		set args [lassign $args option]
+		switch -- $option {
+			-duration {set args [lassign $args duration]}
+			-video    {set video true}
+			-sound    {set sound true}
+			-channel  {set args [lassign $args channel]}
+			-command  {set args [lassign $args command]}
+			default   {error "Invalid option: $option"}
+		}
+	}
+	if {![string is double -strict $duration] || $duration <= 0} {
+		error "Invalid duration: $duration"
+	}
+
+	set restore [list throttle $::throttle]
+	set ::throttle off
+	if {!$video} {
+		lappend restore renderer $::renderer
+		set ::renderer none
+	}
+	if {!$sound} {
+		lappend restore mute $::mute
+		set ::mute on
+	}
+	set profiling [script_profile status]
+	debug scheduler_stats reset
+	debug scheduler_stats start
+	script_profile reset
+	script_profile start
+
+	set start [dict create \
+		emu    [machine_info time] \
+		real   [openmsx_info realtime] \
+		frames [openmsx_info frames]]
+	after time $duration [namespace code [list finish \
+		$start $restore $profiling $channel $command]]
+	return ""
+}
+
+proc finish {start restore profiling channel command} {
+	set emu    [expr {[machine_info time] - [dict get $start emu]}]
+	set real   [expr {[openmsx_info realtime] - [dict get $start real]}]
+	set frames [expr {[openmsx_info frames] - [dict get $start frames]}]
+
+	debug scheduler_stats stop
+	if {!$profiling} {
+		script_profile stop
+	}
+	set vdp 0
+	set sound 0
+	set scheduler 0
+	foreach entry [debug scheduler_stats] {
+		lassign $entry name calls ns
+		if {[string match *VDP* $name] || [string match *V9990* $name]} {
+			set vdp [expr {$vdp + $ns}]
+		} elseif {[string match *Mixer* $name]} {
+			set sound [expr {$sound + $ns}]
+		} else {
+			set scheduler [expr {$scheduler + $ns}]
+		}
+	}
+	set tcl 0
+	foreach entry [script_profile report] {
+		lassign $entry name count us
+		set tcl [expr {$tcl + $us * 1000}]
+	}
+	set vdp       [expr {$vdp       / 1e9}]
+	set sound     [expr {$sound     / 1e9}]
+	set scheduler [expr {$scheduler / 1e9}]
+	set tcl       [expr {$tcl       / 1e9}]
+	set cpu [expr {max(0.0, $real - $vdp - $sound - $scheduler - $tcl)}]
+
+	dict for {setting value} $restore {
+		set ::$setting $value
+	}
+
+	puts $channel [format \
+{{
+  "machine": "%s",
+  "emulated_seconds": %.3f,
+  "real_seconds": %.3f,
+  "speed": %.3f,
+  "frames": %d,
+  "time": {
+    "vdp": %.3f,
+    "sound": %.3f,
+    "scheduler": %.3f,
+    "tcl": %.3f,
+    "cpu": %.3f
+  }
+}} [string map {\\ \\\\ \" \\\"} [machine_info config_name]] \
+		$emu $real [expr {$emu / $real}] $frames \
+		$vdp $sound $scheduler $tcl $cpu]
+
+	if {$command ne ""} {
+		uplevel #0 $command
+	}
+}
+
+namespace export benchmark
+
+} ;# namespace benchmark
+
+namespace import benchmark::*
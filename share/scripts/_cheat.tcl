@@ -1,7 +1,7 @@
-package provide cheatfinder 0.5
+package provide cheatfinder 0.6
 
 set_help_text findcheat \
-{Cheat finder version 0.5
+{Cheat finder version 0.6
 
 Welcome to the openMSX cheat finder. Please visit
   http://forum.vampier.net/viewtopic.php?t=32 and
@@ -28,11 +28,10 @@ Examples:
 namespace eval cheat_finder {
 
 variable max_num_results 15 ;# maximum to display cheats
-variable mem
 
 # build translation dictionary for convenience expressions
 variable translate [dict create \
-	""         "true"       \
+	""         ""           \
 	                        \
 	"smaller"  "new < old"  \
 	"less"     "new < old"  \
@@ -54,7 +53,7 @@ variable translate [dict create \
 	"<="       "new <= old" \
 	">="       "new >= old" \
 	"<"        "new <  old" \
-	">"        "new <  old" \
+	">"        "new >  old" \
 	"=="       "new == old" \
 	"!="       "new != old"]
 
@@ -70,44 +69,44 @@ proc tab_cheat_type {args} {
 
 # Restart cheat finder.
 proc start {} {
-	variable mem [dict create]
-
-	set mymem [debug read_block memory 0 0x10000]
-	binary scan $mymem c* values
-	set addr 0
-	foreach val $values {
-		dict append mem $addr $val
-		incr addr
-	}
+	debug search start memory
 }
 
-# Helper function to do the actual search.
-# Returns a list of triplets (addr, old, new)
+# Helper function to do the actual search. Simple comparisons are done by
+# 'debug search filter' (fast, for all candidates at once), other expressions
+# are evaluated in Tcl for each remaining candidate.
 proc search {expression} {
-	variable mem
+	if {$expression eq ""} return
+	if {[regexp {^\s*new\s*(==|!=|<=|>=|<|>)\s*(old|\d+|0x[0-9a-fA-F]+)\s*$} \
+			$expression -> op value]} {
+		if {$value eq "old"} {
+			debug search filter $op
+		} else {
+			debug search filter $op $value
+		}
+		return
+	}
 
-	set result [list]
-	dict for {addr old} $mem {
+	# prefix 'old', 'new' and 'addr' with '$'
+	set expression [string map {old $old new $new addr $addr} $expression]
+	set keep [list]
+	foreach {addr prev old} [join [debug search results]] {
 		set new [debug read memory $addr]
 		#note: NO braces around $expression
 		if $expression {
-			dict set mem $addr $new
-			lappend result [list $addr $old $new]
-		} else {
-			dict unset mem $addr
+			lappend keep $addr
 		}
 	}
-	return $result
+	debug search keep $keep
 }
 
 # main routine
 proc findcheat {args} {
-	variable mem
 	variable max_num_results
 	variable translate
 
-	# create mem dictionary
-	if {![info exists mem]} start
+	# start a search if there is none yet
+	if {[catch {debug search count}]} start
 
 	# parse options
 	while (1) {
@@ -135,20 +134,16 @@ proc findcheat {args} {
 		set expression "new == $expression"
 	}
 
-	# prefix 'old', 'new' and 'addr' with '$'
-	set expression [string map {old $old new $new addr $addr} $expression]
-
 	# search memory
-	set result [search $expression]
+	search $expression
 
 	# display the result
-	set num [llength $result]
+	set num [debug search count]
 	if {$num == 0} {
 		return "No results left"
 	} elseif {$num <= $max_num_results} {
 		set output ""
-		set sorted [lsort -integer -index 0 $result]
-		foreach {addr old new} [join $sorted] {
+		foreach {addr old new} [join [debug search results]] {
 			append output [format "0x%04X : %d -> %d\n" $addr $old $new]
 		}
 		return $output
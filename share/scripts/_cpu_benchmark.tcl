@@ -0,0 +1,155 @@
+namespace eval cpu_benchmark {
+
+set_help_text cpu_benchmark \
+{Measure the speed of the CPU emulation.
+
+Each workload runs unthrottled for a fixed amount of emulated time on the
+current machine. For each workload the emulated seconds per host second and
+the resulting effective CPU clock (in MHz) are reported. For
+reproducible numbers use 'set renderer none' and 'set mute on', or use
+'make benchmark' which does this for you.
+
+Usage:
+  cpu_benchmark [<duration> [<workloads> [<channel> [<command>]]]]
+
+  <duration>   emulated seconds per workload (default 10)
+  <workloads>  list of workloads (default all of them):
+                 boot     reset the machine and run the boot code
+                 z80loop  a loop of typical Z80 instructions in RAM
+                 vdploop  a loop that writes to VRAM with OTIR
+  <channel>    where to print the results (default stdout)
+  <command>    command that's executed when all workloads are done
+
+The workloads (except 'boot') run on the CPU that is active after the
+machine has booted, so on a turbo R machine that's the R800.
+}
+
+set_tabcompletion_proc cpu_benchmark [namespace code tab_cpu_benchmark]
+proc tab_cpu_benchmark {args} {
+	if {[llength $args] == 3} {
+		return [list boot z80loop vdploop]
+	}
+	return [list]
+}
+
+# Machine code of the workloads, they're placed in RAM at address 0xC000.
+variable code [dict create \
+	z80loop {
+		0xF3                   ;# di
+		0x21 0x00 0xD0         ;# loop1: ld hl,#D000
+		0x11 0x00 0xE0         ;# ld de,#E000
+		0x01 0x00 0x01         ;# ld bc,#0100
+		0xED 0xB0              ;# ldir
+		0xDD 0x21 0x00 0xD0    ;# ld ix,#D000
+		0x06 0x00              ;# ld b,0
+		0xDD 0x7E 0x00         ;# loop2: ld a,(ix+0)
+		0x87                   ;# add a,a
+		0xCB 0x1F              ;# rr a
+		0xC5                   ;# push bc
+		0xCD 0x21 0xC0         ;# call sub
+		0xC1                   ;# pop bc
+		0x10 0xF3              ;# djnz loop2
+		0x18 0xE0              ;# jr loop1
+		0xDD 0x23              ;# sub: inc ix
+		0xD9                   ;# exx
+		0x08                   ;# ex af,af'
+		0xD9                   ;# exx
+		0x08                   ;# ex af,af'
+		0xC9                   ;# ret
+	} \
+	vdploop {
+		0xF3                   ;# di
+		0xAF                   ;# loop: xor a
+		0xD3 0x99              ;# out (#99),a
+		0x3E 0x40              ;# ld a,#40
+		0xD3 0x99              ;# out (#99),a
+		0x21 0x00 0xD0         ;# ld hl,#D000
+		0x0E 0x98              ;# ld c,#98
+		0x06 0x00              ;# ld b,0
+		0xED 0xB3              ;# otir
+		0x18 0xEE              ;# jr loop
+	}]
+
+# emulated seconds to wait for the machine to boot before starting a workload
+variable boot_time 3
+
+variable results
+variable old_throttle
+
+proc cpu_benchmark {{duration 10} {workloads {boot z80loop vdploop}} {channel stdout} {command ""}} {
+	variable code
+	variable results
+	variable old_throttle
+
+	foreach workload $workloads {
+		if {$workload ne "boot" && ![dict exists $code $workload]} {
+			error "Unknown workload: $workload"
+		}
+	}
+	set results [list]
+	set old_throttle $::throttle
+	set ::throttle off
+	next_workload $duration $workloads $channel $command
+	return ""
+}
+
+proc next_workload {duration workloads channel command} {
+	variable results
+	variable old_throttle
+	variable boot_time
+
+	if {[llength $workloads] == 0} {
+		set ::throttle $old_throttle
+		foreach {workload emu real} $results {
+			report $workload $emu $real $channel
+		}
+		if {$command ne ""} {
+			uplevel #0 $command
+		}
+		return
+	}
+	set workloads [lassign $workloads workload]
+	reset
+	if {$workload eq "boot"} {
+		start_workload $workload $duration $workloads $channel $command
+	} else {
+		after time $boot_time [namespace code [list load_workload \
+			$workload $duration $workloads $channel $command]]
+	}
+}
+
+proc load_workload {workload duration workloads channel command} {
+	variable code
+	set bytes [regsub -all {;#[^\n]*} [dict get $code $workload] ""]
+	debug write_block memory 0xC000 [binary format c* $bytes]
+	reg pc 0xC000
+	start_workload $workload $duration $workloads $channel $command
+}
+
+proc start_workload {workload duration workloads channel command} {
+	set emu_start [machine_info time]
+	set real_start [openmsx_info realtime]
+	after time $duration [namespace code [list stop_workload \
+		$workload $emu_start $real_start $duration $workloads $channel $command]]
+}
+
+proc stop_workload {workload emu_start real_start duration workloads channel command} {
+	variable results
+	set emu  [expr {[machine_info time] - $emu_start}]
+	set real [expr {[openmsx_info realtime] - $real_start}]
+	lappend results $workload $emu $real
+	next_workload $duration $workloads $channel $command
+}
+
+proc report {workload emu real channel} {
+	set freq [machine_info [get_active_cpu]_freq]
+	set speed [expr {$emu / $real}]
+	puts $channel [format "%-8s %7.2f x realtime  %8.2f MHz  (%.2fs in %.2fs)" \
+		$workload $speed [expr {$speed * $freq / 1e6}] $emu $real]
+}
+
+namespace export cpu_benchmark
+
+} ;# namespace cpu_benchmark
+
+namespace import cpu_benchmark::*
@@ -136,10 +136,9 @@ Usage:
 }
 proc disasm {{address -1} {num 8}} {
 	if {$address == -1} {set address [reg PC]}
-	for {set i 0} {$i < int($num)} {incr i} {
-		set l [debug disasm $address]
-		append result [format "%04X  %s\n" $address [join $l]]
-		set address [expr {($address + [llength $l] - 1) & 0xFFFF}]
+	set result ""
+	foreach l [debug disasm_block $address [expr {int($num)}]] {
+		append result [format "%04X  %s\n" [lindex $l 0] [join [lrange $l 1 end]]]
 	}
 	return $result
 }
@@ -0,0 +1,94 @@
+set_help_text toggle_frame_profile \
+{Shows a graph on the On-Screen-Display with where the host time of the last
+frames went (see 'help frame_profile'). Each bar is one frame, its height is
+the duration of the frame (a horizontal line is drawn at 20ms), the colors
+are the categories. Use the command again to remove the graph.}
+
+namespace eval frame_profile_osd {
+
+variable after_id
+variable num_bars 64
+variable bar_width 2
+variable height 80 ;# pixels, corresponds to 40ms
+variable us_per_pixel 500
+# one color per category, see 'frame_profile categories'
+variable colors {
+	0x808080ff 0x4080ffff 0x40ff40ff 0xffff40ff
+	0xff8040ff 0xff40ffff 0x40ffffff 0x202020ff
+}
+
+proc update_graph {} {
+	variable after_id
+	variable num_bars
+	variable height
+	variable us_per_pixel
+
+	set frames [frame_profile frames $num_bars]
+	set offset [expr {$num_bars - [llength $frames]}]
+	set ncat [llength [frame_profile categories]]
+	for {set i 0} {$i < $num_bars} {incr i} {
+		set times [lindex $frames [expr {$i - $offset}]]
+		set y $height
+		for {set c 0} {$c < $ncat} {incr c} {
+			set h [expr {($times eq "") ? 0 : [lindex $times $c] / $us_per_pixel}]
+			if {$h > $y} {set h $y}
+			incr y -$h
+			osd configure frame_profile.bar$i.cat$c -y $y -h $h
+		}
+	}
+	set after_id [after realtime 0.2 frame_profile_osd::update_graph]
+}
+
+proc create_graph {} {
+	variable num_bars
+	variable bar_width
+	variable height
+	variable us_per_pixel
+	variable colors
+
+	set categories [frame_profile categories]
+	set width [expr {$num_bars * $bar_width}]
+	osd create rectangle frame_profile \
+		-x 4 -y 4 -w [expr {$width + 64}] -h [expr {$height + 2}] \
+		-rgba 0x00000080 -scaled true -clip true
+	for {set i 0} {$i < $num_bars} {incr i} {
+		osd create rectangle frame_profile.bar$i \
+			-x [expr {1 + $i * $bar_width}] -y 1 \
+			-w $bar_width -h $height -alpha 0
+		for {set c 0} {$c < [llength $categories]} {incr c} {
+			osd create rectangle frame_profile.bar$i.cat$c \
+				-w $bar_width -h 0 -rgba [lindex $colors $c]
+		}
+	}
+	osd create rectangle frame_profile.line20ms \
+		-x 1 -y [expr {1 + $height - 20000 / $us_per_pixel}] \
+		-w $width -h 1 -rgba 0xffffff60
+	set y 1
+	set c 0
+	foreach category $categories {
+		osd create text frame_profile.legend$c \
+			-x [expr {$width + 4}] -y $y -size 8 \
+			-rgba [lindex $colors $c] -text $category
+		incr y 10
+		incr c
+	}
+}
+
+proc toggle_frame_profile {} {
+	variable after_id
+	if {[info exists after_id]} {
+		after cancel $after_id
+		osd destroy frame_profile
+		unset after_id
+	} else {
+		create_graph
+		update_graph
+	}
+	return ""
+}
+
+namespace export toggle_frame_profile
+
+} ;# namespace frame_profile_osd
+
+namespace import frame_profile_osd::*
@@ -5,6 +5,9 @@ set_help_text multi_screenshot \
 
 Usage:
  multi_screenshot <num> [<base>]
+
+The PNG files are written in the background (see 'screenshot -async'), so
+that taking the screenshots doesn't slow down the emulation.
 }
 
 proc multi_screenshot {num {base ""}} {
@@ -15,9 +18,9 @@ proc multi_screenshot {num {base ""}} {
 proc multi_screenshot_helper {acc max {base ""}} {
 	if {$acc <= $max} {
 		if {$base eq ""} {
-			screenshot
+			screenshot -async
 		} else {
-			screenshot -prefix $base
+			screenshot -async -prefix $base
 		}
 		after frame "[namespace code multi_screenshot_helper] [expr {$acc + 1}] $max $base"
 	}
@@ -118,7 +118,6 @@ proc update_keyboard {} {
 	variable num_notes
 	variable note_strings
 	variable note_key_color
-	variable frame_trigger_id
 
 	dict for {soundchip chip_dict} $keyb_dict {
 		dict for {channel chan_dict} $chip_dict {
@@ -154,7 +153,6 @@ proc update_keyboard {} {
 				-text $note_text
 		}
 	}
-	set frame_trigger_id [after frame [namespace code update_keyboard]]
 }
 
 proc music_keyboard_reset {} {
@@ -178,6 +176,7 @@ proc toggle_music_keyboard {} {
 	} else {
 		keyboard_init
 		update_keyboard
+		set frame_trigger_id [after frame -repeat [namespace code update_keyboard]]
 	}
 	return ""
 }
@@ -260,16 +260,24 @@ proc auto_save_setting_changed {name1 name2 op} {
 		} elseif {!$::auto_save_replay && $auto_save_after_id != 0 } {
 			after cancel $auto_save_after_id
 			set auto_save_after_id 0
+			catch {reverse journal stop}
 			puts "Auto-save of replay disabled."
 		}
 	}
 }
 
+# The replay is written as a journal: each time only the new data is appended
+# to the file, instead of writing the whole replay again.
 proc auto_save_replay_loop {} {
 	variable auto_save_after_id
 
 	if {$::auto_save_replay} {
-		reverse savereplay -maxnofextrasnapshots 0 $::auto_save_replay_filename
+		if {[reverse journal] eq ""} {
+			# (re)start, e.g. after switching to another machine
+			reverse journal start $::auto_save_replay_filename
+		} else {
+			reverse journal flush
+		}
 
 		set auto_save_after_id [after realtime $::auto_save_replay_interval "reverse::auto_save_replay_loop"]
 	}
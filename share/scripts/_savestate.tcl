@@ -19,8 +19,39 @@ proc savestate_common {} {
 	}
 }
 
-proc savestate {{name ""}} {
+# parses the options of savestate/loadstate, returns the remaining name
+proc parse_options {args} {
+	upvar memory memory write write
+	set memory false
+	set write false
+	while {[string index [lindex $args 0] 0] eq "-"} {
+		set args [lassign $args option]
+		switch -- $option {
+			"-memory" {set memory true}
+			"-write"  {set memory true; set write true}
+			"default" {error "Invalid option: $option"}
+		}
+	}
+	if {[llength $args] > 1} {
+		error "Too many arguments"
+	}
+	return [lindex $args 0]
+}
+
+proc savestate {args} {
+	set name [parse_options {*}$args]
 	savestate_common
+	if {$memory} {
+		if {$write} {
+			# the file is written in the background
+			file mkdir $directory
+			savestate_slot store $name [machine] $fullname_oms
+			file delete -- $fullname_gz
+		} else {
+			savestate_slot store $name [machine]
+		}
+		return $name
+	}
 	file mkdir $directory
 	if {[catch {screenshot -raw -doublesize $png}]} {
 		# some renderers don't support msx-only screenshots
@@ -39,9 +70,14 @@ proc savestate {{name ""}} {
 	return $name
 }
 
-proc loadstate {{name ""}} {
+proc loadstate {args} {
+	set name [parse_options {*}$args]
 	savestate_common
-	set newID [restore_machine $fullname_bwcompat]
+	if {$memory} {
+		set newID [savestate_slot restore $name]
+	} else {
+		set newID [restore_machine $fullname_bwcompat]
+	}
 	set currentID [machine]
 	if {$currentID ne ""} {delete_machine $currentID}
 	activate_machine $newID
@@ -112,24 +148,28 @@ proc savestate_list_tab {args} {
 
 # savestate
 set_help_text savestate \
-{savestate [<name>]
+{savestate [-memory] [-write] [<name>]
 
 Create a snapshot of the current emulated MSX machine.
 
 Optionally you can specify a name for the savestate. If you omit this the default name 'quicksave' will be taken.
 
+With -memory the snapshot is kept in memory (in a slot with the given name) instead of being written to a file. Loading it again with 'loadstate -memory' is much faster. With -write the state is also written to the savestate file, in the background.
+
 See also 'loadstate', 'list_savestates', 'delete_savestate'.
 }
 set_tabcompletion_proc savestate [namespace code savestate_tab]
 
 # loadstate
 set_help_text loadstate \
-{loadstate [<name>]
+{loadstate [-memory] [<name>]
 
 Restore a previously created savestate.
 
 You can specify the name of the savestate that should be loaded. If you omit this name, the default savestate will be loaded.
 
+With -memory the savestate is loaded from the in-memory slot created with 'savestate -memory'.
+
 See also 'savestate', 'list_savestates', 'delete_savestate'.
 }
 set_tabcompletion_proc loadstate [namespace code savestate_tab]
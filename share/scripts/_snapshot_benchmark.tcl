@@ -0,0 +1,182 @@
+namespace eval snapshot_benchmark {
+
+set_help_text snapshot_benchmark \
+{Measure the speed and size of savestates, snapshots and replays.
+
+For each configuration a new machine is created and run for a while, then
+these are measured:
+  snapshot  in-memory snapshots (like the reverse snapshots, via
+            'savestate_slot'), taken with some emulated time in between.
+            Reported: the average time per snapshot, the size of the
+            state itself and the number and size of the memory blocks
+            (see 'savestate_slot info'), and the time to restore a
+            snapshot into a new machine.
+  xml       'store_machine' and 'restore_machine' with a savestate file.
+  binary    the same with the binary savestate format.
+  replay    'reverse savereplay' and 'reverse loadreplay'.
+The file sizes are those of the written files. Configurations that can't be
+created (e.g. because the system ROMs are missing) are skipped. The current
+machine stays as it was. For reproducible numbers use 'set renderer none'
+and 'set mute on', or use 'make snapshot-benchmark' which does this for you.
+
+Usage:
+  snapshot_benchmark [<count> [<configs> [<channel> [<command>]]]]
+
+  <count>    number of snapshots per configuration (default 10)
+  <configs>  list of configurations (default all of them):
+               msx2       C-BIOS MSX2, which has a 512kB memory mapper
+               turbor     Panasonic FS-A1GT
+               moonsound  C-BIOS MSX2+ with a MoonSound and a 4MB mapper
+  <channel>  where to print the results (default stdout)
+  <command>  command that's executed when all configurations are done
+}
+
+set_tabcompletion_proc snapshot_benchmark [namespace code tab_snapshot_benchmark]
+proc tab_snapshot_benchmark {args} {
+	variable configs
+	if {[llength $args] == 3} {
+		return [dict keys $configs]
+	}
+	return [list]
+}
+
+# configuration name -> {machine extensions}
+variable configs [dict create \
+	msx2      {C-BIOS_MSX2 {}} \
+	turbor    {Panasonic_FS-A1GT {}} \
+	moonsound {C-BIOS_MSX2+ {moonsound ram4mb}}]
+
+# emulated seconds before the first snapshot, and between the snapshots
+variable warmup_time 3
+variable interval 1
+
+variable old_machine
+variable old_throttle
+
+proc snapshot_benchmark {{count 10} {names ""} {channel stdout} {command ""}} {
+	variable configs
+	variable old_machine
+	variable old_throttle
+
+	if {$names eq ""} {set names [dict keys $configs]}
+	foreach name $names {
+		if {![dict exists $configs $name]} {
+			error "Unknown configuration: $name"
+		}
+	}
+	set old_machine [machine]
+	set old_throttle $::throttle
+	set ::throttle off
+	next_config $count $names $channel $command
+	return ""
+}
+
+proc next_config {count names channel command} {
+	variable configs
+	variable old_machine
+	variable old_throttle
+	variable warmup_time
+
+	if {[llength $names] == 0} {
+		if {$old_machine ne ""} {activate_machine $old_machine}
+		set ::throttle $old_throttle
+		if {$command ne ""} {
+			uplevel #0 $command
+		}
+		return
+	}
+	set names [lassign $names name]
+	lassign [dict get $configs $name] config extensions
+	set id [create_machine]
+	if {[catch {
+		${id}::load_machine $config
+		foreach ext $extensions {${id}::ext $ext}
+	} error_result]} {
+		delete_machine $id
+		puts $channel [format "%-10s skipped: %s" $name $error_result]
+		# not from within this (machine specific) callback
+		after realtime 0 [namespace code [list next_config $count $names $channel $command]]
+		return
+	}
+	activate_machine $id
+	reverse start
+	after time $warmup_time [namespace code [list take_snapshot \
+		$id $name 0 $count {} $names $channel $command]]
+}
+
+proc take_snapshot {id name i count times names channel command} {
+	variable interval
+	lappend times [lindex [time {savestate_slot store snapshot_benchmark_$i}] 0]
+	incr i
+	if {$i < $count} {
+		after time $interval [namespace code [list take_snapshot \
+			$id $name $i $count $times $names $channel $command]]
+	} else {
+		# Creating and deleting machines is done outside of the
+		# callbacks of the measured machine.
+		after realtime 0 [namespace code [list measure \
+			$id $name $count $times $names $channel $command]]
+	}
+}
+
+proc measure {id name count times names channel command} {
+	if {[catch {
+		report_snapshots $id $name $count $times $channel
+		report_savestate $id $name xml  {}      $channel
+		report_savestate $id $name binary -binary $channel
+		set id [report_replay $id $name $channel]
+	} error_result]} {
+		puts $channel [format "%-10s error: %s" $name $error_result]
+	}
+	for {set i 0} {$i < $count} {incr i} {
+		catch {savestate_slot delete snapshot_benchmark_$i}
+	}
+	delete_machine $id
+	next_config $count $names $channel $command
+}
+
+proc report_snapshots {id name count times channel} {
+	set total 0
+	foreach t $times {set total [expr {$total + $t}]}
+	# The first snapshot stores all memory, the later ones mostly refer
+	# to unchanged blocks. So report the sizes of the last one.
+	set last snapshot_benchmark_[expr {$count - 1}]
+	set info [savestate_slot info $last]
+	set restore [lindex [time {set new_id [savestate_slot restore $last]}] 0]
+	delete_machine $new_id
+	puts $channel [format "%-10s snapshot %8.2f ms  restore %8.2f ms  %9d bytes + %d blocks (%d bytes)" \
+		$name [expr {$total / 1000.0 / $count}] [expr {$restore / 1000.0}] \
+		[dict get $info bytes] [dict get $info blocks] [dict get $info block_bytes]]
+}
+
+proc report_savestate {id name format option channel} {
+	close [file tempfile filename]
+	set save [lindex [time {store_machine {*}$option $id $filename}] 0]
+	set size [file size $filename]
+	set load [lindex [time {set new_id [restore_machine $filename]}] 0]
+	delete_machine $new_id
+	file delete -- $filename
+	report_file $name $format $save $load $size $channel
+}
+
+# 'reverse loadreplay' replaces the machine, returns the ID of the new one.
+proc report_replay {id name channel} {
+	close [file tempfile filename]
+	set save [lindex [time {reverse savereplay $filename}] 0]
+	set size [file size $filename]
+	set load [lindex [time {reverse loadreplay $filename}] 0]
+	file delete -- $filename
+	report_file $name replay $save $load $size $channel
+	return [machine]
+}
+
+proc report_file {name format save load size channel} {
+	puts $channel [format "%-10s %-8s save %8.2f ms  load %8.2f ms  %9d bytes" \
+		$name $format [expr {$save / 1000.0}] [expr {$load / 1000.0}] $size]
+}
+
+namespace export snapshot_benchmark
+
+} ;# namespace snapshot_benchmark
+
+namespace import snapshot_benchmark::*
@@ -106,6 +106,37 @@ proc show_sprite {sprite} {
 	}
 }
 
+proc view_all_sprites {} {
+	if {![osd exists all_sprites]} {
+		osd create rectangle all_sprites -x 0 -y 0 -w 256 -h 64 -rgba 0x00000080
+		osd create rectangle all_sprites.image
+		update_all_sprites
+	}
+	return ""
+}
+
+proc update_all_sprites {} {
+	if {![osd exists all_sprites]} return
+	if {[catch {osd configure all_sprites.image -imagedata [vdp_image sprites]}]} {
+		# no sprites in this display mode
+		osd configure all_sprites.image -imagedata {}
+	}
+	after frame [namespace code update_all_sprites]
+}
+
+proc hide_all_sprites_viewer {} {
+	catch {osd destroy all_sprites}
+	return ""
+}
+
+set_help_text view_all_sprites \
+{Shows all patterns of the sprite pattern table, 32 per row for 8x8 sprites
+or 16 per row for 16x16 sprites. The view is updated every frame. Hide it
+with hide_all_sprites_viewer.}
+
+set_help_text hide_all_sprites_viewer \
+{Hide the viewer you summoned with the view_all_sprites command.}
+
 proc draw_matrix {matrixname x y blocksize matrixsize matrixgap} {
 	osd create rectangle $matrixname \
 		-x $x \
@@ -129,6 +160,8 @@ proc draw_matrix {matrixname x y blocksize matrixsize matrixgap} {
 }
 
 namespace export sprite_viewer
+namespace export view_all_sprites
+namespace export hide_all_sprites_viewer
 
 } ;# namespace osd_menu
 
@@ -7,16 +7,17 @@
 # The work is provided "as is" without warranty of any kind, neither express
 # nor implied.
 
-set_help_text test_all_machines "Test all known machines and report errors. Pass 'stderr' as channel argument to get the return values on the commandline."
+set_help_text test_all_machines "Test all known machines and report errors and the time each test took. The machines are tested in parallel, using one worker process per CPU core. Pass 'stderr' as channel argument to get the return values on the commandline. The optional second argument is the number of worker processes (1 tests all machines in this process, one after the other)."
 
-proc test_all_machines {{channel "stdout"}} {
-	set nof_machines [llength [openmsx_info machines]]
+proc test_all_machines {{channel "stdout"} {jobs 0}} {
+	set machines [openmsx_info machines]
+	set nof_machines [llength $machines]
 	set broken [list]
 	set errors [list]
 	puts $channel "Going to test $nof_machines machines..."
-	foreach machine [openmsx_info machines] {
-		puts -nonewline $channel "Testing $machine ([utils::get_machine_display_name_by_config_name $machine])... "
-		set res [test_machine $machine]
+	set start [openmsx_info realtime]
+	foreach item [test_machine -jobs $jobs {*}$machines] {
+		lassign $item machine res ms
 		if {$res != ""} {
 			lappend broken $machine
 			lappend errors $res
@@ -24,12 +25,15 @@ proc test_all_machines {{channel "stdout"}} {
 		} else {
 			set res "OK"
 		}
-		puts $channel $res
+		puts $channel [format "Testing %s (%s)... %s (%.0fms)" $machine \
+			[utils::get_machine_display_name_by_config_name $machine] $res $ms]
 	}
+	set total [expr {[openmsx_info realtime] - $start}]
 	set nof_ok [expr {$nof_machines - [llength $broken]}]
 	set perc [expr {($nof_ok*100)/$nof_machines}]
 	puts $channel ""
-	puts $channel "$nof_ok out of $nof_machines machines OK ($perc\%)"
+	puts $channel [format "%d out of %d machines OK (%d%%), tested in %.1fs" \
+		$nof_ok $nof_machines $perc $total]
 	if {$nof_ok < $nof_machines} {
 		puts $channel ""
 		puts $channel "Broken machines:"
@@ -90,55 +90,21 @@ proc view_tile {tile} {
 
 proc view_all_tiles {} {
 	if {![osd exists all_tiles]} {
-
-		osd create rectangle all_tiles -x 0 -y 0 -h 255 -w 255 -rgba 0xff0000ff
-
-		for {set x 0} {$x < 256} {incr x} {
-			for {set y 0} {$y < 192} {incr y} {
-				osd create rectangle all_tiles.${x}_${y} -x $x -y $y -h 1 -w 1
-			}
-		}
-	}
-
-	if {[get_screen_mode] != 2} {
-		for {set x 0} {$x < 256} {incr x} {
-			for {set y 0} {$y < 192} {incr y} {
-				osd configure all_tiles.${x}_${y} -rgb 0xffffff
-			}
-		}
-		return
-	}
-
-	for {set i 0} {$i < 16} {incr i} {
-		lassign [split [getcolor $i] {}] r g b
-		set rgbval($i) [expr {($r << (5 + 16)) + ($g << (5 + 8)) + ($b << 5)}]
+		osd create rectangle all_tiles -x 0 -y 0
+		update_all_tiles
 	}
+	return ""
+}
 
-	set color_addr   [expr {(([vdpreg 10] << 8 | [vdpreg 3]) << 6) & 0x1e000}]
-	set pattern_addr [expr {([vdpreg 4] & 0x3c) << 11}]
-	for {set y 0} {$y < 192} {incr y 8} {
-		for {set x 0} {$x < 256} {incr x 8} {
-			set ypos $y
-			for {set yt 0} {$yt < 8} {incr yt} {
-				set pattern [vpeek $pattern_addr]
-				set col     [vpeek $color_addr]
-				incr pattern_addr
-				incr color_addr
-
-				set bc [expr {$col >> 4}]
-				set fc [expr {$col & 0x0f}]
-
-				set mask 0x80
-				set xpos $x
-				for {set xt 0} {$xt < 8} {incr xt} {
-					osd configure all_tiles.${xpos}_${ypos} -rgb $rgbval([expr {($pattern & $mask) ? $bc : $fc}])
-					set mask [expr {$mask >> 1}]
-					incr xpos
-				}
-				incr ypos
-			}
-		}
+# Rendering the pattern table natively only takes microseconds, so it can be
+# refreshed every frame.
+proc update_all_tiles {} {
+	if {![osd exists all_tiles]} return
+	if {[catch {osd configure all_tiles -imagedata [vdp_image patterns]}]} {
+		# e.g. bitmap display mode
+		osd configure all_tiles -imagedata {}
 	}
+	after frame [namespace code update_all_tiles]
 }
 
 proc hide_all_tiles_viewer {} {
@@ -158,10 +124,19 @@ pixels between fore- and background colors with a mouse click.}
 
 set_help_text hide_tile_viewer\
 {Hide the tile viewer you summoned with the view_tile command.}
+
+set_help_text view_all_tiles\
+{Shows the complete pattern table (in pattern modes) with the colors of the
+color table, 32 tiles per row. The view is updated every frame. Hide it with
+hide_all_tiles_viewer.}
+
+set_help_text hide_all_tiles_viewer\
+{Hide the viewer you summoned with the view_all_tiles command.}
+
 namespace export view_tile
 namespace export hide_tile_viewer
-
-# for now do not expose the all tile viewer, as it is extremely slow
+namespace export view_all_tiles
+namespace export hide_all_tiles_viewer
 
 } ;# namespace tileviewer
 
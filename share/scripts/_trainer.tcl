@@ -126,15 +126,33 @@ proc execute {} {
 	variable items_active
 	variable after_id
 
+	variable pending
+
 	set items  [dict get $trainers $active_trainer items ]
 	set repeat [dict get $trainers $active_trainer repeat]
+	set pending [dict create]
 	foreach {item_name item_impl} $items item_active $items_active {
 		if {$item_active} {
 			eval $item_impl
 		}
 	}
+	# one (recorded) write per debuggable, instead of one per poke
+	dict for {m pokes} $pending {
+		debug write_multi $m {*}$pokes
+	}
 	set after_id [after {*}$repeat trainer::execute]
 }
+
+# The trainer items are evaluated in this namespace, so these replace the
+# global poke and dpoke procs: they collect the writes for execute.
+variable pending [dict create]
+proc poke {addr val {m memory}} {
+	variable pending
+	dict lappend pending $m $addr $val
+}
+proc dpoke {addr val {m memory}} {
+	if {[peek $addr $m] != $val} {poke $addr $val $m}
+}
 proc deactivate {} {
 	variable after_id
 	variable active_trainer
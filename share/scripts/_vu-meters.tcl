@@ -101,7 +101,6 @@ proc update_meters {} {
 	variable vu_meters_active
 	variable volume_cache
 	variable volume_expr
-	variable frame_trigger_id
 
 	# update meters with the volumes
 	if {!$vu_meters_active} return
@@ -120,9 +119,6 @@ proc update_meters {} {
 		# a chip disappeared probably, let's reinit to see which there are now
 		vu_meters_reinit
 	}
-	# here you can customize the update frequency (to reduce CPU load)
-	#set frame_trigger_id [after time 0.05 [namespace code update_meters]]
-	set frame_trigger_id [after frame [namespace code update_meters]]
 }
 
 proc update_meter {meter volume} {
@@ -164,6 +160,7 @@ proc toggle_vu_meters {} {
 		set vu_meters_active true
 		vu_meters_init
 		update_meters
+		set frame_trigger_id [after frame -repeat [namespace code update_meters]]
 	}
 	return ""
 }
@@ -51,4 +51,66 @@ proc initial_set {} {
 
 after realtime 0 [namespace code initial_set]
 
+
+user_setting create boolean cassette_fast_load \
+"Whether you want to load CAS images in the cassetteplayer quickly. The BIOS
+routines that read the tape are intercepted: they directly move the tape to
+the next header or read the next byte. Unlike with the
+fast_cas_load_hack_enabled setting, all other cassetteplayer functionality
+keeps working. And because the tape position moves along, (custom) loaders
+that don't use the BIOS still work, they just load at normal speed. WAV
+images always load at normal speed." false
+
+variable fast_load_bps [list]
+
+proc update_fast_load {args} {
+	variable fast_load_bps
+	foreach bp $fast_load_bps {
+		catch {debug remove_bp $bp}
+	}
+	set fast_load_bps [list]
+	if {$::cassette_fast_load} {
+		# Only the entries in the BIOS jump table (TAPION and TAPIN)
+		# are intercepted, code that calls the routines in some
+		# other way loads at normal speed.
+		foreach {addr func} {0x00E1 fast_tapion 0x00E4 fast_tapin} {
+			lappend fast_load_bps [debug set_bp $addr {[pc_in_slot 0 0]} \
+				[namespace code $func]]
+		}
+	}
+}
+
+proc fast_load_active {} {
+	# The old hack replaces the cassetteplayer command, SVI has a different
+	# format and BIOS.
+	expr {!$::fast_cas_load_hack_enabled && [machine_info type] ne "SVI"}
+}
+
+proc fast_ret {} {
+	reg PC [peek16 [reg SP]]
+	reg SP [expr {[reg SP] + 2}]
+}
+
+proc fast_tapion {} {
+	# Skip most of the silence and the header, but still let the BIOS
+	# routine read the last part of the header. That also turns on the
+	# motor and measures the signal, like for a normal load.
+	if {[fast_load_active]} {
+		catch {cassetteplayer readheader}
+	}
+}
+
+proc fast_tapin {} {
+	# When it's not possible (e.g. a WAV image or end of the data), just
+	# execute the BIOS routine.
+	if {![fast_load_active] ||
+	    [catch {cassetteplayer readbyte} value] || ($value < 0)} return
+	reg A $value
+	reg F 0x40 ;# ok, clear carry flag
+	fast_ret
+}
+
+trace add variable ::cassette_fast_load write [namespace code update_fast_load]
+after realtime 0 [namespace code update_fast_load]
+
 } ;# namespace cashandler
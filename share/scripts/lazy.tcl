@@ -59,7 +59,8 @@ register_lazy "_slot.tcl" {
 register_lazy "_soundchip_utils.tcl" {
 	get_num_channels get_volume_expr get_frequency_expr}
 register_lazy "_soundlog.tcl" soundlog
-register_lazy "_sprites.tcl" {sprite_viewer draw_matrix}
+register_lazy "_sprites.tcl" {
+	sprite_viewer draw_matrix view_all_sprites hide_all_sprites_viewer}
 register_lazy "_stack.tcl" stack
 register_lazy "_tas_tools.tcl" {
 	toggle_frame_counter prev_frame next_frame start_of_frame
@@ -72,7 +73,6 @@ register_lazy "_tileviewer.tcl" {view_tile hide_tile_viewer view_all_tiles hide_
 register_lazy "_toggle_freq.tcl" toggle_freq
 register_lazy "_trainer.tcl" trainer
 register_lazy "_type_from_file.tcl" {type_from_file type_password_from_file}
-register_lazy "_type_via_keybuf.tcl" {type_via_keybuf}
 register_lazy "_utils.tcl" {
 	get_machine_display_name get_machine_display_name_by_config_name
 	get_extension_display_name_by_config_name
@@ -0,0 +1,15 @@
+uniform sampler2D u_tex;
+uniform sampler2D u_noiseA;
+uniform sampler2D u_noiseB;
+
+varying vec2 v_texCoord;
+varying vec2 v_noiseCoord;
+
+void main()
+{
+	// noiseA holds the positive and noiseB the negative part of the noise
+	vec3 noise = texture2D(u_noiseA, v_noiseCoord).rgb -
+	             texture2D(u_noiseB, v_noiseCoord).rgb;
+	vec4 color = texture2D(u_tex, v_texCoord);
+	gl_FragColor = vec4(color.rgb + noise, color.a);
+}
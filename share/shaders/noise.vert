@@ -0,0 +1,13 @@
+attribute vec4 a_position;
+attribute vec2 a_texCoord;
+attribute vec2 a_noiseCoord;
+
+varying vec2 v_texCoord;
+varying vec2 v_noiseCoord;
+
+void main()
+{
+	gl_Position  = a_position;
+	v_texCoord   = a_texCoord;
+	v_noiseCoord = a_noiseCoord;
+}
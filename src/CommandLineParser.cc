@@ -14,6 +14,7 @@
 #include "EnumSetting.hh"
 #include "XMLException.hh"
 #include "StringOp.hh"
+#include "Timer.hh"
 #include "xrange.hh"
 #include "GLUtil.hh"
 #include "Reactor.hh"
@@ -63,6 +64,7 @@ CommandLineParser::CommandLineParser(Reactor& reactor_)
 	registerOption("-v",          versionOption, PHASE_BEFORE_INIT, 1);
 	registerOption("--version",   versionOption, PHASE_BEFORE_INIT, 1);
 	registerOption("-bash",       bashOption,    PHASE_BEFORE_INIT, 1);
+	registerOption("-verbose-startup", verboseStartupOption, PHASE_BEFORE_INIT, 1);
 
 	registerOption("-setting",    settingOption, PHASE_BEFORE_SETTINGS);
 	registerOption("-control",    controlOption, PHASE_BEFORE_SETTINGS, 1);
@@ -71,6 +73,7 @@ CommandLineParser::CommandLineParser(Reactor& reactor_)
 	registerOption("-nopbo",      noPBOOption,   PHASE_BEFORE_SETTINGS, 1);
 	#endif
 	registerOption("-testconfig", testConfigOption, PHASE_BEFORE_SETTINGS, 1);
+	registerOption("-benchmark",  benchmarkOption, PHASE_BEFORE_SETTINGS);
 
 	registerOption("-machine",    machineOption, PHASE_LOAD_MACHINE);
 
@@ -165,9 +168,18 @@ void CommandLineParser::parse(int argc, char** argv)
 	span<string> cmdLine(cmdLineBuf);
 	vector<string> backupCmdLine;
 
+	static const char* const phaseNames[] = {
+		"parse early options", "init", "parse setting options",
+		"load settings", "parse options", "load machine",
+		"load default machine", "parse remaining options",
+	};
+	static_assert(sizeof(phaseNames) / sizeof(phaseNames[0]) == PHASE_LAST + 1,
+	              "need a name for each phase");
+
 	for (ParsePhase phase = PHASE_BEFORE_INIT;
 	     (phase <= PHASE_LAST) && (parseStatus != EXIT);
 	     phase = static_cast<ParsePhase>(phase + 1)) {
+		auto phaseStart = Timer::getTime();
 		switch (phase) {
 		case PHASE_INIT:
 			reactor.init();
@@ -264,6 +276,9 @@ void CommandLineParser::parse(int argc, char** argv)
 			cmdLine = cmdLineBuf;
 			break;
 		}
+		if (isVerboseStartup()) {
+			addStartupTime(phaseNames[phase], Timer::getTime() - phaseStart);
+		}
 	}
 	for (auto& p : options) {
 		p.second.option->parseDone();
@@ -291,6 +306,11 @@ const CommandLineParser::Scripts& CommandLineParser::getStartupScripts() const
 	return scriptOption.scripts;
 }
 
+const string& CommandLineParser::getBenchmarkDuration() const
+{
+	return benchmarkOption.duration;
+}
+
 MSXMotherBoard* CommandLineParser::getMotherBoard() const
 {
 	return reactor.getMotherBoard();
@@ -368,6 +388,39 @@ string_view CommandLineParser::ScriptOption::fileTypeHelp() const
 }
 
 
+// Verbose startup option
+
+void CommandLineParser::VerboseStartupOption::parseOption(
+	const string& /*option*/, span<string>& /*cmdLine*/)
+{
+	enabled = true;
+}
+
+string_view CommandLineParser::VerboseStartupOption::optionHelp() const
+{
+	return "Report how long each phase of the startup took";
+}
+
+
+// Benchmark option
+
+void CommandLineParser::BenchmarkOption::parseOption(
+	const string& option, span<string>& cmdLine)
+{
+	duration = getArgument(option, cmdLine);
+	double seconds;
+	if (!StringOp::stringToDouble(duration, seconds) || (seconds <= 0.0)) {
+		throw FatalError("Invalid benchmark duration: ", duration);
+	}
+}
+
+string_view CommandLineParser::BenchmarkOption::optionHelp() const
+{
+	return "Run the machine unthrottled for the given number of emulated "
+	       "seconds, print the benchmark results (JSON) and exit";
+}
+
+
 // Help option
 
 static string formatSet(const vector<string_view>& inputSet, string::size_type columns)
@@ -13,6 +13,7 @@
 #include "span.hh"
 #include "string_view.hh"
 #include "components.hh"
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <utility>
@@ -53,6 +54,21 @@ public:
 	using Scripts = std::vector<std::string>;
 	const Scripts& getStartupScripts() const;
 
+	/** The emulated duration given with -benchmark, empty when that
+	  * option wasn't used.
+	  */
+	const std::string& getBenchmarkDuration() const;
+
+	/** Startup phases and the time (in us) they took, only measured
+	  * when -verbose-startup was given.
+	  */
+	using StartupTimes = std::vector<std::pair<const char*, uint64_t>>;
+	bool isVerboseStartup() const { return verboseStartupOption.enabled; }
+	const StartupTimes& getStartupTimes() const { return startupTimes; }
+	void addStartupTime(const char* phase, uint64_t duration) {
+		startupTimes.emplace_back(phase, duration);
+	}
+
 	MSXMotherBoard* getMotherBoard() const;
 	GlobalCommandController& getGlobalCommandController() const;
 	Interpreter& getInterpreter() const;
@@ -106,6 +122,20 @@ private:
 		CommandLineParser::Scripts scripts;
 	} scriptOption;
 
+	struct BenchmarkOption final : CLIOption {
+		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
+		string_view optionHelp() const override;
+
+		std::string duration;
+	} benchmarkOption;
+
+	struct VerboseStartupOption final : CLIOption {
+		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
+		string_view optionHelp() const override;
+
+		bool enabled = false;
+	} verboseStartupOption;
+
 	struct MachineOption final : CLIOption {
 		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
 		string_view optionHelp() const override;
@@ -142,6 +172,7 @@ private:
 	DiskImageCLI diskImageCLI;
 	HDImageCLI hdImageCLI;
 	CDImageCLI cdImageCLI;
+	StartupTimes startupTimes;
 	ParseStatus parseStatus;
 	bool haveConfig;
 	bool haveSettings;
@@ -75,9 +75,7 @@ public:
 	}
 
 	uint64_t getTotalTicks() const {
-		// note: don't use divmod.div() because that one only returns a
-		//       32 bit result. Maybe improve in the future.
-		return lastTick.time / getStep();
+		return divmod.div64(lastTick.time);
 	}
 
 	/** Change the frequency at which this clock ticks.
@@ -85,8 +83,7 @@ public:
 	  */
 	void setFreq(unsigned freq) {
 		unsigned newStep = (MAIN_FREQ32 + (freq / 2)) / freq;
-		assert(newStep);
-		divmod.setDivisor(newStep);
+		setStep(newStep);
 	}
 	/** Equivalent to setFreq(freq_num / freq_denom), but possibly with
 	  * less rounding errors.
@@ -96,8 +93,7 @@ public:
 		uint64_t p = MAIN_FREQ * freq_denom + (freq_num / 2);
 		uint64_t newStep = p / freq_num;
 		assert(newStep < (1ull << 32));
-		assert(newStep);
-		divmod.setDivisor(unsigned(newStep));
+		setStep(unsigned(newStep));
 	}
 
 	/** Returns the frequency (in Hz) at which this clock ticks.
@@ -177,6 +173,16 @@ private:
 	  */
 	unsigned getStep() const { return divmod.getDivisor(); }
 
+	/** Calculating the magic numbers in DivModBySame is expensive, and
+	  * devices often set the same frequency again (e.g. the FDCs on each
+	  * command), so skip it when the step doesn't change.
+	  */
+	void setStep(unsigned newStep) {
+		assert(newStep);
+		if (newStep == getStep()) return;
+		divmod.setDivisor(newStep);
+	}
+
 	/** Time of this clock's last tick.
 	  */
 	EmuTime lastTick;
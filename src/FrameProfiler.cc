@@ -0,0 +1,190 @@
+#include "FrameProfiler.hh"
+#include "CliComm.hh"
+#include "CommandException.hh"
+#include "FileContext.hh"
+#include "FileOperations.hh"
+#include "Instrumentation.hh"
+#include "outer.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <fstream>
+
+using std::string;
+using std::vector;
+
+namespace openmsx {
+
+static const char* const categoryNames[FrameProfiler::NUM_CATEGORIES] = {
+	"other", "emulation", "vdp", "sound", "paint", "tcl", "events", "sleep"
+};
+
+FrameProfiler::FrameProfiler(CommandController& commandController,
+                             CliComm& cliComm_)
+	: cliComm(cliComm_)
+	, profileCommand(commandController)
+#ifdef OPENMSX_INSTRUMENTATION
+	, instrumentationCommand(commandController)
+#endif
+	, lastUpdate(Timer::getTime())
+	, lastTime(lastUpdate)
+{
+	for (auto& c : current) c = 0;
+}
+
+void FrameProfiler::endFrame()
+{
+	enter(curCategory); // account the time till now
+
+	auto& frame = frames[numFrames % HISTORY];
+	for (auto i : xrange(unsigned(NUM_CATEGORIES))) {
+		// clip (e.g. while paused) so that it fits in a Tcl int
+		frame.time[i] = uint32_t(std::min<uint64_t>(current[i], 0x7FFFFFFF));
+		current[i] = 0;
+	}
+	++numFrames;
+
+	if ((lastTime - lastUpdate) >= 1000000) {
+		sendUpdate(lastTime);
+	}
+}
+
+void FrameProfiler::sendUpdate(uint64_t now)
+{
+	// The frames since the previous update (as far as they're still in
+	// the history).
+	unsigned count = std::min(numFrames - sentFrames, HISTORY);
+	cliComm.update(CliComm::PROFILE, "frames", getFrames(count).getString());
+	sentFrames = numFrames;
+	lastUpdate = now;
+}
+
+TclObject FrameProfiler::toTcl(const Frame& frame)
+{
+	TclObject result;
+	result.addListElements(frame.time);
+	return result;
+}
+
+TclObject FrameProfiler::getFrames(unsigned count) const
+{
+	count = std::min({count, numFrames, HISTORY});
+	TclObject result;
+	for (unsigned i = numFrames - count; i != numFrames; ++i) {
+		result.addListElement(toTcl(frames[i % HISTORY]));
+	}
+	return result;
+}
+
+
+// class FrameProfiler::Cmd
+
+FrameProfiler::Cmd::Cmd(CommandController& commandController_)
+	: Command(commandController_, "frame_profile")
+{
+}
+
+void FrameProfiler::Cmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& profiler = OUTER(FrameProfiler, profileCommand);
+	executeSubCommand(tokens[1].getString(),
+		"categories", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			result.addListElements(categoryNames); },
+		"frames", [&]{
+			checkNumArgs(tokens, Between{2, 3}, Prefix{2}, "?count?");
+			unsigned count = HISTORY;
+			if (tokens.size() == 3) {
+				int n = tokens[2].getInt(getInterpreter());
+				if (n < 0) throw CommandException("Count can't be negative");
+				count = unsigned(n);
+			}
+			result = profiler.getFrames(count); });
+}
+
+string FrameProfiler::Cmd::help(const vector<string>& /*tokens*/) const
+{
+	return "Shows where the host time of the last frames went.\n"
+	       "frame_profile categories\n"
+	       "    Returns the names of the categories: the emulation (CPU "
+	       "and devices), VDP rendering, sound generation, painting (post "
+	       "processing, OSD and swapping buffers), Tcl 'after' callbacks, "
+	       "event delivery, sleeping and the rest.\n"
+	       "frame_profile frames [<count>]\n"
+	       "    Returns the last <count> (at most 256) frames, oldest "
+	       "first. Each frame is a list with the time, in microseconds, "
+	       "spent in each of the categories.";
+}
+
+void FrameProfiler::Cmd::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const cmds[] = { "categories", "frames" };
+		completeString(tokens, cmds);
+	}
+}
+
+
+#ifdef OPENMSX_INSTRUMENTATION
+
+// class FrameProfiler::InstrumentationCmd
+
+FrameProfiler::InstrumentationCmd::InstrumentationCmd(
+		CommandController& commandController_)
+	: Command(commandController_, "instrumentation")
+{
+}
+
+void FrameProfiler::InstrumentationCmd::execute(
+	span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	executeSubCommand(tokens[1].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			Instrumentation::start(); },
+		"stop", [&]{
+			checkNumArgs(tokens, 3, Prefix{2}, "filename");
+			Instrumentation::stop();
+			auto filename = tokens[2].getString().str();
+			std::ofstream file;
+			FileOperations::openofstream(
+				file, FileOperations::expandTilde(filename));
+			if (!file.is_open()) {
+				throw CommandException("Couldn't open file ", filename);
+			}
+			auto count = Instrumentation::write(file);
+			if (!file) {
+				throw CommandException("Error while writing to ", filename);
+			}
+			result = strCat("Wrote ", count, " zones to ", filename); });
+}
+
+string FrameProfiler::InstrumentationCmd::help(
+	const vector<string>& /*tokens*/) const
+{
+	return "Records the named zones in the hot paths of openMSX (scheduler, "
+	       "CPU, device I/O, sound, rendering, serialization, file I/O).\n"
+	       "instrumentation start\n"
+	       "    Starts a new recording.\n"
+	       "instrumentation stop <filename>\n"
+	       "    Stops the recording and writes it to the given file in the "
+	       "Chrome trace event format (JSON), to be opened in Perfetto or "
+	       "imported in Tracy.";
+}
+
+void FrameProfiler::InstrumentationCmd::tabCompletion(
+	vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const cmds[] = { "start", "stop" };
+		completeString(tokens, cmds);
+	} else if (tokens.size() == 3) {
+		completeFileName(tokens, userFileContext());
+	}
+}
+
+#endif // OPENMSX_INSTRUMENTATION
+
+} // namespace openmsx
@@ -0,0 +1,116 @@
+#ifndef FRAMEPROFILER_HH
+#define FRAMEPROFILER_HH
+
+#include "Command.hh"
+#include "TclObject.hh"
+#include "Timer.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class CliComm;
+class CommandController;
+
+/** Measures where the host time of each frame goes: emulation, rendering,
+  * sound, Tcl callbacks, sleeping, ...
+  *
+  * At any moment the time is attributed to one category. A Section switches
+  * to another category for as long as it exists, sections can be nested
+  * (e.g. VDP rendering within the emulation), so the time of a category
+  * doesn't include the time of the nested sections. A frame ends with each
+  * repaint of the Display. This only takes two Timer::getTime() calls per
+  * section, so it's always enabled.
+  *
+  * The last frames can be retrieved with the 'frame_profile' command. Once
+  * per second the frames of the past second are also sent as a 'profile'
+  * update to the CLI listeners.
+  *
+  * In builds with OPENMSX_INSTRUMENTATION this also offers the
+  * 'instrumentation' command, see Instrumentation.hh.
+  */
+class FrameProfiler
+{
+public:
+	enum Category {
+		OTHER,     // not in any of the categories below
+		EMULATION, // CPU and the devices, except VDP and sound
+		VDP,       // VDP rendering (rasterizer) and sprite checking
+		SOUND,     // generating sound
+		PAINT,     // post processing, scaling, OSD and swapping buffers
+		TCL,       // 'after' callbacks
+		EVENTS,    // delivering events (except the categories above)
+		SLEEP,     // waiting for real time or for an event
+		NUM_CATEGORIES // must be last
+	};
+
+	class Section {
+	public:
+		Section(FrameProfiler& profiler_, Category category)
+			: profiler(profiler_), prev(profiler.enter(category)) {}
+		~Section() { profiler.enter(prev); }
+		Section(const Section&) = delete;
+		Section& operator=(const Section&) = delete;
+	private:
+		FrameProfiler& profiler;
+		const Category prev;
+	};
+
+	FrameProfiler(CommandController& commandController, CliComm& cliComm);
+
+	/** Switch to the given category, returns the previous category. */
+	Category enter(Category category) {
+		auto now = Timer::getTime();
+		current[curCategory] += now - lastTime;
+		lastTime = now;
+		auto prev = curCategory;
+		curCategory = category;
+		return prev;
+	}
+
+	/** Called at the end of each repaint. */
+	void endFrame();
+
+private:
+	static const unsigned HISTORY = 256; // frames
+	struct Frame {
+		uint32_t time[NUM_CATEGORIES]; // in us
+	};
+
+	/** The last 'count' frames, oldest first. */
+	TclObject getFrames(unsigned count) const;
+	static TclObject toTcl(const Frame& frame);
+	void sendUpdate(uint64_t now);
+
+	CliComm& cliComm;
+
+	struct Cmd final : Command {
+		explicit Cmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} profileCommand;
+
+#ifdef OPENMSX_INSTRUMENTATION
+	struct InstrumentationCmd final : Command {
+		explicit InstrumentationCmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} instrumentationCommand;
+#endif
+
+	Frame frames[HISTORY];
+	unsigned numFrames = 0; // total number of recorded frames
+	unsigned sentFrames = 0; // frames that were sent to the CLI listeners
+	uint64_t lastUpdate;
+
+	uint64_t current[NUM_CATEGORIES]; // time of the current frame so far
+	uint64_t lastTime;
+	Category curCategory = OTHER;
+};
+
+} // namespace openmsx
+
+#endif
@@ -1,6 +1,7 @@
 #include "GlobalSettings.hh"
 #include "SettingsConfig.hh"
 #include "GlobalCommandController.hh"
+#include "MemoryOps.hh"
 #include "strCat.hh"
 #include "view.hh"
 #include "xrange.hh"
@@ -42,6 +43,26 @@ GlobalSettings::GlobalSettings(GlobalCommandController& commandController_)
 			{"hq",   ResampledSoundDevice::RESAMPLE_HQ},
 			{"fast", ResampledSoundDevice::RESAMPLE_LQ},
 			{"blip", ResampledSoundDevice::RESAMPLE_BLIP}})
+	, stateCompressionSetting(commandController, "savestate_compression",
+		"gzip compression level of savestates and replays: "
+		"1 is fastest, 9 gives the smallest files, 0 is uncompressed",
+		6, 0, 9)
+	, fastDiskAccessSetting(commandController, "fast_disk_access",
+		"transfer sectors directly between the disk image and memory in "
+		"the disk ROM, instead of emulating the floppy disk controller",
+		false)
+	, syncSpinSetting(commandController, "sync_spin_time",
+		"when throttling, the last part (in us) of each wait for real "
+		"time is done by busy waiting instead of sleeping: this gives "
+		"more regular frame timing (less jitter) but uses more CPU, "
+		"0 means only sleep",
+		0, 0, 20000)
+	, hugePagesSetting(commandController, "huge_pages",
+		"allocate large emulated memories (2MB or more, e.g. big memory "
+		"mappers) in huge pages of the host, this gives less TLB misses "
+		"but the memory is no longer committed lazily, only has effect "
+		"on machines and extensions created after changing this",
+		false)
 	, throttleManager(commandController)
 {
 	deadzoneSettings = to_vector(
@@ -53,10 +74,13 @@ GlobalSettings::GlobalSettings(GlobalCommandController& commandController_)
 				25, 0, 100);
 		}));
 	getPowerSetting().attach(*this);
+	hugePagesSetting.attach(*this);
+	MemoryOps::setHugePages(hugePagesSetting.getBoolean());
 }
 
 GlobalSettings::~GlobalSettings()
 {
+	hugePagesSetting.detach(*this);
 	getPowerSetting().detach(*this);
 	commandController.getSettingsConfig().setSaveSettings(
 		autoSaveSetting.getBoolean());
@@ -70,6 +94,8 @@ void GlobalSettings::update(const Setting& setting)
 		// this solved a bug, but apart from that this behaviour also
 		// makes more sense
 		getPauseSetting().setBoolean(false);
+	} else if (&setting == &hugePagesSetting) {
+		MemoryOps::setHugePages(hugePagesSetting.getBoolean());
 	}
 }
 
@@ -47,6 +47,15 @@ public:
 	EnumSetting<ResampledSoundDevice::ResampleType>& getResampleSetting() {
 		return resampleSetting;
 	}
+	IntegerSetting& getStateCompressionSetting() {
+		return stateCompressionSetting;
+	}
+	BooleanSetting& getFastDiskAccessSetting() {
+		return fastDiskAccessSetting;
+	}
+	IntegerSetting& getSyncSpinSetting() {
+		return syncSpinSetting;
+	}
 	IntegerSetting& getJoyDeadzoneSetting(int i) {
 		return *deadzoneSettings[i];
 	}
@@ -67,6 +76,10 @@ private:
 	StringSetting  umrCallBackSetting;
 	StringSetting  invalidPsgDirectionsSetting;
 	EnumSetting<ResampledSoundDevice::ResampleType> resampleSetting;
+	IntegerSetting stateCompressionSetting;
+	BooleanSetting fastDiskAccessSetting;
+	IntegerSetting syncSpinSetting;
+	BooleanSetting hugePagesSetting;
 	std::vector<std::unique_ptr<IntegerSetting>> deadzoneSettings;
 	ThrottleManager throttleManager;
 };
@@ -0,0 +1,194 @@
+#include "LibOpenMSX.hh"
+#include "CommandLineParser.hh"
+#include "Command.hh"
+#include "Debuggable.hh"
+#include "Debugger.hh"
+#include "Display.hh"
+#include "EnumSetting.hh"
+#include "EventDistributor.hh"
+#include "MSXCommandController.hh"
+#include "MSXException.hh"
+#include "MSXMotherBoard.hh"
+#include "PNG.hh"
+#include "Reactor.hh"
+#include "RenderSettings.hh"
+#include "TclObject.hh"
+#include "Thread.hh"
+#include "UnicodeKeymap.hh"
+#include "VDP.hh"
+#include "VideoLayer.hh"
+#include "random.hh"
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <SDL.h>
+
+using namespace openmsx;
+
+struct openmsx_env
+{
+	Reactor reactor;
+	CommandLineParser parser{reactor};
+};
+
+static std::string lastError;
+static bool created = false;
+
+// Run the given function, translate exceptions into an error code.
+template<typename F>
+static int guard(F f)
+{
+	try {
+		f();
+		return 0;
+	} catch (FatalError& e) {
+		lastError = e.getMessage();
+	} catch (MSXException& e) {
+		lastError = e.getMessage();
+	} catch (std::exception& e) {
+		lastError = e.what();
+	}
+	return -1;
+}
+
+static MSXMotherBoard& getPoweredBoard(openmsx_env& env)
+{
+	auto* board = env.reactor.getMotherBoard();
+	if (!board || !board->getMachineConfig() || !board->isPowered()) {
+		throw MSXException("The machine is not powered on.");
+	}
+	return *board;
+}
+
+static EmuDuration getFrameDuration(MSXMotherBoard& board)
+{
+	if (auto* vdp = dynamic_cast<VDP*>(board.findDevice("VDP"))) {
+		return EmuDuration(double(vdp->getTicksPerFrame()) /
+		                   VDP::TICKS_PER_SECOND);
+	}
+	return EmuDuration::hz(60);
+}
+
+openmsx_env* openmsx_create(int argc, char** argv)
+{
+	if (created) {
+		lastError = "There can only be one openMSX environment per process.";
+		return nullptr;
+	}
+	openmsx_env* result = nullptr;
+	guard([&] {
+		randomize(); // seed global random generator
+		if (SDL_Init(0) < 0) {
+			throw MSXException("Couldn't init SDL: ", SDL_GetError());
+		}
+		Thread::setMainThread();
+		auto env = std::make_unique<openmsx_env>();
+		env->parser.parse(argc, argv);
+		auto parseStatus = env->parser.getParseStatus();
+		if (parseStatus == CommandLineParser::EXIT) {
+			throw MSXException("openMSX exited while parsing the options.");
+		}
+		auto& reactor = env->reactor;
+		if (!env->parser.isHiddenStartup()) {
+			// like in main(), see there for the details
+			auto& render = reactor.getDisplay().getRenderSettings().getRendererSetting();
+			render.setValue(render.getRestoreValue());
+			reactor.getEventDistributor().deliverEvents();
+		}
+		reactor.startUp(env->parser);
+		result = env.release();
+	});
+	if (result) {
+		created = true;
+	} else if (SDL_WasInit(SDL_INIT_EVERYTHING)) {
+		SDL_Quit();
+	}
+	return result;
+}
+
+void openmsx_destroy(openmsx_env* env)
+{
+	if (!env) return;
+	delete env;
+	created = false;
+	if (SDL_WasInit(SDL_INIT_EVERYTHING)) {
+		SDL_Quit();
+	}
+}
+
+const char* openmsx_get_error(void)
+{
+	return lastError.c_str();
+}
+
+int openmsx_step(openmsx_env* env, const unsigned char* keyMatrix,
+                 unsigned frames)
+{
+	return guard([&] {
+		env->reactor.getEventDistributor().deliverEvents();
+		auto& board = getPoweredBoard(*env);
+		if (keyMatrix) {
+			// Go through the (recorded) command, but not through
+			// the Tcl interpreter.
+			auto* command = board.getMSXCommandController().findCommand(
+				"keymatrix_sequence");
+			if (!command) {
+				throw MSXException("This machine has no keyboard.");
+			}
+			TclObject tokens[2] = {
+				TclObject("keymatrix_sequence"),
+				TclObject(span<const uint8_t>(
+					keyMatrix, KeyMatrixPosition::NUM_ROWS)),
+			};
+			TclObject dummy;
+			command->execute(tokens, dummy);
+		}
+		if (frames == 0) return;
+		auto target = board.getCurrentTime() + getFrameDuration(board) * frames;
+		board.fastForward(target, true);
+	});
+}
+
+double openmsx_get_time(openmsx_env* env)
+{
+	auto* board = env->reactor.getMotherBoard();
+	return board ? (board->getCurrentTime() - EmuTime::zero).toDouble() : 0.0;
+}
+
+int openmsx_read_debuggable(openmsx_env* env, const char* name,
+                            unsigned address, unsigned char* buffer,
+                            unsigned size)
+{
+	return guard([&] {
+		auto* board = env->reactor.getMotherBoard();
+		if (!board) throw MSXException("No machine.");
+		auto* debuggable = board->getDebugger().findDebuggable(name);
+		if (!debuggable) {
+			throw MSXException("No such debuggable: ", name);
+		}
+		unsigned total = debuggable->getSize();
+		if ((address > total) || (size > (total - address))) {
+			throw MSXException("Range is outside of debuggable ", name);
+		}
+		debuggable->readBlock(address, buffer, size);
+	});
+}
+
+int openmsx_get_frame(openmsx_env* env, unsigned height, unsigned char* buffer)
+{
+	return guard([&] {
+		if ((height != 240) && (height != 480)) {
+			throw MSXException("Height must be 240 or 480.");
+		}
+		auto& display = env->reactor.getDisplay();
+		display.renderOnDemand();
+		auto* videoLayer = dynamic_cast<VideoLayer*>(display.findActiveLayer());
+		if (!videoLayer) {
+			throw MSXException("Current renderer doesn't support raw frames.");
+		}
+		PNG::Image image = videoLayer->takeRawScreenShot(height);
+		memcpy(buffer, image.pixels.data(),
+		       size_t(image.width) * image.height * 3);
+	});
+}
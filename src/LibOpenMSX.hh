@@ -0,0 +1,73 @@
+#ifndef LIBOPENMSX_HH
+#define LIBOPENMSX_HH
+
+/* Interface to drive openMSX from another program, without going through Tcl
+ * or a socket for every step. Meant for e.g. reinforcement learning: create a
+ * machine, repeatedly step it a number of frames with some input and read the
+ * observation (the video frame, or RAM or any other debuggable) directly into
+ * buffers of the caller.
+ *
+ * Build openMSX as a shared library with 'make SHARED_LIBRARY=true' (or build
+ * libopenmsx.so with meson). This header can be included from C and C++.
+ *
+ * There can only be one environment per process (openMSX uses global SDL and
+ * Tcl state), run multiple processes for multiple environments. All functions
+ * must be called from the thread that created the environment. To run without
+ * a window, select the SDL dummy video driver (SDL_VIDEODRIVER=dummy in the
+ * environment), that only supports the SDL renderer. SDL's offscreen video
+ * driver (SDL_VIDEODRIVER=offscreen) also supports the SDLGL-PP renderer, it
+ * creates the openGL context via EGL, without a display. Enabling the 'render_on_demand' setting makes stepping faster,
+ * then only the frames that are requested with openmsx_get_frame() are
+ * rendered.
+ *
+ * Sound is muted while stepping, it is not part of the observation.
+ *
+ * Functions that return int return 0 on success and -1 on error, the error
+ * message is then available via openmsx_get_error().
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct openmsx_env openmsx_env;
+
+/* Create an environment. The arguments are the command line options of the
+ * openmsx executable (including argv[0]), e.g. "-machine" and "-carta". The
+ * machine is powered on, but not emulated yet. Returns NULL on error. */
+openmsx_env* openmsx_create(int argc, char** argv);
+
+/* Destroy an environment that was created with openmsx_create(). */
+void openmsx_destroy(openmsx_env* env);
+
+/* The message of the last error. */
+const char* openmsx_get_error(void);
+
+/* Emulate 'frames' video frames (the duration of a frame depends on the
+ * current PAL/NTSC mode of the VDP). When 'keyMatrix' isn't NULL it points
+ * to 16 bytes, one for each row of the keyboard matrix, that replace the
+ * state of the whole matrix first; a 0 bit means the key is pressed. This
+ * input is recorded like 'keymatrix_sequence', so replays are deterministic. */
+int openmsx_step(openmsx_env* env, const unsigned char* keyMatrix,
+                 unsigned frames);
+
+/* The current MSX time, in seconds. */
+double openmsx_get_time(openmsx_env* env);
+
+/* Read 'size' bytes starting at 'address' from the debuggable with the given
+ * name (e.g. "memory" or "VRAM", see 'debug list'). */
+int openmsx_read_debuggable(openmsx_env* env, const char* name,
+                            unsigned address, unsigned char* buffer,
+                            unsigned size);
+
+/* Copy the current frame, like 'screenshot -raw': 'height' must be 240 or
+ * 480, 'buffer' must have room for (height * 4 / 3) * height RGB pixels
+ * (3 bytes per pixel). */
+int openmsx_get_frame(openmsx_env* env, unsigned height,
+                      unsigned char* buffer);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -409,6 +409,11 @@ byte MSXDevice::peekIO(word /*port*/, EmuTime::param /*time*/) const
 	return 0xFF;
 }
 
+bool MSXDevice::isIdlePollIO(word /*port*/) const
+{
+	return false;
+}
+
 
 byte MSXDevice::readMem(word /*address*/, EmuTime::param /*time*/)
 {
@@ -460,6 +465,18 @@ void MSXDevice::invalidateMemCache(word start, unsigned size)
 	getCPU().invalidateMemCache(start, size);
 }
 
+void MSXDevice::updateMemCache(word start, unsigned size)
+{
+	assert((start >> 14) == ((start + size - 1) >> 14));
+	if (getCPUInterface().getVisibleMemDevice(start >> 14) == this) {
+		getCPU().refillMemCache(start, size);
+	} else {
+		// Not visible (or only via e.g. MSXMultiMemDevice), the
+		// saved cache lines of our slot must be invalidated.
+		getCPU().invalidateMemCache(start, size);
+	}
+}
+
 template<typename Archive>
 void MSXDevice::serialize(Archive& ar, unsigned /*version*/)
 {
@@ -129,6 +129,16 @@ public:
 	 */
 	virtual byte peekIO(word port, EmuTime::param time) const;
 
+	/**
+	 * Can a busy loop that polls this IO port be skipped till the next
+	 * synchronization point? That's the case when the value read from
+	 * the port can only change at a synchronization point and reading
+	 * it again has no further side effects. This is used by the CPU to
+	 * detect idle loops, e.g. while waiting for VBLANK.
+	 * The default implementation returns false.
+	 */
+	virtual bool isIdlePollIO(word port) const;
+
 
 	// Memory
 
@@ -208,6 +218,15 @@ public:
 	  */
 	void invalidateMemCache(word start, unsigned size);
 
+	/** Like invalidateMemCache(), but when this device is currently
+	  * visible in the CPU address space, the (read) cache lines of the
+	  * region are immediately filled again via getReadCacheLine(). Use
+	  * this for bank switches that happen very often (e.g. MegaROM
+	  * mappers), then the CPU doesn't have to refill each cache line via
+	  * its slow path. The region must not cross a 16kB page boundary.
+	  */
+	void updateMemCache(word start, unsigned size);
+
 	/** Get the mother board this device belongs to
 	  */
 	MSXMotherBoard& getMotherBoard() const;
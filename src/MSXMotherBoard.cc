@@ -11,6 +11,7 @@
 #include "Scheduler.hh"
 #include "Schedulable.hh"
 #include "CartridgeSlotManager.hh"
+#include "CheatEngine.hh"
 #include "EventDistributor.hh"
 #include "Debugger.hh"
 #include "SimpleDebuggable.hh"
@@ -36,6 +37,7 @@
 #include "CommandException.hh"
 #include "InfoTopic.hh"
 #include "FileException.hh"
+#include "TclArgParser.hh"
 #include "TclObject.hh"
 #include "Observer.hh"
 #include "serialize.hh"
@@ -110,6 +112,17 @@ private:
 	MSXMotherBoard& motherBoard;
 };
 
+class RunForCmd final : public Command
+{
+public:
+	explicit RunForCmd(MSXMotherBoard& motherBoard);
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	string help(const vector<string>& tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+private:
+	MSXMotherBoard& motherBoard;
+};
+
 class MachineNameInfo final : public InfoTopic
 {
 public:
@@ -204,10 +217,12 @@ MSXMotherBoard::MSXMotherBoard(Reactor& reactor_)
 	listExtCommand = make_unique<ListExtCmd>(*this);
 	extCommand = make_unique<ExtCmd>(*this, "ext");
 	removeExtCommand = make_unique<RemoveExtCmd>(*this);
+	runForCommand = make_unique<RunForCmd>(*this);
 	machineNameInfo = make_unique<MachineNameInfo>(*this);
 	machineTypeInfo = make_unique<MachineTypeInfo>(*this);
 	deviceInfo = make_unique<DeviceInfo>(*this);
 	debugger = make_unique<Debugger>(*this);
+	cheatEngine = make_unique<CheatEngine>(*this);
 
 	msxMixer->mute(); // powered down
 
@@ -821,6 +836,55 @@ string ListExtCmd::help(const vector<string>& /*tokens*/) const
 }
 
 
+// RunForCmd
+RunForCmd::RunForCmd(MSXMotherBoard& motherBoard_)
+	: Command(motherBoard_.getCommandController(), "run_for")
+	, motherBoard(motherBoard_)
+{
+}
+
+void RunForCmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	bool noVideo = false;
+	ArgsInfo info[] = { flagArg("-novideo", noVideo) };
+	auto args = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
+	if (args.size() != 1) throw SyntaxError();
+	double duration = args[0].getDouble(getInterpreter());
+	if (duration < 0.0) {
+		throw CommandException("Duration must be positive.");
+	}
+	if (!motherBoard.getMachineConfig() || !motherBoard.isPowered()) {
+		throw CommandException("The machine is not powered on.");
+	}
+	if (motherBoard.isFastForwarding()) {
+		throw CommandException("Already fast-forwarding.");
+	}
+	motherBoard.fastForward(
+		motherBoard.getCurrentTime() + EmuDuration(duration), noVideo);
+	result = (motherBoard.getCurrentTime() - EmuTime::zero).toDouble();
+}
+
+string RunForCmd::help(const vector<string>& /*tokens*/) const
+{
+	return "run_for [-novideo] <seconds>\n"
+	       "Emulates the given amount of MSX time as fast as possible "
+	       "and only returns when done, also when paused. This is meant "
+	       "for scripts and external programs (e.g. bots) that control "
+	       "the emulation in lockstep: inject input, run_for one frame, "
+	       "look at the result (e.g. 'frame_hash' or 'screenshot -raw'), "
+	       "and so on. With -novideo the frames aren't rendered. Sound "
+	       "is muted meanwhile. Returns the new MSX time.\n"
+	       "Don't use this from callbacks that are executed during the "
+	       "emulation (e.g. breakpoint or 'after time' callbacks).";
+}
+
+void RunForCmd::tabCompletion(vector<string>& tokens) const
+{
+	static const char* const options[] = { "-novideo" };
+	completeString(tokens, options);
+}
+
+
 // ExtCmd
 ExtCmd::ExtCmd(MSXMotherBoard& motherBoard_, std::string commandName_)
 	: RecordedCommand(motherBoard_.getCommandController(),
@@ -1051,6 +1115,7 @@ void SettingObserver::update(const Setting& setting)
 // version 2: added reRecordCount
 // version 3: removed reRecordCount (moved to ReverseManager)
 // version 4: moved joystickportA/B from MSXPSG to here
+// version 5: added cheats
 template<typename Archive>
 void MSXMotherBoard::serialize(Archive& ar, unsigned version)
 {
@@ -1100,6 +1165,10 @@ void MSXMotherBoard::serialize(Archive& ar, unsigned version)
 		}
 	}
 
+	if (ar.versionAtLeast(version, 5)) {
+		ar.serialize("cheats", *cheatEngine);
+	}
+
 	if (ar.isLoader()) {
 		powered = true; // must come before changing power setting
 		powerSetting.setBoolean(true);
@@ -18,6 +18,7 @@ namespace openmsx {
 class AddRemoveUpdate;
 class BooleanSetting;
 class CartridgeSlotManager;
+class CheatEngine;
 class CassettePortInterface;
 class CliComm;
 class CommandController;
@@ -48,6 +49,7 @@ class PanasonicMemory;
 class PluggingController;
 class Reactor;
 class RealTime;
+class RunForCmd;
 class RemoveExtCmd;
 class RenShaTurbo;
 class ResetCmd;
@@ -93,6 +95,7 @@ public:
 	void doReset();
 	void activate(bool active);
 	bool isActive() const { return active; }
+	bool isPowered() const { return powered; }
 	bool isFastForwarding() const { return fastForwarding; }
 
 	byte readIRQVector();
@@ -256,6 +259,8 @@ private:
 	std::unique_ptr<ListExtCmd>   listExtCommand;
 	std::unique_ptr<ExtCmd>       extCommand;
 	std::unique_ptr<RemoveExtCmd> removeExtCommand;
+	std::unique_ptr<RunForCmd>    runForCommand;
+	std::unique_ptr<CheatEngine>  cheatEngine;
 	std::unique_ptr<MachineNameInfo> machineNameInfo;
 	std::unique_ptr<MachineTypeInfo> machineTypeInfo;
 	std::unique_ptr<DeviceInfo>   deviceInfo;
@@ -271,7 +276,7 @@ private:
 	bool active;
 	bool fastForwarding;
 };
-SERIALIZE_CLASS_VERSION(MSXMotherBoard, 4);
+SERIALIZE_CLASS_VERSION(MSXMotherBoard, 5);
 
 class ExtCmd final : public RecordedCommand
 {
@@ -0,0 +1,364 @@
+#include "Netplay.hh"
+#include "CliComm.hh"
+#include "EventDistributor.hh"
+#include "GlobalSettings.hh"
+#include "MSXException.hh"
+#include "Reactor.hh"
+#include "ReverseManager.hh"
+#include "StateChange.hh"
+#include "TclObject.hh"
+#include "Timer.hh"
+#include "serialize.hh"
+#include "serialize_meta.hh"
+#include "serialize_stl.hh"
+#include "strCat.hh"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/time.h>
+#endif
+
+namespace openmsx {
+
+// Netplay packet format (one UDP datagram):
+//   4 bytes  magic "oNP1"
+//   1 byte   kind
+//   data     a binary archive (see BinOutputArchive) with
+//              HELLO: "time" and "hash" (of the machine state at the start)
+//                     and "received" (whether the peer's hello arrived)
+//              INPUT: "ack" (number of events received from the peer),
+//                     "first" (sequence number of the first event) and
+//                     "events" (the events that are not acknowledged yet)
+//              BYE:   nothing, the peer left the session
+static const char NETPLAY_MAGIC[4] = { 'o', 'N', 'P', '1' };
+static const size_t HEADER_SIZE = sizeof(NETPLAY_MAGIC) + 1;
+static const size_t MAX_PACKET_SIZE = 1400; // stay below the usual MTU
+static const size_t MAX_EVENTS_PER_PACKET = 32;
+
+// Resend periods (in ms), depending on what is to be sent.
+static const unsigned HELLO_PERIOD = 100;
+static const unsigned UNACKED_PERIOD = 20;
+static const unsigned KEEPALIVE_PERIOD = 250;
+// Granularity of the network thread.
+static const unsigned RECEIVE_TIMEOUT = 10;
+
+Netplay::Netplay(Reactor& reactor_, ReverseManager& manager_,
+                 unsigned localPort, const std::string& remoteHost,
+                 unsigned remotePort, EmuTime::param time,
+                 uint32_t stateHash_)
+	: reactor(reactor_), manager(&manager_)
+	, peerName(strCat(remoteHost, ':', remotePort))
+	, startTime(time), stateHash(stateHash_)
+{
+	sock_startup();
+	try {
+		addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_DGRAM;
+		addrinfo* info;
+		if (int err = getaddrinfo(remoteHost.c_str(),
+		                          std::to_string(remotePort).c_str(),
+		                          &hints, &info)) {
+			throw MSXException("Couldn't resolve ", peerName, ": ",
+			                   gai_strerror(err));
+		}
+		sock = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+		if (sock == OPENMSX_INVALID_SOCKET) {
+			freeaddrinfo(info);
+			throw MSXException("Couldn't create socket: ", sock_error());
+		}
+		// Bind to the local port, in the address family of the peer.
+		sockaddr_storage local;
+		memset(&local, 0, sizeof(local));
+		socklen_t localLen;
+		if (info->ai_family == AF_INET6) {
+			auto& a = reinterpret_cast<sockaddr_in6&>(local);
+			a.sin6_family = AF_INET6;
+			a.sin6_addr = in6addr_any;
+			a.sin6_port = htons(localPort);
+			localLen = sizeof(a);
+		} else {
+			auto& a = reinterpret_cast<sockaddr_in&>(local);
+			a.sin_family = AF_INET;
+			a.sin_addr.s_addr = htonl(INADDR_ANY);
+			a.sin_port = htons(localPort);
+			localLen = sizeof(a);
+		}
+		bool ok = (bind(sock, reinterpret_cast<sockaddr*>(&local), localLen) == 0) &&
+		          (connect(sock, info->ai_addr, int(info->ai_addrlen)) == 0);
+		freeaddrinfo(info);
+		if (!ok) {
+			throw MSXException("Couldn't use local port ", localPort,
+			                   ": ", sock_error());
+		}
+		// Wait at most RECEIVE_TIMEOUT, so that the thread can resend.
+#ifdef _WIN32
+		DWORD timeout = RECEIVE_TIMEOUT;
+		setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO,
+		           reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+#else
+		timeval timeout;
+		timeout.tv_sec = 0;
+		timeout.tv_usec = RECEIVE_TIMEOUT * 1000;
+		setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+	} catch (MSXException&) {
+		if (sock != OPENMSX_INVALID_SOCKET) sock_close(sock);
+		sock_cleanup();
+		throw;
+	}
+
+	reactor.getEventDistributor().registerEventListener(
+		OPENMSX_NETPLAY_EVENT, *this);
+
+	// Wait for the peer.
+	reactor.getGlobalSettings().getPauseSetting().setBoolean(true);
+	updatePacket();
+	thread = std::thread([this]() { run(); });
+	reactor.getCliComm().printInfo(
+		"Netplay: waiting for ", peerName, " (emulation is paused).");
+}
+
+Netplay::~Netplay()
+{
+	if (state == HANDSHAKE) {
+		// we paused the emulation
+		reactor.getGlobalSettings().getPauseSetting().setBoolean(false);
+	}
+	if (state != CLOSED) {
+		setPacket(BYE, nullptr, 0, 0);
+	}
+	stopThread = true;
+	thread.join();
+	sock_close(sock);
+	sock_cleanup();
+	reactor.getEventDistributor().unregisterEventListener(
+		OPENMSX_NETPLAY_EVENT, *this);
+}
+
+void Netplay::sendEvent(const std::shared_ptr<StateChange>& event)
+{
+	if (state == CLOSED) return;
+	unacked.push_back(event);
+	updatePacket();
+}
+
+void Netplay::status(TclObject& result) const
+{
+	result.addDictKeyValue("status", (state == HANDSHAKE) ? "waiting"
+	                               : (state == RUNNING)   ? "running"
+	                                                      : "closed");
+	result.addDictKeyValue("peer", peerName);
+	result.addDictKeyValue("sent", int(sentBase + unacked.size()));
+	result.addDictKeyValue("unacknowledged", int(unacked.size()));
+	result.addDictKeyValue("received", int(received));
+	result.addDictKeyValue("rollbacks", int(rollbacks));
+	uint64_t last = lastReceiveTime;
+	result.addDictKeyValue("idle", last ? (Timer::getTime() - last) / 1000000.0 : -1.0);
+}
+
+void Netplay::updatePacket()
+{
+	// Build the packet that should be sent (and resent) next.
+	BinOutputArchive out(peerName);
+	Kind kind;
+	unsigned period;
+	switch (state) {
+	case HANDSHAKE: {
+		EmuTime time = startTime;
+		out.serialize("time", time,
+		              "hash", stateHash,
+		              "received", gotHello);
+		kind = HELLO;
+		period = HELLO_PERIOD;
+		break;
+	}
+	case RUNNING: {
+		// Don't send more than fits in a packet, the remainder goes
+		// out once the first events are acknowledged.
+		Events events(begin(unacked), begin(unacked) +
+			std::min(unacked.size(), MAX_EVENTS_PER_PACKET));
+		out.serialize("ack", received,
+		              "first", sentBase,
+		              "events", events);
+		kind = INPUT;
+		period = unacked.empty() ? KEEPALIVE_PERIOD : UNACKED_PERIOD;
+		break;
+	}
+	default:
+		return;
+	}
+	size_t size;
+	auto buf = out.releaseBuffer(size);
+	if ((HEADER_SIZE + size) > MAX_PACKET_SIZE) {
+		// Can only happen with huge events (e.g. long recorded
+		// commands), the peer will never receive this.
+		reactor.getCliComm().printWarning(
+			"Netplay: event too large to send, the session will "
+			"get out of sync.");
+		unacked.pop_front();
+		++sentBase;
+		updatePacket();
+		return;
+	}
+	setPacket(kind, buf.data(), size, period);
+}
+
+void Netplay::setPacket(Kind kind, const uint8_t* data, size_t size,
+                        unsigned period)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	packet.resize(HEADER_SIZE + size);
+	memcpy(packet.data(), NETPLAY_MAGIC, sizeof(NETPLAY_MAGIC));
+	packet[sizeof(NETPLAY_MAGIC)] = kind;
+	if (size) memcpy(packet.data() + HEADER_SIZE, data, size);
+	resendPeriod = period;
+	sendPacket(); // don't wait for the next resend
+}
+
+void Netplay::sendPacket()
+{
+	// mutex must be locked
+	// Errors are ignored: e.g. 'connection refused' while the peer isn't
+	// started yet. The packet is resent anyway.
+	sock_send(sock, reinterpret_cast<const char*>(packet.data()),
+	          packet.size());
+}
+
+void Netplay::run()
+{
+	uint64_t lastSend = Timer::getTime();
+	while (!stopThread) {
+		uint8_t buf[MAX_PACKET_SIZE];
+		int n = recv(sock, reinterpret_cast<char*>(buf), sizeof(buf), 0);
+		if (stopThread) break;
+		if ((n >= int(HEADER_SIZE)) &&
+		    (memcmp(buf, NETPLAY_MAGIC, sizeof(NETPLAY_MAGIC)) == 0)) {
+			lastReceiveTime = Timer::getTime();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				incoming.emplace_back(buf, buf + n);
+			}
+			if (!eventPending.exchange(true)) {
+				reactor.getEventDistributor().distributeEvent(
+					std::make_shared<SimpleEvent>(OPENMSX_NETPLAY_EVENT));
+			}
+		}
+		// Otherwise it was a timeout, an error (ignored, see
+		// sendPacket()) or garbage.
+
+		uint64_t now = Timer::getTime();
+		std::lock_guard<std::mutex> lock(mutex);
+		if (resendPeriod && ((now - lastSend) >= resendPeriod * 1000)) {
+			sendPacket();
+			lastSend = now;
+		}
+	}
+}
+
+void Netplay::startRunning()
+{
+	state = RUNNING;
+	updatePacket();
+	reactor.getGlobalSettings().getPauseSetting().setBoolean(false);
+	reactor.getCliComm().printInfo("Netplay: connected to ", peerName, '.');
+}
+
+void Netplay::receivePacket(const std::vector<uint8_t>& p)
+{
+	if (state == CLOSED) return;
+	auto kind = p[sizeof(NETPLAY_MAGIC)];
+	BinInputArchive in(p.data() + HEADER_SIZE, p.size() - HEADER_SIZE);
+	if (kind == HELLO) {
+		EmuTime peerTime = EmuTime::zero;
+		uint32_t peerHash;
+		bool peerGotHello;
+		in.serialize("time", peerTime,
+		             "hash", peerHash,
+		             "received", peerGotHello);
+		if (state != HANDSHAKE) return;
+		if (!gotHello) {
+			gotHello = true;
+			if ((peerTime != startTime) || (peerHash != stateHash)) {
+				reactor.getCliComm().printWarning(
+					"Netplay: the machine of ", peerName,
+					" is not in the same state as this one, "
+					"the session will not stay in sync. Start "
+					"both sides from the same savestate.");
+			}
+		}
+		if (peerGotHello) {
+			startRunning();
+		} else {
+			updatePacket();
+		}
+	} else if (kind == INPUT) {
+		unsigned ack, first;
+		Events events;
+		in.serialize("ack", ack,
+		             "first", first,
+		             "events", events);
+		if (state == HANDSHAKE) {
+			// The peer only starts after it received our hello
+			// (and it already sent its own).
+			startRunning();
+		}
+		while ((sentBase < ack) && !unacked.empty()) {
+			unacked.pop_front();
+			++sentBase;
+		}
+		Events newEvents;
+		if ((first <= received) && (received < (first + events.size()))) {
+			newEvents.assign(begin(events) + (received - first),
+			                 end(events));
+		}
+		received += unsigned(newEvents.size());
+		updatePacket();
+		if (!newEvents.empty()) {
+			// Can switch to a new MSXMotherBoard, so do this last.
+			try {
+				manager->insertRemoteEvents(newEvents);
+			} catch (MSXException& e) {
+				reactor.getCliComm().printWarning(
+					"Netplay: rollback failed: ",
+					e.getMessage());
+			}
+		}
+	} else if (kind == BYE) {
+		state = CLOSED;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			resendPeriod = 0;
+		}
+		reactor.getCliComm().printWarning(
+			"Netplay: ", peerName, " left the session.");
+	}
+}
+
+int Netplay::signalEvent(const std::shared_ptr<const Event>& /*event*/)
+{
+	eventPending = false;
+	std::deque<std::vector<uint8_t>> packets;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::swap(packets, incoming);
+	}
+	for (auto& p : packets) {
+		try {
+			receivePacket(p);
+		} catch (MSXException&) {
+			// corrupt packet, ignore
+		}
+		// receivePacket() can trigger a rollback, afterwards the
+		// remaining packets are still handled by this object (it
+		// moved to the new ReverseManager).
+	}
+	return 0;
+}
+
+} // namespace openmsx
@@ -0,0 +1,117 @@
+#ifndef NETPLAY_HH
+#define NETPLAY_HH
+
+#include "EventListener.hh"
+#include "EmuTime.hh"
+#include "Socket.hh"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+class Reactor;
+class ReverseManager;
+class StateChange;
+class TclObject;
+
+/** A netplay session: two openMSX instances, started from the same state,
+  * emulate the same machine while each one provides part of the input.
+  *
+  * All input of a machine already is a sequence of StateChange events (that
+  * is what makes replays possible). The local events are sent to the peer,
+  * the events of the peer are added to the local history:
+  * - Events that are still in the future are scheduled at their own time.
+  * - When an event arrives too late (which is normal, it takes some time to
+  *   get here) the history is rewritten: the ReverseManager goes back to a
+  *   snapshot before the event and emulates up to the current time again,
+  *   now with the event included ('rollback'). Till then it is predicted
+  *   that the input of the peer doesn't change.
+  *
+  * Events are sent over UDP. Each packet contains all local events that the
+  * peer didn't acknowledge yet (so lost packets don't matter) and the number
+  * of events received from the peer. Packets are resent regularly, as long
+  * as not everything is acknowledged.
+  *
+  * At the start both sides are paused till the peer responds, they compare
+  * the current time and a hash of the machine state to detect sessions that
+  * can't stay in sync.
+  *
+  * This object follows the history when the ReverseManager switches to a
+  * new MSXMotherBoard (see ReverseManager::transferState()).
+  */
+class Netplay final : private EventListener
+{
+public:
+	using Events = std::vector<std::shared_ptr<StateChange>>;
+
+	/** Start a session, the peer is contacted in the background.
+	  * @param time Current time of the machine.
+	  * @param stateHash Hash of the current state of the machine.
+	  * @throws MSXException When the socket can't be created.
+	  */
+	Netplay(Reactor& reactor, ReverseManager& manager,
+	        unsigned localPort, const std::string& remoteHost,
+	        unsigned remotePort, EmuTime::param time, uint32_t stateHash);
+	/** Tells the peer the session is over. */
+	~Netplay();
+
+	void setManager(ReverseManager& manager_) { manager = &manager_; }
+
+	/** A new event of the local machine, it is sent to the peer. */
+	void sendEvent(const std::shared_ptr<StateChange>& event);
+
+	void countRollback() { ++rollbacks; }
+	void status(TclObject& result) const;
+
+private:
+	enum State { HANDSHAKE, RUNNING, CLOSED };
+	enum Kind : uint8_t { HELLO = 'H', INPUT = 'I', BYE = 'B' };
+
+	void run();
+	void updatePacket();
+	void setPacket(Kind kind, const uint8_t* data, size_t size,
+	               unsigned period);
+	void sendPacket();
+	void receivePacket(const std::vector<uint8_t>& packet);
+	void startRunning();
+
+	// EventListener
+	int signalEvent(const std::shared_ptr<const Event>& event) override;
+
+	Reactor& reactor;
+	ReverseManager* manager;
+	const std::string peerName;
+	State state = HANDSHAKE;
+
+	// handshake
+	const EmuTime startTime;
+	const uint32_t stateHash;
+	bool gotHello = false;
+
+	// local events, [sentBase, sentBase + unacked.size())
+	std::deque<std::shared_ptr<StateChange>> unacked;
+	unsigned sentBase = 0;
+	unsigned received = 0; // number of events received from the peer
+	unsigned rollbacks = 0;
+
+	SOCKET sock = OPENMSX_INVALID_SOCKET;
+	std::thread thread;
+	std::atomic_bool stopThread{false};
+	std::atomic_bool eventPending{false};
+	std::atomic<uint64_t> lastReceiveTime{0};
+
+	std::mutex mutex;
+	std::vector<uint8_t> packet; // protected by 'mutex'
+	unsigned resendPeriod = 0;   // idem, in ms
+	std::deque<std::vector<uint8_t>> incoming; // idem
+};
+
+} // namespace openmsx
+
+#endif
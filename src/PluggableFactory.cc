@@ -10,6 +10,7 @@
 #include "SETetrisDongle.hh"
 #include "MagicKey.hh"
 #include "KeyJoystick.hh"
+#include "IntegerSetting.hh"
 #include "MidiInReader.hh"
 #include "MidiOutLogger.hh"
 #include "Mouse.hh"
@@ -19,6 +20,7 @@
 #include "PrinterPortLogger.hh"
 #include "PrinterPortSimpl.hh"
 #include "Printer.hh"
+#include "RS232Net.hh"
 #include "RS232Tester.hh"
 #include "WavAudioInput.hh"
 #include "components.hh"
@@ -91,6 +93,10 @@ void PluggableFactory::createAll(PluggingController& controller,
 	// Serial communication:
 	controller.registerPluggable(std::make_unique<RS232Tester>(
 		eventDistributor, scheduler, commandController));
+#if !defined(_WIN32)
+	controller.registerPluggable(std::make_unique<RS232Net>(
+		eventDistributor, scheduler, commandController));
+#endif
 
 	// Sampled audio:
 	controller.registerPluggable(std::make_unique<PrinterPortSimpl>(
@@ -110,15 +116,26 @@ void PluggableFactory::createAll(PluggingController& controller,
 	MidiInWindows::registerAll(eventDistributor, scheduler, controller);
 	MidiOutWindows::registerAll(controller);
 #endif
+#if defined(__APPLE__) || COMPONENT_ALSAMIDI
+	// Shared by all MIDI out devices that can schedule their messages.
+	auto midiOutLatency = motherBoard.getSharedStuff<IntegerSetting>(
+		"midi-out-latency", commandController, "midi-out-latency",
+		"send MIDI out messages this many milliseconds after they were "
+		"produced by the emulation, this removes the timing jitter caused "
+		"by emulating in bursts; 0 means send them immediately",
+		0, 0, 1000);
+#endif
 #if defined(__APPLE__)
 	controller.registerPluggable(std::make_unique<MidiInCoreMIDIVirtual>(
 		eventDistributor, scheduler));
 	MidiInCoreMIDI::registerAll(eventDistributor, scheduler, controller);
-	controller.registerPluggable(std::make_unique<MidiOutCoreMIDIVirtual>());
-	MidiOutCoreMIDI::registerAll(controller);
+	controller.registerPluggable(std::make_unique<MidiOutCoreMIDIVirtual>(
+		midiOutLatency));
+	MidiOutCoreMIDI::registerAll(controller, midiOutLatency);
 #endif
 #if COMPONENT_ALSAMIDI
-	MidiSessionALSA::registerAll(controller, reactor.getCliComm());
+	MidiSessionALSA::registerAll(controller, reactor.getCliComm(),
+	                             midiOutLatency);
 #endif
 
 	// Printers
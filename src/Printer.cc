@@ -1,10 +1,14 @@
 #include "Printer.hh"
 #include "PNG.hh"
 #include "FileOperations.hh"
+#include "Event.hh"
+#include "EventDistributor.hh"
+#include "File.hh"
 #include "IntegerSetting.hh"
 #include "MSXMotherBoard.hh"
 #include "CliComm.hh"
 #include "MSXException.hh"
+#include "Reactor.hh"
 #include "Math.hh"
 #include "MemBuffer.hh"
 #include "serialize.hh"
@@ -22,24 +26,42 @@ using std::string;
 
 namespace openmsx {
 
+// A page. The dots are only recorded (in a compact form) while printing,
+// the page is rendered when it's saved.
 class Paper
 {
 public:
 	Paper(unsigned x, unsigned y, double dotSizeX, double dotSizeY);
 
-	std::string save() const;
-	void setDotSize(double sizeX, double sizeY);
+	/** Render the page and write it to the given file. Is called on a
+	  * background thread, so it doesn't access anything but this object.
+	  * @throws MSXException
+	  */
+	void save(const std::string& filename) const;
 	void plot(double x, double y);
 
 private:
-	byte& dot(unsigned x, unsigned y);
+	// A dot (an antialiased ellipse) at position (x16 / 16, y16 / 16).
+	// The range of pixels that is covered is [dx1, dx2) x [dy1, dy2) relative
+	// to the pixel that contains that position.
+	struct Dot {
+		int32_t x16, y16;
+		int8_t dx1, dx2, dy1, dy2;
+	};
+
+	void setDotSize(double sizeX, double sizeY);
+	int getTable(int i) const;
+	int calcCoverage(int x, int y) const;
+	void render(byte* buf) const;
 
-	MemBuffer<byte> buf;
+	std::vector<Dot> dots;
 	std::vector<int> table;
 
 	double radiusX;
 	double radiusY;
 	int radius16;
+	int marginX; // a dot covers (at most) pixels [-margin, margin] relative to its center pixel
+	int marginY;
 
 	unsigned sizeX;
 	unsigned sizeY;
@@ -110,8 +132,11 @@ void RawPrinter::forceFormFeed()
 
 ImagePrinter::ImagePrinter(MSXMotherBoard& motherBoard_, bool graphicsHiLo_)
 	: motherBoard(motherBoard_)
+	, eventDistributor(motherBoard.getReactor().getEventDistributor())
 	, graphicsHiLo(graphicsHiLo_)
 {
+	eventDistributor.registerEventListener(OPENMSX_PRINT_DONE_EVENT, *this);
+
 	dpiSetting = motherBoard.getSharedStuff<IntegerSetting>(
 		"print-resolution",
 		motherBoard.getCommandController(), "print-resolution",
@@ -153,6 +178,9 @@ ImagePrinter::ImagePrinter(MSXMotherBoard& motherBoard_, bool graphicsHiLo_)
 ImagePrinter::~ImagePrinter()
 {
 	flushEmulatedPrinter();
+	// Don't lose the pages that are already printed.
+	writer.waitIdle();
+	eventDistributor.unregisterEventListener(OPENMSX_PRINT_DONE_EVENT, *this);
 }
 
 void ImagePrinter::write(byte data)
@@ -270,9 +298,29 @@ void ImagePrinter::flushEmulatedPrinter()
 	if (paper) {
 		if (printAreaBottom > printAreaTop) {
 			try {
-				string filename = paper->save();
-				motherBoard.getMSXCliComm().printInfo(
-					"Printed to ", filename);
+				string filename = FileOperations::getNextNumberedFileName(
+					"prints", "page", ".png");
+				// Already create the (empty) file, this reserves
+				// the name for this page.
+				{ File file(filename, File::TRUNCATE); }
+
+				// Jobs must be copyable, so share the (move-only) paper.
+				std::shared_ptr<const Paper> page = std::move(paper);
+				writer.push([this, page, filename] {
+					PrintResult r{true, filename};
+					try {
+						page->save(filename);
+					} catch (MSXException& e) {
+						r.ok = false;
+						r.value = e.getMessage();
+					}
+					{
+						std::lock_guard<std::mutex> lock(resultMutex);
+						results.push_back(std::move(r));
+					}
+					eventDistributor.distributeEvent(
+						std::make_shared<SimpleEvent>(OPENMSX_PRINT_DONE_EVENT));
+				});
 			} catch (MSXException& e) {
 				motherBoard.getMSXCliComm().printWarning(
 					"Failed to print: ", e.getMessage());
@@ -286,6 +334,24 @@ void ImagePrinter::flushEmulatedPrinter()
 	vpos = pageTop;
 }
 
+int ImagePrinter::signalEvent(const std::shared_ptr<const Event>& /*event*/)
+{
+	std::vector<PrintResult> finished;
+	{
+		std::lock_guard<std::mutex> lock(resultMutex);
+		std::swap(finished, results);
+	}
+	auto& cliComm = motherBoard.getMSXCliComm();
+	for (auto& r : finished) {
+		if (r.ok) {
+			cliComm.printInfo("Printed to ", r.value);
+		} else {
+			cliComm.printWarning("Failed to print: ", r.value);
+		}
+	}
+	return 0;
+}
+
 static unsigned compress9(unsigned a)
 {
 	unsigned result = 0;
@@ -1650,29 +1716,28 @@ REGISTER_POLYMORPHIC_INITIALIZER(Pluggable, ImagePrinterEpson, "ImagePrinterEpso
 // class Paper
 
 Paper::Paper(unsigned x, unsigned y, double dotSizeX, double dotSizeY)
-	: buf(x * y)
-	, sizeX(x), sizeY(y)
+	: sizeX(x), sizeY(y)
 {
-	memset(buf.data(), 255, x * y);
 	setDotSize(dotSizeX, dotSizeY);
 }
 
-string Paper::save() const
+void Paper::save(const std::string& filename) const
 {
-	string filename = FileOperations::getNextNumberedFileName(
-		"prints", "page", ".png");
+	MemBuffer<byte> buf(size_t(sizeX) * sizeY);
+	render(buf.data());
 	VLA(const void*, rowPointers, sizeY);
 	for (unsigned y = 0; y < sizeY; ++y) {
-		rowPointers[y] = &buf[sizeX * y];
+		rowPointers[y] = &buf[size_t(sizeX) * y];
 	}
 	PNG::saveGrayscale(sizeX, sizeY, rowPointers, filename);
-	return filename;
 }
 
 void Paper::setDotSize(double dotSizeX, double dotSizeY)
 {
 	radiusX = dotSizeX / 2.0;
 	radiusY = dotSizeY / 2.0;
+	marginX = int(ceil(radiusX)) + 2;
+	marginY = int(ceil(radiusY)) + 2;
 
 	int rx = int(16 * radiusX);
 	int ry = int(16 * radiusY);
@@ -1732,42 +1797,90 @@ void Paper::setDotSize(double dotSizeX, double dotSizeY)
 
 void Paper::plot(double xPos, double yPos)
 {
-	unsigned xx1 = max<int>(int(floor(xPos - radiusX)), 0);
-	unsigned xx2 = min<int>(int(ceil (xPos + radiusX)), sizeX);
-	unsigned yy1 = max<int>(int(floor(yPos - radiusY)), 0);
-	unsigned yy2 = min<int>(int(ceil (yPos + radiusY)), sizeY);
-
-	int y = 16 * yy1 - int(16 * yPos) + 16 + radius16;
-	for (unsigned yy = yy1; yy < yy2; ++yy) {
-		int x = 16 * xx1 - int(16 * xPos);
-		for (unsigned xx = xx1; xx < xx2; ++xx) {
-			int sum = 0;
-			for (int i = 0; i < 16; ++i) {
-				int a = table[y + i];
-				if (x < -a) {
-					int t = 16 + a + x;
-					if (t > 0) {
-						sum += min(t, 2 * a);
-					}
-				} else {
-					int t = a - x;
-					if (t > 0) {
-						sum += min(16, t);
-					}
-				}
+	Dot d;
+	d.x16 = int(16 * xPos);
+	d.y16 = int(16 * yPos);
+	int px = d.x16 >> 4;
+	int py = d.y16 >> 4;
+	d.dx1 = int(floor(xPos - radiusX)) - px;
+	d.dx2 = int(ceil (xPos + radiusX)) - px;
+	d.dy1 = int(floor(yPos - radiusY)) - py;
+	d.dy2 = int(ceil (yPos + radiusY)) - py;
+	dots.push_back(d);
+}
+
+int Paper::getTable(int i) const
+{
+	// outside the table means outside the dot
+	return (unsigned(i) < table.size()) ? table[i] : -(1 << 30);
+}
+
+// The amount (0..256) by which a pixel gets darker. 'x' and 'y' are the
+// position of the pixel relative to the dot (in 1/16 pixels), 'y' is offset
+// by the size of the table.
+int Paper::calcCoverage(int x, int y) const
+{
+	int sum = 0;
+	for (int i = 0; i < 16; ++i) {
+		int a = getTable(y + i);
+		if (x < -a) {
+			int t = 16 + a + x;
+			if (t > 0) {
+				sum += min(t, 2 * a);
+			}
+		} else {
+			int t = a - x;
+			if (t > 0) {
+				sum += min(16, t);
 			}
-			dot(xx, yy) = max(0, dot(xx, yy) - sum);
-			x += 16;
 		}
-		y += 16;
 	}
+	return sum;
 }
 
-byte& Paper::dot(unsigned x, unsigned y)
+void Paper::render(byte* buf) const
 {
-	assert(x < sizeX);
-	assert(y < sizeY);
-	return buf[y * sizeX + x];
+	memset(buf, 255, size_t(sizeX) * sizeY);
+
+	// The coverage of the pixels around a dot only depends on the
+	// position of the dot within its pixel (in 1/16 pixels), so calculate
+	// these 16x16 stamps once instead of for every dot.
+	int stampW = 2 * marginX + 1;
+	int stampH = 2 * marginY + 1;
+	int stampSize = stampW * stampH;
+	std::vector<uint16_t> stamps(256 * stampSize);
+	for (int fy = 0; fy < 16; ++fy) {
+		for (int fx = 0; fx < 16; ++fx) {
+			uint16_t* stamp = &stamps[(16 * fy + fx) * stampSize];
+			for (int dy = -marginY; dy <= marginY; ++dy) {
+				int y = 16 * dy - fy + 16 + radius16;
+				for (int dx = -marginX; dx <= marginX; ++dx) {
+					int x = 16 * dx - fx;
+					*stamp++ = calcCoverage(x, y);
+				}
+			}
+		}
+	}
+
+	for (auto& d : dots) {
+		int px = d.x16 >> 4;
+		int py = d.y16 >> 4;
+		const uint16_t* stamp =
+			&stamps[(16 * (d.y16 & 15) + (d.x16 & 15)) * stampSize];
+		// Same pixels as before recording was introduced, clipped to the
+		// page (and to the stamp, though that doesn't matter in practice).
+		int xx1 = max(px + max<int>(d.dx1, -marginX), 0);
+		int xx2 = min(px + min<int>(d.dx2,  marginX + 1), int(sizeX));
+		int yy1 = max(py + max<int>(d.dy1, -marginY), 0);
+		int yy2 = min(py + min<int>(d.dy2,  marginY + 1), int(sizeY));
+		for (int yy = yy1; yy < yy2; ++yy) {
+			const uint16_t* s = &stamp[(yy - py + marginY) * stampW];
+			byte* line = &buf[size_t(yy) * sizeX];
+			for (int xx = xx1; xx < xx2; ++xx) {
+				line[xx] = max(0, line[xx] - s[xx - px + marginX]);
+			}
+		}
+	}
 }
 
 } // namespace openmsx
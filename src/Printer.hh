@@ -11,12 +11,18 @@
 #define PRINTER_HH
 
 #include "PrinterPortDevice.hh"
+#include "EventListener.hh"
+#include "WorkerThread.hh"
 #include "openmsx.hh"
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
+class EventDistributor;
 class IntegerSetting;
 class Paper;
 
@@ -65,7 +71,9 @@ private:
 */
 
 // Abstract image printer
-class ImagePrinter : public PrinterCore
+// The printed dots are only recorded, a page is rendered (and written to a
+// PNG file) on a background thread when it's finished.
+class ImagePrinter : public PrinterCore, private EventListener
 {
 public:
 	void write(byte data) override;
@@ -159,12 +167,24 @@ protected:
 	bool noHighEscapeCodes;
 
 private:
+	// EventListener
+	int signalEvent(const std::shared_ptr<const Event>& event) override;
+
 	MSXMotherBoard& motherBoard;
+	EventDistributor& eventDistributor;
 	std::unique_ptr<Paper> paper;
 
 	std::shared_ptr<IntegerSetting> dpiSetting;
 
 	const bool graphicsHiLo;
+
+	WorkerThread writer;
+	struct PrintResult {
+		bool ok;
+		std::string value; // filename or error message
+	};
+	std::mutex resultMutex;
+	std::vector<PrintResult> results; // protected by 'resultMutex'
 };
 
 // emulated MSX printer
@@ -33,6 +33,14 @@ bool RTScheduler::isPending(const RTSchedulable& schedulable) const
 	return ranges::any_of(queue, EqualRTSchedulable(schedulable));
 }
 
+uint64_t RTScheduler::getTimeTillNext() const
+{
+	if (queue.empty()) return uint64_t(-1);
+	auto now = Timer::getTime();
+	auto next = queue.front().time;
+	return (next > now) ? (next - now) : 0;
+}
+
 void RTScheduler::scheduleHelper(uint64_t limit)
 {
 	// Process at most this many events to prevent getting stuck in an
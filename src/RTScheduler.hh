@@ -28,6 +28,10 @@ public:
 		}
 	}
 
+	/** The time (in us) till the first RTSchedulable expires, or
+	  * uint64_t(-1) when there's none. */
+	uint64_t getTimeTillNext() const;
+
 private:
 	// These are called by RTSchedulable
 	friend class RTSchedulable;
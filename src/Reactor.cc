@@ -17,6 +17,7 @@
 #include "StateChangeDistributor.hh"
 #include "Command.hh"
 #include "AfterCommand.hh"
+#include "AsyncCommand.hh"
 #include "MessageCommand.hh"
 #include "CommandException.hh"
 #include "GlobalCliComm.hh"
@@ -24,6 +25,10 @@
 #include "Display.hh"
 #include "Mixer.hh"
 #include "AviRecorder.hh"
+#include "FrameExporter.hh"
+#include "FrameHasher.hh"
+#include "FrameProfiler.hh"
+#include "Instrumentation.hh"
 #include "GlobalSettings.hh"
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
@@ -36,6 +41,11 @@
 #include "FileOperations.hh"
 #include "ReadDir.hh"
 #include "Thread.hh"
+#include "WorkerThread.hh"
+#include "DeltaBlock.hh"
+#include "File.hh"
+#include "MemBuffer.hh"
+#include "TclArgParser.hh"
 #include "Timer.hh"
 #include "serialize.hh"
 #include "checked_cast.hh"
@@ -44,9 +54,22 @@
 #include "stl.hh"
 #include "unreachable.hh"
 #include "view.hh"
+#include "xrange.hh"
 #include "build-info.hh"
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#ifndef _WIN32
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using std::make_shared;
 using std::make_unique;
@@ -154,6 +177,82 @@ private:
 	Reactor& reactor;
 };
 
+class SaveStateSlotCommand final : public Command
+{
+public:
+	SaveStateSlotCommand(CommandController& commandController, Reactor& reactor);
+	~SaveStateSlotCommand();
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	string help(const vector<string>& tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+
+	/** Create a new machine from the given slot. */
+	Reactor::Board restoreBoard(const string& slotName);
+	bool hasSlot(const string& slotName) const { return slots.count(slotName) != 0; }
+
+private:
+	void store(span<const TclObject> tokens, TclObject& result);
+	void restore(span<const TclObject> tokens, TclObject& result);
+	void info(span<const TclObject> tokens, TclObject& result) const;
+	void flush();
+	void reportWriteErrors();
+
+	// Same representation as the snapshots of the ReverseManager.
+	struct Slot {
+		vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+		MemBuffer<uint8_t> savestate;
+		size_t size;
+	};
+	std::map<string, Slot> slots;
+	// Shared by all slots, so unchanged memory is stored only once.
+	LastDeltaBlocks lastDeltaBlocks;
+
+	Reactor& reactor;
+	WorkerThread writer; // writes (optional) copies of the slots to disk
+	std::mutex errorMutex;
+	vector<string> writeErrors; // protected by 'errorMutex'
+};
+
+class ForkMachineCommand final : public Command
+{
+public:
+	ForkMachineCommand(CommandController& commandController, Reactor& reactor);
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	string help(const vector<string>& tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+private:
+	Reactor& reactor;
+};
+
+class MachinePoolCommand final : public Command, private RTSchedulable
+{
+public:
+	MachinePoolCommand(CommandController& commandController, Reactor& reactor);
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	string help(const vector<string>& tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+
+	/** Take a ready (booted from scratch) machine with the given config
+	  * out of the pool, returns nullptr when there's none.
+	  */
+	Reactor::Board take(string_view machine);
+
+private:
+	void fill(span<const TclObject> tokens);
+	void clear();
+	void replenishLater();
+	Reactor::Board createBoard();
+
+	// RTSchedulable
+	void executeRT() override;
+
+	Reactor& reactor;
+	vector<Reactor::Board> pool;
+	string config;   // machine config of the pooled machines
+	string snapshot; // if not empty: restore this savestate slot instead
+	unsigned size = 0;
+};
+
 class GetClipboardCommand final : public Command
 {
 public:
@@ -216,6 +315,8 @@ void Reactor::init()
 		*eventDistributor, *globalCliComm, *this);
 	globalSettings = make_unique<GlobalSettings>(
 		*globalCommandController);
+	frameProfiler = make_unique<FrameProfiler>(
+		*globalCommandController, *globalCliComm);
 	inputEventGenerator = make_unique<InputEventGenerator>(
 		*globalCommandController, *eventDistributor, *globalSettings);
 	mixer = make_unique<Mixer>(
@@ -227,12 +328,16 @@ void Reactor::init()
 	virtualDrive = make_unique<DiskChanger>(
 		*this, "virtual_drive");
 	filePool = make_unique<FilePool>(*globalCommandController, *this);
+	// starts loading in the background
+	softwareDatabase = make_unique<RomDatabase>(*globalCliComm);
 	userSettings = make_unique<UserSettings>(
 		*globalCommandController);
 	afterCommand = make_unique<AfterCommand>(
 		*this, *eventDistributor, *globalCommandController);
 	exitCommand = make_unique<ExitCommand>(
 		*globalCommandController, *eventDistributor);
+	asyncCommand = make_unique<AsyncCommand>(
+		*globalCommandController, *eventDistributor);
 	messageCommand = make_unique<MessageCommand>(
 		*globalCommandController);
 	machineCommand = make_unique<MachineCommand>(
@@ -251,11 +356,19 @@ void Reactor::init()
 		*globalCommandController, *this);
 	restoreMachineCommand = make_unique<RestoreMachineCommand>(
 		*globalCommandController, *this);
+	saveStateSlotCommand = make_unique<SaveStateSlotCommand>(
+		*globalCommandController, *this);
+	forkMachineCommand = make_unique<ForkMachineCommand>(
+		*globalCommandController, *this);
+	machinePoolCommand = make_unique<MachinePoolCommand>(
+		*globalCommandController, *this);
 	getClipboardCommand = make_unique<GetClipboardCommand>(
 		*globalCommandController);
 	setClipboardCommand = make_unique<SetClipboardCommand>(
 		*globalCommandController);
 	aviRecordCommand = make_unique<AviRecorder>(*this);
+	frameExporter = make_unique<FrameExporter>(*this);
+	frameHasher = make_unique<FrameHasher>(*this);
 	extensionInfo = make_unique<ConfigInfo>(
 		getOpenMSXInfoCommand(), "extensions");
 	machineInfo   = make_unique<ConfigInfo>(
@@ -295,9 +408,6 @@ Reactor::~Reactor()
 
 RomDatabase& Reactor::getSoftwareDatabase()
 {
-	if (!softwareDatabase) {
-		softwareDatabase = make_unique<RomDatabase>(*globalCliComm);
-	}
 	return *softwareDatabase;
 }
 
@@ -436,9 +546,12 @@ void Reactor::switchMachine(const string& machine)
 	assert(Thread::isMainThread());
 	// Note: loadMachine can throw an exception and in that case the
 	//       motherboard must be considered as not created at all.
-	auto newBoard_ = createEmptyMotherBoard();
+	auto newBoard_ = machinePoolCommand->take(machine);
+	if (!newBoard_) {
+		newBoard_ = createEmptyMotherBoard();
+		newBoard_->loadMachine(machine);
+	}
 	auto* newBoard = newBoard_.get();
-	newBoard->loadMachine(machine);
 	boards.push_back(move(newBoard_));
 
 	auto* oldBoard = activeBoard;
@@ -514,9 +627,10 @@ void Reactor::enterMainLoop()
 	}
 }
 
-void Reactor::run(CommandLineParser& parser)
+void Reactor::startUp(CommandLineParser& parser)
 {
 	auto& commandController = *globalCommandController;
+	auto scriptsStart = Timer::getTime();
 
 	// execute init.tcl
 	try {
@@ -536,6 +650,32 @@ void Reactor::run(CommandLineParser& parser)
 		}
 	}
 
+	if (parser.isVerboseStartup()) {
+		auto& cliComm = getCliComm();
+		uint64_t scripts = Timer::getTime() - scriptsStart;
+		uint64_t total = scripts;
+		for (auto& p : parser.getStartupTimes()) {
+			cliComm.printInfo("Startup: ", p.first, ": ",
+			                  p.second / 1000.0, "ms");
+			total += p.second;
+		}
+		cliComm.printInfo("Startup: startup scripts: ", scripts / 1000.0, "ms");
+		cliComm.printInfo("Startup: total: ", total / 1000.0, "ms");
+	}
+
+	// -benchmark: start the benchmark script as soon as the machine runs
+	const auto& benchmarkDuration = parser.getBenchmarkDuration();
+	if (!benchmarkDuration.empty()) {
+		try {
+			commandController.executeCommand(strCat(
+				"after boot {benchmark -duration ", benchmarkDuration,
+				" -command exit}"));
+		} catch (CommandException& e) {
+			throw FatalError("Couldn't start benchmark: ",
+			                 e.getMessage());
+		}
+	}
+
 	// At this point openmsx is fully started, it's OK now to start
 	// accepting external commands
 	getGlobalCliComm().setAllowExternalCommands();
@@ -552,20 +692,32 @@ void Reactor::run(CommandLineParser& parser)
 			activeBoard->powerUp();
 		}
 	}
+}
+
+void Reactor::run(CommandLineParser& parser)
+{
+	startUp(parser);
 
 	while (running) {
-		eventDistributor->deliverEvents();
+		{
+			FrameProfiler::Section section(*frameProfiler, FrameProfiler::EVENTS);
+			eventDistributor->deliverEvents();
+		}
 		assert(garbageBoards.empty());
 		bool blocked = (blockedCounter > 0) || !activeBoard;
-		if (!blocked) blocked = !activeBoard->execute();
+		if (!blocked) {
+			FrameProfiler::Section section(*frameProfiler, FrameProfiler::EMULATION);
+			blocked = !activeBoard->execute();
+		}
 		if (blocked) {
-			// At first sight a better alternative is to use the
-			// SDL_WaitEvent() function. Though when inspecting
-			// the implementation of that function, it turns out
-			// to also use a sleep/poll loop, with even shorter
-			// sleep periods as we use here. Maybe in future
-			// SDL implementations this will be improved.
-			eventDistributor->sleep(20 * 1000);
+			FrameProfiler::Section section(*frameProfiler, FrameProfiler::SLEEP);
+			// Sleep till there's something to do: an SDL event,
+			// a command from another thread (e.g. from CliServer)
+			// or a realtime timer (e.g. an OSD animation, a
+			// delayed repaint or 'after realtime'). Wake up at
+			// least once per second for Tcl's own event loop.
+			eventDistributor->waitForEvents(std::min<uint64_t>(
+				rtScheduler->getTimeTillNext(), 1000 * 1000));
 		}
 	}
 }
@@ -732,23 +884,164 @@ TestMachineCommand::TestMachineCommand(CommandController& commandController_,
 {
 }
 
-void TestMachineCommand::execute(span<const TclObject> tokens,
-                                 TclObject& result)
+// Returns the error message (empty on success) and the duration in us.
+static std::pair<string, uint64_t> testMachine(Reactor& reactor, const string& config)
 {
-	checkNumArgs(tokens, 2, "machinetype");
+	string error;
+	auto start = Timer::getTime();
 	try {
 		MSXMotherBoard mb(reactor);
-		mb.loadMachine(tokens[1].getString().str());
+		mb.loadMachine(config);
 	} catch (MSXException& e) {
-		result = e.getMessage(); // error
+		error = e.getMessage();
+	} catch (std::exception& e) {
+		error = strCat("unexpected error: ", e.what());
+	}
+	return {std::move(error), Timer::getTime() - start};
+}
+
+#ifndef _WIN32
+// Write a result record to the pipe: index, duration, error length, error.
+static void writeTestResult(int fd, uint32_t index, uint64_t time, const string& error)
+{
+	uint32_t len = uint32_t(error.size());
+	string rec(reinterpret_cast<const char*>(&index), sizeof(index));
+	rec.append(reinterpret_cast<const char*>(&time), sizeof(time));
+	rec.append(reinterpret_cast<const char*>(&len), sizeof(len));
+	rec += error;
+	const char* p = rec.data();
+	size_t left = rec.size();
+	while (left) {
+		auto n = ::write(fd, p, left);
+		if (n <= 0) {
+			if ((n < 0) && (errno == EINTR)) continue;
+			return;
+		}
+		p += n; left -= n;
+	}
+}
+
+static bool readAll(int fd, void* buf, size_t size)
+{
+	auto* p = static_cast<char*>(buf);
+	while (size) {
+		auto n = ::read(fd, p, size);
+		if (n <= 0) {
+			if ((n < 0) && (errno == EINTR)) continue;
+			return false;
+		}
+		p += n; size -= n;
+	}
+	return true;
+}
+#endif
+
+void TestMachineCommand::execute(span<const TclObject> tokens,
+                                 TclObject& result)
+{
+	int jobs = -1;
+	ArgsInfo info[] = { valueArg("-jobs", jobs) };
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
+	if (jobs == -1) {
+		if (arguments.size() != 1) throw SyntaxError();
+		result = testMachine(reactor, arguments[0].getString().str()).first;
+		return;
+	}
+
+	// batch mode
+	if (jobs < 0) throw CommandException("-jobs must be at least 0.");
+	if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+	auto configs = to_vector(view::transform(arguments,
+		[](const TclObject& o) { return o.getString().str(); }));
+	size_t num = configs.size();
+	vector<std::pair<string, uint64_t>> results(num);
+	vector<bool> done(num, false);
+
+#ifndef _WIN32
+	// Machines can only be constructed on the main thread, so to use all
+	// cores each worker is a forked process. They start with a copy of
+	// everything that's already loaded (e.g. the shared rom store and the
+	// decompression cache), and the roms they map are shared through the
+	// page cache. Sound output is muted so that no worker touches the
+	// sound driver while it's active.
+	jobs = int(std::min<size_t>(jobs, num));
+	if (jobs > 1) {
+		auto& mixer = reactor.getMixer();
+		mixer.mute();
+		vector<std::pair<pid_t, int>> workers; // pid, read end of pipe
+		for (auto w : xrange(jobs)) {
+			int fds[2];
+			if (pipe(fds) != 0) break;
+			std::cout.flush(); std::cerr.flush(); fflush(nullptr);
+			pid_t pid = fork();
+			if (pid < 0) {
+				close(fds[0]); close(fds[1]);
+				break;
+			}
+			if (pid == 0) {
+				// worker: test every jobs'th config, then exit without
+				// running any destructors or exit handlers
+				close(fds[0]);
+				for (size_t i = w; i < num; i += jobs) {
+					auto r = testMachine(reactor, configs[i]);
+					writeTestResult(fds[1], uint32_t(i), r.second, r.first);
+				}
+				_exit(0);
+			}
+			close(fds[1]);
+			workers.emplace_back(pid, fds[0]);
+		}
+		for (auto w : xrange(workers.size())) {
+			auto& wk = workers[w];
+			while (true) {
+				uint32_t index, len;
+				uint64_t time;
+				if (!readAll(wk.second, &index, sizeof(index)) ||
+				    !readAll(wk.second, &time, sizeof(time)) ||
+				    !readAll(wk.second, &len, sizeof(len))) break;
+				string error(len, '\0');
+				if (!readAll(wk.second, &error[0], len) || (index >= num)) break;
+				results[index] = {std::move(error), time};
+				done[index] = true;
+			}
+			close(wk.second);
+			int status = 0;
+			while ((waitpid(wk.first, &status, 0) < 0) && (errno == EINTR)) {}
+			for (size_t i = w; i < num; i += jobs) {
+				if (done[i]) continue;
+				// this config (or an earlier one) crashed the worker
+				results[i].first = WIFSIGNALED(status)
+					? strCat("worker process killed by signal ", WTERMSIG(status))
+					: string("worker process died");
+				done[i] = true;
+			}
+		}
+		mixer.unmute();
+		// When not all workers could be started, the remaining configs
+		// are tested below, in this process.
+	}
+#endif
+	for (auto i : xrange(num)) {
+		if (!done[i]) results[i] = testMachine(reactor, configs[i]);
+	}
+
+	for (auto i : xrange(num)) {
+		result.addListElement(makeTclList(
+			configs[i], results[i].first, double(results[i].second) / 1000.0));
 	}
 }
 
 string TestMachineCommand::help(const vector<string>& /*tokens*/) const
 {
-	return "Test the configuration for the given machine. "
-	       "Returns an error message explaining why the configuration is "
-	       "invalid or an empty string in case of success.";
+	return "test_machine <machine>\n"
+	       "  Test the configuration for the given machine. Returns an "
+	       "error message explaining why the configuration is invalid or "
+	       "an empty string in case of success.\n"
+	       "test_machine -jobs <n> <machine> [<machine> ...]\n"
+	       "  Test several configurations, using <n> worker processes (0 "
+	       "means one per CPU core). Returns for each configuration a list "
+	       "with its name, the error message (or an empty string) and the "
+	       "time it took in milliseconds.";
 }
 
 void TestMachineCommand::tabCompletion(vector<string>& tokens) const
@@ -882,17 +1175,20 @@ StoreMachineCommand::StoreMachineCommand(
 
 void StoreMachineCommand::execute(span<const TclObject> tokens, TclObject& result)
 {
-	checkNumArgs(tokens, Between{1, 3}, Prefix{1}, "?id? ?filename?");
+	bool binary = (tokens.size() > 1) && (tokens[1] == "-binary");
+	if (binary) tokens = tokens.subspan(1);
+	checkNumArgs(tokens, Between{1, 3}, Prefix{1}, "?-binary? ?id? ?filename?");
 	string filename;
 	string_view machineID;
+	const char* extension = binary ? ".bin" : ".xml.gz";
 	switch (tokens.size()) {
 	case 1:
 		machineID = reactor.getMachineID();
-		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", ".xml.gz");
+		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", extension);
 		break;
 	case 2:
 		machineID = tokens[1].getString();
-		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", ".xml.gz");
+		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", extension);
 		break;
 	case 3:
 		machineID = tokens[1].getString();
@@ -902,9 +1198,17 @@ void StoreMachineCommand::execute(span<const TclObject> tokens, TclObject& resul
 
 	auto& board = reactor.getMachine(machineID);
 
-	XmlOutputArchive out(filename);
-	out.serialize("machine", board);
-	out.close();
+	INSTRUMENT_ZONE("store_machine");
+	if (binary) {
+		BinOutputArchive out(filename);
+		out.serialize("machine", board);
+		out.close();
+	} else {
+		XmlOutputArchive out(filename, reactor.getGlobalSettings()
+			.getStateCompressionSetting().getInt());
+		out.serialize("machine", board);
+		out.close();
+	}
 	result = filename;
 }
 
@@ -914,6 +1218,7 @@ string StoreMachineCommand::help(const vector<string>& /*tokens*/) const
 		"store_machine                       Save state of current machine to file \"openmsxNNNN.xml.gz\"\n"
 		"store_machine machineID             Save state of machine \"machineID\" to file \"openmsxNNNN.xml.gz\"\n"
                 "store_machine machineID <filename>  Save state of machine \"machineID\" to indicated file\n"
+		"store_machine -binary ...           Save state in the compact binary format (default file \"openmsxNNNN.bin\")\n"
 		"\n"
 		"This is a low-level command, the 'savestate' script is easier to use.";
 }
@@ -971,8 +1276,14 @@ void RestoreMachineCommand::execute(span<const TclObject> tokens,
 
 	//std::cerr << "Loading " << filename << '\n';
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("machine", *newBoard);
+		INSTRUMENT_ZONE("restore_machine");
+		if (BinInputArchive::isBinArchive(filename)) {
+			BinInputArchive in(filename);
+			in.serialize("machine", *newBoard);
+		} else {
+			XmlInputArchive in(filename);
+			in.serialize("machine", *newBoard);
+		}
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load state, bad file format: ",
 		                       e.getMessage());
@@ -1004,6 +1315,415 @@ void RestoreMachineCommand::tabCompletion(vector<string>& tokens) const
 }
 
 
+// class SaveStateSlotCommand
+
+SaveStateSlotCommand::SaveStateSlotCommand(
+	CommandController& commandController_, Reactor& reactor_)
+	: Command(commandController_, "savestate_slot")
+	, reactor(reactor_)
+{
+}
+
+SaveStateSlotCommand::~SaveStateSlotCommand()
+{
+	// Don't lose the write-through copies on exit.
+	writer.waitIdle();
+}
+
+void SaveStateSlotCommand::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	reportWriteErrors();
+	executeSubCommand(tokens[1].getString(),
+		"store",   [&]{ store(tokens, result); },
+		"restore", [&]{ restore(tokens, result); },
+		"delete",  [&]{
+			checkNumArgs(tokens, 3, "name");
+			slots.erase(tokens[2].getString().str());
+		},
+		"list",    [&]{
+			checkNumArgs(tokens, 2, "");
+			for (auto& p : slots) result.addListElement(p.first);
+		},
+		"info",    [&]{ info(tokens, result); },
+		"flush",   [&]{
+			checkNumArgs(tokens, 2, "");
+			flush();
+		});
+}
+
+void SaveStateSlotCommand::store(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{3, 5}, Prefix{2}, "name ?id? ?filename?");
+	string slotName = tokens[2].getString().str();
+	auto& board = (tokens.size() > 3)
+		? reactor.getMachine(tokens[3].getString())
+		: reactor.getMachine(reactor.getMachineID());
+
+	Slot slot;
+	{
+		// Not a reverse snapshot: that would reset the dirty page
+		// tracking the ReverseManager relies on.
+		MemOutputArchive out(lastDeltaBlocks, slot.deltaBlocks, false);
+		out.serialize("machine", board);
+		slot.savestate = out.releaseBuffer(slot.size);
+	}
+	slots[slotName] = std::move(slot);
+
+	if (tokens.size() == 5) {
+		// The state is serialized here, but the (slow) file write
+		// happens on the background thread.
+		string filename = tokens[4].getString().str();
+		BinOutputArchive out(filename);
+		out.serialize("machine", board);
+		size_t size;
+		auto buf = std::make_shared<MemBuffer<uint8_t>>(out.releaseBuffer(size));
+		writer.push([this, filename, buf, size] {
+			try {
+				File file(filename, File::TRUNCATE);
+				file.write(buf->data(), size);
+			} catch (MSXException& e) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				writeErrors.push_back(strCat(
+					"Couldn't write savestate slot to ", filename,
+					": ", e.getMessage()));
+			}
+		});
+	}
+	result = slotName;
+}
+
+void SaveStateSlotCommand::restore(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 3, "name");
+	auto newBoard = restoreBoard(tokens[2].getString().str());
+	result = newBoard->getMachineID();
+	reactor.boards.push_back(move(newBoard));
+}
+
+Reactor::Board SaveStateSlotCommand::restoreBoard(const string& slotName)
+{
+	auto it = slots.find(slotName);
+	if (it == end(slots)) {
+		throw CommandException("No such savestate slot: ", slotName);
+	}
+	const auto& slot = it->second;
+
+	auto newBoard = reactor.createEmptyMotherBoard();
+	try {
+		MemInputArchive in(slot.savestate.data(), slot.size, slot.deltaBlocks);
+		in.serialize("machine", *newBoard);
+	} catch (MSXException& e) {
+		throw CommandException("Cannot load state: ", e.getMessage());
+	}
+	// See RestoreMachineCommand.
+	newBoard->getStateChangeDistributor().stopReplay(newBoard->getCurrentTime());
+	return newBoard;
+}
+
+void SaveStateSlotCommand::info(span<const TclObject> tokens, TclObject& result) const
+{
+	checkNumArgs(tokens, 3, "name");
+	auto it = slots.find(tokens[2].getString().str());
+	if (it == end(slots)) {
+		throw CommandException("No such savestate slot: ", tokens[2].getString());
+	}
+	const auto& slot = it->second;
+	// Blocks that didn't change since an earlier slot are shared with that
+	// slot, these are counted in full for each slot.
+	size_t blockBytes = 0;
+	for (auto& b : slot.deltaBlocks) blockBytes += b->getAllocSize();
+	result.addDictKeyValue("bytes", int64_t(slot.size));
+	result.addDictKeyValue("blocks", int64_t(slot.deltaBlocks.size()));
+	result.addDictKeyValue("block_bytes", int64_t(blockBytes));
+}
+
+void SaveStateSlotCommand::flush()
+{
+	writer.waitIdle();
+	std::lock_guard<std::mutex> lock(errorMutex);
+	if (!writeErrors.empty()) {
+		string msg;
+		for (auto& e : writeErrors) {
+			if (!msg.empty()) msg += '\n';
+			msg += e;
+		}
+		writeErrors.clear();
+		throw CommandException(msg);
+	}
+}
+
+void SaveStateSlotCommand::reportWriteErrors()
+{
+	std::lock_guard<std::mutex> lock(errorMutex);
+	for (auto& e : writeErrors) {
+		reactor.getCliComm().printWarning(e);
+	}
+	writeErrors.clear();
+}
+
+string SaveStateSlotCommand::help(const vector<string>& /*tokens*/) const
+{
+	return "Keep savestates in memory, restoring those is much faster than loading a file.\n"
+	       "savestate_slot store <name> ?id? ?filename?  Store state of (current) machine in slot <name>,\n"
+	       "                                             optionally also write it to file (in the background)\n"
+	       "savestate_slot restore <name>                Create a new machine from slot <name>, returns its ID\n"
+	       "savestate_slot delete <name>                 Remove slot <name>\n"
+	       "savestate_slot list                          List all slots\n"
+	       "savestate_slot info <name>                   Size of slot <name>: bytes of the state itself, number of\n"
+	       "                                             memory blocks and bytes used by those blocks\n"
+	       "savestate_slot flush                         Wait till all files are written\n"
+	       "\n"
+	       "This is a low-level command, the 'savestate -memory' and 'loadstate -memory' scripts are easier to use.";
+}
+
+void SaveStateSlotCommand::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const cmds[] = {
+			"store", "restore", "delete", "list", "info", "flush",
+		};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() == 3) && (tokens[1] != "list")) {
+		completeString(tokens, view::keys(slots));
+	} else if ((tokens.size() == 4) && (tokens[1] == "store")) {
+		completeString(tokens, reactor.getMachineIDs());
+	}
+}
+
+
+// class ForkMachineCommand
+
+ForkMachineCommand::ForkMachineCommand(
+	CommandController& commandController_, Reactor& reactor_)
+	: Command(commandController_, "fork_machine")
+	, reactor(reactor_)
+{
+}
+
+void ForkMachineCommand::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{1, 2}, Prefix{1}, "?id?");
+	auto& board = (tokens.size() == 2)
+		? reactor.getMachine(tokens[1].getString())
+		: reactor.getMachine(reactor.getMachineID());
+
+	// Copy the state via a memory archive, that's a lot cheaper than going
+	// through a file. Because 'lastDeltaBlocks' is empty all blobs are
+	// stored as a plain copy (and nothing gets compressed).
+	LastDeltaBlocks lastDeltaBlocks;
+	vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+	MemOutputArchive out(lastDeltaBlocks, deltaBlocks, false);
+	out.serialize("machine", board);
+	size_t size;
+	auto buf = out.releaseBuffer(size);
+
+	auto newBoard = reactor.createEmptyMotherBoard();
+	try {
+		MemInputArchive in(buf.data(), size, deltaBlocks);
+		in.serialize("machine", *newBoard);
+	} catch (MSXException& e) {
+		throw CommandException("Cannot fork machine: ", e.getMessage());
+	}
+	// See RestoreMachineCommand.
+	newBoard->getStateChangeDistributor().stopReplay(newBoard->getCurrentTime());
+
+	result = newBoard->getMachineID();
+	reactor.boards.push_back(move(newBoard));
+}
+
+string ForkMachineCommand::help(const vector<string>& /*tokens*/) const
+{
+	return "fork_machine ?id?  Create a new machine that is an exact copy of "
+	       "the (current) machine, returns the ID of the new machine.";
+}
+
+void ForkMachineCommand::tabCompletion(vector<string>& tokens) const
+{
+	completeString(tokens, reactor.getMachineIDs());
+}
+
+
+// class MachinePoolCommand
+
+// Delay between creating two machines in the background. Creating a machine
+// can take a while, this keeps the active machine running smoothly.
+static const uint64_t POOL_REPLENISH_DELAY = 100000; // 100ms
+
+MachinePoolCommand::MachinePoolCommand(
+	CommandController& commandController_, Reactor& reactor_)
+	: Command(commandController_, "machine_pool")
+	, RTSchedulable(reactor_.getRTScheduler())
+	, reactor(reactor_)
+{
+}
+
+void MachinePoolCommand::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	executeSubCommand(tokens[1].getString(),
+		"fill",   [&]{ fill(tokens); },
+		"take",   [&]{
+			checkNumArgs(tokens, 2, "");
+			if (size == 0) {
+				throw CommandException("The machine pool is empty, "
+				                       "use 'machine_pool fill' first.");
+			}
+			Reactor::Board board;
+			if (!pool.empty()) {
+				board = move(pool.back());
+				pool.pop_back();
+			} else {
+				// not replenished yet
+				try {
+					board = createBoard();
+				} catch (MSXException& e) {
+					throw CommandException("Cannot create machine: ",
+					                       e.getMessage());
+				}
+			}
+			replenishLater();
+			result = board->getMachineID();
+			reactor.boards.push_back(move(board));
+		},
+		"clear",  [&]{
+			checkNumArgs(tokens, 2, "");
+			clear();
+		},
+		"status", [&]{
+			checkNumArgs(tokens, 2, "");
+			result.addDictKeyValue("machine", config);
+			result.addDictKeyValue("snapshot", snapshot);
+			result.addDictKeyValue("size", int(size));
+			result.addDictKeyValue("ready", int(pool.size()));
+		});
+}
+
+void MachinePoolCommand::fill(span<const TclObject> tokens)
+{
+	string newSnapshot;
+	ArgsInfo info[] = { valueArg("-snapshot", newSnapshot) };
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(2), info);
+	if (arguments.size() != (newSnapshot.empty() ? 2 : 1)) {
+		throw SyntaxError();
+	}
+	string newConfig = newSnapshot.empty()
+	                 ? arguments[0].getString().str() : string{};
+	int newSize = arguments.back().getInt(getInterpreter());
+	if ((newSize < 1) || (newSize > 64)) {
+		throw CommandException("Pool size must be in range [1, 64].");
+	}
+	if (!newSnapshot.empty() && !reactor.saveStateSlotCommand->hasSlot(newSnapshot)) {
+		throw CommandException("No such savestate slot: ", newSnapshot);
+	}
+
+	if ((newConfig != config) || (newSnapshot != snapshot)) {
+		clear();
+		config = std::move(newConfig);
+		snapshot = std::move(newSnapshot);
+	}
+	size = newSize;
+	while (pool.size() > size) pool.pop_back();
+
+	if (pool.empty()) {
+		// Create the first one right away, this also reports errors
+		// in the config (or snapshot).
+		try {
+			pool.push_back(createBoard());
+		} catch (MSXException& e) {
+			clear();
+			throw CommandException("Cannot create machine: ", e.getMessage());
+		}
+		if (!snapshot.empty()) {
+			config = pool.back()->getMachineName().str();
+		}
+	}
+	replenishLater();
+}
+
+void MachinePoolCommand::clear()
+{
+	cancelRT();
+	pool.clear(); // not active, so these can be deleted right away
+	config.clear();
+	snapshot.clear();
+	size = 0;
+}
+
+Reactor::Board MachinePoolCommand::take(string_view machine)
+{
+	// machines restored from a snapshot are not in their initial state
+	if (pool.empty() || !snapshot.empty() || (machine != config)) {
+		return nullptr;
+	}
+	auto board = move(pool.back());
+	pool.pop_back();
+	replenishLater();
+	return board;
+}
+
+void MachinePoolCommand::replenishLater()
+{
+	if ((pool.size() < size) && !isPendingRT()) {
+		scheduleRT(POOL_REPLENISH_DELAY);
+	}
+}
+
+Reactor::Board MachinePoolCommand::createBoard()
+{
+	if (!snapshot.empty()) {
+		return reactor.saveStateSlotCommand->restoreBoard(snapshot);
+	}
+	auto board = reactor.createEmptyMotherBoard();
+	board->loadMachine(config);
+	return board;
+}
+
+void MachinePoolCommand::executeRT()
+{
+	// one machine at a time, see POOL_REPLENISH_DELAY
+	if (pool.size() >= size) return;
+	try {
+		pool.push_back(createBoard());
+	} catch (MSXException& e) {
+		// e.g. the savestate slot was deleted, don't keep retrying
+		reactor.getCliComm().printWarning(
+			"Couldn't create machine for the machine pool: ",
+			e.getMessage());
+		size = unsigned(pool.size());
+		return;
+	}
+	replenishLater();
+}
+
+string MachinePoolCommand::help(const vector<string>& /*tokens*/) const
+{
+	return "Keep a number of machines ready, so that getting a new machine doesn't have to wait for it to be created.\n"
+	       "machine_pool fill <machine> <n>          Keep <n> machines of type <machine> ready\n"
+	       "machine_pool fill -snapshot <slot> <n>   Keep <n> machines restored from savestate slot <slot> ready\n"
+	       "machine_pool take                        Take a machine out of the pool, returns its ID\n"
+	       "machine_pool clear                       Delete all pooled machines\n"
+	       "machine_pool status                      Query the pool\n"
+	       "\n"
+	       "Taken machines are replaced in the background. The 'machine' command also uses a "
+	       "pooled machine when it has the requested type (and was not restored from a snapshot).";
+}
+
+void MachinePoolCommand::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const cmds[] = {
+			"fill", "take", "clear", "status",
+		};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() == 3) && (tokens[1] == "fill")) {
+		auto machines = Reactor::getHwConfigs("machines");
+		machines.emplace_back("-snapshot");
+		completeString(tokens, machines);
+	}
+}
+
+
 // class GetClipboardCommand
 
 GetClipboardCommand::GetClipboardCommand(CommandController& commandController_)
@@ -13,6 +13,7 @@
 namespace openmsx {
 
 class RTScheduler;
+class FrameProfiler;
 class EventDistributor;
 class CommandController;
 class InfoCommand;
@@ -35,6 +36,7 @@ class MSXMotherBoard;
 class Setting;
 class CommandLineParser;
 class AfterCommand;
+class AsyncCommand;
 class ExitCommand;
 class MessageCommand;
 class MachineCommand;
@@ -45,9 +47,14 @@ class ListMachinesCommand;
 class ActivateMachineCommand;
 class StoreMachineCommand;
 class RestoreMachineCommand;
+class SaveStateSlotCommand;
+class ForkMachineCommand;
+class MachinePoolCommand;
 class GetClipboardCommand;
 class SetClipboardCommand;
 class AviRecorder;
+class FrameExporter;
+class FrameHasher;
 class ConfigInfo;
 class RealTimeInfo;
 class SoftwareInfoTopic;
@@ -75,9 +82,17 @@ public:
 	 */
 	void run(CommandLineParser& parser);
 
+	/**
+	 * Everything run() does before it enters the main loop: execute the
+	 * startup scripts and power up the machine. For when openMSX is
+	 * driven by another program, see LibOpenMSX.hh.
+	 */
+	void startUp(CommandLineParser& parser);
+
 	void enterMainLoop();
 
 	RTScheduler& getRTScheduler() { return *rtScheduler; }
+	FrameProfiler& getFrameProfiler() { return *frameProfiler; }
 	EventDistributor& getEventDistributor() { return *eventDistributor; }
 	GlobalCliComm& getGlobalCliComm() { return *globalCliComm; }
 	GlobalCommandController& getGlobalCommandController() { return *globalCommandController; }
@@ -138,6 +153,7 @@ private:
 	std::unique_ptr<GlobalCliComm> globalCliComm;
 	std::unique_ptr<GlobalCommandController> globalCommandController;
 	std::unique_ptr<GlobalSettings> globalSettings;
+	std::unique_ptr<FrameProfiler> frameProfiler;
 	std::unique_ptr<InputEventGenerator> inputEventGenerator;
 	std::unique_ptr<Display> display;
 	std::unique_ptr<Mixer> mixer;
@@ -151,6 +167,7 @@ private:
 	std::unique_ptr<RomDatabase> softwareDatabase;
 
 	std::unique_ptr<AfterCommand> afterCommand;
+	std::unique_ptr<AsyncCommand> asyncCommand;
 	std::unique_ptr<ExitCommand> exitCommand;
 	std::unique_ptr<MessageCommand> messageCommand;
 	std::unique_ptr<MachineCommand> machineCommand;
@@ -161,9 +178,14 @@ private:
 	std::unique_ptr<ActivateMachineCommand> activateMachineCommand;
 	std::unique_ptr<StoreMachineCommand> storeMachineCommand;
 	std::unique_ptr<RestoreMachineCommand> restoreMachineCommand;
+	std::unique_ptr<SaveStateSlotCommand> saveStateSlotCommand;
+	std::unique_ptr<ForkMachineCommand> forkMachineCommand;
+	std::unique_ptr<MachinePoolCommand> machinePoolCommand;
 	std::unique_ptr<GetClipboardCommand> getClipboardCommand;
 	std::unique_ptr<SetClipboardCommand> setClipboardCommand;
 	std::unique_ptr<AviRecorder> aviRecordCommand;
+	std::unique_ptr<FrameExporter> frameExporter;
+	std::unique_ptr<FrameHasher> frameHasher;
 	std::unique_ptr<ConfigInfo> extensionInfo;
 	std::unique_ptr<ConfigInfo> machineInfo;
 	std::unique_ptr<RealTimeInfo> realTimeInfo;
@@ -201,6 +223,9 @@ private:
 	friend class ActivateMachineCommand;
 	friend class StoreMachineCommand;
 	friend class RestoreMachineCommand;
+	friend class SaveStateSlotCommand;
+	friend class ForkMachineCommand;
+	friend class MachinePoolCommand;
 };
 
 } // namespace openmsx
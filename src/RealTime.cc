@@ -4,7 +4,9 @@
 #include "EventDelay.hh"
 #include "Event.hh"
 #include "FinishFrameEvent.hh"
+#include "FrameProfiler.hh"
 #include "GlobalSettings.hh"
+#include "InputEventGenerator.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
 #include "IntegerSetting.hh"
@@ -29,6 +31,7 @@ RealTime::RealTime(
 	, speedSetting   (globalSettings.getSpeedSetting())
 	, pauseSetting   (globalSettings.getPauseSetting())
 	, powerSetting   (globalSettings.getPowerSetting())
+	, syncSpinSetting(globalSettings.getSyncSpinSetting())
 	, emuTime(EmuTime::zero)
 	, enabled(true)
 {
@@ -84,22 +87,38 @@ void RealTime::sync(EmuTime::param time, bool allowSleep)
 	}
 }
 
-void RealTime::internalSync(EmuTime::param time, bool allowSleep)
+bool RealTime::internalSync(EmuTime::param time, bool allowSleep)
 {
+	bool didSleep = false;
 	if (throttleManager.isThrottled()) {
 		auto realDuration = static_cast<uint64_t>(
 		        getRealDuration(emuTime, time) * 1000000ULL);
 		idealRealTime += realDuration;
 		auto currentRealTime = Timer::getTime();
 		int64_t sleep = idealRealTime - currentRealTime;
-		if (allowSleep) {
+		if (allowSleep && (syncSpinSetting.getInt() > 0)) {
+			// Sleep till shortly before the deadline and busy-wait
+			// for the rest, that doesn't depend on the precision of
+			// sleep(), so no need to adjust for it.
+			if (sleep > 0) {
+				FrameProfiler::Section section(
+					motherBoard.getReactor().getFrameProfiler(),
+					FrameProfiler::SLEEP);
+				Timer::waitUntil(idealRealTime, syncSpinSetting.getInt());
+				didSleep = true;
+			}
+		} else if (allowSleep) {
 			// want to sleep for 'sleep' us
 			sleep += static_cast<int64_t>(sleepAdjust);
 			int64_t delta = 0;
 			if (sleep > 0) {
+				FrameProfiler::Section section(
+					motherBoard.getReactor().getFrameProfiler(),
+					FrameProfiler::SLEEP);
 				Timer::sleep(sleep); // request to sleep for 'sleep+sleepAdjust'
 				int64_t slept = Timer::getTime() - currentRealTime;
 				delta = sleep - slept; // actually slept for 'slept' us
+				didSleep = true;
 			}
 			const double ALPHA = 0.2;
 			sleepAdjust = sleepAdjust * (1 - ALPHA) + delta * ALPHA;
@@ -108,16 +127,26 @@ void RealTime::internalSync(EmuTime::param time, bool allowSleep)
 			idealRealTime = currentRealTime - MAX_LAG / 2;
 		}
 	}
+	// Host input that arrived while sleeping would otherwise only be seen
+	// in the next iteration of the main loop, possibly after the MSX has
+	// already read its input for the next frame. So poll it now, right
+	// before the emulation continues.
+	bool newInput = didSleep &&
+		motherBoard.getReactor().getInputEventGenerator().poll();
 	if (allowSleep) {
 		eventDelay.sync(time);
 	}
 
 	emuTime = time;
+	return newInput;
 }
 
 void RealTime::executeUntil(EmuTime::param time)
 {
-	internalSync(time, true);
+	if (internalSync(time, true)) {
+		// deliver the new input events before emulating further
+		motherBoard.exitCPULoopSync();
+	}
 	setSyncPoint(time + getEmuDuration(SYNC_INTERVAL));
 }
 
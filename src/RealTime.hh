@@ -67,7 +67,7 @@ private:
 	// Observer<ThrottleManager>
 	void update(const ThrottleManager& throttleManager) override;
 
-	void internalSync(EmuTime::param time, bool allowSleep);
+	bool internalSync(EmuTime::param time, bool allowSleep);
 
 	MSXMotherBoard& motherBoard;
 	EventDistributor& eventDistributor;
@@ -76,6 +76,7 @@ private:
 	IntegerSetting& speedSetting;
 	BooleanSetting& pauseSetting;
 	BooleanSetting& powerSetting;
+	IntegerSetting& syncSpinSetting;
 
 	uint64_t idealRealTime;
 	EmuTime emuTime;
@@ -0,0 +1,183 @@
+#include "ReplayJournal.hh"
+#include "MSXException.hh"
+#include "MSXMotherBoard.hh"
+#include "Reactor.hh"
+#include "StateChange.hh"
+#include "endian.hh"
+#include "serialize.hh"
+#include "serialize_meta.hh"
+#include "serialize_stl.hh"
+#include "stl.hh"
+#include <cassert>
+#include <cstring>
+
+namespace openmsx {
+
+// Replay journal file format:
+//   header:  8 bytes  magic "OMSXJRN1"
+//   followed by zero or more records:
+//            1 byte   kind (see below)
+//            8 bytes  length of the data (little endian)
+//            data     a binary archive (see BinOutputArchive) with
+//                       SNAPSHOT: "machine"
+//                       EVENTS:   "time" (end of the replay so far),
+//                                 "reRecordCount" and "events" (the
+//                                 events that were added to the log)
+static const char JOURNAL_MAGIC[8] = { 'O', 'M', 'S', 'X', 'J', 'R', 'N', '1' };
+enum RecordKind { SNAPSHOT = 1, EVENTS = 2 };
+static const size_t RECORD_HEADER_SIZE = 9;
+
+ReplayJournal::ReplayJournal(std::string filename_)
+	: filename(std::move(filename_))
+{
+	// Already create the file, so that errors are reported immediately.
+	// The header is written by the first restart().
+	file = File(filename, File::TRUNCATE);
+}
+
+ReplayJournal::~ReplayJournal()
+{
+	writer.waitIdle();
+}
+
+void ReplayJournal::restart()
+{
+	lastSnapshotTime = EmuTime::zero;
+	eventCount = 0;
+	valid = true;
+	writer.push([this] {
+		try {
+			file.truncate(0);
+			file.seek(0);
+			file.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+			file.flush();
+		} catch (MSXException& e) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			error = e.getMessage();
+		}
+	});
+}
+
+void ReplayJournal::appendSnapshot(MSXMotherBoard& board)
+{
+	assert(valid);
+	BinOutputArchive out(filename);
+	out.serialize("machine", board);
+	size_t size;
+	auto buf = out.releaseBuffer(size);
+	push(SNAPSHOT, std::move(buf), size);
+	lastSnapshotTime = board.getCurrentTime();
+}
+
+void ReplayJournal::appendEvents(const Events& events, size_t count,
+                                 EmuTime::param time, unsigned reRecordCount)
+{
+	assert(valid);
+	assert(eventCount <= count);
+	assert(count <= events.size());
+	Events newEvents(begin(events) + eventCount, begin(events) + count);
+	EmuTime endTime = time;
+	BinOutputArchive out(filename);
+	out.serialize("time", endTime,
+	              "reRecordCount", reRecordCount,
+	              "events", newEvents);
+	size_t size;
+	auto buf = out.releaseBuffer(size);
+	push(EVENTS, std::move(buf), size);
+	eventCount = count;
+}
+
+void ReplayJournal::push(unsigned kind, MemBuffer<uint8_t> buf, size_t size)
+{
+	// Jobs must be copyable, so share the (move-only) buffer.
+	auto data = std::make_shared<MemBuffer<uint8_t>>(std::move(buf));
+	writer.push([this, kind, data, size] {
+		uint8_t header[RECORD_HEADER_SIZE];
+		header[0] = kind;
+		Endian::write_UA_L64(&header[1], size);
+		try {
+			file.write(header, sizeof(header));
+			file.write(data->data(), size);
+			file.flush();
+		} catch (MSXException& e) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			error = e.getMessage();
+		}
+	});
+}
+
+void ReplayJournal::checkErrors()
+{
+	std::lock_guard<std::mutex> lock(errorMutex);
+	if (!error.empty()) {
+		std::string message = std::move(error);
+		error.clear();
+		throw MSXException("Error while writing replay journal ",
+		                   filename, ": ", message);
+	}
+}
+
+bool ReplayJournal::isJournal(const std::string& filename)
+{
+	try {
+		File file(filename);
+		char magic[sizeof(JOURNAL_MAGIC)];
+		if (file.getSize() < sizeof(magic)) return false;
+		file.read(magic, sizeof(magic));
+		return memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) == 0;
+	} catch (MSXException&) {
+		return false;
+	}
+}
+
+void ReplayJournal::load(const std::string& filename, Reactor& reactor,
+                         Boards& boards, Events& events,
+                         EmuTime& currentTime, unsigned& reRecordCount)
+{
+	reRecordCount = 0;
+	File file(filename);
+	size_t size = file.getSize();
+	MemBuffer<uint8_t> buf(size);
+	file.read(buf.data(), size);
+	if ((size < sizeof(JOURNAL_MAGIC)) ||
+	    (memcmp(buf.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)) {
+		throw MSXException("Not a replay journal: ", filename);
+	}
+
+	bool haveTime = false;
+	const uint8_t* p = buf.data() + sizeof(JOURNAL_MAGIC);
+	const uint8_t* end = buf.data() + size;
+	while (size_t(end - p) >= RECORD_HEADER_SIZE) {
+		unsigned kind = p[0];
+		size_t len = Endian::read_UA_L64(p + 1);
+		p += RECORD_HEADER_SIZE;
+		// Ignore an incomplete last record.
+		if (size_t(end - p) < len) break;
+
+		BinInputArchive in(p, len);
+		if (kind == SNAPSHOT) {
+			auto board = reactor.createEmptyMotherBoard();
+			in.serialize("machine", *board);
+			boards.push_back(std::move(board));
+		} else if (kind == EVENTS) {
+			Events newEvents;
+			in.serialize("time", currentTime,
+			             "reRecordCount", reRecordCount,
+			             "events", newEvents);
+			append(events, std::move(newEvents));
+			haveTime = true;
+		} else {
+			throw MSXException("Unknown record in replay journal: ", kind);
+		}
+		p += len;
+	}
+	if (boards.empty()) {
+		throw MSXException("Replay journal doesn't contain a snapshot: ",
+		                   filename);
+	}
+	if (!haveTime) {
+		currentTime = boards.back()->getCurrentTime();
+	}
+}
+
+} // namespace openmsx
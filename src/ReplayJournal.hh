@@ -0,0 +1,101 @@
+#ifndef REPLAYJOURNAL_HH
+#define REPLAYJOURNAL_HH
+
+#include "EmuTime.hh"
+#include "File.hh"
+#include "MemBuffer.hh"
+#include "WorkerThread.hh"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+class Reactor;
+class StateChange;
+
+/** A replay file that is written incrementally.
+  *
+  * 'reverse savereplay' writes all snapshots and the complete event log each
+  * time, so saving gets slower as the recording grows. A journal instead only
+  * appends what changed since the previous flush: the new events and, once in
+  * a while, a new snapshot. The (slow) file access happens on a background
+  * thread. Only when the history itself changes (e.g. new input after going
+  * back in time) the file has to be written again from the start.
+  *
+  * The file consists of a header followed by records, each record is a binary
+  * archive (see BinOutputArchive) of either a snapshot or a batch of events.
+  * A record that wasn't completely written (e.g. because openMSX crashed) is
+  * ignored on load.
+  */
+class ReplayJournal final
+{
+public:
+	using Events = std::vector<std::shared_ptr<StateChange>>;
+	using Boards = std::vector<std::unique_ptr<MSXMotherBoard>>;
+
+	/** Start a new journal, an existing file is overwritten. The journal
+	  * is not valid yet, first restart() it.
+	  * @throws MSXException If the file can't be created.
+	  */
+	explicit ReplayJournal(std::string filename);
+	/** Waits till all data is written. */
+	~ReplayJournal();
+
+	const std::string& getFilename() const { return filename; }
+
+	/** Throw away the content of the file, the first record that is
+	  * appended next should be the initial snapshot. */
+	void restart();
+
+	/** The file no longer matches the history, restart() it before
+	  * appending anything. */
+	void invalidate() { valid = false; }
+	bool isValid() const { return valid; }
+
+	/** Append a snapshot of the given machine. */
+	void appendSnapshot(MSXMotherBoard& board);
+	EmuTime::param getLastSnapshotTime() const { return lastSnapshotTime; }
+
+	/** Append the events [getEventCount(), count) of the given log.
+	  * @param time Current time, the replay (at least) lasts till then.
+	  */
+	void appendEvents(const Events& events, size_t count,
+	                  EmuTime::param time, unsigned reRecordCount);
+	size_t getEventCount() const { return eventCount; }
+
+	/** Report an error of an earlier (background) write.
+	  * @throws MSXException
+	  */
+	void checkErrors();
+
+	/** Does the given file (probably) contain a replay journal? */
+	static bool isJournal(const std::string& filename);
+
+	/** Read a journal. Events are appended to the given log.
+	  * @throws MSXException
+	  */
+	static void load(const std::string& filename, Reactor& reactor,
+	                 Boards& boards, Events& events,
+	                 EmuTime& currentTime, unsigned& reRecordCount);
+
+private:
+	void push(unsigned kind, MemBuffer<uint8_t> buf, size_t size);
+
+	const std::string filename;
+	EmuTime lastSnapshotTime = EmuTime::zero;
+	size_t eventCount = 0;
+	bool valid = false;
+
+	WorkerThread writer;
+	File file; // only accessed by the writer thread
+
+	std::mutex errorMutex;
+	std::string error; // protected by 'errorMutex'
+};
+
+} // namespace openmsx
+
+#endif
@@ -4,25 +4,37 @@
 #include "StateChangeDistributor.hh"
 #include "Keyboard.hh"
 #include "Debugger.hh"
+#include "Debuggable.hh"
 #include "EventDelay.hh"
 #include "MSXMixer.hh"
 #include "MSXCommandController.hh"
 #include "XMLException.hh"
+#include "File.hh"
+#include "FileException.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
 #include "FileOperations.hh"
 #include "FileContext.hh"
+#include "Instrumentation.hh"
 #include "StateChange.hh"
 #include "Timer.hh"
 #include "CliComm.hh"
 #include "Display.hh"
 #include "Reactor.hh"
+#include "ReplayJournal.hh"
+#include "Netplay.hh"
+#include "GlobalSettings.hh"
 #include "CommandException.hh"
 #include "MemBuffer.hh"
+#include "ScopedAssign.hh"
+#include "hash_set.hh"
 #include "ranges.hh"
 #include "serialize.hh"
 #include "serialize_meta.hh"
 #include "view.hh"
+#include "xrange.hh"
+#include "xxhash.hh"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iomanip>
@@ -37,6 +49,14 @@ namespace openmsx {
 // Time between two snapshots (in seconds)
 static const double SNAPSHOT_PERIOD = 1.0;
 
+// In between the snapshots, (short lived) key frames are taken. These make
+// going back a few frames (e.g. frame-stepping backwards) fast, because less
+// time has to be emulated again.
+static const unsigned KEYFRAMES_PER_SNAPSHOT = 5; // so every 0.2s (10 frames)
+static const double KEYFRAME_PERIOD = SNAPSHOT_PERIOD / KEYFRAMES_PER_SNAPSHOT;
+// Only the most recent key frames are kept
+static const unsigned MAX_KEYFRAMES = 25; // last 5s
+
 // Max number of snapshots in a replay file
 static const unsigned MAX_NOF_SNAPSHOTS = 10;
 
@@ -46,6 +66,9 @@ static const EmuDuration MIN_PARTITION_LENGTH = EmuDuration(60.0);
 // Max distance of one before last snapshot before the end time in replay file (in seconds)
 static const EmuDuration MAX_DIST_1_BEFORE_LAST_SNAPSHOT = EmuDuration(30.0);
 
+// Min distance between snapshots in a replay journal (in seconds)
+static const EmuDuration JOURNAL_SNAPSHOT_PERIOD = EmuDuration(60.0);
+
 static const char* const REPLAY_DIR = "replays";
 
 // A replay is a struct that contains a vector of motherboards and an MSX event
@@ -100,19 +123,152 @@ struct Replay
 SERIALIZE_CLASS_VERSION(Replay, 4);
 
 
+// class ReverseSpillFile
+
+// Temporary file that holds (old) snapshots that don't fit in the reverse
+// memory budget. Data is only appended, space of dropped snapshots is not
+// reused. The file is removed when this object gets destroyed.
+class ReverseSpillFile
+{
+public:
+	ReverseSpillFile()
+	{
+		string dir = strCat(FileOperations::getTempDir(),
+		                    FileOperations::nativePathSeparator, "openmsx");
+		FileOperations::mkdirp(dir);
+		{
+			auto fp = FileOperations::openUniqueFile(dir, filename);
+			if (!fp) {
+				throw FileException("Couldn't create reverse spill file");
+			}
+		}
+		file = File(filename, File::TRUNCATE);
+	}
+
+	~ReverseSpillFile()
+	{
+		file.close();
+		FileOperations::unlink(filename);
+	}
+
+	size_t append(const void* data, size_t size)
+	{
+		size_t offset = end;
+		file.seek(offset);
+		file.write(data, size);
+		end += size;
+		return offset;
+	}
+
+	void read(size_t offset, void* data, size_t size)
+	{
+		file.seek(offset);
+		file.read(data, size);
+	}
+
+private:
+	string filename;
+	File file;
+	size_t end = 0;
+};
+
+
 // struct ReverseHistory
 
+ReverseManager::ReverseHistory::ReverseHistory() = default;
+ReverseManager::ReverseHistory::~ReverseHistory() = default;
+
 void ReverseManager::ReverseHistory::swap(ReverseHistory& other)
 {
 	std::swap(chunks, other.chunks);
+	std::swap(keyFrames, other.keyFrames);
 	std::swap(events, other.events);
+	std::swap(spillFile, other.spillFile);
 }
 
 void ReverseManager::ReverseHistory::clear()
 {
 	// clear() and free storage capacity
 	Chunks().swap(chunks);
+	KeyFrames().swap(keyFrames);
 	Events().swap(events);
+	spillFile.reset();
+}
+
+size_t ReverseManager::ReverseHistory::getMemoryUsage() const
+{
+	// (null-)diffs can be shared between snapshots, only count them once
+	hash_set<const DeltaBlock*> seen;
+	size_t result = 0;
+	auto count = [&](const ReverseChunk& chunk) {
+		if (chunk.spilled) return;
+		result += chunk.size;
+		for (auto& block : chunk.deltaBlocks) {
+			if (seen.insert(block.get()).second) {
+				result += block->getAllocSize();
+			}
+		}
+	};
+	for (auto& p : chunks) count(p.second);
+	for (auto& k : keyFrames) count(k);
+	return result;
+}
+
+void ReverseManager::ReverseHistory::spill(ReverseChunk& chunk)
+{
+	if (chunk.spilled) return;
+	INSTRUMENT_ZONE("ReverseHistory::spill");
+
+	if (chunk.spillOffset == ReverseChunk::NOT_SPILLED) {
+		// Not yet on disk. Blocks are stored in their full
+		// (uncompressed) form, so that they don't depend on
+		// reference blocks anymore.
+		if (!spillFile) {
+			spillFile = std::make_unique<ReverseSpillFile>();
+		}
+		size_t offset = spillFile->append(chunk.savestate.data(), chunk.size);
+		MemBuffer<uint8_t> buf;
+		chunk.blockSizes.clear();
+		for (auto& block : chunk.deltaBlocks) {
+			size_t size = block->getBlockSize();
+			buf.resize(size);
+			block->apply(buf.data(), size);
+			spillFile->append(buf.data(), size);
+			chunk.blockSizes.push_back(size);
+		}
+		chunk.spillOffset = offset;
+	}
+
+	// release memory
+	chunk.savestate = MemBuffer<uint8_t>();
+	vector<shared_ptr<DeltaBlock>>().swap(chunk.deltaBlocks);
+	chunk.spilled = true;
+}
+
+void ReverseManager::ReverseHistory::unspill(ReverseChunk& chunk)
+{
+	if (!chunk.spilled) return;
+	INSTRUMENT_ZONE("ReverseHistory::unspill");
+	assert(spillFile);
+	assert(chunk.spillOffset != ReverseChunk::NOT_SPILLED);
+
+	size_t offset = chunk.spillOffset;
+	MemBuffer<uint8_t> savestate(chunk.size);
+	spillFile->read(offset, savestate.data(), chunk.size);
+	offset += chunk.size;
+
+	vector<shared_ptr<DeltaBlock>> blocks;
+	MemBuffer<uint8_t> buf;
+	for (auto size : chunk.blockSizes) {
+		buf.resize(size);
+		spillFile->read(offset, buf.data(), size);
+		offset += size;
+		blocks.push_back(std::make_shared<DeltaBlockCopy>(buf.data(), size));
+	}
+
+	chunk.savestate = std::move(savestate);
+	chunk.deltaBlocks = std::move(blocks);
+	chunk.spilled = false; // but it's still on disk
 }
 
 
@@ -137,9 +293,15 @@ REGISTER_POLYMORPHIC_CLASS(StateChange, EndLogEvent, "EndLog");
 ReverseManager::ReverseManager(MSXMotherBoard& motherBoard_)
 	: syncNewSnapshot(motherBoard_.getScheduler())
 	, syncInputEvent (motherBoard_.getScheduler())
+	, syncRemoteEvent(motherBoard_.getScheduler())
 	, motherBoard(motherBoard_)
 	, eventDistributor(motherBoard.getReactor().getEventDistributor())
 	, reverseCmd(motherBoard.getCommandController())
+	, memoryBudgetSetting(motherBoard.getCommandController(),
+		"reverse_memory_budget",
+		"Maximum amount of memory (in MB) used for reverse snapshots. "
+		"Older snapshots are moved to a temporary file on disk. "
+		"0 means unlimited.", 0, 0, 1000000)
 	, keyboard(nullptr)
 	, eventDelay(nullptr)
 	, replayIndex(0)
@@ -170,6 +332,7 @@ void ReverseManager::start()
 		// create first snapshot
 		collecting = true;
 		takeSnapshot(getCurrentTime());
+		keyFrameCount = 0;
 		// schedule creation of next snapshot
 		schedule(getCurrentTime());
 		// start recording events
@@ -184,10 +347,15 @@ void ReverseManager::stop()
 		motherBoard.getStateChangeDistributor().unregisterRecorder(*this);
 		syncNewSnapshot.removeSyncPoint(); // don't schedule new snapshot takings
 		syncInputEvent .removeSyncPoint(); // stop any pending replay actions
+		syncRemoteEvent.removeSyncPoint();
 		history.clear();
+		journal.reset();
+		netplay.reset();
+		remoteEvents.clear();
 		replayIndex = 0;
 		collecting = false;
 		pendingTakeSnapshot = false;
+		sendStatusUpdate();
 	}
 	assert(!pendingTakeSnapshot);
 	assert(!isCollecting());
@@ -238,6 +406,26 @@ void ReverseManager::status(TclObject& result) const
 	result.addDictKeyValue("last_event", (le - EmuTime::zero).toDouble());
 }
 
+void ReverseManager::sendStatusUpdate()
+{
+	// Only the fields that don't change continuously, this is sent (at
+	// most) once per snapshot, when replaying starts or stops and when
+	// collecting stops. So an external application doesn't need to poll
+	// 'reverse status'.
+	TclObject value;
+	value.addDictKeyValue("status", !isCollecting() ? "disabled"
+	                              : isReplaying()   ? "replaying"
+	                                                : "enabled");
+	if (isCollecting()) {
+		EmuTime b = begin(history.chunks)->second.time;
+		value.addDictKeyValue("begin", (b - EmuTime::zero).toDouble());
+		EmuTime e = getEndTime(history);
+		value.addDictKeyValue("end", (e - EmuTime::zero).toDouble());
+	}
+	motherBoard.getMSXCliComm().update(
+		CliComm::REVERSE, "status", value.getString());
+}
+
 void ReverseManager::debugInfo(TclObject& result) const
 {
 	// TODO this is useful during development, but for the end user this
@@ -250,13 +438,20 @@ void ReverseManager::debugInfo(TclObject& result) const
 		          (chunk.time - EmuTime::zero).toDouble(), ' ',
 		          ((chunk.time - EmuTime::zero).toDouble() / (getCurrentTime() - EmuTime::zero).toDouble()) * 100, "%"
 		          " (", chunk.size, ")"
-		          " (next event index: ", chunk.eventCount, ")\n");
+		          " (next event index: ", chunk.eventCount, ")",
+		          (chunk.spilled ? " (on disk)\n" : "\n"));
 		totalSize += chunk.size;
 	}
-	strAppend(res, "total size: ", totalSize, '\n');
+	strAppend(res, "total size: ", totalSize, '\n',
+	          "memory usage: ", history.getMemoryUsage(), '\n');
 	result = res;
 }
 
+void ReverseManager::statsInfo(TclObject& result) const
+{
+	result = snapshotStats.format();
+}
+
 static void parseGoTo(Interpreter& interp, span<const TclObject> tokens,
                       bool& novideo, double& time)
 {
@@ -371,7 +566,14 @@ void ReverseManager::goTo(
 		// one that's not newer (thus older or equal).
 		assert(it != begin(hist.chunks));
 		--it;
-		ReverseChunk& chunk = it->second;
+		// a more recent key frame is cheaper to start from
+		ReverseChunk* best = &it->second;
+		for (auto& k : hist.keyFrames) {
+			if ((k.time <= preTarget) && (k.time > best->time)) {
+				best = &k;
+			}
+		}
+		ReverseChunk& chunk = *best;
 		EmuTime snapshotTime = chunk.time;
 		assert(snapshotTime <= preTarget);
 
@@ -397,10 +599,14 @@ void ReverseManager::goTo(
 			// -- restore old snapshot --
 			newBoard_ = reactor.createEmptyMotherBoard();
 			newBoard = newBoard_.get();
-			MemInputArchive in(chunk.savestate.data(),
-					   chunk.size,
-					   chunk.deltaBlocks);
-			in.serialize("machine", *newBoard);
+			hist.unspill(chunk);
+			{
+				INSTRUMENT_ZONE("ReverseManager::restoreSnapshot");
+				MemInputArchive in(chunk.savestate.data(),
+						   chunk.size,
+						   chunk.deltaBlocks);
+				in.serialize("machine", *newBoard);
+			}
 
 			if (eventDelay) {
 				// Handle all events that are scheduled, but not yet
@@ -424,6 +630,9 @@ void ReverseManager::goTo(
 
 			// transfer (or copy) state from old to new machine
 			transferState(*newBoard);
+			if (!sameTimeLine && newManager.journal) {
+				newManager.journal->invalidate();
+			}
 
 			// In case of load-replay it's possible we are not collecting,
 			// but calling stop() anyway is ok.
@@ -522,6 +731,17 @@ void ReverseManager::transferState(MSXMotherBoard& newBoard)
 	// copy rerecord count
 	newManager.reRecordCount = reRecordCount;
 
+	// the journal follows the history
+	newManager.journal = std::move(journal);
+
+	// and so does the netplay session
+	newManager.netplay = std::move(netplay);
+	if (newManager.netplay) newManager.netplay->setManager(newManager);
+	newManager.remoteEvents = std::move(remoteEvents);
+	remoteEvents.clear();
+	syncRemoteEvent.removeSyncPoint();
+	newManager.scheduleRemoteEvent();
+
 	// transfer settings
 	const auto& oldController = motherBoard.getMSXCommandController();
 	newBoard.getMSXCommandController().transferSettings(oldController);
@@ -530,14 +750,18 @@ void ReverseManager::transferState(MSXMotherBoard& newBoard)
 void ReverseManager::saveReplay(
 	Interpreter& interp, span<const TclObject> tokens, TclObject& result)
 {
-	const auto& chunks = history.chunks;
+	auto& chunks = history.chunks;
 	if (chunks.empty()) {
 		throw CommandException("No recording...");
 	}
 
 	string_view filenameArg;
 	int maxNofExtraSnapshots = MAX_NOF_SNAPSHOTS;
-	ArgsInfo info[] = { valueArg("-maxnofextrasnapshots", maxNofExtraSnapshots) };
+	bool binary = false;
+	ArgsInfo info[] = {
+		valueArg("-maxnofextrasnapshots", maxNofExtraSnapshots),
+		flagArg("-binary", binary),
+	};
 	auto args = parseTclArgs(interp, tokens.subspan(2), info);
 	switch (args.size()) {
 		case 0: break; // nothing
@@ -561,6 +785,7 @@ void ReverseManager::saveReplay(
 
 	// restore first snapshot to be able to serialize it to a file
 	auto initialBoard = reactor.createEmptyMotherBoard();
+	history.unspill(begin(chunks)->second);
 	MemInputArchive in(begin(chunks)->second.savestate.data(),
 	                   begin(chunks)->second.size,
 			   begin(chunks)->second.deltaBlocks);
@@ -590,6 +815,7 @@ void ReverseManager::saveReplay(
 				if (it != lastAddedIt) {
 					// this is a new one, add it to the list of snapshots
 					Reactor::Board board = reactor.createEmptyMotherBoard();
+					history.unspill(it->second);
 					MemInputArchive in2(it->second.savestate.data(),
 							    it->second.size,
 							    it->second.deltaBlocks);
@@ -615,10 +841,17 @@ void ReverseManager::saveReplay(
 			getCurrentTime()));
 	}
 	try {
-		XmlOutputArchive out(filename);
 		replay.events = &history.events;
-		out.serialize("replay", replay);
-		out.close();
+		if (binary) {
+			BinOutputArchive out(filename);
+			out.serialize("replay", replay);
+			out.close();
+		} else {
+			XmlOutputArchive out(filename, motherBoard.getReactor()
+				.getGlobalSettings().getStateCompressionSetting().getInt());
+			out.serialize("replay", replay);
+			out.close();
+		}
 	} catch (MSXException&) {
 		if (addSentinel) {
 			history.events.pop_back();
@@ -637,51 +870,77 @@ void ReverseManager::saveReplay(
 	result = "Saved replay to " + filename;
 }
 
-void ReverseManager::loadReplay(
-	Interpreter& interp, span<const TclObject> tokens, TclObject& result)
+static string resolveReplayFile(const string& fileNameArg)
 {
-	bool enableViewOnly = false;
-	optional<TclObject> where;
-	ArgsInfo info[] = {
-		flagArg("-viewonly", enableViewOnly),
-		valueArg("-goto", where),
-	};
-	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
-	if (arguments.size() != 1) throw SyntaxError();
-
-	// resolve the filename
 	auto context = userDataFileContext(REPLAY_DIR);
-	string fileNameArg = arguments[0].getString().str();
-	string filename;
 	try {
 		// Try filename as typed by user.
-		filename = context.resolve(fileNameArg);
+		return context.resolve(fileNameArg);
 	} catch (MSXException& /*e1*/) { try {
 		// Not found, try adding '.omr'.
-		filename = context.resolve(fileNameArg + ".omr");
+		return context.resolve(fileNameArg + ".omr");
 	} catch (MSXException& e2) { try {
 		// Again not found, try adding '.gz'.
 		// (this is for backwards compatibility).
-		filename = context.resolve(fileNameArg + ".gz");
+		return context.resolve(fileNameArg + ".gz");
 	} catch (MSXException& /*e3*/) {
 		// Show error message that includes the default extension.
 		throw e2;
 	}}}
+}
 
-	// restore replay
-	auto& reactor = motherBoard.getReactor();
-	Replay replay(reactor);
-	Events events;
-	replay.events = &events;
+// Read a replay file (or a journal) into 'replay', 'replay.events' must
+// already point to an (empty) event list.
+static void readReplay(const string& filename, Replay& replay)
+{
+	auto& events = *replay.events;
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("replay", replay);
+		if (ReplayJournal::isJournal(filename)) {
+			ReplayJournal::load(filename, replay.reactor,
+			                    replay.motherBoards, events,
+			                    replay.currentTime,
+			                    replay.reRecordCount);
+			// a journal doesn't contain the terminating EndLogEvent
+			EmuTime endTime = replay.currentTime;
+			if (!events.empty()) {
+				endTime = std::max(endTime, events.back()->getTime());
+			}
+			events.push_back(std::make_shared<EndLogEvent>(endTime));
+		} else if (BinInputArchive::isBinArchive(filename)) {
+			BinInputArchive in(filename);
+			in.serialize("replay", replay);
+		} else {
+			XmlInputArchive in(filename);
+			in.serialize("replay", replay);
+		}
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load replay, bad file format: ",
 		                       e.getMessage());
 	} catch (MSXException& e) {
 		throw CommandException("Cannot load replay: ", e.getMessage());
 	}
+}
+
+void ReverseManager::loadReplay(
+	Interpreter& interp, span<const TclObject> tokens, TclObject& result)
+{
+	bool enableViewOnly = false;
+	optional<TclObject> where;
+	ArgsInfo info[] = {
+		flagArg("-viewonly", enableViewOnly),
+		valueArg("-goto", where),
+	};
+	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
+	if (arguments.size() != 1) throw SyntaxError();
+
+	string filename = resolveReplayFile(arguments[0].getString().str());
+
+	// restore replay
+	auto& reactor = motherBoard.getReactor();
+	Replay replay(reactor);
+	Events events;
+	replay.events = &events;
+	readReplay(filename, replay);
 
 	// get destination time index
 	auto destination = EmuTime::zero;
@@ -748,6 +1007,211 @@ void ReverseManager::loadReplay(
 	result = "Loaded replay from " + filename;
 }
 
+// The content of all debuggables (RAM, VRAM, CPU and chip registers, ...) of
+// a machine, one hash per debuggable, sorted on name.
+static vector<std::pair<string, uint32_t>> hashDebuggables(MSXMotherBoard& board)
+{
+	vector<std::pair<string, uint32_t>> result;
+	MemBuffer<byte> buf;
+	for (auto& p : board.getDebugger().getDebuggables()) {
+		auto& debuggable = *p.second;
+		unsigned size = debuggable.getSize();
+		buf.resize(size);
+		debuggable.readBlock(0, buf.data(), size);
+		result.emplace_back(p.first, xxhash(string_view(
+			reinterpret_cast<const char*>(buf.data()), size)));
+	}
+	ranges::sort(result);
+	return result;
+}
+
+void ReverseManager::verifyReplay(span<const TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() != 3) throw SyntaxError();
+	string filename = resolveReplayFile(tokens[2].getString().str());
+
+	auto& reactor = motherBoard.getReactor();
+	Replay replay(reactor);
+	Events events;
+	replay.events = &events;
+	readReplay(filename, replay);
+	auto& boards = replay.motherBoards;
+	assert(!boards.empty());
+
+	// The stored snapshots are never emulated, only compared.
+	vector<vector<std::pair<string, uint32_t>>> expected;
+	for (auto i : xrange(size_t(1), boards.size())) {
+		expected.push_back(hashDebuggables(*boards[i]));
+	}
+
+	// Replay the events on the first snapshot, like 'loadreplay' does, but
+	// without taking new snapshots. This machine doesn't become active, so
+	// it has no video output, and it's muted.
+	auto& board = *boards[0];
+	auto& manager = board.getReverseManager();
+	ReverseHistory hist;
+	ReverseChunk chunk;
+	chunk.time = board.getCurrentTime();
+	{
+		MemOutputArchive out(hist.lastDeltaBlocks, chunk.deltaBlocks, false);
+		out.serialize("machine", board);
+		chunk.savestate = out.releaseBuffer(chunk.size);
+	}
+	unsigned eventCount = 0;
+	while ((eventCount < events.size()) &&
+	       (events[eventCount]->getTime() < chunk.time)) {
+		++eventCount;
+	}
+	chunk.eventCount = eventCount;
+	hist.chunks[0] = move(chunk);
+	swap(hist.events, events);
+	manager.transferHistory(hist, eventCount);
+	manager.syncNewSnapshot.removeSyncPoint();
+	board.getMSXMixer().mute();
+
+	// Stop at each stored snapshot (fastForward() stops at the same
+	// instruction boundary as where the snapshot was taken) and compare.
+	unsigned verified = 0;
+	vector<string> differences;
+	EmuTime time = board.getCurrentTime();
+	for (auto i : xrange(size_t(1), boards.size())) {
+		time = boards[i]->getCurrentTime();
+		board.fastForward(time, true);
+		if (board.getCurrentTime() != time) {
+			differences.push_back("time");
+			break;
+		}
+		// both are sorted on name
+		auto actual = hashDebuggables(board);
+		auto& exp = expected[i - 1];
+		auto a = begin(exp);
+		auto b = begin(actual);
+		while ((a != end(exp)) || (b != end(actual))) {
+			if ((b == end(actual)) ||
+			    ((a != end(exp)) && (a->first < b->first))) {
+				differences.push_back(a->first); // only in snapshot
+				++a;
+			} else if ((a == end(exp)) || (b->first < a->first)) {
+				differences.push_back(b->first); // only in replay
+				++b;
+			} else {
+				if (a->second != b->second) {
+					differences.push_back(a->first);
+				}
+				++a; ++b;
+			}
+		}
+		if (!differences.empty()) break;
+		++verified;
+	}
+	board.getMSXMixer().unmute();
+
+	result.addDictKeyValue("status", differences.empty() ? "ok" : "diverged");
+	result.addDictKeyValue("snapshots", int(verified));
+	result.addDictKeyValue("time", (time - EmuTime::zero).toDouble());
+	if (!differences.empty()) {
+		TclObject diffs;
+		diffs.addListElements(differences);
+		result.addDictKeyValue("differences", diffs);
+	}
+}
+
+void ReverseManager::journalCmd(span<const TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() == 2) {
+		if (journal) result = journal->getFilename();
+		return;
+	}
+	string_view subCmd = tokens[2].getString();
+	if (subCmd == "start") {
+		if (history.chunks.empty()) {
+			throw CommandException("No recording...");
+		}
+		string_view filenameArg;
+		switch (tokens.size()) {
+			case 3: break; // nothing
+			case 4: filenameArg = tokens[3].getString(); break;
+			default: throw SyntaxError();
+		}
+		string filename = FileOperations::parseCommandFileArgument(
+			filenameArg, REPLAY_DIR, "openmsx", ".omr");
+		journal.reset(); // finish the previous one (if any)
+		try {
+			journal = std::make_unique<ReplayJournal>(filename);
+			flushJournal();
+		} catch (MSXException& e) {
+			journal.reset();
+			throw CommandException("Cannot start replay journal: ",
+			                       e.getMessage());
+		}
+		result = filename;
+	} else if (subCmd == "flush") {
+		if (!journal) {
+			throw CommandException("No replay journal active.");
+		}
+		try {
+			flushJournal();
+		} catch (MSXException& e) {
+			throw CommandException(e.getMessage());
+		}
+	} else if (subCmd == "stop") {
+		try {
+			stopJournal();
+		} catch (MSXException& e) {
+			throw CommandException(e.getMessage());
+		}
+	} else {
+		throw SyntaxError();
+	}
+}
+
+void ReverseManager::flushJournal()
+{
+	assert(journal);
+	journal->checkErrors();
+	if (!journal->isValid()) {
+		restartJournal();
+	}
+	// The log can be terminated by an EndLogEvent (while we're replaying),
+	// that one is only added when the journal is loaded.
+	auto& events = history.events;
+	size_t count = events.size();
+	if ((count != 0) && dynamic_cast<const EndLogEvent*>(events.back().get())) {
+		--count;
+	}
+	assert(journal->getEventCount() <= count);
+	if (!isReplaying() &&
+	    (getCurrentTime() >= journal->getLastSnapshotTime() + JOURNAL_SNAPSHOT_PERIOD)) {
+		journal->appendSnapshot(motherBoard);
+	}
+	journal->appendEvents(events, count, getEndTime(history), reRecordCount);
+}
+
+void ReverseManager::restartJournal()
+{
+	// start again with the oldest snapshot and all events
+	journal->restart();
+	auto& chunk = begin(history.chunks)->second;
+	auto board = motherBoard.getReactor().createEmptyMotherBoard();
+	history.unspill(chunk);
+	MemInputArchive in(chunk.savestate.data(), chunk.size,
+	                   chunk.deltaBlocks);
+	in.serialize("machine", *board);
+	journal->appendSnapshot(*board);
+}
+
+void ReverseManager::stopJournal()
+{
+	if (!journal) return;
+	try {
+		flushJournal();
+	} catch (MSXException&) {
+		journal.reset();
+		throw;
+	}
+	journal.reset(); // waits till everything is written
+}
+
 void ReverseManager::transferHistory(ReverseHistory& oldHistory,
                                      unsigned oldEventCount)
 {
@@ -770,6 +1234,7 @@ void ReverseManager::transferHistory(ReverseHistory& oldHistory,
 	// replay log contains at least the EndLogEvent
 	assert(replayIndex < history.events.size());
 	replayNextEvent();
+	sendStatusUpdate();
 }
 
 void ReverseManager::execNewSnapshot()
@@ -832,8 +1297,13 @@ int ReverseManager::signalEvent(const shared_ptr<const Event>& event)
 	// machine that requested the snapshot.
 	if (pendingTakeSnapshot) {
 		pendingTakeSnapshot = false;
-		takeSnapshot(getCurrentTime());
-		// schedule creation of next snapshot
+		if (++keyFrameCount == KEYFRAMES_PER_SNAPSHOT) {
+			keyFrameCount = 0;
+			takeSnapshot(getCurrentTime());
+		} else {
+			takeKeyFrame(getCurrentTime());
+		}
+		// schedule creation of next snapshot (or key frame)
 		schedule(getCurrentTime());
 	}
 	return 0;
@@ -863,13 +1333,69 @@ void ReverseManager::takeSnapshot(EmuTime::param time)
 	// the same moment in time).
 
 	// actually create new snapshot
+	INSTRUMENT_ZONE("ReverseManager::takeSnapshot");
 	ReverseChunk& newChunk = history.chunks[seqNum];
 	newChunk.deltaBlocks.clear();
 	MemOutputArchive out(history.lastDeltaBlocks, newChunk.deltaBlocks, true);
+	snapshotStats.clear();
+	out.setStats(&snapshotStats);
+	out.serialize("machine", motherBoard);
+	newChunk.time = time;
+	newChunk.savestate = out.releaseBuffer(newChunk.size);
+	newChunk.eventCount = replayIndex;
+	newChunk.spillOffset = ReverseChunk::NOT_SPILLED;
+	newChunk.blockSizes.clear();
+	newChunk.spilled = false;
+
+	limitMemoryUsage();
+	sendStatusUpdate();
+}
+
+void ReverseManager::takeKeyFrame(EmuTime::param time)
+{
+	// While replaying (after going back in time) later key frames can
+	// still exist, they're taken again.
+	auto& keyFrames = history.keyFrames;
+	while (!keyFrames.empty() && (keyFrames.back().time >= time)) {
+		keyFrames.pop_back();
+	}
+
+	INSTRUMENT_ZONE("ReverseManager::takeKeyFrame");
+	keyFrames.emplace_back();
+	ReverseChunk& newChunk = keyFrames.back();
+	MemOutputArchive out(history.lastDeltaBlocks, newChunk.deltaBlocks, true);
 	out.serialize("machine", motherBoard);
 	newChunk.time = time;
 	newChunk.savestate = out.releaseBuffer(newChunk.size);
 	newChunk.eventCount = replayIndex;
+
+	if (keyFrames.size() > MAX_KEYFRAMES) {
+		keyFrames.pop_front();
+	}
+}
+
+void ReverseManager::limitMemoryUsage()
+{
+	size_t budget = size_t(memoryBudgetSetting.getInt()) * 1024 * 1024;
+	if (budget == 0) return; // unlimited
+
+	// Move the oldest snapshots to disk until we're within budget. The
+	// most recent snapshot always stays in memory. Note that the budget
+	// is only approximate: diffs keep their reference block alive.
+	try {
+		size_t usage = history.getMemoryUsage();
+		auto last = std::prev(end(history.chunks));
+		for (auto it = begin(history.chunks);
+		     (it != last) && (usage > budget); ++it) {
+			if (it->second.spilled) continue;
+			history.spill(it->second);
+			usage = history.getMemoryUsage();
+		}
+	} catch (MSXException& e) {
+		motherBoard.getMSXCliComm().printWarning(
+			"Couldn't move reverse snapshots to disk: ",
+			e.getMessage());
+	}
 }
 
 void ReverseManager::replayNextEvent()
@@ -894,6 +1420,142 @@ void ReverseManager::signalStateChange(const shared_ptr<StateChange>& event)
 		history.events.push_back(event);
 		++replayIndex;
 		assert(!isReplaying());
+		if (netplay && !deliveringRemote) {
+			netplay->sendEvent(event);
+		}
+	}
+}
+
+void ReverseManager::insertRemoteEvents(const Events& events)
+{
+	assert(isCollecting());
+	EmuTime now = getCurrentTime();
+	auto byTime = [](const shared_ptr<StateChange>& a,
+	                 const shared_ptr<StateChange>& b) {
+		return a->getTime() < b->getTime();
+	};
+	bool rollback = false;
+	EmuTime oldest = EmuTime::infinity;
+	for (auto& event : events) {
+		if (dynamic_cast<const EndLogEvent*>(event.get())) continue;
+		EmuTime time = event->getTime();
+		if (time >= now) {
+			remoteEvents.insert(ranges::upper_bound(remoteEvents, event, byTime),
+			                    event);
+			continue;
+		}
+		if (time < begin(history.chunks)->second.time) {
+			motherBoard.getMSXCliComm().printWarning(
+				"Netplay: input of the peer is older than the "
+				"reverse history, the session is out of sync.");
+			continue;
+		}
+		if (isReplaying()) {
+			// the history is rewritten anyway
+			signalStopReplay(now);
+		}
+		auto& evs = history.events;
+		auto it = ranges::upper_bound(evs, event, byTime);
+		if (journal &&
+		    (size_t(it - begin(evs)) < journal->getEventCount())) {
+			journal->invalidate();
+		}
+		evs.insert(it, event);
+		++replayIndex; // still at the end of the log
+		oldest = std::min(oldest, time);
+		rollback = true;
+	}
+	scheduleRemoteEvent();
+	if (!rollback) return;
+
+	// The snapshots after the oldest new event are no longer correct.
+	auto it = ranges::find_if(history.chunks, [&](auto& p) {
+		return p.second.time > oldest;
+	});
+	history.chunks.erase(it, end(history.chunks));
+	auto& keyFrames = history.keyFrames;
+	while (!keyFrames.empty() && (keyFrames.back().time > oldest)) {
+		keyFrames.pop_back();
+	}
+	if (netplay) netplay->countRollback();
+
+	// Re-emulate from before the oldest event up to now. Note: this
+	// deletes the current MSXMotherBoard and ReverseManager.
+	goTo(now, false, history, true);
+}
+
+void ReverseManager::execRemoteEvent()
+{
+	auto event = remoteEvents.front();
+	remoteEvents.erase(begin(remoteEvents));
+	{
+		// record it, but don't send it back to the peer
+		ScopedAssign<bool> sa(deliveringRemote, true);
+		try {
+			motherBoard.getStateChangeDistributor().distributeNew(event);
+		} catch (MSXException&) {
+			// can throw for a recorded command that fails, ignore
+		}
+	}
+	scheduleRemoteEvent();
+}
+
+void ReverseManager::scheduleRemoteEvent()
+{
+	syncRemoteEvent.removeSyncPoint();
+	if (!remoteEvents.empty()) {
+		syncRemoteEvent.setSyncPoint(remoteEvents.front()->getTime());
+	}
+}
+
+void ReverseManager::netplayCmd(span<const TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() == 2) {
+		if (netplay) netplay->status(result);
+		return;
+	}
+	string_view subCmd = tokens[2].getString();
+	if (subCmd == "start") {
+		if (tokens.size() != 6) throw SyntaxError();
+		if (netplay) {
+			throw CommandException("Already in a netplay session.");
+		}
+		auto& interp = motherBoard.getReactor().getInterpreter();
+		int localPort = tokens[3].getInt(interp);
+		string host = tokens[4].getString().str();
+		int remotePort = tokens[5].getInt(interp);
+		if ((localPort <= 0) || (localPort > 65535) ||
+		    (remotePort <= 0) || (remotePort > 65535)) {
+			throw CommandException("Invalid port number.");
+		}
+		// A rollback needs the history (and it must be the current
+		// time-line).
+		start();
+		if (isReplaying()) {
+			signalStopReplay(getCurrentTime());
+		}
+		// Lets the peer check that it starts from the same state.
+		BinOutputArchive out("netplay");
+		out.serialize("machine", motherBoard);
+		size_t size;
+		auto buf = out.releaseBuffer(size);
+		uint32_t hash = xxhash(string_view(
+			reinterpret_cast<const char*>(buf.data()), size));
+		try {
+			netplay = std::make_unique<Netplay>(
+				motherBoard.getReactor(), *this, localPort, host,
+				remotePort, getCurrentTime(), hash);
+		} catch (MSXException& e) {
+			throw CommandException("Cannot start netplay: ",
+			                       e.getMessage());
+		}
+	} else if (subCmd == "stop") {
+		if (tokens.size() != 3) throw SyntaxError();
+		netplay.reset();
+		remoteEvents.clear();
+		syncRemoteEvent.removeSyncPoint();
+	} else {
+		throw SyntaxError();
 	}
 }
 
@@ -911,14 +1573,23 @@ void ReverseManager::stopReplay(EmuTime::param time)
 		// if we're replaying, stop it and erase remainder of event log
 		syncInputEvent.removeSyncPoint();
 		Events& events = history.events;
+		if (journal && (replayIndex < journal->getEventCount())) {
+			// the journal contains events that are now removed
+			journal->invalidate();
+		}
 		events.erase(begin(events) + replayIndex, end(events));
 		// search snapshots that are newer than 'time' and erase them
 		auto it = ranges::find_if(history.chunks, [&](auto& p) {
 			return p.second.time > time;
 		});
 		history.chunks.erase(it, end(history.chunks));
+		auto& keyFrames = history.keyFrames;
+		while (!keyFrames.empty() && (keyFrames.back().time > time)) {
+			keyFrames.pop_back();
+		}
 		// this also means someone is changing history, record that
 		reRecordCount++;
+		sendStatusUpdate();
 	}
 	assert(!isReplaying());
 }
@@ -952,7 +1623,7 @@ void ReverseManager::dropOldSnapshots(unsigned count)
 
 void ReverseManager::schedule(EmuTime::param time)
 {
-	syncNewSnapshot.setSyncPoint(time + EmuDuration(SNAPSHOT_PERIOD));
+	syncNewSnapshot.setSyncPoint(time + EmuDuration(KEYFRAME_PERIOD));
 }
 
 
@@ -973,10 +1644,14 @@ void ReverseManager::ReverseCmd::execute(span<const TclObject> tokens, TclObject
 		"stop",       [&]{ manager.stop(); },
 		"status",     [&]{ manager.status(result); },
 		"debug",      [&]{ manager.debugInfo(result); },
+		"stats",      [&]{ manager.statsInfo(result); },
 		"goback",     [&]{ manager.goBack(tokens); },
 		"goto",       [&]{ manager.goTo(tokens); },
 		"savereplay", [&]{ manager.saveReplay(interp, tokens, result); },
 		"loadreplay", [&]{ manager.loadReplay(interp, tokens, result); },
+		"verifyreplay", [&]{ manager.verifyReplay(tokens, result); },
+		"journal",    [&]{ manager.journalCmd(tokens, result); },
+		"netplay",    [&]{ manager.netplayCmd(tokens, result); },
 		"viewonlymode", [&]{
 			auto& distributor = manager.motherBoard.getStateChangeDistributor();
 			switch (tokens.size()) {
@@ -1000,30 +1675,49 @@ string ReverseManager::ReverseCmd::help(const vector<string>& /*tokens*/) const
 	return "start               start collecting reverse data\n"
 	       "stop                stop collecting\n"
 	       "status              show various status info on reverse\n"
+	       "stats               show the size and serialize time of the parts (devices) of the last snapshot\n"
 	       "goback <n>          go back <n> seconds in time\n"
 	       "goto <time>         go to an absolute moment in time\n"
 	       "viewonlymode <bool> switch viewonly mode on or off\n"
 	       "truncatereplay      stop replaying and remove all 'future' data\n"
-	       "savereplay [<name>] save the first snapshot and all replay data as a 'replay' (with optional name)\n"
-	       "loadreplay [-goto <begin|end|savetime|<n>>] [-viewonly] <name>   load a replay (snapshot and replay data) with given name and start replaying\n";
+	       "savereplay [-maxnofextrasnapshots <n>] [-binary] [<name>]   save the first snapshot and all replay data as a 'replay' (with optional name), -binary uses the compact binary format\n"
+	       "loadreplay [-goto <begin|end|savetime|<n>>] [-viewonly] <name>   load a replay (snapshot and replay data) with given name and start replaying\n"
+	       "verifyreplay <name> replay the replay with given name as fast as possible (no video, no sound) and compare the machine state with each snapshot in it, returns a dict with 'status' (ok or diverged), the number of matching 'snapshots', the 'time' of the last compared snapshot and the 'differences' (names of the debuggables that differ)\n"
+	       "journal start [<name>] start writing the replay to a file incrementally (a 'journal'), it can be loaded with loadreplay\n"
+	       "journal flush       append the new replay data to the journal (in the background)\n"
+	       "journal stop        flush and close the journal\n"
+	       "journal             returns the filename of the current journal (or an empty string)\n"
+	       "netplay start <localport> <host> <port>   start a netplay session with the openMSX at host:port, both sides must start from the same state\n"
+	       "netplay stop        leave the netplay session\n"
+	       "netplay             show the status of the netplay session\n";
 }
 
 void ReverseManager::ReverseCmd::tabCompletion(vector<string>& tokens) const
 {
 	if (tokens.size() == 2) {
 		static const char* const subCommands[] = {
-			"start", "stop", "status", "goback", "goto",
-			"savereplay", "loadreplay", "viewonlymode",
-			"truncatereplay",
+			"start", "stop", "status", "stats", "goback", "goto",
+			"savereplay", "loadreplay", "verifyreplay", "viewonlymode",
+			"truncatereplay", "journal", "netplay",
 		};
 		completeString(tokens, subCommands);
 	} else if ((tokens.size() == 3) || (tokens[1] == "loadreplay")) {
-		if (tokens[1] == "loadreplay" || tokens[1] == "savereplay") {
+		if (tokens[1] == "verifyreplay") {
+			completeFileName(tokens, userDataFileContext(REPLAY_DIR));
+		} else if (tokens[1] == "loadreplay" || tokens[1] == "savereplay") {
 			std::vector<const char*> cmds;
 			if (tokens[1] == "loadreplay") {
 				cmds = { "-goto", "-viewonly" };
+			} else {
+				cmds = { "-maxnofextrasnapshots", "-binary" };
 			}
 			completeFileName(tokens, userDataFileContext(REPLAY_DIR), cmds);
+		} else if (tokens[1] == "journal") {
+			static const char* const cmds[] = { "start", "flush", "stop" };
+			completeString(tokens, cmds);
+		} else if (tokens[1] == "netplay") {
+			static const char* const cmds[] = { "start", "stop" };
+			completeString(tokens, cmds);
 		} else if (tokens[1] == "viewonlymode") {
 			static const char* const options[] = { "true", "false" };
 			completeString(tokens, options);
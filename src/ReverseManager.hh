@@ -5,11 +5,14 @@
 #include "EventListener.hh"
 #include "StateChangeListener.hh"
 #include "Command.hh"
+#include "IntegerSetting.hh"
 #include "EmuTime.hh"
 #include "MemBuffer.hh"
 #include "DeltaBlock.hh"
+#include "serialize_stats.hh"
 #include "span.hh"
 #include "outer.hh"
+#include <deque>
 #include <vector>
 #include <map>
 #include <memory>
@@ -23,6 +26,9 @@ class EventDelay;
 class EventDistributor;
 class TclObject;
 class Interpreter;
+class ReverseSpillFile;
+class ReplayJournal;
+class Netplay;
 
 class ReverseManager final : private EventListener, private StateChangeRecorder
 {
@@ -50,6 +56,15 @@ public:
 		reRecordCount = count;
 	}
 
+	/** Add events that happened on the other machine of a netplay
+	  * session. Events in the future are scheduled at their own time. When
+	  * some events are already in the past, they're inserted in the
+	  * history and then the machine goes back to before the oldest one and
+	  * emulates up to the current time again. This switches to a new
+	  * MSXMotherBoard, so this object is deleted afterwards.
+	  */
+	void insertRemoteEvents(const std::vector<std::shared_ptr<StateChange>>& events);
+
 private:
 	struct ReverseChunk {
 		ReverseChunk() : time(EmuTime::zero) {}
@@ -63,18 +78,42 @@ private:
 		// snapshot was created. So when going back replay should
 		// start at this index.
 		unsigned eventCount;
+
+		// When the memory budget is exceeded, old snapshots are moved
+		// to the spill file. 'spillOffset' is the position of this
+		// snapshot in that file (or NOT_SPILLED). 'spilled' indicates
+		// the in-memory data has been released.
+		static constexpr size_t NOT_SPILLED = size_t(-1);
+		size_t spillOffset = NOT_SPILLED;
+		std::vector<size_t> blockSizes; // only valid when on disk
+		bool spilled = false;
 	};
 	using Chunks = std::map<unsigned, ReverseChunk>;
+	using KeyFrames = std::deque<ReverseChunk>; // sorted on time
 	using Events = std::vector<std::shared_ptr<StateChange>>;
 
 	struct ReverseHistory {
+		ReverseHistory();
+		~ReverseHistory();
 		void swap(ReverseHistory& other);
 		void clear();
 		unsigned getNextSeqNum(EmuTime::param time) const;
 
+		/** Approximate amount of memory used by the (not spilled)
+		  * snapshots. */
+		size_t getMemoryUsage() const;
+		/** Move the snapshot data to the spill file.
+		  * @throws FileException */
+		void spill(ReverseChunk& chunk);
+		/** Make sure the snapshot data is available in memory.
+		  * @throws FileException */
+		void unspill(ReverseChunk& chunk);
+
 		Chunks chunks;
+		KeyFrames keyFrames; // never spilled
 		Events events;
 		LastDeltaBlocks lastDeltaBlocks;
+		std::unique_ptr<ReverseSpillFile> spillFile; // created on demand
 	};
 
 	bool isCollecting() const { return collecting; }
@@ -82,13 +121,21 @@ private:
 	void start();
 	void stop();
 	void status(TclObject& result) const;
+	void sendStatusUpdate();
 	void debugInfo(TclObject& result) const;
+	void statsInfo(TclObject& result) const;
 	void goBack(span<const TclObject> tokens);
 	void goTo(span<const TclObject> tokens);
 	void saveReplay(Interpreter& interp,
 	                span<const TclObject> tokens, TclObject& result);
 	void loadReplay(Interpreter& interp,
 	                span<const TclObject> tokens, TclObject& result);
+	void verifyReplay(span<const TclObject> tokens, TclObject& result);
+	void journalCmd(span<const TclObject> tokens, TclObject& result);
+	void netplayCmd(span<const TclObject> tokens, TclObject& result);
+	void flushJournal();
+	void restartJournal();
+	void stopJournal();
 
 	void signalStopReplay(EmuTime::param time);
 	EmuTime::param getEndTime(const ReverseHistory& history) const;
@@ -98,9 +145,20 @@ private:
 	void transferHistory(ReverseHistory& oldHistory,
 	                     unsigned oldEventCount);
 	void transferState(MSXMotherBoard& newBoard);
+	// TODO Run-ahead (each host frame: snapshot, emulate N frames with the
+	//      current input and show the last one, restore) would build on
+	//      takeSnapshot(). But only taking a snapshot is cheap (delta
+	//      blocks): restoring one always deserializes into a freshly
+	//      created MSXMotherBoard (see goTo()), which constructs all
+	//      devices from the config and replaces the active board. Doing
+	//      that every frame would cost far more than a frame. It first
+	//      needs a way to load a snapshot into the existing devices.
 	void takeSnapshot(EmuTime::param time);
+	void takeKeyFrame(EmuTime::param time);
+	void limitMemoryUsage();
 	void schedule(EmuTime::param time);
 	void replayNextEvent();
+	void scheduleRemoteEvent();
 	template<unsigned N> void dropOldSnapshots(unsigned count);
 
 	// Schedulable
@@ -120,9 +178,18 @@ private:
 			rm.execInputEvent();
 		}
 	} syncInputEvent;
+	struct SyncRemoteEvent final : Schedulable {
+		friend class ReverseManager;
+		explicit SyncRemoteEvent(Scheduler& s) : Schedulable(s) {}
+		void executeUntil(EmuTime::param /*time*/) override {
+			auto& rm = OUTER(ReverseManager, syncRemoteEvent);
+			rm.execRemoteEvent();
+		}
+	} syncRemoteEvent;
 
 	void execNewSnapshot();
 	void execInputEvent();
+	void execRemoteEvent();
 	EmuTime::param getCurrentTime() const { return syncNewSnapshot.getCurrentTime(); }
 
 	// EventListener
@@ -143,12 +210,20 @@ private:
 		void tabCompletion(std::vector<std::string>& tokens) const override;
 	} reverseCmd;
 
+	IntegerSetting memoryBudgetSetting;
+
 	Keyboard* keyboard;
 	EventDelay* eventDelay;
 	ReverseHistory history;
+	std::unique_ptr<ReplayJournal> journal; // only while journaling
+	std::unique_ptr<Netplay> netplay; // only during a netplay session
+	Events remoteEvents; // (netplay) future events, sorted on time
+	bool deliveringRemote = false;
+	SerializeStats snapshotStats; // of the last snapshot
 	unsigned replayIndex;
 	bool collecting;
 	bool pendingTakeSnapshot;
+	unsigned keyFrameCount = 0; // since the last snapshot
 
 	unsigned reRecordCount;
 
@@ -2,11 +2,15 @@
 #include "Schedulable.hh"
 #include "Thread.hh"
 #include "MSXCPU.hh"
+#include "Instrumentation.hh"
+#include "demangle.hh"
 #include "ranges.hh"
 #include "serialize.hh"
 #include "stl.hh"
 #include <cassert>
+#include <chrono>
 #include <iterator> // for back_inserter
+#include <typeinfo>
 
 namespace openmsx {
 
@@ -39,8 +43,7 @@ void Scheduler::setSyncPoint(EmuTime::param time, Schedulable& device)
 	// Push sync point into queue.
 	queue.insert(SynchronizationPoint(time, &device),
 	             [](SynchronizationPoint& sp) { sp.setTime(EmuTime::infinity); },
-	             [](const SynchronizationPoint& x, const SynchronizationPoint& y) {
-	                     return x.getTime() < y.getTime(); });
+	             LessSyncPoint());
 
 	if (!scheduleInProgress && cpu) {
 		// only when scheduleHelper() is not being executed
@@ -101,7 +104,12 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 
 		queue.remove_front();
 
-		device->executeUntil(next);
+		INSTRUMENT_ZONE(Instrumentation::typeName(typeid(*device)));
+		if (unlikely(statsEnabled)) {
+			executeWithStats(*device, next);
+		} else {
+			device->executeUntil(next);
+		}
 
 		next = getNext();
 		if (likely(next > limit)) break;
@@ -111,6 +119,32 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 	cpu->setNextSyncPoint(next);
 }
 
+void Scheduler::executeWithStats(Schedulable& device, EmuTime::param time)
+{
+	// Lookup before executing, executeUntil() may delete the device.
+	auto& stat = stats[std::type_index(typeid(device))];
+
+	auto start = std::chrono::steady_clock::now();
+	device.executeUntil(time);
+	auto stop = std::chrono::steady_clock::now();
+
+	++stat.count;
+	stat.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+		stop - start).count();
+}
+
+Scheduler::Stats Scheduler::getStats() const
+{
+	Stats result;
+	for (auto& p : stats) {
+		result.emplace_back(demangle(p.first.name()), p.second);
+	}
+	ranges::sort(result, [](auto& x, auto& y) {
+		return x.second.nanoseconds > y.second.nanoseconds;
+	});
+	return result;
+}
+
 
 template <typename Archive>
 void SynchronizationPoint::serialize(Archive& ar, unsigned /*version*/)
@@ -1,9 +1,27 @@
 #ifndef SCHEDULER_HH
 #define SCHEDULER_HH
 
+// Set to 1 to keep the pending synchronization points in a 4-ary heap
+// (SchedulerHeap) instead of in a SchedulerQueue. The heap has better
+// worst-case behavior, but in typical scheduling patterns most inserts land
+// near the front of the queue, and then SchedulerQueue still wins, even with
+// 64 sync points. See the "[.benchmark]" test in SchedulerQueue_test.cc.
+#ifndef SCHEDULER_HEAP
+#define SCHEDULER_HEAP 0
+#endif
+
 #include "EmuTime.hh"
+#if SCHEDULER_HEAP
+#include "SchedulerHeap.hh"
+#else
 #include "SchedulerQueue.hh"
+#endif
+#include "hash_map.hh"
 #include "likely.hh"
+#include <cstdint>
+#include <string>
+#include <typeindex>
+#include <utility>
 #include <vector>
 
 namespace openmsx {
@@ -29,12 +47,27 @@ private:
 	Schedulable* device = nullptr;
 };
 
+struct LessSyncPoint {
+	bool operator()(const SynchronizationPoint& x,
+	                const SynchronizationPoint& y) const {
+		return x.getTime() < y.getTime();
+	}
+};
+
 
 class Scheduler
 {
 public:
 	using SyncPoints = std::vector<SynchronizationPoint>;
 
+	/** Statistics on the executeUntil() calls of one type of Schedulable.
+	  */
+	struct Stat {
+		uint64_t count = 0;       // number of calls
+		uint64_t nanoseconds = 0; // total host time spent in those calls
+	};
+	using Stats = std::vector<std::pair<std::string, Stat>>;
+
 	Scheduler() = default;
 	~Scheduler();
 
@@ -68,6 +101,20 @@ public:
 		scheduleTime = limit;
 	}
 
+	/** Enable/disable collecting statistics on the executed sync points.
+	  * This is meant to find out which devices are the most expensive to
+	  * emulate. It's disabled by default because it has some overhead.
+	  */
+	void setStatsEnabled(bool enabled) { statsEnabled = enabled; }
+	bool isStatsEnabled() const { return statsEnabled; }
+	void resetStats() { stats.clear(); }
+
+	/** Get the collected statistics, one entry per type of Schedulable
+	  * (the name is the demangled type name), sorted on descending host
+	  * time.
+	  */
+	Stats getStats() const;
+
 	template <typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -107,14 +154,21 @@ private: // -> intended for Schedulable
 
 private:
 	void scheduleHelper(EmuTime::param limit, EmuTime next);
+	void executeWithStats(Schedulable& device, EmuTime::param time);
 
 	/** Vector used as heap, not a priority queue because that
 	  * doesn't allow removal of non-top element.
 	  */
+#if SCHEDULER_HEAP
+	SchedulerHeap<SynchronizationPoint, LessSyncPoint> queue;
+#else
 	SchedulerQueue<SynchronizationPoint> queue;
+#endif
 	EmuTime scheduleTime = EmuTime::zero;
 	MSXCPU* cpu = nullptr;
 	bool scheduleInProgress = false;
+	bool statsEnabled = false;
+	hash_map<std::type_index, Stat> stats;
 };
 
 } // namespace openmsx
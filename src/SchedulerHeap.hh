@@ -0,0 +1,162 @@
+#ifndef SCHEDULERHEAP_HH
+#define SCHEDULERHEAP_HH
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+// Alternative for SchedulerQueue, organized as a D-ary heap (by default a
+// 4-ary heap). Insert and remove_front() run in O(log(N)) instead of O(N), so
+// this is faster when there are many pending elements. For a small number of
+// elements SchedulerQueue is usually faster.
+//
+// The interface is the same as for SchedulerQueue, except that the LESS
+// predicate is a template parameter (remove_front() also needs it). Like
+// SchedulerQueue, equivalent elements are returned in order of insertion
+// (this needs an extra sequence number per element). Iterating over the
+// elements (begin()/end()) visits them in an unspecified order.
+template<typename T, typename LESS, unsigned D = 4> class SchedulerHeap
+{
+	static_assert(D >= 2, "need at least a binary heap");
+
+public:
+	explicit SchedulerHeap(LESS less_ = LESS())
+		: less(less_)
+	{
+		values.reserve(32);
+		seqNums.reserve(32);
+	}
+
+	size_t size()  const { return values.size(); }
+	bool   empty() const { return values.empty(); }
+
+	// Returns reference to the smallest element.
+	      T& front()       { assert(!empty()); return values.front(); }
+	const T& front() const { assert(!empty()); return values.front(); }
+
+	      T* begin()       { return values.data(); }
+	const T* begin() const { return values.data(); }
+	      T* end()         { return values.data() + values.size(); }
+	const T* end()   const { return values.data() + values.size(); }
+
+	// Insert new element.
+	// The SET_SENTINEL parameter is only there for compatibility with
+	// SchedulerQueue, it's not used. The 'less' parameter should be
+	// equivalent with the LESS template parameter.
+	template<typename SET_SENTINEL>
+	void insert(const T& t, SET_SENTINEL /*setSentinel*/, LESS /*less*/)
+	{
+		values.push_back(t);
+		seqNums.push_back(nextSeqNum++);
+		siftUp(values.size() - 1);
+	}
+
+	// Remove the smallest element.
+	void remove_front()
+	{
+		assert(!empty());
+		removeAt(0);
+	}
+
+	// Remove the first (in iteration order) element for which the given
+	// predicate returns true.
+	template<typename PRED> bool remove(PRED p)
+	{
+		auto it = std::find_if(values.begin(), values.end(), p);
+		if (it == values.end()) return false;
+		removeAt(it - values.begin());
+		return true;
+	}
+
+	// Remove all elements for which the given predicate returns true.
+	template<typename PRED> void remove_all(PRED p)
+	{
+		size_t n = values.size();
+		size_t dst = 0;
+		for (size_t src = 0; src < n; ++src) {
+			if (p(values[src])) continue;
+			values [dst] = std::move(values [src]);
+			seqNums[dst] =           seqNums[src];
+			++dst;
+		}
+		if (dst == n) return;
+		values .resize(dst);
+		seqNums.resize(dst);
+		// restore heap property
+		for (size_t i = dst / D + 1; i-- > 0; ) {
+			siftDown(i);
+		}
+	}
+
+private:
+	bool before(size_t i, size_t j) const
+	{
+		if (less(values[i], values[j])) return true;
+		if (less(values[j], values[i])) return false;
+		return seqNums[i] < seqNums[j];
+	}
+
+	void swapElems(size_t i, size_t j)
+	{
+		using std::swap;
+		swap(values [i], values [j]);
+		swap(seqNums[i], seqNums[j]);
+	}
+
+	void siftUp(size_t i)
+	{
+		while (i != 0) {
+			size_t parent = (i - 1) / D;
+			if (!before(i, parent)) break;
+			swapElems(i, parent);
+			i = parent;
+		}
+	}
+
+	void siftDown(size_t i)
+	{
+		size_t n = values.size();
+		while (true) {
+			size_t first = D * i + 1;
+			if (first >= n) break;
+			size_t last = std::min(first + D, n);
+			size_t best = first;
+			for (size_t c = first + 1; c < last; ++c) {
+				if (before(c, best)) best = c;
+			}
+			if (!before(best, i)) break;
+			swapElems(i, best);
+			i = best;
+		}
+	}
+
+	void removeAt(size_t i)
+	{
+		size_t last = values.size() - 1;
+		if (i != last) {
+			values [i] = std::move(values [last]);
+			seqNums[i] =           seqNums[last];
+		}
+		values .pop_back();
+		seqNums.pop_back();
+		if (i < values.size()) {
+			siftUp(i);
+			siftDown(i);
+		}
+	}
+
+private:
+	std::vector<T> values;
+	std::vector<uint64_t> seqNums; // parallel to 'values'
+	uint64_t nextSeqNum = 0;
+	LESS less;
+};
+
+} // namespace openmsx
+
+#endif // SCHEDULERHEAP_HH
@@ -5,8 +5,8 @@
 #include "CliComm.hh"
 #include "Clock.hh"
 #include "MSXException.hh"
-#include "stl.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cstring> // for memcmp
 
 namespace openmsx {
@@ -55,20 +55,80 @@ CasImage::CasImage(const Filename& filename, FilePool& filePool, CliComm& cliCom
 	convert(filename, filePool, cliComm);
 }
 
-int16_t CasImage::getSampleAt(EmuTime::param time)
+// Output samples per bit and per byte (one start bit, eight data bits and
+// two stop bits).
+static const unsigned SAMPLES_PER_BIT = 4;
+static const unsigned SAMPLES_PER_BYTE = 11 * SAMPLES_PER_BIT;
+
+static int bitSample(bool bit, unsigned i)
+{
+	static const signed char wave0[SAMPLES_PER_BIT] = { 127, 127, -127, -127 };
+	static const signed char wave1[SAMPLES_PER_BIT] = { 127, -127, 127, -127 };
+	return bit ? wave1[i] : wave0[i];
+}
+
+size_t CasImage::getNbSamples() const
+{
+	return segments.empty() ? 0 : segments.back().start + segments.back().length;
+}
+
+static size_t toSample(EmuTime::param time)
 {
 	static const Clock<OUTPUT_FREQUENCY> zero(EmuTime::zero);
-	unsigned pos = zero.getTicksTill(time);
-	return pos < output.size() ? output[pos] * 256 : 0;
+	return zero.getTicksTill(time);
 }
 
-EmuTime CasImage::getEndTime() const
+static EmuTime toTime(size_t sample)
 {
 	Clock<OUTPUT_FREQUENCY> clk(EmuTime::zero);
-	clk += unsigned(output.size());
+	clk += unsigned(sample);
 	return clk.getTime();
 }
 
+// Returns the segment that contains the given sample, or end(segments).
+std::vector<CasImage::Segment>::const_iterator CasImage::findSegment(size_t pos) const
+{
+	auto it = std::upper_bound(begin(segments), end(segments), pos,
+		[](size_t p, const Segment& s) { return p < s.start; });
+	if (it == begin(segments)) return end(segments);
+	--it;
+	return ((pos - it->start) < it->length) ? it : end(segments);
+}
+
+int CasImage::getSample(size_t pos) const
+{
+	auto it = findSegment(pos);
+	if (it == end(segments)) return 0;
+	auto& seg = *it;
+	size_t offset = pos - seg.start;
+
+	unsigned bitPos = offset % SAMPLES_PER_BIT;
+	switch (seg.kind) {
+	case Segment::HEADER:
+		return bitSample(true, bitPos);
+	case Segment::DATA: {
+		byte b = data[seg.dataPos + offset / SAMPLES_PER_BYTE];
+		unsigned bitNo = (offset % SAMPLES_PER_BYTE) / SAMPLES_PER_BIT;
+		bool bit = (bitNo == 0) ? false // start bit
+		         : (bitNo <= 8) ? ((b >> (bitNo - 1)) & 1) != 0
+		         : true; // stop bits
+		return bitSample(bit, bitPos);
+	}
+	default:
+		return 0; // silence
+	}
+}
+
+int16_t CasImage::getSampleAt(EmuTime::param time)
+{
+	return getSample(toSample(time)) * 256;
+}
+
+EmuTime CasImage::getEndTime() const
+{
+	return toTime(getNbSamples());
+}
+
 unsigned CasImage::getFrequency() const
 {
 	return OUTPUT_FREQUENCY * AUDIO_OVERSAMPLE;
@@ -76,11 +136,11 @@ unsigned CasImage::getFrequency() const
 
 void CasImage::fillBuffer(unsigned pos, float** bufs, unsigned num) const
 {
-	size_t nbSamples = output.size();
+	size_t nbSamples = getNbSamples();
 	if ((pos / AUDIO_OVERSAMPLE) < nbSamples) {
 		for (auto i : xrange(num)) {
 			bufs[0][i] = ((pos / AUDIO_OVERSAMPLE) < nbSamples)
-			           ? output[pos / AUDIO_OVERSAMPLE]
+			           ? getSample(pos / AUDIO_OVERSAMPLE)
 			           : 0.0f;
 			++pos;
 		}
@@ -94,64 +154,99 @@ float CasImage::getAmplificationFactorImpl() const
 	return 1.0f / 128;
 }
 
-void CasImage::write0()
+bool CasImage::readHeader(EmuTime& pos) const
 {
-	append(output, {127, 127, -127, -127});
+	// Skip the silence and most of the first header that isn't
+	// completely passed yet. Leave as much as a short header, that's
+	// enough for the BIOS to synchronize with the signal.
+	static const size_t KEEP = SHORT_HEADER * SAMPLES_PER_BIT;
+	size_t sample = toSample(pos);
+	for (auto& seg : segments) {
+		auto end = seg.start + seg.length;
+		if ((seg.kind == Segment::HEADER) && (end > sample)) {
+			if ((end - sample) > KEEP) {
+				pos = toTime(std::max(seg.start, end - KEEP));
+			}
+			return true;
+		}
+	}
+	return false;
 }
-void CasImage::write1()
+
+bool CasImage::readByte(EmuTime& pos, uint8_t& value) const
 {
-	append(output, {127, -127, 127, -127});
+	size_t sample = toSample(pos);
+	auto it = findSegment(sample);
+	if (it == end(segments)) return false;
+	if (it->kind == Segment::HEADER) {
+		// the BIOS may stop reading the header a bit early
+		auto next = it + 1;
+		if ((next == end(segments)) || (next->kind != Segment::DATA)) {
+			return false;
+		}
+		it = next;
+		sample = it->start;
+	} else if (it->kind != Segment::DATA) {
+		return false;
+	}
+
+	// The tape keeps rolling between two reads, so the position is
+	// usually a bit past the start of the next byte. Only skip a byte
+	// when most of it has already passed.
+	size_t byteNo = (sample - it->start + SAMPLES_PER_BYTE / 4) /
+	                SAMPLES_PER_BYTE;
+	if (byteNo >= (it->length / SAMPLES_PER_BYTE)) return false;
+	value = data[it->dataPos + byteNo];
+	pos = toTime(it->start + (byteNo + 1) * SAMPLES_PER_BYTE);
+	return true;
 }
 
-// write a header signal
-void CasImage::writeHeader(int s)
+void CasImage::addSegment(Segment::Kind kind, size_t length, size_t dataPos)
 {
-	for (int i = 0; i < s; ++i) {
-		write1();
+	if (length == 0) return;
+	auto start = getNbSamples();
+	if (!segments.empty()) {
+		// merge with the previous segment when possible
+		auto& last = segments.back();
+		if ((last.kind == kind) &&
+		    ((kind != Segment::DATA) ||
+		     ((last.dataPos + last.length / SAMPLES_PER_BYTE) == dataPos))) {
+			last.length += length;
+			return;
+		}
 	}
+	segments.push_back({start, length, dataPos, kind});
 }
 
-// write silence
-void CasImage::writeSilence(int s)
+// write a header signal
+void CasImage::writeHeader(int s)
 {
-	output.insert(end(output), s, 0);
+	addSegment(Segment::HEADER, size_t(s) * SAMPLES_PER_BIT);
 }
 
-// write a byte
-void CasImage::writeByte(byte b)
+// write silence
+void CasImage::writeSilence(int s)
 {
-	// one start bit
-	write0();
-	// eight data bits
-	for (auto i : xrange(8)) {
-		if (b & (1 << i)) {
-			write1();
-		} else {
-			write0();
-		}
-	}
-	// two stop bits
-	write1();
-	write1();
+	addSegment(Segment::SILENCE, s);
 }
 
 // write data until a header is detected
 bool CasImage::writeData(span<byte> buf, size_t& pos)
 {
 	bool eof = false;
+	size_t start = pos;
 	while ((pos + 8) <= buf.size()) {
 		if (memcmp(&buf[pos], CAS_HEADER, 8) == 0) {
+			addSegment(Segment::DATA, (pos - start) * SAMPLES_PER_BYTE, start);
 			return eof;
 		}
-		writeByte(buf[pos]);
 		if (buf[pos] == 0x1A) {
 			eof = true;
 		}
 		pos++;
 	}
-	while (pos < buf.size()) {
-		writeByte(buf[pos++]);
-	}
+	pos = buf.size();
+	addSegment(Segment::DATA, (pos - start) * SAMPLES_PER_BYTE, start);
 	return false;
 }
 
@@ -159,6 +254,7 @@ void CasImage::convert(const Filename& filename, FilePool& filePool, CliComm& cl
 {
 	File file(filename);
 	auto buf = file.mmap();
+	data.assign(buf.begin(), buf.end());
 
 	// search for a header in the .cas file
 	bool issueWarning = false;
@@ -26,17 +26,32 @@ public:
 	unsigned getFrequency() const override;
 	void fillBuffer(unsigned pos, float** bufs, unsigned num) const override;
 	float getAmplificationFactorImpl() const override;
+	bool readHeader(EmuTime& pos) const override;
+	bool readByte(EmuTime& pos, uint8_t& value) const override;
 
 private:
-	void write0();
-	void write1();
+	// The converted signal is not stored, it's generated on demand from
+	// a list of segments (silence, header or data bytes of the .cas
+	// file). That's about 44 times smaller than the full signal.
+	struct Segment {
+		enum Kind { SILENCE, HEADER, DATA };
+		size_t start;   // first output sample
+		size_t length;  // number of output samples
+		size_t dataPos; // offset in 'data' (only for DATA)
+		Kind kind;
+	};
+
 	void writeHeader(int s);
 	void writeSilence(int s);
-	void writeByte(byte b);
 	bool writeData(span<byte> buf, size_t& pos);
+	void addSegment(Segment::Kind kind, size_t length, size_t dataPos = 0);
 	void convert(const Filename& filename, FilePool& filePool, CliComm& cliComm);
+	std::vector<Segment>::const_iterator findSegment(size_t pos) const;
+	int getSample(size_t pos) const;
+	size_t getNbSamples() const;
 
-	std::vector<signed char> output;
+	std::vector<Segment> segments;
+	std::vector<byte> data; // content of the .cas file
 };
 
 } // namespace openmsx
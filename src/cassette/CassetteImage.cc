@@ -16,6 +16,16 @@ std::string CassetteImage::getFirstFileTypeAsString() const
 	}
 }
 
+bool CassetteImage::readHeader(EmuTime& /*pos*/) const
+{
+	return false;
+}
+
+bool CassetteImage::readByte(EmuTime& /*pos*/, uint8_t& /*value*/) const
+{
+	return false;
+}
+
 void CassetteImage::setSha1Sum(const Sha1Sum& sha1sum_)
 {
 	assert(sha1sum.empty());
@@ -20,6 +20,19 @@ public:
 	virtual void fillBuffer(unsigned pos, float** bufs, unsigned num) const = 0;
 	virtual float getAmplificationFactorImpl() const = 0;
 
+	/** Support for fast loading (replacing the BIOS tape routines), only
+	  * possible for images that contain the actual data bytes (.cas).
+	  * readHeader(): skip to the last part of the next block header,
+	  * the BIOS still reads that part to measure the signal.
+	  * readByte(): read the data byte at the given tape position.
+	  * On success 'pos' is moved to after that (part of the) header or
+	  * byte.
+	  * @return false when not supported, or when there's no header or
+	  *         data byte at this position.
+	  */
+	virtual bool readHeader(EmuTime& pos) const;
+	virtual bool readByte(EmuTime& pos, uint8_t& value) const;
+
 	FileType getFirstFileType() const { return firstFileType; }
 	std::string getFirstFileTypeAsString() const;
 
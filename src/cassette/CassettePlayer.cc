@@ -287,6 +287,38 @@ void CassettePlayer::setState(State newState, const Filename& newImage,
 	checkInvariants();
 }
 
+bool CassettePlayer::fastLoadHeader(EmuTime::param time)
+{
+	if (getState() != PLAY) return false;
+	sync(time);
+	EmuTime pos = tapePos;
+	if (!playImage->readHeader(pos)) return false;
+	setTapePos(pos, time);
+	return true;
+}
+
+int CassettePlayer::fastLoadByte(EmuTime::param time)
+{
+	if (getState() != PLAY) return -1;
+	sync(time);
+	EmuTime pos = tapePos;
+	uint8_t value;
+	if (!playImage->readByte(pos, value)) return -1;
+	setTapePos(pos, time);
+	return value;
+}
+
+void CassettePlayer::setTapePos(EmuTime::param pos, EmuTime::param time)
+{
+	assert(prevSyncTime == time); // sync() must be called
+	assert(pos <= playImage->getEndTime());
+	tapePos = pos;
+	DynamicClock clk(EmuTime::zero);
+	clk.setFreq(playImage->getFrequency());
+	audioPos = clk.getTicksTill(tapePos);
+	updateLoadingState(time); // moves end-of-tape syncpoint
+}
+
 void CassettePlayer::updateLoadingState(EmuTime::param time)
 {
 	assert(prevSyncTime == time); // sync() must be called
@@ -715,6 +747,12 @@ void CassettePlayer::TapeCommand::execute(
 	} else if (tokens[1] == "getlength") {
 		result = cassettePlayer.getTapeLength(time);
 
+	} else if (tokens[1] == "readheader") {
+		result = cassettePlayer.fastLoadHeader(time);
+
+	} else if (tokens[1] == "readbyte") {
+		result = cassettePlayer.fastLoadByte(time);
+
 	} else {
 		try {
 			result = "Changing tape";
@@ -780,6 +818,18 @@ string CassettePlayer::TapeCommand::help(const vector<string>& tokens) const
 		} else if (tokens[1] == "getlength") {
 			helptext =
 			    "Return the length of the tape in seconds.";
+		} else if (tokens[1] == "readheader") {
+			helptext =
+			    "Move the tape to the last part of the next block "
+			    "header. Returns false when that's not possible "
+			    "(only supported for CAS images). Used to "
+			    "replace the BIOS tape routines, see the "
+			    "'cassette_fast_load' setting.";
+		} else if (tokens[1] == "readbyte") {
+			helptext =
+			    "Return the next data byte on the tape and move "
+			    "the tape to after it, or -1 when that's not "
+			    "possible (only supported for CAS images).";
 		}
 	} else {
 		helptext =
@@ -826,7 +876,10 @@ void CassettePlayer::TapeCommand::tabCompletion(vector<string>& tokens) const
 
 bool CassettePlayer::TapeCommand::needRecord(span<const TclObject> tokens) const
 {
-	return tokens.size() > 1;
+	// The fast load subcommands are executed from breakpoints, those
+	// are also triggered again while replaying.
+	return (tokens.size() > 1) &&
+	       (tokens[1] != "readheader") && (tokens[1] != "readbyte");
 }
 
 
@@ -103,6 +103,16 @@ private:
 	  * continuously). */
 	double getTapeLength(EmuTime::param time);
 
+	/** Fast loading: skip to the end of the next header, or read the
+	  * next data byte and move the tape to after it. This allows to
+	  * replace the BIOS tape routines, while a (custom) loader that
+	  * reads the signal itself still finds the tape at the right spot.
+	  * @return false resp. -1 when not possible (e.g. a WAV image).
+	  */
+	bool fastLoadHeader(EmuTime::param time);
+	int fastLoadByte(EmuTime::param time);
+	void setTapePos(EmuTime::param pos, EmuTime::param time);
+
 	void sync(EmuTime::param time);
 	void updateTapePosition(EmuDuration::param duration, EmuTime::param time);
 	void generateRecordOutput(EmuDuration::param duration);
@@ -4,6 +4,7 @@
 #include "FilePool.hh"
 #include "Math.hh"
 #include "xrange.hh"
+#include <algorithm>
 
 namespace openmsx {
 
@@ -22,6 +23,10 @@ public:
 		t0 = t1;
 		return y;
 	}
+	float getR() const { return R; }
+	float getState() const { return t0; }
+	void setR(float r) { R = r; }
+	void setState(float t) { t0 = t; }
 private:
 	float R;
 	float t0 = 0.0f;
@@ -29,24 +34,67 @@ private:
 
 // Note: type detection not implemented yet for WAV images
 WavImage::WavImage(const Filename& filename, FilePool& filePool)
-	: clock(EmuTime::zero)
+	: file(filename)
+	, raw(file.mmap())
+	, format(WavData::parseFormat(raw))
+	, chunkBuf(CHUNK_SIZE)
+	, currentChunk(unsigned(-1))
+	, clock(EmuTime::zero)
 {
-	File file(filename);
 	setSha1Sum(filePool.getSha1Sum(file));
 
-	wav = WavData(std::move(file), DCFilter{});
-	clock.setFreq(wav.getFreq());
+	DCFilter filter;
+	filter.setFreq(format.freq);
+	filterR = filter.getR();
+	chunkStates.push_back(0.0f);
+	clock.setFreq(format.freq);
+}
+
+void WavImage::decodeChunk(unsigned chunk) const
+{
+	DCFilter filter;
+	filter.setR(filterR);
+
+	// Run the filter up to the start of the requested chunk (only the
+	// first time a chunk is reached).
+	while (chunkStates.size() <= chunk) {
+		unsigned c = unsigned(chunkStates.size() - 1);
+		filter.setState(chunkStates.back());
+		for (auto i : xrange(c * CHUNK_SIZE, (c + 1) * CHUNK_SIZE)) {
+			filter(WavData::getRawSample(format, raw, i));
+		}
+		chunkStates.push_back(filter.getState());
+	}
+
+	filter.setState(chunkStates[chunk]);
+	unsigned start = chunk * CHUNK_SIZE;
+	unsigned num = std::min(CHUNK_SIZE, format.length - start);
+	for (auto i : xrange(num)) {
+		chunkBuf[i] = filter(WavData::getRawSample(format, raw, start + i));
+	}
+	if (chunkStates.size() == (chunk + 1)) {
+		chunkStates.push_back(filter.getState());
+	}
+	currentChunk = chunk;
+}
+
+int16_t WavImage::getSample(unsigned pos) const
+{
+	if (pos >= format.length) return 0;
+	unsigned chunk = pos / CHUNK_SIZE;
+	if (chunk != currentChunk) decodeChunk(chunk);
+	return chunkBuf[pos % CHUNK_SIZE];
 }
 
 int16_t WavImage::getSampleAt(EmuTime::param time)
 {
-	return wav.getSample(clock.getTicksTill(time));
+	return getSample(clock.getTicksTill(time));
 }
 
 EmuTime WavImage::getEndTime() const
 {
 	DynamicClock clk(clock);
-	clk += wav.getSize();
+	clk += format.length;
 	return clk.getTime();
 }
 
@@ -57,9 +105,9 @@ unsigned WavImage::getFrequency() const
 
 void WavImage::fillBuffer(unsigned pos, float** bufs, unsigned num) const
 {
-	if (pos < wav.getSize()) {
+	if (pos < format.length) {
 		for (auto i : xrange(num)) {
-			bufs[0][i] = wav.getSample(pos + i);
+			bufs[0][i] = getSample(pos + i);
 		}
 	} else {
 		bufs[0] = nullptr;
@@ -4,7 +4,11 @@
 #include "CassetteImage.hh"
 #include "WavData.hh"
 #include "DynamicClock.hh"
+#include "File.hh"
+#include "MemBuffer.hh"
+#include "span.hh"
 #include <cstdint>
+#include <vector>
 
 namespace openmsx {
 
@@ -23,7 +27,22 @@ public:
 	float getAmplificationFactorImpl() const override;
 
 private:
-	WavData wav;
+	int16_t getSample(unsigned pos) const;
+	void decodeChunk(unsigned chunk) const;
+
+	// The samples are not all decoded up front, that would take 2 bytes
+	// per sample for the whole (possibly hours long) tape. Instead the
+	// file stays mapped and one chunk at a time is decoded on demand.
+	// The DC filter has state, so the filter state at the start of each
+	// chunk is remembered (once that chunk is reached).
+	static const unsigned CHUNK_SIZE = 4096;
+	File file;
+	span<uint8_t> raw;
+	WavData::Format format;
+	mutable std::vector<float> chunkStates;
+	mutable MemBuffer<int16_t> chunkBuf;
+	mutable unsigned currentChunk;
+	float filterR;
 	DynamicClock clock;
 };
 
@@ -37,6 +37,9 @@ GlobalCommandController::GlobalCommandController(
 	, helpCmd(*this)
 	, tabCompletionCmd(*this)
 	, updateCmd(*this)
+	, debugStreamCmd(*this)
+	, protocolCmd(*this)
+	, scriptProfileCmd(*this)
 	, platformInfo(getOpenMSXInfoCommand())
 	, versionInfo (getOpenMSXInfoCommand())
 	, romInfoTopic(getOpenMSXInfoCommand())
@@ -528,24 +531,36 @@ static GlobalCliComm::UpdateType getType(const TclObject& name)
 	throw CommandException("No such update type: ", name.getString());
 }
 
-CliConnection& GlobalCommandController::UpdateCmd::getConnection()
+static CliConnection& checkConnection(CliConnection* connection)
 {
-	auto& controller = OUTER(GlobalCommandController, updateCmd);
-	if (auto* c = controller.getConnection()) {
-		return *c;
-	}
+	if (connection) return *connection;
 	throw CommandException("This command only makes sense when "
 	                       "it's used from an external application.");
 }
 
+CliConnection& GlobalCommandController::UpdateCmd::getConnection()
+{
+	auto& controller = OUTER(GlobalCommandController, updateCmd);
+	return checkConnection(controller.getConnection());
+}
+
 void GlobalCommandController::UpdateCmd::execute(
-	span<const TclObject> tokens, TclObject& /*result*/)
+	span<const TclObject> tokens, TclObject& result)
 {
-	checkNumArgs(tokens, 3, "enable|disable type");
+	checkNumArgs(tokens, AtLeast{3}, "enable|disable|filters type ?filter ...?");
+	auto& connection = getConnection();
+	auto type = getType(tokens[2]);
 	if (tokens[1] == "enable") {
-		getConnection().setUpdateEnable(getType(tokens[2]), true);
+		connection.setUpdateEnable(type, true);
+		for (auto& filter : tokens.subspan(3)) {
+			connection.addUpdateFilter(type, filter.getString().str());
+		}
 	} else if (tokens[1] == "disable") {
-		getConnection().setUpdateEnable(getType(tokens[2]), false);
+		checkNumArgs(tokens, 3, "disable type");
+		connection.setUpdateEnable(type, false);
+	} else if (tokens[1] == "filters") {
+		checkNumArgs(tokens, 3, "filters type");
+		result.addListElements(connection.getUpdateFilters(type));
 	} else {
 		throw SyntaxError();
 	}
@@ -553,7 +568,14 @@ void GlobalCommandController::UpdateCmd::execute(
 
 string GlobalCommandController::UpdateCmd::help(const vector<string>& /*tokens*/) const
 {
-	static const string helpText = "Enable or disable update events for external applications. See doc/openmsx-control-xml.txt.";
+	static const string helpText =
+		"Enable or disable update events for external applications. "
+		"Optionally only for the names that match one of the given "
+		"glob patterns, for the 'debuggable' type these are the names "
+		"of the debuggables to watch. See doc/manual/openmsx-control.html.\n"
+		"  openmsx_update enable <type> [<filter> ...]\n"
+		"  openmsx_update disable <type>\n"
+		"  openmsx_update filters <type>\n";
 	return helpText;
 }
 
@@ -561,7 +583,7 @@ void GlobalCommandController::UpdateCmd::tabCompletion(vector<string>& tokens) c
 {
 	switch (tokens.size()) {
 	case 2: {
-		static const char* const ops[] = { "enable", "disable" };
+		static const char* const ops[] = { "enable", "disable", "filters" };
 		completeString(tokens, ops);
 		break;
 	}
@@ -572,6 +594,195 @@ void GlobalCommandController::UpdateCmd::tabCompletion(vector<string>& tokens) c
 }
 
 
+// class DebugStreamCmd
+
+GlobalCommandController::DebugStreamCmd::DebugStreamCmd(CommandController& commandController_)
+	: Command(commandController_, "openmsx_debug_stream")
+{
+}
+
+CliConnection& GlobalCommandController::DebugStreamCmd::getConnection()
+{
+	auto& controller = OUTER(GlobalCommandController, debugStreamCmd);
+	return checkConnection(controller.getConnection());
+}
+
+void GlobalCommandController::DebugStreamCmd::execute(
+	span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& streams = getConnection().getDebugStreams();
+	auto& interp = getInterpreter();
+	if (tokens[1] == "add") {
+		checkNumArgs(tokens, Between{3, 5}, Prefix{2}, "debuggable ?address? ?size?");
+		CliConnection::DebugStream stream;
+		stream.debuggable = tokens[2].getString().str();
+		stream.address = (tokens.size() > 3) ? tokens[3].getInt(interp) : 0;
+		stream.size = (tokens.size() > 4) ? tokens[4].getInt(interp) : ~0u;
+		if (stream.size == 0) {
+			throw CommandException("Invalid size");
+		}
+		streams.push_back(std::move(stream));
+	} else if (tokens[1] == "remove") {
+		checkNumArgs(tokens, 3, Prefix{2}, "debuggable");
+		auto debuggable = tokens[2].getString();
+		auto it = ranges::remove_if(streams, [&](auto& s) {
+			return s.debuggable == debuggable;
+		});
+		if (it == end(streams)) {
+			throw CommandException("No stream for debuggable: ", debuggable);
+		}
+		streams.erase(it, end(streams));
+	} else if (tokens[1] == "clear") {
+		checkNumArgs(tokens, 2, Prefix{2}, "");
+		streams.clear();
+	} else if (tokens[1] == "list") {
+		checkNumArgs(tokens, 2, Prefix{2}, "");
+		for (auto& s : streams) {
+			TclObject entry = makeTclList(s.debuggable, s.address);
+			if (s.size != ~0u) entry.addListElement(s.size);
+			result.addListElement(entry);
+		}
+	} else {
+		throw SyntaxError();
+	}
+}
+
+string GlobalCommandController::DebugStreamCmd::help(const vector<string>& /*tokens*/) const
+{
+	return "Send the content of debuggables to an external application "
+	       "after every emulated frame, without going through Tcl. "
+	       "See doc/manual/openmsx-control.html.\n"
+	       "  openmsx_debug_stream add <debuggable> [<address> [<size>]]\n"
+	       "  openmsx_debug_stream remove <debuggable>\n"
+	       "  openmsx_debug_stream clear\n"
+	       "  openmsx_debug_stream list\n";
+}
+
+void GlobalCommandController::DebugStreamCmd::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const ops[] = { "add", "remove", "clear", "list" };
+		completeString(tokens, ops);
+	}
+}
+
+
+// class ProtocolCmd
+
+GlobalCommandController::ProtocolCmd::ProtocolCmd(CommandController& commandController_)
+	: Command(commandController_, "openmsx_protocol")
+{
+}
+
+CliConnection& GlobalCommandController::ProtocolCmd::getConnection()
+{
+	auto& controller = OUTER(GlobalCommandController, protocolCmd);
+	return checkConnection(controller.getConnection());
+}
+
+void GlobalCommandController::ProtocolCmd::execute(
+	span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{1, 2}, "?xml|binary?");
+	auto& connection = getConnection();
+	if (tokens.size() == 2) {
+		if (tokens[1] == "xml") {
+			connection.setProtocol(CliConnection::XML);
+		} else if (tokens[1] == "binary") {
+			connection.setProtocol(CliConnection::BINARY);
+		} else {
+			throw SyntaxError();
+		}
+	}
+	result = (connection.getProtocol() == CliConnection::XML)
+	       ? "xml" : "binary";
+}
+
+string GlobalCommandController::ProtocolCmd::help(const vector<string>& /*tokens*/) const
+{
+	return "Query or change the protocol of the connection with an external "
+	       "application. The reply of this command still uses the old "
+	       "protocol, wait for it before sending commands in the new "
+	       "protocol. See doc/manual/openmsx-control.html.\n"
+	       "  openmsx_protocol [xml|binary]\n";
+}
+
+void GlobalCommandController::ProtocolCmd::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const protocols[] = { "xml", "binary" };
+		completeString(tokens, protocols);
+	}
+}
+
+
+// class ScriptProfileCmd
+
+GlobalCommandController::ScriptProfileCmd::ScriptProfileCmd(CommandController& commandController_)
+	: Command(commandController_, "script_profile")
+{
+}
+
+void GlobalCommandController::ScriptProfileCmd::execute(
+	span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& interp = getInterpreter();
+	executeSubCommand(tokens[1].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			interp.setProfiling(true); },
+		"stop", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			interp.setProfiling(false); },
+		"reset", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			interp.resetScriptStats(); },
+		"status", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			result = interp.isProfiling(); },
+		"report", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			// most expensive scripts first
+			using Entry = std::pair<const string, Interpreter::ScriptStats>;
+			vector<const Entry*> entries;
+			for (auto& e : interp.getScriptStats()) entries.push_back(&e);
+			ranges::sort(entries, [](auto* x, auto* y) {
+				return x->second.time > y->second.time;
+			});
+			for (auto* e : entries) {
+				result.addListElement(makeTclList(
+					e->first, int64_t(e->second.count),
+					int64_t(e->second.time)));
+			}
+		});
+}
+
+string GlobalCommandController::ScriptProfileCmd::help(const vector<string>& /*tokens*/) const
+{
+	return "Measure the Tcl scripts that are executed by openMSX itself: "
+	       "callbacks, breakpoint/watchpoint/condition commands and "
+	       "after commands.\n"
+	       "  script_profile start   start recording\n"
+	       "  script_profile stop    stop recording (keeps the results)\n"
+	       "  script_profile reset   discard the results\n"
+	       "  script_profile status  is recording active\n"
+	       "  script_profile report  list of {name count time} entries, "
+	       "time in microseconds, most expensive first\n";
+}
+
+void GlobalCommandController::ScriptProfileCmd::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const ops[] = {
+			"start", "stop", "reset", "status", "report"
+		};
+		completeString(tokens, ops);
+	}
+}
+
+
 // Platform info
 
 GlobalCommandController::PlatformInfo::PlatformInfo(InfoCommand& openMSXInfoCommand_)
@@ -88,6 +88,7 @@ public:
 	SettingsConfig& getSettingsConfig() { return settingsConfig; }
 	SettingsManager& getSettingsManager() { return settingsConfig.getSettingsManager(); }
 	CliConnection* getConnection() const { return connection; }
+	Reactor& getReactor() { return reactor; }
 
 private:
 	void split(string_view str,
@@ -135,6 +136,31 @@ private:
 		CliConnection& getConnection();
 	} updateCmd;
 
+	struct DebugStreamCmd final : Command {
+		explicit DebugStreamCmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	private:
+		CliConnection& getConnection();
+	} debugStreamCmd;
+
+	struct ProtocolCmd final : Command {
+		explicit ProtocolCmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	private:
+		CliConnection& getConnection();
+	} protocolCmd;
+
+	struct ScriptProfileCmd final : Command {
+		explicit ScriptProfileCmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} scriptProfileCmd;
+
 	struct PlatformInfo final : InfoTopic {
 		explicit PlatformInfo(InfoCommand& openMSXInfoCommand);
 		void execute(span<const TclObject> tokens,
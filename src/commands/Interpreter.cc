@@ -8,6 +8,8 @@
 #include "InterpreterOutput.hh"
 #include "MSXCPUInterface.hh"
 #include "FileOperations.hh"
+#include "Timer.hh"
+#include "likely.hh"
 #include "ranges.hh"
 #include "span.hh"
 #include "stl.hh"
@@ -212,6 +214,31 @@ TclObject Interpreter::execute(const string& command)
 	return TclObject(Tcl_GetObjResult(interp));
 }
 
+TclObject Interpreter::executeProfiled(
+	TclObject& command, bool compile, string_view kind, string_view id)
+{
+	if (likely(!profiling)) {
+		return command.executeCommand(*this, compile);
+	}
+	// Only look up the entry afterwards, the script itself might reset
+	// the statistics.
+	auto record = [&](uint64_t start) {
+		auto& stats = scriptStats[strCat(
+			kind, ' ', id.empty() ? command.getString() : id)];
+		++stats.count;
+		stats.time += Timer::getTime() - start;
+	};
+	auto start = Timer::getTime();
+	try {
+		auto result = command.executeCommand(*this, compile);
+		record(start);
+		return result;
+	} catch (CommandException&) {
+		record(start);
+		throw;
+	}
+}
+
 TclObject Interpreter::executeFile(const string& filename)
 {
 	int success = Tcl_EvalFile(interp, filename.c_str());
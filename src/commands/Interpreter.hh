@@ -5,6 +5,8 @@
 #include "TclObject.hh"
 #include "string_view.hh"
 #include <tcl.h>
+#include <cstdint>
+#include <map>
 #include <string>
 
 namespace openmsx {
@@ -53,6 +55,25 @@ public:
 	
 	void wrongNumArgs(unsigned argc, span<const TclObject> tokens, const char* message);
 
+	/** Execute a script that openMSX itself triggers (a callback, the
+	  * command of a breakpoint, ...). Same as command.executeCommand(),
+	  * but when profiling is enabled, the number of executions and the
+	  * time spent are recorded under the name "<kind> <id>", or
+	  * "<kind> <script>" when 'id' is empty.
+	  */
+	TclObject executeProfiled(TclObject& command, bool compile,
+	                          string_view kind, string_view id = {});
+
+	struct ScriptStats {
+		uint64_t count = 0;
+		uint64_t time = 0; // in us
+	};
+	using ScriptStatsMap = std::map<std::string, ScriptStats>;
+	void setProfiling(bool enabled) { profiling = enabled; }
+	bool isProfiling() const { return profiling; }
+	const ScriptStatsMap& getScriptStats() const { return scriptStats; }
+	void resetScriptStats() { scriptStats.clear(); }
+
 private:
 	static int outputProc(ClientData clientData, const char* buf,
 	        int toWrite, int* errorCodePtr);
@@ -64,6 +85,8 @@ private:
 	static Tcl_ChannelType channelType;
 	Tcl_Interp* interp;
 	InterpreterOutput* output;
+	ScriptStatsMap scriptStats;
+	bool profiling = false;
 
 	friend class TclObject;
 };
@@ -17,6 +17,8 @@ using std::string;
 
 namespace openmsx {
 
+unsigned MSXCommandController::commandGeneration = 0;
+
 MSXCommandController::MSXCommandController(
 		GlobalCommandController& globalCommandController_,
 		Reactor& reactor_,
@@ -67,6 +69,7 @@ void MSXCommandController::registerCommand(Command& command, const string& str)
 	assert(!hasCommand(str));
 	assert(command.getName() == str);
 	commandMap.insert_noDuplicateCheck(&command);
+	++commandGeneration;
 
 	string fullname = getFullName(str);
 	globalCommandController.registerCommand(command, fullname);
@@ -80,6 +83,7 @@ void MSXCommandController::unregisterCommand(Command& command, string_view str)
 	assert(hasCommand(str));
 	assert(command.getName() == str);
 	commandMap.erase(str);
+	++commandGeneration;
 
 	globalCommandController.unregisterProxyCommand(str);
 	string fullname = getFullName(str);
@@ -45,6 +45,10 @@ public:
 
 	Command* findCommand(string_view name) const;
 
+	/** Changes whenever a command is (un)registered in any machine, so
+	  * that the result of findCommand() can be cached (see ProxyCmd). */
+	static unsigned getCommandGeneration() { return commandGeneration; }
+
 	/** Returns true iff the machine this controller belongs to is currently
 	  * active.
 	  */
@@ -74,6 +78,8 @@ public:
 private:
 	std::string getFullName(string_view name);
 
+	static unsigned commandGeneration;
+
 	// MSXEventListener
 	void signalMSXEvent(const std::shared_ptr<const Event>& event,
 	                    EmuTime::param time) override;
@@ -24,9 +24,21 @@ Command* ProxyCmd::getMachineCommand() const
 	return motherBoard->getMSXCommandController().findCommand(getName());
 }
 
+Command* ProxyCmd::getCachedMachineCommand()
+{
+	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
+	unsigned generation = MSXCommandController::getCommandGeneration();
+	if ((motherBoard != cachedBoard) || (generation != cachedGeneration)) {
+		cachedCommand = getMachineCommand();
+		cachedBoard = motherBoard;
+		cachedGeneration = generation;
+	}
+	return cachedCommand;
+}
+
 void ProxyCmd::execute(span<const TclObject> tokens, TclObject& result)
 {
-	if (Command* command = getMachineCommand()) {
+	if (Command* command = getCachedMachineCommand()) {
 		if (!command->isAllowedInEmptyMachine()) {
 			auto controller = checked_cast<MSXCommandController*>(
 				&command->getCommandController());
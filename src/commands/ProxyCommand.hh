@@ -6,6 +6,7 @@
 
 namespace openmsx {
 
+class MSXMotherBoard;
 class Reactor;
 
 class ProxyCmd final : public Command
@@ -18,7 +19,15 @@ public:
 	void tabCompletion(std::vector<std::string>& tokens) const override;
 private:
 	Command* getMachineCommand() const;
+	Command* getCachedMachineCommand();
+
 	Reactor& reactor;
+
+	// Scripts often call the same command many times in a row, remember
+	// the last lookup (valid while board and generation don't change).
+	MSXMotherBoard* cachedBoard = nullptr;
+	unsigned cachedGeneration = 0;
+	Command* cachedCommand = nullptr;
 };
 
 } // namespace openmsx
@@ -1,6 +1,7 @@
 #include "TclCallback.hh"
 #include "CommandController.hh"
 #include "CliComm.hh"
+#include "Interpreter.hh"
 #include "CommandException.hh"
 #include "StringSetting.hh"
 #include <iostream>
@@ -85,7 +86,11 @@ TclObject TclCallback::execute(string_view arg1, string_view arg2)
 TclObject TclCallback::executeCommon(TclObject& command)
 {
 	try {
-		return command.executeCommand(callbackSetting.getInterpreter());
+		// 'command' is a pure list, Tcl invokes that directly (without
+		// parsing or compiling), so there's nothing to gain from
+		// keeping compiled byte-code here.
+		return callbackSetting.getInterpreter().executeProfiled(
+			command, false, "callback", getSetting().getFullName());
 	} catch (CommandException& e) {
 		string message = strCat(
 			"Error executing callback function \"",
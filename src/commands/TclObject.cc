@@ -11,6 +11,20 @@ static void throwException(Tcl_Interp* interp)
 	throw CommandException(message);
 }
 
+Tcl_Obj* TclObject::cachedInt(unsigned i)
+{
+	assert(i < NUM_CACHED_INTS);
+	// The cache holds a reference, so these objects are never freed (and
+	// always shared).
+	static Tcl_Obj* cache[NUM_CACHED_INTS] = {};
+	auto*& o = cache[i];
+	if (!o) {
+		o = Tcl_NewIntObj(int(i));
+		Tcl_IncrRefCount(o);
+	}
+	return o;
+}
+
 void TclObject::addListElement(Tcl_Obj* element)
 {
 	// Although it's theoretically possible that Tcl_ListObjAppendElement()
@@ -202,10 +202,14 @@ private:
 		return Tcl_NewBooleanObj(b);
 	}
 	static Tcl_Obj* newObj(int i) {
-		return Tcl_NewIntObj(i);
+		return (unsigned(i) < NUM_CACHED_INTS) ? cachedInt(i)
+		                                       : Tcl_NewIntObj(i);
 	}
 	static Tcl_Obj* newObj(unsigned u) {
-		return Tcl_NewIntObj(u);
+		return (u < NUM_CACHED_INTS) ? cachedInt(u) : Tcl_NewIntObj(u);
+	}
+	static Tcl_Obj* newObj(int64_t i) {
+		return Tcl_NewWideIntObj(i);
 	}
 	static Tcl_Obj* newObj(float f) {
 		return Tcl_NewDoubleObj(double(f));
@@ -238,6 +242,9 @@ private:
 	void assign(unsigned u) {
 		Tcl_SetIntObj(obj, u);
 	}
+	void assign(int64_t i) {
+		Tcl_SetWideIntObj(obj, i);
+	}
 	void assign(float f) {
 		Tcl_SetDoubleObj(obj, double(f));
 	}
@@ -262,6 +269,12 @@ private:
 		addListElementsImpl(objc, objv);
 	}
 
+	// Small integers (e.g. bytes read from a debuggable) are very common
+	// values. All TclObjects with such a value share one (never modified,
+	// because it's shared) Tcl_Obj per value, this avoids allocating.
+	static const unsigned NUM_CACHED_INTS = 256;
+	static Tcl_Obj* cachedInt(unsigned i);
+
 	void addListElement(Tcl_Obj* element);
 	void addListElementsImpl(int objc, Tcl_Obj* const* objv);
 	void addListElementsImpl(std::initializer_list<Tcl_Obj*> l);
@@ -9,12 +9,20 @@
 #include "MSXCPUInterface.hh"
 #include "CommandController.hh"
 #include "DeviceFactory.hh"
+#include "File.hh"
+#include "FileContext.hh"
+#include "Filename.hh"
+#include "FilePool.hh"
+#include "Reactor.hh"
 #include "TclArgParser.hh"
 #include "serialize.hh"
 #include "serialize_stl.hh"
+#include "hash_map.hh"
+#include "Thread.hh"
 #include "unreachable.hh"
 #include "view.hh"
 #include "xrange.hh"
+#include "xxhash.hh"
 #include <cassert>
 #include <iostream>
 #include <memory>
@@ -197,6 +205,35 @@ static XMLElement loadHelper(const string& filename)
 	}
 }
 
+// Parsed machine and extension configs, so that instantiating the same
+// hardware again (e.g. for a reset via 'machine' or 'fork_machine') doesn't
+// read and parse the XML file again. An entry is only used as long as the
+// file's modification time and size are unchanged.
+struct CachedConfig {
+	time_t mtime;
+	int64_t size;
+	XMLElement config;
+};
+static hash_map<string, CachedConfig, XXHasher> configCache;
+
+static XMLElement loadCachedHelper(const string& filename)
+{
+	assert(Thread::isMainThread());
+	FileOperations::Stat st;
+	if (!FileOperations::getStat(filename, st)) {
+		return loadHelper(filename); // reports the error
+	}
+	auto mtime = FileOperations::getModificationDate(st);
+	auto it = configCache.find(filename);
+	if ((it != end(configCache)) &&
+	    (it->second.mtime == mtime) && (it->second.size == int64_t(st.st_size))) {
+		return it->second.config; // copy
+	}
+	auto config = loadHelper(filename);
+	configCache[filename] = CachedConfig{mtime, int64_t(st.st_size), config};
+	return config;
+}
+
 static string getFilename(string_view type, string_view name)
 {
 	auto context = systemFileContext();
@@ -224,7 +261,7 @@ XMLElement HardwareConfig::loadConfig(string_view type, string_view name)
 void HardwareConfig::load(string_view type)
 {
 	string filename = getFilename(type, hwName);
-	setConfig(loadHelper(filename));
+	setConfig(loadCachedHelper(filename));
 
 	assert(!userName.empty());
 	const auto& dirname = FileOperations::getDirName(filename);
@@ -317,8 +354,55 @@ byte HardwareConfig::parseSlotMap() const
 	return initialPrimarySlots;
 }
 
+// Collect the files of the <rom> tags that are referenced by name, in the
+// same order as Rom::init() tries them. Roms that are only referenced by
+// sha1sum are located via the FilePool during device construction.
+static void collectRomFiles(const XMLElement& elem, const FileContext& context,
+                            vector<File>& files)
+{
+	for (auto& c : elem.getChildren()) {
+		if (c.getName() != "rom") {
+			collectRomFiles(c, context, files);
+			continue;
+		}
+		if (c.findChild("firstblock")) continue; // part of another rom
+		File file;
+		if (auto* resolved = c.findChild("resolvedFilename")) {
+			try {
+				file = File(resolved->getData());
+			} catch (MSXException&) {
+				// ignore
+			}
+		}
+		for (auto* f : c.getChildren("filename")) {
+			if (file.is_open()) break;
+			try {
+				file = File(Filename(f->getData(), context));
+			} catch (MSXException&) {
+				// ignore
+			}
+		}
+		if (file.is_open()) files.push_back(std::move(file));
+	}
+}
+
+void HardwareConfig::prefetchRoms()
+{
+	// A machine has a dozen or more roms. Reading and hashing them one by
+	// one during device construction takes a noticeable amount of time,
+	// so do that for all of them in parallel first. The devices are still
+	// constructed one by one, but then the sha1sums come from the cache
+	// and the file content is in the OS cache. Errors are ignored here,
+	// they're reported when the device is constructed.
+	vector<File> files;
+	collectRomFiles(getDevices(), getFileContext(), files);
+	if (files.size() < 2) return;
+	motherBoard.getReactor().getFilePool().calcSha1Sums(files);
+}
+
 void HardwareConfig::createDevices()
 {
+	prefetchRoms();
 	createDevices(getDevices(), nullptr, nullptr);
 }
 
@@ -451,7 +535,9 @@ void HardwareConfig::serialize(Archive& ar, unsigned version)
 	}
 	// only (polymorphically) initialize devices, they are already created
 	for (auto& d : devices) {
+		ar.beginStats(d->getName());
 		ar.serializePolymorphic("device", *d);
+		ar.endStats();
 	}
 	ar.serialize("name", name);
 }
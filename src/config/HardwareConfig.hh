@@ -68,6 +68,7 @@ private:
 	void load(string_view type);
 
 	const XMLElement& getDevices() const;
+	void prefetchRoms();
 	void createDevices(const XMLElement& elem,
 	                   const XMLElement* primary, const XMLElement* secondary);
 	void createExternalSlot(int ps);
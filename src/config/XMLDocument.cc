@@ -0,0 +1,165 @@
+#include "XMLDocument.hh"
+#include "XMLException.hh"
+#include "StringOp.hh"
+#include "rapidsax.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace openmsx {
+
+const string_view* XMLDocument::Node::findAttribute(string_view attName) const
+{
+	for (auto* a = firstAttribute; a; a = a->next) {
+		if (a->name == attName) return &a->value;
+	}
+	return nullptr;
+}
+
+bool XMLDocument::Node::findAttributeInt(string_view attName,
+                                         unsigned& result) const
+{
+	if (auto* value = findAttribute(attName)) {
+		result = StringOp::stringToInt(value->str());
+		return true;
+	} else {
+		return false;
+	}
+}
+
+const XMLDocument::Node* XMLDocument::Node::findNextChild(
+	string_view childName, const Node*& from) const
+{
+	for (auto* c = from; c; c = c->nextSibling) {
+		if (c->name == childName) {
+			from = c->nextSibling;
+			return c;
+		}
+	}
+	for (auto* c = firstChild; c != from; c = c->nextSibling) {
+		if (c->name == childName) {
+			from = c->nextSibling;
+			return c;
+		}
+	}
+	return nullptr;
+}
+
+class XMLDocument::Parser : public rapidsax::NullHandler
+{
+public:
+	explicit Parser(XMLDocument& doc_) : doc(doc_) {}
+
+	// rapidsax handler interface
+	void start(string_view name) { doc.start(name); }
+	void attribute(string_view name, string_view value) {
+		doc.attribute(name, value);
+	}
+	void text(string_view txt) { doc.text(txt); }
+	void stop() { doc.stop(); }
+	void doctype(string_view txt) { doc.doctype(txt); }
+
+private:
+	XMLDocument& doc;
+};
+
+void XMLDocument::parse(MemBuffer<char> buf)
+{
+	buffer = std::move(buf);
+	Parser parser(*this);
+	rapidsax::parse<rapidsax::trimWhitespace>(parser, buffer.data());
+	open.clear();
+}
+
+template<typename T> T* XMLDocument::allocate()
+{
+	static_assert(std::is_trivially_destructible<T>::value,
+	              "arena objects are never destructed");
+	const size_t align = alignof(T);
+	auto addr = reinterpret_cast<uintptr_t>(blockPtr);
+	size_t pad = (align - (addr & (align - 1))) & (align - 1);
+	if ((pad + sizeof(T)) > blockLeft) {
+		blocks.emplace_back(new char[nextBlockSize]);
+		blockPtr = blocks.back().get();
+		blockLeft = nextBlockSize;
+		nextBlockSize = std::min<size_t>(2 * nextBlockSize, 4 * 1024 * 1024);
+		pad = 0; // new[] returns memory that is suitably aligned
+	}
+	T* result = new (blockPtr + pad) T();
+	blockPtr  += pad + sizeof(T);
+	blockLeft -= pad + sizeof(T);
+	return result;
+}
+
+void XMLDocument::start(string_view name)
+{
+	auto* node = allocate<Node>();
+	node->name = name;
+	if (open.empty()) {
+		if (root) throw XMLException("Multiple root elements.");
+		root = node;
+	} else {
+		auto& parent = open.back();
+		if (parent.lastChild) {
+			parent.lastChild->nextSibling = node;
+		} else {
+			parent.node->firstChild = node;
+		}
+		parent.lastChild = node;
+		++parent.node->numChildren_;
+	}
+	open.push_back({node, nullptr, nullptr});
+}
+
+void XMLDocument::attribute(string_view name, string_view value)
+{
+	auto& current = open.back();
+	if (current.node->findAttribute(name)) {
+		throw XMLException(
+			"Found duplicate attribute \"", name, "\" in <",
+			current.node->name, ">.");
+	}
+	auto* attr = allocate<Attribute>();
+	attr->name = name;
+	attr->value = value;
+	if (current.lastAttribute) {
+		current.lastAttribute->next = attr;
+	} else {
+		current.node->firstAttribute = attr;
+	}
+	current.lastAttribute = attr;
+}
+
+void XMLDocument::text(string_view txt)
+{
+	auto* node = open.back().node;
+	if (node->hasChildren()) {
+		// no mixed-content elements
+		throw XMLException(
+			"Mixed text+subtags in <", node->name, ">: \"", txt, "\".");
+	}
+	node->data = txt;
+}
+
+void XMLDocument::stop()
+{
+	open.pop_back();
+}
+
+void XMLDocument::doctype(string_view txt)
+{
+	auto pos1 = txt.find(" SYSTEM ");
+	if (pos1 == string_view::npos) return;
+	if ((pos1 + 8) >= txt.size()) return;
+	char q = txt[pos1 + 8];
+	if ((q != '"') && (q != '\'')) return;
+	auto t = txt.substr(pos1 + 9);
+	auto pos2 = t.find(q);
+	if (pos2 == string_view::npos) return;
+
+	systemID = t.substr(0, pos2);
+}
+
+} // namespace openmsx
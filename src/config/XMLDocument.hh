@@ -0,0 +1,111 @@
+#ifndef XMLDOCUMENT_HH
+#define XMLDOCUMENT_HH
+
+#include "MemBuffer.hh"
+#include "string_view.hh"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace openmsx {
+
+/** Read-only XML DOM that is cheap to build, for loading big documents like
+  * savestates.
+  *
+  * The source text is parsed in place (see rapidsax), all names, data and
+  * attribute values are string_views into that buffer. The nodes and
+  * attributes themselves are allocated from an arena of a few big blocks.
+  * So building the tree takes a handful of allocations, independent of the
+  * number of nodes (XMLElement takes several allocations per node). Use
+  * XMLLoader::loadDocument() to create one.
+  */
+class XMLDocument
+{
+public:
+	struct Attribute {
+		string_view name;
+		string_view value;
+		const Attribute* next = nullptr;
+	};
+
+	class Node {
+	public:
+		string_view getName() const { return name; }
+		string_view getData() const { return data; }
+
+		const Node* getFirstChild() const { return firstChild; }
+		const Node* getNextSibling() const { return nextSibling; }
+		bool hasChildren() const { return firstChild != nullptr; }
+		unsigned numChildren() const { return numChildren_; }
+
+		const Attribute* getFirstAttribute() const { return firstAttribute; }
+		/** Returns ptr to attribute value, or nullptr when not found. */
+		const string_view* findAttribute(string_view attName) const;
+		bool findAttributeInt(string_view attName, unsigned& result) const;
+
+		/** Like XMLElement::findNextChild(), but with a node instead of
+		  * an index as position: search for the first child with the
+		  * given name starting at 'from' (nullptr means the end) and
+		  * wrapping around. On success 'from' moves past the result. */
+		const Node* findNextChild(string_view childName,
+		                          const Node*& from) const;
+
+		/** Used by XmlInputArchive to mark a node as processed. */
+		void clearName() { name = string_view(); }
+
+	private:
+		friend class XMLDocument;
+
+		string_view name;
+		string_view data;
+		Node* firstChild = nullptr;
+		Node* nextSibling = nullptr;
+		const Attribute* firstAttribute = nullptr;
+		unsigned numChildren_ = 0;
+	};
+
+	XMLDocument() = default;
+	XMLDocument(XMLDocument&&) = default;
+	XMLDocument& operator=(XMLDocument&&) = default;
+
+	/** Parse the given XML text in place, the document takes ownership
+	  * of the buffer. The text must be zero-terminated and the buffer must
+	  * have rapidsax::EXTRA_BUFFER_SPACE bytes of room for that.
+	  * Throws rapidsax::ParseError or XMLException. */
+	void parse(MemBuffer<char> buf);
+
+	/** The root node, nullptr when the document is empty. */
+	const Node* getRoot() const { return root; }
+	/** The system ID of the DOCTYPE declaration (or empty). */
+	string_view getSystemID() const { return systemID; }
+
+private:
+	class Parser;
+
+	template<typename T> T* allocate();
+	void start(string_view name);
+	void attribute(string_view name, string_view value);
+	void text(string_view txt);
+	void stop();
+	void doctype(string_view txt);
+
+	MemBuffer<char> buffer;
+	std::vector<std::unique_ptr<char[]>> blocks;
+	char* blockPtr = nullptr;
+	size_t blockLeft = 0;
+	size_t nextBlockSize = 16 * 1024;
+
+	Node* root = nullptr;
+	string_view systemID;
+
+	struct Open {
+		Node* node;
+		Node* lastChild;
+		Attribute* lastAttribute;
+	};
+	std::vector<Open> open; // only used while building
+};
+
+} // namespace openmsx
+
+#endif
@@ -16,6 +16,25 @@ using std::string;
 
 namespace openmsx {
 
+XMLElement::XMLElement(const XMLDocument::Node& node)
+	: name(node.getName().str()), data(node.getData().str())
+{
+	// The number of attributes and children is known upfront, so each
+	// vector is allocated only once (and children are never moved).
+	unsigned numAttributes = 0;
+	for (auto* a = node.getFirstAttribute(); a; a = a->next) {
+		++numAttributes;
+	}
+	attributes.reserve(numAttributes);
+	for (auto* a = node.getFirstAttribute(); a; a = a->next) {
+		attributes.emplace_back(a->name.str(), a->value.str());
+	}
+	children.reserve(node.numChildren());
+	for (auto* c = node.getFirstChild(); c; c = c->getNextSibling()) {
+		children.emplace_back(*c);
+	}
+}
+
 XMLElement& XMLElement::addChild(string childName)
 {
 	children.emplace_back(std::move(childName));
@@ -1,6 +1,7 @@
 #ifndef XMLELEMENT_HH
 #define XMLELEMENT_HH
 
+#include "XMLDocument.hh"
 #include "serialize_meta.hh"
 #include <utility>
 #include <string>
@@ -25,6 +26,8 @@ public:
 		: name(std::move(name_)) {}
 	XMLElement(std::string name_, std::string data_)
 		: name(std::move(name_)), data(std::move(data_)) {}
+	// Deep copy of a (read-only) document node.
+	explicit XMLElement(const XMLDocument::Node& node);
 
 	// name
 	const std::string& getName() const { return name; }
@@ -1,5 +1,4 @@
 #include "XMLLoader.hh"
-#include "XMLElement.hh"
 #include "XMLException.hh"
 #include "File.hh"
 #include "FileException.hh"
@@ -9,26 +8,7 @@
 namespace openmsx {
 namespace XMLLoader {
 
-class XMLElementParser : public rapidsax::NullHandler
-{
-public:
-	// rapidsax handler interface
-	void start(string_view name);
-	void attribute(string_view name, string_view value);
-	void text(string_view txt);
-	void stop();
-	void doctype(string_view txt);
-
-	string_view getSystemID() const { return systemID; }
-	XMLElement& getRoot() { return root; }
-
-private:
-	XMLElement root;
-	std::vector<XMLElement*> current;
-	string_view systemID;
-};
-
-XMLElement load(string_view filename, string_view systemID)
+XMLDocument loadDocument(string_view filename, string_view systemID)
 {
 	MemBuffer<char> buf;
 	try {
@@ -41,79 +21,32 @@ XMLElement load(string_view filename, string_view systemID)
 		throw XMLException(filename, ": failed to read: ", e.getMessage());
 	}
 
-	XMLElementParser handler;
+	XMLDocument doc;
 	try {
-		rapidsax::parse<rapidsax::trimWhitespace>(handler, buf.data());
+		doc.parse(std::move(buf));
 	} catch (rapidsax::ParseError& e) {
 		throw XMLException(filename, ": Document parsing failed: ", e.what());
 	}
-	auto& root = handler.getRoot();
-	if (root.getName().empty()) {
+	if (!doc.getRoot()) {
 		throw XMLException(filename,
 			": Document doesn't contain mandatory root Element");
 	}
-	if (handler.getSystemID().empty()) {
+	if (doc.getSystemID().empty()) {
 		throw XMLException(filename, ": Missing systemID.\n"
 			"You're probably using an old incompatible file format.");
 	}
-	if (handler.getSystemID() != systemID) {
+	if (doc.getSystemID() != systemID) {
 		throw XMLException(filename, ": systemID doesn't match "
-			"(expected ", systemID, ", got ", handler.getSystemID(), ")\n"
+			"(expected ", systemID, ", got ", doc.getSystemID(), ")\n"
 			"You're probably using an old incompatible file format.");
 	}
-	return std::move(root);
-}
-
-void XMLElementParser::start(string_view name)
-{
-	XMLElement* newElem;
-	if (!current.empty()) {
-		newElem = &current.back()->addChild(name.str());
-	} else {
-		root.setName(name.str());
-		newElem = &root;
-	}
-	current.push_back(newElem);
-}
-
-void XMLElementParser::attribute(string_view name, string_view value)
-{
-	if (current.back()->hasAttribute(name)) {
-		throw XMLException(
-			"Found duplicate attribute \"", name, "\" in <",
-			current.back()->getName(), ">.");
-	}
-	current.back()->addAttribute(name.str(), value.str());
-}
-
-void XMLElementParser::text(string_view txt)
-{
-	if (current.back()->hasChildren()) {
-		// no mixed-content elements
-		throw XMLException(
-			"Mixed text+subtags in <", current.back()->getName(),
-			">: \"", txt, "\".");
-	}
-	current.back()->setData(txt.str());
+	return doc;
 }
 
-void XMLElementParser::stop()
-{
-	current.pop_back();
-}
-
-void XMLElementParser::doctype(string_view txt)
+XMLElement load(string_view filename, string_view systemID)
 {
-	auto pos1 = txt.find(" SYSTEM ");
-	if (pos1 == string_view::npos) return;
-	if ((pos1 + 8) >= txt.size()) return;
-	char q = txt[pos1 + 8];
-	if ((q != '"') && (q != '\'')) return;
-	auto t = txt.substr(pos1 + 9);
-	auto pos2 = t.find(q);
-	if (pos2 == string_view::npos) return;
-
-	systemID = t.substr(0, pos2);
+	auto doc = loadDocument(filename, systemID);
+	return XMLElement(*doc.getRoot());
 }
 
 } // namespace XMLLoader
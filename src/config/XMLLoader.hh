@@ -1,11 +1,17 @@
 #ifndef XMLLOADER_HH
 #define XMLLOADER_HH
 
+#include "XMLDocument.hh"
 #include "XMLElement.hh"
 
 namespace openmsx {
 namespace XMLLoader {
 
+	/** Load and parse the given file, the root element must have the given
+	  * systemID. Throws XMLException on errors. */
+	XMLDocument loadDocument(string_view filename, string_view systemID);
+
+	/** Same as above, but converted to a (modifiable) XMLElement tree. */
 	XMLElement load(string_view filename, string_view systemID);
 
 } // namespace XMLLoader
@@ -107,12 +107,19 @@ void OSDImageBasedWidget::setRGBA(const uint32_t newRGBA[4])
 		// not changed
 		return;
 	}
-	invalidateLocal();
+	if (isImageColorChange(newRGBA)) {
+		invalidateLocal();
+	}
 	for (auto i : xrange(4)) {
 		rgba[i] = newRGBA[i];
 	}
 }
 
+bool OSDImageBasedWidget::isImageColorChange(const uint32_t* /*newRGBA*/) const
+{
+	return true;
+}
+
 static void set4(const uint32_t rgba[4], uint32_t mask, unsigned shift, TclObject& result)
 {
 	if ((rgba[0] == rgba[1]) && (rgba[0] == rgba[2]) && (rgba[0] == rgba[3])) {
@@ -33,6 +33,10 @@ protected:
 	void paintGL (OutputSurface& output) override;
 	virtual std::unique_ptr<BaseImage> createSDL(OutputSurface& output) = 0;
 	virtual std::unique_ptr<BaseImage> createGL (OutputSurface& output) = 0;
+	/** Does changing the colors to 'newRGBA' require a new image? By
+	  * default it does, subclasses that only apply (part of) the colors
+	  * while drawing can avoid rendering the image again. */
+	virtual bool isImageColorChange(const uint32_t newRGBA[4]) const;
 
 	void setError(std::string message);
 	bool hasError() const { return error; }
@@ -1,13 +1,16 @@
 #include "OSDRectangle.hh"
 #include "SDLImage.hh"
+#include "SDLSurfacePtr.hh"
 #include "CommandException.hh"
 #include "FileContext.hh"
 #include "FileOperations.hh"
 #include "TclObject.hh"
 #include "stl.hh"
+#include "build-info.hh"
 #include "components.hh"
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <memory>
 #if COMPONENT_GL
 #include "GLImage.hh"
@@ -30,7 +33,7 @@ vector<string_view> OSDRectangle::getProperties() const
 {
 	auto result = OSDImageBasedWidget::getProperties();
 	static const char* const vals[] = {
-		"-w", "-h", "-relw", "-relh", "-scale", "-image",
+		"-w", "-h", "-relw", "-relh", "-scale", "-image", "-imagedata",
 		"-bordersize", "-relbordersize", "-borderrgba",
 	};
 	append(result, vals);
@@ -79,6 +82,33 @@ void OSDRectangle::setProperty(
 			imageName = val;
 			invalidateRecursive();
 		}
+	} else if (propName == "-imagedata") {
+		// {<width> <height> <pixels>}, pixels are RGBA (4 bytes each)
+		// and usually directly come from a command like 'vdp_image'.
+		ivec2 newSize;
+		TclObject newData;
+		if (value.getListLength(interp) != 0) {
+			if (value.getListLength(interp) != 3) {
+				throw CommandException(
+					"Expected a list {<width> <height> <pixels>}");
+			}
+			newSize = ivec2(value.getListIndex(interp, 0).getInt(interp),
+			                value.getListIndex(interp, 1).getInt(interp));
+			newData = value.getListIndex(interp, 2);
+			if ((newSize[0] <= 0) || (newSize[1] <= 0) ||
+			    (newData.getBinary().size() !=
+			     size_t(newSize[0]) * newSize[1] * 4)) {
+				throw CommandException(
+					"Image data doesn't match dimensions");
+			}
+		}
+		imageData = newData;
+		if (imageDataSize != newSize) {
+			imageDataSize = newSize;
+			invalidateRecursive();
+		} else {
+			invalidateLocal();
+		}
 	} else if (propName == "-bordersize") {
 		float newSize = value.getDouble(interp);
 		if (borderSize != newSize) {
@@ -116,6 +146,12 @@ void OSDRectangle::getProperty(string_view propName, TclObject& result) const
 		result = scale;
 	} else if (propName == "-image") {
 		result = imageName;
+	} else if (propName == "-imagedata") {
+		result = TclObject();
+		if (imageDataSize != ivec2()) {
+			result.addListElement(imageDataSize[0], imageDataSize[1],
+			                      imageData);
+		}
 	} else if (propName == "-bordersize") {
 		result = borderSize;
 	} else if (propName == "-relbordersize") {
@@ -139,7 +175,7 @@ bool OSDRectangle::takeImageDimensions() const
 
 vec2 OSDRectangle::getSize(const OutputSurface& output) const
 {
-	if (!imageName.empty() && image && takeImageDimensions()) {
+	if (hasImage() && image && takeImageDimensions()) {
 		return vec2(image->getSize());
 	} else {
 		return (size * float(getScaleFactor(output)) * scale) +
@@ -153,9 +189,35 @@ uint8_t OSDRectangle::getFadedAlpha() const
 	return uint8_t(255 * getRecursiveFadeValue());
 }
 
+SDLSurfacePtr OSDRectangle::createImageDataSurface() const
+{
+	SDLSurfacePtr surface(imageDataSize[0], imageDataSize[1], 32,
+		OPENMSX_BIGENDIAN ? 0xFF000000 : 0x000000FF,
+		OPENMSX_BIGENDIAN ? 0x00FF0000 : 0x0000FF00,
+		OPENMSX_BIGENDIAN ? 0x0000FF00 : 0x00FF0000,
+		OPENMSX_BIGENDIAN ? 0x000000FF : 0xFF000000);
+	auto pixels = imageData.getBinary();
+	size_t lineSize = imageDataSize[0] * 4;
+	for (int y = 0; y < imageDataSize[1]; ++y) {
+		memcpy(static_cast<uint8_t*>(surface->pixels) + y * surface->pitch,
+		       &pixels[y * lineSize], lineSize);
+	}
+	return surface;
+}
+
 template <typename IMAGE> std::unique_ptr<BaseImage> OSDRectangle::create(
 	OutputSurface& output)
 {
+	if (imageName.empty() && (imageDataSize != ivec2())) {
+		// Like an image file, but the size is in (unscaled) OSD
+		// coordinates. '-image' has priority over '-imagedata'.
+		ivec2 iSize = takeImageDimensions()
+		            ? round(vec2(imageDataSize) *
+		                    (getScaleFactor(output) * scale))
+		            : round(getSize(output));
+		return std::make_unique<IMAGE>(
+			output, createImageDataSurface(), iSize);
+	}
 	if (imageName.empty()) {
 		bool constAlpha = hasConstantAlpha();
 		if (constAlpha && ((getRGBA(0) & 0xff) == 0) &&
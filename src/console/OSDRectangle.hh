@@ -4,6 +4,8 @@
 #include "OSDImageBasedWidget.hh"
 #include <memory>
 
+class SDLSurfacePtr;
+
 namespace openmsx {
 
 class BaseImage;
@@ -21,6 +23,10 @@ public:
 
 private:
 	bool takeImageDimensions() const;
+	bool hasImage() const {
+		return !imageName.empty() || (imageDataSize != gl::ivec2());
+	}
+	SDLSurfacePtr createImageDataSurface() const;
 
 	gl::vec2 getSize(const OutputSurface& output) const override;
 	uint8_t getFadedAlpha() const override;
@@ -30,6 +36,8 @@ private:
 		OutputSurface& output);
 
 	std::string imageName;
+	TclObject imageData; // RGBA pixels, see '-imagedata'
+	gl::ivec2 imageDataSize;
 	gl::vec2 size, relSize;
 	float scale, borderSize, relBorderSize;
 	unsigned borderRGBA;
@@ -51,8 +51,7 @@ void OSDText::setProperty(
 		string_view val = value.getString();
 		if (text != val) {
 			text = val.str();
-			// note: don't invalidate font (don't reopen font file)
-			OSDImageBasedWidget::invalidateLocal();
+			invalidateLocal();
 			invalidateChildren();
 		}
 	} else if (propName == "-font") {
@@ -137,10 +136,11 @@ void OSDText::getProperty(string_view propName, TclObject& result) const
 	}
 }
 
-void OSDText::invalidateLocal()
+bool OSDText::isImageColorChange(const uint32_t newRGBA[4]) const
 {
-	font = TTFFont(); // clear font
-	OSDImageBasedWidget::invalidateLocal();
+	// The text is rendered in the RGB color of the first corner, alpha
+	// (and the other corners) only matter while drawing the image.
+	return (getRGBA(0) & 0xffffff00) != (newRGBA[0] & 0xffffff00);
 }
 
 
@@ -172,12 +172,18 @@ template <typename IMAGE> std::unique_ptr<BaseImage> OSDText::create(
 		return std::make_unique<IMAGE>(output, ivec2(), 0);
 	}
 	int scale = getScaleFactor(output);
-	if (font.empty()) {
+	int ptSize = size * scale;
+	// Only (re)open the font when it actually changed. Widgets get
+	// invalidated for many other reasons (e.g. a new text or color) and
+	// reopening would decompress and parse the font file again.
+	if (font.empty() || (openedFontfile != fontfile) || (openedPtSize != ptSize)) {
 		try {
 			string file = systemFileContext().resolve(fontfile);
-			int ptSize = size * scale;
 			font = TTFFont(file, ptSize);
+			openedFontfile = fontfile;
+			openedPtSize = ptSize;
 		} catch (MSXException& e) {
+			font = TTFFont();
 			throw MSXException("Couldn't open font: ", e.getMessage());
 		}
 	}
@@ -19,7 +19,7 @@ public:
 	string_view getType() const override;
 
 private:
-	void invalidateLocal() override;
+	bool isImageColorChange(const uint32_t newRGBA[4]) const override;
 	gl::vec2 getSize(const OutputSurface& output) const override;
 	uint8_t getFadedAlpha() const override;
 	std::unique_ptr<BaseImage> createSDL(OutputSurface& output) override;
@@ -43,6 +43,8 @@ private:
 	std::string text;
 	std::string fontfile;
 	TTFFont font;
+	std::string openedFontfile; // 'font' was opened from this file ..
+	int openedPtSize = 0;       // .. with this point size
 	int size;
 	WrapMode wrapMode;
 	float wrapw, wraprelw;
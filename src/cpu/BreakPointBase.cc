@@ -1,17 +1,33 @@
 #include "BreakPointBase.hh"
 #include "CommandException.hh"
 #include "GlobalCliComm.hh"
+#include "Interpreter.hh"
 #include "ScopedAssign.hh"
 
 namespace openmsx {
 
-bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
+BreakPointBase::BreakPointBase(TclObject command_, TclObject condition_, bool once_)
+	: command(std::move(command_))
+	, condition(std::move(condition_))
+	, once(once_)
+{
+	auto cond = condition.getString();
+	if (!cond.empty()) {
+		compiled = CompiledCondition::compile(cond);
+	}
+}
+
+bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+                            CompiledCondition::Context* context) const
 {
 	if (condition.getString().empty()) {
 		// unconditional bp
 		return true;
 	}
 	try {
+		if (compiled && context) {
+			return compiled->evaluate(*context);
+		}
 		return condition.evalBool(interp);
 	} catch (CommandException& e) {
 		cliComm.printWarning(e.getMessage());
@@ -19,16 +35,18 @@ bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
 	}
 }
 
-void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp)
+void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+                                     CompiledCondition::Context* context)
 {
 	if (executing) {
 		// no recursive execution
 		return;
 	}
 	ScopedAssign<bool> sa(executing, true);
-	if (isTrue(cliComm, interp)) {
+	if (isTrue(cliComm, interp, context)) {
 		try {
-			command.executeCommand(interp, true); // compile command
+			// compile command, it's executed over and over again
+			interp.executeProfiled(command, true, "breakpoint");
 		} catch (CommandException& e) {
 			cliComm.printWarning(e.getMessage());
 		}
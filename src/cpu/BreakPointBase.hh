@@ -1,8 +1,10 @@
 #ifndef BREAKPOINTBASE_HH
 #define BREAKPOINTBASE_HH
 
+#include "CompiledCondition.hh"
 #include "TclObject.hh"
 #include "string_view.hh"
+#include <memory>
 
 namespace openmsx {
 
@@ -20,22 +22,28 @@ public:
 	TclObject getCommandObj()   const { return command; }
 	bool onlyOnce() const { return once; }
 
-	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp);
+	/** Evaluate the condition and, if true, execute the command.
+	  * When a context is given and the condition could be compiled, the
+	  * condition is evaluated natively instead of via Tcl.
+	  */
+	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+	                     CompiledCondition::Context* context = nullptr);
 
 protected:
 	// Note: we require GlobalCliComm here because breakpoint objects can
 	// be transfered to different MSX machines, and so the MSXCliComm
 	// object won't remain valid.
-	BreakPointBase(TclObject command_, TclObject condition_, bool once_)
-		: command(std::move(command_))
-		, condition(std::move(condition_))
-		, once(once_) {}
+	BreakPointBase(TclObject command_, TclObject condition_, bool once_);
+
+	bool isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+	            CompiledCondition::Context* context) const;
 
 private:
-	bool isTrue(GlobalCliComm& cliComm, Interpreter& interp) const;
 
 	TclObject command;
 	TclObject condition;
+	// shared: breakpoints get copied a lot (on each check)
+	std::shared_ptr<const CompiledCondition> compiled; // can be nullptr
 	bool once;
 	bool executing = false;
 };
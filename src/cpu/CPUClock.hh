@@ -4,6 +4,7 @@
 #include "DynamicClock.hh"
 #include "Scheduler.hh"
 #include <cassert>
+#include <cstdint>
 
 namespace openmsx {
 
@@ -57,6 +58,14 @@ protected:
 		return halts;
 	}
 
+	/** The number of cycles since the start, only useful to calculate
+	  * the duration (in cycles) of a sequence of instructions.
+	  */
+	uint64_t getTotalTicks() const {
+		sync();
+		return clock.getTotalTicks();
+	}
+
 	/** R800 runs at 7MHz, but I/O is done over a slower 3.5MHz bus. So
 	  * sometimes right before I/O it's needed to wait for one cycle so
 	  * that we're at the start of a clock cycle of the slower bus.
@@ -109,6 +118,17 @@ protected:
 		limit = -1;
 		remaining = limit - extra;
 	}
+	/** Make limitReached() return true after (at most) the given number
+	  * of cycles, even if the next SP is further away. Must be called
+	  * right after enableLimit().
+	  */
+	void capLimit(int ticks) {
+		assert(limitEnabled && (remaining == limit));
+		if (limit > ticks) {
+			limit = ticks;
+			remaining = ticks;
+		}
+	}
 	inline bool limitReached() const {
 		return remaining < 0;
 	}
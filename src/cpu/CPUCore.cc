@@ -163,15 +163,21 @@
 #include "Scheduler.hh"
 #include "MSXMotherBoard.hh"
 #include "CliComm.hh"
+#include "CommandException.hh"
+#include "CPUTraceBuffer.hh"
 #include "TclCallback.hh"
+#include "TclObject.hh"
 #include "Dasm.hh"
 #include "Z80.hh"
 #include "R800.hh"
 #include "Thread.hh"
+#include "Instrumentation.hh"
 #include "endian.hh"
 #include "likely.hh"
 #include "inline.hh"
 #include "unreachable.hh"
+#include "xrange.hh"
+#include <algorithm>
 #include <iostream>
 #include <type_traits>
 #include <cassert>
@@ -194,7 +200,8 @@
 //
 // Probably the easiest way to enable this, is to pass the -DUSE_COMPUTED_GOTO
 // flag to the compiler. This is for example done in the super-opt flavour.
-// See build/flavour-super-opt.mk
+// See build/flavour-super-opt.mk. When building with meson, configure with
+// -Dcomputed_goto=true instead.
 
 
 using std::string;
@@ -281,8 +288,9 @@ static constexpr Table table = initTables();
 // Global variable, because it should be shared between Z80 and R800.
 // It must not be shared between the CPUs of different MSX machines, but
 // the (logical) lifetime of this variable cannot overlap between execution
-// of two MSX machines.
-static word start_pc;
+// of two MSX machines. At least not on the same thread, so make it
+// thread-local such that machines can be emulated from different threads.
+static thread_local word start_pc;
 
 // conditions
 struct CondC  { bool operator()(byte f) const { return  (f & C_FLAG) != 0; } };
@@ -298,6 +306,8 @@ struct CondTrue { bool operator()(byte /*f*/) const { return true; } };
 template<class T> CPUCore<T>::CPUCore(
 		MSXMotherBoard& motherboard_, const string& name,
 		const BooleanSetting& traceSetting_,
+		const BooleanSetting& idleLoopSetting_,
+		CPUTraceBuffer& traceBuffer_,
 		TclCallback& diHaltCallback_, EmuTime::param time)
 	: CPURegs(T::isR800())
 	, T(time, motherboard_.getScheduler())
@@ -305,6 +315,8 @@ template<class T> CPUCore<T>::CPUCore(
 	, scheduler(motherboard.getScheduler())
 	, interface(nullptr)
 	, traceSetting(traceSetting_)
+	, idleLoopSetting(idleLoopSetting_)
+	, traceBuffer(traceBuffer_)
 	, diHaltCallback(diHaltCallback_)
 	, IRQStatus(motherboard.getDebugger(), name + ".pendingIRQ",
 	            "Non-zero if there are pending IRQs (thus CPU would enter "
@@ -326,11 +338,16 @@ template<class T> CPUCore<T>::CPUCore(
 	, NMIStatus(0)
 	, nmiEdge(false)
 	, exitLoop(false)
-	, tracingEnabled(traceSetting.getBoolean())
+	, tracingEnabled(traceSetting.getBoolean() || traceBuffer.isActive())
+	, skipIdleLoops(idleLoopSetting.getBoolean())
 	, isTurboR(motherboard.isTurboR())
 {
 	static_assert(!std::is_polymorphic<CPUCore<T>>::value,
 		"keep CPUCore non-virtual to keep PC at offset 0");
+	for (auto& page : savedCachePages) {
+		for (auto& saved : page) saved.generation = 0;
+	}
+	for (auto& gen : cacheGeneration) gen = 1;
 	doSetFreq();
 	doReset(time);
 }
@@ -354,6 +371,75 @@ template<class T> void CPUCore<T>::invalidateMemCache(unsigned start, unsigned s
 	memset(&writeCacheLine [first], 0, num * sizeof(byte*)); //
 	memset(&readCacheTried [first], 0, num * sizeof(bool));  // FALSE
 	memset(&writeCacheTried[first], 0, num * sizeof(bool));  //
+	memset(&readWatchedLine [first], 0, num * sizeof(byte*)); // nullptr
+	memset(&writeWatchedLine[first], 0, num * sizeof(byte*)); //
+
+	// the saved copies of these pages (for all slots) are no longer valid
+	unsigned last = std::min((start + size - 1) >> 14, 3u);
+	for (unsigned page = start >> 14; page <= last; ++page) {
+		++cacheGeneration[page];
+	}
+	if (size == 0x10000) {
+		// Also used when this CPU becomes active again (Z80 <-> R800
+		// switch). In that case the visible slots may have changed
+		// without us being informed.
+		for (auto& slot : visibleCacheSlot) slot = -1;
+	}
+}
+
+template<class T> void CPUCore<T>::refillMemCache(unsigned start, unsigned size)
+{
+	// Only the visible slot changed, so unlike invalidateMemCache() the
+	// saved copies of the page (of the other slots) remain valid.
+	unsigned first = start / CacheLine::SIZE;
+	unsigned num = (size + CacheLine::SIZE - 1) / CacheLine::SIZE;
+	memset(&writeCacheLine [first], 0, num * sizeof(byte*)); // nullptr
+	memset(&readCacheTried [first], 0, num * sizeof(bool));  // FALSE
+	memset(&writeCacheTried[first], 0, num * sizeof(bool));  //
+	memset(&readWatchedLine [first], 0, num * sizeof(byte*)); // nullptr
+	memset(&writeWatchedLine[first], 0, num * sizeof(byte*)); //
+	for (auto i : xrange(first, first + num)) {
+		// Same as in RDMEMslow(). If the line isn't cacheable,
+		// RDMEMslow() will check again (e.g. for watchpoints).
+		unsigned addrBase = i * CacheLine::SIZE;
+		const byte* line = interface->getReadCacheLine(addrBase);
+		readCacheLine[i] = line ? line - addrBase : nullptr;
+	}
+}
+
+template<class T> void CPUCore<T>::switchMemCachePage(unsigned page, unsigned slot)
+{
+	unsigned first = page * LINES_PER_PAGE;
+	if (visibleCacheSlot[page] != -1) {
+		auto& old = savedCachePages[page][visibleCacheSlot[page]];
+		memcpy(old.readCacheLine,   &readCacheLine  [first], sizeof(old.readCacheLine));
+		memcpy(old.writeCacheLine,  &writeCacheLine [first], sizeof(old.writeCacheLine));
+		memcpy(old.readCacheTried,  &readCacheTried [first], sizeof(old.readCacheTried));
+		memcpy(old.writeCacheTried, &writeCacheTried[first], sizeof(old.writeCacheTried));
+		memcpy(old.readWatchedLine,  &readWatchedLine [first], sizeof(old.readWatchedLine));
+		memcpy(old.writeWatchedLine, &writeWatchedLine[first], sizeof(old.writeWatchedLine));
+		old.generation = cacheGeneration[page];
+	}
+	visibleCacheSlot[page] = slot;
+
+	auto& saved = savedCachePages[page][slot];
+	if (saved.generation == cacheGeneration[page]) {
+		memcpy(&readCacheLine  [first], saved.readCacheLine,   sizeof(saved.readCacheLine));
+		memcpy(&writeCacheLine [first], saved.writeCacheLine,  sizeof(saved.writeCacheLine));
+		memcpy(&readCacheTried [first], saved.readCacheTried,  sizeof(saved.readCacheTried));
+		memcpy(&writeCacheTried[first], saved.writeCacheTried, sizeof(saved.writeCacheTried));
+		memcpy(&readWatchedLine [first], saved.readWatchedLine,  sizeof(saved.readWatchedLine));
+		memcpy(&writeWatchedLine[first], saved.writeWatchedLine, sizeof(saved.writeWatchedLine));
+	} else {
+		// Like invalidateMemCache(), but without invalidating the
+		// copy we just saved.
+		memset(&readCacheLine  [first], 0, LINES_PER_PAGE * sizeof(byte*)); // nullptr
+		memset(&writeCacheLine [first], 0, LINES_PER_PAGE * sizeof(byte*)); //
+		memset(&readCacheTried [first], 0, LINES_PER_PAGE * sizeof(bool));  // FALSE
+		memset(&writeCacheTried[first], 0, LINES_PER_PAGE * sizeof(bool));  //
+		memset(&readWatchedLine [first], 0, LINES_PER_PAGE * sizeof(byte*)); // nullptr
+		memset(&writeWatchedLine[first], 0, LINES_PER_PAGE * sizeof(byte*)); //
+	}
 }
 
 template<class T> void CPUCore<T>::doReset(EmuTime::param time)
@@ -539,16 +625,44 @@ template<class T> void CPUCore<T>::disasmCommand(
 	Interpreter& interp, span<const TclObject> tokens, TclObject& result) const
 {
 	word address = (tokens.size() < 3) ? getPC() : tokens[2].getInt(interp);
+	disasmInstruction(address, T::getTimeFast(), result);
+}
+
+template<class T> unsigned CPUCore<T>::disasmInstruction(
+	word address, EmuTime::param time, TclObject& result) const
+{
 	byte outBuf[4];
 	std::string dasmOutput;
-	unsigned len = dasm(*interface, address, outBuf, dasmOutput,
-	               T::getTimeFast());
+	unsigned len = dasmCache.dasm(*interface, address, outBuf, dasmOutput,
+	                              time);
 	result.addListElement(dasmOutput);
 	char tmp[3]; tmp[2] = 0;
 	for (unsigned i = 0; i < len; ++i) {
 		toHex(outBuf[i], tmp);
 		result.addListElement(tmp);
 	}
+	return len;
+}
+
+template<class T> void CPUCore<T>::disasmBlockCommand(
+	Interpreter& interp, span<const TclObject> tokens, TclObject& result) const
+{
+	if ((tokens.size() != 3) && (tokens.size() != 4)) {
+		throw SyntaxError();
+	}
+	unsigned address = tokens[2].getInt(interp) & 0xFFFF;
+	int num = (tokens.size() == 4) ? tokens[3].getInt(interp) : 8;
+	if ((num < 0) || (num > 0x10000)) {
+		throw CommandException("Number of instructions must be in range "
+		                       "0..65536");
+	}
+	EmuTime::param time = T::getTimeFast();
+	for (int i = 0; i < num; ++i) {
+		TclObject line;
+		line.addListElement(int(address));
+		address = (address + disasmInstruction(address, time, line)) & 0xFFFF;
+		result.addListElement(line);
+	}
 }
 
 template<class T> void CPUCore<T>::update(const Setting& setting)
@@ -558,10 +672,19 @@ template<class T> void CPUCore<T>::update(const Setting& setting)
 	} else if (&setting == &freqValue) {
 		doSetFreq();
 	} else if (&setting == &traceSetting) {
-		tracingEnabled = traceSetting.getBoolean();
+		updateTracing();
+	} else if (&setting == &idleLoopSetting) {
+		skipIdleLoops = idleLoopSetting.getBoolean();
 	}
 }
 
+template<class T> void CPUCore<T>::updateTracing()
+{
+	tracingEnabled = traceSetting.getBoolean() || traceBuffer.isActive() ||
+	                 (interface && (interface->isMemoryHeatmapEnabled() ||
+	                                interface->isCoverageEnabled()));
+}
+
 template<class T> void CPUCore<T>::setFreq(unsigned freq_)
 {
 	freq = freq_;
@@ -612,9 +735,20 @@ NEVER_INLINE byte CPUCore<T>::RDMEMslow(unsigned address, unsigned cc)
 			readCacheLine[high] = line - addrBase;
 			return readCacheLine[high][address];
 		}
+		if (const byte* line = interface->getWatchedReadCacheLine(addrBase)) {
+			readWatchedLine[high] = line - addrBase;
+		}
 	}
-	// uncacheable
 	readCacheTried[high] = true;
+	if (const byte* line = readWatchedLine[high]) {
+		if (likely(!interface->isReadWatched(address))) {
+			// not a watched address, no need to go via readMem()
+			T::template PRE_MEM<PRE_PB, POST_PB>(address);
+			T::template POST_MEM<       POST_PB>(address);
+			return line[address];
+		}
+	}
+	// uncacheable
 	T::template PRE_MEM<PRE_PB, POST_PB>(address);
 	EmuTime time = T::getTimeFast(cc);
 	scheduler.schedule(time);
@@ -716,9 +850,21 @@ NEVER_INLINE void CPUCore<T>::WRMEMslow(unsigned address, byte value, unsigned c
 			writeCacheLine[high][address] = value;
 			return;
 		}
+		if (byte* line = interface->getWatchedWriteCacheLine(addrBase)) {
+			writeWatchedLine[high] = line - addrBase;
+		}
 	}
-	// uncacheable
 	writeCacheTried[high] = true;
+	if (byte* line = writeWatchedLine[high]) {
+		if (likely(!interface->isWriteWatched(address))) {
+			// not a watched address, no need to go via writeMem()
+			T::template PRE_MEM<PRE_PB, POST_PB>(address);
+			T::template POST_MEM<       POST_PB>(address);
+			line[address] = value;
+			return;
+		}
+	}
+	// uncacheable
 	T::template PRE_MEM<PRE_PB, POST_PB>(address);
 	EmuTime time = T::getTimeFast(cc);
 	scheduler.schedule(time);
@@ -2470,9 +2616,29 @@ template<class T> inline void CPUCore<T>::cpuTracePost()
 }
 template<class T> void CPUCore<T>::cpuTracePost_slow()
 {
+	if (interface->isMemoryHeatmapEnabled()) {
+		interface->heatmapExecute(start_pc);
+	}
+	if (interface->isCoverageEnabled()) {
+		interface->coverageExecute(start_pc);
+	}
+	if (traceBuffer.isActive()) {
+		EmuTime time = T::getTimeFast();
+		auto& r = traceBuffer.add();
+		r.time = (time - EmuTime::zero).length();
+		r.pc = start_pc;
+		r.af = getAF(); r.bc = getBC(); r.de = getDE(); r.hl = getHL();
+		r.ix = getIX(); r.iy = getIY(); r.sp = getSP();
+		for (auto i : xrange(4)) {
+			r.opcode[i] = interface->peekMem(
+				(start_pc + i) & 0xFFFF, time);
+		}
+	}
+	if (!traceSetting.getBoolean()) return;
+
 	byte opbuf[4];
 	string dasmOutput;
-	dasm(*interface, start_pc, opbuf, dasmOutput, T::getTimeFast());
+	dasmCache.dasm(*interface, start_pc, opbuf, dasmOutput, T::getTimeFast());
 	std::cout << strCat(hex_string<4>(start_pc),
 	                    " : ", dasmOutput,
 	                    " AF=", hex_string<4>(getAF()),
@@ -2560,6 +2726,156 @@ template<class T> void CPUCore<T>::executeSlow(ExecIRQ execIRQ)
 	}
 }
 
+// Idle loop detection: a lot of MSX software waits for an interrupt or for
+// VBLANK with a busy loop, e.g.
+//     ld   a,(JIFFY)          loop: in  a,(#99)
+//  loop:                            and a
+//     cp   (hl)          or         jp  p,loop
+//     jr   z,loop
+// Such a loop only ends when some device changes its state (the loop itself
+// doesn't change anything), and that only happens at a sync point. So like
+// for HALT, the time can be advanced till the next sync point. A loop
+// qualifies when it only contains instructions that don't write to memory or
+// IO, that only read from plain memory (RAM or ROM, not memory mapped IO) or
+// from IO ports for which MSXDevice::isIdlePollIO() is true and when one
+// iteration leaves the registers unchanged.
+static const int IDLE_LOOP_CHECK_TICKS = 1024; // look for a loop this often
+static const int IDLE_LOOP_MAX_INSTRUCTIONS = 8;
+
+// Returns the length of the instruction at the given address when it can be
+// part of an idle loop, or 0 when it can't. For a jump instruction 'target' is
+// set to the destination, otherwise to -1. When 'checkReads' is false the
+// registers don't necessarily have the values for this instruction yet, then
+// memory and IO reads are not checked.
+template<class T> unsigned CPUCore<T>::decodeIdleInstruction(
+	unsigned address, bool checkReads, int& target) const
+{
+	byte op[3];
+	auto fetch = [&](unsigned len) {
+		for (unsigned i = 0; i < len; ++i) {
+			unsigned addr = (address + i) & 0xFFFF;
+			const byte* line = readCacheLine[addr >> CacheLine::BITS];
+			if (!line) return false; // not plain memory
+			op[i] = line[addr];
+		}
+		return true;
+	};
+	auto readable = [&](unsigned addr) {
+		return !checkReads ||
+		       (readCacheLine[(addr & 0xFFFF) >> CacheLine::BITS] != nullptr);
+	};
+	auto pollable = [&](unsigned port) {
+		return !checkReads || interface->isIdlePollIO(port);
+	};
+
+	target = -1;
+	if (!fetch(1)) return 0;
+	if ((0x40 <= op[0]) && (op[0] < 0xC0)) {
+		if ((op[0] & 0xF8) == 0x70) return 0; // ld (hl),r / halt
+		if ((op[0] & 7) == 6) { // ld r,(hl) / alu (hl)
+			return readable(getHL()) ? 1 : 0;
+		}
+		return 1; // ld r,r / alu r
+	}
+	switch (op[0]) {
+	case 0x00: // nop
+	case 0x04: case 0x0C: case 0x14: case 0x1C: case 0x24: case 0x2C: case 0x3C: // inc r
+	case 0x05: case 0x0D: case 0x15: case 0x1D: case 0x25: case 0x2D: case 0x3D: // dec r
+	case 0x07: case 0x0F: case 0x17: case 0x1F: // rlca, rrca, rla, rra
+	case 0x27: case 0x2F: case 0x37: case 0x3F: // daa, cpl, scf, ccf
+		return 1;
+	case 0x0A: // ld a,(bc)
+		return readable(getBC()) ? 1 : 0;
+	case 0x1A: // ld a,(de)
+		return readable(getDE()) ? 1 : 0;
+	case 0x06: case 0x0E: case 0x16: case 0x1E: case 0x26: case 0x2E: case 0x3E: // ld r,n
+	case 0xC6: case 0xCE: case 0xD6: case 0xDE: case 0xE6: case 0xEE: case 0xF6: case 0xFE: // alu n
+		return fetch(2) ? 2 : 0;
+	case 0x01: case 0x11: case 0x21: // ld rr,nn
+		return fetch(3) ? 3 : 0;
+	case 0x2A: { // ld hl,(nn)
+		if (!fetch(3)) return 0;
+		unsigned nn = op[1] + 256 * op[2];
+		return (readable(nn) && readable(nn + 1)) ? 3 : 0;
+	}
+	case 0x3A: // ld a,(nn)
+		if (!fetch(3)) return 0;
+		return readable(op[1] + 256 * op[2]) ? 3 : 0;
+	case 0x10: case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // djnz, jr
+		if (!fetch(2)) return 0;
+		target = (address + 2 + int8_t(op[1])) & 0xFFFF;
+		return 2;
+	case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: case 0xE2: case 0xEA: case 0xF2: case 0xFA: // jp
+		if (!fetch(3)) return 0;
+		target = op[1] + 256 * op[2];
+		return 3;
+	case 0xDB: // in a,(n)
+		if (!fetch(2)) return 0;
+		return pollable(256 * getA() + op[1]) ? 2 : 0;
+	case 0xCB:
+		if (!fetch(2)) return 0;
+		if ((op[1] & 7) != 6) return 2; // shift/bit/res/set r
+		if ((op[1] & 0xC0) == 0x40) { // bit n,(hl)
+			return readable(getHL()) ? 2 : 0;
+		}
+		return 0;
+	case 0xED:
+		if (!fetch(2)) return 0;
+		if ((op[1] & 0xC7) == 0x40) { // in r,(c)
+			return pollable(getBC()) ? 2 : 0;
+		}
+		return 0;
+	default:
+		return 0;
+	}
+}
+
+template<class T> void CPUCore<T>::skipIdleLoop()
+{
+	// Quick check first: is there a jump back to (or before) the current
+	// instruction within a few instructions.
+	unsigned start = getPC();
+	unsigned address = start;
+	for (int i = 0; /**/; ++i) {
+		if (i == IDLE_LOOP_MAX_INSTRUCTIONS) return;
+		int target;
+		unsigned len = decodeIdleInstruction(address, false, target);
+		if (len == 0) return;
+		if ((0 <= target) && (unsigned(target) <= start)) break;
+		address = (address + len) & 0xFFFF;
+	}
+
+	// Execute one iteration of the loop, one instruction at a time, and
+	// check that it's really an idle loop. Stop before the next sync
+	// point, the polled values might change there.
+	EmuTime next = scheduler.getNext();
+	unsigned af = getAF(), bc = getBC(), de = getDE(), hl = getHL();
+	byte r = getR();
+	uint64_t ticks = T::getTotalTicks();
+	T::disableLimit(); // only one instruction at a time
+	for (int i = 0; i < IDLE_LOOP_MAX_INSTRUCTIONS; ++i) {
+		int target;
+		if ((T::getTimeFast() >= next) ||
+		    (decodeIdleInstruction(getPC(), true, target) == 0)) {
+			return;
+		}
+		executeInstructions();
+		endInstruction();
+		if (slowInstructions) return; // e.g. got an IRQ
+		if (getPC() == start) {
+			if ((getAF() == af) && (getBC() == bc) &&
+			    (getDE() == de) && (getHL() == hl)) {
+				// The next iterations will do exactly the same.
+				auto loopTicks = unsigned(T::getTotalTicks() - ticks);
+				auto loopR = byte(getR() - r);
+				unsigned loops = T::advanceHalt(loopTicks, next);
+				incR(byte(loops * loopR));
+			}
+			return;
+		}
+	}
+}
+
 template<class T> void CPUCore<T>::execute(bool fastForward)
 {
 	// In fast-forward mode, breakpoints, watchpoints or debug condtions
@@ -2569,6 +2885,7 @@ template<class T> void CPUCore<T>::execute(bool fastForward)
 	if (fastForward) {
 		interface->setFastForward(true);
 	}
+	INSTRUMENT_ZONE(T::isR800() ? "R800" : "Z80");
 	execute2(fastForward);
 	interface->setFastForward(false);
 }
@@ -2598,6 +2915,14 @@ template<class T> void CPUCore<T>::execute2(bool fastForward)
 	// Note: we call scheduler _after_ executing the instruction and before
 	// deciding between executeFast() and executeSlow() (because a
 	// SyncPoint could set an IRQ and then we must choose executeSlow())
+	//
+	// The fast path below is also what's used when running as fast as
+	// possible (throttle off, fast-forward): executeInstructions() already
+	// runs uninterrupted till the next sync point (or till a 'slow'
+	// instruction or device access), it contains no trace, breakpoint or
+	// IRQ checks. A separate CPU_POLICY instantiation for such a 'turbo'
+	// mode would double the (already huge) compile time and size of the
+	// CPU core without making this inner loop any faster.
 	if (fastForward ||
 	    (!interface->anyBreakPoints() && !tracingEnabled)) {
 		// fast path, no breakpoints, no tracing
@@ -2609,6 +2934,10 @@ template<class T> void CPUCore<T>::execute2(bool fastForward)
 			} else {
 				while (slowInstructions == 0) {
 					T::enableLimit(); // does CPUClock::sync()
+					if (skipIdleLoops) {
+						// regularly look for an idle loop
+						T::capLimit(IDLE_LOOP_CHECK_TICKS);
+					}
 					if (likely(!T::limitReached())) {
 						// multiple instructions
 						executeInstructions();
@@ -2618,6 +2947,9 @@ template<class T> void CPUCore<T>::execute2(bool fastForward)
 					}
 					scheduler.schedule(T::getTimeFast());
 					if (needExitCPULoop()) return;
+					if (skipIdleLoops && (slowInstructions == 0)) {
+						skipIdleLoop();
+					}
 				}
 			}
 		}
@@ -4187,6 +4519,12 @@ template<class T> II CPUCore<T>::inir() { return BLOCK_IN( 1, true ); }
 
 
 // block OUT
+// Note: OTIR/OTDR are (intentionally) not handed to the device as one burst.
+// E.g. for VRAM writes the VDP schedules each access in a VDP access slot
+// (and detects too fast accesses), and sync points of other devices (VDP line
+// interrupts, display mode changes, ...) can occur in between bytes of the
+// burst. And the overhead of repeatedly dispatching the instruction is small
+// compared to the work the VDP does for each byte.
 template<class T> inline II CPUCore<T>::BLOCK_OUT(int increase, bool repeat) {
 	// TODO R800 flags
 	byte val = RDMEM(getHL(), T::CC_OUTI_1);
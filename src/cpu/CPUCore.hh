@@ -3,6 +3,7 @@
 
 #include "CPURegs.hh"
 #include "CacheLine.hh"
+#include "Dasm.hh"
 #include "Probe.hh"
 #include "EmuTime.hh"
 #include "BooleanSetting.hh"
@@ -16,6 +17,7 @@
 namespace openmsx {
 
 class MSXCPUInterface;
+class CPUTraceBuffer;
 class Scheduler;
 class MSXMotherBoard;
 class TclCallback;
@@ -51,6 +53,8 @@ class CPUCore final : public CPUBase, public CPURegs, public CPU_POLICY
 public:
 	CPUCore(MSXMotherBoard& motherboard, const std::string& name,
 	        const BooleanSetting& traceSetting,
+	        const BooleanSetting& idleLoopSetting,
+	        CPUTraceBuffer& traceBuffer,
 	        TclCallback& diHaltCallback, EmuTime::param time);
 
 	void setInterface(MSXCPUInterface* interf) { interface = interf; }
@@ -80,11 +84,23 @@ public:
 	EmuTime waitCycles(EmuTime::param time, unsigned cycles);
 	void setNextSyncPoint(EmuTime::param time);
 	void invalidateMemCache(unsigned start, unsigned size);
+	void refillMemCache(unsigned start, unsigned size);
+
+	/** A different slot (given as 4 * primary + secondary) became visible
+	  * in the given page. Instead of (only) invalidating the page, the
+	  * cache lines of the previously visible slot are kept aside, and
+	  * those of the new slot are reused from the last time it was visible,
+	  * unless some part of the page got invalidated in the mean time.
+	  */
+	void switchMemCachePage(unsigned page, unsigned slot);
 	bool isM1Cycle(unsigned address) const;
 
 	void disasmCommand(Interpreter& interp,
 	                   span<const TclObject> tokens,
                            TclObject& result) const;
+	void disasmBlockCommand(Interpreter& interp,
+	                        span<const TclObject> tokens,
+	                        TclObject& result) const;
 
 	/**
 	 * Raises the maskable interrupt count.
@@ -123,22 +139,54 @@ private:
 	bool needExitCPULoop();
 	void setSlowInstructions();
 	void doSetFreq();
+	/** Append the disassembly of one instruction (text followed by the
+	  * opcode bytes) to 'result', returns the instruction length. */
+	unsigned disasmInstruction(word address, EmuTime::param time,
+	                           TclObject& result) const;
 
 	// Observer<Setting>  !! non-virtual !!
 	void update(const Setting& setting);
 
+	/** Must be called after the trace buffer was started or stopped or
+	  * the memory heatmap was enabled or disabled. */
+	void updateTracing();
+
 	// memory cache
 	const byte* readCacheLine[CacheLine::NUM];
 	byte* writeCacheLine[CacheLine::NUM];
 	bool readCacheTried [CacheLine::NUM];
 	bool writeCacheTried[CacheLine::NUM];
+	// Lines that are only uncacheable because they contain a memory
+	// watchpoint: only accesses to the watched addresses take the slow
+	// path, see MSXCPUInterface::getWatchedReadCacheLine().
+	const byte* readWatchedLine[CacheLine::NUM];
+	byte* writeWatchedLine[CacheLine::NUM];
+
+	// memory cache of the pages of the slots that are not visible, see
+	// switchMemCachePage()
+	static const unsigned LINES_PER_PAGE = CacheLine::NUM / 4;
+	struct SavedCachePage {
+		const byte* readCacheLine[LINES_PER_PAGE];
+		byte* writeCacheLine[LINES_PER_PAGE];
+		bool readCacheTried [LINES_PER_PAGE];
+		bool writeCacheTried[LINES_PER_PAGE];
+		const byte* readWatchedLine[LINES_PER_PAGE];
+		byte* writeWatchedLine[LINES_PER_PAGE];
+		unsigned generation; // only valid if equal to cacheGeneration
+	};
+	SavedCachePage savedCachePages[4][16];
+	unsigned cacheGeneration[4]; // incremented on invalidateMemCache()
+	int visibleCacheSlot[4]; // -1 if unknown
 
 	MSXMotherBoard& motherboard;
 	Scheduler& scheduler;
 	MSXCPUInterface* interface;
 
 	const BooleanSetting& traceSetting;
+	const BooleanSetting& idleLoopSetting;
+	CPUTraceBuffer& traceBuffer;
 	TclCallback& diHaltCallback;
+	mutable DasmCache dasmCache; // for the disasm commands and 'cputrace'
 
 	Probe<int> IRQStatus;
 	Probe<void> IRQAccept;
@@ -161,9 +209,13 @@ private:
 
 	std::atomic<bool> exitLoop;
 
-	/** In sync with traceSetting.getBoolean(). */
+	/** True when the trace setting, the trace buffer, the memory
+	  * heatmap or code coverage is active, see updateTracing(). */
 	bool tracingEnabled;
 
+	/** Cached value of 'idleLoopSetting', see skipIdleLoop(). */
+	bool skipIdleLoops;
+
 	/** 'normal' Z80 and Z80 in a turboR behave slightly different */
 	const bool isTurboR;
 
@@ -220,6 +272,9 @@ private:
 	inline void irq2();
 	ExecIRQ getExecIRQ() const;
 	void executeSlow(ExecIRQ execIRQ);
+	unsigned decodeIdleInstruction(unsigned address, bool checkReads,
+	                               int& target) const;
+	void skipIdleLoop();
 
 	template<Reg8>  inline byte     get8()  const;
 	template<Reg16> inline unsigned get16() const;
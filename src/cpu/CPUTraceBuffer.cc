@@ -0,0 +1,125 @@
+#include "CPUTraceBuffer.hh"
+#include "Dasm.hh"
+#include "EmuDuration.hh"
+#include "File.hh"
+#include "MSXException.hh"
+#include "endian.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+#include <cstring>
+
+namespace openmsx {
+
+static const char MAGIC[8] = { 'O', 'M', 'S', 'X', 'T', 'R', 'C', '1' };
+static const unsigned HEADER_SIZE = 16;
+static const unsigned RECORD_SIZE = 28;
+
+CPUTraceBuffer::CPUTraceBuffer()
+	: capacity(0), head(0), count(0), active(false)
+{
+}
+
+void CPUTraceBuffer::start(size_t numRecords)
+{
+	assert(numRecords != 0);
+	if (numRecords != capacity) {
+		records.resize(numRecords);
+		capacity = numRecords;
+	}
+	clear();
+	active = true;
+}
+
+void CPUTraceBuffer::save(const std::string& filename, bool text) const
+{
+	File file(filename, File::TRUNCATE);
+	std::string buf;
+	DasmCache dasmCache; // traces mostly consist of loops
+	if (!text) {
+		buf.assign(MAGIC, sizeof(MAGIC));
+		buf.resize(HEADER_SIZE);
+		Endian::write_UA_L32(&buf[ 8], RECORD_SIZE);
+		Endian::write_UA_L32(&buf[12], MAIN_FREQ32);
+	}
+	for (auto i : xrange(count)) {
+		const auto& r = (*this)[i];
+		if (text) {
+			strAppend(buf, format(r, &dasmCache), '\n');
+		} else {
+			char rec[RECORD_SIZE];
+			Endian::write_UA_L64(&rec[ 0], r.time);
+			Endian::write_UA_L16(&rec[ 8], r.pc);
+			Endian::write_UA_L16(&rec[10], r.af);
+			Endian::write_UA_L16(&rec[12], r.bc);
+			Endian::write_UA_L16(&rec[14], r.de);
+			Endian::write_UA_L16(&rec[16], r.hl);
+			Endian::write_UA_L16(&rec[18], r.ix);
+			Endian::write_UA_L16(&rec[20], r.iy);
+			Endian::write_UA_L16(&rec[22], r.sp);
+			memcpy(&rec[24], r.opcode, 4);
+			buf.append(rec, RECORD_SIZE);
+		}
+		if (buf.size() >= 1024 * 1024) {
+			file.write(buf.data(), buf.size());
+			buf.clear();
+		}
+	}
+	file.write(buf.data(), buf.size());
+}
+
+void CPUTraceBuffer::load(const std::string& filename)
+{
+	File file(filename);
+	auto data = file.mmap();
+	if ((data.size() < HEADER_SIZE) ||
+	    (memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0)) {
+		throw MSXException("Not an openMSX CPU trace file: ", filename);
+	}
+	if ((Endian::read_UA_L32(&data[ 8]) != RECORD_SIZE) ||
+	    (Endian::read_UA_L32(&data[12]) != MAIN_FREQ32)) {
+		throw MSXException("Unsupported CPU trace file: ", filename);
+	}
+	size_t num = (data.size() - HEADER_SIZE) / RECORD_SIZE;
+
+	active = false;
+	clear();
+	if (num == 0) return;
+	records.resize(num);
+	capacity = num;
+	for (auto i : xrange(num)) {
+		const byte* rec = &data[HEADER_SIZE + i * RECORD_SIZE];
+		Record& r = records[i];
+		r.time = Endian::read_UA_L64(&rec[ 0]);
+		r.pc   = Endian::read_UA_L16(&rec[ 8]);
+		r.af   = Endian::read_UA_L16(&rec[10]);
+		r.bc   = Endian::read_UA_L16(&rec[12]);
+		r.de   = Endian::read_UA_L16(&rec[14]);
+		r.hl   = Endian::read_UA_L16(&rec[16]);
+		r.ix   = Endian::read_UA_L16(&rec[18]);
+		r.iy   = Endian::read_UA_L16(&rec[20]);
+		r.sp   = Endian::read_UA_L16(&rec[22]);
+		memcpy(r.opcode, &rec[24], 4);
+	}
+	count = num;
+}
+
+std::string CPUTraceBuffer::format(const Record& r, DasmCache* cache)
+{
+	std::string dasmOutput;
+	if (cache) {
+		cache->dasm(r.opcode, r.pc, dasmOutput);
+	} else {
+		dasm(r.opcode, r.pc, dasmOutput);
+	}
+	return strCat(r.time, ' ', hex_string<4>(r.pc),
+	              " : ", dasmOutput,
+	              " AF=", hex_string<4>(r.af),
+	              " BC=", hex_string<4>(r.bc),
+	              " DE=", hex_string<4>(r.de),
+	              " HL=", hex_string<4>(r.hl),
+	              " IX=", hex_string<4>(r.ix),
+	              " IY=", hex_string<4>(r.iy),
+	              " SP=", hex_string<4>(r.sp));
+}
+
+} // namespace openmsx
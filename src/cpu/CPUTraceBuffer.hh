@@ -0,0 +1,101 @@
+#ifndef CPUTRACEBUFFER_HH
+#define CPUTRACEBUFFER_HH
+
+#include "MemBuffer.hh"
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+namespace openmsx {
+
+class DasmCache;
+
+/** Binary trace of the executed CPU instructions.
+  *
+  * Compared to the 'cputrace' setting (which disassembles and prints every
+  * instruction) recording an instruction only costs a few stores in a big
+  * ring buffer, so it's feasible to trace millions of instructions (e.g.
+  * the ones before a crash). The trace can be saved as a compact binary
+  * file and later be loaded again to decode it to text.
+  *
+  * Binary file format (all values little endian):
+  *   header:  8 bytes   magic "OMSXTRC1"
+  *            4 bytes   size of each record in bytes (28)
+  *            4 bytes   frequency of the time stamps in Hz
+  *   followed by the records, oldest first:
+  *            8 bytes   time stamp, after the instruction was executed
+  *            8x2 bytes PC AF BC DE HL IX IY SP (PC is the address of the
+  *                      instruction, the others are the values after it)
+  *            4 bytes   opcode bytes (unused bytes are also filled in)
+  */
+class CPUTraceBuffer
+{
+public:
+	struct Record {
+		uint64_t time; // in EmuTime ticks
+		uint16_t pc, af, bc, de, hl, ix, iy, sp;
+		uint8_t opcode[4];
+	};
+
+	CPUTraceBuffer();
+
+	/** (Re)start recording, keep (at most) the last 'numRecords'
+	  * instructions. All previously recorded instructions are discarded.
+	  */
+	void start(size_t numRecords);
+	/** Stop recording, the recorded instructions are kept. */
+	void stop() { active = false; }
+	bool isActive() const { return active; }
+	/** Discard all recorded instructions. */
+	void clear() { head = 0; count = 0; }
+
+	/** The number of recorded instructions. */
+	size_t size() const { return count; }
+	/** Get the i-th recorded instruction, 0 is the oldest one. */
+	const Record& operator[](size_t i) const {
+		assert(i < count);
+		size_t idx = head + (capacity - count) + i;
+		if (idx >= capacity) idx -= capacity;
+		return records[idx];
+	}
+
+	/** Returns the slot for a new record, overwrites the oldest record
+	  * when the buffer is full. Should only be called while active.
+	  */
+	Record& add() {
+		assert(active);
+		Record& result = records[head];
+		if (++head == capacity) head = 0;
+		if (count < capacity) ++count;
+		return result;
+	}
+
+	/** Write the recorded instructions to a file, either in the binary
+	  * format or as text (the same format as the 'cputrace' setting
+	  * produces, prefixed with the time stamp).
+	  * @throws FileException
+	  */
+	void save(const std::string& filename, bool text) const;
+
+	/** Replace the content of this buffer with the instructions from a
+	  * file in the binary format. Recording is stopped.
+	  * @throws MSXException
+	  */
+	void load(const std::string& filename);
+
+	/** Disassemble a record to a line of text (without newline).
+	  * Optionally use (and fill) the given cache for the disassembly. */
+	static std::string format(const Record& record,
+	                          DasmCache* cache = nullptr);
+
+private:
+	MemBuffer<Record> records;
+	size_t capacity;
+	size_t head;  // position of the next record
+	size_t count; // number of valid records
+	bool active;
+};
+
+} // namespace openmsx
+
+#endif
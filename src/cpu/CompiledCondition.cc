@@ -0,0 +1,356 @@
+#include "CompiledCondition.hh"
+#include "StringOp.hh"
+#include "ranges.hh"
+#include <cassert>
+#include <cctype>
+
+namespace openmsx {
+
+// Register names and indices, see 'reg' in share/scripts/_cpuregs.tcl
+struct RegInfo {
+	const char* name;
+	unsigned index;
+};
+static const RegInfo regs8[] = {
+	{ "A",    0 }, { "F",    1 }, { "B",    2 }, { "C",    3 },
+	{ "D",    4 }, { "E",    5 }, { "H",    6 }, { "L",    7 },
+	{ "A2",   8 }, { "F2",   9 }, { "B2",  10 }, { "C2",  11 },
+	{ "D2",  12 }, { "E2",  13 }, { "H2",  14 }, { "L2",  15 },
+	{ "IXH", 16 }, { "IXL", 17 }, { "IYH", 18 }, { "IYL", 19 },
+	{ "PCH", 20 }, { "PCL", 21 }, { "SPH", 22 }, { "SPL", 23 },
+	{ "I",   24 }, { "R",   25 }, { "IM",  26 }, { "IFF", 27 },
+};
+static const RegInfo regs16[] = {
+	{ "AF",   0 }, { "BC",   2 }, { "DE",   4 }, { "HL",   6 },
+	{ "AF2",  8 }, { "BC2", 10 }, { "DE2", 12 }, { "HL2", 14 },
+	{ "IX",  16 }, { "IY",  18 }, { "PC",  20 }, { "SP",  22 },
+};
+static const unsigned PC_INDEX = 20;
+
+// Recursive descent parser. Operator precedence is the same as in Tcl
+// expressions. Each parse method returns false when the input is not in the
+// supported subset.
+class CompiledCondition::Parser
+{
+public:
+	Parser(string_view input_, std::vector<Instr>& code_)
+		: input(input_), code(code_) {}
+
+	bool parse()
+	{
+		if (!parseOr()) return false;
+		skipSpace();
+		return input.empty() && (depth == 1);
+	}
+
+private:
+	void skipSpace()
+	{
+		while (!input.empty() && isspace(static_cast<unsigned char>(input.front()))) {
+			input.remove_prefix(1);
+		}
+	}
+
+	// Consume 'token' when it's next in the input, but not when it's
+	// followed by 'notFollowedBy' (to distinguish e.g. '&' from '&&').
+	bool accept(string_view token, char notFollowedBy = 0)
+	{
+		skipSpace();
+		if (!input.starts_with(token)) return false;
+		if (notFollowedBy && (input.size() > token.size()) &&
+		    (input[token.size()] == notFollowedBy)) {
+			return false;
+		}
+		input.remove_prefix(token.size());
+		return true;
+	}
+
+	bool emit(Op op, int64_t value = 0)
+	{
+		switch (op) {
+		case LITERAL: case REG8: case REG16: case PC_IN_SLOT:
+			++depth;
+			break;
+		case PEEK: case PEEK16: case NEG: case PLUS: case NOT: case BITNOT:
+			break;
+		default: // binary
+			assert(depth >= 2);
+			--depth;
+			break;
+		}
+		if (depth > MAX_STACK) return false;
+		code.push_back(Instr{op, value});
+		return true;
+	}
+
+	template<typename SUB>
+	bool parseBinary(SUB sub, std::initializer_list<std::pair<const char*, Op>> ops,
+	                 char notFollowedBy = 0)
+	{
+		if (!(this->*sub)()) return false;
+		while (true) {
+			const std::pair<const char*, Op>* found = nullptr;
+			for (auto& o : ops) {
+				if (accept(o.first, notFollowedBy)) {
+					found = &o;
+					break;
+				}
+			}
+			if (!found) return true;
+			if (!(this->*sub)()) return false;
+			if (!emit(found->second)) return false;
+		}
+	}
+
+	bool parseOr()     { return parseBinary(&Parser::parseAnd,    {{"||", OR}}); }
+	bool parseAnd()    { return parseBinary(&Parser::parseBitOr,  {{"&&", AND}}); }
+	bool parseBitOr()  { return parseBinary(&Parser::parseBitXor, {{"|", BITOR}}, '|'); }
+	bool parseBitXor() { return parseBinary(&Parser::parseBitAnd, {{"^", BITXOR}}); }
+	bool parseBitAnd() { return parseBinary(&Parser::parseEqual,  {{"&", BITAND}}, '&'); }
+	bool parseEqual()  { return parseBinary(&Parser::parseRel,    {{"==", EQ}, {"!=", NE}}); }
+	bool parseRel()
+	{
+		// '<<' and '>>' are handled by checking '<=' first and by
+		// rejecting '<' followed by '<'.
+		if (!parseShift()) return false;
+		while (true) {
+			Op op;
+			if      (accept("<="))      op = LE;
+			else if (accept(">="))      op = GE;
+			else if (accept("<", '<'))  op = LT;
+			else if (accept(">", '>'))  op = GT;
+			else return true;
+			if (!parseShift()) return false;
+			if (!emit(op)) return false;
+		}
+	}
+	bool parseShift()  { return parseBinary(&Parser::parseAdd,    {{"<<", SHL}, {">>", SHR}}); }
+	bool parseAdd()    { return parseBinary(&Parser::parseMul,    {{"+", ADD}, {"-", SUB}}); }
+	bool parseMul()    { return parseBinary(&Parser::parseUnary,  {{"*", MUL}}); }
+
+	bool parseUnary()
+	{
+		Op op;
+		if      (accept("-"))      op = NEG;
+		else if (accept("+"))      op = PLUS;
+		else if (accept("!", '=')) op = NOT;
+		else if (accept("~"))      op = BITNOT;
+		else return parsePrimary();
+		return parseUnary() && emit(op);
+	}
+
+	bool parsePrimary()
+	{
+		skipSpace();
+		if (accept("(")) {
+			return parseOr() && accept(")");
+		} else if (accept("[")) {
+			return parseCommand();
+		} else {
+			int64_t value;
+			return parseNumber(value) && emit(LITERAL, value);
+		}
+	}
+
+	// A sequence of characters up to whitespace or a bracket.
+	string_view parseWord()
+	{
+		skipSpace();
+		size_t n = 0;
+		while ((n < input.size()) && !isspace(static_cast<unsigned char>(input[n])) &&
+		       (input[n] != '[') && (input[n] != ']')) {
+			++n;
+		}
+		auto result = input.substr(0, n);
+		input.remove_prefix(n);
+		return result;
+	}
+
+	bool parseNumber(int64_t& result)
+	{
+		skipSpace();
+		size_t n = 0;
+		while ((n < input.size()) && isalnum(static_cast<unsigned char>(input[n]))) ++n;
+		string_view word = input.substr(0, n);
+		if (word.empty() || !isdigit(word.front())) return false;
+		// Reject decimal numbers with a leading zero: depending on the
+		// Tcl version these are interpreted as octal.
+		if ((word.size() > 1) && (word[0] == '0') && isdigit(word[1])) {
+			return false;
+		}
+		int base = 10;
+		if (word.starts_with("0x") || word.starts_with("0X")) {
+			base = 16; word.remove_prefix(2);
+		} else if (word.starts_with("0b") || word.starts_with("0B")) {
+			base = 2; word.remove_prefix(2);
+		}
+		if (word.empty() || (word.size() > 10)) return false;
+		uint64_t value = 0;
+		for (char c : word) {
+			int d = isdigit(c) ? (c - '0')
+			      : isxdigit(c) ? (tolower(c) - 'a' + 10)
+			      : 99;
+			if (d >= base) return false;
+			value = value * base + d;
+		}
+		if (value > 0xFFFFFFFF) return false;
+		input.remove_prefix(n);
+		result = value;
+		return true;
+	}
+
+	// An argument of peek/peek16: a number or a nested command.
+	bool parseAddress()
+	{
+		if (accept("[")) return parseCommand();
+		int64_t value;
+		return parseNumber(value) && emit(LITERAL, value);
+	}
+
+	// Primary or secondary slot number, or 'X' (-1).
+	bool parseSlot(int& result)
+	{
+		string_view word = parseWord();
+		if ((word.size() == 1) && ('0' <= word[0]) && (word[0] <= '3')) {
+			result = word[0] - '0';
+			return true;
+		}
+		if ((word == "X") || (word == "x")) {
+			result = -1;
+			return true;
+		}
+		return false;
+	}
+
+	// Parses the part after the opening bracket, up to (and including)
+	// the closing bracket.
+	bool parseCommand()
+	{
+		string_view name = parseWord();
+		if (name == "reg") {
+			string_view reg = parseWord();
+			auto eq = [&](const RegInfo& r) {
+				return StringOp::casecmp()(reg, r.name);
+			};
+			auto it8 = ranges::find_if(regs8, eq);
+			if (it8 != std::end(regs8)) {
+				if (!emit(REG8, it8->index)) return false;
+			} else {
+				auto it16 = ranges::find_if(regs16, eq);
+				if (it16 == std::end(regs16)) return false;
+				if (!emit(REG16, it16->index)) return false;
+			}
+		} else if ((name == "peek") || (name == "peek8") || (name == "peek_u8")) {
+			if (!parseAddress() || !emit(PEEK)) return false;
+		} else if ((name == "peek16") || (name == "peek_u16")) {
+			if (!parseAddress() || !emit(PEEK16)) return false;
+		} else if (name == "pc_in_slot") {
+			int ps, ss = -1;
+			if (!parseSlot(ps)) return false;
+			skipSpace();
+			if (!input.starts_with("]") && !parseSlot(ss)) return false;
+			if (!emit(PC_IN_SLOT, (ps & 0xFF) | ((ss & 0xFF) << 8))) return false;
+		} else {
+			return false;
+		}
+		return accept("]");
+	}
+
+	string_view input;
+	std::vector<Instr>& code;
+	unsigned depth = 0;
+};
+
+
+std::unique_ptr<CompiledCondition> CompiledCondition::compile(string_view expr)
+{
+	auto result = std::make_unique<CompiledCondition>();
+	Parser parser(expr, result->code);
+	if (!parser.parse()) return nullptr;
+	return result;
+}
+
+static int64_t readWord(CompiledCondition::Context& context,
+                        CompiledCondition::Source source,
+                        unsigned addr, bool bigEndian)
+{
+	unsigned b0 = context.read(source, addr + 0);
+	unsigned b1 = context.read(source, addr + 1);
+	return bigEndian ? (256 * b0 + b1) : (b0 + 256 * b1);
+}
+
+static bool pcInSlot(CompiledCondition::Context& context, int ps, int ss)
+{
+	// see 'address_in_slot' in share/scripts/_slot.tcl
+	auto pc = readWord(context, CompiledCondition::CPU_REGS, PC_INDEX, true);
+	int page = int(pc >> 14);
+	unsigned psReg = context.read(CompiledCondition::IO_PORTS, 0xA8);
+	int pcPs = (psReg >> (2 * page)) & 3;
+	if ((ps != -1) && (pcPs != ps)) return false;
+	if ((ss == -1) || !context.isExpanded(pcPs)) return true;
+	unsigned ssReg = context.read(CompiledCondition::SLOTTED_MEMORY,
+	                              0x40000 * pcPs + 0xFFFF);
+	int pcSs = ((ssReg ^ 255) >> (2 * page)) & 3;
+	return pcSs == ss;
+}
+
+bool CompiledCondition::evaluate(Context& context) const
+{
+	int64_t stack[MAX_STACK];
+	int64_t* sp = stack; // points past the top element
+	for (auto& instr : code) {
+		switch (instr.op) {
+		case LITERAL:
+			*sp++ = instr.value;
+			break;
+		case REG8:
+			*sp++ = context.read(CPU_REGS, unsigned(instr.value));
+			break;
+		case REG16:
+			*sp++ = readWord(context, CPU_REGS, unsigned(instr.value), true);
+			break;
+		case PEEK:
+			sp[-1] = context.read(MEMORY, unsigned(sp[-1]));
+			break;
+		case PEEK16:
+			sp[-1] = readWord(context, MEMORY, unsigned(sp[-1]), false);
+			break;
+		case PC_IN_SLOT:
+			*sp++ = pcInSlot(context, int8_t(instr.value & 0xFF),
+			                          int8_t(instr.value >> 8));
+			break;
+		case NEG:    sp[-1] = -sp[-1]; break;
+		case PLUS:   break;
+		case NOT:    sp[-1] = !sp[-1]; break;
+		case BITNOT: sp[-1] = ~sp[-1]; break;
+		default: {
+			int64_t y = *--sp;
+			int64_t& x = sp[-1];
+			switch (instr.op) {
+			case MUL:    x = x * y; break;
+			case ADD:    x = x + y; break;
+			case SUB:    x = x - y; break;
+			case SHL:    x = ((y >= 0) && (y < 32)) ? (x << y) : 0; break;
+			case SHR:    x = ((y >= 0) && (y < 64)) ? (x >> y) : (x < 0 ? -1 : 0); break;
+			case LT:     x = x <  y; break;
+			case LE:     x = x <= y; break;
+			case GT:     x = x >  y; break;
+			case GE:     x = x >= y; break;
+			case EQ:     x = x == y; break;
+			case NE:     x = x != y; break;
+			case BITAND: x = x & y; break;
+			case BITXOR: x = x ^ y; break;
+			case BITOR:  x = x | y; break;
+			case AND:    x = x && y; break;
+			case OR:     x = x || y; break;
+			default: assert(false);
+			}
+			break;
+		}
+		}
+	}
+	assert(sp == (stack + 1));
+	return stack[0] != 0;
+}
+
+} // namespace openmsx
@@ -0,0 +1,82 @@
+#ifndef COMPILEDCONDITION_HH
+#define COMPILEDCONDITION_HH
+
+#include "string_view.hh"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace openmsx {
+
+/** Native version of a breakpoint/condition expression.
+ *
+ * Conditions are checked before every emulated instruction, evaluating them
+ * via the Tcl interpreter makes emulation very slow. Though most conditions
+ * only use a small subset of the Tcl expression syntax. Such conditions are
+ * translated into a compact sequence of instructions for a small stack
+ * machine, which can be evaluated much faster.
+ *
+ * The supported subset:
+ *  - integer literals (decimal, 0x.. hexadecimal, 0b.. binary)
+ *  - parentheses
+ *  - unary operators:  - + ! ~
+ *  - binary operators: * + - << >> < <= > >= == != & ^ | && ||
+ *  - the commands [reg <name>], [peek <addr>], [peek16 <addr>] and
+ *    [pc_in_slot <ps> ?<ss>?], where <addr> is a literal or again one of
+ *    these commands
+ * For anything else compile() fails and the condition should be evaluated
+ * via Tcl. Note that this assumes the standard (script) implementation of
+ * these commands.
+ */
+class CompiledCondition
+{
+public:
+	enum Source { CPU_REGS, MEMORY, IO_PORTS, SLOTTED_MEMORY };
+
+	/** Provides the machine state needed to evaluate a condition. */
+	class Context
+	{
+	public:
+		/** Read a byte from the given debuggable.
+		  * @throws CommandException when address is out of range */
+		virtual unsigned read(Source source, unsigned address) = 0;
+		virtual bool isExpanded(int ps) = 0;
+	protected:
+		~Context() = default;
+	};
+
+	/** Returns nullptr if the expression is not in the supported subset.
+	  */
+	static std::unique_ptr<CompiledCondition> compile(string_view expr);
+
+	/** Evaluate the (compiled) expression.
+	  * @throws CommandException (only from Context::read()).
+	  */
+	bool evaluate(Context& context) const;
+
+private:
+	enum Op : uint8_t {
+		LITERAL,    // push constant
+		REG8,       // push 8-bit register
+		REG16,      // push 16-bit register
+		PEEK,       // replace top with byte in memory
+		PEEK16,     // replace top with 16-bit word in memory
+		PC_IN_SLOT, // push 'pc_in_slot' result
+		NEG, PLUS, NOT, BITNOT, // unary, operate on top
+		MUL, ADD, SUB, SHL, SHR, LT, LE, GT, GE, EQ, NE,
+		BITAND, BITXOR, BITOR, AND, OR, // binary, pop 2 push 1
+	};
+	struct Instr {
+		Op op;
+		int64_t value;
+	};
+	static const unsigned MAX_STACK = 32;
+
+	class Parser;
+
+	std::vector<Instr> code;
+};
+
+} // namespace openmsx
+
+#endif
@@ -3,7 +3,9 @@
 
 #include "EmuTime.hh"
 #include "openmsx.hh"
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace openmsx {
 
@@ -21,6 +23,41 @@ class MSXCPUInterface;
 unsigned dasm(const MSXCPUInterface& interf, word pc, byte buf[4],
               std::string& dest, EmuTime::param time);
 
+/** Same as above, but disassemble the given (max 4) opcode bytes instead of
+  * reading them from memory.
+  */
+unsigned dasm(const byte opcode[4], word pc, std::string& dest);
+
+/** Remembers the result of recently disassembled instructions.
+  *
+  * Debugger views disassemble (mostly) the same range again on every
+  * refresh and the trace output disassembles the same loops over and over.
+  * The entries are keyed by the address together with the (max 4) opcode
+  * bytes, so no invalidation is needed on memory writes or slot switches:
+  * changed memory simply doesn't match the old entry anymore.
+  */
+class DasmCache
+{
+public:
+	DasmCache();
+
+	/** Same as dasm(interf, pc, buf, dest, time), but always peeks 4
+	  * bytes (peeking has no side effects). */
+	unsigned dasm(const MSXCPUInterface& interf, word pc, byte buf[4],
+	              std::string& dest, EmuTime::param time);
+	/** Same as dasm(opcode, pc, dest). */
+	unsigned dasm(const byte opcode[4], word pc, std::string& dest);
+
+private:
+	struct Entry {
+		uint64_t key = 0; // 0 means unused
+		char text[22];
+		uint8_t textLen;
+		uint8_t len;
+	};
+	std::vector<Entry> entries;
+};
+
 } // namespace openmsx
 
 #endif
@@ -9,18 +9,31 @@ namespace openmsx {
 // class IRQSource
 
 IRQSource::IRQSource(MSXCPU& cpu_)
-	: cpu(cpu_)
+	: cpu(cpu_), bit(cpu.allocateIRQBit())
 {
 }
 
+IRQSource::~IRQSource()
+{
+	if (bit) cpu.freeIRQBit(bit);
+}
+
 void IRQSource::raise()
 {
-	cpu.raiseIRQ();
+	if (bit) {
+		cpu.raiseIRQ(bit);
+	} else {
+		cpu.raiseIRQ();
+	}
 }
 
 void IRQSource::lower()
 {
-	cpu.lowerIRQ();
+	if (bit) {
+		cpu.lowerIRQ(bit);
+	} else {
+		cpu.lowerIRQ();
+	}
 }
 
 
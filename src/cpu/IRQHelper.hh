@@ -4,6 +4,7 @@
 #include "Probe.hh"
 #include "MSXMotherBoard.hh"
 #include "serialize.hh"
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -24,10 +25,12 @@ class IRQSource
 {
 protected:
 	explicit IRQSource(MSXCPU& cpu);
+	~IRQSource();
 	void raise();
 	void lower();
 private:
 	MSXCPU& cpu;
+	const uint64_t bit; // see MSXCPU::allocateIRQBit()
 };
 
 // supports <optional_irq> tag in hardware config
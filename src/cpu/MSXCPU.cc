@@ -23,15 +23,20 @@ MSXCPU::MSXCPU(MSXMotherBoard& motherboard_)
 	, traceSetting(
 		motherboard.getCommandController(), "cputrace",
 		"CPU tracing on/off", false, Setting::DONT_SAVE)
+	, idleLoopSetting(
+		motherboard.getCommandController(), "skip_idle_loops",
+		"detect busy loops that wait for an interrupt or VBLANK and "
+		"skip them, this changes the timing slightly (like HALT)", true)
 	, diHaltCallback(
 		motherboard.getCommandController(), "di_halt_callback",
 		"Tcl proc called when the CPU executed a DI/HALT sequence")
 	, z80(std::make_unique<CPUCore<Z80TYPE>>(
-		motherboard, "z80", traceSetting,
+		motherboard, "z80", traceSetting, idleLoopSetting, traceBuffer,
 		diHaltCallback, EmuTime::zero))
 	, r800(motherboard.isTurboR()
 		? std::make_unique<CPUCore<R800TYPE>>(
-			motherboard, "r800", traceSetting,
+			motherboard, "r800", traceSetting, idleLoopSetting,
+			traceBuffer,
 			diHaltCallback, EmuTime::zero)
 		: nullptr)
 	, timeInfo(motherboard.getMachineInfoCommand())
@@ -49,6 +54,7 @@ MSXCPU::MSXCPU(MSXMotherBoard& motherboard_)
 	motherboard.getDebugger().setCPU(this);
 	motherboard.getScheduler().setCPU(this);
 	traceSetting.attach(*this);
+	idleLoopSetting.attach(*this);
 
 	z80->freqLocked.attach(*this);
 	z80->freqValue.attach(*this);
@@ -61,6 +67,7 @@ MSXCPU::MSXCPU(MSXMotherBoard& motherboard_)
 MSXCPU::~MSXCPU()
 {
 	traceSetting.detach(*this);
+	idleLoopSetting.detach(*this);
 	z80->freqLocked.detach(*this);
 	z80->freqValue.detach(*this);
 	if (r800) {
@@ -140,7 +147,9 @@ void MSXCPU::setNextSyncPoint(EmuTime::param time)
 
 void MSXCPU::updateVisiblePage(byte page, byte primarySlot, byte secondarySlot)
 {
-	invalidateMemCache(page * 0x4000, 0x4000);
+	unsigned slot = 4 * primarySlot + secondarySlot;
+	z80Active ? z80 ->switchMemCachePage(page, slot)
+	          : r800->switchMemCachePage(page, slot);
 	if (r800) r800->updateVisiblePage(page, primarySlot, secondarySlot);
 }
 
@@ -150,12 +159,18 @@ void MSXCPU::invalidateMemCache(word start, unsigned size)
 	          : r800->invalidateMemCache(start, size);
 }
 
-void MSXCPU::raiseIRQ()
+void MSXCPU::refillMemCache(word start, unsigned size)
+{
+	z80Active ? z80 ->refillMemCache(start, size)
+	          : r800->refillMemCache(start, size);
+}
+
+void MSXCPU::raiseCoreIRQ()
 {
 	          z80 ->raiseIRQ();
 	if (r800) r800->raiseIRQ();
 }
-void MSXCPU::lowerIRQ()
+void MSXCPU::lowerCoreIRQ()
 {
 	          z80 ->lowerIRQ();
 	if (r800) r800->lowerIRQ();
@@ -209,6 +224,24 @@ CPURegs& MSXCPU::getRegisters()
 	}
 }
 
+void MSXCPU::startTrace(size_t numRecords)
+{
+	traceBuffer.start(numRecords);
+	updateTracing();
+}
+
+void MSXCPU::stopTrace()
+{
+	traceBuffer.stop();
+	updateTracing();
+}
+
+void MSXCPU::updateTracing()
+{
+	          z80 ->updateTracing();
+	if (r800) r800->updateTracing();
+}
+
 void MSXCPU::update(const Setting& setting)
 {
 	          z80 ->update(setting);
@@ -226,6 +259,14 @@ void MSXCPU::disasmCommand(
 	          : r800->disasmCommand(interp, tokens, result);
 }
 
+void MSXCPU::disasmBlockCommand(
+	Interpreter& interp, span<const TclObject> tokens,
+	TclObject& result) const
+{
+	z80Active ? z80 ->disasmBlockCommand(interp, tokens, result)
+	          : r800->disasmBlockCommand(interp, tokens, result);
+}
+
 void MSXCPU::setPaused(bool paused)
 {
 	if (z80Active) {
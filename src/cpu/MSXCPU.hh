@@ -5,11 +5,14 @@
 #include "SimpleDebuggable.hh"
 #include "Observer.hh"
 #include "BooleanSetting.hh"
+#include "CPUTraceBuffer.hh"
 #include "EmuTime.hh"
 #include "TclCallback.hh"
 #include "serialize_meta.hh"
 #include "openmsx.hh"
 #include "span.hh"
+#include <cassert>
+#include <cstdint>
 #include <memory>
 
 namespace openmsx {
@@ -44,8 +47,9 @@ public:
 	/** Sets DRAM or ROM mode (influences memory access speed for R800). */
 	void setDRAMmode(bool dram);
 
-	/** Inform CPU of bank switch. This will invalidate memory cache and
-	  * update memory timings on R800. */
+	/** Inform CPU of bank switch. This will switch the memory cache of
+	  * that page to the one of the new slot and update memory timings on
+	  * R800. */
 	void updateVisiblePage(byte page, byte primarySlot, byte secondarySlot);
 
 	/** Invalidate the CPU its cache for the interval [start, start + size)
@@ -53,18 +57,60 @@ public:
 	  * method when a 'memory switch' occurs. */
 	void invalidateMemCache(word start, unsigned size);
 
+	/** Like invalidateMemCache(), but immediately refill the read cache
+	  * lines of the interval (only for the currently visible slot). See
+	  * MSXDevice::updateMemCache(). */
+	void refillMemCache(word start, unsigned size);
+
 	/** This method raises a maskable interrupt. A device may call this
 	  * method more than once. If the device wants to lower the
 	  * interrupt again it must call the lowerIRQ() method exactly as
 	  * many times.
 	  * Before using this method take a look at IRQHelper. */
-	void raiseIRQ();
+	void raiseIRQ() {
+		if (!anyIRQPending()) raiseCoreIRQ();
+		++irqCount;
+	}
 
 	/** This methods lowers the maskable interrupt again. A device may never
 	  * call this method more often than it called the method
 	  * raiseIRQ().
 	  * Before using this method take a look at IRQHelper. */
-	void lowerIRQ();
+	void lowerIRQ() {
+		assert(irqCount > 0);
+		--irqCount;
+		if (!anyIRQPending()) lowerCoreIRQ();
+	}
+
+	/** Each IRQSource gets its own bit in a 64-bit mask, so raising or
+	  * lowering its IRQ is a single bit operation, only the transitions
+	  * between 'none pending' and 'some pending' reach the CPU cores.
+	  * Returns 0 when all bits are in use, the source must then use
+	  * raiseIRQ()/lowerIRQ(). */
+	uint64_t allocateIRQBit() {
+		uint64_t bit = ~usedIRQBits & (usedIRQBits + 1); // lowest free
+		usedIRQBits |= bit;
+		return bit;
+	}
+	void freeIRQBit(uint64_t bit) {
+		assert(!(pendingIRQBits & bit));
+		usedIRQBits &= ~bit;
+	}
+	/** Set or clear the IRQ of the source with the given bit. Unlike
+	  * raiseIRQ()/lowerIRQ() this may be called repeatedly. */
+	void raiseIRQ(uint64_t bit) {
+		if (!anyIRQPending()) raiseCoreIRQ();
+		pendingIRQBits |= bit;
+	}
+	void lowerIRQ(uint64_t bit) {
+		if (!(pendingIRQBits & bit)) return;
+		pendingIRQBits &= ~bit;
+		if (!anyIRQPending()) lowerCoreIRQ();
+	}
+	/** Is any maskable interrupt requested? */
+	bool anyIRQPending() const {
+		return pendingIRQBits || irqCount;
+	}
 
 	/** This method raises a non-maskable interrupt. A device may call this
 	  * method more than once. If the device wants to lower the
@@ -102,6 +148,9 @@ public:
 	void disasmCommand(Interpreter& interp,
 	                   span<const TclObject> tokens,
                            TclObject& result) const;
+	void disasmBlockCommand(Interpreter& interp,
+	                        span<const TclObject> tokens,
+	                        TclObject& result) const;
 
 	/** (un)pause CPU. During pause the CPU executes NOP instructions
 	  * continuously (just like during HALT). Used by turbor hw pause. */
@@ -115,6 +164,16 @@ public:
 
 	CPURegs& getRegisters();
 
+	/** Start/stop recording the executed instructions in the binary
+	  * trace buffer (see CPUTraceBuffer). */
+	void startTrace(size_t numRecords);
+	void stopTrace();
+	CPUTraceBuffer& getTraceBuffer() { return traceBuffer; }
+
+	/** Must be called when the memory heatmap is enabled or disabled
+	  * (executed instructions are counted via the trace path). */
+	void updateTracing();
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -133,8 +192,13 @@ private:
 	// Observer<Setting>
 	void update(const Setting& setting) override;
 
+	void raiseCoreIRQ();
+	void lowerCoreIRQ();
+
 	MSXMotherBoard& motherboard;
 	BooleanSetting traceSetting;
+	BooleanSetting idleLoopSetting;
+	CPUTraceBuffer traceBuffer;
 	TclCallback diHaltCallback;
 	const std::unique_ptr<CPUCore<Z80TYPE>> z80;
 	const std::unique_ptr<CPUCore<R800TYPE>> r800; // can be nullptr
@@ -166,6 +230,9 @@ private:
 	} debuggable;
 
 	EmuTime reference;
+	uint64_t usedIRQBits = 0;
+	uint64_t pendingIRQBits = 0;
+	unsigned irqCount = 0; // raiseIRQ() calls without bit
 	bool z80Active;
 	bool newZ80Active;
 };
@@ -2,6 +2,8 @@
 #include "DebugCondition.hh"
 #include "DummyDevice.hh"
 #include "CommandException.hh"
+#include "Debuggable.hh"
+#include "Debugger.hh"
 #include "TclObject.hh"
 #include "Interpreter.hh"
 #include "Reactor.hh"
@@ -44,6 +46,7 @@ bool MSXCPUInterface::breaked = false;
 bool MSXCPUInterface::continued = false;
 bool MSXCPUInterface::step = false;
 MSXCPUInterface::BreakPoints MSXCPUInterface::breakPoints;
+std::bitset<0x10000> MSXCPUInterface::breakPointMap;
 //TODO watchpoints
 MSXCPUInterface::Conditions  MSXCPUInterface::conditions;
 
@@ -55,12 +58,14 @@ static unsigned breakedSettingCount = 0;
 static const byte SECONDARY_SLOT_BIT = 0x01;
 static const byte MEMORY_WATCH_BIT   = 0x02;
 static const byte GLOBAL_RW_BIT      = 0x04;
+static const byte HEATMAP_BIT        = 0x08;
 
 
 MSXCPUInterface::MSXCPUInterface(MSXMotherBoard& motherBoard_)
 	: memoryDebug       (motherBoard_)
 	, slottedMemoryDebug(motherBoard_)
 	, ioDebug           (motherBoard_)
+	, memoryHeatmap(motherBoard_.getDebugger())
 	, slotInfo(motherBoard_.getMachineInfoCommand())
 	, subSlottedInfo(motherBoard_.getMachineInfoCommand())
 	, externalSlotInfo(motherBoard_.getMachineInfoCommand())
@@ -183,10 +188,13 @@ byte MSXCPUInterface::readMemSlow(word address, EmuTime::param time)
 				g.device->globalRead(address, time);
 			}
 		}
+		if (unlikely(memoryHeatmap.isEnabled())) {
+			memoryHeatmap.read(getSlotAddress(address));
+		}
 		// execute read watches before actual read
 		if (readWatchSet[address >> CacheLine::BITS]
 		                [address &  CacheLine::LOW]) {
-			executeMemWatch(WatchPoint::READ_MEM, address);
+			executeMemWatch(WatchPoint::READ_MEM, address, time);
 		}
 	}
 	if (unlikely((address == 0xFFFF) && isExpanded(primarySlotState[3]))) {
@@ -216,14 +224,33 @@ void MSXCPUInterface::writeMemSlow(word address, byte value, EmuTime::param time
 				g.device->globalWrite(address, value, time);
 			}
 		}
+		if (unlikely(memoryHeatmap.isEnabled())) {
+			memoryHeatmap.write(getSlotAddress(address));
+		}
 		// execute write watches after actual write
 		if (writeWatchSet[address >> CacheLine::BITS]
 		                 [address &  CacheLine::LOW]) {
-			executeMemWatch(WatchPoint::WRITE_MEM, address, value);
+			executeMemWatch(WatchPoint::WRITE_MEM, address, time, value);
 		}
 	}
 }
 
+const byte* MSXCPUInterface::getWatchedReadCacheLine(word start) const
+{
+	if (disallowReadCache[start >> CacheLine::BITS] != MEMORY_WATCH_BIT) {
+		return nullptr;
+	}
+	return visibleDevices[start >> 14]->getReadCacheLine(start);
+}
+
+byte* MSXCPUInterface::getWatchedWriteCacheLine(word start) const
+{
+	if (disallowWriteCache[start >> CacheLine::BITS] != MEMORY_WATCH_BIT) {
+		return nullptr;
+	}
+	return visibleDevices[start >> 14]->getWriteCacheLine(start);
+}
+
 void MSXCPUInterface::setExpanded(int ps)
 {
 	if (expanded[ps] == 0) {
@@ -467,6 +494,8 @@ void MSXCPUInterface::registerSlot(
 			assert(false);
 		}
 	}
+	// also drop the cached page of this slot (when not visible)
+	msxcpu.invalidateMemCache(page * 0x4000, 0x4000);
 	updateVisible(page);
 }
 
@@ -487,6 +516,8 @@ void MSXCPUInterface::unregisterSlot(
 		assert(slot == &device);
 		slot = dummyDevice.get();
 	}
+	// also drop the cached page of this slot (when not visible)
+	msxcpu.invalidateMemCache(page * 0x4000, 0x4000);
 	updateVisible(page);
 }
 
@@ -732,13 +763,16 @@ void MSXCPUInterface::insertBreakPoint(const BreakPoint& bp)
 {
 	auto it = ranges::upper_bound(breakPoints, bp, CompareBreakpoints());
 	breakPoints.insert(it, bp);
+	breakPointMap[bp.getAddress()] = true;
 }
 
 void MSXCPUInterface::removeBreakPoint(const BreakPoint& bp)
 {
-	auto range = ranges::equal_range(breakPoints, bp.getAddress(), CompareBreakpoints());
+	word address = bp.getAddress(); // bp is destroyed by erase()
+	auto range = ranges::equal_range(breakPoints, address, CompareBreakpoints());
 	breakPoints.erase(find_if_unguarded(range.first, range.second,
 		[&](const BreakPoint& i) { return &i == &bp; }));
+	updateBreakPointMap(address);
 }
 void MSXCPUInterface::removeBreakPoint(unsigned id)
 {
@@ -746,9 +780,52 @@ void MSXCPUInterface::removeBreakPoint(unsigned id)
 		[&](const BreakPoint& i) { return i.getId() == id; });
 	// could be ==end for a breakpoint that removes itself AND has the -once flag set
 	if (it != breakPoints.end()) {
+		word address = it->getAddress();
 		breakPoints.erase(it);
+		updateBreakPointMap(address);
 	}
 }
+void MSXCPUInterface::updateBreakPointMap(word address)
+{
+	auto range = ranges::equal_range(breakPoints, address, CompareBreakpoints());
+	breakPointMap[address] = range.first != range.second;
+}
+
+// Gives compiled breakpoint conditions access to the machine state, via the
+// same debuggables as used by the Tcl implementation of these conditions.
+class ConditionContext final : public CompiledCondition::Context
+{
+public:
+	explicit ConditionContext(MSXMotherBoard& motherBoard_)
+		: motherBoard(motherBoard_) {}
+
+	unsigned read(CompiledCondition::Source source, unsigned address) override
+	{
+		static const char* const names[] = {
+			"CPU regs", "memory", "ioports", "slotted memory"
+		};
+		auto*& debuggable = debuggables[source];
+		if (!debuggable) {
+			debuggable = motherBoard.getDebugger().findDebuggable(names[source]);
+			if (!debuggable) {
+				throw CommandException("No such debuggable: ", names[source]);
+			}
+		}
+		if (address >= debuggable->getSize()) {
+			throw CommandException("Invalid address");
+		}
+		return debuggable->read(address);
+	}
+
+	bool isExpanded(int ps) override
+	{
+		return motherBoard.getCPUInterface().isExpanded(ps);
+	}
+
+private:
+	MSXMotherBoard& motherBoard;
+	Debuggable* debuggables[4] = {};
+};
 
 void MSXCPUInterface::checkBreakPoints(
 	std::pair<BreakPoints::const_iterator,
@@ -761,15 +838,16 @@ void MSXCPUInterface::checkBreakPoints(
 	BreakPoints bpCopy(range.first, range.second);
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
+	ConditionContext context(motherBoard);
 	for (auto& p : bpCopy) {
-		p.checkAndExecute(globalCliComm, interp);
+		p.checkAndExecute(globalCliComm, interp, &context);
 		if (p.onlyOnce()) {
 			removeBreakPoint(p.getId());
 		}
 	}
 	auto condCopy = conditions;
 	for (auto& c : condCopy) {
-		c.checkAndExecute(globalCliComm, interp);
+		c.checkAndExecute(globalCliComm, interp, &context);
 		if (c.onlyOnce()) {
 			removeCondition(c.getId());
 		}
@@ -913,35 +991,66 @@ void MSXCPUInterface::updateMemWatch(WatchPoint::Type type)
 	msxcpu.invalidateMemCache(0x0000, 0x10000);
 }
 
+void MSXCPUInterface::updateHeatmap()
+{
+	// Counting is done in readMemSlow() and writeMemSlow(), so disallow
+	// caching in the whole address space.
+	for (unsigned i = 0; i < CacheLine::NUM; ++i) {
+		if (memoryHeatmap.isEnabled()) {
+			disallowReadCache [i] |=  HEATMAP_BIT;
+			disallowWriteCache[i] |=  HEATMAP_BIT;
+		} else {
+			disallowReadCache [i] &= ~HEATMAP_BIT;
+			disallowWriteCache[i] &= ~HEATMAP_BIT;
+		}
+	}
+	msxcpu.invalidateMemCache(0x0000, 0x10000);
+	// executed instructions are counted via the CPU trace path
+	msxcpu.updateTracing();
+}
+
 void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
-                                      unsigned address, unsigned value)
+                                      unsigned address, EmuTime::param time,
+                                      unsigned value)
 {
 	assert(!watchPoints.empty());
 	if (isFastForward()) return;
 
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
-	interp.setVariable(TclObject("wp_last_address"),
-	                   TclObject(int(address)));
-	if (value != ~0u) {
-		interp.setVariable(TclObject("wp_last_value"),
-		                   TclObject(int(value)));
-	}
+	// Only set the Tcl variables when really needed: logging watchpoints
+	// without condition can be handled natively.
+	bool varsSet = false;
 
 	auto wpCopy = watchPoints;
 	for (auto& w : wpCopy) {
 		if ((w->getBeginAddress() <= address) &&
 		    (w->getEndAddress()   >= address) &&
 		    (w->getType()         == type)) {
-			w->checkAndExecute(globalCliComm, interp);
+			if (w->isUnconditionalLog()) {
+				w->getLog()->add(time, address, value);
+				continue;
+			}
+			if (!varsSet) {
+				interp.setVariable(TclObject("wp_last_address"),
+				                   TclObject(int(address)));
+				if (value != ~0u) {
+					interp.setVariable(TclObject("wp_last_value"),
+					                   TclObject(int(value)));
+				}
+				varsSet = true;
+			}
+			w->triggered(globalCliComm, interp, time, address, value);
 			if (w->onlyOnce()) {
 				removeWatchPoint(w);
 			}
 		}
 	}
 
-	interp.unsetVariable("wp_last_address");
-	interp.unsetVariable("wp_last_value");
+	if (varsSet) {
+		interp.unsetVariable("wp_last_address");
+		interp.unsetVariable("wp_last_value");
+	}
 }
 
 
@@ -996,6 +1105,7 @@ void MSXCPUInterface::cleanup()
 	// TODO it would be nicer if breakpoints and conditions were not
 	//      global objects.
 	breakPoints.clear();
+	breakPointMap.reset();
 	conditions.clear();
 }
 
@@ -1164,6 +1274,52 @@ void MSXCPUInterface::IODebug::write(unsigned address, byte value, EmuTime::para
 }
 
 
+// class MemoryHeatmap
+
+MSXCPUInterface::MemoryHeatmap::MemoryHeatmap(Debugger& debugger_)
+	: Heatmap(debugger_, "memory",
+	          "CPU memory accesses, per page of each (sub)slot. The keys "
+	          "are formatted as <ps>[-<ss>]:<address>.", 16 * 0x10000)
+{
+}
+
+void MSXCPUInterface::MemoryHeatmap::enabledChanged()
+{
+	OUTER(MSXCPUInterface, memoryHeatmap).updateHeatmap();
+}
+
+std::string MSXCPUInterface::MemoryHeatmap::formatPage(unsigned page) const
+{
+	auto& interface = OUTER(MSXCPUInterface, memoryHeatmap);
+	unsigned address = (page << PAGE_BITS) & 0xFFFF;
+	unsigned ps = page >> (18 - PAGE_BITS);
+	unsigned ss = (page >> (16 - PAGE_BITS)) & 3;
+	std::string result = strCat(ps);
+	if (interface.isExpanded(ps)) strAppend(result, '-', ss);
+	strAppend(result, ':', hex_string<4>(address));
+	return result;
+}
+
+
+// class MemoryCoverage
+
+void MSXCPUInterface::MemoryCoverage::enabledChanged()
+{
+	// executed instructions are recorded via the CPU trace path
+	OUTER(MSXCPUInterface, coverage).msxcpu.updateTracing();
+}
+
+std::string MSXCPUInterface::MemoryCoverage::formatSlot(unsigned slot) const
+{
+	// same format as the memory heatmap
+	auto& interface = OUTER(MSXCPUInterface, coverage);
+	unsigned ps = slot >> 2;
+	std::string result = strCat(ps);
+	if (interface.isExpanded(ps)) strAppend(result, '-', slot & 3);
+	return result;
+}
+
+
 // class IOInfo
 
 MSXCPUInterface::IOInfo::IOInfo(InfoCommand& machineInfoCommand, const char* name_)
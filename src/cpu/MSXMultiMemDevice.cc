@@ -2,11 +2,11 @@
 #include "DummyDevice.hh"
 #include "MSXCPUInterface.hh"
 #include "TclObject.hh"
-#include "likely.hh"
 #include "ranges.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "view.hh"
+#include "xrange.hh"
 #include <cassert>
 
 namespace openmsx {
@@ -30,6 +30,7 @@ MSXMultiMemDevice::MSXMultiMemDevice(const HardwareConfig& hwConf)
 {
 	// add sentinel at the end
 	ranges.emplace_back(0x0000, 0x10000, getCPUInterface().getDummyDevice());
+	updateLineDevices();
 }
 
 MSXMultiMemDevice::~MSXMultiMemDevice()
@@ -60,11 +61,35 @@ void MSXMultiMemDevice::add(MSXDevice& device, int base, int size)
 {
 	assert(canAdd(base, size));
 	ranges.insert(begin(ranges), Range(base, size, device));
+	updateLineDevices();
 }
 
 void MSXMultiMemDevice::remove(MSXDevice& device, int base, int size)
 {
 	ranges.erase(rfind_unguarded(ranges, Range(base, size, device)));
+	updateLineDevices();
+}
+
+void MSXMultiMemDevice::updateLineDevices()
+{
+	for (auto line : xrange(CacheLine::NUM)) {
+		unsigned start = line * CacheLine::SIZE;
+		// The first range that overlaps this line must cover the
+		// full line, otherwise (part of) the line is handled by
+		// another device.
+		MSXDevice* owner = nullptr;
+		for (auto& r : ranges) {
+			if (overlap(start, CacheLine::SIZE, r.base, r.size) ||
+			    isInside(r.base, start, CacheLine::SIZE)) {
+				if (isInside(start,                      r.base, r.size) &&
+				    isInside(start + CacheLine::SIZE - 1, r.base, r.size)) {
+					owner = r.device;
+				}
+				break;
+			}
+		}
+		lineDevices[line] = owner;
+	}
 }
 
 std::vector<MSXDevice*> MSXMultiMemDevice::getDevices() const
@@ -104,44 +129,42 @@ MSXDevice* MSXMultiMemDevice::searchDevice(unsigned address) const
 	return searchRange(address).device;
 }
 
+MSXDevice* MSXMultiMemDevice::lookupDevice(unsigned address) const
+{
+	if (auto* device = lineDevices[address >> CacheLine::BITS]) {
+		return device;
+	}
+	return searchDevice(address);
+}
+
 byte MSXMultiMemDevice::readMem(word address, EmuTime::param time)
 {
-	return searchDevice(address)->readMem(address, time);
+	return lookupDevice(address)->readMem(address, time);
 }
 
 byte MSXMultiMemDevice::peekMem(word address, EmuTime::param time) const
 {
-	return searchDevice(address)->peekMem(address, time);
+	return lookupDevice(address)->peekMem(address, time);
 }
 
 void MSXMultiMemDevice::writeMem(word address, byte value, EmuTime::param time)
 {
-	searchDevice(address)->writeMem(address, value, time);
+	lookupDevice(address)->writeMem(address, value, time);
 }
 
 const byte* MSXMultiMemDevice::getReadCacheLine(word start) const
 {
 	assert((start & CacheLine::HIGH) == start); // start is aligned
-	// Because start is aligned we don't need to wory about the begin
-	// address of the range. But we must make sure the end of the range
-	// doesn't only fill a partial cacheline.
-	const auto& range = searchRange(start);
-	if (unlikely(((range.base + range.size) & CacheLine::HIGH) == start)) {
-		// The end of this memory device only fills a partial
-		// cacheline. This can't be cached.
-		return nullptr;
-	}
-	return searchDevice(start)->getReadCacheLine(start);
+	// Only cacheable when a single device handles the full cacheline.
+	auto* device = lineDevices[start >> CacheLine::BITS];
+	return device ? device->getReadCacheLine(start) : nullptr;
 }
 
 byte* MSXMultiMemDevice::getWriteCacheLine(word start) const
 {
 	assert((start & CacheLine::HIGH) == start);
-	const auto& range = searchRange(start);
-	if (unlikely(((range.base + range.size) & CacheLine::HIGH) == start)) {
-		return nullptr;
-	}
-	return searchDevice(start)->getWriteCacheLine(start);
+	auto* device = lineDevices[start >> CacheLine::BITS];
+	return device ? device->getWriteCacheLine(start) : nullptr;
 }
 
 } // namespace openmsx
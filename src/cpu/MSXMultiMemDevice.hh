@@ -2,6 +2,8 @@
 #define MSXMULTIMEMDEVICE_HH
 
 #include "MSXMultiDevice.hh"
+#include "CacheLine.hh"
+#include <array>
 #include <vector>
 
 namespace openmsx {
@@ -39,8 +41,16 @@ private:
 
 	const Range& searchRange(unsigned address) const;
 	MSXDevice* searchDevice(unsigned address) const;
+	MSXDevice* lookupDevice(unsigned address) const;
+	void updateLineDevices();
 
 	std::vector<Range> ranges; // ordered (sentinel at the back)
+
+	// For each cache line the device that handles the full line, or
+	// nullptr when the line is shared by several devices. Rebuilt when
+	// a range is added or removed, so that most accesses don't need to
+	// search the list of ranges.
+	std::array<MSXDevice*, CacheLine::NUM> lineDevices;
 };
 
 } // namespace openmsx
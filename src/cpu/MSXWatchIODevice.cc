@@ -31,11 +31,17 @@ MSXWatchIODevice& WatchIO::getDevice(byte port)
 	return *ios[port - begin];
 }
 
-void WatchIO::doReadCallback(unsigned port)
+void WatchIO::doReadCallback(unsigned port, EmuTime::param time)
 {
 	auto& cpuInterface = motherboard.getCPUInterface();
 	if (cpuInterface.isFastForward()) return;
 
+	if (isUnconditionalLog()) {
+		// fast path, no need to go via Tcl
+		getLog()->add(time, port, ~0u);
+		return;
+	}
+
 	auto& cliComm = motherboard.getReactor().getGlobalCliComm();
 	auto& interp  = motherboard.getReactor().getInterpreter();
 	interp.setVariable(TclObject("wp_last_address"), TclObject(int(port)));
@@ -43,7 +49,7 @@ void WatchIO::doReadCallback(unsigned port)
 	// keep this object alive by holding a shared_ptr to it, for the case
 	// this watchpoint deletes itself in checkAndExecute()
 	auto keepAlive = shared_from_this();
-	checkAndExecute(cliComm, interp);
+	triggered(cliComm, interp, time, port, ~0u);
 	if (onlyOnce()) {
 		cpuInterface.removeWatchPoint(keepAlive);
 	}
@@ -51,11 +57,17 @@ void WatchIO::doReadCallback(unsigned port)
 	interp.unsetVariable("wp_last_address");
 }
 
-void WatchIO::doWriteCallback(unsigned port, unsigned value)
+void WatchIO::doWriteCallback(unsigned port, unsigned value, EmuTime::param time)
 {
 	auto& cpuInterface = motherboard.getCPUInterface();
 	if (cpuInterface.isFastForward()) return;
 
+	if (isUnconditionalLog()) {
+		// fast path, no need to go via Tcl
+		getLog()->add(time, port, value);
+		return;
+	}
+
 	auto& cliComm = motherboard.getReactor().getGlobalCliComm();
 	auto& interp  = motherboard.getReactor().getInterpreter();
 	interp.setVariable(TclObject("wp_last_address"), TclObject(int(port)));
@@ -63,7 +75,7 @@ void WatchIO::doWriteCallback(unsigned port, unsigned value)
 
 	// see comment in doReadCallback() above
 	auto keepAlive = shared_from_this();
-	checkAndExecute(cliComm, interp);
+	triggered(cliComm, interp, time, port, value);
 	if (onlyOnce()) {
 		cpuInterface.removeWatchPoint(keepAlive);
 	}
@@ -100,7 +112,7 @@ byte MSXWatchIODevice::readIO(word port, EmuTime::param time)
 	assert(device);
 
 	// first trigger watchpoint, then read from device
-	watchIO.doReadCallback(port);
+	watchIO.doReadCallback(port, time);
 	return device->readIO(port, time);
 }
 
@@ -110,7 +122,7 @@ void MSXWatchIODevice::writeIO(word port, byte value, EmuTime::param time)
 
 	// first write to device, then trigger watchpoint
 	device->writeIO(port, value, time);
-	watchIO.doWriteCallback(port, value);
+	watchIO.doWriteCallback(port, value, time);
 }
 
 } // namespace openmsx
@@ -15,4 +15,16 @@ WatchPoint::WatchPoint(TclObject command_, TclObject condition_,
 	assert(beginAddr <= endAddr);
 }
 
+void WatchPoint::triggered(GlobalCliComm& cliComm, Interpreter& interp,
+                           EmuTime::param time, unsigned address, unsigned value)
+{
+	if (log) {
+		if (isTrue(cliComm, interp, nullptr)) {
+			log->add(time, address, value);
+		}
+	} else {
+		checkAndExecute(cliComm, interp);
+	}
+}
+
 } // namespace openmsx
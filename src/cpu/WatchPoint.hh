@@ -2,9 +2,50 @@
 #define WATCHPOINT_HH
 
 #include "BreakPointBase.hh"
+#include "EmuTime.hh"
+#include "circular_buffer.hh"
+#include <memory>
 
 namespace openmsx {
 
+/** Records the accesses that triggered a (logging) watchpoint.
+ *  Instead of executing a Tcl command for every access, a logging watchpoint
+ *  only appends an entry to this (preallocated) buffer. The buffer is then
+ *  emptied in bulk, e.g. once per frame. When the buffer is full, the oldest
+ *  entries get dropped.
+ */
+class AccessLog
+{
+public:
+	struct Entry {
+		Entry(EmuTime::param time_, unsigned address_, unsigned value_)
+			: time(time_), address(address_), value(value_) {}
+		EmuTime time;
+		unsigned address;
+		unsigned value; // ~0u for reads
+	};
+
+	explicit AccessLog(size_t capacity)
+		: entries(capacity) {}
+
+	void add(EmuTime::param time, unsigned address, unsigned value)
+	{
+		if (entries.full()) {
+			entries.pop_front();
+			++dropped;
+		}
+		entries.push_back(Entry(time, address, value));
+	}
+
+	const circular_buffer<Entry>& getEntries() const { return entries; }
+	size_t getDropped() const { return dropped; }
+	void clear() { entries.clear(); dropped = 0; }
+
+private:
+	circular_buffer<Entry> entries;
+	size_t dropped = 0;
+};
+
 /** Base class for CPU breakpoints.
  *  For performance reasons every bp is associated with exactly one
  *  (immutable) address.
@@ -26,7 +67,24 @@ public:
 	unsigned getBeginAddress() const { return beginAddr; }
 	unsigned getEndAddress()   const { return endAddr; }
 
+	/** When a log is set, matching accesses are recorded in that log
+	  * instead of executing the command. The log is shared, so that it
+	  * survives transferring the watchpoint to another machine. */
+	void setLog(std::shared_ptr<AccessLog> log_) { log = std::move(log_); }
+	const std::shared_ptr<AccessLog>& getLog() const { return log; }
+
+	/** Logging watchpoint without condition: can be handled without
+	  * involving the Tcl interpreter at all. */
+	bool isUnconditionalLog() const { return log && getCondition().empty(); }
+
+	/** Handle an access that lies in the range of this watchpoint. The Tcl
+	  * variables 'wp_last_address' and 'wp_last_value' must already be set.
+	  */
+	void triggered(GlobalCliComm& cliComm, Interpreter& interp,
+	               EmuTime::param time, unsigned address, unsigned value);
+
 private:
+	std::shared_ptr<AccessLog> log; // can be nullptr
 	unsigned id;
 	unsigned beginAddr;
 	unsigned endAddr;
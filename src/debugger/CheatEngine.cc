@@ -0,0 +1,197 @@
+#include "CheatEngine.hh"
+#include "CommandException.hh"
+#include "Debuggable.hh"
+#include "Debugger.hh"
+#include "MSXMotherBoard.hh"
+#include "TclObject.hh"
+#include "ranges.hh"
+#include "serialize.hh"
+#include "serialize_stl.hh"
+#include "xrange.hh"
+
+using std::string;
+using std::vector;
+
+namespace openmsx {
+
+// Most games only update their state once per frame.
+static const EmuDuration INTERVAL = EmuDuration::hz(60);
+
+CheatEngine::CheatEngine(MSXMotherBoard& motherBoard_)
+	: RecordedCommand(motherBoard_.getCommandController(),
+	                  motherBoard_.getStateChangeDistributor(),
+	                  motherBoard_.getScheduler(), "cheat_table")
+	, Schedulable(motherBoard_.getScheduler())
+	, motherBoard(motherBoard_)
+{
+}
+
+bool CheatEngine::needRecord(span<const TclObject> tokens) const
+{
+	if (tokens.size() < 2) return false;
+	string_view subCmd = tokens[1].getString();
+	return (subCmd == "set") || (subCmd == "remove") || (subCmd == "clear");
+}
+
+void CheatEngine::execute(span<const TclObject> tokens, TclObject& result,
+                          EmuTime::param time)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	executeSubCommand(tokens[1].getString(),
+		"set",    [&]{ set(tokens, time); },
+		"remove", [&]{ remove(tokens); },
+		"clear",  [&]{
+			checkNumArgs(tokens, 2, "");
+			cheats.clear();
+			removeSyncPoints(); },
+		"list",   [&]{
+			checkNumArgs(tokens, 2, "");
+			list(result); });
+}
+
+void CheatEngine::set(span<const TclObject> tokens, EmuTime::param time)
+{
+	checkNumArgs(tokens, AtLeast{6}, "name debuggable address value ?address value ...?");
+	if ((tokens.size() % 2) != 0) {
+		throw SyntaxError();
+	}
+	auto& interp = getInterpreter();
+	Cheat cheat;
+	cheat.name = tokens[2].getString().str();
+	cheat.debuggable = tokens[3].getString().str();
+	auto* device = motherBoard.getDebugger().findDebuggable(cheat.debuggable);
+	if (!device) {
+		throw CommandException("No such debuggable: ", cheat.debuggable);
+	}
+	for (size_t i = 4; i < tokens.size(); i += 2) {
+		unsigned addr = tokens[i + 0].getInt(interp);
+		if (addr >= device->getSize()) {
+			throw CommandException("Invalid address");
+		}
+		unsigned value = tokens[i + 1].getInt(interp);
+		if (value >= 256) {
+			throw CommandException("Invalid value");
+		}
+		cheat.pokes.push_back(Poke{addr, byte(value)});
+	}
+
+	auto it = ranges::find_if(cheats, [&](auto& c) { return c.name == cheat.name; });
+	if (it != end(cheats)) {
+		*it = std::move(cheat);
+	} else {
+		cheats.push_back(std::move(cheat));
+	}
+	// apply the new cheat right away
+	removeSyncPoints();
+	executeUntil(time);
+}
+
+void CheatEngine::remove(span<const TclObject> tokens)
+{
+	checkNumArgs(tokens, 3, "name");
+	string_view cheatName = tokens[2].getString();
+	auto it = ranges::find_if(cheats, [&](auto& c) { return c.name == cheatName; });
+	if (it == end(cheats)) {
+		throw CommandException("No such cheat: ", cheatName);
+	}
+	cheats.erase(it);
+	if (cheats.empty()) removeSyncPoints();
+}
+
+void CheatEngine::list(TclObject& result) const
+{
+	for (auto& cheat : cheats) {
+		TclObject pokes;
+		pokes.addListElement(cheat.debuggable);
+		for (auto& poke : cheat.pokes) {
+			pokes.addListElement(int(poke.address), poke.value);
+		}
+		result.addDictKeyValue(cheat.name, pokes);
+	}
+}
+
+void CheatEngine::apply()
+{
+	auto& debugger = motherBoard.getDebugger();
+	for (auto& cheat : cheats) {
+		// The debuggable may (temporarily) be gone, e.g. when the
+		// cartridge was removed.
+		auto* device = debugger.findDebuggable(cheat.debuggable);
+		if (!device) continue;
+		unsigned size = device->getSize();
+		for (auto& poke : cheat.pokes) {
+			// only write when needed, like 'dpoke'
+			if ((poke.address < size) &&
+			    (device->read(poke.address) != poke.value)) {
+				device->write(poke.address, poke.value);
+			}
+		}
+	}
+}
+
+void CheatEngine::executeUntil(EmuTime::param time)
+{
+	apply();
+	if (!cheats.empty()) {
+		setSyncPoint(time + INTERVAL);
+	}
+}
+
+string CheatEngine::help(const vector<string>& /*tokens*/) const
+{
+	return "Applies cheats about once per frame, without the overhead of "
+	       "a Tcl script that pokes memory every frame. A cheat only "
+	       "writes the values that differ.\n"
+	       "cheat_table set <name> <debuggable> <address> <value> "
+	       "[<address> <value> ...]\n"
+	       "    Adds a cheat, or replaces the cheat with the same name.\n"
+	       "cheat_table remove <name>\n"
+	       "    Removes a cheat.\n"
+	       "cheat_table clear\n"
+	       "    Removes all cheats.\n"
+	       "cheat_table list\n"
+	       "    Returns a dict with for each cheat a list with the "
+	       "debuggable followed by the address/value pairs.\n"
+	       "The cheats are part of the machine state (savestates, "
+	       "replays).\n"
+	       "Example: cheat_table set lives memory 0xe000 9";
+}
+
+void CheatEngine::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const cmds[] = {
+			"set", "remove", "clear", "list",
+		};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() == 3) && (tokens[1] == "remove")) {
+		vector<string> names;
+		for (auto& cheat : cheats) names.push_back(cheat.name);
+		completeString(tokens, names);
+	}
+}
+
+template<typename Archive>
+void CheatEngine::Poke::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.serialize("address", address,
+	             "value",   value);
+}
+
+template<typename Archive>
+void CheatEngine::Cheat::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.serialize("name",       name,
+	             "debuggable", debuggable,
+	             "pokes",      pokes);
+}
+
+template<typename Archive>
+void CheatEngine::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.template serializeBase<Schedulable>(*this);
+	ar.serialize("cheats", cheats);
+}
+INSTANTIATE_SERIALIZE_METHODS(CheatEngine);
+
+} // namespace openmsx
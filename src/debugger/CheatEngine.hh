@@ -0,0 +1,67 @@
+#ifndef CHEATENGINE_HH
+#define CHEATENGINE_HH
+
+#include "RecordedCommand.hh"
+#include "Schedulable.hh"
+#include "EmuTime.hh"
+#include "openmsx.hh"
+#include "serialize_meta.hh"
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+
+/** Applies a table of cheats (a cheat is a list of address/value pairs in a
+  * debuggable) about once per frame, without going through Tcl. Only changes
+  * to the table are recorded in replays (it's a RecordedCommand), the table
+  * itself is part of the machine state. So unlike e.g. a trainer script that
+  * pokes memory each frame, the cheats don't add an event per write.
+  */
+class CheatEngine final : public RecordedCommand, public Schedulable
+{
+public:
+	explicit CheatEngine(MSXMotherBoard& motherBoard);
+
+	bool needRecord(span<const TclObject> tokens) const override;
+	void execute(span<const TclObject> tokens, TclObject& result,
+	             EmuTime::param time) override;
+	std::string help(const std::vector<std::string>& tokens) const override;
+	void tabCompletion(std::vector<std::string>& tokens) const override;
+
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
+
+//private:
+	struct Poke {
+		unsigned address;
+		byte value;
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+	};
+	struct Cheat {
+		std::string name;
+		std::string debuggable;
+		std::vector<Poke> pokes;
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+	};
+
+private:
+	void set(span<const TclObject> tokens, EmuTime::param time);
+	void remove(span<const TclObject> tokens);
+	void list(TclObject& result) const;
+	void apply();
+
+	void executeUntil(EmuTime::param time) override;
+
+	MSXMotherBoard& motherBoard;
+	std::vector<Cheat> cheats;
+};
+
+} // namespace openmsx
+
+#endif
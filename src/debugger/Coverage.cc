@@ -0,0 +1,119 @@
+#include "Coverage.hh"
+#include "File.hh"
+#include "MSXException.hh"
+#include "TclObject.hh"
+#include "endian.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+
+namespace openmsx {
+
+static const unsigned WORDS_PER_SLOT = 0x10000 / 64;
+
+static unsigned countBits(uint64_t x)
+{
+#ifdef __GNUC__
+	return __builtin_popcountll(x);
+#else
+	unsigned result = 0;
+	for (; x; x &= x - 1) ++result;
+	return result;
+#endif
+}
+
+Coverage::Coverage()
+	: bits(SIZE / 64)
+	, enabled(false)
+{
+}
+
+void Coverage::setEnabled(bool enabled_)
+{
+	if (enabled == enabled_) return;
+	enabled = enabled_;
+	enabledChanged();
+}
+
+void Coverage::clear()
+{
+	for (auto& b : bits) b = 0;
+}
+
+unsigned Coverage::count() const
+{
+	unsigned result = 0;
+	for (auto b : bits) result += countBits(b);
+	return result;
+}
+
+TclObject Coverage::getBitmaps() const
+{
+	TclObject result;
+	uint8_t buf[0x10000 / 8];
+	for (auto slot : xrange(16u)) {
+		const uint64_t* p = &bits[slot * WORDS_PER_SLOT];
+		bool any = false;
+		for (auto i : xrange(WORDS_PER_SLOT)) {
+			Endian::write_UA_L64(&buf[8 * i], p[i]);
+			any |= p[i] != 0;
+		}
+		if (any) {
+			result.addDictKeyValue(formatSlot(slot),
+			                       span<const uint8_t>(buf, sizeof(buf)));
+		}
+	}
+	return result;
+}
+
+void Coverage::save(const std::string& filename) const
+{
+	std::vector<uint8_t> buf(SIZE / 8);
+	for (auto i : xrange(bits.size())) {
+		Endian::write_UA_L64(&buf[8 * i], bits[i]);
+	}
+	File file(filename, File::TRUNCATE);
+	file.write(buf.data(), buf.size());
+}
+
+void Coverage::merge(const std::string& filename)
+{
+	File file(filename);
+	if (file.getSize() != (SIZE / 8)) {
+		throw MSXException("Not a coverage file: ", filename);
+	}
+	std::vector<uint8_t> buf(SIZE / 8);
+	file.read(buf.data(), buf.size());
+	for (auto i : xrange(bits.size())) {
+		bits[i] |= Endian::read_UA_L64(&buf[8 * i]);
+	}
+}
+
+void Coverage::report(const std::string& filename) const
+{
+	std::string out;
+	for (auto slot : xrange(16u)) {
+		const uint64_t* p = &bits[slot * WORDS_PER_SLOT];
+		unsigned num = 0;
+		std::string lines;
+		for (auto i : xrange(WORDS_PER_SLOT)) {
+			if (!p[i]) continue;
+			for (auto bit : xrange(64u)) {
+				if (!((p[i] >> bit) & 1)) continue;
+				strAppend(lines, "DA:", 64 * i + bit, ",1\n");
+				++num;
+			}
+		}
+		if (num == 0) continue;
+		strAppend(out, "SF:slot ", formatSlot(slot), '\n', lines,
+		          "LH:", num, "\nend_of_record\n");
+	}
+	File file(filename, File::TRUNCATE);
+	file.write(out.data(), out.size());
+}
+
+std::string Coverage::formatSlot(unsigned slot) const
+{
+	return strCat(slot >> 2, '-', slot & 3);
+}
+
+} // namespace openmsx
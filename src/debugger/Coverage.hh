@@ -0,0 +1,70 @@
+#ifndef COVERAGE_HH
+#define COVERAGE_HH
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class TclObject;
+
+/** Records which addresses of the (slotted) CPU address space were executed,
+  * one bit per address of each of the 16 (sub)slots. Only the address of
+  * the first byte of each instruction is recorded. Recording is off by
+  * default, it can be enabled with 'debug coverage'. The owner should only
+  * call execute() while isEnabled() returns true.
+  */
+class Coverage
+{
+public:
+	static const unsigned SIZE = 16 * 0x10000;
+
+	Coverage();
+	virtual ~Coverage() = default;
+
+	bool isEnabled() const { return enabled; }
+	void setEnabled(bool enabled);
+	void clear();
+
+	/** @param slotAddress ((ps * 4 + ss) << 16) | address */
+	void execute(unsigned slotAddress) {
+		bits[slotAddress / 64] |= uint64_t(1) << (slotAddress % 64);
+	}
+	bool isExecuted(unsigned slotAddress) const {
+		return (bits[slotAddress / 64] >> (slotAddress % 64)) & 1;
+	}
+	/** The number of executed addresses. */
+	unsigned count() const;
+
+	/** A Tcl dict with for each (sub)slot that has executed addresses
+	  * the bitmap of that slot (8kB, bit 'a % 8' of byte 'a / 8' for
+	  * address 'a'). The keys are formatted by formatSlot(). */
+	TclObject getBitmaps() const;
+
+	/** Write the bitmap of all slots to a file (128kB).
+	  * @throws FileException */
+	void save(const std::string& filename) const;
+	/** Add the addresses of a file that was written by save(), e.g. to
+	  * combine the results of several runs.
+	  * @throws MSXException */
+	void merge(const std::string& filename);
+	/** Write an lcov style report: a record per (sub)slot with a 'DA'
+	  * line per executed address.
+	  * @throws FileException */
+	void report(const std::string& filename) const;
+
+protected:
+	/** Called after recording was enabled or disabled. */
+	virtual void enabledChanged() {}
+	/** By default "<ps>-<ss>". */
+	virtual std::string formatSlot(unsigned slot) const;
+
+private:
+	std::vector<uint64_t> bits;
+	bool enabled;
+};
+
+} // namespace openmsx
+
+#endif
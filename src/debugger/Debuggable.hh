@@ -14,6 +14,17 @@ public:
 	virtual byte read(unsigned address) = 0;
 	virtual void write(unsigned address, byte value) = 0;
 
+	/** Read 'num' consecutive bytes starting at 'address'. The caller
+	  * must make sure the range lies within [0, getSize()). The default
+	  * implementation calls read() for each byte, debuggables that are
+	  * backed by a plain buffer can override it with a single copy.
+	  */
+	virtual void readBlock(unsigned address, byte* output, unsigned num) {
+		for (unsigned i = 0; i < num; ++i) {
+			output[i] = read(address + i);
+		}
+	}
+
 protected:
 	Debuggable() = default;
 	~Debuggable() = default;
@@ -6,10 +6,14 @@
 #include "MSXCPUInterface.hh"
 #include "BreakPoint.hh"
 #include "DebugCondition.hh"
+#include "Heatmap.hh"
 #include "MSXWatchIODevice.hh"
+#include "Scheduler.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
+#include "CliComm.hh"
 #include "CommandException.hh"
+#include "FileOperations.hh"
 #include "MemBuffer.hh"
 #include "ranges.hh"
 #include "stl.hh"
@@ -17,7 +21,10 @@
 #include "view.hh"
 #include "xrange.hh"
 #include <cassert>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <new>
 #include <stdexcept>
 
 using std::shared_ptr;
@@ -26,6 +33,9 @@ using std::string;
 using std::vector;
 using std::end;
 
+// number of entries in the access log of a logging watchpoint
+static const size_t ACCESS_LOG_SIZE = 1 << 16;
+
 namespace openmsx {
 
 Debugger::Debugger(MSXMotherBoard& motherBoard_)
@@ -33,6 +43,8 @@ Debugger::Debugger(MSXMotherBoard& motherBoard_)
 	, cmd(motherBoard.getCommandController(),
 	      motherBoard.getStateChangeDistributor(),
 	      motherBoard.getScheduler())
+	, schedulerStatsInfo(motherBoard.getMachineInfoCommand())
+	, profiler(motherBoard)
 	, cpu(nullptr)
 {
 }
@@ -52,14 +64,22 @@ void Debugger::registerDebuggable(string name, Debuggable& debuggable)
 void Debugger::unregisterDebuggable(string_view name, Debuggable& debuggable)
 {
 	assert(debuggables.contains(name));
-	assert(debuggables[name.str()] == &debuggable); (void)debuggable;
+	assert(debuggables[name.str()] == &debuggable);
 	debuggables.erase(name);
+	if (lastDebuggable == &debuggable) lastDebuggable = nullptr;
 }
 
 Debuggable* Debugger::findDebuggable(string_view name)
 {
+	// Scripts typically access the same debuggable many times in a row.
+	if (lastDebuggable && (name == lastDebuggableName)) {
+		return lastDebuggable;
+	}
 	auto v = lookup(debuggables, name);
-	return v ? *v : nullptr;
+	if (!v) return nullptr;
+	lastDebuggableName = name.str();
+	lastDebuggable = *v;
+	return lastDebuggable;
 }
 
 Debuggable& Debugger::getDebuggable(string_view name)
@@ -89,6 +109,27 @@ ProbeBase* Debugger::findProbe(string_view name)
 	return (it != end(probes)) ? *it : nullptr;
 }
 
+void Debugger::registerHeatmap(Heatmap& heatmap)
+{
+	assert(!contains(heatmaps, &heatmap));
+	heatmaps.push_back(&heatmap);
+}
+
+void Debugger::unregisterHeatmap(Heatmap& heatmap)
+{
+	move_pop_back(heatmaps, rfind_unguarded(heatmaps, &heatmap));
+}
+
+Heatmap& Debugger::getHeatmap(string_view name)
+{
+	auto it = ranges::find_if(heatmaps,
+		[&](Heatmap* h) { return h->getName() == name; });
+	if (it == end(heatmaps)) {
+		throw CommandException("No such heatmap: ", name);
+	}
+	return **it;
+}
+
 ProbeBase& Debugger::getProbe(string_view name)
 {
 	auto* result = findProbe(name);
@@ -148,7 +189,8 @@ void Debugger::removeProbeBreakPoint(ProbeBreakPoint& bp)
 unsigned Debugger::setWatchPoint(TclObject command, TclObject condition,
                                  WatchPoint::Type type,
                                  unsigned beginAddr, unsigned endAddr,
-                                 bool once, unsigned newId /*= -1*/)
+                                 bool once, shared_ptr<AccessLog> log,
+                                 unsigned newId /*= -1*/)
 {
 	shared_ptr<WatchPoint> wp;
 	if ((type == WatchPoint::READ_IO) || (type == WatchPoint::WRITE_IO)) {
@@ -159,6 +201,7 @@ unsigned Debugger::setWatchPoint(TclObject command, TclObject condition,
 		wp = make_shared<WatchPoint>(
 			command, condition, type, beginAddr, endAddr, once, newId);
 	}
+	wp->setLog(std::move(log));
 	motherBoard.getCPUInterface().setWatchPoint(wp);
 	return wp->getId();
 }
@@ -171,7 +214,7 @@ void Debugger::transfer(Debugger& other)
 		setWatchPoint(wp->getCommandObj(), wp->getConditionObj(),
 		              wp->getType(),       wp->getBeginAddress(),
 		              wp->getEndAddress(), wp->onlyOnce(),
-		              wp->getId());
+		              wp->getLog(),        wp->getId());
 	}
 
 	// Copy probes to new machine.
@@ -185,6 +228,13 @@ void Debugger::transfer(Debugger& other)
 		}
 	}
 
+	// Keep the collected profile.
+	profiler.transfer(other.profiler);
+
+	// Keep an ongoing memory search (e.g. while searching for cheats).
+	memorySearch = std::move(other.memorySearch);
+	searchDebuggable = std::move(other.searchDebuggable);
+
 	// Breakpoints and conditions are (currently) global, so no need to
 	// copy those.
 }
@@ -211,13 +261,14 @@ Debugger::Cmd::Cmd(CommandController& commandController_,
 
 bool Debugger::Cmd::needRecord(span<const TclObject> tokens) const
 {
-	// Note: it's crucial for security that only the write and write_block
-	// subcommands are recorded and replayed. The 'set_bp' command for
+	// Note: it's crucial for security that only the write, write_block and
+	// write_multi subcommands are recorded and replayed. The 'set_bp' command for
 	// example would allow to set a callback that can execute arbitrary Tcl
 	// code. See comments in RecordedCommand for more details.
 	if (tokens.size() < 2) return false;
 	string_view subCmd = tokens[1].getString();
-	return (subCmd == "write") || (subCmd == "write_block");
+	return (subCmd == "write") || (subCmd == "write_block") ||
+	       (subCmd == "write_multi");
 }
 
 void Debugger::Cmd::execute(
@@ -229,12 +280,15 @@ void Debugger::Cmd::execute(
 		"read_block",        [&]{ readBlock(tokens, result); },
 		"write",             [&]{ write(tokens, result); },
 		"write_block",       [&]{ writeBlock(tokens, result); },
+		"write_multi",       [&]{ writeMulti(tokens, result); },
+		"diff",              [&]{ diff(tokens, result); },
 		"size",              [&]{ size(tokens, result); },
 		"desc",              [&]{ desc(tokens, result); },
 		"list",              [&]{ list(result); },
 		"step",              [&]{ debugger().motherBoard.getCPUInterface().doStep(); },
 		"cont",              [&]{ debugger().motherBoard.getCPUInterface().doContinue(); },
 		"disasm",            [&]{ debugger().cpu->disasmCommand(getInterpreter(), tokens, result); },
+		"disasm_block",      [&]{ debugger().cpu->disasmBlockCommand(getInterpreter(), tokens, result); },
 		"break",             [&]{ debugger().motherBoard.getCPUInterface().doBreak(); },
 		"breaked",           [&]{ result = debugger().motherBoard.getCPUInterface().isBreaked(); },
 		"set_bp",            [&]{ setBreakPoint(tokens, result); },
@@ -243,10 +297,17 @@ void Debugger::Cmd::execute(
 		"set_watchpoint",    [&]{ setWatchPoint(tokens, result); },
 		"remove_watchpoint", [&]{ removeWatchPoint(tokens, result); },
 		"list_watchpoints",  [&]{ listWatchPoints(tokens, result); },
+		"watchpoint_log",    [&]{ watchPointLog(tokens, result); },
 		"set_condition",     [&]{ setCondition(tokens, result); },
 		"remove_condition",  [&]{ removeCondition(tokens, result); },
 		"list_conditions",   [&]{ listConditions(tokens, result); },
-		"probe",             [&]{ probe(tokens, result); });
+		"probe",             [&]{ probe(tokens, result); },
+		"scheduler_stats",   [&]{ schedulerStats(tokens, result); },
+		"profile",           [&]{ profile(tokens, result); },
+		"cputrace",          [&]{ cpuTrace(tokens, result); },
+		"heatmap",           [&]{ heatmap(tokens, result); },
+		"coverage",          [&]{ coverage(tokens, result); },
+		"search",            [&]{ search(tokens, result); });
 }
 
 void Debugger::Cmd::list(TclObject& result)
@@ -295,9 +356,7 @@ void Debugger::Cmd::readBlock(span<const TclObject> tokens, TclObject& result)
 	}
 
 	MemBuffer<byte> buf(num);
-	for (unsigned i = 0; i < num; ++i) {
-		buf[i] = device.read(addr + i);
-	}
+	device.readBlock(addr, buf.data(), num);
 	result = span<byte>{buf.data(), num};
 }
 
@@ -337,6 +396,76 @@ void Debugger::Cmd::writeBlock(span<const TclObject> tokens, TclObject& /*result
 	}
 }
 
+void Debugger::Cmd::writeMulti(span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, AtLeast{5}, Prefix{2}, "debuggable address value ?address value ...?");
+	if ((tokens.size() % 2) != 1) throw SyntaxError();
+	auto& interp = getInterpreter();
+	Debuggable& device = debugger().getDebuggable(tokens[2].getString());
+	unsigned devSize = device.getSize();
+
+	// first check all arguments, so that either all or none are written
+	auto num = (tokens.size() - 3) / 2;
+	MemBuffer<unsigned> addrs(num);
+	MemBuffer<byte> values(num);
+	for (auto i : xrange(num)) {
+		unsigned addr = tokens[3 + 2 * i].getInt(interp);
+		if (addr >= devSize) {
+			throw CommandException("Invalid address");
+		}
+		unsigned value = tokens[4 + 2 * i].getInt(interp);
+		if (value >= 256) {
+			throw CommandException("Invalid value");
+		}
+		addrs[i] = addr;
+		values[i] = value;
+	}
+	for (auto i : xrange(num)) {
+		device.write(addrs[i], values[i]);
+	}
+}
+
+// Returns the first index in [i, num) where 'a' and 'b' differ (or 'num').
+static unsigned skipEqual(const byte* a, const byte* b, unsigned i, unsigned num)
+{
+	// Usually most of the memory is unchanged, compare 8 bytes at once.
+	for (; (i + 8) <= num; i += 8) {
+		uint64_t x, y;
+		memcpy(&x, a + i, 8);
+		memcpy(&y, b + i, 8);
+		if (x != y) break;
+	}
+	while ((i < num) && (a[i] == b[i])) ++i;
+	return i;
+}
+
+void Debugger::Cmd::diff(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 5, Prefix{2}, "debuggable address values");
+	Debuggable& device = debugger().getDebuggable(tokens[2].getString());
+	unsigned devSize = device.getSize();
+	unsigned addr = tokens[3].getInt(getInterpreter());
+	if (addr >= devSize) {
+		throw CommandException("Invalid address");
+	}
+	auto old = tokens[4].getBinary();
+	if ((old.size() + addr) > devSize) {
+		throw CommandException("Invalid size");
+	}
+
+	auto num = unsigned(old.size());
+	MemBuffer<byte> buf(num);
+	device.readBlock(addr, buf.data(), num);
+	unsigned i = skipEqual(old.data(), buf.data(), 0, num);
+	while (i < num) {
+		unsigned start = i;
+		while ((i < num) && (old[i] != buf[i])) ++i;
+		result.addListElement(makeTclList(
+			addr + start, span<const byte>(&buf[start], i - start)));
+		i = skipEqual(old.data(), buf.data(), i, num);
+	}
+}
+
 void Debugger::Cmd::setBreakPoint(span<const TclObject> tokens, TclObject& result)
 {
 	checkNumArgs(tokens, AtLeast{3}, "address ?-once? ?condition? ?command?");
@@ -424,18 +553,31 @@ void Debugger::Cmd::listBreakPoints(
 
 void Debugger::Cmd::setWatchPoint(span<const TclObject> tokens, TclObject& result)
 {
-	checkNumArgs(tokens, AtLeast{4}, Prefix{2}, "type address ?-once? ?condition? ?command?");
+	checkNumArgs(tokens, AtLeast{4}, Prefix{2}, "type address ?-once|-log? ?condition? ?command?");
 	TclObject command("debug break");
 	TclObject condition;
 	unsigned beginAddr, endAddr;
 	WatchPoint::Type type;
 	bool once = false;
+	bool log = false;
 
-	ArgsInfo info[] = { flagArg("-once", once) };
+	ArgsInfo info[] = { flagArg("-once", once), flagArg("-log", log) };
 	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(2), info);
 	if ((arguments.size() < 2) || (arguments.size() > 4)) {
 		throw SyntaxError();
 	}
+	shared_ptr<AccessLog> accessLog;
+	if (log) {
+		if (once) {
+			throw CommandException("Can't combine -once and -log");
+		}
+		if (arguments.size() == 4) {
+			throw CommandException(
+				"A logging watchpoint doesn't execute a command");
+		}
+		command = TclObject();
+		accessLog = make_shared<AccessLog>(ACCESS_LOG_SIZE);
+	}
 
 	switch (arguments.size()) {
 	case 4: // command
@@ -483,31 +625,33 @@ void Debugger::Cmd::setWatchPoint(span<const TclObject> tokens, TclObject& resul
 		UNREACHABLE; break;
 	}
 	unsigned id = debugger().setWatchPoint(
-		command, condition, type, beginAddr, endAddr, once);
+		command, condition, type, beginAddr, endAddr, once, accessLog);
 	result = strCat("wp#", id);
 }
 
-void Debugger::Cmd::removeWatchPoint(
-	span<const TclObject> tokens, TclObject& /*result*/)
+static shared_ptr<WatchPoint> findWatchPoint(
+	MSXCPUInterface& interface, string_view name)
 {
-	checkNumArgs(tokens, 3, "id");
-	string_view tmp = tokens[2].getString();
 	try {
-		if (tmp.starts_with("wp#")) {
-			// remove by id
-			unsigned id = fast_stou(tmp.substr(3));
-			auto& interface = debugger().motherBoard.getCPUInterface();
+		if (name.starts_with("wp#")) {
+			unsigned id = fast_stou(name.substr(3));
 			for (auto& wp : interface.getWatchPoints()) {
-				if (wp->getId() == id) {
-					interface.removeWatchPoint(wp);
-					return;
-				}
+				if (wp->getId() == id) return wp;
 			}
 		}
 	} catch (std::invalid_argument&) {
 		// parse error in fast_stou()
 	}
-	throw CommandException("No such watchpoint: ", tmp);
+	throw CommandException("No such watchpoint: ", name);
+}
+
+void Debugger::Cmd::removeWatchPoint(
+	span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, 3, "id");
+	auto& interface = debugger().motherBoard.getCPUInterface();
+	interface.removeWatchPoint(
+		findWatchPoint(interface, tokens[2].getString()));
 }
 
 void Debugger::Cmd::listWatchPoints(
@@ -551,6 +695,56 @@ void Debugger::Cmd::listWatchPoints(
 	result = res;
 }
 
+void Debugger::Cmd::watchPointLog(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "id ?-file filename?");
+	string filename;
+	ArgsInfo info[] = { valueArg("-file", filename) };
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(2), info);
+	if (arguments.size() != 1) throw SyntaxError();
+
+	auto& interface = debugger().motherBoard.getCPUInterface();
+	auto wp = findWatchPoint(interface, arguments[0].getString());
+	auto& log = wp->getLog();
+	if (!log) {
+		throw CommandException("Not a logging watchpoint: ",
+		                       arguments[0].getString());
+	}
+
+	auto toTcl = [](const AccessLog::Entry& e) {
+		TclObject entry = makeTclList(
+			(e.time - EmuTime::zero).toDouble(), int(e.address));
+		if (e.value != ~0u) entry.addListElement(int(e.value));
+		return entry;
+	};
+	auto& entries = log->getEntries();
+	if (filename.empty()) {
+		for (auto& e : entries) {
+			result.addListElement(toTcl(e));
+		}
+	} else {
+		std::ofstream file;
+		FileOperations::openofstream(
+			file, FileOperations::expandTilde(filename), std::ios::app);
+		if (!file.is_open()) {
+			throw CommandException("Couldn't open file ", filename);
+		}
+		for (auto& e : entries) {
+			file << toTcl(e).getString() << '\n';
+		}
+		if (!file) {
+			throw CommandException("Error while writing to ", filename);
+		}
+		result = int(entries.size());
+	}
+	if (auto dropped = log->getDropped()) {
+		debugger().motherBoard.getMSXCliComm().printWarning(
+			"Access log of wp#", wp->getId(), " overflowed, ",
+			dropped, " entries were dropped.");
+	}
+	log->clear();
+}
+
 
 void Debugger::Cmd::setCondition(span<const TclObject> tokens, TclObject& result)
 {
@@ -709,12 +903,15 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"    write             write a byte to a debuggable\n"
 		"    read_block        read a whole block at once\n"
 		"    write_block       write a whole block at once\n"
+		"    write_multi       write bytes at several addresses at once\n"
+		"    diff              compare a block with an earlier read_block\n"
 		"    set_bp            insert a new breakpoint\n"
 		"    remove_bp         remove a certain breakpoint\n"
 		"    list_bp           list the active breakpoints\n"
 		"    set_watchpoint    insert a new watchpoint\n"
 		"    remove_watchpoint remove a certain watchpoint\n"
 		"    list_watchpoints  list the active watchpoints\n"
+		"    watchpoint_log    fetch the accesses recorded by a watchpoint\n"
 		"    set_condition     insert a new condition\n"
 		"    remove_condition  remove a certain condition\n"
 		"    list_conditions   list the active conditions\n"
@@ -724,6 +921,13 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"    break             break CPU at current position\n"
 		"    breaked           query CPU breaked status\n"
 		"    disasm            disassemble instructions\n"
+		"    disasm_block      disassemble a range of instructions\n"
+		"    scheduler_stats   show statistics on the scheduled devices\n"
+		"    profile           sample where the CPU spends its time\n"
+		"    cputrace          record the executed instructions\n"
+		"    heatmap           count the memory accesses per page\n"
+		"    coverage          record which addresses were executed\n"
+		"    search            search for addresses with changing values\n"
 		"  The arguments are specific for each subcommand.\n"
 		"  Type 'help debug <subcommand>' for help about a specific subcommand.\n";
 
@@ -768,6 +972,24 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"  The block has a size and an offset in the debuggable. The "
 		"complete block must fit in the debuggable (see the 'size' "
 		"subcommand).\n";
+	static const string writeMultiHelp =
+		"debug write_multi <name> <addr> <val> [<addr> <val> ...]\n"
+		"  Write bytes at several (not necessarily consecutive) "
+		"offsets in the debuggable. This is equivalent with a "
+		"'write' subcommand for each pair, but in a replay it's only "
+		"a single event, which makes it a lot cheaper for e.g. "
+		"trainers. Either all bytes are written or (in case of an "
+		"invalid argument) none.\n"
+		"  See also the 'cheat_table' command to apply values every "
+		"frame.\n";
+	static const string diffHelp =
+		"debug diff <name> <addr> <values>\n"
+		"  Compares the content of the given debuggable, starting at the "
+		"given address, with <values> (e.g. the result of an earlier "
+		"read_block) and returns a list with for each range of changed "
+		"bytes the start address and the new values. This is much cheaper "
+		"than reading the whole block again when only a few bytes "
+		"changed.\n";
 	static const string setBpHelp =
 		"debug set_bp [-once] <addr> [<cond>] [<cmd>]\n"
 		"  Insert a new breakpoint at given address. When the CPU is about "
@@ -800,7 +1022,7 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"(default condition is empty). And the last column contains "
 		"the command that will be executed (default is 'debug break').\n";
 	static const string setWatchPointHelp =
-		"debug set_watchpoint [-once] <type> <region> [<cond>] [<cmd>]\n"
+		"debug set_watchpoint [-once|-log] <type> <region> [<cond>] [<cmd>]\n"
 		"  Insert a new watchpoint of given type on the given region, "
 		"there can be an optional -once flag, a condition and alternative "
 		"command. See the 'set_bp' subcommand for details about these.\n"
@@ -819,9 +1041,14 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"read/write that triggered the watchpoint\n"
 		"  ::wp_last_value     this is the actual value that was written "
 		"by the mem/io write that triggered the watchpoint\n"
+		"When the -log flag is given, no command is executed. Instead each "
+		"access (for which the condition is true) is recorded together with "
+		"the emulation time. This is much faster than executing a Tcl "
+		"command, see the 'watchpoint_log' subcommand.\n"
 		"Examples:\n"
 		"  debug set_watchpoint write_io 0x99 {[reg A] == 0x81}\n"
-		"  debug set_watchpoint read_mem {0xfbe5 0xfbef}\n";
+		"  debug set_watchpoint read_mem {0xfbe5 0xfbef}\n"
+		"  debug set_watchpoint -log write_io {0xa0 0xa1}\n";
 	static const string removeWatchPointHelp =
 		"debug remove_watchpoint <id>\n"
 		"  Remove the watchpoint with given ID again. You can use the "
@@ -831,6 +1058,18 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"  Lists all active watchpoints. The result is similar to the "
 		"'list_bp' subcommand, but there is an extra column (2nd column) "
 		"that contains the type of the watchpoint.\n";
+	static const string watchPointLogHelp =
+		"debug watchpoint_log <id> [-file <filename>]\n"
+		"  Returns the accesses recorded by the given logging watchpoint "
+		"(see 'set_watchpoint -log') and clears the log. The result is a "
+		"list with for each access a list containing the emulation time (in "
+		"seconds), the address and (for writes) the value.\n"
+		"  With the -file option the entries are appended to the given file "
+		"instead, one entry per line, and the number of entries is "
+		"returned.\n"
+		"  The log has room for " + std::to_string(ACCESS_LOG_SIZE) +
+		" entries, it's meant to be fetched regularly (e.g. once per "
+		"frame). When it overflows, the oldest entries are dropped.\n";
 	static const string setCondHelp =
 		"debug set_condition [-once] <cond> [<cmd>]\n"
 		"  Insert a new condition. These are much like breakpoints, "
@@ -884,6 +1123,128 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"instruction).\n"
 		"  Note that openMSX comes with a 'disasm' Tcl script that is much "
 		"more convenient to use than this subcommand.";
+	static const string disasmBlockHelp =
+		"debug disasm_block <addr> [<num>]\n"
+		"  Disassemble <num> (default 8) consecutive instructions starting "
+		"at the given address. The result is a Tcl list with an element "
+		"per instruction: its address followed by the same elements as "
+		"returned by 'debug disasm'. This is much faster than calling "
+		"'debug disasm' for every instruction.\n";
+	static const string schedulerStatsHelp =
+		"debug scheduler_stats [start|stop|reset]\n"
+		"  Collect statistics on the devices that get called by the "
+		"scheduler, to see which device emulation takes the most (host) "
+		"time.\n"
+		"    start  start collecting (this has a small overhead)\n"
+		"    stop   stop collecting, the collected data is kept\n"
+		"    reset  clear the collected data\n"
+		"  Without argument returns the collected data: a list with for "
+		"each type of device a list with its name, the number of calls and "
+		"the total time spent (in nanoseconds). Sorted on descending time.\n";
+	static const string profileHelp =
+		"debug profile <subcommand> [<arguments>]\n"
+		"  Sampling profiler: at regular intervals record the location of "
+		"the instruction that is being executed and of the word on top of "
+		"the stack (the return address, when in a subroutine). A location "
+		"is shown as <ps>[-<ss>][/<segment>]:<address>, when symbols are "
+		"loaded the address is replaced by the nearest symbol (plus "
+		"offset).\n"
+		"  Possible subcommands are:\n"
+		"    start [<cycles>]          start sampling, every <cycles> Z80 "
+		"clock cycles (default 1000)\n"
+		"    stop                      stop sampling, the samples are kept\n"
+		"    clear                     discard all samples\n"
+		"    dump [-folded] [-file <filename>]\n"
+		"                              returns a list with for each pair of "
+		"locations a list with the location, the stack-top location and the "
+		"number of samples, sorted on descending count. With -folded the "
+		"result is in the 'folded stacks' format of FlameGraph, one "
+		"'<stack-top>;<location> <count>' line per routine. With -file the "
+		"result is written to the given file instead.\n"
+		"    load_symbols <filename>   load the symbols from a .sym file "
+		"(as generated by e.g. sjasm, tniASM or pasmo)\n"
+		"    clear_symbols             discard all loaded symbols\n";
+	static const string cpuTraceHelp =
+		"debug cputrace <subcommand> [<arguments>]\n"
+		"  Record the executed instructions (with the time, opcode bytes "
+		"and the register values) in a ring buffer. Unlike the 'cputrace' "
+		"setting this hardly slows down emulation, so it can be used to "
+		"trace millions of instructions, e.g. the ones leading up to a "
+		"crash.\n"
+		"  Possible subcommands are:\n"
+		"    start [<records>]         start recording, keep the last "
+		"<records> instructions (default 1000000), previously recorded "
+		"instructions are discarded\n"
+		"    stop                      stop recording, the recorded "
+		"instructions are kept\n"
+		"    clear                     discard all recorded instructions\n"
+		"    size                      returns the number of recorded "
+		"instructions\n"
+		"    save [-text] <filename>   write the recorded instructions to "
+		"a file, in a compact binary format or, with -text, disassembled "
+		"(one instruction per line)\n"
+		"    load <filename>           replace the recorded instructions "
+		"with the ones from a binary file, e.g. to save them again as "
+		"text\n";
+	static const string heatmapHelp =
+		"debug heatmap <subcommand> [<arguments>]\n"
+		"  Count the number of reads, writes and executed instructions "
+		"per 256-byte page. E.g. the 'memory' heatmap counts the CPU "
+		"accesses for each slot, the 'VRAM' heatmap the CPU accesses to "
+		"VRAM. While enabled, the memory heatmap slows down emulation "
+		"(all memory accesses take the slow path).\n"
+		"  Possible subcommands are:\n"
+		"    list                      returns the names of the heatmaps\n"
+		"    desc  <name>              describe the given heatmap\n"
+		"    start <name>              start counting\n"
+		"    stop  <name>              stop counting, the counts are kept\n"
+		"    clear <name>              reset all counts to zero\n"
+		"    dump  <name>              returns a dict with for each page "
+		"that was accessed a list with the number of reads, writes and "
+		"executes\n"
+		"    save  <name> <filename>   write the counts of all pages to a "
+		"file, three 64-bit little endian values per page\n";
+	static const string coverageHelp =
+		"debug coverage <subcommand> [<arguments>]\n"
+		"  Record which addresses were executed by the CPU, one bit per "
+		"address of each (sub)slot (the first byte of each executed "
+		"instruction). While recording, emulation is somewhat slower.\n"
+		"  Possible subcommands are:\n"
+		"    start               start recording\n"
+		"    stop                stop recording, the results are kept\n"
+		"    clear               forget all recorded addresses\n"
+		"    count               returns the number of executed addresses\n"
+		"    dump                returns a dict with for each (sub)slot "
+		"that has executed addresses a bitmap of 8kB (bit 'a % 8' of byte "
+		"'a / 8' for address 'a')\n"
+		"    save   <filename>   write the bitmaps of all (sub)slots to a "
+		"file\n"
+		"    merge  <filename>   add the addresses from a file written by "
+		"'save', e.g. to combine several runs\n"
+		"    report <filename>   write an lcov style report, with a record "
+		"per (sub)slot\n";
+	static const string searchHelp =
+		"debug search <subcommand> [<arguments>]\n"
+		"  Search a debuggable for the addresses whose value matches some "
+		"condition, e.g. to find the address of the number of lives in a "
+		"game. The condition is checked for all remaining candidates at "
+		"once, each step compares the current content with the content of "
+		"the previous step (or with a value).\n"
+		"  Possible subcommands are:\n"
+		"    start <name>           take a snapshot of the given debuggable, "
+		"all addresses are candidates\n"
+		"    filter <op>            only keep the candidates for which "
+		"'new <op> old' holds, <op> is one of == != < <= > >=\n"
+		"    filter <op> <value>    only keep the candidates for which "
+		"'new <op> <value>' holds\n"
+		"    keep <addresses>       only keep the candidates in the given "
+		"list, for conditions that can't be expressed with 'filter'\n"
+		"    count                  returns the number of candidates\n"
+		"    results [-max <num>]   returns a list with for (at most <num>) "
+		"candidates the address, the old and the new value\n"
+		"    stop                   forget the snapshot and the candidates\n"
+		"  'start', 'filter' and 'keep' return the number of remaining "
+		"candidates.\n";
 	static const string unknownHelp =
 		"Unknown subcommand, use 'help debug' to see a list of valid "
 		"subcommands.\n";
@@ -904,6 +1265,10 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		return readBlockHelp;
 	} else if (tokens[1] == "write_block") {
 		return writeBlockHelp;
+	} else if (tokens[1] == "write_multi") {
+		return writeMultiHelp;
+	} else if (tokens[1] == "diff") {
+		return diffHelp;
 	} else if (tokens[1] == "set_bp") {
 		return setBpHelp;
 	} else if (tokens[1] == "remove_bp") {
@@ -916,6 +1281,8 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		return removeWatchPointHelp;
 	} else if (tokens[1] == "list_watchpoints") {
 		return listWatchPointsHelp;
+	} else if (tokens[1] == "watchpoint_log") {
+		return watchPointLogHelp;
 	} else if (tokens[1] == "set_condition") {
 		return setCondHelp;
 	} else if (tokens[1] == "remove_condition") {
@@ -934,11 +1301,310 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		return breakedHelp;
 	} else if (tokens[1] == "disasm") {
 		return disasmHelp;
+	} else if (tokens[1] == "disasm_block") {
+		return disasmBlockHelp;
+	} else if (tokens[1] == "scheduler_stats") {
+		return schedulerStatsHelp;
+	} else if (tokens[1] == "profile") {
+		return profileHelp;
+	} else if (tokens[1] == "cputrace") {
+		return cpuTraceHelp;
+	} else if (tokens[1] == "heatmap") {
+		return heatmapHelp;
+	} else if (tokens[1] == "coverage") {
+		return coverageHelp;
+	} else if (tokens[1] == "search") {
+		return searchHelp;
 	} else {
 		return unknownHelp;
 	}
 }
 
+static void getSchedulerStats(Scheduler& scheduler, TclObject& result)
+{
+	for (auto& p : scheduler.getStats()) {
+		result.addListElement(makeTclList(
+			p.first, int64_t(p.second.count),
+			int64_t(p.second.nanoseconds)));
+	}
+}
+
+void Debugger::Cmd::schedulerStats(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{2, 3}, "?start|stop|reset?");
+	auto& sched = debugger().motherBoard.getScheduler();
+	if (tokens.size() == 2) {
+		getSchedulerStats(sched, result);
+		return;
+	}
+	executeSubCommand(tokens[2].getString(),
+		"start", [&]{ sched.setStatsEnabled(true); },
+		"stop",  [&]{ sched.setStatsEnabled(false); },
+		"reset", [&]{ sched.resetStats(); });
+}
+
+void Debugger::Cmd::profile(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& interp = getInterpreter();
+	auto& profiler = debugger().profiler;
+	executeSubCommand(tokens[2].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, Between{3, 4}, Prefix{3}, "?cycles?");
+			int cycles = (tokens.size() == 4) ? tokens[3].getInt(interp) : 1000;
+			if (cycles <= 0) {
+				throw CommandException("Interval must be positive");
+			}
+			profiler.start(cycles);
+		},
+		"stop",  [&]{ profiler.stop(); },
+		"clear", [&]{ profiler.clear(); },
+		"dump",  [&]{
+			bool folded = false;
+			string filename;
+			ArgsInfo info[] = {
+				flagArg("-folded", folded),
+				valueArg("-file", filename),
+			};
+			auto arguments = parseTclArgs(interp, tokens.subspan(3), info);
+			if (!arguments.empty()) throw SyntaxError();
+			if (filename.empty()) {
+				if (folded) {
+					result = profiler.getFolded();
+				} else {
+					result = profiler.getSamples();
+				}
+				return;
+			}
+			std::ofstream file;
+			FileOperations::openofstream(
+				file, FileOperations::expandTilde(filename));
+			if (!file.is_open()) {
+				throw CommandException("Couldn't open file ", filename);
+			}
+			if (folded) {
+				file << profiler.getFolded();
+			} else {
+				for (auto s : profiler.getSamples()) {
+					file << s << '\n';
+				}
+			}
+			if (!file) {
+				throw CommandException("Error while writing to ", filename);
+			}
+		},
+		"load_symbols", [&]{
+			checkNumArgs(tokens, 4, Prefix{3}, "filename");
+			try {
+				result = int(profiler.getSymbols().load(
+					FileOperations::expandTilde(tokens[3].getString().str())));
+			} catch (MSXException& e) {
+				throw CommandException(e.getMessage());
+			}
+		},
+		"clear_symbols", [&]{ profiler.getSymbols().clear(); });
+}
+
+void Debugger::Cmd::cpuTrace(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& interp = getInterpreter();
+	auto& cpu = *debugger().cpu;
+	auto& buffer = cpu.getTraceBuffer();
+	executeSubCommand(tokens[2].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, Between{3, 4}, Prefix{3}, "?records?");
+			int records = (tokens.size() == 4) ? tokens[3].getInt(interp) : 1000000;
+			if (records <= 0) {
+				throw CommandException("Number of records must be positive");
+			}
+			try {
+				cpu.startTrace(records);
+			} catch (std::bad_alloc&) {
+				throw CommandException("Not enough memory for ", records, " records");
+			}
+		},
+		"stop",  [&]{ cpu.stopTrace(); },
+		"clear", [&]{ buffer.clear(); },
+		"size",  [&]{ result = int64_t(buffer.size()); },
+		"save",  [&]{
+			bool text = false;
+			ArgsInfo info[] = { flagArg("-text", text) };
+			auto arguments = parseTclArgs(interp, tokens.subspan(3), info);
+			if (arguments.size() != 1) throw SyntaxError();
+			try {
+				buffer.save(FileOperations::expandTilde(
+					arguments[0].getString().str()), text);
+			} catch (MSXException& e) {
+				throw CommandException(e.getMessage());
+			}
+		},
+		"load", [&]{
+			checkNumArgs(tokens, 4, Prefix{3}, "filename");
+			cpu.stopTrace();
+			try {
+				buffer.load(FileOperations::expandTilde(
+					tokens[3].getString().str()));
+			} catch (MSXException& e) {
+				throw CommandException(e.getMessage());
+			}
+		});
+}
+
+void Debugger::Cmd::heatmap(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& dbg = debugger();
+	auto getHeatmap = [&]() -> Heatmap& {
+		checkNumArgs(tokens, 4, "heatmap");
+		return dbg.getHeatmap(tokens[3].getString());
+	};
+	executeSubCommand(tokens[2].getString(),
+		"list", [&]{
+			result.addListElements(view::transform(
+				dbg.heatmaps, [](auto* h) { return h->getName(); }));
+		},
+		"desc",  [&]{ result = getHeatmap().getDescription(); },
+		"start", [&]{ getHeatmap().setEnabled(true); },
+		"stop",  [&]{ getHeatmap().setEnabled(false); },
+		"clear", [&]{ getHeatmap().clear(); },
+		"dump",  [&]{ result = getHeatmap().getCounts(); },
+		"save",  [&]{
+			checkNumArgs(tokens, 5, Prefix{3}, "heatmap filename");
+			auto& h = dbg.getHeatmap(tokens[3].getString());
+			try {
+				h.save(FileOperations::expandTilde(
+					tokens[4].getString().str()));
+			} catch (MSXException& e) {
+				throw CommandException(e.getMessage());
+			}
+		});
+}
+
+void Debugger::Cmd::coverage(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& cov = debugger().motherBoard.getCPUInterface().getCoverage();
+	auto fileCmd = [&](auto action) {
+		checkNumArgs(tokens, 4, Prefix{3}, "filename");
+		try {
+			action(FileOperations::expandTilde(tokens[3].getString().str()));
+		} catch (MSXException& e) {
+			throw CommandException(e.getMessage());
+		}
+	};
+	executeSubCommand(tokens[2].getString(),
+		"start", [&]{ cov.setEnabled(true); },
+		"stop",  [&]{ cov.setEnabled(false); },
+		"clear", [&]{ cov.clear(); },
+		"count", [&]{ result = cov.count(); },
+		"dump",  [&]{ result = cov.getBitmaps(); },
+		"save",  [&]{ fileCmd([&](const string& f) { cov.save(f); }); },
+		"merge", [&]{ fileCmd([&](const string& f) { cov.merge(f); }); },
+		"report", [&]{ fileCmd([&](const string& f) { cov.report(f); }); });
+}
+
+static MemorySearch::Op parseSearchOp(string_view str)
+{
+	static const struct { const char* name; MemorySearch::Op op; } ops[] = {
+		{"==", MemorySearch::EQ}, {"!=", MemorySearch::NE},
+		{"<",  MemorySearch::LT}, {"<=", MemorySearch::LE},
+		{">",  MemorySearch::GT}, {">=", MemorySearch::GE},
+	};
+	for (auto& o : ops) {
+		if (str == o.name) return o.op;
+	}
+	throw CommandException("Invalid comparison: ", str);
+}
+
+void Debugger::Cmd::search(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& dbg = debugger();
+	auto& ms = dbg.memorySearch;
+	auto& interp = getInterpreter();
+	auto getActive = [&]() -> MemorySearch& {
+		if (!ms.isActive()) {
+			throw CommandException("No search in progress");
+		}
+		return ms;
+	};
+	// Read the current content of the searched debuggable.
+	auto readData = [&](MemBuffer<byte>& buf) {
+		unsigned size = getActive().getSize();
+		auto* device = dbg.findDebuggable(dbg.searchDebuggable);
+		if (!device || (device->getSize() != size)) {
+			throw CommandException("Debuggable ", dbg.searchDebuggable,
+			                       " changed, restart the search");
+		}
+		buf.resize(size);
+		device->readBlock(0, buf.data(), size);
+		return span<const byte>(buf.data(), size);
+	};
+	MemBuffer<byte> buf;
+	executeSubCommand(tokens[2].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, 4, Prefix{3}, "debuggable");
+			string_view devName = tokens[3].getString();
+			Debuggable& device = dbg.getDebuggable(devName);
+			unsigned size = device.getSize();
+			buf.resize(size);
+			device.readBlock(0, buf.data(), size);
+			ms.start(span<const byte>(buf.data(), size));
+			dbg.searchDebuggable = devName.str();
+			result = ms.count();
+		},
+		"filter", [&]{
+			checkNumArgs(tokens, Between{4, 5}, Prefix{3}, "op ?value?");
+			auto op = parseSearchOp(tokens[3].getString());
+			auto data = readData(buf);
+			if (tokens.size() == 5) {
+				unsigned value = tokens[4].getInt(interp);
+				if (value >= 256) {
+					throw CommandException("Invalid value");
+				}
+				ms.filter(data, op, value);
+			} else {
+				ms.filter(data, op);
+			}
+			result = ms.count();
+		},
+		"keep", [&]{
+			checkNumArgs(tokens, 4, Prefix{3}, "addresses");
+			unsigned num = tokens[3].getListLength(interp);
+			vector<unsigned> addrs;
+			addrs.reserve(num);
+			for (auto i : xrange(num)) {
+				addrs.push_back(tokens[3].getListIndex(interp, i).getInt(interp));
+			}
+			auto data = readData(buf);
+			ms.keep(addrs, data);
+			result = ms.count();
+		},
+		"count", [&]{
+			checkNumArgs(tokens, 3, "");
+			result = getActive().count();
+		},
+		"results", [&]{
+			int maxNum = -1;
+			ArgsInfo info[] = { valueArg("-max", maxNum) };
+			auto arguments = parseTclArgs(interp, tokens.subspan(3), info);
+			if (!arguments.empty()) throw SyntaxError();
+			getActive().forEach([&](unsigned addr) {
+				if (maxNum == 0) return false;
+				--maxNum;
+				result.addListElement(makeTclList(
+					addr, ms.getPrevious(addr), ms.getValue(addr)));
+				return true;
+			});
+		},
+		"stop", [&]{
+			checkNumArgs(tokens, 3, "");
+			ms.clear();
+			dbg.searchDebuggable.clear();
+		});
+}
+
 vector<string> Debugger::Cmd::getBreakPointIds() const
 {
 	return to_vector(view::transform(
@@ -966,12 +1632,13 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 	};
 	static const char* const debuggableArgCmds[] = {
 		"desc", "size", "read", "read_block",
-		"write", "write_block",
+		"write", "write_block", "write_multi", "diff",
 	};
 	static const char* const otherCmds[] = {
-		"disasm", "set_bp", "remove_bp", "set_watchpoint",
-		"remove_watchpoint", "set_condition", "remove_condition",
-		"probe",
+		"disasm", "disasm_block", "set_bp", "remove_bp", "set_watchpoint",
+		"remove_watchpoint", "watchpoint_log", "set_condition", "remove_condition",
+		"probe", "scheduler_stats", "profile", "cputrace", "heatmap",
+		"coverage", "search",
 	};
 	switch (tokens.size()) {
 	case 2: {
@@ -987,7 +1654,8 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 			} else if (tokens[1] == "remove_bp") {
 				// this one takes a bp id
 				completeString(tokens, getBreakPointIds());
-			} else if (tokens[1] == "remove_watchpoint") {
+			} else if ((tokens[1] == "remove_watchpoint") ||
+			           (tokens[1] == "watchpoint_log")) {
 				// this one takes a wp id
 				completeString(tokens, getWatchPointIds());
 			} else if (tokens[1] == "remove_condition") {
@@ -1005,6 +1673,40 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 					"remove_bp", "list_bp",
 				};
 				completeString(tokens, subCmds);
+			} else if (tokens[1] == "scheduler_stats") {
+				static const char* const subCmds[] = {
+					"start", "stop", "reset",
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "profile") {
+				static const char* const subCmds[] = {
+					"start", "stop", "clear", "dump",
+					"load_symbols", "clear_symbols",
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "cputrace") {
+				static const char* const subCmds[] = {
+					"start", "stop", "clear", "size", "save", "load",
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "heatmap") {
+				static const char* const subCmds[] = {
+					"list", "desc", "start", "stop", "clear",
+					"dump", "save",
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "coverage") {
+				static const char* const subCmds[] = {
+					"start", "stop", "clear", "count", "dump",
+					"save", "merge", "report",
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "search") {
+				static const char* const subCmds[] = {
+					"start", "filter", "keep", "count", "results",
+					"stop",
+				};
+				completeString(tokens, subCmds);
 			}
 		}
 		break;
@@ -1016,9 +1718,37 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 				debugger().probes,
 				[](auto* p) { return p->getName(); }));
 			completeString(tokens, probeNames);
+		} else if ((tokens[1] == "heatmap") && (tokens[2] != "list")) {
+			auto names = to_vector(view::transform(
+				debugger().heatmaps,
+				[](auto* h) { return h->getName(); }));
+			completeString(tokens, names);
+		} else if ((tokens[1] == "search") && (tokens[2] == "start")) {
+			completeString(tokens, view::keys(debugger().debuggables));
 		}
 		break;
 	}
 }
 
+
+// class SchedulerStatsInfo
+
+Debugger::SchedulerStatsInfo::SchedulerStatsInfo(InfoCommand& machineInfoCommand)
+	: InfoTopic(machineInfoCommand, "scheduler_stats")
+{
+}
+
+void Debugger::SchedulerStatsInfo::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	auto& debugger = OUTER(Debugger, schedulerStatsInfo);
+	getSchedulerStats(debugger.motherBoard.getScheduler(), result);
+}
+
+string Debugger::SchedulerStatsInfo::help(const vector<string>& /*tokens*/) const
+{
+	return "Returns the statistics collected with 'debug scheduler_stats "
+	       "start', see 'help debug scheduler_stats'.\n";
+}
+
 } // namespace openmsx
@@ -1,8 +1,11 @@
 #ifndef DEBUGGER_HH
 #define DEBUGGER_HH
 
+#include "MemorySearch.hh"
 #include "Probe.hh"
+#include "Profiler.hh"
 #include "RecordedCommand.hh"
+#include "InfoTopic.hh"
 #include "WatchPoint.hh"
 #include "hash_map.hh"
 #include "string_view.hh"
@@ -17,6 +20,7 @@ class MSXMotherBoard;
 class Debuggable;
 class ProbeBase;
 class ProbeBreakPoint;
+class Heatmap;
 class MSXCPU;
 
 class Debugger
@@ -31,11 +35,17 @@ public:
 	void registerDebuggable   (std::string name, Debuggable& debuggable);
 	void unregisterDebuggable (string_view name, Debuggable& debuggable);
 	Debuggable* findDebuggable(string_view name);
+	const hash_map<std::string, Debuggable*, XXHasher>& getDebuggables() const {
+		return debuggables;
+	}
 
 	void registerProbe  (ProbeBase& probe);
 	void unregisterProbe(ProbeBase& probe);
 	ProbeBase* findProbe(string_view name);
 
+	void registerHeatmap  (Heatmap& heatmap);
+	void unregisterHeatmap(Heatmap& heatmap);
+
 	void removeProbeBreakPoint(ProbeBreakPoint& bp);
 	void setCPU(MSXCPU* cpu_) { cpu = cpu_; }
 
@@ -46,6 +56,7 @@ public:
 private:
 	Debuggable& getDebuggable(string_view name);
 	ProbeBase& getProbe(string_view name);
+	Heatmap& getHeatmap(string_view name);
 
 	unsigned insertProbeBreakPoint(
 		TclObject command, TclObject condition,
@@ -55,7 +66,8 @@ private:
 	unsigned setWatchPoint(TclObject command, TclObject condition,
 	                       WatchPoint::Type type,
 	                       unsigned beginAddr, unsigned endAddr,
-	                       bool once, unsigned newId = -1);
+	                       bool once, std::shared_ptr<AccessLog> log,
+	                       unsigned newId = -1);
 
 	MSXMotherBoard& motherBoard;
 
@@ -80,6 +92,8 @@ private:
 		void readBlock(span<const TclObject> tokens, TclObject& result);
 		void write(span<const TclObject> tokens, TclObject& result);
 		void writeBlock(span<const TclObject> tokens, TclObject& result);
+		void writeMulti(span<const TclObject> tokens, TclObject& result);
+		void diff(span<const TclObject> tokens, TclObject& result);
 		void setBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void removeBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void listBreakPoints(span<const TclObject> tokens, TclObject& result);
@@ -89,6 +103,7 @@ private:
 		void setWatchPoint(span<const TclObject> tokens, TclObject& result);
 		void removeWatchPoint(span<const TclObject> tokens, TclObject& result);
 		void listWatchPoints(span<const TclObject> tokens, TclObject& result);
+		void watchPointLog(span<const TclObject> tokens, TclObject& result);
 		void setCondition(span<const TclObject> tokens, TclObject& result);
 		void removeCondition(span<const TclObject> tokens, TclObject& result);
 		void listConditions(span<const TclObject> tokens, TclObject& result);
@@ -99,8 +114,23 @@ private:
 		void probeSetBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeRemoveBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeListBreakPoints(span<const TclObject> tokens, TclObject& result);
+		void schedulerStats(span<const TclObject> tokens, TclObject& result);
+		void profile(span<const TclObject> tokens, TclObject& result);
+		void cpuTrace(span<const TclObject> tokens, TclObject& result);
+		void heatmap(span<const TclObject> tokens, TclObject& result);
+		void coverage(span<const TclObject> tokens, TclObject& result);
+		void search(span<const TclObject> tokens, TclObject& result);
 	} cmd;
 
+	struct SchedulerStatsInfo final : InfoTopic {
+		explicit SchedulerStatsInfo(InfoCommand& machineInfoCommand);
+		void execute(span<const TclObject> tokens,
+			     TclObject& result) const override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+	} schedulerStatsInfo;
+
+	Profiler profiler;
+
 	struct NameFromProbe {
 		const std::string& operator()(const ProbeBase* p) const {
 			return p->getName();
@@ -108,9 +138,14 @@ private:
 	};
 
 	hash_map<std::string, Debuggable*, XXHasher> debuggables;
+	std::string lastDebuggableName; // cache for findDebuggable()
+	Debuggable* lastDebuggable = nullptr;
 	hash_set<ProbeBase*, NameFromProbe, XXHasher>  probes;
 	using ProbeBreakPoints = std::vector<std::unique_ptr<ProbeBreakPoint>>;
 	ProbeBreakPoints probeBreakPoints; // unordered
+	std::vector<Heatmap*> heatmaps; // unordered
+	MemorySearch memorySearch;
+	std::string searchDebuggable; // name of the searched debuggable
 	MSXCPU* cpu;
 };
 
@@ -0,0 +1,72 @@
+#include "Heatmap.hh"
+#include "Debugger.hh"
+#include "File.hh"
+#include "TclObject.hh"
+#include "endian.hh"
+#include "strCat.hh"
+
+namespace openmsx {
+
+Heatmap::Heatmap(Debugger& debugger_, std::string name_,
+                 std::string description_, unsigned size)
+	: debugger(debugger_)
+	, name(std::move(name_))
+	, description(std::move(description_))
+	, counts((size + (1 << PAGE_BITS) - 1) >> PAGE_BITS)
+	, enabled(false)
+{
+	clear();
+	debugger.registerHeatmap(*this);
+}
+
+Heatmap::~Heatmap()
+{
+	debugger.unregisterHeatmap(*this);
+}
+
+void Heatmap::setEnabled(bool enabled_)
+{
+	if (enabled == enabled_) return;
+	enabled = enabled_;
+	enabledChanged();
+}
+
+void Heatmap::clear()
+{
+	for (auto& c : counts) c = Counts{0, 0, 0};
+}
+
+TclObject Heatmap::getCounts() const
+{
+	TclObject result;
+	for (unsigned page = 0; page < counts.size(); ++page) {
+		auto& c = counts[page];
+		if (c.reads || c.writes || c.executes) {
+			result.addDictKeyValue(formatPage(page), makeTclList(
+				int64_t(c.reads), int64_t(c.writes),
+				int64_t(c.executes)));
+		}
+	}
+	return result;
+}
+
+void Heatmap::save(const std::string& filename) const
+{
+	std::vector<uint8_t> buf(counts.size() * 24);
+	uint8_t* p = buf.data();
+	for (auto& c : counts) {
+		Endian::write_UA_L64(p +  0, c.reads);
+		Endian::write_UA_L64(p +  8, c.writes);
+		Endian::write_UA_L64(p + 16, c.executes);
+		p += 24;
+	}
+	File file(filename, File::TRUNCATE);
+	file.write(buf.data(), buf.size());
+}
+
+std::string Heatmap::formatPage(unsigned page) const
+{
+	return strCat(hex_string<5>(page << PAGE_BITS));
+}
+
+} // namespace openmsx
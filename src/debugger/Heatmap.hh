@@ -0,0 +1,73 @@
+#ifndef HEATMAP_HH
+#define HEATMAP_HH
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class Debugger;
+class TclObject;
+
+/** Counts the number of reads, writes and executed instructions per 256-byte
+  * page of some memory (e.g. the CPU address space in all slots or the VRAM).
+  * Counting is off by default, it can be enabled with 'debug heatmap'. The
+  * owner of the memory should only call read(), write() and execute() while
+  * isEnabled() returns true.
+  */
+class Heatmap
+{
+public:
+	static const unsigned PAGE_BITS = 8;
+
+	Heatmap(Debugger& debugger, std::string name, std::string description,
+	        unsigned size);
+	virtual ~Heatmap();
+
+	const std::string& getName() const { return name; }
+	const std::string& getDescription() const { return description; }
+
+	bool isEnabled() const { return enabled; }
+	void setEnabled(bool enabled);
+	void clear();
+
+	void read   (unsigned address) { ++counts[address >> PAGE_BITS].reads; }
+	void write  (unsigned address) { ++counts[address >> PAGE_BITS].writes; }
+	void execute(unsigned address) { ++counts[address >> PAGE_BITS].executes; }
+
+	/** A Tcl dict with for each page that was accessed at least once a
+	  * list with the number of reads, writes and executes. The keys are
+	  * formatted by formatPage().
+	  */
+	TclObject getCounts() const;
+
+	/** Write the counts of all pages to a file: per page the number of
+	  * reads, writes and executes, each as a 64-bit little endian value.
+	  * @throws FileException
+	  */
+	void save(const std::string& filename) const;
+
+protected:
+	/** Called after counting was enabled or disabled. */
+	virtual void enabledChanged() {}
+	/** By default the (hexadecimal) start address of the page. */
+	virtual std::string formatPage(unsigned page) const;
+
+private:
+	struct Counts {
+		uint64_t reads;
+		uint64_t writes;
+		uint64_t executes;
+	};
+
+	Debugger& debugger;
+	const std::string name;
+	const std::string description;
+	std::vector<Counts> counts;
+	bool enabled;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,169 @@
+#include "MemorySearch.hh"
+#include <cassert>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx {
+
+static unsigned countBits(uint64_t x)
+{
+#ifdef __GNUC__
+	return __builtin_popcountll(x);
+#else
+	unsigned bits = 0;
+	for (; x; x &= x - 1) ++bits;
+	return bits;
+#endif
+}
+
+// Compare 'num' (at most 64) bytes, bit i of the result is set when
+// 'a[i] op b[i]' holds.
+static uint64_t compareScalar(const uint8_t* a, const uint8_t* b, unsigned num,
+                              MemorySearch::Op op)
+{
+	uint64_t result = 0;
+	for (unsigned i = 0; i < num; ++i) {
+		bool r;
+		switch (op) {
+			case MemorySearch::EQ: r = a[i] == b[i]; break;
+			case MemorySearch::NE: r = a[i] != b[i]; break;
+			case MemorySearch::LT: r = a[i] <  b[i]; break;
+			case MemorySearch::LE: r = a[i] <= b[i]; break;
+			case MemorySearch::GT: r = a[i] >  b[i]; break;
+			default:               r = a[i] >= b[i]; break;
+		}
+		result |= uint64_t(r) << i;
+	}
+	return result;
+}
+
+#ifdef __SSE2__
+// Same as compareScalar(), but for exactly 64 bytes.
+static uint64_t compare64(const uint8_t* a, const uint8_t* b,
+                          MemorySearch::Op op)
+{
+	// SSE2 only has a signed byte compare, but with the unsigned maximum:
+	//   a >= b  <=>  max(a, b) == a
+	//   a <= b  <=>  max(a, b) == b
+	// and the other relations are the complement of these.
+	uint64_t result = 0;
+	for (unsigned i = 0; i < 4; ++i) {
+		auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16 * i));
+		auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16 * i));
+		__m128i r;
+		switch (op) {
+			case MemorySearch::EQ:
+			case MemorySearch::NE:
+				r = _mm_cmpeq_epi8(x, y);
+				break;
+			case MemorySearch::LT:
+			case MemorySearch::GE:
+				r = _mm_cmpeq_epi8(_mm_max_epu8(x, y), x);
+				break;
+			default: // LE, GT
+				r = _mm_cmpeq_epi8(_mm_max_epu8(x, y), y);
+				break;
+		}
+		result |= uint64_t(_mm_movemask_epi8(r) & 0xffff) << (16 * i);
+	}
+	bool invert = (op == MemorySearch::NE) || (op == MemorySearch::LT) ||
+	              (op == MemorySearch::GT);
+	return invert ? ~result : result;
+}
+#else
+static uint64_t compare64(const uint8_t* a, const uint8_t* b,
+                          MemorySearch::Op op)
+{
+	return compareScalar(a, b, 64, op);
+}
+#endif
+
+void MemorySearch::start(span<const uint8_t> data)
+{
+	size = unsigned(data.size());
+	snapshot.resize(size);
+	previous.resize(size);
+	memcpy(snapshot.data(), data.data(), size);
+	memcpy(previous.data(), data.data(), size);
+
+	// Only the bits for existing addresses are set in the last word.
+	bitmap.assign((size + 63) / 64, ~uint64_t(0));
+	if (unsigned tail = size % 64) {
+		bitmap.back() = (uint64_t(1) << tail) - 1;
+	}
+	active = true;
+}
+
+void MemorySearch::clear()
+{
+	snapshot.clear();
+	previous.clear();
+	bitmap.clear();
+	size = 0;
+	active = false;
+}
+
+void MemorySearch::filterImpl(const uint8_t* data, Op op, const uint8_t* ref,
+                              bool constant)
+{
+	unsigned fullWords = size / 64;
+	for (unsigned w = 0; w < fullWords; ++w) {
+		// In later steps most words are zero, those need no work.
+		if (!bitmap[w]) continue;
+		bitmap[w] &= compare64(data + 64 * w, constant ? ref : ref + 64 * w, op);
+	}
+	if (unsigned tail = size % 64) {
+		unsigned w = fullWords;
+		bitmap[w] &= compareScalar(data + 64 * w,
+		                           constant ? ref : ref + 64 * w, tail, op);
+	}
+	updateSnapshot(data);
+}
+
+void MemorySearch::updateSnapshot(const uint8_t* data)
+{
+	previous.swap(snapshot);
+	memcpy(snapshot.data(), data, size);
+}
+
+void MemorySearch::filter(span<const uint8_t> data, Op op)
+{
+	assert(isActive());
+	assert(data.size() == size);
+	filterImpl(data.data(), op, snapshot.data(), false);
+}
+
+void MemorySearch::filter(span<const uint8_t> data, Op op, uint8_t value)
+{
+	assert(isActive());
+	assert(data.size() == size);
+	uint8_t ref[64];
+	memset(ref, value, sizeof(ref));
+	filterImpl(data.data(), op, ref, true);
+}
+
+void MemorySearch::keep(span<const unsigned> addrs, span<const uint8_t> data)
+{
+	assert(isActive());
+	assert(data.size() == size);
+	std::vector<uint64_t> newBitmap(bitmap.size(), 0);
+	for (auto addr : addrs) {
+		if ((addr < size) && isCandidate(addr)) {
+			newBitmap[addr / 64] |= uint64_t(1) << (addr % 64);
+		}
+	}
+	bitmap = std::move(newBitmap);
+	updateSnapshot(data.data());
+}
+
+unsigned MemorySearch::count() const
+{
+	unsigned result = 0;
+	for (auto w : bitmap) result += countBits(w);
+	return result;
+}
+
+} // namespace openmsx
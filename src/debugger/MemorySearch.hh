@@ -0,0 +1,91 @@
+#ifndef MEMORYSEARCH_HH
+#define MEMORYSEARCH_HH
+
+#include "MemBuffer.hh"
+#include "Math.hh"
+#include "span.hh"
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+/** Iteratively narrows down the addresses of a block of memory (e.g. the
+  * content of a debuggable) that satisfy some condition, like "the value
+  * decreased since the previous step". This is the core of cheat finding.
+  *
+  * A snapshot of the memory is taken at the start. Each filter step compares
+  * the new content with that snapshot (or with a constant value), removes the
+  * addresses that don't match from the set of candidates and then replaces
+  * the snapshot with the new content (the old content is kept as well, e.g.
+  * to show how the remaining candidates changed). The candidates are stored as a bitmap,
+  * one bit per byte, the comparisons are done on 64 bytes at once.
+  */
+class MemorySearch
+{
+public:
+	/** Comparison between the new value (left) and the old value or the
+	  * given constant (right). */
+	enum Op { EQ, NE, LT, LE, GT, GE };
+
+	/** Take an initial snapshot, all addresses are candidates. */
+	void start(span<const uint8_t> data);
+	/** Forget the snapshot and all candidates. */
+	void clear();
+
+	bool isActive() const { return active; }
+	/** The size of the searched memory (the size of the snapshot). */
+	unsigned getSize() const { return size; }
+
+	/** Only keep the candidates for which 'data[addr] op snapshot[addr]'
+	  * holds. 'data' must have the same size as the snapshot. */
+	void filter(span<const uint8_t> data, Op op);
+	/** Only keep the candidates for which 'data[addr] op value' holds. */
+	void filter(span<const uint8_t> data, Op op, uint8_t value);
+	/** Only keep the candidates that are in the given list of addresses.
+	  * E.g. for conditions that can't be expressed with filter(). */
+	void keep(span<const unsigned> addrs, span<const uint8_t> data);
+
+	/** The number of remaining candidates. */
+	unsigned count() const;
+	bool isCandidate(unsigned addr) const {
+		return (bitmap[addr / 64] >> (addr % 64)) & 1;
+	}
+	/** The value at the given address in the snapshot, so the value that
+	  * was passed to the last start(), filter() or keep() call. */
+	uint8_t getValue(unsigned addr) const { return snapshot[addr]; }
+	/** The value at the given address in the snapshot before that, so the
+	  * value that was compared against in the last step (only meaningful
+	  * after at least one filter() or keep() call). */
+	uint8_t getPrevious(unsigned addr) const { return previous[addr]; }
+
+	/** Call f(addr) for all remaining candidates, in increasing order.
+	  * Stops early when f returns false. */
+	template<typename F> void forEach(F f) const {
+		for (unsigned w = 0; w < bitmap.size(); ++w) {
+			for (uint64_t bits = bitmap[w]; bits; bits &= bits - 1) {
+				if (!f(64 * w + lowestBit(bits))) return;
+			}
+		}
+	}
+
+private:
+	void filterImpl(const uint8_t* data, Op op, const uint8_t* ref,
+	                bool constant);
+	static unsigned lowestBit(uint64_t x) {
+		auto lo = uint32_t(x);
+		return lo ? Math::findFirstSet(lo) - 1
+		          : Math::findFirstSet(uint32_t(x >> 32)) + 31;
+	}
+
+	void updateSnapshot(const uint8_t* data);
+
+	MemBuffer<uint8_t> snapshot;
+	MemBuffer<uint8_t> previous;
+	std::vector<uint64_t> bitmap; // bit i of word w <-> address 64 * w + i
+	unsigned size = 0;
+	bool active = false;
+};
+
+} // namespace openmsx
+
+#endif
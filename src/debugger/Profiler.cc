@@ -0,0 +1,153 @@
+#include "Profiler.hh"
+#include "MSXMotherBoard.hh"
+#include "MSXCPU.hh"
+#include "CPURegs.hh"
+#include "MSXCPUInterface.hh"
+#include "MSXMemoryMapper.hh"
+#include "TclObject.hh"
+#include "ranges.hh"
+#include "strCat.hh"
+#include "xxhash.hh"
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+// Layout of a location:
+//   bits  0-15: address
+//   bits 16-17: secondary slot
+//   bits 18-19: primary slot
+//   bit     20: primary slot is expanded
+//   bit     21: segment is valid
+//   bits 24-31: memory mapper segment
+static const uint32_t EXPANDED = 1 << 20;
+static const uint32_t SEGMENT  = 1 << 21;
+
+static const unsigned Z80_FREQ = 3579545;
+
+Profiler::Profiler(MSXMotherBoard& motherBoard_)
+	: Schedulable(motherBoard_.getScheduler())
+	, motherBoard(motherBoard_)
+	, interval(EmuDuration::hz(Z80_FREQ) * 1000)
+	, running(false)
+{
+}
+
+void Profiler::start(unsigned cycles)
+{
+	assert(cycles != 0);
+	stop();
+	interval = EmuDuration::hz(Z80_FREQ) * cycles;
+	running = true;
+	setSyncPoint(getCurrentTime() + interval);
+}
+
+void Profiler::stop()
+{
+	removeSyncPoint();
+	running = false;
+}
+
+void Profiler::clear()
+{
+	samples.clear();
+}
+
+void Profiler::transfer(Profiler& other)
+{
+	samples = std::move(other.samples);
+	symbols = std::move(other.symbols);
+	interval = other.interval;
+	if (other.running) {
+		other.stop();
+		running = true;
+		setSyncPoint(getCurrentTime() + interval);
+	}
+}
+
+void Profiler::executeUntil(EmuTime::param time)
+{
+	auto& regs = motherBoard.getCPU().getRegisters();
+	auto& interface = motherBoard.getCPUInterface();
+	unsigned pc = regs.getPC();
+	unsigned sp = regs.getSP();
+	unsigned top = interface.peekMem(sp, time) +
+	               (interface.peekMem((sp + 1) & 0xFFFF, time) << 8);
+	++samples[(uint64_t(getLocation(top)) << 32) | getLocation(pc)];
+	setSyncPoint(time + interval);
+}
+
+uint32_t Profiler::getLocation(unsigned address) const
+{
+	auto& interface = motherBoard.getCPUInterface();
+	int page = address >> 14;
+	int ps = interface.getPrimarySlot(page);
+	uint32_t result = address | (ps << 18);
+	if (interface.isExpanded(ps)) {
+		result |= EXPANDED | (interface.getSecondarySlot(page) << 16);
+	}
+	// only the standard memory mapper, other devices with a mapper
+	// (e.g. Carnivore2) are shown without segment
+	if (auto* mapper = dynamic_cast<MSXMemoryMapper*>(
+			interface.getVisibleMemDevice(page))) {
+		result |= SEGMENT | (mapper->getSelectedSegment(page) << 24);
+	}
+	return result;
+}
+
+// Formatted as <ps>[-<ss>][/<segment>]:<address or symbol>, for example
+// "3-2/5:4A3F" or "0:CHPUT+3"
+std::string Profiler::formatLocation(uint32_t location, bool withOffset) const
+{
+	std::string result = strCat((location >> 18) & 3);
+	if (location & EXPANDED) strAppend(result, '-', (location >> 16) & 3);
+	if (location & SEGMENT)  strAppend(result, '/', location >> 24);
+	result += ':';
+	uint16_t address = location & 0xFFFF;
+	if (auto* symbol = symbols.lookup(address)) {
+		result += symbol->name;
+		if (withOffset && (address != symbol->address)) {
+			strAppend(result, '+', address - symbol->address);
+		}
+	} else {
+		strAppend(result, hex_string<4>(address));
+	}
+	return result;
+}
+
+TclObject Profiler::getSamples() const
+{
+	std::vector<std::pair<uint64_t, uint64_t>> sorted(
+		samples.begin(), samples.end());
+	ranges::sort(sorted, [](auto& x, auto& y) { return x.second > y.second; });
+
+	TclObject result;
+	for (auto& s : sorted) {
+		result.addListElement(makeTclList(
+			formatLocation(uint32_t(s.first), true),
+			formatLocation(uint32_t(s.first >> 32), true),
+			int64_t(s.second)));
+	}
+	return result;
+}
+
+std::string Profiler::getFolded() const
+{
+	hash_map<std::string, uint64_t, XXHasher> folded;
+	for (auto& s : samples) {
+		folded[strCat(formatLocation(uint32_t(s.first >> 32), false), ';',
+		              formatLocation(uint32_t(s.first), false))] += s.second;
+	}
+	std::vector<std::pair<std::string, uint64_t>> sorted(
+		folded.begin(), folded.end());
+	ranges::sort(sorted, [](auto& x, auto& y) { return x.first < y.first; });
+
+	std::string result;
+	for (auto& f : sorted) {
+		strAppend(result, f.first, ' ', f.second, '\n');
+	}
+	return result;
+}
+
+} // namespace openmsx
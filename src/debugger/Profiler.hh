@@ -0,0 +1,75 @@
+#ifndef PROFILER_HH
+#define PROFILER_HH
+
+#include "Schedulable.hh"
+#include "SymbolTable.hh"
+#include "EmuDuration.hh"
+#include "hash_map.hh"
+#include <cstdint>
+#include <string>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+class TclObject;
+
+/** Sampling profiler for the emulated CPU.
+  *
+  * At regular (emulated) time intervals, the location of the instruction that
+  * is being executed is recorded, together with the location of the word on
+  * top of the stack (when the CPU is in a subroutine this is the return
+  * address, otherwise it's just some value). A location is the address plus
+  * the slot (and the memory mapper segment, if any) that is visible at that
+  * address. Compared to per-instruction breakpoints or conditions this has
+  * very little overhead.
+  */
+class Profiler final : private Schedulable
+{
+public:
+	explicit Profiler(MSXMotherBoard& motherBoard);
+
+	/** Start sampling, every 'interval' Z80 clock cycles (3.58MHz). */
+	void start(unsigned interval);
+	void stop();
+	bool isRunning() const { return running; }
+
+	/** Discard all samples (symbols are kept). */
+	void clear();
+
+	SymbolTable& getSymbols() { return symbols; }
+
+	/** A Tcl list with for each recorded (location, stack-top) pair
+	  * a list with these two (symbolized) locations and the number of
+	  * samples, sorted on descending count.
+	  */
+	TclObject getSamples() const;
+
+	/** The samples in the 'folded stacks' format that is used by
+	  * FlameGraph tools, one line "<stack-top>;<location> <count>" per
+	  * pair. Locations are reduced to the (nearest) symbol, so that all
+	  * samples within one routine are combined.
+	  */
+	std::string getFolded() const;
+
+	/** Take over the samples and settings from the profiler of another
+	  * machine (used when switching to a new machine on reverse).
+	  */
+	void transfer(Profiler& other);
+
+private:
+	void executeUntil(EmuTime::param time) override;
+
+	uint32_t getLocation(unsigned address) const;
+	std::string formatLocation(uint32_t location, bool withOffset) const;
+
+	MSXMotherBoard& motherBoard;
+	SymbolTable symbols;
+	// key: (stack-top location << 32) | location,  value: number of samples
+	hash_map<uint64_t, uint64_t> samples;
+	EmuDuration interval;
+	bool running;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,86 @@
+#include "SymbolTable.hh"
+#include "File.hh"
+#include "StringOp.hh"
+#include "ranges.hh"
+
+namespace openmsx {
+
+static bool parseValue(string_view str, unsigned& result)
+{
+	unsigned base = 10;
+	if (StringOp::startsWith(str, "0x") || StringOp::startsWith(str, "0X")) {
+		base = 16; str.remove_prefix(2);
+	} else if (StringOp::startsWith(str, '$') || StringOp::startsWith(str, '#')) {
+		base = 16; str.remove_prefix(1);
+	} else if (StringOp::endsWith(str, 'h') || StringOp::endsWith(str, 'H')) {
+		base = 16; str.remove_suffix(1);
+	}
+	if (str.empty()) return false;
+	uint64_t value = 0;
+	for (char c : str) {
+		unsigned digit;
+		if (('0' <= c) && (c <= '9')) {
+			digit = c - '0';
+		} else if (('a' <= c) && (c <= 'f')) {
+			digit = c - 'a' + 10;
+		} else if (('A' <= c) && (c <= 'F')) {
+			digit = c - 'A' + 10;
+		} else {
+			return false;
+		}
+		if (digit >= base) return false;
+		value = value * base + digit;
+		if (value > 0xFFFFFFFF) return false;
+	}
+	result = unsigned(value);
+	return true;
+}
+
+unsigned SymbolTable::parse(string_view text)
+{
+	unsigned count = 0;
+	for (auto line : StringOp::split(text, '\n')) {
+		auto comment = line.find(';');
+		if (comment != string_view::npos) line = line.substr(0, comment);
+		std::vector<string_view> words;
+		for (auto w : StringOp::split(line, ' ')) {
+			for (auto w2 : StringOp::split(w, '\t')) {
+				StringOp::trim(w2, '\r');
+				if (!w2.empty()) words.push_back(w2);
+			}
+		}
+		if (words.size() != 3) continue;
+
+		StringOp::casecmp cmp;
+		if (!cmp(words[1], "equ") && !cmp(words[1], "%equ")) continue;
+		unsigned value;
+		if (!parseValue(words[2], value) || (value > 0xFFFF)) continue;
+		string_view name = words[0];
+		if (StringOp::endsWith(name, ':')) name.remove_suffix(1);
+		if (name.empty()) continue;
+
+		symbols.push_back({name.str(), uint16_t(value)});
+		++count;
+	}
+	ranges::stable_sort(symbols,
+		[](const Symbol& x, const Symbol& y) { return x.address < y.address; });
+	return count;
+}
+
+unsigned SymbolTable::load(const std::string& filename)
+{
+	File file(filename);
+	auto buf = file.mmap();
+	return parse(string_view(reinterpret_cast<const char*>(buf.data()),
+	                         buf.size()));
+}
+
+const SymbolTable::Symbol* SymbolTable::lookup(uint16_t address) const
+{
+	auto it = ranges::upper_bound(symbols, address,
+		[](uint16_t a, const Symbol& s) { return a < s.address; });
+	if (it == symbols.begin()) return nullptr;
+	return &*(it - 1);
+}
+
+} // namespace openmsx
@@ -0,0 +1,52 @@
+#ifndef SYMBOLTABLE_HH
+#define SYMBOLTABLE_HH
+
+#include "string_view.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Mapping from (Z80) addresses to symbol names, as loaded from the symbol
+  * files that are generated by assemblers.
+  */
+class SymbolTable
+{
+public:
+	struct Symbol {
+		std::string name;
+		uint16_t address;
+	};
+
+	/** Add the symbols from the content of a symbol file. These are the
+	  * lines of the form
+	  *    <name>[:] [%]equ <value>
+	  * with <value> in decimal, or in hexadecimal with prefix '0x', '$' or
+	  * '#' or with suffix 'h' (this covers the output of e.g. sjasm,
+	  * sjasmplus, tniASM and pasmo). Other lines and comments (starting
+	  * with ';') are ignored.
+	  * @return The number of symbols that were added.
+	  */
+	unsigned parse(string_view text);
+
+	/** Same as parse(), but on the content of the given file.
+	  * @throws FileException
+	  */
+	unsigned load(const std::string& filename);
+
+	/** Returns the symbol with the highest address that is not higher
+	  * than the given address, or nullptr if there's no such symbol.
+	  */
+	const Symbol* lookup(uint16_t address) const;
+
+	void clear() { symbols.clear(); }
+	bool empty() const { return symbols.empty(); }
+
+private:
+	std::vector<Symbol> symbols; // sorted on address
+};
+
+} // namespace openmsx
+
+#endif
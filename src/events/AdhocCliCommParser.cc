@@ -1,5 +1,6 @@
 #include "AdhocCliCommParser.hh"
 #include "utf8_unchecked.hh"
+#include <algorithm>
 
 
 AdhocCliCommParser::AdhocCliCommParser(std::function<void(const std::string&)> callback_)
@@ -10,9 +11,50 @@ AdhocCliCommParser::AdhocCliCommParser(std::function<void(const std::string&)> c
 
 void AdhocCliCommParser::parse(const char* buf, size_t n)
 {
+	if (binary) {
+		parseBinary(buf, n);
+		return;
+	}
 	for (size_t i = 0; i < n; ++i) parse(buf[i]);
 }
 
+void AdhocCliCommParser::setBinary(bool binary_)
+{
+	if (binary == binary_) return;
+	binary = binary_;
+	// a partially received command (in the old protocol) is dropped
+	state = O0;
+	headerPos = 0;
+	command.clear();
+}
+
+void AdhocCliCommParser::parseBinary(const char* buf, size_t n)
+{
+	// Unlike the XML protocol no character by character parsing is needed,
+	// the payload is copied in one go.
+	while (n) {
+		if (headerPos < FRAME_HEADER_SIZE) {
+			header[headerPos++] = *buf++;
+			--n;
+			if (headerPos < FRAME_HEADER_SIZE) continue;
+			frameSize = (uint32_t(header[0]) <<  0) |
+			            (uint32_t(header[1]) <<  8) |
+			            (uint32_t(header[2]) << 16) |
+			            (uint32_t(header[3]) << 24);
+			command.clear();
+		} else {
+			size_t num = std::min<size_t>(n, frameSize - command.size());
+			command.append(buf, num);
+			buf += num;
+			n -= num;
+		}
+		if (command.size() == frameSize) {
+			if (header[4] == 'C') callback(command);
+			headerPos = 0;
+		}
+	}
+}
+
 void AdhocCliCommParser::parse(char c)
 {
 	// Whenever there is a parse error we return to the initial state
@@ -11,12 +11,31 @@ public:
 	explicit AdhocCliCommParser(std::function<void(const std::string&)> callback);
 	void parse(const char* buf, size_t n);
 
+	/** Switch between the XML protocol (the default) and the binary
+	  * protocol. In the binary protocol every message is a frame: a 4 byte
+	  * little endian length N, a 1 byte kind and N bytes of payload. Only
+	  * frames of kind 'C' (a command) are passed to the callback, others
+	  * are ignored.
+	  */
+	void setBinary(bool binary);
+	bool isBinary() const { return binary; }
+
+	static const unsigned FRAME_HEADER_SIZE = 5;
+
 private:
 	void parse(char c);
+	void parseBinary(const char* buf, size_t n);
 
 	std::function<void(const std::string&)> callback;
 	std::string command;
 	uint32_t unicode;
+
+	// binary protocol
+	bool binary = false;
+	unsigned char header[FRAME_HEADER_SIZE];
+	unsigned headerPos = 0;
+	uint32_t frameSize = 0;
+
 	enum State {
 		O0, // no tag char matched yet
 		O1, // matched <
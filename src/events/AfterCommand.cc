@@ -3,7 +3,9 @@
 #include "CliComm.hh"
 #include "Schedulable.hh"
 #include "EventDistributor.hh"
+#include "FrameProfiler.hh"
 #include "InputEventFactory.hh"
+#include "Interpreter.hh"
 #include "Reactor.hh"
 #include "MSXMotherBoard.hh"
 #include "RTSchedulable.hh"
@@ -31,17 +33,22 @@ public:
 	virtual ~AfterCmd() = default;
 	string_view getCommand() const;
 	const string& getId() const;
+	unsigned getIdNum() const { return idNum; }
+	bool isRepeating() const { return repeating; }
 	virtual string getType() const = 0;
-	void execute();
+	bool execute();
+
+	static unsigned lastAfterId;
 protected:
 	AfterCmd(AfterCommand& afterCommand,
-		 const TclObject& command);
+		 const TclObject& command, bool repeating = false);
 	unique_ptr<AfterCmd> removeSelf();
 
 	AfterCommand& afterCommand;
 	TclObject command;
 	string id;
-	static unsigned lastAfterId;
+	unsigned idNum;
+	bool repeating; // stays registered after it's executed
 };
 
 class AfterTimedCmd : public AfterCmd, private Schedulable
@@ -85,7 +92,7 @@ class AfterEventCmd final : public AfterCmd
 public:
 	AfterEventCmd(AfterCommand& afterCommand,
 		      const TclObject& type,
-		      const TclObject& command);
+		      const TclObject& command, bool repeating);
 	string getType() const override;
 private:
 	const string type;
@@ -284,10 +291,12 @@ void AfterCommand::afterTclTime(
 template<EventType T>
 void AfterCommand::afterEvent(span<const TclObject> tokens, TclObject& result)
 {
-	checkNumArgs(tokens, 3, "command");
-	auto cmd = std::make_unique<AfterEventCmd<T>>(*this, tokens[1], tokens[2]);
+	bool repeat = (tokens.size() == 4) && (tokens[2] == "-repeat");
+	if (!repeat) checkNumArgs(tokens, 3, "?-repeat? command");
+	auto cmd = std::make_unique<AfterEventCmd<T>>(
+		*this, tokens[1], tokens.back(), repeat);
 	result = cmd->getId();
-	afterCmds.push_back(move(cmd));
+	eventCmds[T].push_back(move(cmd));
 }
 
 void AfterCommand::afterInputEvent(
@@ -313,11 +322,21 @@ void AfterCommand::afterIdle(span<const TclObject> tokens, TclObject& result)
 
 void AfterCommand::afterInfo(span<const TclObject> /*tokens*/, TclObject& result)
 {
+	// list the commands in the order they were created
+	vector<const AfterCmd*> cmds;
+	for (auto& c : afterCmds) cmds.push_back(c.get());
+	for (auto& bucket : eventCmds) {
+		for (auto& c : bucket) cmds.push_back(c.get());
+	}
+	ranges::sort(cmds, [](auto* x, auto* y) {
+		return x->getIdNum() < y->getIdNum();
+	});
+
 	ostringstream str;
-	for (auto& cmd : afterCmds) {
+	for (auto* cmd : cmds) {
 		str << cmd->getId() << ": ";
 		str << cmd->getType() << ' ';
-		if (auto cmd2 = dynamic_cast<const AfterTimedCmd*>(cmd.get())) {
+		if (auto cmd2 = dynamic_cast<const AfterTimedCmd*>(cmd)) {
 			str.precision(3);
 			str << std::fixed << std::showpoint << cmd2->getTime() << ' ';
 		}
@@ -332,35 +351,65 @@ void AfterCommand::afterCancel(span<const TclObject> tokens, TclObject& /*result
 	checkNumArgs(tokens, AtLeast{3}, "id|command");
 	if (tokens.size() == 3) {
 		auto id = tokens[2].getString();
-		auto it = ranges::find_if(afterCmds,
-		                          [&](auto& e) { return e->getId() == id; });
-		if (it != end(afterCmds)) {
-			afterCmds.erase(it);
+		if (cancelOldest([&](auto& e) { return e->getId() == id; })) {
 			return;
 		}
 	}
 	TclObject command;
 	command.addListElements(view::drop(tokens, 2));
 	string_view cmdStr = command.getString();
-	auto it = ranges::find_if(afterCmds,
-	                          [&](auto& e) { return e->getCommand() == cmdStr; });
-	if (it != end(afterCmds)) {
-		afterCmds.erase(it);
-		// Tcl manual is not clear about this, but it seems
-		// there's only occurence of this command canceled.
-		// It's also not clear which of the (possibly) several
-		// matches is canceled.
-		return;
-	}
+	// Tcl manual is not clear about this, but it seems there's only
+	// occurence of this command canceled. It's also not clear which of
+	// the (possibly) several matches is canceled.
+	cancelOldest([&](auto& e) { return e->getCommand() == cmdStr; });
 	// It's not an error if no match is found
 }
 
+// Remove the oldest after command for which the predicate returns true.
+template<typename PRED> bool AfterCommand::cancelOldest(PRED pred)
+{
+	AfterCmds* container = nullptr;
+	AfterCmds::iterator oldest;
+	auto check = [&](AfterCmds& cmds) {
+		auto it = ranges::find_if(cmds, pred);
+		if ((it != end(cmds)) &&
+		    (!container || ((*it)->getIdNum() < (*oldest)->getIdNum()))) {
+			container = &cmds;
+			oldest = it;
+		}
+	};
+	check(afterCmds);
+	for (auto& bucket : eventCmds) check(bucket);
+	if (!container) return false;
+	container->erase(oldest);
+	return true;
+}
+
+bool AfterCommand::runCommand(TclObject command, bool compile, string_view type)
+{
+	// 'command' is a copy: the AfterCmd it belongs to may get deleted
+	// while it executes (e.g. when it cancels itself).
+	auto& interp = getInterpreter();
+	FrameProfiler::Section section(
+		reactor.getFrameProfiler(), FrameProfiler::TCL);
+	try {
+		interp.executeProfiled(command, compile,
+			interp.isProfiling() ? strCat("after ", type) : string());
+		return true;
+	} catch (CommandException& e) {
+		getCommandController().getCliComm().printWarning(
+			"Error executing delayed command: ", e.getMessage());
+		return false;
+	}
+}
+
 string AfterCommand::help(const vector<string>& /*tokens*/) const
 {
 	return "after time     <seconds> <command>  execute a command after some time (MSX time)\n"
 	       "after realtime <seconds> <command>  execute a command after some time (realtime)\n"
 	       "after idle     <seconds> <command>  execute a command after some time being idle\n"
 	       "after frame <command>               execute a command after a new frame is drawn\n"
+	       "after frame -repeat <command>       execute a command after every new frame (until canceled)\n"
 	       "after break <command>               execute a command after a breakpoint is reached\n"
 	       "after boot <command>                execute a command after a (re)boot\n"
 	       "after machine_switch <command>      execute a command after a switch to a new machine\n"
@@ -393,14 +442,38 @@ template<typename PRED> void AfterCommand::executeMatches(PRED pred)
 	}
 }
 
-template<EventType T> struct AfterEventPred {
-	bool operator()(const unique_ptr<AfterCmd>& x) const {
-		return dynamic_cast<AfterEventCmd<T>*>(x.get()) != nullptr;
-	}
-};
+// Execute the cmds for event type T. One-shot commands are removed before
+// they're executed, repeating commands stay registered (unless they fail).
+// Commands that are added by the callbacks only run for the next event.
 template<EventType T> void AfterCommand::executeEvents()
 {
-	executeMatches(AfterEventPred<T>());
+	auto& bucket = eventCmds[T];
+	auto idLess = [](const unique_ptr<AfterCmd>& c, unsigned n) {
+		return c->getIdNum() < n;
+	};
+	unsigned last = AfterCmd::lastAfterId;
+	unsigned next = 0;
+	while (true) {
+		// The callbacks can add or remove (other) commands, so look
+		// up the next one again each time.
+		auto it = ranges::lower_bound(bucket, next, idLess);
+		if ((it == end(bucket)) || ((*it)->getIdNum() > last)) break;
+		next = (*it)->getIdNum() + 1;
+		if ((*it)->isRepeating()) {
+			if (!(*it)->execute()) {
+				// don't keep on failing every frame
+				auto it2 = ranges::lower_bound(bucket, next - 1, idLess);
+				if ((it2 != end(bucket)) &&
+				    ((*it2)->getIdNum() == (next - 1))) {
+					bucket.erase(it2);
+				}
+			}
+		} else {
+			auto cmd = move(*it);
+			bucket.erase(it);
+			cmd->execute();
+		}
+	}
 }
 
 struct AfterEmuTimePred {
@@ -456,11 +529,13 @@ int AfterCommand::signalEvent(const std::shared_ptr<const Event>& event)
 
 unsigned AfterCmd::lastAfterId = 0;
 
-AfterCmd::AfterCmd(AfterCommand& afterCommand_, const TclObject& command_)
+AfterCmd::AfterCmd(AfterCommand& afterCommand_, const TclObject& command_,
+                   bool repeating_)
 	: afterCommand(afterCommand_), command(command_)
+	, idNum(++lastAfterId), repeating(repeating_)
 {
 	ostringstream str;
-	str << "after#" << ++lastAfterId;
+	str << "after#" << idNum;
 	id = str.str();
 }
 
@@ -474,14 +549,11 @@ const string& AfterCmd::getId() const
 	return id;
 }
 
-void AfterCmd::execute()
+bool AfterCmd::execute()
 {
-	try {
-		command.executeCommand(afterCommand.getInterpreter());
-	} catch (CommandException& e) {
-		afterCommand.getCommandController().getCliComm().printWarning(
-			"Error executing delayed command: ", e.getMessage());
-	}
+	// Repeating commands are executed over and over again, so then it's
+	// worth to let Tcl keep the compiled script.
+	return afterCommand.runCommand(command, repeating, getType());
 }
 
 unique_ptr<AfterCmd> AfterCmd::removeSelf()
@@ -568,15 +640,16 @@ string AfterIdleCmd::getType() const
 template<EventType T>
 AfterEventCmd<T>::AfterEventCmd(
 		AfterCommand& afterCommand_, const TclObject& type_,
-		const TclObject& command_)
-	: AfterCmd(afterCommand_, command_), type(type_.getString().str())
+		const TclObject& command_, bool repeating_)
+	: AfterCmd(afterCommand_, command_, repeating_)
+	, type(type_.getString().str())
 {
 }
 
 template<EventType T>
 string AfterEventCmd<T>::getType() const
 {
-	return type;
+	return repeating ? type + " -repeat" : type;
 }
 
 
@@ -30,6 +30,7 @@ public:
 
 private:
 	template<typename PRED> void executeMatches(PRED pred);
+	template<typename PRED> bool cancelOldest(PRED pred);
 	template<EventType T> void executeEvents();
 	template<EventType T> void afterEvent(
 	                   span<const TclObject> tokens, TclObject& result);
@@ -42,11 +43,17 @@ private:
 	void afterIdle    (span<const TclObject> tokens, TclObject& result);
 	void afterInfo    (span<const TclObject> tokens, TclObject& result);
 	void afterCancel  (span<const TclObject> tokens, TclObject& result);
+	bool runCommand(TclObject command, bool compile, string_view type);
 
 	// EventListener
 	int signalEvent(const std::shared_ptr<const Event>& event) override;
 
 	using AfterCmds = std::vector<std::unique_ptr<AfterCmd>>;
+	// The 'after frame', 'after break', ... commands, per event type, so
+	// that an event doesn't need to look at all after commands. Each
+	// bucket is sorted on creation order (id).
+	AfterCmds eventCmds[NUM_EVENT_TYPES];
+	// All other after commands.
 	AfterCmds afterCmds;
 	Reactor& reactor;
 	EventDistributor& eventDistributor;
@@ -0,0 +1,145 @@
+#include "AsyncCommand.hh"
+#include "CliComm.hh"
+#include "CommandController.hh"
+#include "CommandException.hh"
+#include "Event.hh"
+#include "EventDistributor.hh"
+#include "Interpreter.hh"
+
+using std::string;
+using std::vector;
+
+namespace openmsx {
+
+AsyncCommand::AsyncCommand(CommandController& commandController_,
+                           EventDistributor& eventDistributor_)
+	: Command(commandController_, "async")
+	, eventDistributor(eventDistributor_)
+{
+	eventDistributor.registerEventListener(OPENMSX_ASYNC_RESULT_EVENT, *this);
+}
+
+AsyncCommand::~AsyncCommand()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		exitLoop = true;
+		jobs.clear();
+#if (TCL_MAJOR_VERSION > 8) || ((TCL_MAJOR_VERSION == 8) && (TCL_MINOR_VERSION >= 6))
+		// Don't wait for a (possibly endless) script to finish.
+		if (workerInterp) {
+			Tcl_CancelEval(workerInterp, nullptr, nullptr, TCL_CANCEL_UNWIND);
+		}
+#endif
+	}
+	jobCond.notify_one();
+	if (thread.joinable()) thread.join();
+	eventDistributor.unregisterEventListener(OPENMSX_ASYNC_RESULT_EVENT, *this);
+}
+
+void AsyncCommand::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{2, 3}, "script ?command?");
+	unsigned id = ++lastId;
+	if (tokens.size() == 3) {
+		callbacks[id] = tokens[2];
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// Tcl objects can't be shared between threads, pass a string.
+		jobs.push_back(Job{id, tokens[1].getString().str()});
+	}
+	if (!thread.joinable()) {
+		thread = std::thread([this] { run(); });
+	}
+	jobCond.notify_one();
+	result = int(id);
+}
+
+void AsyncCommand::run()
+{
+	// A Tcl interpreter may only be used by the thread that created it.
+	Tcl_Interp* interp = Tcl_CreateInterp();
+	Tcl_Init(interp); // ignore errors, only needed for the script library
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		workerInterp = interp;
+	}
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobCond.wait(lock, [&] { return exitLoop || !jobs.empty(); });
+			if (exitLoop) break;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		int code = Tcl_EvalEx(interp, job.script.data(), int(job.script.size()),
+		                      TCL_EVAL_GLOBAL);
+		Result r{job.id, code == TCL_OK, Tcl_GetStringResult(interp)};
+		Tcl_ResetResult(interp);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			results.push_back(std::move(r));
+		}
+		eventDistributor.distributeEvent(
+			std::make_shared<SimpleEvent>(OPENMSX_ASYNC_RESULT_EVENT));
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		workerInterp = nullptr;
+	}
+	Tcl_DeleteInterp(interp);
+	Tcl_FinalizeThread();
+}
+
+int AsyncCommand::signalEvent(const std::shared_ptr<const Event>& /*event*/)
+{
+	std::deque<Result> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::swap(finished, results);
+	}
+	auto& cliComm = getCommandController().getCliComm();
+	for (auto& r : finished) {
+		auto it = callbacks.find(r.id);
+		if (it == end(callbacks)) {
+			if (!r.ok) {
+				cliComm.printWarning("Error in async script: ", r.value);
+			}
+			continue;
+		}
+		TclObject command = std::move(it->second);
+		callbacks.erase(it);
+		command.addListElement(r.ok ? "ok" : "error", r.value);
+		try {
+			getInterpreter().executeProfiled(command, false, "async");
+		} catch (CommandException& e) {
+			cliComm.printWarning("Error in async callback: ", e.getMessage());
+		}
+	}
+	return 0;
+}
+
+string AsyncCommand::help(const vector<string>& /*tokens*/) const
+{
+	return "async <script> ?<command>?\n"
+	       "Execute <script> on a background thread and return a job ID. "
+	       "This is meant for slow work that doesn't need the MSX machine, "
+	       "like generating data or writing files, so that it doesn't "
+	       "disturb the emulation.\n"
+	       "The scripts run one after the other in a separate Tcl "
+	       "interpreter, which has only the standard Tcl commands (no "
+	       "openMSX commands) and which keeps its variables and procs "
+	       "between jobs. So pass all needed data in the script itself "
+	       "(e.g. with 'list').\n"
+	       "When the script is done, <command> is executed with two extra "
+	       "arguments: 'ok' or 'error' and the result of the script.\n"
+	       "Example:\n"
+	       "  async [list apply {{name data} {\n"
+	       "      set f [open $name w]; fconfigure $f -translation binary\n"
+	       "      puts -nonewline $f $data; close $f}} vram.raw [debug read_block VRAM 0 0x20000]] \\\n"
+	       "      {apply {{status result} {puts \"done: $status $result\"}}}\n";
+}
+
+} // namespace openmsx
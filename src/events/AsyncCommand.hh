@@ -0,0 +1,73 @@
+#ifndef ASYNCCOMMAND_HH
+#define ASYNCCOMMAND_HH
+
+#include "Command.hh"
+#include "EventListener.hh"
+#include "TclObject.hh"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tcl.h>
+
+namespace openmsx {
+
+class CommandController;
+class EventDistributor;
+
+/** Runs Tcl scripts on a background thread, so that slow work that doesn't
+  * need the machine state (generating data, writing files, ...) doesn't
+  * stall the emulation.
+  *
+  * The scripts run (one at a time and in order) in a separate plain Tcl
+  * interpreter that lives on the worker thread. It has none of the openMSX
+  * commands and it keeps its state (variables, procs) between jobs. The
+  * result of a job is passed back to the main thread via an event, where
+  * the optional callback command is executed.
+  */
+class AsyncCommand final : public Command, private EventListener
+{
+public:
+	AsyncCommand(CommandController& commandController,
+	             EventDistributor& eventDistributor);
+	~AsyncCommand();
+
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	std::string help(const std::vector<std::string>& tokens) const override;
+
+private:
+	struct Job {
+		unsigned id;
+		std::string script;
+	};
+	struct Result {
+		unsigned id;
+		bool ok;
+		std::string value;
+	};
+
+	void run();
+
+	// EventListener
+	int signalEvent(const std::shared_ptr<const Event>& event) override;
+
+	EventDistributor& eventDistributor;
+
+	// only accessed by the main thread
+	std::map<unsigned, TclObject> callbacks;
+	unsigned lastId = 0;
+
+	std::thread thread; // started on the first job
+	std::mutex mutex;
+	std::condition_variable jobCond;
+	std::deque<Job> jobs;       // protected by 'mutex'
+	std::deque<Result> results; // protected by 'mutex'
+	Tcl_Interp* workerInterp = nullptr; // protected by 'mutex'
+	bool exitLoop = false;              // protected by 'mutex'
+};
+
+} // namespace openmsx
+
+#endif
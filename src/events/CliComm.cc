@@ -8,7 +8,8 @@ const char* const CliComm::levelStr[CliComm::NUM_LEVELS] = {
 
 const char* const CliComm::updateStr[CliComm::NUM_UPDATES] = {
 	"led", "setting", "setting-info", "hardware", "plug",
-	"media", "status", "extension", "sounddevice", "connector"
+	"media", "status", "extension", "sounddevice", "connector",
+	"speed", "reverse", "debuggable", "profile"
 };
 
 
@@ -28,6 +28,10 @@ public:
 		EXTENSION,
 		SOUNDDEVICE,
 		CONNECTOR,
+		SPEED,      // measured rendering and emulation speed, once per second
+		REVERSE,    // reverse status, once per snapshot
+		DEBUGGABLE, // content changed, only for explicitly named debuggables
+		PROFILE,    // host time per frame, once per second
 		NUM_UPDATES // must be last
 	};
 
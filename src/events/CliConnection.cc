@@ -6,23 +6,37 @@
 // - Unsubscribe at CliComm after stream is closed.
 
 #include "CliConnection.hh"
+#include "CliServer.hh"
 #include "EventDistributor.hh"
 #include "Event.hh"
-#include "CommandController.hh"
+#include "FinishFrameEvent.hh"
+#include "GlobalCommandController.hh"
 #include "CommandException.hh"
+#include "Debugger.hh"
+#include "Debuggable.hh"
+#include "MSXMotherBoard.hh"
+#include "Reactor.hh"
+#include "Base64.hh"
 #include "TclObject.hh"
+#include "Timer.hh"
 #include "XMLElement.hh"
+#include "endian.hh"
 #include "checked_cast.hh"
 #include "cstdiop.hh"
 #include "openmsx.hh"
 #include "ranges.hh"
 #include "unistdp.hh"
+#include "xrange.hh"
+#include "xxhash.hh"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
 #ifdef _WIN32
 #include "SocketStreamWrapper.hh"
 #include "SspiNegotiateServer.hh"
+#else
+#include <poll.h>
 #endif
 
 using std::string;
@@ -34,14 +48,14 @@ namespace openmsx {
 class CliCommandEvent final : public Event
 {
 public:
-	CliCommandEvent(string command_, const CliConnection* id_)
+	CliCommandEvent(std::vector<string> commands_, const CliConnection* id_)
 		: Event(OPENMSX_CLICOMMAND_EVENT)
-		, command(std::move(command_)), id(id_)
+		, commands(std::move(commands_)), id(id_)
 	{
 	}
-	const string& getCommand() const
+	const std::vector<string>& getCommands() const
 	{
-		return command;
+		return commands;
 	}
 	const CliConnection* getId() const
 	{
@@ -49,15 +63,17 @@ public:
 	}
 	TclObject toTclList() const override
 	{
-		return makeTclList("CliCmd", getCommand());
+		TclObject result = makeTclList("CliCmd");
+		result.addListElements(commands);
+		return result;
 	}
 	bool lessImpl(const Event& other) const override
 	{
 		auto& otherCmdEvent = checked_cast<const CliCommandEvent&>(other);
-		return getCommand() < otherCmdEvent.getCommand();
+		return getCommands() < otherCmdEvent.getCommands();
 	}
 private:
-	const string command;
+	const std::vector<string> commands;
 	const CliConnection* id;
 };
 
@@ -66,23 +82,48 @@ private:
 
 CliConnection::CliConnection(CommandController& commandController_,
                              EventDistributor& eventDistributor_)
-	: parser([this](const std::string& cmd) { execute(cmd); })
-	, commandController(commandController_)
+	: commandController(commandController_)
 	, eventDistributor(eventDistributor_)
+	, parser([this](const std::string& cmd) { execute(cmd); })
 {
 	ranges::fill(updateEnabled, false);
 
 	eventDistributor.registerEventListener(OPENMSX_CLICOMMAND_EVENT, *this);
+	eventDistributor.registerEventListener(OPENMSX_FINISH_FRAME_EVENT, *this);
 }
 
 CliConnection::~CliConnection()
 {
+	eventDistributor.unregisterEventListener(OPENMSX_FINISH_FRAME_EVENT, *this);
 	eventDistributor.unregisterEventListener(OPENMSX_CLICOMMAND_EVENT, *this);
 }
 
+// A message in the binary protocol: a 4 byte little endian length, 1 byte
+// kind and the payload. Parts of the payload are separated by a '\0'.
+static void appendFrameHeader(string& out, char kind, size_t size)
+{
+	uint8_t header[AdhocCliCommParser::FRAME_HEADER_SIZE];
+	Endian::write_UA_L32(header, uint32_t(size));
+	header[4] = kind;
+	out.append(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+static string frame(char kind, string_view payload)
+{
+	string result;
+	result.reserve(AdhocCliCommParser::FRAME_HEADER_SIZE + payload.size());
+	appendFrameHeader(result, kind, payload.size());
+	result.append(payload.data(), payload.size());
+	return result;
+}
+
 void CliConnection::log(CliComm::LogLevel level, string_view message)
 {
 	auto levelStr = CliComm::getLevelStrings();
+	if (protocol == BINARY) {
+		output(frame('L', strCat(levelStr[level], '\0', message)));
+		return;
+	}
 	output(strCat("<log level=\"", levelStr[level], "\">",
 	              XMLElement::XMLEscape(message.str()), "</log>\n"));
 }
@@ -91,8 +132,20 @@ void CliConnection::update(CliComm::UpdateType type, string_view machine,
                               string_view name, string_view value)
 {
 	if (!getUpdateEnable(type)) return;
+	auto& filters = updateFilters[type];
+	if ((type != CliComm::DEBUGGABLE) && !filters.empty() &&
+	    ranges::none_of(filters, [&](auto& f) {
+		    return Tcl_StringMatch(name.str().c_str(), f.c_str());
+	    })) {
+		return;
+	}
 
 	auto updateStr = CliComm::getUpdateStrings();
+	if (protocol == BINARY) {
+		output(frame('U', strCat(updateStr[type], '\0', machine, '\0',
+		                         name, '\0', value)));
+		return;
+	}
 	string tmp = strCat("<update type=\"", updateStr[type], '\"');
 	if (!machine.empty()) {
 		strAppend(tmp, " machine=\"", machine, '\"');
@@ -117,7 +170,7 @@ void CliConnection::start()
 
 void CliConnection::end()
 {
-	output("</openmsx-output>\n");
+	if (protocol == XML) output("</openmsx-output>\n");
 	close();
 
 	poller.abort();
@@ -127,29 +180,142 @@ void CliConnection::end()
 	}
 }
 
-void CliConnection::execute(const string& command)
+void CliConnection::processInput(const char* buf, size_t n)
 {
+	// A client must wait for the reply on a protocol switch before it
+	// sends commands in the new protocol.
+	parser.setBinary(binaryInput);
+	parser.parse(buf, n);
+	if (pendingCommands.empty()) return;
 	eventDistributor.distributeEvent(
-		std::make_shared<CliCommandEvent>(command, this));
+		std::make_shared<CliCommandEvent>(std::move(pendingCommands), this));
+	pendingCommands.clear();
 }
 
-static string reply(const string& message, bool status)
+void CliConnection::execute(const string& command)
+{
+	// collect, see processInput()
+	pendingCommands.push_back(command);
+}
+
+static string reply(const string& message, bool status,
+                    CliConnection::Protocol protocol)
 {
+	if (protocol == CliConnection::BINARY) {
+		return frame(status ? 'O' : 'E', message);
+	}
 	return strCat("<reply result=\"", (status ? "ok" : "nok"), "\">",
 	              XMLElement::XMLEscape(message), "</reply>\n");
 }
 
+void CliConnection::sendDebugStreams()
+{
+	// The data is base64 encoded (in the XML protocol), that's much cheaper
+	// than converting it to a Tcl object and XML-escaping the result, and
+	// it keeps the output a valid XML stream.
+	auto& controller = checked_cast<GlobalCommandController&>(commandController);
+	auto* motherBoard = controller.getReactor().getMotherBoard();
+	if (!motherBoard) return;
+	auto& debugger = motherBoard->getDebugger();
+
+	string message;
+	for (auto& s : debugStreams) {
+		auto* debuggable = debugger.findDebuggable(s.debuggable);
+		if (!debuggable) continue;
+		unsigned devSize = debuggable->getSize();
+		if (s.address >= devSize) continue;
+		unsigned num = std::min(s.size, devSize - s.address);
+		if (num > debugBufferSize) {
+			debugBuffer.resize(num);
+			debugBufferSize = num;
+		}
+		debuggable->readBlock(s.address, debugBuffer.data(), num);
+		if (protocol == BINARY) {
+			// Raw data, no base64 needed.
+			appendFrameHeader(message, 'D', s.debuggable.size() + 1 + 4 + num);
+			strAppend(message, s.debuggable, '\0');
+			uint8_t address[4];
+			Endian::write_UA_L32(address, s.address);
+			message.append(reinterpret_cast<const char*>(address), 4);
+			message.append(reinterpret_cast<const char*>(debugBuffer.data()), num);
+			continue;
+		}
+		strAppend(message,
+		          "<debug name=\"", XMLElement::XMLEscape(s.debuggable),
+		          "\" address=\"", s.address,
+		          "\" size=\"", num, "\">",
+		          Base64::encode(debugBuffer.data(), num),
+		          "</debug>\n");
+	}
+	if (!message.empty()) output(message);
+}
+
+void CliConnection::checkDebuggables()
+{
+	// Polling the debuggables ourself is much cheaper than the client
+	// doing it over the connection. But don't do it every frame.
+	auto now = Timer::getTime();
+	if ((now - lastDebuggableCheck) < 100000) return; // max 10 times per second
+	lastDebuggableCheck = now;
+
+	auto& controller = checked_cast<GlobalCommandController&>(commandController);
+	auto* motherBoard = controller.getReactor().getMotherBoard();
+	if (!motherBoard) return;
+	auto& debugger = motherBoard->getDebugger();
+
+	auto& names = updateFilters[CliComm::DEBUGGABLE];
+	debuggableHashes.resize(names.size()); // new entries are not yet known
+	for (auto i : xrange(names.size())) {
+		auto* debuggable = debugger.findDebuggable(names[i]);
+		if (!debuggable) continue;
+		unsigned num = debuggable->getSize();
+		if (num > debugBufferSize) {
+			debugBuffer.resize(num);
+			debugBufferSize = num;
+		}
+		debuggable->readBlock(0, debugBuffer.data(), num);
+		uint32_t hash = xxhash(string_view(
+			reinterpret_cast<const char*>(debugBuffer.data()), num));
+		auto& prev = debuggableHashes[i];
+		bool changed = prev && (*prev != hash);
+		prev = hash;
+		if (changed) {
+			update(CliComm::DEBUGGABLE, motherBoard->getMachineID(),
+			       names[i], "changed");
+		}
+	}
+}
+
 int CliConnection::signalEvent(const std::shared_ptr<const Event>& event)
 {
+	if (event->getType() == OPENMSX_FINISH_FRAME_EVENT) {
+		// Only once per frame, also when multiple video sources
+		// are active.
+		auto& ffe = checked_cast<const FinishFrameEvent&>(*event);
+		if (ffe.getSource() != ffe.getSelectedSource()) return 0;
+		if (!debugStreams.empty()) {
+			sendDebugStreams();
+		}
+		if (updateEnabled[CliComm::DEBUGGABLE] &&
+		    !updateFilters[CliComm::DEBUGGABLE].empty()) {
+			checkDebuggables();
+		}
+		return 0;
+	}
 	auto& commandEvent = checked_cast<const CliCommandEvent&>(*event);
-	if (commandEvent.getId() == this) {
+	if (commandEvent.getId() != this) return 0;
+	for (auto& command : commandEvent.getCommands()) {
 		try {
 			string result = commandController.executeCommand(
-				commandEvent.getCommand(), this).getString().str();
-			output(reply(result, true));
+				command, this).getString().str();
+			output(reply(result, true, protocol));
 		} catch (CommandException& e) {
 			string result = std::move(e).getMessage() + '\n';
-			output(reply(result, false));
+			output(reply(result, false, protocol));
+		}
+		if (protocol != nextProtocol) {
+			protocol = nextProtocol;
+			binaryInput = (protocol == BINARY);
 		}
 	}
 	return 0;
@@ -183,7 +349,7 @@ void StdioConnection::run()
 		char buf[BUF_SIZE];
 		int n = read(STDIN_FILENO, buf, sizeof(buf));
 		if (n > 0) {
-			parser.parse(buf, n);
+			processInput(buf, n);
 		} else if (n < 0) {
 			break;
 		}
@@ -273,7 +439,7 @@ void PipeConnection::run()
 			if (!GetOverlappedResult(pipeHandle, &overlapped, &bytesRead, TRUE)) {
 				break; // Pipe broke
 			}
-			parser.parse(buf, bytesRead);
+			processInput(buf, bytesRead);
 		} else if (wait == WAIT_OBJECT_0) {
 			break; // Shutdown
 		} else {
@@ -307,21 +473,39 @@ void PipeConnection::close()
 
 SocketConnection::SocketConnection(CommandController& commandController_,
                                    EventDistributor& eventDistributor_,
-                                   SOCKET sd_)
+                                   SOCKET sd_, CliServer& server_)
 	: CliConnection(commandController_, eventDistributor_)
-	, sd(sd_), established(false)
+	, sd(sd_)
+#ifdef _WIN32
+	, established(false)
+#else
+	, server(&server_)
+#endif
 {
+#ifdef _WIN32
+	(void)server_;
+#endif
 }
 
 SocketConnection::~SocketConnection()
 {
+#ifndef _WIN32
+	// After this the I/O thread no longer touches this connection.
+	CliServer* s;
+	{
+		std::lock_guard<std::mutex> lock(sdMutex);
+		s = server;
+		server = nullptr;
+	}
+	if (s) s->removeConnection(*this);
+#endif
 	end();
 }
 
+#ifdef _WIN32
 void SocketConnection::run()
 {
 	// runs in helper thread
-#ifdef _WIN32
 	bool ok;
 	{
 		std::lock_guard<std::mutex> lock(sdMutex);
@@ -334,7 +518,6 @@ void SocketConnection::run()
 		closeSocket();
 		return;
 	}
-#endif
 	// Start output element
 	established = true; // TODO needs locking?
 	startOutput();
@@ -344,15 +527,10 @@ void SocketConnection::run()
 	// and 'sd' only gets written to in this thread.
 	while (true) {
 		if (sd == OPENMSX_INVALID_SOCKET) return;
-#ifndef _WIN32
-		if (poller.poll(sd)) {
-			break;
-		}
-#endif
 		char buf[BUF_SIZE];
 		int n = sock_recv(sd, buf, BUF_SIZE);
 		if (n > 0) {
-			parser.parse(buf, n);
+			processInput(buf, n);
 		} else if (n < 0) {
 			break;
 		}
@@ -382,28 +560,151 @@ void SocketConnection::output(string_view message)
 			pos += bytesSend;
 		} else {
 			// Note: On Windows we rely on closing the socket to
-			//       wake up the worker thread, on other platforms
-			//       we rely on Poller.
+			//       wake up the worker thread.
 			closeSocket();
-			poller.abort();
 			break;
 		}
 	}
 }
 
-void SocketConnection::closeSocket()
+void SocketConnection::close()
+{
+	closeSocket();
+}
+
+#else // _WIN32
+
+// A client that doesn't read its output (fast enough) is disconnected,
+// instead of buffering an unbounded amount of data.
+static const size_t MAX_PENDING_OUTPUT = 64 * 1024 * 1024;
+
+void SocketConnection::start()
+{
+	{
+		std::lock_guard<std::mutex> lock(sdMutex);
+		started = true;
+	}
+	// This also wakes up the I/O thread, so that it starts polling
+	// this connection.
+	startOutput();
+}
+
+void SocketConnection::output(string_view message)
 {
 	std::lock_guard<std::mutex> lock(sdMutex);
-	if (sd != OPENMSX_INVALID_SOCKET) {
+	if (!started || (sd == OPENMSX_INVALID_SOCKET)) {
+		// The opening tag is not yet sent. Ignore log and update
+		// messages for now.
+		return;
+	}
+	if (outPos == outBuffer.size()) {
+		outBuffer.clear();
+		outPos = 0;
+	}
+	if ((outBuffer.size() - outPos + message.size()) > MAX_PENDING_OUTPUT) {
 		SOCKET _sd = sd;
 		sd = OPENMSX_INVALID_SOCKET;
 		sock_close(_sd);
+		if (server) server->wakeUp();
+		return;
+	}
+	bool wasEmpty = outBuffer.empty();
+	outBuffer.append(message.data(), message.size());
+	// Many messages can be produced before the I/O thread runs again,
+	// they are all sent at once.
+	if (wasEmpty && server) server->wakeUp();
+}
+
+bool SocketConnection::getPollFd(pollfd& pfd)
+{
+	std::lock_guard<std::mutex> lock(sdMutex);
+	if (!started || (sd == OPENMSX_INVALID_SOCKET)) return false;
+	pfd.fd = sd;
+	pfd.events = POLLIN;
+	if (outPos != outBuffer.size()) pfd.events |= POLLOUT;
+	pfd.revents = 0;
+	return true;
+}
+
+bool SocketConnection::sendPending()
+{
+	// sdMutex must be locked
+	while (outPos != outBuffer.size()) {
+		int n = sock_send(sd, &outBuffer[outPos], outBuffer.size() - outPos);
+		if (n < 0) return false;
+		if (n == 0) break; // would block
+		outPos += n;
 	}
+	return true;
+}
+
+bool SocketConnection::handleEvents(short revents)
+{
+	if (revents & POLLOUT) {
+		std::lock_guard<std::mutex> lock(sdMutex);
+		if (sd == OPENMSX_INVALID_SOCKET) return false;
+		if (!sendPending()) {
+			SOCKET _sd = sd;
+			sd = OPENMSX_INVALID_SOCKET;
+			sock_close(_sd);
+			return false;
+		}
+	}
+	if (revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) {
+		// Read all available input, so that the commands in it are
+		// executed (by the main thread) in a single batch.
+		string input;
+		while (true) {
+			char buf[BUF_SIZE];
+			int n;
+			{
+				std::lock_guard<std::mutex> lock(sdMutex);
+				if (sd == OPENMSX_INVALID_SOCKET) return false;
+				n = sock_recv(sd, buf, BUF_SIZE);
+			}
+			if (n > 0) {
+				input.append(buf, n);
+				if (n < BUF_SIZE) break;
+			} else if (n == 0) {
+				break; // would block
+			} else {
+				if (!input.empty()) processInput(input.data(), input.size());
+				closeSocket();
+				return false;
+			}
+		}
+		if (!input.empty()) processInput(input.data(), input.size());
+	}
+	return true;
+}
+
+void SocketConnection::detach()
+{
+	std::lock_guard<std::mutex> lock(sdMutex);
+	server = nullptr;
 }
 
 void SocketConnection::close()
 {
+	{
+		// Best effort to send the remaining output (e.g. the closing
+		// tag), without blocking.
+		std::lock_guard<std::mutex> lock(sdMutex);
+		if (sd != OPENMSX_INVALID_SOCKET) sendPending();
+	}
 	closeSocket();
 }
 
+#endif // _WIN32
+
+void SocketConnection::closeSocket()
+{
+	std::lock_guard<std::mutex> lock(sdMutex);
+	if (sd != OPENMSX_INVALID_SOCKET) {
+		SOCKET _sd = sd;
+		sd = OPENMSX_INVALID_SOCKET;
+		sock_close(_sd);
+	}
+}
+
 } // namespace openmsx
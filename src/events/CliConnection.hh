@@ -7,31 +7,75 @@
 #include "CliComm.hh"
 #include "AdhocCliCommParser.hh"
 #include "Poller.hh"
+#include "MemBuffer.hh"
+#include "openmsx.hh"
+#include "optional.hh"
+#include <atomic>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace openmsx {
 
+class CliServer;
 class CommandController;
 class EventDistributor;
 
 class CliConnection : public CliListener, private EventListener
 {
 public:
+	/** Enabling or disabling an update type also removes its filters. */
 	void setUpdateEnable(CliComm::UpdateType type, bool value) {
 		updateEnabled[type] = value;
+		updateFilters[type].clear();
+		if (type == CliComm::DEBUGGABLE) debuggableHashes.clear();
 	}
 	bool getUpdateEnable(CliComm::UpdateType type) const {
 		return updateEnabled[type];
 	}
+	/** Only send the updates of the given type whose name matches one of
+	  * the filters (glob patterns). Without filters all updates of an
+	  * enabled type are sent. For DEBUGGABLE updates the filters are the
+	  * (exact) names of the debuggables to watch, without filters nothing
+	  * is watched.
+	  */
+	void addUpdateFilter(CliComm::UpdateType type, std::string filter) {
+		updateFilters[type].push_back(std::move(filter));
+	}
+	const std::vector<std::string>& getUpdateFilters(CliComm::UpdateType type) const {
+		return updateFilters[type];
+	}
+
+	/** A range of a debuggable whose content is sent to this connection
+	  * after every emulated frame (see the 'openmsx_debug_stream'
+	  * command). The range is clipped to the size of the debuggable.
+	  */
+	struct DebugStream {
+		std::string debuggable;
+		unsigned address;
+		unsigned size;
+	};
+	std::vector<DebugStream>& getDebugStreams() { return debugStreams; }
+
+	/** The framing of the messages on this connection, see
+	  * doc/manual/openmsx-control.html. XML is the default, the binary
+	  * protocol is cheaper for applications that send many commands.
+	  */
+	enum Protocol { XML, BINARY };
+	Protocol getProtocol() const { return nextProtocol; }
+	/** Switch the protocol (in both directions). This takes effect after
+	  * the reply of the command that is currently executing, so that reply
+	  * still uses the old protocol.
+	  */
+	void setProtocol(Protocol protocol_) { nextProtocol = protocol_; }
 
-	/** Starts the helper thread.
+	/** Starts the helper thread (see run()).
 	  * Called when this CliConnection is added to GlobalCliComm (and
 	  * after it's allowed to respond to external commands).
 	  * Subclasses should themself send the opening tag (startOutput()).
 	  */
-	void start();
+	virtual void start();
 
 protected:
 	CliConnection(CommandController& commandController,
@@ -58,13 +102,23 @@ protected:
 	  */
 	void startOutput();
 
-	AdhocCliCommParser parser;
+	/** Parse a chunk of input. All commands that are completed by this
+	  * chunk are sent to the main thread at once (in a single event), the
+	  * replies are sent in the order of the commands.
+	  */
+	void processInput(const char* buf, size_t n);
+
 	Poller poller;
 
 private:
-	virtual void run() = 0;
+	/** Reads the input, runs in the helper thread that is started by
+	  * start(). Not needed for subclasses that override start().
+	  */
+	virtual void run() {}
 
 	void execute(const std::string& command);
+	void sendDebugStreams();
+	void checkDebuggables();
 
 	// CliListener
 	void log(CliComm::LogLevel level, string_view message) override;
@@ -77,9 +131,26 @@ private:
 	CommandController& commandController;
 	EventDistributor& eventDistributor;
 
+	AdhocCliCommParser parser;
+	std::vector<std::string> pendingCommands; // only used by processInput()
+
+	Protocol protocol = XML;
+	Protocol nextProtocol = XML;
+	std::atomic_bool binaryInput{false}; // read by processInput()
+
 	std::thread thread;
 
 	bool updateEnabled[CliComm::NUM_UPDATES];
+	std::vector<std::string> updateFilters[CliComm::NUM_UPDATES];
+
+	// Content hashes of the watched debuggables (DEBUGGABLE updates),
+	// same order as updateFilters[DEBUGGABLE].
+	std::vector<optional<uint32_t>> debuggableHashes;
+	uint64_t lastDebuggableCheck = 0;
+
+	std::vector<DebugStream> debugStreams;
+	MemBuffer<byte> debugBuffer;
+	unsigned debugBufferSize = 0;
 };
 
 class StdioConnection final : public CliConnection
@@ -116,24 +187,60 @@ private:
 };
 #endif
 
+/** A connection on the socket of CliServer.
+  * On Windows each connection has its own helper thread (the authentication
+  * is blocking). On other platforms all connections are served by the I/O
+  * thread of CliServer: output is buffered and sent by that thread, so the
+  * main thread never blocks on a slow client.
+  */
 class SocketConnection final : public CliConnection
 {
 public:
 	SocketConnection(CommandController& commandController,
 	                 EventDistributor& eventDistributor,
-	                 SOCKET sd);
+	                 SOCKET sd, CliServer& server);
 	~SocketConnection() override;
 
 	void output(string_view message) override;
 
+#ifndef _WIN32
+	void start() override;
+
+	// The following methods are called from the I/O thread of CliServer.
+
+	/** Fill in the file descriptor and the events to wait for. Returns
+	  * false if this connection shouldn't be polled (yet).
+	  */
+	bool getPollFd(pollfd& pfd);
+	/** Handle the events that were reported by poll(). Returns false
+	  * when the connection got closed, then it shouldn't be polled
+	  * anymore.
+	  */
+	bool handleEvents(short revents);
+	/** The server is being destroyed, it should no longer be notified. */
+	void detach();
+#endif
+
 private:
 	void close() override;
-	void run() override;
 	void closeSocket();
+#ifdef _WIN32
+	void run() override;
+#else
+	bool sendPending();
+#endif
 
 	std::mutex sdMutex;
 	SOCKET sd;
+#ifdef _WIN32
 	bool established;
+#else
+	// The members below are protected by 'sdMutex'.
+	CliServer* server; // nullptr after detach()
+	std::string outBuffer;
+	size_t outPos = 0; // outBuffer[0, outPos) is already sent
+	bool started = false;
+#endif
 };
 
 } // namespace openmsx
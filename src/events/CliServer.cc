@@ -4,7 +4,10 @@
 #include "FileOperations.hh"
 #include "MSXException.hh"
 #include "random.hh"
+#include "ranges.hh"
 #include "statp.hh"
+#include "stl.hh"
+#include "xrange.hh"
 #include <memory>
 #include <string>
 
@@ -13,6 +16,7 @@
 #include <ctime>
 #else
 #include <pwd.h>
+#include <poll.h>
 #include <unistd.h>
 #include <fcntl.h>
 #endif
@@ -217,27 +221,26 @@ CliServer::~CliServer()
 		exitAcceptLoop();
 		thread.join();
 	}
+#ifndef _WIN32
+	// The connections themselves live on (they're owned by GlobalCliComm),
+	// but they're no longer served.
+	for (auto* connection : connections) {
+		connection->detach();
+	}
+	connections.clear();
+#endif
 
 	deleteSocket(socketName);
 	sock_cleanup();
 }
 
+#ifdef _WIN32
 void CliServer::mainLoop()
 {
-#ifndef _WIN32
-	// Set socket to non-blocking to make sure accept() doesn't hang when
-	// a connection attempt is dropped between poll() and accept().
-	fcntl(listenSock, F_SETFL, O_NONBLOCK);
-#endif
 	while (true) {
 		// wait for incoming connection
 		// Note: On Windows, closing the socket is sufficient to exit the
 		//       accept() call.
-#ifndef _WIN32
-		if (poller.poll(listenSock)) {
-			break;
-		}
-#endif
 		SOCKET sd = accept(listenSock, nullptr, nullptr);
 		if (poller.aborted()) {
 			if (sd != OPENMSX_INVALID_SOCKET) {
@@ -252,14 +255,89 @@ void CliServer::mainLoop()
 				break;
 			}
 		}
-#ifndef _WIN32
-		// The BSD/OSX sockets implementation inherits O_NONBLOCK, while Linux
-		// does not. To be on the safe side, we explicitly reset file flags.
-		fcntl(sd, F_SETFL, 0);
-#endif
 		cliComm.addListener(std::make_unique<SocketConnection>(
-			commandController, eventDistributor, sd));
+			commandController, eventDistributor, sd, *this));
+	}
+}
+
+#else // _WIN32
+
+void CliServer::mainLoop()
+{
+	// Set socket to non-blocking to make sure accept() doesn't hang when
+	// a connection attempt is dropped between poll() and accept().
+	fcntl(listenSock, F_SETFL, O_NONBLOCK);
+
+	std::vector<pollfd> fds;
+	std::vector<SocketConnection*> polled; // fds[i + 1] <-> polled[i]
+	while (true) {
+		fds.clear();
+		polled.clear();
+		fds.push_back({ .fd = listenSock, .events = POLLIN, .revents = 0 });
+		{
+			std::lock_guard<std::mutex> lock(connectionsMutex);
+			for (auto* connection : connections) {
+				pollfd pfd;
+				if (connection->getPollFd(pfd)) {
+					fds.push_back(pfd);
+					polled.push_back(connection);
+				}
+			}
+		}
+		if (poller.poll(fds.data(), unsigned(fds.size()))) {
+			break;
+		}
+		{
+			std::lock_guard<std::mutex> lock(connectionsMutex);
+			for (auto i : xrange(polled.size())) {
+				short revents = fds[i + 1].revents;
+				if (!revents) continue;
+				// The connection may have been removed in the mean time.
+				auto it = ranges::find(connections, polled[i]);
+				if (it == end(connections)) continue;
+				if (!(*it)->handleEvents(revents)) {
+					move_pop_back(connections, it);
+				}
+			}
+		}
+		if (fds[0].revents) {
+			acceptConnection();
+		}
 	}
 }
 
+void CliServer::acceptConnection()
+{
+	SOCKET sd = accept(listenSock, nullptr, nullptr);
+	if (sd == OPENMSX_INVALID_SOCKET) {
+		// e.g. EAGAIN, the connection attempt was dropped
+		return;
+	}
+	// The BSD/OSX sockets implementation inherits O_NONBLOCK, while Linux
+	// does not. To be on the safe side, we explicitly set file flags. All
+	// I/O for this connection is done from this thread, so it should never
+	// block.
+	fcntl(sd, F_SETFL, O_NONBLOCK);
+	auto connection = std::make_unique<SocketConnection>(
+		commandController, eventDistributor, sd, *this);
+	{
+		std::lock_guard<std::mutex> lock(connectionsMutex);
+		connections.push_back(connection.get());
+	}
+	// Not while holding 'connectionsMutex', this may start() the
+	// connection, which wakes us up.
+	cliComm.addListener(std::move(connection));
+}
+
+void CliServer::removeConnection(SocketConnection& connection)
+{
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+	auto it = ranges::find(connections, &connection);
+	if (it != end(connections)) {
+		move_pop_back(connections, it);
+	}
+}
+
+#endif // _WIN32
+
 } // namespace openmsx
@@ -3,15 +3,23 @@
 
 #include "Poller.hh"
 #include "Socket.hh"
+#include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace openmsx {
 
 class CommandController;
 class EventDistributor;
 class GlobalCliComm;
+class SocketConnection;
 
+/** Accepts connections on the openMSX socket.
+  * On Windows every connection gets its own thread. On other platforms a
+  * single I/O thread accepts the connections and also does all reading and
+  * writing for them (see SocketConnection).
+  */
 class CliServer final
 {
 public:
@@ -20,10 +28,25 @@ public:
 	          GlobalCliComm& cliComm);
 	~CliServer();
 
+#ifndef _WIN32
+	/** Wake up the I/O thread, e.g. because there's new output for one of
+	  * the connections. Can be called from any thread.
+	  */
+	void wakeUp() { poller.wakeUp(); }
+
+	/** Stop serving the given connection, called when it's destroyed.
+	  * When this method returns the I/O thread no longer accesses it.
+	  */
+	void removeConnection(SocketConnection& connection);
+#endif
+
 private:
 	void mainLoop();
 	SOCKET createSocket();
 	void exitAcceptLoop();
+#ifndef _WIN32
+	void acceptConnection();
+#endif
 
 	CommandController& commandController;
 	EventDistributor& eventDistributor;
@@ -33,6 +56,11 @@ private:
 	std::string socketName;
 	SOCKET listenSock;
 	Poller poller;
+
+#ifndef _WIN32
+	std::mutex connectionsMutex;
+	std::vector<SocketConnection*> connections; // protected by connectionsMutex
+#endif
 };
 
 } // namespace openmsx
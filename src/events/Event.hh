@@ -74,6 +74,19 @@ enum EventType
 	OPENMSX_MIDI_IN_COREMIDI_EVENT,
 	OPENMSX_MIDI_IN_COREMIDI_VIRTUAL_EVENT,
 	OPENMSX_RS232_TESTER_EVENT,
+	OPENMSX_RS232_NET_EVENT,
+
+	/** Sent by Netplay when packets from the peer arrived. */
+	OPENMSX_NETPLAY_EVENT,
+
+	/** Sent by AsyncCommand when a background script has finished. */
+	OPENMSX_ASYNC_RESULT_EVENT,
+
+	/** Sent by ScreenShotWriter when a screenshot has been written. */
+	OPENMSX_SCREENSHOT_DONE_EVENT,
+
+	/** Sent by ImagePrinter when a page has been written. */
+	OPENMSX_PRINT_DONE_EVENT,
 
 	NUM_EVENT_TYPES // must be last
 };
@@ -8,6 +8,8 @@
 #include "ranges.hh"
 #include "stl.hh"
 #include "view.hh"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 
@@ -17,7 +19,10 @@ namespace openmsx {
 
 EventDistributor::EventDistributor(Reactor& reactor_)
 	: reactor(reactor_)
+	, overflowing(false)
+	, waitingForSDL(false)
 {
+	for (auto& n : numListeners) n = 0;
 }
 
 void EventDistributor::registerEventListener(
@@ -30,6 +35,7 @@ void EventDistributor::registerEventListener(
 	// insert at highest position that keeps listeners sorted on priority
 	auto it = ranges::upper_bound(priorityMap, priority, LessTupleElement<0>());
 	priorityMap.insert(it, {priority, &listener});
+	++numListeners[type];
 }
 
 void EventDistributor::unregisterEventListener(
@@ -39,6 +45,7 @@ void EventDistributor::unregisterEventListener(
 	auto& priorityMap = listeners[type];
 	priorityMap.erase(rfind_if_unguarded(priorityMap,
 		[&](PriorityMap::value_type v) { return v.second == &listener; }));
+	--numListeners[type];
 }
 
 void EventDistributor::distributeEvent(const EventPtr& event)
@@ -50,18 +57,27 @@ void EventDistributor::distributeEvent(const EventPtr& event)
 	// TODO: Is it useful to test for 0 listeners or should we just always
 	//       queue the event?
 	assert(event);
-	std::unique_lock<std::mutex> lock(mutex);
-	if (!listeners[event->getType()].empty()) {
-		scheduledEvents.push_back(event);
-		// must release lock, otherwise there's a deadlock:
+	if (numListeners[event->getType()] == 0) return;
+
+	if (overflowing.load(std::memory_order_acquire) ||
+	    !scheduledEvents.push(event)) {
+		// Don't hold the lock while calling enterMainLoop(),
+		// otherwise there's a deadlock:
 		//   thread 1: Reactor::deleteMotherBoard()
 		//             EventDistributor::unregisterEventListener()
 		//   thread 2: EventDistributor::distributeEvent()
 		//             Reactor::enterMainLoop()
-		condition.notify_all();
-		lock.unlock();
-		reactor.enterMainLoop();
+		std::lock_guard<std::mutex> lock(mutex);
+		overflowEvents.push_back(event);
+		overflowing.store(true, std::memory_order_release);
+	}
+	condition.notify_all();
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waitingForSDL.exchange(false)) {
+		// Wake up the main thread, see waitForEvents().
+		InputEventGenerator::wakeUp();
 	}
+	reactor.enterMainLoop();
 }
 
 bool EventDistributor::isRegistered(EventType type, EventListener* listener) const
@@ -77,37 +93,50 @@ void EventDistributor::deliverEvents()
 	reactor.getInterpreter().poll();
 	reactor.getRTScheduler().execute();
 
-	std::unique_lock<std::mutex> lock(mutex);
 	// It's possible that executing an event triggers scheduling of another
 	// event. We also want to execute those secondary events. That's why
-	// we have this while loop here.
+	// we keep on taking events till the queue is empty.
 	// For example the 'loadstate' command event, triggers a machine switch
 	// event and as reaction to the latter event, AfterCommand will
 	// unsubscribe from the ols MSXEventDistributor. This really should be
 	// done before we exit this method.
-	while (!scheduledEvents.empty()) {
-		EventQueue eventsCopy;
-		swap(eventsCopy, scheduledEvents);
-
-		for (auto& event : eventsCopy) {
-			auto type = event->getType();
-			auto priorityMapCopy = listeners[type];
-			lock.unlock();
-			auto blockPriority = unsigned(-1); // allow all
-			for (auto& p : priorityMapCopy) {
-				// It's possible delivery to one of the previous
-				// Listeners unregistered the current Listener.
-				if (!isRegistered(type, p.second)) continue;
-
-				unsigned currentPriority = p.first;
-				if (currentPriority >= blockPriority) break;
-
-				if (unsigned block = p.second->signalEvent(event)) {
-					assert(block > currentPriority);
-					blockPriority = block;
-				}
-			}
-			lock.lock();
+	EventPtr event;
+	while (true) {
+		if (scheduledEvents.pop(event)) {
+			deliver(event);
+			continue;
+		}
+		if (!overflowing.load(std::memory_order_acquire)) break;
+		std::vector<EventPtr> eventsCopy;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			swap(eventsCopy, overflowEvents);
+			overflowing.store(false, std::memory_order_release);
+		}
+		for (auto& e : eventsCopy) {
+			deliver(e);
+		}
+	}
+}
+
+void EventDistributor::deliver(const EventPtr& event)
+{
+	auto type = event->getType();
+	std::unique_lock<std::mutex> lock(mutex);
+	auto priorityMapCopy = listeners[type];
+	lock.unlock();
+	auto blockPriority = unsigned(-1); // allow all
+	for (auto& p : priorityMapCopy) {
+		// It's possible delivery to one of the previous
+		// Listeners unregistered the current Listener.
+		if (!isRegistered(type, p.second)) continue;
+
+		unsigned currentPriority = p.first;
+		if (currentPriority >= blockPriority) break;
+
+		if (unsigned block = p.second->signalEvent(event)) {
+			assert(block > currentPriority);
+			blockPriority = block;
 		}
 	}
 }
@@ -119,4 +148,22 @@ bool EventDistributor::sleep(unsigned us)
 	return condition.wait_for(lock, duration) == std::cv_status::timeout;
 }
 
+void EventDistributor::waitForEvents(uint64_t us)
+{
+	assert(Thread::isMainThread());
+	if (!InputEventGenerator::canWait()) {
+		// Waiting for SDL events would be a busy loop (or there are
+		// no SDL events), so regularly poll for them.
+		sleep(unsigned(std::min<uint64_t>(us, 20 * 1000)));
+		return;
+	}
+	waitingForSDL = true;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (scheduledEvents.empty() &&
+	    !overflowing.load(std::memory_order_acquire)) {
+		reactor.getInputEventGenerator().wait(us);
+	}
+	waitingForSDL = false;
+}
+
 } // namespace openmsx
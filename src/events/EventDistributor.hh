@@ -2,6 +2,8 @@
 #define EVENTDISTRIBUTOR_HH
 
 #include "Event.hh"
+#include "MPSCQueue.hh"
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -50,6 +52,8 @@ public:
 	/** Schedule the given event for delivery. Actual delivery happens
 	  * when the deliverEvents() method is called. Events are always
 	  * in the main thread.
+	  * This can be called from any thread, it doesn't block (unless
+	  * the queue overflows).
 	  */
 	void distributeEvent(const EventPtr& event);
 
@@ -67,18 +71,36 @@ public:
 	  */
 	bool sleep(unsigned us);
 
+	/** Sleep till there's something to do: an SDL event (e.g. user
+	  * input or a window that must be redrawn), an event from another
+	  * thread (see distributeEvent()) or till the given amount of time
+	  * has passed. Must be called from the main thread.
+	  * @param us Maximum amount of time to sleep, in micro seconds.
+	  */
+	void waitForEvents(uint64_t us);
+
 private:
 	bool isRegistered(EventType type, EventListener* listener) const;
+	void deliver(const EventPtr& event);
 
 	Reactor& reactor;
 
 	using PriorityMap = std::vector<std::pair<Priority, EventListener*>>; // sorted on priority
 	PriorityMap listeners[NUM_EVENT_TYPES];
-	using EventQueue = std::vector<EventPtr>;
-	EventQueue scheduledEvents;
-	std::mutex mutex; // lock datastructures
+	// So that distributeEvent() can check for listeners without locking.
+	std::atomic<unsigned> numListeners[NUM_EVENT_TYPES];
+	// Events are normally queued without taking a lock. Only when the
+	// (lock-free) queue is full they go to the vector, and then all
+	// following events as well till the consumer emptied the vector (this
+	// keeps the events of each thread in order).
+	MPSCQueue<EventPtr, 1024> scheduledEvents;
+	std::vector<EventPtr> overflowEvents;
+	std::atomic<bool> overflowing;
+	std::mutex mutex; // lock listeners and overflowEvents
 	std::mutex cvMutex; // lock condition_variable
 	std::condition_variable condition;
+	// Set while the main thread waits for SDL events in waitForEvents()
+	std::atomic<bool> waitingForSDL;
 };
 
 } // namespace openmsx
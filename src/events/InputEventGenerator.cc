@@ -10,6 +10,8 @@
 #include "utf8_unchecked.hh"
 #include "build-info.hh"
 #include <cassert>
+#include <cstring>
+#include <limits>
 #include <memory>
 
 using std::string;
@@ -51,19 +53,35 @@ InputEventGenerator::~InputEventGenerator()
 	grabInput.detach(*this);
 }
 
-void InputEventGenerator::wait()
+void InputEventGenerator::wait(uint64_t us)
 {
-	// SDL bug workaround
-	if (!SDL_WasInit(SDL_INIT_VIDEO)) {
-		SDL_Delay(100);
-	}
+	assert(canWait());
+	// ms, round up (but -1 means no timeout)
+	int timeout = (us >= uint64_t(std::numeric_limits<int>::max()) * 1000)
+	            ? -1 : int((us + 999) / 1000);
+	SDL_WaitEventTimeout(nullptr, timeout);
+}
 
-	if (SDL_WaitEvent(nullptr)) {
-		poll();
-	}
+bool InputEventGenerator::canWait()
+{
+	// Before SDL 2.0.16, SDL_WaitEvent() was implemented as a loop that
+	// polls for events every millisecond.
+	if (!SDL_WasInit(SDL_INIT_VIDEO)) return false;
+	SDL_version version;
+	SDL_GetVersion(&version);
+	return SDL_VERSIONNUM(version.major, version.minor, version.patch) >=
+	       SDL_VERSIONNUM(2, 0, 16);
+}
+
+void InputEventGenerator::wakeUp()
+{
+	SDL_Event event;
+	memset(&event, 0, sizeof(event));
+	event.type = SDL_USEREVENT; // ignored by handle()
+	SDL_PushEvent(&event);
 }
 
-void InputEventGenerator::poll()
+bool InputEventGenerator::poll()
 {
 	// Heuristic to emulate the old SDL1 behavior:
 	//
@@ -98,8 +116,10 @@ void InputEventGenerator::poll()
 	auto* prev = &event1;
 	auto* curr = &event2;
 	bool pending = false;
+	bool any = false;
 
 	while (SDL_PollEvent(curr)) {
+		any = true;
 		if (pending) {
 			pending = false;
 			if ((prev->type == SDL_KEYDOWN) && (curr->type == SDL_TEXTINPUT)) {
@@ -124,6 +144,7 @@ void InputEventGenerator::poll()
 	if (pending) {
 		handle(*prev);
 	}
+	return any;
 }
 
 void InputEventGenerator::setKeyRepeat(bool enable)
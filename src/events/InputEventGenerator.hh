@@ -27,10 +27,19 @@ public:
 	                    GlobalSettings& globalSettings);
 	~InputEventGenerator();
 
-	/** Wait for event(s) and handle it.
+	/** Wait till there's an SDL event (or till the given time, in
+	  * micro seconds, has passed). The event is not handled yet, that's
+	  * done by the next poll().
 	  * This method should be called from the main thread.
 	  */
-	void wait();
+	void wait(uint64_t us);
+
+	/** Is wait() implemented without polling? */
+	static bool canWait();
+
+	/** Make a wait() that's in progress return, may be called from any
+	  * thread. */
+	static void wakeUp();
 
 	/**
 	 * Enable or disable keyboard event repeats
@@ -47,7 +56,10 @@ public:
 	static int joystickNumButtons(SDL_Joystick* joystick);
 	static bool joystickGetButton(SDL_Joystick* joystick, int button);
 
-	void poll();
+	/** Handle all pending SDL events.
+	  * @return Were there any events?
+	  */
+	bool poll();
 
 private:
 	using EventPtr = std::shared_ptr<const Event>;
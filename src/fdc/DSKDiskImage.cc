@@ -7,6 +7,7 @@ namespace openmsx {
 DSKDiskImage::DSKDiskImage(const Filename& fileName)
 	: SectorBasedDisk(fileName)
 	, file(std::make_shared<File>(fileName, File::PRE_CACHE))
+	, writeBack(*file)
 {
 	setNbSectors(file->getSize() / sizeof(SectorBuffer));
 }
@@ -15,20 +16,19 @@ DSKDiskImage::DSKDiskImage(const Filename& fileName,
                            std::shared_ptr<File> file_)
 	: SectorBasedDisk(fileName)
 	, file(std::move(file_))
+	, writeBack(*file)
 {
 	setNbSectors(file->getSize() / sizeof(SectorBuffer));
 }
 
 void DSKDiskImage::readSectorImpl(size_t sector, SectorBuffer& buf)
 {
-	file->seek(sector * sizeof(buf));
-	file->read(&buf, sizeof(buf));
+	writeBack.read(sector, buf);
 }
 
 void DSKDiskImage::writeSectorImpl(size_t sector, const SectorBuffer& buf)
 {
-	file->seek(sector * sizeof(buf));
-	file->write(&buf, sizeof(buf));
+	writeBack.write(sector, buf);
 }
 
 bool DSKDiskImage::isWriteProtectedImpl() const
@@ -41,6 +41,7 @@ Sha1Sum DSKDiskImage::getSha1SumImpl(FilePool& filePool)
 	if (hasPatches()) {
 		return SectorAccessibleDisk::getSha1SumImpl(filePool);
 	}
+	writeBack.flush();
 	return filePool.getSha1Sum(*file);
 }
 
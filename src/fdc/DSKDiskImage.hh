@@ -2,6 +2,7 @@
 #define DSKDISKIMAGE_HH
 
 #include "SectorBasedDisk.hh"
+#include "SectorWriteBack.hh"
 #include <memory>
 
 namespace openmsx {
@@ -21,6 +22,7 @@ private:
 	Sha1Sum getSha1SumImpl(FilePool& filepool) override;
 
 	const std::shared_ptr<File> file;
+	SectorWriteBack writeBack;
 };
 
 } // namespace openmsx
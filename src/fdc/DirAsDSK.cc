@@ -342,7 +342,7 @@ void DirAsDSK::checkCaches()
 		// Happens when dirasdisk is used in virtual_drive.
 		needSync = true;
 	}
-	if (needSync) {
+	if (needSync && anythingChanged()) {
 		flushCaches();
 	}
 }
@@ -366,7 +366,7 @@ void DirAsDSK::readSectorImpl(size_t sector, SectorBuffer& buf)
 			// Happens when dirasdisk is used in virtual_drive.
 			needSync = true;
 		}
-		if (needSync) {
+		if (needSync && anythingChanged()) {
 			syncWithHost();
 			flushCaches(); // e.g. sha1sum
 			// Let the diskdrive report the disk has been ejected.
@@ -380,8 +380,33 @@ void DirAsDSK::readSectorImpl(size_t sector, SectorBuffer& buf)
 	memcpy(&buf, &sectors[sector], sizeof(buf));
 }
 
+bool DirAsDSK::anythingChanged()
+{
+	// Host changes are reported by the watcher. Writes from the MSX side
+	// don't change the host files (apart from the exported files, but
+	// the watcher reports those) but they may have freed space for host
+	// files that didn't fit before.
+	return msxChanged || watcher.hasChanged();
+}
+
+void DirAsDSK::watchHostDirs()
+{
+	watcher.addDirectory(hostDir);
+	for (auto& p : mapDirs) {
+		if (msxDir(p.first).attrib & MSXDirEntry::ATT_DIRECTORY) {
+			watcher.addDirectory(hostDir + p.second.hostName);
+		}
+	}
+}
+
 void DirAsDSK::syncWithHost()
 {
+	// Start watching before scanning the host directories, so that
+	// changes during the scan are noticed on the next sync.
+	msxChanged = false;
+	watcher.resetChanged();
+	watchHostDirs();
+
 	// Check for removed host files. This frees up space in the virtual
 	// disk. Do this first because otherwise later actions may fail (run
 	// out of virtual disk space) for no good reason.
@@ -395,6 +420,9 @@ void DirAsDSK::syncWithHost()
 
 	// Last add new host files (this can only consume virtual disk space).
 	addNewHostFiles({}, firstDirSector);
+
+	// Also watch the subdirectories that were added just now.
+	watchHostDirs();
 }
 
 void DirAsDSK::checkDeletedHostFiles()
@@ -897,6 +925,7 @@ void DirAsDSK::writeSectorImpl(size_t sector_, const SectorBuffer& buf)
 	if (auto* scheduler = diskChanger.getScheduler()) {
 		lastAccess = scheduler->getCurrentTime();
 	}
+	msxChanged = true;
 
 	DirIndex dirDirIndex;
 	if (sector == 0) {
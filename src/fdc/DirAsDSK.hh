@@ -3,6 +3,7 @@
 
 #include "SectorBasedDisk.hh"
 #include "DiskImageUtils.hh"
+#include "DirWatcher.hh"
 #include "FileOperations.hh"
 #include "EmuTime.hh"
 #include "hash_map.hh"
@@ -69,6 +70,8 @@ private:
 	void writeDIREntry(DirIndex dirIndex, DirIndex dirDirIndex,
 	                   const MSXDirEntry& newEntry);
 	void syncWithHost();
+	void watchHostDirs();
+	bool anythingChanged();
 	void checkDeletedHostFiles();
 	void deleteMSXFile(DirIndex dirIndex);
 	void deleteMSXFilesInDir(unsigned msxDirSector);
@@ -128,6 +131,11 @@ private:
 
 	EmuTime lastAccess; // last time there was a sector read/write
 
+	// Notifies changes in the host directory (and its mapped
+	// subdirectories), so that syncWithHost() is only called when needed.
+	DirWatcher watcher;
+	bool msxChanged = false; // MSX wrote to the disk since the last sync
+
 	// For each directory entry that has a mapped host file/directory we
 	// store the name, last modification time and size of the corresponding
 	// host file/dir.
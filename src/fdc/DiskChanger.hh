@@ -37,7 +37,7 @@ public:
 
 	const std::string& getDriveName() const { return driveName; }
 	const DiskName& getDiskName() const;
-	bool peekDiskChanged() const { return diskChangedFlag; }
+	bool peekDiskChanged() const override { return diskChangedFlag; }
 	void forceDiskChange() { diskChangedFlag = true; }
 	Disk& getDisk() { return *disk; }
 
@@ -25,6 +25,9 @@ public:
 	virtual int insertDisk(string_view filename) = 0;
 	// for nowind
 	bool isRomdisk() const;
+	// for nowind
+	//  - like diskChanged(), but doesn't reset the flag
+	virtual bool peekDiskChanged() const { return false; }
 
 	template<typename Archive>
 	void serialize(Archive& /*ar*/, unsigned /*version*/) {}
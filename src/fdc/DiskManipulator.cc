@@ -494,6 +494,7 @@ void DiskManipulator::mkdir(DriveSettings& driveData, string_view filename)
 	auto workhorse = getMSXtar(*partition, driveData);
 	try {
 		workhorse->mkdir(filename);
+		workhorse->flush();
 	} catch (MSXException& e) {
 		throw CommandException(std::move(e).getMessage());
 	}
@@ -529,6 +530,12 @@ string DiskManipulator::import(DriveSettings& driveData,
 			}
 		}
 	}
+	// all FAT and directory updates are written in one go
+	try {
+		workhorse->flush();
+	} catch (MSXException& e) {
+		throw CommandException(std::move(e).getMessage());
+	}
 	return messages;
 }
 
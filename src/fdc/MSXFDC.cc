@@ -1,9 +1,18 @@
 #include "MSXFDC.hh"
 #include "RealDrive.hh"
+#include "BooleanSetting.hh"
+#include "DiskExceptions.hh"
+#include "DiskImageUtils.hh"
+#include "GlobalSettings.hh"
+#include "MSXCPU.hh"
+#include "MSXCPUInterface.hh"
+#include "CPURegs.hh"
+#include "Reactor.hh"
 #include "Rom.hh"
 #include "XMLElement.hh"
 #include "MSXException.hh"
 #include "serialize.hh"
+#include "xrange.hh"
 #include <memory>
 
 namespace openmsx {
@@ -13,6 +22,8 @@ MSXFDC::MSXFDC(const DeviceConfig& config, const std::string& romId, bool needRO
 	, rom(needROM
 		? std::make_unique<Rom>(getName() + " ROM", "rom", config, romId)
 		: nullptr) // e.g. Spectravideo_SVI-328 doesn't have a diskrom
+	, fastDiskAccessSetting(
+		getReactor().getGlobalSettings().getFastDiskAccessSetting())
 {
 	if (needROM && (rom->getSize() == 0)) {
 		throw MSXException(
@@ -47,21 +58,96 @@ void MSXFDC::powerDown(EmuTime::param time)
 	}
 }
 
-byte MSXFDC::readMem(word address, EmuTime::param /*time*/)
+byte MSXFDC::readMem(word address, EmuTime::param time)
 {
-	return *MSXFDC::getReadCacheLine(address);
+	if (fastPhydio(address, time)) return 0xC9; // RET
+	return MSXFDC::peekMem(address, time);
 }
 
 byte MSXFDC::peekMem(word address, EmuTime::param /*time*/) const
 {
-	return *MSXFDC::getReadCacheLine(address);
+	return (*rom)[address & 0x3FFF];
 }
 
 const byte* MSXFDC::getReadCacheLine(word start) const
 {
+	if (start == (PHYDIO & CacheLine::HIGH)) {
+		// Opcode fetches of the PHYDIO entry must go via readMem().
+		return nullptr;
+	}
 	return &(*rom)[start & 0x3FFF];
 }
 
+bool MSXFDC::executePhydio(EmuTime::param time)
+{
+	// Input:  A  = drive number (0 = first drive of this interface)
+	//         B  = number of sectors
+	//         C  = media descriptor
+	//         DE = first logical sector number
+	//         HL = transfer address
+	//         carry flag set for write, reset for read
+	// Output: carry flag reset on success, on error carry set and
+	//         A  = error code
+	//         B  = number of remaining sectors
+	if (!fastDiskAccessSetting.getBoolean() || !rom) return false;
+	auto& regs = getCPU().getRegisters();
+	// Only intercept an opcode fetch (the CPU only updates PC at the end
+	// of an instruction), not e.g. a data read from the jump table.
+	if (regs.getPC() != PHYDIO) return false;
+
+	// Let the disk ROM handle the cases we can't (easily) do here: the
+	// (phantom) drives without a real drive behind it (the ROM asks to
+	// swap disks) and transfers from/to page 1 (the ROM switches RAM in
+	// that page).
+	byte driveNum = regs.getA();
+	if (driveNum >= 4) return false;
+	auto* drive = dynamic_cast<RealDrive*>(drives[driveNum].get());
+	if (!drive) return false;
+	unsigned num = regs.getB();
+	unsigned addr = regs.getHL();
+	unsigned end = addr + num * 512;
+	if ((end > 0x10000) || ((addr < 0x8000) && (end > 0x4000))) {
+		return false;
+	}
+
+	bool write = (regs.getF() & 0x01) != 0; // carry flag
+	unsigned sector = regs.getDE();
+	auto& cpuInterface = getCPUInterface();
+	byte error = 0;
+	try {
+		for (/**/; num; --num, ++sector, addr += 512) {
+			SectorBuffer buf;
+			if (write) {
+				for (auto i : xrange(512)) {
+					buf.raw[i] = cpuInterface.readMem(addr + i, time);
+				}
+				drive->writeSector(sector, buf);
+			} else {
+				drive->readSector(sector, buf);
+				for (auto i : xrange(512)) {
+					cpuInterface.writeMem(addr + i, buf.raw[i], time);
+				}
+			}
+		}
+	} catch (WriteProtectedException&) {
+		error = 0;  // write protected
+	} catch (DriveEmptyException&) {
+		error = 2;  // not ready
+	} catch (NoSuchSectorException&) {
+		error = 8;  // record not found
+	} catch (MSXException&) {
+		error = 12; // other error
+	}
+	if (num == 0) {
+		regs.setF(regs.getF() & ~0x01);
+	} else {
+		regs.setF(regs.getF() | 0x01);
+		regs.setA(error);
+	}
+	regs.setB(num);
+	return true;
+}
+
 
 template<typename Archive>
 void MSXFDC::serialize(Archive& ar, unsigned /*version*/)
@@ -7,6 +7,7 @@
 
 namespace openmsx {
 
+class BooleanSetting;
 class DiskDrive;
 class Rom;
 
@@ -26,8 +27,25 @@ protected:
 	                bool needROM = true);
 	~MSXFDC() override;
 
+	/** When the 'fast_disk_access' setting is enabled, calling the
+	  * PHYDIO routine of the disk ROM (entry at 0x4010) directly
+	  * transfers the sectors between the disk image and memory. Call
+	  * this from readMem() for addresses where the disk ROM is visible.
+	  * @return true iff the transfer is done, then readMem() must return
+	  *         0xC9 (the opcode of 'RET') instead of the ROM content.
+	  */
+	bool fastPhydio(word address, EmuTime::param time) {
+		return (address == PHYDIO) && executePhydio(time);
+	}
+
 	std::unique_ptr<Rom> rom;
 	std::unique_ptr<DiskDrive> drives[4];
+
+private:
+	static const word PHYDIO = 0x4010;
+	bool executePhydio(EmuTime::param time);
+
+	BooleanSetting& fastDiskAccessSetting;
 };
 
 REGISTER_BASE_NAME_HELPER(MSXFDC, "FDC");
@@ -14,11 +14,13 @@
 #include "StringOp.hh"
 #include "strCat.hh"
 #include "File.hh"
+#include "ranges.hh"
 #include "stl.hh"
 #include <cstring>
 #include <cassert>
 #include <cctype>
 #include <sys/stat.h>
+#include <vector>
 
 using std::string;
 
@@ -112,7 +114,10 @@ void MSXtar::writeLogicalSector(unsigned sector, const SectorBuffer& buf)
 		memcpy(&fatBuffer[fatSector], &buf, sizeof(buf));
 		fatCacheDirty = true;
 	} else {
-		disk.writeSector(sector, buf);
+		// directory sector --> only written on flush()
+		auto& cached = dirCache[sector];
+		memcpy(&cached.buf, &buf, sizeof(buf));
+		cached.dirty = true;
 	}
 }
 
@@ -124,6 +129,32 @@ void MSXtar::readLogicalSector(unsigned sector, SectorBuffer& buf)
 		// we have a cache and this is a sector of the 1st FAT
 		//   --> read from cache
 		memcpy(&buf, &fatBuffer[fatSector], sizeof(buf));
+	} else if (auto* cached = lookup(dirCache, sector)) {
+		memcpy(&buf, &cached->buf, sizeof(buf));
+	} else {
+		disk.readSector(sector, buf);
+		auto& c = dirCache[sector];
+		memcpy(&c.buf, &buf, sizeof(buf));
+		c.dirty = false;
+	}
+}
+
+// File content doesn't go through the directory cache, it's written
+// directly (in runs of consecutive sectors).
+void MSXtar::writeDataSectors(unsigned sector, const SectorBuffer* buf,
+                              unsigned num)
+{
+	for (unsigned i = 0; i < num; ++i) {
+		// normally never cached, unless it used to be a dir sector
+		dirCache.erase(sector + i);
+		disk.writeSector(sector + i, buf[i]);
+	}
+}
+
+void MSXtar::readDataSector(unsigned sector, SectorBuffer& buf)
+{
+	if (auto* cached = lookup(dirCache, sector)) {
+		memcpy(&buf, &cached->buf, sizeof(buf));
 	} else {
 		disk.readSector(sector, buf);
 	}
@@ -145,6 +176,7 @@ MSXtar::MSXtar(SectorAccessibleDisk& sectordisk)
 
 	// cache complete FAT
 	fatCacheDirty = false;
+	freeClusterHint = 2;
 	fatBuffer.resize(sectorsPerFat);
 	for (unsigned i = 0; i < sectorsPerFat; ++i) {
 		disk.readSector(i + 1, fatBuffer[i]);
@@ -153,15 +185,32 @@ MSXtar::MSXtar(SectorAccessibleDisk& sectordisk)
 
 MSXtar::~MSXtar()
 {
-	if (!fatCacheDirty) return;
+	try {
+		flush();
+	} catch (MSXException&) {
+		// nothing
+	}
+}
 
+void MSXtar::flush()
+{
+	// directory sectors first (in disk order), then the FAT
+	std::vector<unsigned> dirty;
+	for (auto& p : dirCache) {
+		if (p.second.dirty) dirty.push_back(p.first);
+	}
+	ranges::sort(dirty);
+	for (auto sector : dirty) {
+		auto& cached = dirCache[sector];
+		disk.writeSector(sector, cached.buf);
+		cached.dirty = false;
+	}
+
+	if (!fatCacheDirty) return;
 	for (unsigned i = 0; i < sectorsPerFat; ++i) {
-		try {
-			disk.writeSector(i + 1, fatBuffer[i]);
-		} catch (MSXException&) {
-			// nothing
-		}
+		disk.writeSector(i + 1, fatBuffer[i]);
 	}
+	fatCacheDirty = false;
 }
 
 // transform BAD_FAT (0xFF7) and EOF_FAT-range (0xFF8-0xFFF)
@@ -198,17 +247,22 @@ void MSXtar::writeFAT(unsigned clnr, unsigned val)
 		p[1] = (p[1] & 0xF0) + ((val >> 8) & 0x0F);
 	}
 	fatCacheDirty = true;
+	if (val == 0) {
+		freeClusterHint = std::min(freeClusterHint, clnr);
+	}
 }
 
 // Find the next clusternumber marked as free in the FAT
 // @throws When no more free clusters
 unsigned MSXtar::findFirstFreeCluster()
 {
-	for (unsigned cluster = 2; cluster < maxCluster; ++cluster) {
+	for (unsigned cluster = freeClusterHint; cluster < maxCluster; ++cluster) {
 		if (readFAT(cluster) == 0) {
+			freeClusterHint = cluster;
 			return cluster;
 		}
 	}
+	freeClusterHint = maxCluster;
 	throw MSXException("Disk full.");
 }
 
@@ -478,10 +532,14 @@ void MSXtar::alterFileInDSK(MSXDirEntry& msxDirEntry, const string& hostName)
 	// open host file for reading
 	File file(FileOperations::expandTilde(hostName), "rb");
 
-	// copy host file to image
+	// First build the cluster chain: reuse the clusters of the existing
+	// chain, extend it with free clusters if needed.
+	unsigned clusterSize = sectorsPerCluster * SECTOR_SIZE;
+	std::vector<unsigned> clusters;
 	unsigned prevCl = 0;
 	unsigned curCl = getStartCluster(msxDirEntry);
-	while (remaining) {
+	unsigned needed = hostSize;
+	while (needed) {
 		// allocate new cluster if needed
 		try {
 			if ((curCl == 0) || (curCl == EOF_FAT)) {
@@ -498,17 +556,8 @@ void MSXtar::alterFileInDSK(MSXDirEntry& msxDirEntry, const string& hostName)
 			// no more free clusters
 			break;
 		}
-
-		// fill cluster
-		unsigned logicalSector = clusterToSector(curCl);
-		for (unsigned j = 0; (j < sectorsPerCluster) && remaining; ++j) {
-			SectorBuffer buf;
-			memset(&buf, 0, sizeof(buf));
-			unsigned chunkSize = std::min(SECTOR_SIZE, remaining);
-			file.read(&buf, chunkSize);
-			writeLogicalSector(logicalSector + j, buf);
-			remaining -= chunkSize;
-		}
+		clusters.push_back(curCl);
+		needed -= std::min(needed, clusterSize);
 
 		// advance to next cluster
 		prevCl = curCl;
@@ -529,6 +578,26 @@ void MSXtar::alterFileInDSK(MSXDirEntry& msxDirEntry, const string& hostName)
 		curCl = nextCl;
 	}
 
+	// copy host file to image, in runs of consecutive clusters
+	static const unsigned MAX_RUN_SECTORS = 128; // 64kB
+	MemBuffer<SectorBuffer> buf;
+	unsigned i = 0;
+	while (remaining && (i < clusters.size())) {
+		unsigned first = i;
+		do {
+			++i;
+		} while ((i < clusters.size()) &&
+		         (clusters[i] == (clusters[i - 1] + 1)) &&
+		         (((i + 1 - first) * sectorsPerCluster) <= MAX_RUN_SECTORS));
+		unsigned chunkSize = std::min(remaining, (i - first) * clusterSize);
+		unsigned num = (chunkSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+		buf.resize(num);
+		memset(&buf[num - 1], 0, SECTOR_SIZE);
+		file.read(buf.data(), chunkSize);
+		writeDataSectors(clusterToSector(clusters[first]), buf.data(), num);
+		remaining -= chunkSize;
+	}
+
 	// write (possibly truncated) file size
 	msxDirEntry.size = hostSize - remaining;
 
@@ -776,7 +845,7 @@ void MSXtar::fileExtract(const string& resultFile, const MSXDirEntry& dirEntry)
 	File file(FileOperations::expandTilde(resultFile), "wb");
 	while (size && sector) {
 		SectorBuffer buf;
-		readLogicalSector(sector, buf);
+		readDataSector(sector, buf);
 		unsigned savesize = std::min(size, SECTOR_SIZE);
 		file.write(&buf, savesize);
 		size -= savesize;
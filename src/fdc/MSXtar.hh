@@ -9,6 +9,7 @@
 
 #include "MemBuffer.hh"
 #include "DiskImageUtils.hh"
+#include "hash_map.hh"
 #include "string_view.hh"
 
 namespace openmsx {
@@ -29,6 +30,13 @@ public:
 	std::string getItemFromDir(string_view rootDirName, string_view itemName);
 	void getDir(string_view rootDirName);
 
+	/** Write the cached FAT and directory sectors back to the disk.
+	  * This is also done by the destructor, but there errors can't be
+	  * reported.
+	  * @throws MSXException when writing fails
+	  */
+	void flush();
+
 private:
 	struct DirEntry {
 		unsigned sector;
@@ -37,6 +45,9 @@ private:
 
 	void writeLogicalSector(unsigned sector, const SectorBuffer& buf);
 	void readLogicalSector (unsigned sector,       SectorBuffer& buf);
+	void writeDataSectors(unsigned sector, const SectorBuffer* buf,
+	                      unsigned num);
+	void readDataSector(unsigned sector, SectorBuffer& buf);
 
 	unsigned clusterToSector(unsigned cluster);
 	unsigned sectorToCluster(unsigned sector);
@@ -70,12 +81,22 @@ private:
 	SectorAccessibleDisk& disk;
 	MemBuffer<SectorBuffer> fatBuffer;
 
+	// Directory sectors are only written to the disk on flush(), so
+	// that importing many files doesn't read and write the same
+	// sectors over and over again.
+	struct CachedSector {
+		SectorBuffer buf;
+		bool dirty;
+	};
+	hash_map<unsigned, CachedSector> dirCache;
+
 	unsigned maxCluster;
 	unsigned sectorsPerCluster;
 	unsigned sectorsPerFat;
 	unsigned rootDirStart; // first sector from the root directory
 	unsigned rootDirLast;  // last  sector from the root directory
 	unsigned chrootSector;
+	unsigned freeClusterHint; // all clusters below this one are in use
 
 	bool fatCacheDirty;
 };
@@ -13,6 +13,7 @@ NationalFDC::NationalFDC(const DeviceConfig& config)
 
 byte NationalFDC::readMem(word address, EmuTime::param time)
 {
+	if (fastPhydio(address, time)) return 0xC9; // RET
 	byte value;
 	switch (address & 0x3FC7) {
 	case 0x3F80:
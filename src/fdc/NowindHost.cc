@@ -21,6 +21,7 @@ using std::ios;
 namespace openmsx {
 
 static const unsigned SECTOR_SIZE = sizeof(SectorBuffer);
+static const unsigned READ_AHEAD_SECTORS = 64; // 32kB, a full page 1+2 transfer
 
 static void DBERR(const char* message, ...)
 {
@@ -72,6 +73,9 @@ void NowindHost::write(byte data, unsigned time)
 	if (duration >= 500) {
 		// timeout (500ms), start looking for AF05
 		purge();
+		// Also forget the read-ahead data, this limits how long a change
+		// on the host (e.g. in a dir-as-disk directory) can go unnoticed.
+		invalidateReadAhead();
 		state = STATE_SYNC1;
 	}
 
@@ -144,6 +148,7 @@ void NowindHost::msxReset()
 	for (auto& dev : devices) {
 		dev.fs.reset();
 	}
+	invalidateReadAhead();
 	DBERR("MSX reset\n");
 }
 
@@ -238,6 +243,17 @@ void NowindHost::send16(word value)
 	hostToMsxFifo.push_back(value & 255);
 	hostToMsxFifo.push_back(value >> 8);
 }
+void NowindHost::sendBlock(const byte* data, unsigned size)
+{
+	// grow the fifo once for the whole block instead of per byte
+	auto& buf = hostToMsxFifo.getBuffer();
+	if (buf.reserve() < size) {
+		buf.set_capacity(std::max(buf.size() + size, 2 * buf.capacity()));
+	}
+	for (unsigned i = 0; i < size; ++i) {
+		buf.push_back(data[i]);
+	}
+}
 
 void NowindHost::purge()
 {
@@ -263,6 +279,7 @@ void NowindHost::DSKCHG()
 	byte num = cmdData[7]; // reg_a
 	assert(num < drives.size());
 	if (drives[num]->diskChanged()) {
+		invalidateReadAhead();
 		send(255); // changed
 		// read first FAT sector (contains media descriptor)
 		SectorBuffer sectorBuffer;
@@ -346,12 +363,67 @@ unsigned NowindHost::getCurrentAddress() const
 }
 
 
-void NowindHost::diskReadInit(SectorAccessibleDisk& disk)
+void NowindHost::invalidateReadAhead()
 {
-	unsigned sectorAmount = getSectorAmount();
+	readAhead.clear();
+	readAheadDisk = nullptr;
+	nextReadSector = unsigned(-1);
+}
+
+// Read the requested sectors into 'buffer'. When the MSX reads the disk
+// sequentially (e.g. while loading a file) the following sectors are already
+// read as well, so that the next request doesn't have to access the disk
+// image.
+int NowindHost::readSectors(SectorAccessibleDisk& disk, unsigned startSector,
+                            unsigned sectorAmount)
+{
+	byte num = cmdData[7]; // reg_a
+	assert(num < drives.size());
+	if (drives[num]->peekDiskChanged()) {
+		invalidateReadAhead();
+	}
+
 	buffer.resize(sectorAmount);
-	unsigned startSector = getStartSector();
-	if (disk.readSectors(buffer.data(), startSector, sectorAmount)) {
+	unsigned endSector = startSector + sectorAmount;
+	unsigned readAheadEnd = readAheadStart + unsigned(readAhead.size());
+	bool cached = (&disk == readAheadDisk) &&
+	              (readAheadStart <= startSector) &&
+	              (endSector <= readAheadEnd);
+	if (cached) {
+		std::copy_n(&readAhead[startSector - readAheadStart],
+		            sectorAmount, buffer.data());
+	} else if (disk.readSectors(buffer.data(), startSector, sectorAmount)) {
+		invalidateReadAhead();
+		return 1; // read error
+	}
+
+	bool sequential = startSector == nextReadSector;
+	nextReadSector = endSector;
+	if (!sequential || (cached && (endSector < readAheadEnd))) {
+		// not a sequential read, or still enough data ahead
+		return 0;
+	}
+	size_t nbSectors = disk.getNbSectors();
+	if (endSector >= nbSectors) {
+		readAhead.clear();
+		return 0;
+	}
+	auto amount = unsigned(std::min<size_t>(READ_AHEAD_SECTORS,
+	                                        nbSectors - endSector));
+	readAhead.resize(amount);
+	if (disk.readSectors(readAhead.data(), endSector, amount)) {
+		// not an error for this request, simply don't use read-ahead
+		readAhead.clear();
+		return 0;
+	}
+	readAheadDisk = &disk;
+	readAheadStart = endSector;
+	return 0;
+}
+
+void NowindHost::diskReadInit(SectorAccessibleDisk& disk)
+{
+	if (readSectors(disk, getStartSector(), getSectorAmount())) {
 		// read error
 		state = STATE_SYNC1;
 		return;
@@ -443,10 +515,7 @@ void NowindHost::transferSectors(unsigned transferAddress, unsigned amount)
 	send16(transferAddress);
 	send16(amount);
 
-	auto* bufferPointer = buffer[0].raw + transfered;
-	for (unsigned i = 0; i < amount; ++i) {
-		send(bufferPointer[i]);
-	}
+	sendBlock(buffer[0].raw + transfered, amount);
 	send(0xAF);
 	send(0x07); // used for validation
 }
@@ -459,10 +528,11 @@ void NowindHost::transferSectorsBackwards(unsigned transferAddress, unsigned amo
 	send16(transferAddress + amount);
 	send(amount / 64);
 
-	auto* bufferPointer = buffer[0].raw + transfered;
-	for (int i = amount - 1; i >= 0; --i) {
-		send(bufferPointer[i]);
-	}
+	assert(amount <= 2048);
+	byte reversed[2048];
+	std::reverse_copy(buffer[0].raw + transfered,
+	                  buffer[0].raw + transfered + amount, reversed);
+	sendBlock(reversed, amount);
 	send(0xAF);
 	send(0x07); // used for validation
 }
@@ -470,6 +540,7 @@ void NowindHost::transferSectorsBackwards(unsigned transferAddress, unsigned amo
 
 void NowindHost::diskWriteInit(SectorAccessibleDisk& disk)
 {
+	invalidateReadAhead();
 	if (disk.isWriteProtected()) {
 		sendHeader();
 		send(1);
@@ -64,6 +64,7 @@ private:
 
 	void send(byte value);
 	void send16(word value);
+	void sendBlock(const byte* data, unsigned size);
 	void sendHeader();
 	void purge();
 
@@ -78,6 +79,9 @@ private:
 	unsigned getStartAddress() const;
 	unsigned getCurrentAddress() const;
 
+	int readSectors(SectorAccessibleDisk& disk, unsigned startSector,
+	                unsigned sectorAmount);
+	void invalidateReadAhead();
 	void diskReadInit(SectorAccessibleDisk& disk);
 	void doDiskRead1();
 	void doDiskRead2();
@@ -124,6 +128,14 @@ private:
 	byte cmdData[9];         // reg_[cbedlhfa] + cmd
 	byte extraData[240 + 2]; // extra data for diskread/write
 
+	// Sectors following the last (sequential) diskread. Not serialized,
+	// it only avoids accessing the disk image, it doesn't influence the
+	// emulation.
+	std::vector<SectorBuffer> readAhead;
+	const SectorAccessibleDisk* readAheadDisk = nullptr;
+	unsigned readAheadStart = 0; // sector number of readAhead[0]
+	unsigned nextReadSector = unsigned(-1); // end of the last diskread
+
 	byte romdisk;            // index of romdisk (255 = no romdisk)
 	bool allowOtherDiskroms;
 	bool enablePhantomDrives;
@@ -21,6 +21,7 @@ void PhilipsFDC::reset(EmuTime::param time)
 
 byte PhilipsFDC::readMem(word address, EmuTime::param time)
 {
+	if (fastPhydio(address, time)) return 0xC9; // RET
 	byte value;
 	switch (address & 0x3FFF) {
 	case 0x3FF8:
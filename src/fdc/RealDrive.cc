@@ -361,6 +361,19 @@ void RealDrive::flushTrack()
 	}
 }
 
+void RealDrive::readSector(size_t sector, SectorBuffer& buf)
+{
+	flushTrack(); // make pending writes via the FDC visible
+	changer->getDisk().readSector(sector, buf);
+}
+
+void RealDrive::writeSector(size_t sector, const SectorBuffer& buf)
+{
+	flushTrack();
+	changer->getDisk().writeSector(sector, buf);
+	invalidateTrack(); // the FDC must not see the old track data
+}
+
 bool RealDrive::diskChanged()
 {
 	return changer->diskChanged();
@@ -14,6 +14,7 @@ namespace openmsx {
 
 class MSXMotherBoard;
 class DiskChanger;
+union SectorBuffer;
 
 /** This class implements a real drive, single or double sided.
  */
@@ -49,6 +50,12 @@ public:
 	void applyWd2793ReadTrackQuirk() override;
 	void invalidateWd2793ReadTrackQuirk() override;
 
+	/** Access the sectors of the inserted disk directly, bypassing the
+	  * (emulated) FDC. Used for the 'fast_disk_access' setting.
+	  */
+	void readSector(size_t sector, SectorBuffer& buf);
+	void writeSector(size_t sector, const SectorBuffer& buf);
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -19,6 +19,7 @@ SanyoFDC::SanyoFDC(const DeviceConfig& config)
 
 byte SanyoFDC::readMem(word address, EmuTime::param time)
 {
+	if (fastPhydio(address, time)) return 0xC9; // RET
 	byte value;
 	switch (address) {
 	case 0x7FF8:
@@ -1,13 +1,13 @@
 #include "SectorBasedDisk.hh"
 #include "MSXException.hh"
 #include <cassert>
+#include <cstring>
 
 namespace openmsx {
 
 SectorBasedDisk::SectorBasedDisk(DiskName name_)
 	: Disk(std::move(name_))
 	, nbSectors(size_t(-1)) // to detect misuse
-	, cachedTrackNum(-1)
 {
 }
 
@@ -31,21 +31,19 @@ void SectorBasedDisk::writeTrackImpl(byte track, byte side, const RawTrack& inpu
 
 void SectorBasedDisk::readTrack(byte track, byte side, RawTrack& output)
 {
-	// Try to cache the last result of this method (the cache will be
-	// flushed on any write to the disk). This very simple cache mechanism
-	// will typically already have a very high hit-rate. For example during
-	// emulation of a WD2793 read sector, we also emulate the search for
-	// the correct sector. So the disk rotates from sector to sector, and
-	// each time we re-read the track data (because emutime has passed).
-	// Typically the software will also read several sectors from the same
-	// track before moving to the next.
+	// Cache the result of this method per track (the cache is flushed on
+	// any write to the disk). During emulation of a WD2793 read sector,
+	// we also emulate the search for the correct sector. So the disk
+	// rotates from sector to sector, and each time we re-read the track
+	// data (because emutime has passed). And software that seeks back and
+	// forth (e.g. between the FAT/directory and the file data) keeps
+	// revisiting the same few tracks.
 	checkCaches();
-	int num = track | (side << 8);
-	if (num == cachedTrackNum) {
-		output = cachedTrackData;
+	unsigned num = track | (side << 8);
+	if (auto* cached = lookup(cachedTracks, num)) {
+		output = *cached;
 		return;
 	}
-	cachedTrackNum = num;
 
 	// This disk image only stores the actual sector data, not all the
 	// extra gap, sync and header information that is in reality stored
@@ -79,64 +77,74 @@ void SectorBasedDisk::readTrack(byte track, byte side, RawTrack& output)
 	// (*) Missing clock transitions in MFM encoding
 
 	try {
-		output.clear(RawTrack::STANDARD_SIZE); // clear idam positions
-
+		// Clears the idam positions and fills the whole track with
+		// 0x4e, so the gaps don't need to be written below. The data
+		// is written directly in the buffer (the track doesn't wrap).
+		output.clear(RawTrack::STANDARD_SIZE);
+		byte* raw = output.getRawBuffer();
 		unsigned idx = 0;
-		for (int i = 0; i < 80; ++i) output.write(idx++, 0x4E); // gap4a
-		for (int i = 0; i < 12; ++i) output.write(idx++, 0x00); // sync
-		for (int i = 0; i <  3; ++i) output.write(idx++, 0xC2); // index mark (1)
-		for (int i = 0; i <  1; ++i) output.write(idx++, 0xFC); //            (2)
-		for (int i = 0; i < 50; ++i) output.write(idx++, 0x4E); // gap1
+		auto fill = [&](unsigned n, byte val) {
+			memset(raw + idx, val, n);
+			idx += n;
+		};
+
+		idx += 80;                                // gap4a
+		fill(12, 0x00);                           // sync
+		fill( 3, 0xC2);                           // index mark (1)
+		fill( 1, 0xFC);                           //            (2)
+		idx += 50;                                // gap1
 
 		for (int j = 0; j < 9; ++j) {
-			for (int i = 0; i < 12; ++i) output.write(idx++, 0x00); // sync
-
-			for (int i = 0; i <  3; ++i) output.write(idx++, 0xA1); // addr mark (1)
-			for (int i = 0; i <  1; ++i) output.write(idx++, 0xFE, true); //     (2) add idam
-			output.write(idx++, track); // C: Cylinder number
-			output.write(idx++, side);  // H: Head Address
-			output.write(idx++, j + 1); // R: Record
-			output.write(idx++, 0x02);  // N: Number (length of sector: 512 = 128 << 2)
+			fill(12, 0x00);                   // sync
+
+			fill( 3, 0xA1);                   // addr mark (1)
+			output.addIdam(idx);
+			fill( 1, 0xFE);                   //           (2)
+			raw[idx++] = track; // C: Cylinder number
+			raw[idx++] = side;  // H: Head Address
+			raw[idx++] = j + 1; // R: Record
+			raw[idx++] = 0x02;  // N: Number (length of sector: 512 = 128 << 2)
 			word addrCrc = output.calcCrc(idx - 8, 8);
-			output.write(idx++, addrCrc >> 8);   // CRC (high byte)
-			output.write(idx++, addrCrc & 0xff); //     (low  byte)
+			raw[idx++] = addrCrc >> 8;   // CRC (high byte)
+			raw[idx++] = addrCrc & 0xff; //     (low  byte)
 
-			for (int i = 0; i < 22; ++i) output.write(idx++, 0x4E); // gap2
-			for (int i = 0; i < 12; ++i) output.write(idx++, 0x00); // sync
+			idx += 22;                        // gap2
+			fill(12, 0x00);                   // sync
 
-			for (int i = 0; i <  3; ++i) output.write(idx++, 0xA1); // data mark (1)
-			for (int i = 0; i <  1; ++i) output.write(idx++, 0xFB); //           (2)
+			fill( 3, 0xA1);                   // data mark (1)
+			fill( 1, 0xFB);                   //           (2)
 
 			auto logicalSector = physToLog(track, side, j + 1);
 			SectorBuffer buf;
 			readSector(logicalSector, buf);
-			for (auto& r : buf.raw) output.write(idx++, r);
+			memcpy(raw + idx, buf.raw, sizeof(buf.raw));
+			idx += sizeof(buf.raw);
 
 			word dataCrc = output.calcCrc(idx - (512 + 4), 512 + 4);
-			output.write(idx++, dataCrc >> 8);   // CRC (high byte)
-			output.write(idx++, dataCrc & 0xff); //     (low  byte)
+			raw[idx++] = dataCrc >> 8;   // CRC (high byte)
+			raw[idx++] = dataCrc & 0xff; //     (low  byte)
 
-			for (int i = 0; i < 84; ++i) output.write(idx++, 0x4E); // gap3
+			idx += 84;                        // gap3
 		}
 
-		for (int i = 0; i < 182; ++i) output.write(idx++, 0x4E); // gap4b
+		idx += 182;                               // gap4b
 		assert(idx == RawTrack::STANDARD_SIZE);
 	} catch (MSXException& /*e*/) {
 		// There was an error while reading the actual sector data.
 		// Most likely this is because we're reading the 81th track on
 		// a disk with only 80 tracks (or similar). If you do this on a
 		// real disk, you simply read an 'empty' track. So we do the
-		// same here.
+		// same here (but don't cache it).
 		output.clear(RawTrack::STANDARD_SIZE);
-		cachedTrackNum = -1; // needed?
+		return;
 	}
-	cachedTrackData = output;
+	cachedTracks.emplace_noDuplicateCheck(num, output);
 }
 
 void SectorBasedDisk::flushCaches()
 {
 	Disk::flushCaches();
-	cachedTrackNum = -1;
+	cachedTracks.clear();
 }
 
 size_t SectorBasedDisk::getNbSectorsImpl() const
@@ -3,6 +3,7 @@
 
 #include "Disk.hh"
 #include "RawTrack.hh"
+#include "hash_map.hh"
 
 namespace openmsx {
 
@@ -30,8 +31,8 @@ private:
 
 	size_t nbSectors;
 
-	RawTrack cachedTrackData;
-	int cachedTrackNum;
+	// synthesized tracks, indexed by 'track | (side << 8)'
+	hash_map<unsigned, RawTrack> cachedTracks;
 };
 
 } // namespace openmsx
@@ -0,0 +1,157 @@
+#include "SectorWriteBack.hh"
+#include "File.hh"
+#include "FileException.hh"
+#include <algorithm>
+#include <cstring>
+
+namespace openmsx {
+
+SectorWriteBack::SectorWriteBack(File& file_)
+	: file(file_)
+{
+}
+
+SectorWriteBack::~SectorWriteBack()
+{
+	try {
+		flush();
+	} catch (MSXException&) {
+		// ignore, nothing we can do about it at this point
+	}
+}
+
+void SectorWriteBack::read(size_t sector, SectorBuffer& buf)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (auto* entry = lookup(dirty, sector)) {
+			buf = entry->buf;
+			return;
+		}
+	}
+	// Not dirty. The worker thread can't make it dirty, so it's fine to
+	// release the lock before reading.
+	std::lock_guard<std::mutex> fileLock(fileMutex);
+	size_t offset = sector * sizeof(buf);
+	file.readAhead(offset);
+	auto mapped = file.mmapShared();
+	if ((offset + sizeof(buf)) <= mapped.size()) {
+		memcpy(&buf, mapped.data() + offset, sizeof(buf));
+		return;
+	}
+	// Can't mmap the file (e.g. not enough address space), read a block
+	// of sectors at once (sectors are mostly read sequentially).
+	if ((sector - readAheadStart) >= readAheadCount) { // also if < start
+		readAheadStart = sector;
+		readAheadCount = 0;
+		size_t fileSectors = file.getSize() / sizeof(buf);
+		if (sector >= fileSectors) {
+			// let File report the error
+			file.seek(offset);
+			file.read(&buf, sizeof(buf));
+			return;
+		}
+		size_t num = std::min(size_t(READ_AHEAD), fileSectors - sector);
+		if (readAhead.empty()) readAhead.resize(READ_AHEAD);
+		file.seek(offset);
+		file.read(readAhead.data(), num * sizeof(buf));
+		readAheadCount = num;
+	}
+	buf = readAhead[sector - readAheadStart];
+}
+
+void SectorWriteBack::write(size_t sector, const SectorBuffer& buf)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	checkError();
+	anyWrites = true;
+	if (auto* entry = lookup(dirty, sector)) {
+		entry->buf = buf;
+		entry->generation = ++generation;
+		return; // there's already a job pending
+	}
+	written.wait(lock, [&] { return dirty.size() < MAX_DIRTY; });
+	dirty.emplace_noDuplicateCheck(sector, Entry{buf, ++generation});
+	if (!jobPending) {
+		jobPending = true;
+		// The job doesn't own 'this', but it's safe because
+		// the destructor waits till all dirty sectors are written.
+		worker.push([this] { writeDirty(); });
+	}
+}
+
+bool SectorWriteBack::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	written.wait(lock, [&] { return dirty.empty(); });
+	checkError();
+	bool result = anyWrites;
+	anyWrites = false;
+	return result;
+}
+
+void SectorWriteBack::checkError()
+{
+	if (!error.empty()) {
+		std::string tmp = std::move(error);
+		error.clear();
+		throw FileException("Error writing disk image: ", tmp);
+	}
+}
+
+void SectorWriteBack::writeDirty()
+{
+	MemBuffer<SectorBuffer> run(MAX_RUN);
+	unsigned generations[MAX_RUN];
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!dirty.empty()) {
+		// Collect a run of consecutive dirty sectors (e.g. a multiple
+		// block write of the SD card), so that it can be written with
+		// a single file write. Keep the entries in the cache while
+		// they're being written, so that reads still get the new data.
+		size_t first = dirty.begin()->first;
+		for (size_t i = 0; (i < (MAX_RUN - 1)) && (first > 0) &&
+		                   dirty.contains(first - 1); ++i) {
+			--first;
+		}
+		size_t num = 0;
+		while (num < MAX_RUN) {
+			auto* entry = lookup(dirty, first + num);
+			if (!entry) break;
+			run[num] = entry->buf;
+			generations[num] = entry->generation;
+			++num;
+		}
+		lock.unlock();
+
+		std::string err;
+		bool failed = false;
+		try {
+			std::lock_guard<std::mutex> fileLock(fileMutex);
+			file.seek(first * sizeof(SectorBuffer));
+			file.write(run.data(), num * sizeof(SectorBuffer));
+			file.flush(); // make the new data visible via mmapShared()
+			readAheadCount = 0;
+		} catch (MSXException& e) {
+			err = e.getMessage();
+			failed = true;
+		}
+
+		lock.lock();
+		if (failed && error.empty()) error = std::move(err);
+		// Only drop an entry when it wasn't rewritten in the mean
+		// time. On error drop it anyway (retrying likely fails again).
+		for (size_t i = 0; i < num; ++i) {
+			auto* current = lookup(dirty, first + i);
+			if (current && (failed ||
+			                (current->generation == generations[i]))) {
+				dirty.erase(first + i);
+			}
+		}
+		written.notify_all();
+	}
+	jobPending = false;
+}
+
+} // namespace openmsx
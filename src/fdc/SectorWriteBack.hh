@@ -0,0 +1,83 @@
+#ifndef SECTORWRITEBACK_HH
+#define SECTORWRITEBACK_HH
+
+#include "DiskImageUtils.hh"
+#include "MemBuffer.hh"
+#include "WorkerThread.hh"
+#include "hash_map.hh"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace openmsx {
+
+class File;
+
+/** Write-back cache for a sector based image file (e.g. a DSK or HD image).
+  *
+  * write() only copies the sector in the cache, a background thread writes
+  * the dirty sectors to the file. So a slow host disk (e.g. a network
+  * drive) doesn't stall the emulation. When there are too many dirty
+  * sectors (more than MAX_DIRTY) write() waits till some are written.
+  * Consecutive dirty sectors are written to the file in one go. When the
+  * file can't be mmap'ed, read() reads READ_AHEAD sectors at once.
+  *
+  * Until flush() is called, the file may not contain all the written data.
+  * So all access to the file must go via this class, and flush() must be
+  * called before the file is used in any other way (e.g. to calculate its
+  * checksum, or before it's closed). A write error on the background thread
+  * is reported by the next write() or flush() call.
+  */
+class SectorWriteBack
+{
+public:
+	static const size_t MAX_DIRTY = 2048; // 1MB
+	static const size_t MAX_RUN = 64; // consecutive sectors per file write
+	static const size_t READ_AHEAD = 32; // only used when mmap fails
+
+	explicit SectorWriteBack(File& file);
+	~SectorWriteBack();
+
+	SectorWriteBack(const SectorWriteBack&) = delete;
+	SectorWriteBack& operator=(const SectorWriteBack&) = delete;
+
+	void read (size_t sector,       SectorBuffer& buf);
+	void write(size_t sector, const SectorBuffer& buf);
+
+	/** Wait till all written sectors are stored in the file.
+	  * @return Were there any writes since the previous flush?
+	  */
+	bool flush();
+
+private:
+	void writeDirty(); // runs on the worker thread
+	void checkError();
+
+	struct Entry {
+		SectorBuffer buf;
+		unsigned generation; // to detect rewrites while writing
+	};
+
+	File& file;
+	std::mutex fileMutex; // protects all accesses to 'file'
+
+	// sectors read ahead, protected by 'fileMutex'
+	MemBuffer<SectorBuffer> readAhead;
+	size_t readAheadStart = 0;
+	size_t readAheadCount = 0;
+
+	std::mutex mutex; // protects all members below
+	std::condition_variable written; // a dirty sector was written
+	hash_map<size_t, Entry> dirty;
+	std::string error; // first write error
+	unsigned generation = 0;
+	bool jobPending = false; // invariant: true if 'dirty' is not empty
+	bool anyWrites = false;
+
+	WorkerThread worker; // must be destroyed first
+};
+
+} // namespace openmsx
+
+#endif
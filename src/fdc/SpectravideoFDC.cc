@@ -37,6 +37,7 @@ void SpectravideoFDC::reset(EmuTime::param /*time*/)
 
 byte SpectravideoFDC::readMem(word address, EmuTime::param time)
 {
+	if (!cpmRomEnabled && fastPhydio(address, time)) return 0xC9; // RET
 	byte value;
 	switch (address & 0x3FFF) {
 	case 0x3FB8:
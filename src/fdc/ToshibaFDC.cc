@@ -18,6 +18,7 @@ ToshibaFDC::ToshibaFDC(const DeviceConfig& config)
 
 byte ToshibaFDC::readMem(word address, EmuTime::param time)
 {
+	if (fastPhydio(address, time)) return 0xC9; // RET
 	byte value;
 	switch (address) {
 	case 0x7FF0:
@@ -49,6 +49,7 @@ void VictorFDC::reset(EmuTime::param time)
 
 byte VictorFDC::readMem(word address, EmuTime::param time)
 {
+	if (fastPhydio(address, time)) return 0xC9; // RET
 	byte value;
 	switch (address) {
 	case 0x7FF8:
@@ -1,6 +1,8 @@
 #include "XSADiskImage.hh"
+#include "DecodedFileCache.hh"
 #include "DiskExceptions.hh"
 #include "File.hh"
+#include "FileException.hh"
 #include <cstring>
 
 using std::string;
@@ -56,11 +58,40 @@ private:
 XSADiskImage::XSADiskImage(Filename& filename, File& file)
 	: SectorBasedDisk(filename)
 {
-	XSAExtractor extractor(file);
-	unsigned sectors = extractor.getData(data);
+	string url = file.getURL();
+	time_t date = file.getModificationDate();
+	size_t sectors;
+	if (!loadCached(url, date, sectors)) {
+		XSAExtractor extractor(file);
+		sectors = extractor.getData(data);
+		if (sectors) {
+			DecodedFileCache::store(
+				"xsa", url, date, data.data()->raw,
+				sectors * sizeof(SectorBuffer));
+		}
+	}
 	setNbSectors(sectors);
 }
 
+bool XSADiskImage::loadCached(const string& url, time_t date, size_t& sectors)
+{
+	File cached;
+	size_t size;
+	string extra;
+	if (!DecodedFileCache::open("xsa", url, date, cached, size, extra) ||
+	    (size == 0) || ((size % sizeof(SectorBuffer)) != 0)) {
+		return false;
+	}
+	sectors = size / sizeof(SectorBuffer);
+	try {
+		data.resize(sectors);
+		cached.read(data.data(), size);
+	} catch (FileException&) {
+		return false;
+	}
+	return true;
+}
+
 void XSADiskImage::readSectorImpl(size_t sector, SectorBuffer& buf)
 {
 	memcpy(&buf, &data[sector], sizeof(buf));
@@ -10,6 +10,8 @@
 
 #include "SectorBasedDisk.hh"
 #include "MemBuffer.hh"
+#include <ctime>
+#include <string>
 
 namespace openmsx {
 
@@ -26,6 +28,8 @@ private:
 	void writeSectorImpl(size_t sector, const SectorBuffer& buf) override;
 	bool isWriteProtectedImpl() const override;
 
+	bool loadCached(const std::string& url, time_t date, size_t& sectors);
+
 	MemBuffer<SectorBuffer> data;
 };
 
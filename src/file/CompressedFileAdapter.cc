@@ -1,6 +1,9 @@
 #include "CompressedFileAdapter.hh"
+#include "DecodedFileCache.hh"
+#include "File.hh"
 #include "FileException.hh"
 #include "hash_set.hh"
+#include "sha1.hh"
 #include "xxhash.hh"
 #include <cstring>
 
@@ -16,6 +19,44 @@ struct GetURLFromDecompressed {
 static hash_set<std::shared_ptr<CompressedFileAdapter::Decompressed>,
                 GetURLFromDecompressed, XXHasher> decompressCache;
 
+// Decompressing small files is fast, don't let them push the big ones (e.g.
+// disk images) out of the persistent cache.
+static const size_t MIN_PERSISTENT_SIZE = 64 * 1024;
+
+// The persistent cache is content-addressed: the same compressed file at a
+// different location (e.g. in another user's directory) shares the entry.
+static string getPersistentKey(FileBase& file)
+{
+	auto raw = file.mmap();
+	return "sha1:" + SHA1::calc(raw.data(), raw.size()).toString();
+}
+
+static bool loadPersistent(const string& key,
+                           CompressedFileAdapter::Decompressed& decompressed)
+{
+	File file;
+	size_t size;
+	string originalName;
+	if (!DecodedFileCache::open("decompressed", key, 0,
+	                            file, size, originalName)) {
+		return false;
+	}
+	try {
+		// The mapping is private (copy-on-write), so the cache file
+		// itself is never modified and can be shared by processes.
+		auto offset = file.getPos();
+		auto mapping = file.mmap();
+		if (mapping.size() != (offset + size)) return false;
+		decompressed.data = mapping.data() + offset;
+	} catch (FileException&) {
+		return false;
+	}
+	decompressed.mapped = std::move(file);
+	decompressed.size = size;
+	decompressed.originalName = std::move(originalName);
+	return true;
+}
+
 
 CompressedFileAdapter::CompressedFileAdapter(std::unique_ptr<FileBase> file_)
 	: file(std::move(file_)), pos(0)
@@ -42,7 +83,17 @@ void CompressedFileAdapter::decompress()
 		decompressed = *it;
 	} else {
 		decompressed = std::make_shared<Decompressed>();
-		decompress(*file, *decompressed);
+		string key = getPersistentKey(*file);
+		if (!loadPersistent(key, *decompressed)) {
+			decompress(*file, *decompressed);
+			decompressed->data = decompressed->buf.data();
+			if (decompressed->size >= MIN_PERSISTENT_SIZE) {
+				DecodedFileCache::store(
+					"decompressed", key, 0,
+					decompressed->data, decompressed->size,
+					decompressed->originalName);
+			}
+		}
 		decompressed->cachedModificationDate = getModificationDate();
 		decompressed->cachedURL = std::move(url);
 		decompressCache.insert_noDuplicateCheck(decompressed);
@@ -58,8 +109,7 @@ void CompressedFileAdapter::read(void* buffer, size_t num)
 	if (decompressed->size < (pos + num)) {
 		throw FileException("Read beyond end of file");
 	}
-	const auto& buf = decompressed->buf;
-	memcpy(buffer, buf.data() + pos, num);
+	memcpy(buffer, decompressed->data + pos, num);
 	pos += num;
 }
 
@@ -71,7 +121,7 @@ void CompressedFileAdapter::write(const void* /*buffer*/, size_t /*num*/)
 span<uint8_t> CompressedFileAdapter::mmap()
 {
 	decompress();
-	return { decompressed->buf.data(), decompressed->size };
+	return { decompressed->data, decompressed->size };
 }
 
 void CompressedFileAdapter::munmap()
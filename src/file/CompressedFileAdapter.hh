@@ -2,6 +2,7 @@
 #define COMPRESSEDFILEADAPTER_HH
 
 #include "FileBase.hh"
+#include "File.hh"
 #include "MemBuffer.hh"
 #include <memory>
 
@@ -12,6 +13,8 @@ class CompressedFileAdapter : public FileBase
 public:
 	struct Decompressed {
 		MemBuffer<uint8_t> buf;
+		File mapped; // when data comes from the persistent cache
+		uint8_t* data; // points in 'buf' or in the mapping of 'mapped'
 		size_t size;
 		std::string originalName;
 		std::string cachedURL;
@@ -0,0 +1,146 @@
+#include "DecodedFileCache.hh"
+#include "File.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include "ReadDir.hh"
+#include "sha1.hh"
+#include "strCat.hh"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+namespace DecodedFileCache {
+
+// Maximum number of cached files, when more are stored the oldest ones are
+// removed. A typical entry is a decompressed disk image (720kB) or ROM.
+static const size_t MAX_ENTRIES = 256;
+static const char CACHE_MAGIC[8] = { 'd','e','c','c','a','c','h','1' };
+
+struct Header
+{
+	char magic[8];
+	int64_t time;      // modification time of the original file
+	uint64_t size;     // size of the decoded data
+	uint64_t urlSize;  // followed by the url (to detect hash collisions)
+	uint64_t extraSize; // followed by the extra info and the decoded data
+};
+
+// Returns false when the cache is disabled.
+static bool getCacheDir(std::string& dir)
+{
+	if (const char* value = getenv("OPENMSX_DECODED_CACHE")) {
+		dir = value;
+		return !dir.empty();
+	}
+	dir = FileOperations::getUserDataDir() + "/decodedcache";
+	return true;
+}
+
+static std::string getCacheFilename(
+	const std::string& dir, string_view kind, const std::string& url)
+{
+	auto name = strCat(kind, ':', url);
+	auto sum = SHA1::calc(reinterpret_cast<const uint8_t*>(name.data()),
+	                      name.size());
+	return dir + '/' + sum.toString();
+}
+
+bool open(string_view kind, const std::string& url, time_t date,
+          File& file, size_t& size, std::string& extra)
+{
+	std::string dir;
+	if (!getCacheDir(dir)) return false;
+	try {
+		File f(getCacheFilename(dir, kind, url));
+		Header header;
+		f.read(&header, sizeof(header));
+		if ((memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) ||
+		    (header.time != date) ||
+		    (header.urlSize != url.size()) ||
+		    (f.getSize() != (sizeof(header) + header.urlSize +
+		                     header.extraSize + header.size))) {
+			return false; // stale, corrupt or (still) being written
+		}
+		std::string storedUrl(header.urlSize, '\0');
+		f.read(&storedUrl[0], storedUrl.size());
+		if (storedUrl != url) return false;
+		std::string storedExtra(header.extraSize, '\0');
+		f.read(&storedExtra[0], storedExtra.size());
+
+		file = std::move(f);
+		size = header.size;
+		extra = std::move(storedExtra);
+		return true;
+	} catch (FileException&) {
+		return false; // not cached
+	}
+}
+
+// Remove the oldest entries when there are more than MAX_ENTRIES.
+static void cleanup(const std::string& dir)
+{
+	std::vector<std::pair<time_t, std::string>> entries;
+	ReadDir readDir(dir);
+	while (auto* d = readDir.getEntry()) {
+		std::string path = strCat(dir, '/', d->d_name);
+		FileOperations::Stat st;
+		if (FileOperations::getStat(path, st) &&
+		    FileOperations::isRegularFile(st)) {
+			entries.emplace_back(FileOperations::getModificationDate(st),
+			                     std::move(path));
+		}
+	}
+	if (entries.size() <= MAX_ENTRIES) return;
+	auto old = entries.size() - MAX_ENTRIES;
+	std::partial_sort(entries.begin(), entries.begin() + old, entries.end());
+	for (size_t i = 0; i < old; ++i) {
+		FileOperations::unlink(entries[i].second);
+	}
+}
+
+void store(string_view kind, const std::string& url, time_t date,
+           const uint8_t* data, size_t size, string_view extra)
+{
+	Header header;
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.time = date;
+	header.size = size;
+	header.urlSize = url.size();
+	header.extraSize = extra.size();
+	std::string dir;
+	if (!getCacheDir(dir)) return;
+	try {
+		// Write to a temporary file and then rename it, so that other
+		// processes never see a partially written (or truncated) entry.
+		FileOperations::mkdirp(dir);
+		std::string tmpName;
+		auto file = FileOperations::openUniqueFile(dir, tmpName);
+		if (!file) return;
+		auto write = [&](const void* p, size_t n) {
+			return (n == 0) || (fwrite(p, n, 1, file.get()) == 1);
+		};
+		bool ok = write(&header, sizeof(header)) &&
+		          write(url.data(), url.size()) &&
+		          write(extra.data(), extra.size()) &&
+		          write(data, size);
+		ok = (fclose(file.release()) == 0) && ok;
+		auto filename = getCacheFilename(dir, kind, url);
+#ifdef _WIN32
+		FileOperations::unlink(filename); // rename doesn't replace
+#endif
+		if (!ok || (FileOperations::rename(tmpName, filename) != 0)) {
+			FileOperations::unlink(tmpName);
+			return;
+		}
+		cleanup(dir);
+	} catch (FileException&) {
+		// ignore, it's only a cache
+	}
+}
+
+} // namespace DecodedFileCache
+} // namespace openmsx
@@ -0,0 +1,57 @@
+#ifndef DECODEDFILECACHE_HH
+#define DECODEDFILECACHE_HH
+
+#include "string_view.hh"
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+namespace openmsx {
+
+class File;
+
+/** Persistent (on-disk) cache of the decoded content of files, e.g. the
+  * decompressed content of a .gz or .xsa file. So that the (relatively slow)
+  * decoding isn't repeated every time openMSX opens the same file. Entries
+  * are identified by the URL and the modification time of the original
+  * file, plus a 'kind' that tells what decoding was done (the same file can
+  * be decoded in multiple ways, e.g. a .xsa.gz file). Only a limited number
+  * of (the most recently stored) entries is kept. It's also used for other
+  * derived data that is slow to recreate, e.g. linked OpenGL shader programs
+  * (then the 'url' is a key that identifies the input and the date is 0).
+  *
+  * The cache lives in the 'decodedcache' subdirectory of the user data
+  * directory. The OPENMSX_DECODED_CACHE environment variable can point to
+  * another directory (e.g. to share one cache between all processes on a
+  * build server), setting it to an empty value disables the cache. Entries
+  * are never modified in place, so processes can safely map them while
+  * another process replaces or removes them.
+  *
+  * This is only an optimization: all errors are ignored.
+  */
+namespace DecodedFileCache {
+
+	/** Open the cached decoded content of the given file.
+	  * @param kind The kind of decoding.
+	  * @param url The URL of the original file.
+	  * @param date The modification time of the original file.
+	  * @param file Output, positioned at the start of the decoded data.
+	  * @param size Output, the size of the decoded data.
+	  * @param extra Output, extra info that was stored with the data.
+	  * @return true iff found (and valid), only then the outputs are set.
+	  */
+	bool open(string_view kind, const std::string& url, time_t date,
+	          File& file, size_t& size, std::string& extra);
+
+	/** Store the decoded content of the given file in the cache.
+	  * Parameters are the same as for open().
+	  */
+	void store(string_view kind, const std::string& url, time_t date,
+	           const uint8_t* data, size_t size, string_view extra = {});
+
+} // namespace DecodedFileCache
+
+} // namespace openmsx
+
+#endif
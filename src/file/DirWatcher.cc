@@ -0,0 +1,70 @@
+#include "DirWatcher.hh"
+#include "stl.hh"
+#include "systemfuncs.hh"
+#if HAVE_INOTIFY_INIT1
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace openmsx {
+
+DirWatcher::DirWatcher()
+{
+#if HAVE_INOTIFY_INIT1
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	if (fd == -1) failed = true;
+}
+
+DirWatcher::~DirWatcher()
+{
+#if HAVE_INOTIFY_INIT1
+	if (fd != -1) close(fd); // also removes all watches
+#endif
+}
+
+void DirWatcher::addDirectory(const std::string& directory)
+{
+#if HAVE_INOTIFY_INIT1
+	if (failed) return;
+	int wd = inotify_add_watch(fd, directory.c_str(),
+		IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+		IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF |
+		IN_ONLYDIR);
+	if (wd == -1) {
+		failed = true;
+	} else if (!contains(watches, wd)) {
+		watches.push_back(wd);
+	}
+#else
+	(void)directory;
+#endif
+}
+
+void DirWatcher::readEvents()
+{
+#if HAVE_INOTIFY_INIT1
+	// Only the presence of events matters (this includes IN_Q_OVERFLOW),
+	// so simply drain them all.
+	alignas(struct inotify_event) char buf[4096];
+	while (read(fd, buf, sizeof(buf)) > 0) {
+		changed = true;
+	}
+#endif
+}
+
+bool DirWatcher::hasChanged()
+{
+	if (failed) return true;
+	readEvents();
+	return changed;
+}
+
+void DirWatcher::resetChanged()
+{
+	if (failed) return;
+	readEvents();
+	changed = false;
+}
+
+} // namespace openmsx
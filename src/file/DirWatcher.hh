@@ -0,0 +1,49 @@
+#ifndef DIRWATCHER_HH
+#define DIRWATCHER_HH
+
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/**
+ * Detects changes (files created, deleted, modified, renamed, ...) in a set
+ * of host directories. Subdirectories must be added separately.
+ *
+ * Uses inotify where available. On other platforms, or when watching fails
+ * (e.g. the inotify watch limit is reached), hasChanged() always returns
+ * true, so users can fall back to scanning the directories themselves.
+ */
+class DirWatcher
+{
+public:
+	DirWatcher(const DirWatcher&) = delete;
+	DirWatcher& operator=(const DirWatcher&) = delete;
+
+	DirWatcher();
+	~DirWatcher();
+
+	/** Start watching the given directory (not recursive). Adding an
+	  * already watched directory again is allowed (and cheap). Removed
+	  * directories are automatically no longer watched.
+	  */
+	void addDirectory(const std::string& directory);
+
+	/** Did anything change in the watched directories since the last
+	  * resetChanged() call?
+	  */
+	bool hasChanged();
+	void resetChanged();
+
+private:
+	void readEvents();
+
+	int fd = -1;
+	std::vector<int> watches;
+	bool changed = false;
+	bool failed = false;
+};
+
+} // namespace openmsx
+
+#endif
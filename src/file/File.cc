@@ -2,6 +2,7 @@
 #include "Filename.hh"
 #include "LocalFile.hh"
 #include "GZFileAdapter.hh"
+#include "Instrumentation.hh"
 #include "ZipFileAdapter.hh"
 #include "checked_cast.hh"
 #include <cstring>
@@ -17,6 +18,7 @@ static std::unique_ptr<FileBase> init(string_view filename, File::OpenMode mode)
 {
 	static const uint8_t GZ_HEADER[3]  = { 0x1F, 0x8B, 0x08 };
 	static const uint8_t ZIP_HEADER[4] = { 0x50, 0x4B, 0x03, 0x04 };
+	INSTRUMENT_ZONE("File::open");
 
 	std::unique_ptr<FileBase> file = std::make_unique<LocalFile>(filename, mode);
 	if (file->getSize() >= 4) {
@@ -82,16 +84,19 @@ void File::close()
 
 void File::read(void* buffer, size_t num)
 {
+	INSTRUMENT_ZONE("File::read");
 	file->read(buffer, num);
 }
 
 void File::write(const void* buffer, size_t num)
 {
+	INSTRUMENT_ZONE("File::write");
 	file->write(buffer, num);
 }
 
 span<uint8_t> File::mmap()
 {
+	INSTRUMENT_ZONE("File::mmap");
 	return file->mmap();
 }
 
@@ -100,6 +105,16 @@ void File::munmap()
 	file->munmap();
 }
 
+span<const uint8_t> File::mmapShared()
+{
+	return file->mmapShared();
+}
+
+void File::readAhead(size_t pos)
+{
+	file->readAhead(pos);
+}
+
 size_t File::getSize()
 {
 	return file->getSize();
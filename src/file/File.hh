@@ -89,6 +89,25 @@ public:
 	 */
 	void munmap();
 
+	/** Map file in memory, read-only and shared. Unlike mmap() this is
+	 * not a private copy: data that is later written via write() is
+	 * visible in the mapped memory (after a flush()). So this allows to
+	 * replace seek()+read() with a memcpy() from the mapped block.
+	 * The mapping stays valid until the file is closed or truncated.
+	 * @result Pointer/size to/of memory block, or an empty block when
+	 *         this isn't possible (e.g. for compressed files, or when
+	 *         the address space is too small). Callers should then
+	 *         fall back to read().
+	 */
+	span<const uint8_t> mmapShared();
+
+	/** Hint that the file is being read at the given position, so that
+	 * the data after it can be read into the OS cache in the background
+	 * (see PreCacheFile). Cheap enough to call on every access, also
+	 * for accesses via mmapShared(). Does nothing for compressed files.
+	 */
+	void readAhead(size_t pos);
+
 	/** Returns the size of this file
 	 * @result The size of this file
 	 * @throws FileException
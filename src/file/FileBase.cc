@@ -28,6 +28,15 @@ void FileBase::munmap()
 	mmapBuf.clear();
 }
 
+span<const uint8_t> FileBase::mmapShared()
+{
+	return {static_cast<const uint8_t*>(nullptr), size_t(0)};
+}
+
+void FileBase::readAhead(size_t /*pos*/)
+{
+}
+
 void FileBase::truncate(size_t newSize)
 {
 	auto oldSize = getSize();
@@ -20,6 +20,10 @@ public:
 	// your destructor.
 	virtual span<uint8_t> mmap();
 	virtual void munmap();
+	// Default implementation returns an empty block (not supported).
+	virtual span<const uint8_t> mmapShared();
+	// Default implementation does nothing.
+	virtual void readAhead(size_t pos);
 
 	virtual size_t getSize() = 0;
 	virtual void seek(size_t pos) = 0;
@@ -297,6 +297,15 @@ int rmdir(const std::string& path)
 #endif
 }
 
+int rename(const std::string& oldPath, const std::string& newPath)
+{
+#ifdef _WIN32
+	return _wrename(utf8to16(oldPath).c_str(), utf8to16(newPath).c_str());
+#else
+	return ::rename(oldPath.c_str(), newPath.c_str());
+#endif
+}
+
 #ifdef _WIN32
 int deleteRecursive(const std::string& path)
 {
@@ -61,6 +61,12 @@ namespace FileOperations {
 	 */
 	int rmdir(const std::string& path);
 
+	/**
+	 * Call rename() in a platform-independent manner. On POSIX systems an
+	 * existing 'newPath' is atomically replaced, on Windows this fails.
+	 */
+	int rename(const std::string& oldPath, const std::string& newPath);
+
 	/** Recurively delete a file or directory and (in case of a directory)
 	  * all its sub-components.
 	  */
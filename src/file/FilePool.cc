@@ -14,6 +14,7 @@
 #include "Timer.hh"
 #include "ranges.hh"
 #include "sha1.hh"
+#include <algorithm>
 #include <fstream>
 #include <memory>
 
@@ -87,11 +88,13 @@ void FilePool::insert(const Sha1Sum& sum, time_t time, const string& filename)
 	auto it = ranges::upper_bound(pool, sum, ComparePool());
 	stringBuffer.push_back(filename);
 	pool.emplace(it, sum, time, stringBuffer.back().c_str());
+	filenameIndex[string_view(stringBuffer.back())] = sum;
 	needWrite = true;
 }
 
 void FilePool::remove(Pool::iterator it)
 {
+	filenameIndex.erase(string_view(it->filename));
 	pool.erase(it);
 	needWrite = true;
 }
@@ -104,6 +107,7 @@ void FilePool::remove(Pool::iterator it)
 bool FilePool::adjust(Pool::iterator it, const Sha1Sum& newSum)
 {
 	needWrite = true;
+	filenameIndex[string_view(it->filename)] = newSum;
 	auto newIt = ranges::upper_bound(pool, newSum, ComparePool());
 	it->sum = newSum; // update sum
 	if (newIt > it) {
@@ -208,6 +212,14 @@ void FilePool::readSha1sums()
 		// safety mechanism.
 		ranges::sort(pool, ComparePool());
 	}
+
+	// Build the filename index. A file should only be listed once. If not
+	// (again only possible when manually edited), drop the duplicates.
+	filenameIndex.reserve(unsigned(pool.size()));
+	pool.erase(std::remove_if(begin(pool), end(pool), [&](const PoolEntry& e) {
+			return !filenameIndex.emplace(e.filename, e.sum).second;
+		}),
+		end(pool));
 }
 
 void FilePool::writeSha1sums()
@@ -427,35 +439,50 @@ File FilePool::scanDirectory(
 	const Sha1Sum& sha1sum, const string& directory, const string& poolPath,
 	ScanProgress& progress)
 {
-	ReadDir dir(directory);
-	while (dirent* d = dir.getEntry()) {
-		if (quit) {
-			// Scanning can take a long time. Allow to exit
-			// openmsx when it takes too long. Stop scanning
-			// by pretending we didn't find the file.
-			return File();
-		}
-		string file = d->d_name;
-		string path = strCat(directory, '/', file);
-		FileOperations::Stat st;
-		if (FileOperations::getStat(path, st)) {
-			File result;
-			if (FileOperations::isRegularFile(st)) {
-				result = scanFile(sha1sum, path, st, poolPath, progress);
-			} else if (FileOperations::isDirectory(st)) {
-				if ((file != ".") && (file != "..")) {
-					result = scanDirectory(sha1sum, path, poolPath, progress);
+	// First check the files in this directory, then the subdirectories.
+	// Files that are not yet in the database (or outdated) are collected
+	// and hashed together, in parallel.
+	vector<string> subDirs;
+	vector<PendingFile> pending;
+	{
+		ReadDir dir(directory);
+		while (dirent* d = dir.getEntry()) {
+			if (quit) {
+				// Scanning can take a long time. Allow to exit
+				// openmsx when it takes too long. Stop scanning
+				// by pretending we didn't find the file.
+				return File();
+			}
+			string file = d->d_name;
+			string path = strCat(directory, '/', file);
+			FileOperations::Stat st;
+			if (FileOperations::getStat(path, st)) {
+				if (FileOperations::isRegularFile(st)) {
+					File result = scanFile(sha1sum, path, st, poolPath,
+					                       progress, pending);
+					if (result.is_open()) return result;
+				} else if (FileOperations::isDirectory(st)) {
+					if ((file != ".") && (file != "..")) {
+						subDirs.push_back(std::move(path));
+					}
 				}
 			}
-			if (result.is_open()) return result;
 		}
 	}
+	File result = hashFiles(sha1sum, pending);
+	if (result.is_open()) return result;
+
+	for (auto& subDir : subDirs) {
+		if (quit) return File();
+		result = scanDirectory(sha1sum, subDir, poolPath, progress);
+		if (result.is_open()) return result;
+	}
 	return File(); // not found
 }
 
 File FilePool::scanFile(const Sha1Sum& sha1sum, const string& filename,
                         const FileOperations::Stat& st, const string& poolPath,
-                        ScanProgress& progress)
+                        ScanProgress& progress, vector<PendingFile>& pending)
 {
 	++progress.amountScanned;
 	// Periodically send a progress message with the current filename
@@ -473,73 +500,106 @@ File FilePool::scanFile(const Sha1Sum& sha1sum, const string& filename,
 	// Note: do NOT call 'reactor.getEventDistributor().deliverEvents()'.
 	// See comment in ReverseManager::goTo() for more details.
 
+	auto time = FileOperations::getModificationDate(st);
 	auto it = findInDatabase(filename);
-	if (it == end(pool)) {
-		// not in pool
-		try {
-			File file(filename);
-			auto sum = calcSha1sum(file, reactor);
-			auto time = FileOperations::getModificationDate(st);
-			insert(sum, time, filename);
-			if (sum == sha1sum) {
-				return file;
+	if ((it != end(pool)) && (it->time == time)) {
+		// already in pool and db is still up to date
+		assert(filename == it->filename);
+		if (it->sum == sha1sum) {
+			try {
+				return File(filename);
+			} catch (FileException&) {
+				// error reading file, remove from db
+				remove(it);
 			}
-		} catch (FileException&) {
-			// ignore
 		}
 	} else {
-		// already in pool
-		assert(filename == it->filename);
-		assert(it->time != time_t(-1));
-		try {
-			auto time = FileOperations::getModificationDate(st);
-			if (it->time == time) {
-				// db is still up to date
-				if (it->sum == sha1sum) {
-					return File(filename);
-				}
+		// not in pool or db outdated, calculate sha1sum later
+		pending.push_back(PendingFile{filename, time});
+	}
+	return File(); // not found
+}
+
+// Calculate the sha1sums of the given files and store them in the database.
+// Returns the (first) file with the requested sha1sum, if any.
+File FilePool::hashFiles(const Sha1Sum& sha1sum, const vector<PendingFile>& pending)
+{
+	// Process the files in batches, to limit the number of open files.
+	static const size_t BATCH_SIZE = 64;
+	struct Job {
+		File file;
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+		Sha1Sum sum;
+		bool ok = false;
+	};
+	File found;
+	for (size_t start = 0; start < pending.size(); start += BATCH_SIZE) {
+		if (quit) break;
+		size_t num = std::min(BATCH_SIZE, pending.size() - start);
+		vector<Job> jobs(num);
+		for (size_t i = 0; i < num; ++i) {
+			try {
+				jobs[i].file = File(pending[start + i].filename);
+				// Do mmap() in this thread, e.g. decompressing
+				// gzipped files is not thread-safe.
+				auto data = jobs[i].file.mmap();
+				jobs[i].data = data.data();
+				jobs[i].size = data.size();
+				jobs[i].ok = true;
+			} catch (FileException&) {
+				// ignore
+			}
+		}
+		workers.parallelFor(num, [&](size_t i) {
+			auto& job = jobs[i];
+			if (!job.ok) return;
+			SHA1 sha1;
+			sha1.update(job.data, job.size);
+			job.sum = sha1.digest();
+		});
+		for (size_t i = 0; i < num; ++i) {
+			auto& p = pending[start + i];
+			auto it = findInDatabase(p.filename);
+			if (!jobs[i].ok) {
+				// error reading file, remove from db
+				if (it != end(pool)) remove(it);
+				continue;
+			}
+			if (it == end(pool)) {
+				insert(jobs[i].sum, p.time, p.filename);
 			} else {
-				// db outdated
-				File file(filename);
-				auto sum = calcSha1sum(file, reactor);
-				it->setTime(time);
-				adjust(it, sum);
-				if (sum == sha1sum) {
-					return file;
-				}
+				it->setTime(p.time);
+				adjust(it, jobs[i].sum);
+			}
+			if (!found.is_open() && (jobs[i].sum == sha1sum)) {
+				found = std::move(jobs[i].file);
 			}
-		} catch (FileException&) {
-			// error reading file, remove from db
-			remove(it);
 		}
+		if (found.is_open()) break;
 	}
-	return File(); // not found
+	return found;
 }
 
-FilePool::Pool::iterator FilePool::findInDatabase(const string& filename)
+FilePool::Pool::iterator FilePool::findInDatabase(string_view filename)
 {
-	// Linear search in pool for filename.
-	// Search from back to front because often, soon after this search, we
-	// will insert/remove an element from the vector. This requires
-	// shifting all elements in the vector starting from a certain
-	// position. Starting the search from the back increases the likelihood
-	// that the to-be-shifted elements are already in the memory cache.
-	auto i = pool.size();
-	while (i) {
-		--i;
-		auto it = begin(pool) + i;
+	auto* sum = lookup(filenameIndex, filename);
+	if (!sum) return end(pool); // not found
+
+	auto bound = ranges::equal_range(pool, *sum, ComparePool());
+	for (auto it = bound.first; it != bound.second; ++it) {
 		if (it->filename == filename) {
 			// ensure 'time' is valid
 			if (it->getTime() == time_t(-1)) {
 				// invalid time/date format, remove from db
-				// and continue searching
-				pool.erase(it);
-				continue;
+				remove(it);
+				return end(pool);
 			}
 			return it;
 		}
 	}
-	return end(pool); // not found
+	assert(false); // filenameIndex is out of sync with pool
+	return end(pool);
 }
 
 Sha1Sum FilePool::getSha1Sum(File& file)
@@ -568,6 +628,51 @@ Sha1Sum FilePool::getSha1Sum(File& file)
 	return sum;
 }
 
+void FilePool::calcSha1Sums(span<File> files)
+{
+	struct Job {
+		std::string filename;
+		time_t time;
+		const uint8_t* data;
+		size_t size;
+		Sha1Sum sum;
+	};
+	vector<Job> jobs;
+	for (auto& file : files) {
+		try {
+			auto time = file.getModificationDate();
+			auto filename = file.getURL();
+			auto it = findInDatabase(filename);
+			if ((it != end(pool)) && (it->time == time)) continue;
+			if (ranges::any_of(jobs, [&](const Job& j) {
+				return j.filename == filename; })) continue;
+			// Do mmap() in this thread, see hashFiles().
+			auto data = file.mmap();
+			jobs.push_back({std::move(filename), time,
+			                data.data(), data.size(), Sha1Sum()});
+		} catch (FileException&) {
+			// ignore, reported later (if needed)
+		}
+	}
+	// Page faults on the mapped files happen in the worker threads, so
+	// this also reads the files in parallel.
+	workers.parallelFor(jobs.size(), [&](size_t i) {
+		auto& job = jobs[i];
+		SHA1 sha1;
+		sha1.update(job.data, job.size);
+		job.sum = sha1.digest();
+	});
+	for (auto& job : jobs) {
+		auto it = findInDatabase(job.filename);
+		if (it == end(pool)) {
+			insert(job.sum, job.time, job.filename);
+		} else {
+			it->setTime(job.time);
+			adjust(it, job.sum);
+		}
+	}
+}
+
 int FilePool::signalEvent(const std::shared_ptr<const Event>& event)
 {
 	(void)event; // avoid warning for non-assert compiles
@@ -6,10 +6,16 @@
 #include "Observer.hh"
 #include "EventListener.hh"
 #include "MemBuffer.hh"
+#include "WorkerPool.hh"
+#include "hash_map.hh"
 #include "sha1.hh"
+#include "span.hh"
+#include "string_view.hh"
+#include "xxhash.hh"
 #include <cassert>
 #include <cstdint>
 #include <ctime>
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
@@ -43,6 +49,12 @@ public:
 	 */
 	Sha1Sum getSha1Sum(File& file);
 
+	/** Calculate the sha1sums of all given files that are not yet in the
+	 * cache (or that changed), in parallel. Afterwards getSha1Sum() is
+	 * cheap for these files. Files that can't be read are skipped.
+	 */
+	void calcSha1Sums(span<File> files);
+
 private:
 	struct ScanProgress {
 		uint64_t lastTime;
@@ -89,6 +101,12 @@ private:
 	};
 	using Pool = std::vector<PoolEntry>; // sorted with 'ComparePool'
 
+	// A file found while scanning that needs a (new) sha1sum.
+	struct PendingFile {
+		std::string filename;
+		time_t time;
+	};
+
 	void insert(const Sha1Sum& sum, time_t time, const std::string& filename);
 	void remove(Pool::iterator it);
 	bool adjust(Pool::iterator it, const Sha1Sum& newSum);
@@ -105,8 +123,11 @@ private:
 	              const std::string& filename,
 	              const FileOperations::Stat& st,
 	              const std::string& poolPath,
-	              ScanProgress& progress);
-	Pool::iterator findInDatabase(const std::string& filename);
+	              ScanProgress& progress,
+	              std::vector<PendingFile>& pending);
+	File hashFiles(const Sha1Sum& sha1sum,
+	               const std::vector<PendingFile>& pending);
+	Pool::iterator findInDatabase(string_view filename);
 
 	Directories getDirectories() const;
 
@@ -121,9 +142,13 @@ private:
 	Reactor& reactor;
 	std::unique_ptr<Sha1SumCommand> sha1SumCommand;
 	MemBuffer<char> fileMem; // content of initial .filecache
-	std::vector<std::string> stringBuffer; // owns strings that are not in 'fileMem'
+	std::deque<std::string> stringBuffer; // owns strings that are not in 'fileMem'
 
 	Pool pool;
+	// For each filename in 'pool' its sha1sum, to quickly find the entry.
+	hash_map<string_view, Sha1Sum, XXHasher> filenameIndex;
+	// Used to calculate sha1sums in parallel.
+	WorkerPool workers;
 	bool quit;
 	bool needWrite;
 };
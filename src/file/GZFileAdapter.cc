@@ -1,6 +1,7 @@
 #include "GZFileAdapter.hh"
 #include "ZlibInflate.hh"
 #include "FileException.hh"
+#include <algorithm>
 
 namespace openmsx {
 
@@ -55,11 +56,21 @@ static bool skipHeader(ZlibInflate& zlib, std::string& originalName)
 
 void GZFileAdapter::decompress(FileBase& f, Decompressed& d)
 {
-	ZlibInflate zlib(f.mmap());
+	auto data = f.mmap();
+	ZlibInflate zlib(data);
 	if (!skipHeader(zlib, d.originalName)) {
 		throw FileException("Not a gzip header");
 	}
-	d.size = zlib.inflate(d.buf);
+	// The gzip trailer contains the uncompressed size (modulo 2^32), use
+	// that as initial buffer size. Deflate can't compress more than about
+	// 1:1032, so a corrupt trailer can't make us allocate a huge buffer.
+	size_t sizeHint = 65536;
+	if (data.size() >= 18) {
+		auto* p = data.data() + data.size() - 4;
+		size_t isize = p[0] | (p[1] << 8) | (p[2] << 16) | (size_t(p[3]) << 24);
+		sizeHint = std::min(isize, 1032 * data.size());
+	}
+	d.size = zlib.inflate(d.buf, sizeHint);
 }
 
 } // namespace openmsx
@@ -95,12 +95,40 @@ LocalFile::LocalFile(string_view filename_, const char* mode)
 LocalFile::~LocalFile()
 {
 	munmap();
+#if HAVE_MMAP || defined _WIN32
+	munmapShared();
+#endif
 }
 
+// Whole files are only pre-cached when they are small (e.g. disk images),
+// bigger files (e.g. harddisk and CD-ROM images) only around the position
+// where they are read.
+static const size_t PRE_CACHE_LIMIT = 4 * 1024 * 1024;
+static const size_t READ_AHEAD_WINDOW = 2 * 1024 * 1024;
+
 void LocalFile::preCacheFile()
 {
-	cache = std::make_unique<PreCacheFile>(
-		FileOperations::getNativePath(filename));
+	auto size = getSize();
+	if (size <= PRE_CACHE_LIMIT) {
+		PreCacheFile::request(FileOperations::getNativePath(filename), 0, size);
+		readAheadPos = 0;
+		readAheadDone = true;
+	}
+}
+
+void LocalFile::readAhead(size_t pos)
+{
+	// Only request a new window when 'pos' is outside the first half of
+	// the previous one, so that the next window is requested well before
+	// the reads reach the end of the previous one.
+	if (readAheadDone && (pos >= readAheadPos) &&
+	    ((pos - readAheadPos) < (READ_AHEAD_WINDOW / 2))) {
+		return;
+	}
+	readAheadPos = pos;
+	readAheadDone = true;
+	PreCacheFile::request(FileOperations::getNativePath(filename),
+	                      pos, READ_AHEAD_WINDOW);
 }
 
 void LocalFile::read(void* buffer, size_t num)
@@ -179,6 +207,47 @@ void LocalFile::munmap()
 	}
 }
 
+span<const uint8_t> LocalFile::mmapShared()
+{
+	if (!smem) {
+		size_t size = getSize();
+		if (size == 0) return {smem, size_t(0)};
+
+		if (smemFailed) return {smem, size_t(0)};
+		smemFailed = true; // until proven otherwise
+
+		int fd = _fileno(file.get());
+		if (fd == -1) return {smem, size_t(0)};
+		auto hFile = reinterpret_cast<HANDLE>(_get_osfhandle(fd)); // No need to close
+		if (hFile == INVALID_HANDLE_VALUE) return {smem, size_t(0)};
+		assert(!hSmap);
+		hSmap = CreateFileMapping(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!hSmap) return {smem, size_t(0)};
+		smem = static_cast<const uint8_t*>(MapViewOfFile(hSmap, FILE_MAP_READ, 0, 0, 0));
+		if (!smem) {
+			CloseHandle(hSmap);
+			hSmap = nullptr;
+			return {smem, size_t(0)};
+		}
+		smemSize = size;
+		smemFailed = false;
+	}
+	return {smem, smemSize};
+}
+
+void LocalFile::munmapShared()
+{
+	if (smem) {
+		// read-only mapping, so there are no dirty pages to write back
+		UnmapViewOfFile(smem);
+		smem = nullptr;
+	}
+	if (hSmap) {
+		CloseHandle(hSmap);
+		hSmap = nullptr;
+	}
+}
+
 #elif HAVE_MMAP
 span<uint8_t> LocalFile::mmap()
 {
@@ -211,6 +280,34 @@ void LocalFile::munmap()
 		mmem = nullptr;
 	}
 }
+
+span<const uint8_t> LocalFile::mmapShared()
+{
+	if (!smem) {
+		size_t size = getSize();
+		if ((size == 0) || smemFailed) return {smem, size_t(0)};
+
+		void* m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED,
+		                 fileno(file.get()), 0);
+		auto MY_MAP_FAILED = reinterpret_cast<void*>(-1);
+		if (m == MY_MAP_FAILED) {
+			// e.g. not enough address space on 32-bit systems
+			smemFailed = true;
+			return {smem, size_t(0)};
+		}
+		smem = static_cast<const uint8_t*>(m);
+		smemSize = size;
+	}
+	return {smem, smemSize};
+}
+
+void LocalFile::munmapShared()
+{
+	if (smem) {
+		::munmap(const_cast<uint8_t*>(smem), smemSize);
+		smem = nullptr;
+	}
+}
 #endif
 
 size_t LocalFile::getSize()
@@ -256,6 +353,10 @@ size_t LocalFile::getPos()
 #if HAVE_FTRUNCATE
 void LocalFile::truncate(size_t size)
 {
+#if HAVE_MMAP || defined _WIN32
+	munmapShared(); // mapping has the old size
+	smemFailed = false;
+#endif
 	int fd = fileno(file.get());
 	if (ftruncate(fd, size)) {
 		throw FileException("Error truncating file");
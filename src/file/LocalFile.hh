@@ -13,8 +13,6 @@
 
 namespace openmsx {
 
-class PreCacheFile;
-
 class LocalFile final : public FileBase
 {
 public:
@@ -26,7 +24,9 @@ public:
 #if HAVE_MMAP || defined _WIN32
 	span<uint8_t> mmap() override;
 	void munmap() override;
+	span<const uint8_t> mmapShared() override;
 #endif
+	void readAhead(size_t pos) override;
 	size_t getSize() override;
 	void seek(size_t pos) override;
 	size_t getPos() override;
@@ -42,6 +42,10 @@ public:
 	void preCacheFile();
 
 private:
+#if HAVE_MMAP || defined _WIN32
+	void munmapShared();
+#endif
+
 	std::string filename;
 	FileOperations::FILE_t file;
 #if HAVE_MMAP
@@ -50,8 +54,16 @@ private:
 #if defined _WIN32
 	uint8_t* mmem;
 	HANDLE hMmap;
+	HANDLE hSmap = nullptr;
+#endif
+#if HAVE_MMAP || defined _WIN32
+	// shared (read-only) mapping, see mmapShared()
+	const uint8_t* smem = nullptr;
+	size_t smemSize = 0;
+	bool smemFailed = false; // don't retry on every call
 #endif
-	std::unique_ptr<PreCacheFile> cache;
+	size_t readAheadPos = 0; // start of the last readAhead() request
+	bool readAheadDone = false;
 	bool readOnly;
 };
 
@@ -1,24 +1,29 @@
 #include "PreCacheFile.hh"
 #include "FileOperations.hh"
+#include "WorkerThread.hh"
 #include "statp.hh"
+#include "systemfuncs.hh"
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <fcntl.h>
 #include <sys/types.h>
 
 namespace openmsx {
+namespace PreCacheFile {
 
-PreCacheFile::PreCacheFile(std::string name_)
-	: name(std::move(name_)), exitLoop(false)
-{
-	thread = std::thread([this]() { run(); });
-}
+// Pre-caching is only a hint, it's fine to drop requests when the device
+// can't keep up (e.g. many sector reads while a CD-ROM spins up).
+static const unsigned MAX_PENDING = 16;
+static std::atomic<unsigned> pending(0);
 
-PreCacheFile::~PreCacheFile()
+static WorkerThread& getWorker()
 {
-	exitLoop = true;
-	thread.join();
+	static WorkerThread worker;
+	return worker;
 }
 
-void PreCacheFile::run()
+static void execute(const std::string& name, size_t offset, size_t size)
 {
 	struct stat st;
 	if (stat(name.c_str(), &st)) return;
@@ -30,37 +35,38 @@ void PreCacheFile::run()
 	auto file = FileOperations::openFile(name, "rb");
 	if (!file) return;
 
-	fseek(file.get(), 0, SEEK_END);
-	auto size = ftell(file.get());
-	if (size < 1024 * 1024) {
-		// only pre-cache small files
-
-		const size_t BLOCK_SIZE = 4096;
-		unsigned block = 0;
-		unsigned repeat = 0;
-		while (true) {
-			if (exitLoop) break;
-
-			char buf[BLOCK_SIZE];
-			if (fseek(file.get(), block * BLOCK_SIZE, SEEK_SET)) break;
-			size_t read = fread(buf, 1, BLOCK_SIZE, file.get());
-			if (read != BLOCK_SIZE) {
-				// error or end-of-file reached,
-				// in both cases stop pre-caching
-				break;
-			}
-
-			// Just reading a file linearly from front to back
-			// makes Linux classify the read as a 'streaming read'.
-			// Linux doesn't cache those. To avoid this we read
-			// some of the blocks twice.
-			if (repeat != 0) {
-				--repeat; ++block;
-			} else {
-				repeat = 5;
-			}
-		}
+#if HAVE_POSIX_FADVISE
+	// Only a hint, the OS reads the data asynchronously. The hint
+	// stays in effect after the file is closed (it's about the cache).
+	posix_fadvise(fileno(file.get()), off_t(offset), off_t(size),
+	              POSIX_FADV_WILLNEED);
+#else
+	// Read in big blocks and discard the result.
+	const size_t BLOCK_SIZE = 64 * 1024;
+	static char buf[BLOCK_SIZE]; // only used by the (single) worker thread
+#if defined _WIN32
+	if (_fseeki64(file.get(), offset, SEEK_SET)) return;
+#else
+	if (fseek(file.get(), offset, SEEK_SET)) return;
+#endif
+	while (size) {
+		size_t read = fread(buf, 1, std::min(size, BLOCK_SIZE), file.get());
+		if (read == 0) break; // error or end-of-file
+		size -= std::min(read, size);
 	}
+#endif
+}
+
+void request(std::string name, size_t offset, size_t size)
+{
+	if (size == 0) return;
+	if (pending >= MAX_PENDING) return;
+	++pending;
+	getWorker().push([name = std::move(name), offset, size] {
+		execute(name, offset, size);
+		--pending;
+	});
 }
 
+} // namespace PreCacheFile
 } // namespace openmsx
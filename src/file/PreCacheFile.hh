@@ -1,31 +1,33 @@
 #ifndef PRECACHEFILE_HH
 #define PRECACHEFILE_HH
 
-#include <atomic>
+#include <cstddef>
 #include <string>
-#include <thread>
 
 namespace openmsx {
 
 /**
- * Read the complete file once and discard result. Hopefully the file
- * sticks in the OS cache. Mainly useful to avoid CDROM spinups or to
- * speed up real floppy disk (/dev/fd0) reads.
+ * Ask the OS to read (part of) a file into its cache in the background, so
+ * that the reads that follow don't have to wait for the device. Mainly
+ * useful to avoid CDROM spinups, for images on slow (network) drives, or
+ * to speed up real floppy disk (/dev/fd0) reads.
+ *
+ * All requests are handled by one shared background thread. Where
+ * available this only passes a hint to the OS (posix_fadvise(WILLNEED)),
+ * the OS then does the actual reading asynchronously. Elsewhere the data is
+ * read and discarded.
  */
-class PreCacheFile final
-{
-public:
-	explicit PreCacheFile(std::string name);
-	~PreCacheFile();
+namespace PreCacheFile {
 
-private:
-	void run();
-
-	const std::string name;
-	std::thread thread;
-	std::atomic<bool> exitLoop;
-};
+/** Pre-cache the bytes [offset, offset + size) of the given file (native
+  * path). The file is opened separately, so the caller's file position
+  * isn't affected and the caller may close its file at any time. Requests
+  * for non regular files (e.g. /dev/fd0) are ignored, and so are requests
+  * while many others are still pending.
+  */
+void request(std::string name, size_t offset, size_t size);
 
+} // namespace PreCacheFile
 } // namespace openmsx
 
 #endif
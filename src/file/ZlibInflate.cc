@@ -1,10 +1,31 @@
 #include "ZlibInflate.hh"
 #include "FileException.hh"
 #include "MemBuffer.hh"
+#include <algorithm>
+#include <cstring>
 #include <limits>
+#include <memory>
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
 
 namespace openmsx {
 
+#ifdef HAVE_LIBDEFLATE
+struct DecompressorDeleter {
+	void operator()(libdeflate_decompressor* d) const {
+		libdeflate_free_decompressor(d);
+	}
+};
+#else
+// zlib takes the output size as a 32-bit number, bigger buffers are filled
+// in several steps.
+static uInt clampAvail(size_t size)
+{
+	return uInt(std::min<size_t>(size, std::numeric_limits<uInt>::max()));
+}
+#endif
+
 ZlibInflate::ZlibInflate(span<uint8_t> input)
 {
 	if (input.size() > std::numeric_limits<decltype(s.avail_in)>::max()) {
@@ -81,6 +102,29 @@ std::string ZlibInflate::getCString()
 
 size_t ZlibInflate::inflate(MemBuffer<uint8_t>& output, size_t sizeHint)
 {
+	size_t outSize = std::max<size_t>(sizeHint, 1024);
+#ifdef HAVE_LIBDEFLATE
+	std::unique_ptr<libdeflate_decompressor, DecompressorDeleter> d(
+		libdeflate_alloc_decompressor());
+	if (!d) {
+		throw FileException("Error initializing inflate struct.");
+	}
+	while (true) {
+		output.resize(outSize);
+		size_t actual;
+		auto r = libdeflate_deflate_decompress(
+			d.get(), s.next_in, s.avail_in,
+			output.data(), outSize, &actual);
+		if (r == LIBDEFLATE_SUCCESS) {
+			output.resize(actual);
+			return actual;
+		}
+		if (r != LIBDEFLATE_INSUFFICIENT_SPACE) {
+			throw FileException("Error decompressing gzip: corrupt data");
+		}
+		outSize *= 2; // the hint was too small, retry with a bigger buffer
+	}
+#else
 	int initErr = inflateInit2(&s, -MAX_WBITS);
 	if (initErr != Z_OK) {
 		throw FileException(
@@ -88,27 +132,97 @@ size_t ZlibInflate::inflate(MemBuffer<uint8_t>& output, size_t sizeHint)
 	}
 	wasInit = true;
 
-	size_t outSize = sizeHint;
 	output.resize(outSize);
-	s.avail_out = uInt(outSize); // TODO overflow?
 	while (true) {
 		s.next_out = output.data() + s.total_out;
-		int err = ::inflate(&s, Z_NO_FLUSH);
+		s.avail_out = clampAvail(outSize - s.total_out);
+		// Z_FINISH: the whole input is available, this lets zlib
+		// decompress directly into 'output' without going through its
+		// sliding window buffer.
+		int err = ::inflate(&s, Z_FINISH);
 		if (err == Z_STREAM_END) {
 			break;
 		}
-		if (err != Z_OK) {
-			throw FileException("Error decompressing gzip: ", zError(err));
+		if (((err != Z_OK) && (err != Z_BUF_ERROR)) || (s.avail_out != 0)) {
+			// Z_BUF_ERROR with room left means truncated input
+			throw FileException("Error decompressing gzip: ",
+			                    (err == Z_BUF_ERROR) ? "unexpected end of file"
+			                                         : zError(err));
+		}
+		if (s.total_out == outSize) {
+			outSize *= 2; // double buffer size
+			output.resize(outSize);
 		}
-		auto oldSize = outSize;
-		outSize = oldSize * 2; // double buffer size
-		output.resize(outSize);
-		s.avail_out = uInt(outSize - oldSize); // TODO overflow?
 	}
 
 	// set actual size
 	output.resize(s.total_out);
 	return s.total_out;
+#endif
+}
+
+bool ZlibInflate::uncompress(span<const uint8_t> input,
+                             uint8_t* output, size_t outSize)
+{
+#ifdef HAVE_LIBDEFLATE
+	std::unique_ptr<libdeflate_decompressor, DecompressorDeleter> d(
+		libdeflate_alloc_decompressor());
+	// nullptr for 'actual_out_nbytes_ret': the size must match exactly
+	return d && (libdeflate_zlib_decompress(
+			d.get(), input.data(), input.size(),
+			output, outSize, nullptr) == LIBDEFLATE_SUCCESS);
+#else
+	if ((input.size() > std::numeric_limits<uLong>::max()) ||
+	    (outSize > std::numeric_limits<uLongf>::max())) {
+		return false;
+	}
+	auto dstLen = uLongf(outSize);
+	return (::uncompress(output, &dstLen, input.data(), uLong(input.size())) == Z_OK)
+	    && (dstLen == outSize);
+#endif
+}
+
+bool ZlibInflate::uncompress(span<const uint8_t> input,
+                             MemBuffer<uint8_t>& output, size_t& outSize,
+                             size_t sizeHint)
+{
+	size_t capacity = std::max<size_t>(sizeHint, 1024);
+#ifdef HAVE_LIBDEFLATE
+	std::unique_ptr<libdeflate_decompressor, DecompressorDeleter> d(
+		libdeflate_alloc_decompressor());
+	if (!d) return false;
+	while (true) {
+		output.resize(capacity);
+		auto r = libdeflate_zlib_decompress(
+			d.get(), input.data(), input.size(),
+			output.data(), capacity, &outSize);
+		if (r == LIBDEFLATE_SUCCESS) return true;
+		if (r != LIBDEFLATE_INSUFFICIENT_SPACE) return false;
+		capacity *= 2;
+	}
+#else
+	if (input.size() > std::numeric_limits<uInt>::max()) return false;
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if (inflateInit(&zs) != Z_OK) return false;
+	output.resize(capacity);
+	zs.next_in = const_cast<Bytef*>(input.data());
+	zs.avail_in = uInt(input.size());
+	int r;
+	while (true) {
+		zs.next_out = output.data() + zs.total_out;
+		zs.avail_out = clampAvail(capacity - zs.total_out);
+		r = ::inflate(&zs, Z_FINISH);
+		if (((r != Z_OK) && (r != Z_BUF_ERROR)) || (zs.avail_out != 0)) break;
+		if (zs.total_out == capacity) {
+			capacity *= 2;
+			output.resize(capacity);
+		}
+	}
+	outSize = zs.total_out;
+	inflateEnd(&zs);
+	return r == Z_STREAM_END;
+#endif
 }
 
 } // namespace openmsx
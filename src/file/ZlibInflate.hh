@@ -9,6 +9,14 @@
 
 namespace openmsx {
 
+/** Decompression of deflate data (gzip and zip files, savestate blobs).
+  *
+  * When openMSX is built with libdeflate (meson option 'libdeflate') that
+  * is used instead of zlib. libdeflate only decompresses whole buffers, but
+  * is a lot faster. It needs the size of the output upfront, so callers
+  * should pass the size when it's known (e.g. in a zip header) or a good
+  * estimate. A wrong estimate only costs an extra decompression attempt.
+  */
 class ZlibInflate
 {
 public:
@@ -22,8 +30,23 @@ public:
 	std::string getString(size_t len);
 	std::string getCString();
 
+	/** Decompress the remaining input (raw deflate data) into 'output'.
+	  * The buffer starts with 'sizeHint' bytes and grows when needed.
+	  * Returns the decompressed size. */
 	size_t inflate(MemBuffer<uint8_t>& output, size_t sizeHint = 65536);
 
+	/** Decompress a zlib stream (as produced by compress()) of which the
+	  * decompressed size is known. Returns false on errors or when the
+	  * size doesn't match. */
+	static bool uncompress(span<const uint8_t> input,
+	                       uint8_t* output, size_t outSize);
+	/** Same, but the decompressed size is not known upfront, 'sizeHint'
+	  * is the initial size of 'output'. The decompressed size is
+	  * returned in 'outSize'. */
+	static bool uncompress(span<const uint8_t> input,
+	                       MemBuffer<uint8_t>& output, size_t& outSize,
+	                       size_t sizeHint);
+
 private:
 	z_stream s;
 	bool wasInit;
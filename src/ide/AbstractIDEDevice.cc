@@ -160,6 +160,10 @@ void AbstractIDEDevice::writeReg(
 	}
 }
 
+// Note: there's no bulk (span) variant of readData()/writeData(). The CPU
+// executes INIR/LDIR one iteration at a time (each with its own timing), and
+// per word this is only a buffer access. The sectors themselves are read from
+// the image a block at a time, see SectorWriteBack.
 word AbstractIDEDevice::readData(EmuTime::param /*time*/)
 {
 	if (!transferRead) {
@@ -60,7 +60,7 @@ HD::HD(const DeviceConfig& config)
 		filesize = file.getSize();
 	}
 	tigerTree = std::make_unique<TigerTree>(
-		*this, filesize, filename.getResolved());
+		*this, filesize, filename.getResolved(), true);
 
 	(*hdInUse)[id] = true;
 	hdCommand = std::make_unique<HDCommand>(
@@ -75,6 +75,11 @@ HD::HD(const DeviceConfig& config)
 
 HD::~HD()
 {
+	try {
+		flushWrites();
+	} catch (MSXException&) {
+		// ignore
+	}
 	motherBoard.getMSXCliComm().update(CliComm::HARDWARE, name, "remove");
 
 	unsigned id = name[2] - 'a';
@@ -84,11 +89,12 @@ HD::~HD()
 
 void HD::switchImage(const Filename& newFilename)
 {
+	flushWrites();
 	file = File(newFilename);
 	filename = newFilename;
 	filesize = file.getSize();
 	tigerTree = std::make_unique<TigerTree>(*this, filesize,
-			filename.getResolved());
+			filename.getResolved(), true);
 	motherBoard.getMSXCliComm().update(CliComm::MEDIA, getName(),
 	                                   filename.getResolved());
 }
@@ -100,18 +106,25 @@ size_t HD::getNbSectorsImpl() const
 
 void HD::readSectorImpl(size_t sector, SectorBuffer& buf)
 {
-	file.seek(sector * sizeof(buf));
-	file.read(&buf, sizeof(buf));
+	writeBack.read(sector, buf);
 }
 
 void HD::writeSectorImpl(size_t sector, const SectorBuffer& buf)
 {
-	file.seek(sector * sizeof(buf));
-	file.write(&buf, sizeof(buf));
+	writeBack.write(sector, buf);
+	// The modification time only gets its final value once the data is
+	// actually written, flushWrites() updates it.
 	tigerTree->notifyChange(sector * sizeof(buf), sizeof(buf),
 	                        file.getModificationDate());
 }
 
+void HD::flushWrites()
+{
+	if (writeBack.flush() && file.is_open()) {
+		tigerTree->notifyChange(0, 0, file.getModificationDate());
+	}
+}
+
 bool HD::isWriteProtectedImpl() const
 {
 	return file.isReadOnly();
@@ -122,6 +135,7 @@ Sha1Sum HD::getSha1SumImpl(FilePool& filePool)
 	if (hasPatches()) {
 		return SectorAccessibleDisk::getSha1SumImpl(filePool);
 	}
+	flushWrites();
 	return filePool.getSha1Sum(file);
 }
 
@@ -146,6 +160,7 @@ void HD::showProgress(size_t position, size_t maxPosition)
 
 std::string HD::getTigerTreeHash()
 {
+	flushWrites();
 	lastProgressTime = Timer::getTime();
 	everDidProgress = false;
 	auto callback = [this](size_t p, size_t t) { showProgress(p, t); };
@@ -231,6 +246,7 @@ void HD::serialize(Archive& ar, unsigned version)
 			//  - So to get in the same state as the initial
 			//    savestate we again close the file. Otherwise the
 			//    checksum-check code below goes wrong.
+			flushWrites();
 			file.close();
 		} else {
 			tmp.updateAfterLoadState();
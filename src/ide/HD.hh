@@ -4,6 +4,7 @@
 #include "Filename.hh"
 #include "File.hh"
 #include "SectorAccessibleDisk.hh"
+#include "SectorWriteBack.hh"
 #include "DiskContainer.hh"
 #include "TigerTree.hh"
 #include "serialize_meta.hh"
@@ -54,6 +55,7 @@ private:
 	bool isCacheStillValid(time_t& time) override;
 
 	void showProgress(size_t position, size_t maxPosition);
+	void flushWrites();
 
 	MSXMotherBoard& motherBoard;
 	std::string name;
@@ -61,6 +63,7 @@ private:
 	std::unique_ptr<TigerTree> tigerTree;
 
 	File file;
+	SectorWriteBack writeBack{file};
 	Filename filename;
 	size_t filesize;
 
@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 
 using std::string;
@@ -111,8 +112,14 @@ unsigned IDECDROM::readBlockStart(AlignedBuffer& buf, unsigned count)
 	assert(readSectorData);
 	if (file.is_open()) {
 		//fprintf(stderr, "read sector data at %08X\n", transferOffset);
-		file.seek(transferOffset);
-		file.read(buf, count);
+		file.readAhead(transferOffset);
+		auto mapped = file.mmapShared();
+		if ((size_t(transferOffset) + count) <= mapped.size()) {
+			memcpy(buf, mapped.data() + transferOffset, count);
+		} else {
+			file.seek(transferOffset);
+			file.read(buf, count);
+		}
 		transferOffset += count;
 		return count;
 	} else {
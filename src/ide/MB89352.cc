@@ -405,11 +405,28 @@ void MB89352::resetACKREQ()
 	}
 }
 
+// The common case during a data transfer: a byte in the middle of a block.
+// setACKREQ() followed by resetACKREQ() then only moves the byte and leaves
+// REG_PSNS unchanged, do that directly instead of going through all the
+// checks. The last byte of a block still takes the slow path, because then
+// the device must supply the next block (or the phase changes).
+bool MB89352::isFastTransfer(SCSI::Phase dataPhase, byte psns) const
+{
+	return (phase == dataPhase) && (counter > 1) &&
+	       (regs[REG_PSNS] == (PSNS_REQ | PSNS_BSY | psns)) &&
+	       (regs[FIX_PCTL] == psns);
+}
+
 byte MB89352::readDREG()
 {
 	if (isTransfer && (tc > 0)) {
-		setACKREQ(regs[REG_DREG]);
-		resetACKREQ();
+		if (isFastTransfer(SCSI::DATA_IN, PSNS_DATAIN)) {
+			regs[REG_DREG] = buffer[bufIdx++];
+			--counter;
+		} else {
+			setACKREQ(regs[REG_DREG]);
+			resetACKREQ();
+		}
 
 		--tc;
 		if (tc == 0) {
@@ -426,8 +443,13 @@ byte MB89352::readDREG()
 void MB89352::writeDREG(byte value)
 {
 	if (isTransfer && (tc > 0)) {
-		setACKREQ(value);
-		resetACKREQ();
+		if (isFastTransfer(SCSI::DATA_OUT, PSNS_DATAOUT)) {
+			buffer[bufIdx++] = value;
+			--counter;
+		} else {
+			setACKREQ(value);
+			resetACKREQ();
+		}
 
 		--tc;
 		if (tc == 0) {
@@ -41,6 +41,7 @@ private:
 	void softReset();
 	void setACKREQ(byte& value);
 	void resetACKREQ();
+	bool isFastTransfer(SCSI::Phase dataPhase, byte psns) const;
 	byte getSSTS() const;
 
 	std::unique_ptr<SCSIDevice> dev[8];
@@ -6,6 +6,7 @@
 #include "MSXEventDistributor.hh"
 #include "StateChangeDistributor.hh"
 #include "MSXMotherBoard.hh"
+#include "MSXCPUInterface.hh"
 #include "ReverseManager.hh"
 #include "CommandController.hh"
 #include "CommandException.hh"
@@ -111,6 +112,9 @@ Keyboard::Keyboard(MSXMotherBoard& motherBoard,
 	, keyMatrixUpCmd  (commandController, stateChangeDistributor, scheduler_)
 	, keyMatrixDownCmd(commandController, stateChangeDistributor, scheduler_)
 	, keyTypeCmd      (commandController, stateChangeDistributor, scheduler_)
+	, keyMatrixSequencer(commandController, stateChangeDistributor, scheduler_)
+	, keyBufferInserter(motherBoard, commandController,
+		stateChangeDistributor, scheduler_, matrix)
 	, capsLockAligner(eventDistributor, scheduler_)
 	, keyboardSettings(commandController)
 	, msxKeyEventQueue(scheduler_, commandController.getInterpreter())
@@ -1096,6 +1100,205 @@ void Keyboard::KeyInserter::reschedule(EmuTime::param time)
 	setSyncPoint(time + EmuDuration::hz(typingFrequency));
 }
 
+
+// class KeyMatrixSequencer
+
+Keyboard::KeyMatrixSequencer::KeyMatrixSequencer(
+		CommandController& commandController_,
+		StateChangeDistributor& stateChangeDistributor_,
+		Scheduler& scheduler_)
+	: RecordedCommand(commandController_, stateChangeDistributor_,
+		scheduler_, "keymatrix_sequence")
+	, Schedulable(scheduler_)
+{
+}
+
+void Keyboard::KeyMatrixSequencer::execute(
+	span<const TclObject> tokens, TclObject& /*result*/, EmuTime::param time)
+{
+	checkNumArgs(tokens, AtLeast{2}, "?-interval seconds? states");
+	double seconds = 1.0 / 60.0;
+	ArgsInfo info[] = { valueArg("-interval", seconds) };
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
+	if (arguments.size() != 1) throw SyntaxError();
+	if (seconds <= 0.0) {
+		throw CommandException("Wrong argument for -interval (should be a positive number)");
+	}
+	auto data = arguments[0].getBinary();
+	if ((data.size() % KeyMatrixPosition::NUM_ROWS) != 0) {
+		throw CommandException("The length of the states should be a "
+		                       "multiple of ", KeyMatrixPosition::NUM_ROWS);
+	}
+
+	// a new sequence replaces the current one
+	removeSyncPoints();
+	states.assign(data.begin(), data.end());
+	index = 0;
+	start = time;
+	interval = EmuDuration(seconds);
+	if (!states.empty()) {
+		executeUntil(time);
+	}
+}
+
+string Keyboard::KeyMatrixSequencer::help(const vector<string>& /*tokens*/) const
+{
+	static const string helpText =
+		"keymatrix_sequence [-interval <seconds>] <states>\n"
+		"Sets the keyboard matrix to a sequence of states, one state per "
+		"interval (default 1/60s). The first state is set immediately. "
+		"<states> is a binary string (e.g. made with 'binary format') "
+		"with for each state one byte per row of the matrix, like in "
+		"'keymatrixdown' a 0 bit means the key is pressed. After the last "
+		"state the matrix stays the same. This allows a script or bot to "
+		"submit the input of many frames at once. A new sequence replaces "
+		"the one that is still running, an empty sequence only stops it.";
+	return helpText;
+}
+
+void Keyboard::KeyMatrixSequencer::tabCompletion(vector<string>& tokens) const
+{
+	static const char* const options[] = { "-interval" };
+	completeString(tokens, options);
+}
+
+void Keyboard::KeyMatrixSequencer::executeUntil(EmuTime::param /*time*/)
+{
+	auto& keyboard = OUTER(Keyboard, keyMatrixSequencer);
+	const byte* state = &states[index * KeyMatrixPosition::NUM_ROWS];
+	memcpy(keyboard.cmdKeyMatrix, state, KeyMatrixPosition::NUM_ROWS);
+	keyboard.keysChanged = true;
+
+	++index;
+	if (index * KeyMatrixPosition::NUM_ROWS < states.size()) {
+		// relative to the start, so that the intervals don't drift
+		setSyncPoint(start + interval * index);
+	}
+}
+
+
+// class KeyBufferInserter
+
+// BIOS work area
+struct KeyBufferAddresses {
+	word putPnt, getPnt, keyBuf, bufEnd;
+};
+static const KeyBufferAddresses MSX_KEYBUF = { 0xF3F8, 0xF3FA, 0xFBF0, 0xFC18 };
+static const KeyBufferAddresses SVI_KEYBUF = { 0xFA1A, 0xFA1C, 0xFD8B, 0xFDB3 };
+
+// How often to check whether the buffer is empty again. A full buffer (39
+// characters) often takes longer than this to process.
+static const EmuDuration KEYBUF_POLL_PERIOD = EmuDuration::hz(200);
+
+Keyboard::KeyBufferInserter::KeyBufferInserter(
+		MSXMotherBoard& motherBoard_,
+		CommandController& commandController_,
+		StateChangeDistributor& stateChangeDistributor_,
+		Scheduler& scheduler_, MatrixType matrix)
+	: RecordedCommand(commandController_, stateChangeDistributor_,
+		scheduler_, "type_via_keybuf")
+	, Schedulable(scheduler_)
+	, motherBoard(motherBoard_)
+	, svi(matrix == MATRIX_SVI)
+{
+}
+
+void Keyboard::KeyBufferInserter::execute(
+	span<const TclObject> tokens, TclObject& /*result*/, EmuTime::param time)
+{
+	checkNumArgs(tokens, AtLeast{2}, "?-release? ?-freq hz? text");
+	// These options are only accepted (and ignored) so that this command
+	// can be used as the implementation of 'type', see 'default_type_proc'.
+	bool release = false;
+	int freq = 0;
+	ArgsInfo info[] = {
+		flagArg("-release", release),
+		valueArg("-freq", freq),
+	};
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
+	if (arguments.size() != 1) throw SyntaxError();
+
+	bool typing = index < text.size();
+	if (!typing) {
+		text.clear();
+		index = 0;
+	}
+	// The buffer contains (8-bit) characters, not keys.
+	auto str = arguments[0].getString();
+	auto it = str.begin();
+	while (it != str.end()) {
+		text += char(utf8::next(it, str.end()));
+	}
+	if (!typing && !text.empty()) {
+		executeUntil(time);
+	}
+}
+
+string Keyboard::KeyBufferInserter::help(const vector<string>& /*tokens*/) const
+{
+	static const string helpText =
+		"type_via_keybuf <text>\n"
+		"This is an alternative to type_via_keyboard. It's a lot faster, "
+		"but it only works in software that reads the input from the "
+		"keyboard buffer area in the RAM. In MSX-BASIC, this one works "
+		"very well. It simply puts the characters of the argument "
+		"directly into the keyboard buffer, each time the software has "
+		"read the complete buffer. When already typing, the text is "
+		"appended. The -release and -freq options of type_via_keyboard "
+		"are accepted, but ignored.";
+	return helpText;
+}
+
+void Keyboard::KeyBufferInserter::tabCompletion(vector<string>& tokens) const
+{
+	static const char* const options[] = { "-release", "-freq" };
+	completeString(tokens, options);
+}
+
+word Keyboard::KeyBufferInserter::peek16(word address, EmuTime::param time) const
+{
+	auto& cpuInterface = motherBoard.getCPUInterface();
+	return cpuInterface.peekMem(address + 0, time) +
+	      (cpuInterface.peekMem(address + 1, time) << 8);
+}
+
+void Keyboard::KeyBufferInserter::poke16(word address, word value, EmuTime::param time)
+{
+	auto& cpuInterface = motherBoard.getCPUInterface();
+	cpuInterface.writeMem(address + 0, value & 0xFF, time);
+	cpuInterface.writeMem(address + 1, value >> 8,   time);
+}
+
+void Keyboard::KeyBufferInserter::executeUntil(EmuTime::param time)
+{
+	const auto& a = svi ? SVI_KEYBUF : MSX_KEYBUF;
+	if (peek16(a.putPnt, time) == peek16(a.getPnt, time)) {
+		// Buffer is empty, fill it (almost, a full buffer would look
+		// empty) with the next part of the text.
+		auto& cpuInterface = motherBoard.getCPUInterface();
+		word addr = a.keyBuf;
+		while ((addr < (a.bufEnd - 1)) && (index < text.size())) {
+			cpuInterface.writeMem(addr++, text[index++], time);
+		}
+		poke16(a.putPnt, addr,     time);
+		poke16(a.getPnt, a.keyBuf, time);
+	}
+	if (index < text.size()) {
+		setSyncPoint(time + KEYBUF_POLL_PERIOD);
+	} else {
+		text.clear();
+		index = 0;
+	}
+}
+
+template<typename Archive>
+void Keyboard::KeyBufferInserter::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.template serializeBase<Schedulable>(*this);
+	ar.serialize("text",  text,
+	             "index", index);
+}
+
 /*
  * class CapsLockAligner
  *
@@ -1234,6 +1437,16 @@ void Keyboard::KeyInserter::serialize(Archive& ar, unsigned /*version*/)
 	}
 }
 
+template<typename Archive>
+void Keyboard::KeyMatrixSequencer::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.template serializeBase<Schedulable>(*this);
+	ar.serialize("states",   states,
+	             "index",    index,
+	             "start",    start,
+	             "interval", interval);
+}
+
 // version 1: Initial version: {userKeyMatrix, dynKeymap, msxmodifiers,
 //            msxKeyEventQueue} was intentionally not serialized. The reason
 //            was that after a loadstate, you want the MSX keyboard to reflect
@@ -1241,6 +1454,8 @@ void Keyboard::KeyInserter::serialize(Archive& ar, unsigned /*version*/)
 //            time the savestate was created are cleared.
 // version 2: For reverse-replay it is important that snapshots contain the
 //            full state of the MSX keyboard, so now we do serialize it.
+// version 3: Added keyMatrixSequencer.
+// version 4: Added keyBufferInserter.
 // TODO Is the assumption in version 1 correct (clear keyb state on load)?
 //      If it is still useful for 'regular' loadstate, then we could implement
 //      it by explicitly clearing the keyb state from the actual loadstate
@@ -1273,6 +1488,12 @@ void Keyboard::serialize(Archive& ar, unsigned version)
 		             "msxmodifiers",     msxmodifiers,
 		             "msxKeyEventQueue", msxKeyEventQueue);
 	}
+	if (ar.versionAtLeast(version, 3)) {
+		ar.serialize("keyMatrixSequencer", keyMatrixSequencer);
+	}
+	if (ar.versionAtLeast(version, 4)) {
+		ar.serialize("keyBufferInserter", keyBufferInserter);
+	}
 	// don't serialize hostKeyMatrix
 
 	if (ar.isLoader()) {
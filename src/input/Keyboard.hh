@@ -160,6 +160,64 @@ private:
 		int typingFrequency;
 	} keyTypeCmd;
 
+	class KeyMatrixSequencer final : public RecordedCommand, public Schedulable {
+	public:
+		KeyMatrixSequencer(CommandController& commandController,
+		                   StateChangeDistributor& stateChangeDistributor,
+		                   Scheduler& scheduler);
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+
+	private:
+		// Command
+		void execute(span<const TclObject> tokens, TclObject& result,
+			     EmuTime::param time) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+
+		// Schedulable
+		void executeUntil(EmuTime::param time) override;
+
+		std::vector<byte> states; // NUM_ROWS bytes per state
+		unsigned index = 0; // of the next state
+		EmuTime start = EmuTime::zero;
+		EmuDuration interval;
+	} keyMatrixSequencer;
+
+	/** Types text by writing it in the keyboard buffer of the BIOS in RAM,
+	  * instead of simulating key presses. Only works for software that
+	  * reads the keyboard via this buffer (e.g. MSX-BASIC), but it is a
+	  * lot faster than 'type_via_keyboard'. The buffer is filled again
+	  * each time it's empty.
+	  */
+	class KeyBufferInserter final : public RecordedCommand, public Schedulable {
+	public:
+		KeyBufferInserter(MSXMotherBoard& motherBoard,
+		                  CommandController& commandController,
+		                  StateChangeDistributor& stateChangeDistributor,
+		                  Scheduler& scheduler, MatrixType matrix);
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+
+	private:
+		// Command
+		void execute(span<const TclObject> tokens, TclObject& result,
+			     EmuTime::param time) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+
+		// Schedulable
+		void executeUntil(EmuTime::param time) override;
+
+		word peek16(word address, EmuTime::param time) const;
+		void poke16(word address, word value, EmuTime::param time);
+
+		MSXMotherBoard& motherBoard;
+		const bool svi;
+		std::string text; // one byte per character
+		unsigned index = 0; // of the next character to put in the buffer
+	} keyBufferInserter;
+
 	class CapsLockAligner final : private EventListener, private Schedulable {
 	public:
 		CapsLockAligner(EventDistributor& eventDistributor,
@@ -240,7 +298,7 @@ private:
 	  */
 	byte locksOn;
 };
-SERIALIZE_CLASS_VERSION(Keyboard, 2);
+SERIALIZE_CLASS_VERSION(Keyboard, 4);
 
 } // namespace openmsx
 
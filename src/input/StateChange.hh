@@ -23,7 +23,7 @@ public:
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned /*version*/)
 	{
-		ar.serialize("time", time);
+		ar.serializeTimeStamp("time", time);
 	}
 
 protected:
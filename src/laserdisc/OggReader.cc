@@ -1,5 +1,6 @@
 #include "OggReader.hh"
 #include "MSXException.hh"
+#include "DecodedFileCache.hh"
 #include "yuv2rgb.hh"
 #include "likely.hh"
 #include "CliComm.hh"
@@ -8,6 +9,7 @@
 #include "stl.hh"
 #include "stringsp.hh" // for strncasecmp
 #include "view.hh"
+#include <algorithm>
 #include <cstring> // for memcpy, memcmp
 #include <cstdlib> // for atoi
 #include <cctype> // for isspace
@@ -55,6 +57,7 @@ OggReader::OggReader(const Filename& filename, CliComm& cli_)
 	currentSample = 0;
 	currentFrame = 1;
 	vorbisPos = 0;
+	seekPending = false;
 
 	th_info ti;
 	th_comment tc;
@@ -201,6 +204,119 @@ OggReader::OggReader(const Filename& filename, CliComm& cli_)
 	th_setup_free(tsi);
 	th_info_clear(&ti);
 	th_comment_clear(&tc);
+
+	loadIndex();
+}
+
+void OggReader::loadIndex()
+{
+	static const string_view KIND = "oggindex";
+	try {
+		auto url = file.getURL();
+		auto date = file.getModificationDate();
+
+		File cached;
+		size_t size;
+		std::string extra;
+		if (DecodedFileCache::open(KIND, url, date, cached, size, extra) &&
+		    (size >= sizeof(IndexHeader)) &&
+		    (((size - sizeof(IndexHeader)) % sizeof(IndexEntry)) == 0)) {
+			cached.read(&indexHeader, sizeof(indexHeader));
+			keyFrameIndex.resize((size - sizeof(IndexHeader)) /
+			                     sizeof(IndexEntry));
+			cached.read(keyFrameIndex.data(),
+			            keyFrameIndex.size() * sizeof(IndexEntry));
+			if (indexHeader.fileSize == fileSize) return;
+			keyFrameIndex.clear();
+		}
+
+		buildIndex();
+		if (keyFrameIndex.empty()) return;
+		std::vector<uint8_t> data(sizeof(IndexHeader) +
+		                          keyFrameIndex.size() * sizeof(IndexEntry));
+		memcpy(data.data(), &indexHeader, sizeof(IndexHeader));
+		memcpy(data.data() + sizeof(IndexHeader), keyFrameIndex.data(),
+		       keyFrameIndex.size() * sizeof(IndexEntry));
+		DecodedFileCache::store(KIND, url, date, data.data(), data.size());
+	} catch (MSXException&) {
+		// no index, seeking falls back to bisection
+		keyFrameIndex.clear();
+	}
+}
+
+void OggReader::buildIndex()
+{
+	// Only the page headers are needed, so this doesn't touch the
+	// decoders. Read in bigger chunks than nextPage(), this reads the
+	// whole file.
+	static const size_t CHUNK = 256 * 1024;
+
+	ogg_sync_state indexSync;
+	ogg_sync_init(&indexSync);
+
+	uint64_t pageOffset = 0; // offset of the next page
+	uint64_t lastKeyFrame = 0;
+	uint64_t lastSample = 0;
+	uint64_t prevVideoOffset = 0; // last video page with a granulepos ..
+	uint64_t prevVideoSample = 0; // .. and the audio reached before it
+	indexHeader.totalFrames = 0;
+	indexHeader.totalSamples = 0;
+
+	try {
+		file.seek(0);
+		size_t readOffset = 0;
+		while (true) {
+			ogg_page page;
+			int ret = ogg_sync_pageseek(&indexSync, &page);
+			if (ret < 0) {
+				pageOffset += -ret; // skipped garbage
+				continue;
+			}
+			if (ret == 0) {
+				if (readOffset >= fileSize) break;
+				auto chunk = std::min(CHUNK, fileSize - readOffset);
+				char* buffer = ogg_sync_buffer(&indexSync, long(chunk));
+				file.read(buffer, chunk);
+				readOffset += chunk;
+				ogg_sync_wrote(&indexSync, long(chunk));
+				continue;
+			}
+
+			int serial = ogg_page_serialno(&page);
+			ogg_int64_t granulepos = ogg_page_granulepos(&page);
+			if ((granulepos > 0) && (serial == audioSerial)) {
+				lastSample = granulepos;
+				indexHeader.totalSamples = std::max<uint64_t>(
+					indexHeader.totalSamples, lastSample);
+			} else if ((granulepos > 0) && (serial == videoSerial)) {
+				uint64_t key = uint64_t(granulepos) >> granuleShift;
+				uint64_t intra = uint64_t(granulepos) &
+				                 ((uint64_t(1) << granuleShift) - 1);
+				if (key > lastKeyFrame) {
+					// The key frame packet starts after the
+					// last packet that ended in the previous
+					// video page with a granulepos.
+					keyFrameIndex.push_back(
+						{key, prevVideoOffset, prevVideoSample});
+					lastKeyFrame = key;
+				}
+				indexHeader.totalFrames = std::max<uint64_t>(
+					indexHeader.totalFrames, key + intra);
+				prevVideoOffset = pageOffset;
+				prevVideoSample = lastSample;
+			}
+			pageOffset += ret;
+		}
+	} catch (MSXException&) {
+		keyFrameIndex.clear();
+	}
+	ogg_sync_clear(&indexSync);
+
+	indexHeader.fileSize = fileSize;
+	if (indexHeader.totalFrames == 0) keyFrameIndex.clear();
+
+	// continue where the header parsing stopped
+	file.seek(fileOffset);
 }
 
 void OggReader::cleanup()
@@ -613,6 +729,14 @@ void OggReader::readTheora(ogg_packet* packet)
 
 void OggReader::getFrameNo(RawFrame& rawFrame, size_t frameno)
 {
+	if (seekPending) {
+		if (auto* cached = findCachedFrame(frameno)) {
+			yuv2rgb::convert(cached->buffer, rawFrame);
+			return;
+		}
+		flushSeek(frameno);
+	}
+
 	Frame* frame;
 	while (true) {
 		// If there are no frames or the frames we have read
@@ -629,7 +753,7 @@ void OggReader::getFrameNo(RawFrame& rawFrame, size_t frameno)
 		// and even frame are displayed during still, so we can
 		// only throw away the one two frames ago
 		while (frameList.size() >= 3 && frameList[2]->no <= frameno) {
-			recycleFrameList.push_back(frameList.pop_front());
+			cacheFrame(frameList.pop_front());
 		}
 
 		if (!frameList.empty() && frameList[0]->no > frameno) {
@@ -680,6 +804,10 @@ void OggReader::recycleAudio(std::unique_ptr<AudioFragment> audio)
 
 const AudioFragment* OggReader::getAudio(size_t sample)
 {
+	if (seekPending) {
+		doSeek(seekFrame, seekSample);
+	}
+
 	// Read while position is unknown
 	while (audioList.empty() ||
 	       audioList.front()->position == AudioFragment::UNKNOWN_POS) {
@@ -786,6 +914,7 @@ bool OggReader::nextPage(ogg_page* page)
 		}
 
 		char* buffer = ogg_sync_buffer(&sync, long(chunk));
+		file.readAhead(fileOffset);
 		file.read(buffer, chunk);
 		fileOffset += chunk;
 
@@ -853,16 +982,63 @@ size_t OggReader::bisection(
 	}
 }
 
+bool OggReader::indexOffset(size_t frame, size_t sample, size_t& offset)
+{
+	if (keyFrameIndex.empty() || (indexHeader.fileSize != fileSize)) {
+		return false;
+	}
+	totalFrames = indexHeader.totalFrames;
+
+	// same shortcut as in findOffset()
+	if (sample < getSampleRate() || frame <= 30) {
+		keyFrame = 1;
+		offset = 0;
+		return true;
+	}
+
+	if ((sample > indexHeader.totalSamples) || (frame > totalFrames)) {
+		sample = indexHeader.totalSamples;
+		frame = totalFrames;
+	}
+
+	// the last key frame at or before the requested frame
+	auto it = std::upper_bound(begin(keyFrameIndex), end(keyFrameIndex), frame,
+		[](size_t f, const IndexEntry& e) { return f < e.keyFrame; });
+	if (it == begin(keyFrameIndex)) {
+		keyFrame = 1;
+		offset = 0;
+		return true;
+	}
+	--it;
+	keyFrame = it->keyFrame;
+
+	// Audio and video are not exactly interleaved, go back further when
+	// the audio at that offset is already past the requested sample
+	// (with some margin because vorbis needs a packet to warm up).
+	while ((it != begin(keyFrameIndex)) &&
+	       (it->sample + AudioFragment::MAX_SAMPLES > sample)) {
+		--it;
+	}
+	offset = it->offset;
+	return true;
+}
+
 size_t OggReader::findOffset(size_t frame, size_t sample)
 {
 	static const size_t STEP = 32 * 1024;
 
-	// first calculate total length in bytes, samples and frames
-
 	// The file might have changed since we last requested its size,
-	// we assume that only data will be added to it and the ogg streams
-	// are exactly as before
+	// in that case the index is no longer valid.
 	fileSize = file.getSize();
+	size_t indexed;
+	if (indexOffset(frame, sample, indexed)) {
+		return indexed;
+	}
+
+	// first calculate total length in bytes, samples and frames
+
+	// We assume that only data will be added to the file and the ogg
+	// streams are exactly as before
 	auto offset = fileSize - 1;
 
 	while (offset > 0) {
@@ -933,12 +1109,49 @@ size_t OggReader::findOffset(size_t frame, size_t sample)
 	return bisection(keyFrame, sample, maxOffset, maxSamples, maxFrames);
 }
 
+void OggReader::cacheFrame(std::unique_ptr<Frame> frame)
+{
+	if (frame->no == size_t(-1)) {
+		recycleFrameList.push_back(std::move(frame));
+		return;
+	}
+	// drop older copies of (some of) the same frames
+	auto overlaps = [&](const std::unique_ptr<Frame>& f) {
+		return (f->no < frame->no + frame->length) &&
+		       (frame->no < f->no + f->length);
+	};
+	for (auto it = begin(frameCache); it != end(frameCache); /**/) {
+		if (overlaps(*it)) {
+			recycleFrameList.push_back(std::move(*it));
+			it = frameCache.erase(it);
+		} else {
+			++it;
+		}
+	}
+	frameCache.push_back(std::move(frame));
+	if (frameCache.size() > MAX_CACHED_FRAMES) {
+		recycleFrameList.push_back(std::move(frameCache.front()));
+		frameCache.pop_front();
+	}
+}
+
+Frame* OggReader::findCachedFrame(size_t frameno)
+{
+	auto it = ranges::find_if(frameCache, [&](const std::unique_ptr<Frame>& f) {
+		return (f->no <= frameno) && (frameno < f->no + f->length);
+	});
+	if (it == end(frameCache)) return nullptr;
+	// move to the most recently used position
+	frameCache.splice(end(frameCache), frameCache, it);
+	return frameCache.back().get();
+}
+
 bool OggReader::seek(size_t frame, size_t samples)
 {
-	// Remove all queued frames
-	recycleFrameList.insert(end(recycleFrameList),
-		make_move_iterator(begin(frameList)),
-		make_move_iterator(end  (frameList)));
+	// Keep the queued frames, we might jump back to them
+	for (auto& f : frameList) {
+		cacheFrame(std::move(f));
+	}
 	frameList.clear();
 
 	// Remove all queued audio
@@ -950,6 +1163,27 @@ bool OggReader::seek(size_t frame, size_t samples)
 	}
 	audioList.clear();
 
+	seekPending = true;
+	seekFrame = frame;
+	seekSample = samples;
+	return true;
+}
+
+void OggReader::flushSeek(size_t frameno)
+{
+	// Stills and stepping may have displayed some cached frames since
+	// the seek, continue from the requested frame with the audio
+	// position moved along.
+	int64_t sample = int64_t(seekSample) +
+		(int64_t(frameno) - int64_t(seekFrame)) * 1001 *
+		getSampleRate() / (frameRate * 1000);
+	doSeek(frameno, size_t(std::max<int64_t>(sample, 0)));
+}
+
+void OggReader::doSeek(size_t frame, size_t samples)
+{
+	seekPending = false;
+
 	fileOffset = findOffset(frame, samples);
 	file.seek(fileOffset);
 
@@ -960,8 +1194,6 @@ bool OggReader::seek(size_t frame, size_t samples)
 	currentSample = samples;
 
 	vorbis_synthesis_restart(&vd);
-
-	return true;
 }
 
 bool OggReader::stopFrame(size_t frame) const
@@ -6,6 +6,7 @@
 #include <ogg/ogg.h>
 #include <vorbis/codec.h>
 #include <theora/theoradec.h>
+#include <cstdint>
 #include <memory>
 #include <list>
 #include <utility>
@@ -70,6 +71,14 @@ private:
 	void vorbisFoundPosition();
 	size_t frameNo(ogg_packet* packet);
 
+	void cacheFrame(std::unique_ptr<Frame> frame);
+	Frame* findCachedFrame(size_t frameno);
+	void doSeek(size_t frame, size_t sample);
+	void flushSeek(size_t frameno);
+
+	void loadIndex();
+	void buildIndex();
+	bool indexOffset(size_t frame, size_t sample, size_t& offset);
 	size_t findOffset(size_t frame, size_t sample);
 	size_t bisection(size_t frame, size_t sample,
 	                 size_t maxOffset, size_t maxSamples, size_t maxFrames);
@@ -104,6 +113,18 @@ private:
 	cb_queue<std::unique_ptr<Frame>> frameList;
 	std::vector<std::unique_ptr<Frame>> recycleFrameList;
 
+	// Recently displayed frames, least recently used first. Stills,
+	// stepping and (short) jumps are often served from here, so they
+	// don't need to decode from the previous keyframe again.
+	static const size_t MAX_CACHED_FRAMES = 32;
+	std::list<std::unique_ptr<Frame>> frameCache;
+
+	// seek() only records the target, the (expensive) seek in the file
+	// is done when a frame or audio is needed that's not in the cache
+	bool seekPending;
+	size_t seekFrame;
+	size_t seekSample;
+
 	// audio
 	int audioHeaders;
 	vorbis_info vi;
@@ -116,6 +137,24 @@ private:
 	std::list<std::unique_ptr<AudioFragment>> audioList;
 	cb_queue<std::unique_ptr<AudioFragment>> recycleAudioList;
 
+	// Index of the key frames, built by scanning the whole file once (and
+	// then cached in DecodedFileCache). Each entry tells from which file
+	// offset to start reading to decode that key frame, and which audio
+	// sample was reached before that offset. When the index doesn't
+	// match the file (anymore) seeking falls back to bisection.
+	struct IndexEntry {
+		uint64_t keyFrame;
+		uint64_t offset;
+		uint64_t sample;
+	};
+	struct IndexHeader {
+		uint64_t fileSize;
+		uint64_t totalFrames;
+		uint64_t totalSamples;
+	};
+	IndexHeader indexHeader;
+	std::vector<IndexEntry> keyFrameIndex;
+
 	// Metadata
 	std::vector<size_t> stopFrames;
 	std::vector<std::pair<int, size_t>> chapters;
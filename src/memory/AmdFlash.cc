@@ -1,10 +1,15 @@
 #include "AmdFlash.hh"
 #include "Rom.hh"
-#include "SRAM.hh"
 #include "MSXMotherBoard.hh"
 #include "MSXCPU.hh"
 #include "MSXDevice.hh"
 #include "CliComm.hh"
+#include "File.hh"
+#include "FileContext.hh"
+#include "FileException.hh"
+#include "FileNotFoundException.hh"
+#include "Reactor.hh"
+#include "SimpleDebuggable.hh"
 #include "HardwareConfig.hh"
 #include "MSXException.hh"
 #include "Math.hh"
@@ -22,43 +27,55 @@ using std::vector;
 
 namespace openmsx {
 
+class AmdFlashDebuggable final : public SimpleDebuggable
+{
+public:
+	AmdFlashDebuggable(MSXMotherBoard& motherBoard, const string& name,
+	                   AmdFlash& flash);
+	byte read(unsigned address) override;
+	void write(unsigned address, byte value) override;
+private:
+	AmdFlash& flash;
+};
+
+
 AmdFlash::AmdFlash(const Rom& rom, vector<SectorInfo> sectorInfo_,
                    word ID_, bool use12bitAddressing_,
-                   const DeviceConfig& config, bool load)
-	: motherBoard(config.getMotherBoard())
+                   const DeviceConfig& config_, bool load)
+	: motherBoard(config_.getMotherBoard())
+	, config(config_)
 	, sectorInfo(std::move(sectorInfo_))
 	, size(sum(view::transform(sectorInfo, [](auto& i) { return i.size; })))
 	, ID(ID_)
 	, use12bitAddressing(use12bitAddressing_)
 {
-	init(rom.getName() + "_flash", config, load, &rom);
+	init(rom.getName() + "_flash", load, &rom);
 }
 
 AmdFlash::AmdFlash(const string& name, vector<SectorInfo> sectorInfo_,
                    word ID_, bool use12bitAddressing_,
-                   const DeviceConfig& config)
-	: motherBoard(config.getMotherBoard())
+                   const DeviceConfig& config_)
+	: motherBoard(config_.getMotherBoard())
+	, config(config_)
 	, sectorInfo(std::move(sectorInfo_))
 	, size(sum(view::transform(sectorInfo, [](auto& i) { return i.size; })))
 	, ID(ID_)
 	, use12bitAddressing(use12bitAddressing_)
 {
-	init(name, config, true, nullptr);
+	init(name, true, nullptr);
 }
 
-static bool sramEmpty(const SRAM& ram)
+static bool isErased(const byte* data, unsigned size)
 {
-	return ranges::all_of(xrange(ram.getSize()),
-	                      [&](auto i) { return ram[i] == 0xFF; });
+	return ranges::all_of(xrange(size), [&](auto i) { return data[i] == 0xFF; });
 }
 
-void AmdFlash::init(const string& name, const DeviceConfig& config, bool load, const Rom* rom)
+void AmdFlash::init(const string& name, bool load, const Rom* rom)
 {
 	assert(Math::ispow2(getSize()));
 
 	auto numSectors = sectorInfo.size();
 
-	unsigned writableSize = 0;
 	unsigned readOnlySize = 0;
 	writeAddress.resize(numSectors);
 	for (auto i : xrange(numSectors)) {
@@ -71,34 +88,55 @@ void AmdFlash::init(const string& name, const DeviceConfig& config, bool load, c
 		}
 	}
 	assert((writableSize + readOnlySize) == getSize());
+	if (readOnlySize) {
+		// If some part of the flash is read-only we require a ROM
+		// constructor parameter.
+		assert(rom);
+	}
+
+	// Sectors that are completely covered by the rom point directly to
+	// the rom data, a sector that is only partially covered (or not at
+	// all) reads as 0xFF (nullptr) for now.
+	readAddress.resize(numSectors);
+	initialAddress.resize(numSectors);
+	sectorData.resize(numSectors);
+	auto setInitialAddresses = [&] {
+		unsigned romSize = rom ? rom->getSize() : 0;
+		unsigned offset = 0;
+		for (auto i : xrange(numSectors)) {
+			unsigned sectorSize = sectorInfo[i].size;
+			initialAddress[i] = ((offset + sectorSize) <= romSize)
+			                  ? &(*rom)[offset] : nullptr;
+			readAddress[i] = initialAddress[i];
+			offset += sectorSize;
+		}
+		assert(offset == getSize());
+	};
+	setInitialAddresses();
 
 	bool loaded = false;
+	string loadedFilename;
 	if (writableSize) {
+		debuggable = std::make_unique<AmdFlashDebuggable>(
+			motherBoard, name, *this);
+		// Hack for 'Matra INK', flash chip is wired-up so that writes
+		// are never visible to the MSX (but the flash is not made
+		// write-protected). In this case it doesn't make sense to
+		// load/save the flash content.
 		if (load) {
-			ram = std::make_unique<SRAM>(
-				name, "flash rom",
-				writableSize, config, nullptr, &loaded);
-		} else {
-			// Hack for 'Matra INK', flash chip is wired-up so that
-			// writes are never visible to the MSX (but the flash
-			// is not made write-protected). In this case it doesn't
-			// make sense to load/save the SRAM file.
-			ram = std::make_unique<SRAM>(
-				name, "flash rom",
-				writableSize, config, SRAM::DontLoadTag{});
+			schedulable = std::make_unique<SaveSchedulable>(
+				config.getReactor().getRTScheduler(), *this);
+			loaded = this->load(loadedFilename);
 		}
 	}
-	if (readOnlySize) {
-		// If some part of the flash is read-only we require a ROM
-		// constructor parameter.
-		assert(rom);
-	}
 
 	auto* romTag = config.getXML()->findChild("rom");
 	bool initialContentSpecified = romTag && romTag->findChild("sha1");
 
-	// check whether the loaded SRAM is empty, whilst initial content was specified
-	if (!rom && loaded && initialContentSpecified && sramEmpty(*ram)) {
+	// check whether the loaded content is empty, whilst initial content was specified
+	if (!rom && loaded && initialContentSpecified &&
+	    ranges::all_of(xrange(numSectors), [&](auto i) {
+		return (writeAddress[i] == -1) || !readAddress[i]; })) {
 		config.getCliComm().printInfo(
 			"This flash device (", config.getHardwareConfig().getName(),
 			") has initial content specified, but this content "
@@ -109,10 +147,9 @@ void AmdFlash::init(const string& name, const DeviceConfig& config, bool load, c
 			"when this device was used for the first time). If you "
 			"still wish to load the specified initial content, "
 			"please remove the blank persistent storage file: ",
-			ram->getLoadedFilename());
+			loadedFilename);
 	}
 
-	std::unique_ptr<Rom> rom_;
 	if (!rom && !loaded) {
 		// If we don't have a ROM constructor parameter and there was
 		// no sram content loaded (= previous persistent flash
@@ -121,13 +158,14 @@ void AmdFlash::init(const string& name, const DeviceConfig& config, bool load, c
 		// ships. This ROM is optional, if it's not found, then the
 		// initial flash content is all 0xFF.
 		try {
-			rom_ = std::make_unique<Rom>(
+			initialRom = std::make_unique<Rom>(
 				string{}, string{}, // dummy name and description
 				config);
-			rom = rom_.get();
+			rom = initialRom.get();
 			config.getCliComm().printInfo(
 				"Loaded initial content for flash ROM from ",
 				rom->getFilename());
+			setInitialAddresses();
 		} catch (MSXException& e) {
 			// ignore error
 			assert(rom == nullptr); // 'rom' remains nullptr
@@ -140,48 +178,184 @@ void AmdFlash::init(const string& name, const DeviceConfig& config, bool load, c
 		}
 	}
 
-	readAddress.resize(numSectors);
-	unsigned romSize = rom ? rom->getSize() : 0;
-	unsigned offset = 0;
-	for (auto i : xrange(numSectors)) {
-		unsigned sectorSize = sectorInfo[i].size;
-		if (isSectorWritable(unsigned(i))) {
-			readAddress[i] = &(*ram)[writeAddress[i]];
-			if (!loaded) {
-				auto ramPtr = const_cast<byte*>(
-					&(*ram)[writeAddress[i]]);
-				if (offset >= romSize) {
-					// completely past end of rom
-					memset(ramPtr, 0xFF, sectorSize);
-				} else if (offset + sectorSize >= romSize) {
-					// partial overlap
-					unsigned last = romSize - offset;
-					unsigned missing = sectorSize - last;
-					const byte* romPtr = &(*rom)[offset];
-					memcpy(ramPtr, romPtr, last);
-					memset(ramPtr + last, 0xFF, missing);
-				} else {
-					// completely before end of rom
-					const byte* romPtr = &(*rom)[offset];
-					memcpy(ramPtr, romPtr, sectorSize);
-				}
+	if (!loaded && rom) {
+		// A writable sector that is only partially covered by the
+		// rom gets its own copy right away.
+		unsigned romSize = rom->getSize();
+		unsigned offset = 0;
+		for (auto i : xrange(numSectors)) {
+			unsigned sectorSize = sectorInfo[i].size;
+			if ((writeAddress[i] != -1) && !initialAddress[i] &&
+			    (offset < romSize)) {
+				unsigned last = romSize - offset;
+				auto& data = sectorData[i];
+				data.resize(sectorSize);
+				memcpy(data.data(), &(*rom)[offset], last);
+				memset(data.data() + last, 0xFF, sectorSize - last);
+				readAddress[i] = data.data();
 			}
+			offset += sectorSize;
+		}
+	}
+
+	reset();
+}
+
+AmdFlash::~AmdFlash()
+{
+	if (schedulable) {
+		save();
+	}
+}
+
+// Set the content of a writable sector, only keep a copy when it differs from
+// the initial content.
+void AmdFlash::setSectorContent(unsigned sector, const byte* data)
+{
+	unsigned sectorSize = sectorInfo[sector].size;
+	const byte* initial = initialAddress[sector];
+	if (initial && (memcmp(data, initial, sectorSize) == 0)) {
+		sectorData[sector].clear();
+		readAddress[sector] = initial;
+	} else if (isErased(data, sectorSize)) {
+		sectorData[sector].clear();
+		readAddress[sector] = nullptr;
+	} else {
+		auto& buf = sectorData[sector];
+		buf.resize(sectorSize);
+		memcpy(buf.data(), data, sectorSize);
+		readAddress[sector] = buf.data();
+	}
+}
+
+AmdFlash::SectorState AmdFlash::getSectorState(unsigned sector) const
+{
+	if (!sectorData[sector].empty()) return SECTOR_MODIFIED;
+	return readAddress[sector] ? SECTOR_INITIAL : SECTOR_ERASED;
+}
+
+// Make sure the sector has its own copy of the data (copy-on-write).
+byte* AmdFlash::getWritableSector(unsigned sector)
+{
+	assert(writeAddress[sector] != -1);
+	auto& data = sectorData[sector];
+	if (data.empty()) {
+		unsigned sectorSize = sectorInfo[sector].size;
+		data.resize(sectorSize);
+		if (const byte* src = readAddress[sector]) {
+			memcpy(data.data(), src, sectorSize);
 		} else {
-			assert(rom); // must have rom constructor parameter
-			if ((offset + sectorSize) <= romSize) {
-				readAddress[i] = &(*rom)[offset];
+			memset(data.data(), 0xFF, sectorSize);
+		}
+		readAddress[sector] = data.data();
+		motherBoard.getCPU().invalidateMemCache(0x0000, 0x10000);
+	}
+	markModified();
+	return data.data();
+}
+
+void AmdFlash::eraseSector(unsigned sector)
+{
+	assert(writeAddress[sector] != -1);
+	sectorData[sector].clear();
+	if (readAddress[sector]) {
+		readAddress[sector] = nullptr;
+		motherBoard.getCPU().invalidateMemCache(0x0000, 0x10000);
+	}
+	markModified();
+}
+
+void AmdFlash::markModified()
+{
+	unsaved = true;
+	if (schedulable && !schedulable->isPendingRT()) {
+		schedulable->scheduleRT(5000000); // sync to disk after 5s
+	}
+}
+
+// Translate an address in the writable part of the flash (as used by the
+// debuggable and the persistent file) to a sector and an offset.
+bool AmdFlash::findWritableSector(unsigned address, unsigned& sector,
+                                  unsigned& offset) const
+{
+	for (auto i : xrange(unsigned(sectorInfo.size()))) {
+		if (writeAddress[i] == -1) continue;
+		unsigned start = writeAddress[i];
+		if ((address >= start) && (address < (start + sectorInfo[i].size))) {
+			sector = i;
+			offset = address - start;
+			return true;
+		}
+	}
+	return false;
+}
+
+// The persistent file contains the complete content of the writable sectors.
+bool AmdFlash::load(string& loadedFilename)
+{
+	const string& filename = config.getChildData("sramname");
+	try {
+		File file(config.getFileContext().resolveCreate(filename),
+		          File::LOAD_PERSISTENT);
+		MemBuffer<byte> buf;
+		for (auto i : xrange(unsigned(sectorInfo.size()))) {
+			if (writeAddress[i] == -1) continue;
+			buf.resize(sectorInfo[i].size);
+			file.read(buf.data(), sectorInfo[i].size);
+			setSectorContent(i, buf.data());
+		}
+		loadedFilename = file.getURL();
+		return true;
+	} catch (FileNotFoundException& /*e*/) {
+		config.getCliComm().printInfo(
+			"SRAM file ", filename, " not found, "
+			"assuming blank SRAM content.");
+	} catch (FileException& e) {
+		config.getCliComm().printWarning(
+			"Couldn't load SRAM ", filename,
+			" (", e.getMessage(), ").");
+	}
+	// discard partially loaded content
+	for (auto i : xrange(sectorInfo.size())) {
+		sectorData[i].clear();
+		readAddress[i] = initialAddress[i];
+	}
+	return false;
+}
+
+void AmdFlash::save()
+{
+	// Nothing changed since the content was loaded (or since the initial
+	// content was used), so there's no need to (re)write the file.
+	if (!unsaved) return;
+	const string& filename = config.getChildData("sramname");
+	try {
+		File file(config.getFileContext().resolveCreate(filename),
+		          File::SAVE_PERSISTENT);
+		MemBuffer<byte> erased;
+		for (auto i : xrange(sectorInfo.size())) {
+			if (writeAddress[i] == -1) continue;
+			unsigned sectorSize = sectorInfo[i].size;
+			if (const byte* data = readAddress[i]) {
+				file.write(data, sectorSize);
 			} else {
-				readAddress[i] = nullptr;
+				erased.resize(sectorSize);
+				memset(erased.data(), 0xFF, sectorSize);
+				file.write(erased.data(), sectorSize);
 			}
 		}
-		offset += sectorSize;
+		unsaved = false;
+	} catch (FileException& e) {
+		config.getCliComm().printWarning(
+			"Couldn't save SRAM ", filename,
+			" (", e.getMessage(), ").");
 	}
-	assert(offset == getSize());
-
-	reset();
 }
 
-AmdFlash::~AmdFlash() = default;
+void AmdFlash::SaveSchedulable::executeRT()
+{
+	flash.save();
+}
 
 void AmdFlash::getSectorInfo(unsigned address, unsigned& sector,
                              unsigned& sectorSize, unsigned& offset) const
@@ -309,8 +483,7 @@ bool AmdFlash::checkCommandEraseSector()
 			unsigned sector, sectorSize, offset;
 			getSectorInfo(addr, sector, sectorSize, offset);
 			if (isSectorWritable(sector)) {
-				ram->memset(writeAddress[sector],
-				            0xff, sectorSize);
+				eraseSector(sector);
 			}
 		}
 	}
@@ -323,7 +496,11 @@ bool AmdFlash::checkCommandEraseChip()
 	if (partialMatch(5, cmdSeq)) {
 		if (cmdIdx < 6) return true;
 		if (cmd[5].value == 0x10) {
-			if (ram) ram->memset(0, 0xff, ram->getSize());
+			for (auto sector : xrange(unsigned(sectorInfo.size()))) {
+				if (writeAddress[sector] != -1) {
+					eraseSector(sector);
+				}
+			}
 		}
 	}
 	return false;
@@ -338,8 +515,12 @@ bool AmdFlash::checkCommandProgramHelper(unsigned numBytes, const byte* cmdSeq,
 			unsigned sector, sectorSize, offset;
 			getSectorInfo(addr, sector, sectorSize, offset);
 			if (isSectorWritable(sector)) {
-				unsigned ramAddr = writeAddress[sector] + offset;
-				ram->write(ramAddr, (*ram)[ramAddr] & cmd[i].value);
+				const byte* data = readAddress[sector];
+				byte oldValue = data ? data[offset] : 0xFF;
+				byte newValue = oldValue & cmd[i].value;
+				if (newValue != oldValue) {
+					getWritableSector(sector)[offset] = newValue;
+				}
 			}
 		}
 	}
@@ -401,6 +582,13 @@ static std::initializer_list<enum_string<AmdFlash::State>> stateInfo = {
 };
 SERIALIZE_ENUM(AmdFlash::State, stateInfo);
 
+static std::initializer_list<enum_string<AmdFlash::SectorState>> sectorStateInfo = {
+	{ "INITIAL",  AmdFlash::SECTOR_INITIAL  },
+	{ "ERASED",   AmdFlash::SECTOR_ERASED   },
+	{ "MODIFIED", AmdFlash::SECTOR_MODIFIED }
+};
+SERIALIZE_ENUM(AmdFlash::SectorState, sectorStateInfo);
+
 template<typename Archive>
 void AmdFlash::AmdCmd::serialize(Archive& ar, unsigned /*version*/)
 {
@@ -411,8 +599,52 @@ void AmdFlash::AmdCmd::serialize(Archive& ar, unsigned /*version*/)
 template<typename Archive>
 void AmdFlash::serialize(Archive& ar, unsigned version)
 {
-	ar.serialize("ram",    *ram,
-	             "cmd",    cmd,
+	if (ar.versionAtLeast(version, 3)) {
+		// Only the writable sectors that differ from the initial
+		// content are stored.
+		for (auto i : xrange(unsigned(sectorInfo.size()))) {
+			if (writeAddress[i] == -1) continue;
+			SectorState sectorState = getSectorState(i);
+			ar.serialize("sector", sectorState);
+			if (ar.isLoader()) {
+				sectorData[i].clear();
+				readAddress[i] = (sectorState == SECTOR_INITIAL)
+				               ? initialAddress[i] : nullptr;
+			}
+			if (sectorState == SECTOR_MODIFIED) {
+				if (ar.isLoader()) {
+					sectorData[i].resize(sectorInfo[i].size);
+					readAddress[i] = sectorData[i].data();
+				}
+				ar.serialize_blob("data", sectorData[i].data(),
+				                  sectorInfo[i].size);
+			}
+		}
+	} else if (writableSize) {
+		assert(ar.isLoader());
+		// older versions stored all writable sectors in a SRAM object
+		//    <ram>
+		//      <ram>
+		//        <ram encoding="..">...</ram>
+		//      </ram>
+		//    </ram>
+		// deserialize that structure and only keep the modified sectors
+		MemBuffer<byte> tmp(writableSize);
+		ar.beginTag("ram");
+		ar.beginTag("ram");
+		ar.serialize_blob("ram", tmp.data(), writableSize);
+		ar.endTag("ram");
+		ar.endTag("ram");
+		for (auto i : xrange(unsigned(sectorInfo.size()))) {
+			if (writeAddress[i] == -1) continue;
+			setSectorContent(i, &tmp[writeAddress[i]]);
+		}
+	}
+	if (ar.isLoader()) {
+		// like before, the loaded content ends up in the persistent file
+		unsaved = true;
+	}
+	ar.serialize("cmd",    cmd,
 	             "cmdIdx", cmdIdx,
 	             "state",  state);
 	if (ar.versionAtLeast(version, 2)) {
@@ -421,4 +653,31 @@ void AmdFlash::serialize(Archive& ar, unsigned version)
 }
 INSTANTIATE_SERIALIZE_METHODS(AmdFlash);
 
+
+// class AmdFlashDebuggable
+
+AmdFlashDebuggable::AmdFlashDebuggable(
+		MSXMotherBoard& motherBoard_, const string& name_, AmdFlash& flash_)
+	: SimpleDebuggable(motherBoard_, name_, "flash rom", flash_.writableSize)
+	, flash(flash_)
+{
+}
+
+byte AmdFlashDebuggable::read(unsigned address)
+{
+	unsigned sector, offset;
+	if (!flash.findWritableSector(address, sector, offset)) return 0xFF;
+	const byte* data = flash.readAddress[sector];
+	return data ? data[offset] : 0xFF;
+}
+
+void AmdFlashDebuggable::write(unsigned address, byte value)
+{
+	unsigned sector, offset;
+	if (!flash.findWritableSector(address, sector, offset)) return;
+	if (read(address) != value) {
+		flash.getWritableSector(sector)[offset] = value;
+	}
+}
+
 } // namespace openmsx
@@ -1,19 +1,25 @@
 #ifndef AMDFLASH_HH
 #define AMDFLASH_HH
 
+#include "DeviceConfig.hh"
 #include "MemBuffer.hh"
+#include "RTSchedulable.hh"
 #include "openmsx.hh"
 #include "serialize_meta.hh"
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
 class Rom;
-class SRAM;
-class DeviceConfig;
+class AmdFlashDebuggable;
 
+/** The content of the writable sectors is a copy-on-write overlay over the
+  * initial content (the ROM): only the sectors that are modified get their
+  * own copy. Likewise only those sectors end up in savestates.
+  */
 class AmdFlash
 {
 public:
@@ -73,9 +79,28 @@ public:
 	};
 
 	enum State { ST_IDLE, ST_IDENT };
+	enum SectorState { SECTOR_INITIAL, SECTOR_ERASED, SECTOR_MODIFIED };
 
 private:
-	void init(const std::string& name, const DeviceConfig& config, bool load, const Rom* rom);
+	struct SaveSchedulable final : public RTSchedulable {
+		explicit SaveSchedulable(RTScheduler& scheduler_, AmdFlash& flash_)
+			: RTSchedulable(scheduler_), flash(flash_) {}
+		void executeRT() override;
+	private:
+		AmdFlash& flash;
+	};
+	friend class AmdFlashDebuggable;
+
+	void init(const std::string& name, bool load, const Rom* rom);
+	bool load(std::string& loadedFilename);
+	void save();
+	void setSectorContent(unsigned sector, const byte* data);
+	SectorState getSectorState(unsigned sector) const;
+	byte* getWritableSector(unsigned sector);
+	void eraseSector(unsigned sector);
+	void markModified();
+	bool findWritableSector(unsigned address, unsigned& sector,
+	                        unsigned& offset) const;
 	void getSectorInfo(unsigned address, unsigned& sector,
                            unsigned& sectorSize, unsigned& offset) const;
 
@@ -93,9 +118,16 @@ private:
 	bool isSectorWritable(unsigned sector) const;
 
 	MSXMotherBoard& motherBoard;
-	std::unique_ptr<SRAM> ram;
+	const DeviceConfig config;
+	std::unique_ptr<Rom> initialRom; // only when not passed to the constructor
 	MemBuffer<int> writeAddress;
-	MemBuffer<const byte*> readAddress;
+	MemBuffer<const byte*> readAddress; // nullptr -> all 0xFF
+	MemBuffer<const byte*> initialAddress; // idem, only for writable sectors
+	std::vector<MemBuffer<byte>> sectorData; // empty -> not modified
+	std::unique_ptr<AmdFlashDebuggable> debuggable;
+	std::unique_ptr<SaveSchedulable> schedulable; // nullptr -> not persistent
+	unsigned writableSize = 0;
+	bool unsaved = false;
 	const std::vector<SectorInfo> sectorInfo;
 	const unsigned size;
 	const word ID;
@@ -107,7 +139,7 @@ private:
 	State state = ST_IDLE;
 	bool vppWpPinLow = false; // true = protection on
 };
-SERIALIZE_CLASS_VERSION(AmdFlash, 2);
+SERIALIZE_CLASS_VERSION(AmdFlash, 3);
 
 } // namespace openmsx
 
@@ -5,11 +5,17 @@
 #include "Base64.hh"
 #include "HexDump.hh"
 #include "MSXException.hh"
+#include "MemoryOps.hh"
 #include "serialize.hh"
+#include "systemfuncs.hh"
 #include <zlib.h>
 #include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <memory>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 using std::string;
 
@@ -22,31 +28,127 @@ public:
 	              const string& description, Ram& ram);
 	byte read(unsigned address) override;
 	void write(unsigned address, byte value) override;
+	void readBlock(unsigned address, byte* output, unsigned num) override;
 private:
 	Ram& ram;
 };
 
 
+// Large memories (e.g. a 4MB memory mapper) are mapped, so that the OS only
+// commits the pages that are actually written. Pages that were never written
+// share the (read-only) pages of a process wide 'pattern file', that's a file
+// which is completely filled with the byte value the memory was cleared with.
+static const unsigned LAZY_THRESHOLD = 64 * 1024;
+
+#if HAVE_MMAP
+// Returns a file descriptor of a file of at least 'size' bytes all equal to
+// 'c', or -1 on error. (For zero there's no file, see mapPattern().)
+static int getPatternFile(byte c, size_t size)
+{
+	struct PatternFile {
+		FILE* file = nullptr;
+		size_t size = 0;
+	};
+	static PatternFile patternFiles[256];
+
+	auto& pattern = patternFiles[c];
+	if (!pattern.file) {
+		pattern.file = tmpfile(); // never closed
+		if (!pattern.file) return -1;
+	}
+	if (pattern.size < size) {
+		byte buf[4096];
+		memset(buf, c, sizeof(buf));
+		fseek(pattern.file, long(pattern.size), SEEK_SET);
+		while (pattern.size < size) {
+			if (fwrite(buf, sizeof(buf), 1, pattern.file) != 1) {
+				return -1;
+			}
+			pattern.size += sizeof(buf);
+		}
+		if (fflush(pattern.file) != 0) return -1;
+	}
+	return fileno(pattern.file);
+}
+
+// Map 'size' bytes (private, copy-on-write) that read as 'c'. When 'addr' is
+// not nullptr the existing mapping at that address is replaced, that also
+// releases all pages that were written before.
+static byte* mapPattern(byte* addr, byte c, size_t size)
+{
+	int flags = MAP_PRIVATE | (addr ? MAP_FIXED : 0);
+	int fd = -1;
+	if (c == 0) {
+		flags |= MAP_ANONYMOUS;
+	} else {
+		fd = getPatternFile(c, size);
+		if (fd == -1) return nullptr;
+	}
+	void* result = mmap(addr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+	return (result == MAP_FAILED) ? nullptr : static_cast<byte*>(result);
+}
+#endif
+
 Ram::Ram(const DeviceConfig& config, const string& name,
          const string& description, unsigned size_)
 	: xml(*config.getXML())
-	, ram(size_)
 	, size(size_)
 	, debuggable(std::make_unique<RamDebuggable>(
 		config.getMotherBoard(), name, description, *this))
 {
+	allocate();
 	clear();
 }
 
 Ram::Ram(const XMLElement& xml_, unsigned size_)
 	: xml(xml_)
-	, ram(size_)
 	, size(size_)
 {
+	allocate();
 	clear();
 }
 
-Ram::~Ram() = default;
+Ram::~Ram()
+{
+	if (huge) MemoryOps::freeHuge(data, size);
+#if HAVE_MMAP
+	if (mapped) munmap(data, size);
+#endif
+}
+
+void Ram::allocate()
+{
+	// Huge pages get committed as a whole on first access, so lazily
+	// committing (below) would bring nothing for such memories.
+	if (auto* p = MemoryOps::mallocHuge(size)) {
+		data = static_cast<byte*>(p);
+		huge = true;
+		return;
+	}
+#if HAVE_MMAP
+	if (size >= LAZY_THRESHOLD) {
+		if (auto* p = mapPattern(nullptr, 0, size)) {
+			data = p;
+			mapped = true;
+			return;
+		}
+	}
+#endif
+	ram.resize(size);
+	data = ram.data();
+}
+
+bool Ram::fillLazily(byte c)
+{
+#if HAVE_MMAP
+	// Replacing the mapping (at the same address) can only fail when
+	// the system is out of resources, then fall back to memset().
+	return mapped && mapPattern(data, c, size);
+#else
+	(void)c;
+	return false;
+#endif
+}
 
 void Ram::clear(byte c)
 {
@@ -57,7 +159,7 @@ void Ram::clear(byte c)
 		if (encoding == "gz-base64") {
 			auto p = Base64::decode(init->getData());
 			uLongf dstLen = getSize();
-			if (uncompress(reinterpret_cast<Bytef*>(ram.data()), &dstLen,
+			if (uncompress(reinterpret_cast<Bytef*>(data), &dstLen,
 			               reinterpret_cast<const Bytef*>(p.first.data()), uLong(p.second))
 			     != Z_OK) {
 				throw MSXException("Error while decompressing initialContent.");
@@ -71,7 +173,7 @@ void Ram::clear(byte c)
 				throw MSXException("Zero-length initial pattern");
 			}
 			done = std::min(size_t(size), p.second);
-			memcpy(ram.data(), p.first.data(), done);
+			memcpy(data, p.first.data(), done);
 		} else {
 			throw MSXException("Unsupported encoding \"", encoding,
 			                   "\" for initialContent");
@@ -81,13 +183,13 @@ void Ram::clear(byte c)
 		auto left = size - done;
 		while (left) {
 			auto tmp = std::min(done, left);
-			memcpy(&ram[done], &ram[0], tmp);
+			memcpy(&data[done], &data[0], tmp);
 			done += tmp;
 			left -= tmp;
 		}
-	} else {
+	} else if (!fillLazily(c)) {
 		// no init pattern specified
-		memset(ram.data(), c, size);
+		memset(data, c, size);
 	}
 
 }
@@ -115,11 +217,30 @@ void RamDebuggable::write(unsigned address, byte value)
 	ram[address] = value;
 }
 
+void RamDebuggable::readBlock(unsigned address, byte* output, unsigned num)
+{
+	memcpy(output, &ram[address], num);
+}
+
 
 template<typename Archive>
 void Ram::serialize(Archive& ar, unsigned /*version*/)
 {
-	ar.serialize_blob("ram", ram.data(), size);
+	if (ar.isLoader() && mapped) {
+		// Only write the pages that actually change, so that pages
+		// that were never written remain uncommitted.
+		MemBuffer<byte> tmp(size);
+		ar.serialize_blob("ram", tmp.data(), size);
+		static const unsigned PAGE = 4096;
+		for (unsigned addr = 0; addr < size; addr += PAGE) {
+			unsigned len = std::min(PAGE, size - addr);
+			if (memcmp(&data[addr], &tmp[addr], len) != 0) {
+				memcpy(&data[addr], &tmp[addr], len);
+			}
+		}
+	} else {
+		ar.serialize_blob("ram", data, size);
+	}
 }
 INSTANTIATE_SERIALIZE_METHODS(Ram);
 
@@ -25,10 +25,10 @@ public:
 	~Ram();
 
 	const byte& operator[](unsigned addr) const {
-		return ram[addr];
+		return data[addr];
 	}
 	byte& operator[](unsigned addr) {
-		return ram[addr];
+		return data[addr];
 	}
 	unsigned getSize() const {
 		return size;
@@ -41,9 +41,15 @@ public:
 	void serialize(Archive& ar, unsigned version);
 
 private:
+	void allocate();
+	bool fillLazily(byte c);
+
 	const XMLElement& xml;
-	MemBuffer<byte> ram;
+	MemBuffer<byte> ram; // not used when the memory is mapped or huge
+	byte* data;
 	unsigned size; // must come before debuggable
+	bool mapped = false;
+	bool huge = false; // allocated with MemoryOps::mallocHuge()
 	const std::unique_ptr<RamDebuggable> debuggable; // can be nullptr
 };
 
@@ -21,6 +21,7 @@
 #include "sha1.hh"
 #include <cstring>
 #include <limits>
+#include <map>
 #include <memory>
 
 using std::string;
@@ -37,12 +38,45 @@ public:
 	const std::string& getDescription() const override;
 	byte read(unsigned address) override;
 	void write(unsigned address, byte value) override;
+	void readBlock(unsigned address, byte* output, unsigned num) override;
 	void moved(Rom& r);
 private:
 	Debugger& debugger;
 	Rom* rom;
 };
 
+// Process-wide store of rom content that is built in memory, keyed on (the
+// sha1 of) the content. Identical images (e.g. the same padded MegaROM in
+// several machines) share a single buffer. Roms that are simply mapped from
+// a file already share the pages of that file.
+static std::map<Sha1Sum, std::weak_ptr<const MemBuffer<byte>>> romStore;
+
+static std::shared_ptr<const MemBuffer<byte>> shareRomData(
+	const Sha1Sum& key, MemBuffer<byte> data)
+{
+	auto it = romStore.find(key);
+	if (it != end(romStore)) {
+		if (auto shared = it->second.lock()) return shared;
+	}
+	// forget about buffers that are no longer used
+	for (auto it2 = begin(romStore); it2 != end(romStore); /**/) {
+		if (it2->second.expired()) {
+			it2 = romStore.erase(it2);
+		} else {
+			++it2;
+		}
+	}
+	auto shared = std::make_shared<const MemBuffer<byte>>(std::move(data));
+	romStore[key] = shared;
+	return shared;
+}
+
+static std::shared_ptr<const MemBuffer<byte>> shareRomData(
+	MemBuffer<byte> data, size_t size)
+{
+	auto sha1 = SHA1::calc(data.data(), size);
+	return shareRomData(sha1, std::move(data));
+}
 
 Rom::Rom(string name_, string description_,
          const DeviceConfig& config, const string& id /*= {}*/)
@@ -180,12 +214,15 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 				"supported.");
 		}
 		try {
-			auto mmap = file.mmap();
-			if (mmap.size() > std::numeric_limits<decltype(size)>::max()) {
+			// Prefer a read-only shared mapping, then all machines
+			// (and processes) that use this rom share its memory.
+			span<const uint8_t> mapped = file.mmapShared();
+			if (mapped.empty()) mapped = file.mmap();
+			if (mapped.size() > std::numeric_limits<decltype(size)>::max()) {
 				throw MSXException("Rom file too big: ", file.getURL());
 			}
-			rom = mmap.data();
-			size = unsigned(mmap.size());
+			rom = mapped.data();
+			size = unsigned(mapped.size());
 		} catch (FileException&) {
 			throw MSXException("Error reading ROM image: ", file.getURL());
 		}
@@ -213,9 +250,10 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 		// the size of the mapper (and you don't care about initial
 		// content)
 		size = config.getChildDataAsInt("size", 0) * 1024; // in kb
-		extendedRom.resize(size);
-		memset(extendedRom.data(), 0xff, size);
-		rom = extendedRom.data();
+		MemBuffer<byte> tmp(size);
+		memset(tmp.data(), 0xff, size);
+		extendedRom = shareRomData(std::move(tmp), size);
+		rom = extendedRom->data();
 
 		// Content does not depend on external files. No need to check
 		checkResolvedSha1 = false;
@@ -234,18 +272,16 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 					Filename(p->getData(), context),
 					std::move(patch));
 			}
-			auto patchSize = unsigned(patch->getSize());
-			if (patchSize <= size) {
-				patch->copyBlock(0, const_cast<byte*>(rom), size);
-			} else {
-				size = patchSize;
-				extendedRom.resize(size);
-				patch->copyBlock(0, extendedRom.data(), size);
-				rom = extendedRom.data();
-			}
+			// The (shared) original content can't be modified,
+			// so always patch into a new buffer.
+			size = std::max(size, unsigned(patch->getSize()));
+			MemBuffer<byte> patched(size);
+			patch->copyBlock(0, patched.data(), size);
 
 			// calculated because it's different from original
-			actualSha1 = SHA1::calc(rom, size);
+			actualSha1 = SHA1::calc(patched.data(), size);
+			extendedRom = shareRomData(actualSha1, std::move(patched));
+			rom = extendedRom->data();
 
 			// Content altered by external patch file -> check.
 			checkResolvedSha1 = true;
@@ -378,8 +414,8 @@ void Rom::addPadding(unsigned newSize, byte filler)
 	memcpy(newData, rom, size);
 	memset(newData + size, filler, newSize - size);
 
-	extendedRom = std::move(tmp);
-	rom = newData;
+	extendedRom = shareRomData(std::move(tmp), newSize);
+	rom = extendedRom->data();
 	size = newSize;
 }
 
@@ -415,6 +451,12 @@ void RomDebuggable::write(unsigned /*address*/, byte /*value*/)
 	// ignore
 }
 
+void RomDebuggable::readBlock(unsigned address, byte* output, unsigned num)
+{
+	assert((address + num) <= getSize());
+	memcpy(output, &(*rom)[address], num);
+}
+
 void RomDebuggable::moved(Rom& r)
 {
 	rom = &r;
@@ -47,7 +47,10 @@ private:
 private:
 	// !! update the move constructor when changing these members !!
 	const byte* rom;
-	MemBuffer<byte> extendedRom;
+	// Content that isn't mapped from the file (padded, patched or empty
+	// roms). Immutable, so it's shared with identical roms, also those of
+	// other machines.
+	std::shared_ptr<const MemBuffer<byte>> extendedRom;
 
 	File file; // can be a closed file
 
@@ -7,6 +7,7 @@
 #include "MSXException.hh"
 #include "StringOp.hh"
 #include "String32.hh"
+#include "strCat.hh"
 #include "hash_map.hh"
 #include "ranges.hh"
 #include "rapidsax.hh"
@@ -28,10 +29,10 @@ class DBParser : public rapidsax::NullHandler
 {
 public:
 	DBParser(RomDatabase::RomDB& db_, UnknownTypes& unknownTypes_,
-	         CliComm& cliComm_, char* bufStart_)
+	         vector<string>& warnings_, char* bufStart_)
 		: db(db_)
 		, unknownTypes(unknownTypes_)
-		, cliComm(cliComm_)
+		, warnings(warnings_)
 		, bufStart(bufStart_)
 		, state(BEGIN)
 		, unknownLevel(0)
@@ -84,7 +85,7 @@ private:
 
 	RomDatabase::RomDB& db;
 	UnknownTypes& unknownTypes;
-	CliComm& cliComm;
+	vector<string>& warnings;
 	char* bufStart;
 
 	string_view systemID;
@@ -327,10 +328,10 @@ void DBParser::text(string_view txt)
 		try {
 			genMSXid = fast_stou(txt);
 		} catch (std::invalid_argument&) {
-			cliComm.printWarning(
+			warnings.push_back(strCat(
 				"Ignoring bad Generation MSX id (genmsxid) "
 				"in entry with title '", title,
-				": ", txt);
+				": ", txt));
 		}
 		break;
 	case ORIGINAL:
@@ -409,9 +410,9 @@ void DBParser::addAllEntries()
 	// move non-duplicates up
 	while (it2 != last) {
 		if (it1->first == it2->first) {
-			cliComm.printWarning(
+			warnings.push_back(strCat(
 				"duplicate softwaredb entry SHA1: ",
-				it2->first.toString());
+				it2->first.toString()));
 		} else {
 			++it1;
 			*it1 = std::move(*it2);
@@ -546,10 +547,10 @@ void DBParser::doctype(string_view txt)
 	systemID = t.substr(0, pos2);
 }
 
-static void parseDB(CliComm& cliComm, char* buf, char* bufStart,
+static void parseDB(vector<string>& warnings, char* buf, char* bufStart,
                     RomDatabase::RomDB& db, UnknownTypes& unknownTypes)
 {
-	DBParser handler(db, unknownTypes, cliComm, bufStart);
+	DBParser handler(db, unknownTypes, warnings, bufStart);
 	rapidsax::parse<rapidsax::trimWhitespace>(handler, buf);
 
 	if (handler.getSystemID() != "softwaredb1.dtd") {
@@ -560,12 +561,28 @@ static void parseDB(CliComm& cliComm, char* buf, char* bufStart,
 	}
 }
 
-RomDatabase::RomDatabase(CliComm& cliComm)
+RomDatabase::RomDatabase(CliComm& cliComm_)
+	: cliComm(cliComm_)
 {
-	db.reserve(3500);
-	UnknownTypes unknownTypes;
 	// first user- then system-directory
 	vector<string> paths = systemFileContext().getPaths();
+	// Parsing the database takes a while. It's only needed once the first
+	// ROM is loaded, so meanwhile we can already continue with the rest of
+	// the startup.
+	loader = std::thread([this, paths = std::move(paths)]() { load(paths); });
+}
+
+RomDatabase::~RomDatabase()
+{
+	if (loader.joinable()) loader.join();
+}
+
+void RomDatabase::load(const vector<string>& paths)
+{
+	// Note: this runs in a separate thread, so warnings are only collected
+	// here, they're printed in waitUntilLoaded().
+	db.reserve(3500);
+	UnknownTypes unknownTypes;
 	vector<File> files;
 	size_t bufferSize = 0;
 	for (auto& p : paths) {
@@ -589,17 +606,17 @@ RomDatabase::RomDatabase(CliComm& cliComm)
 			file.read(buf, size);
 			buf[size] = 0;
 
-			parseDB(cliComm, buf, buffer.data(), db, unknownTypes);
+			parseDB(warnings, buf, buffer.data(), db, unknownTypes);
 		} catch (rapidsax::ParseError& e) {
-			cliComm.printWarning(
-				"Rom database parsing failed: ", e.what());
+			warnings.push_back(strCat(
+				"Rom database parsing failed: ", e.what()));
 		} catch (MSXException& /*e*/) {
 			// Ignore, see above
 		}
 	}
 	if (bufferSize) buffer[0] = 0;
 	if (db.empty()) {
-		cliComm.printWarning(
+		warnings.emplace_back(
 			"Couldn't load software database.\n"
 			"This may cause incorrect ROM mapper types to be used.");
 	}
@@ -608,12 +625,23 @@ RomDatabase::RomDatabase(CliComm& cliComm)
 		for (auto& p : unknownTypes) {
 			strAppend(output, p.first, " (", p.second, "x); ");
 		}
-		cliComm.printWarning(output);
+		warnings.push_back(std::move(output));
+	}
+}
+
+void RomDatabase::waitUntilLoaded() const
+{
+	if (!loader.joinable()) return;
+	loader.join();
+	for (auto& w : warnings) {
+		cliComm.printWarning(w);
 	}
+	warnings.clear();
 }
 
 const RomInfo* RomDatabase::fetchRomInfo(const Sha1Sum& sha1sum) const
 {
+	waitUntilLoaded();
 	auto it = ranges::lower_bound(db, sha1sum, LessTupleElement<0>());
 	return ((it != end(db)) && (it->first == sha1sum))
 		? &it->second : nullptr;
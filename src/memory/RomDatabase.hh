@@ -3,6 +3,8 @@
 
 #include "MemBuffer.hh"
 #include "sha1.hh"
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -16,18 +18,33 @@ class RomDatabase
 public:
 	using RomDB = std::vector<std::pair<Sha1Sum, RomInfo>>;
 
-	RomDatabase(CliComm& cliComm);
+	/** Starts loading the database in a background thread.
+	 */
+	explicit RomDatabase(CliComm& cliComm);
+	~RomDatabase();
 
 	/** Lookup an entry in the database by sha1sum.
 	 * Returns nullptr when no corresponding entry was found.
+	 * Waits till the database is loaded.
 	 */
 	const RomInfo* fetchRomInfo(const Sha1Sum& sha1sum) const;
 
-	const char* getBufferStart() const { return buffer.data(); }
+	const char* getBufferStart() const {
+		waitUntilLoaded();
+		return buffer.data();
+	}
 
 private:
+	void load(const std::vector<std::string>& paths);
+	void waitUntilLoaded() const;
+
+	CliComm& cliComm;
 	RomDB db;
 	MemBuffer<char> buffer;
+
+	// only used during loading
+	mutable std::thread loader;
+	mutable std::vector<std::string> warnings;
 };
 
 } // namespace openmsx
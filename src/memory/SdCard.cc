@@ -6,6 +6,7 @@
 #include "endian.hh"
 #include "serialize.hh"
 #include "serialize_stl.hh"
+#include <algorithm>
 #include <memory>
 
 // TODO:
@@ -34,6 +35,9 @@ static const byte R1_IDLE            = 0x01; // TODO: why is lots of code checki
 static const byte R1_ILLEGAL_COMMAND = 0x04;
 static const byte R1_PARAMETER_ERROR = 0x80;
 
+// number of sectors that are read at once during a multiple block read
+static const unsigned PREFETCH_SECTORS = 32; // 16kB
+
 SdCard::SdCard(const DeviceConfig& config)
 	: hd(config.getXML() ? std::make_unique<HD>(config) : nullptr)
 	, cmdIdx(0)
@@ -41,6 +45,7 @@ SdCard::SdCard(const DeviceConfig& config)
 	, mode(COMMAND)
 	, currentSector(0)
 	, currentByteInSector(0)
+	, prefetchBuf(hd ? PREFETCH_SECTORS : 0)
 {
 }
 
@@ -52,7 +57,11 @@ byte SdCard::readCurrentByteFromCurrentSector() {
 	if (currentByteInSector == -1) {
 		retval = START_BLOCK_TOKEN;
 		try {
-			hd->readSector(currentSector, sectorBuf);
+			if (mode == MULTI_READ) {
+				readPrefetched(currentSector, sectorBuf);
+			} else {
+				hd->readSector(currentSector, sectorBuf);
+			}
 		} catch (MSXException&) {
 			retval = DATA_ERROR_TOKEN_ERROR;
 		}
@@ -67,6 +76,26 @@ byte SdCard::readCurrentByteFromCurrentSector() {
 	return retval;
 }
 
+// A multiple block read (almost always) continues with the next sectors, so
+// read a whole range from the image at once instead of sector per sector.
+void SdCard::readPrefetched(unsigned sector, SectorBuffer& buf)
+{
+	if ((sector - prefetchStart) >= prefetchCount) { // also if sector < start
+		prefetchStart = sector;
+		prefetchCount = 0;
+		auto num = unsigned(std::min<size_t>(
+			PREFETCH_SECTORS, hd->getNbSectors() - sector));
+		if (hd->readSectors(prefetchBuf.data(), sector, num) != 0) {
+			// error somewhere in this range, only read the requested
+			// sector (throws if that's the one that failed)
+			hd->readSector(sector, buf);
+			return;
+		}
+		prefetchCount = num;
+	}
+	buf = prefetchBuf[sector - prefetchStart];
+}
+
 byte SdCard::transfer(byte value, bool cs)
 {
 	if (!hd) return 0xFF; // no card inserted
@@ -210,6 +239,7 @@ void SdCard::executeCommand()
 	// it takes 2 transfers (2x8 cycles) before a reply
 	// can be given to a command
 	transferDelayCounter = 2;
+	prefetchCount = 0; // image may have changed since the last command
 	byte command = cmdBuf[0] & 0x3F;
 	switch (command) {
 	case 0:  // GO_IDLE_STATE
@@ -4,6 +4,7 @@
 #include "openmsx.hh"
 #include "circular_buffer.hh"
 #include "DiskImageUtils.hh"
+#include "MemBuffer.hh"
 #include <memory>
 
 namespace openmsx {
@@ -34,6 +35,7 @@ public:
 private:
 	void executeCommand();
 	byte readCurrentByteFromCurrentSector();
+	void readPrefetched(unsigned sector, SectorBuffer& buf);
 
 	const std::unique_ptr<HD> hd; // can be nullptr
 
@@ -47,6 +49,12 @@ private:
 	Mode mode;
 	unsigned currentSector;
 	int currentByteInSector;
+
+	// Sectors read ahead during a multiple block read. Not serialized,
+	// it's only valid during one command.
+	MemBuffer<SectorBuffer> prefetchBuf;
+	unsigned prefetchStart = 0;
+	unsigned prefetchCount = 0;
 };
 
 } // namespace openmsx
@@ -2,20 +2,23 @@
 #define TRACKED_RAM_HH
 
 #include "Ram.hh"
+#include "DirtyPages.hh"
 
 namespace openmsx {
 
-// Ram with dirty tracking
+// Ram with dirty tracking (per page, see DirtyPages)
 class TrackedRam
 {
 public:
 	// Most methods simply delegate to the internal 'ram' object.
 	TrackedRam(const DeviceConfig& config, const std::string& name,
 	           const std::string& description, unsigned size)
-		: ram(config, name, description, size) {}
+		: ram(config, name, description, size)
+		, dirty(ram.getSize()) {}
 
 	TrackedRam(const XMLElement& xml, unsigned size)
-		: ram(xml, size) {}
+		: ram(xml, size)
+		, dirty(ram.getSize()) {}
 
 	unsigned getSize() const {
 		return ram.getSize();
@@ -36,12 +39,12 @@ public:
 
 	// Only allow write/clear via an explicit method.
 	void write(unsigned addr, byte value) {
-		writeSinceLastReverseSnapshot = true;
+		dirty.markDirty(addr);
 		ram[addr] = value;
 	}
 
 	void clear(byte c = 0xff) {
-		writeSinceLastReverseSnapshot = true;
+		dirty.markAllDirty();
 		ram.clear(c);
 	}
 
@@ -50,7 +53,7 @@ public:
 	// invocation, so the resulting pointer (although the same each time)
 	// should not be reused for multiple (distinct) bulk write operations.
 	byte* getWriteBackdoor() {
-		writeSinceLastReverseSnapshot = true;
+		dirty.markAllDirty();
 		return &ram[0];
 	}
 
@@ -59,7 +62,7 @@ public:
 
 private:
 	Ram ram;
-	bool writeSinceLastReverseSnapshot = true;
+	DirtyPages dirty; // pages written since last reverse snapshot
 };
 
 } // namespace openmsx
@@ -5,8 +5,11 @@
 #include "Scheduler.hh"
 #include "FileOperations.hh"
 #include "serialize.hh"
-#include <cstdio>
+#include "unistdp.hh"
+#include <cassert>
 #include <cerrno>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
 
 using std::string;
@@ -71,39 +74,60 @@ string_view MidiInReader::getDescription() const
 
 void MidiInReader::run()
 {
-	byte buf;
 	if (!file) return;
 	while (true) {
+		// Read blocks of data, not byte per byte.
+		byte buf[256];
 #ifndef _WIN32
 		if (poller.poll(fileno(file.get()))) {
 			break;
 		}
+		// After poll() the data can be read without blocking, but
+		// fread() would wait till the whole buffer is filled.
+		ssize_t n = read(fileno(file.get()), buf, sizeof(buf));
+		size_t num = (n > 0) ? size_t(n) : 0;
+#else
+		size_t num = fread(buf, 1, 1, file.get());
 #endif
-		size_t num = fread(&buf, 1, 1, file.get());
 		if (poller.aborted()) {
 			break;
 		}
-		if (num != 1) {
+		if (num == 0) {
 			continue;
 		}
 		assert(isPluggedIn());
 
-		{
-			std::lock_guard<std::mutex> lock(mutex);
-			queue.push_back(buf);
+		for (size_t i = 0; i < num; ++i) {
+			// When the interface doesn't pull the data fast enough
+			// (e.g. when reading from a regular file), wait till
+			// there's room again.
+			while (!queue.push(buf[i])) {
+				if (poller.aborted()) return;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		// Only wake up the main thread when it's not already going to
+		// look at the queue. Afterwards the interface pulls the next
+		// bytes itself.
+		if (!eventPending.exchange(true)) {
+			eventDistributor.distributeEvent(
+				std::make_shared<SimpleEvent>(OPENMSX_MIDI_IN_READER_EVENT));
 		}
-		eventDistributor.distributeEvent(
-			std::make_shared<SimpleEvent>(OPENMSX_MIDI_IN_READER_EVENT));
 	}
 }
 
+void MidiInReader::clearQueue()
+{
+	byte dummy;
+	while (queue.pop(dummy)) /*empty*/;
+}
+
 // MidiInDevice
 void MidiInReader::signal(EmuTime::param time)
 {
 	auto* conn = static_cast<MidiInConnector*>(getConnector());
 	if (!conn->acceptsData()) {
-		std::lock_guard<std::mutex> lock(mutex);
-		queue.clear();
+		clearQueue();
 		return;
 	}
 	if (!conn->ready()) {
@@ -111,22 +135,18 @@ void MidiInReader::signal(EmuTime::param time)
 	}
 
 	byte data;
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		if (queue.empty()) return;
-		data = queue.pop_front();
-	}
+	if (!queue.pop(data)) return;
 	conn->recvByte(data, time);
 }
 
 // EventListener
 int MidiInReader::signalEvent(const std::shared_ptr<const Event>& /*event*/)
 {
+	eventPending = false;
 	if (isPluggedIn()) {
 		signal(scheduler.getCurrentTime());
 	} else {
-		std::lock_guard<std::mutex> lock(mutex);
-		queue.clear();
+		clearQueue();
 	}
 	return 0;
 }
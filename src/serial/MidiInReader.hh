@@ -6,9 +6,9 @@
 #include "FilenameSetting.hh"
 #include "FileOperations.hh"
 #include "openmsx.hh"
-#include "circular_buffer.hh"
+#include "MPSCQueue.hh"
 #include "Poller.hh"
-#include <mutex>
+#include <atomic>
 #include <thread>
 
 namespace openmsx {
@@ -38,6 +38,7 @@ public:
 
 private:
 	void run();
+	void clearQueue();
 
 	// EventListener
 	int signalEvent(const std::shared_ptr<const Event>& event) override;
@@ -46,8 +47,11 @@ private:
 	Scheduler& scheduler;
 	std::thread thread;
 	FileOperations::FILE_t file;
-	cb_queue<byte> queue;
-	std::mutex mutex; // to protect queue
+	// Filled by the reader thread, emptied by the main thread. The
+	// receiving MIDI interface pulls the bytes (see signal()) at the pace
+	// of its baud rate, so a small queue suffices.
+	MPSCQueue<byte, 4096> queue;
+	std::atomic_bool eventPending{false};
 	Poller poller;
 
 	FilenameSetting readFilenameSetting;
@@ -1,8 +1,10 @@
 #if defined(__APPLE__)
 
 #include "MidiOutCoreMIDI.hh"
+#include "IntegerSetting.hh"
 #include "PluggingController.hh"
 #include "PlugException.hh"
+#include "Timer.hh"
 #include "serialize.hh"
 #include "openmsx.hh"
 #include "StringOp.hh"
@@ -16,11 +18,28 @@ namespace openmsx {
 
 // MidiOutMessageBuffer ======================================================
 
+MidiOutMessageBuffer::MidiOutMessageBuffer(
+		std::shared_ptr<IntegerSetting> latencySetting_)
+	: latencySetting(std::move(latencySetting_))
+{
+}
+
 void MidiOutMessageBuffer::recvMessage(
-		const std::vector<uint8_t>& message, EmuTime::param /*time*/)
+		const std::vector<uint8_t>& message, EmuTime::param time)
 {
-	// TODO: It would be better to schedule events based on EmuTime.
 	MIDITimeStamp abstime = mach_absolute_time();
+	uint64_t latency = latencySetting->getInt() * 1000;
+	if (latency != 0) {
+		// Schedule the message at a fixed latency after its EmuTime.
+		uint64_t now = Timer::getTime();
+		uint64_t delay = timeMapper.map(time, now, latency) - now;
+		static mach_timebase_info_data_t timebase = [] {
+			mach_timebase_info_data_t result;
+			mach_timebase_info(&result);
+			return result;
+		}();
+		abstime += delay * 1000 * timebase.denom / timebase.numer;
+	}
 
 	MIDIPacketList packetList;
 	MIDIPacket *curPacket = MIDIPacketListInit(&packetList);
@@ -38,20 +57,26 @@ void MidiOutMessageBuffer::recvMessage(
 
 // MidiOutCoreMIDI ===========================================================
 
-void MidiOutCoreMIDI::registerAll(PluggingController& controller)
+void MidiOutCoreMIDI::registerAll(
+	PluggingController& controller,
+	const std::shared_ptr<IntegerSetting>& latencySetting)
 {
 	ItemCount numberOfEndpoints = MIDIGetNumberOfDestinations();
 	for (ItemCount i = 0; i < numberOfEndpoints; i++) {
 		MIDIEndpointRef endpoint = MIDIGetDestination(i);
 		if (endpoint) {
 			controller.registerPluggable(
-				std::make_unique<MidiOutCoreMIDI>(endpoint));
+				std::make_unique<MidiOutCoreMIDI>(
+					endpoint, latencySetting));
 		}
 	}
 }
 
-MidiOutCoreMIDI::MidiOutCoreMIDI(MIDIEndpointRef endpoint_)
-	: endpoint(endpoint_)
+MidiOutCoreMIDI::MidiOutCoreMIDI(
+		MIDIEndpointRef endpoint_,
+		std::shared_ptr<IntegerSetting> latencySetting)
+	: MidiOutMessageBuffer(std::move(latencySetting))
+	, endpoint(endpoint_)
 {
 	// Get a user-presentable name for the endpoint.
 	CFStringRef midiDeviceName;
@@ -121,8 +146,10 @@ REGISTER_POLYMORPHIC_INITIALIZER(Pluggable, MidiOutCoreMIDI, "MidiOutCoreMIDI");
 
 // MidiOutCoreMIDIVirtual ====================================================
 
-MidiOutCoreMIDIVirtual:: MidiOutCoreMIDIVirtual()
-	: client(0)
+MidiOutCoreMIDIVirtual::MidiOutCoreMIDIVirtual(
+		std::shared_ptr<IntegerSetting> latencySetting)
+	: MidiOutMessageBuffer(std::move(latencySetting))
+	, client(0)
 	, endpoint(0)
 {
 }
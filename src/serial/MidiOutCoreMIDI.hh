@@ -4,12 +4,15 @@
 #if defined(__APPLE__)
 
 #include "MidiOutDevice.hh"
+#include "MidiOutTimeMapper.hh"
 #include <CoreMIDI/MIDIServices.h>
 
+#include <memory>
 #include <vector>
 
 namespace openmsx {
 
+class IntegerSetting;
 class PluggingController;
 
 /** Puts MIDI messages into a MIDIPacketList.
@@ -17,11 +20,19 @@ class PluggingController;
 class MidiOutMessageBuffer : public MidiOutDevice
 {
 protected:
+	/** @param latencySetting Messages are timestamped this many
+	  *        milliseconds after their EmuTime, 0 sends them directly. */
+	explicit MidiOutMessageBuffer(
+		std::shared_ptr<IntegerSetting> latencySetting);
+
 	virtual OSStatus sendPacketList(MIDIPacketList *myPacketList) = 0;
 
 private:
 	void recvMessage(
 			const std::vector<uint8_t>& message, EmuTime::param time) override;
+
+	std::shared_ptr<IntegerSetting> latencySetting;
+	MidiOutTimeMapper timeMapper;
 };
 
 /** Sends MIDI events to an existing CoreMIDI destination.
@@ -29,12 +40,15 @@ private:
 class MidiOutCoreMIDI final : public MidiOutMessageBuffer
 {
 public:
-	static void registerAll(PluggingController& controller);
+	static void registerAll(
+		PluggingController& controller,
+		const std::shared_ptr<IntegerSetting>& latencySetting);
 
 	/** Public for the sake of make_unique<>() - not intended for actual
 	  * public use.
 	  */
-	explicit MidiOutCoreMIDI(MIDIEndpointRef endpoint);
+	MidiOutCoreMIDI(MIDIEndpointRef endpoint,
+	                std::shared_ptr<IntegerSetting> latencySetting);
 
 	// Pluggable
 	void plugHelper(Connector& connector, EmuTime::param time) override;
@@ -64,7 +78,8 @@ private:
 class MidiOutCoreMIDIVirtual final : public MidiOutMessageBuffer
 {
 public:
-	explicit MidiOutCoreMIDIVirtual();
+	explicit MidiOutCoreMIDIVirtual(
+		std::shared_ptr<IntegerSetting> latencySetting);
 
 	// Pluggable
 	void plugHelper(Connector& connector, EmuTime::param time) override;
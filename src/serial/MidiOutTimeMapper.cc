@@ -0,0 +1,34 @@
+#include "MidiOutTimeMapper.hh"
+#include <algorithm>
+#include <cmath>
+
+namespace openmsx {
+
+// Allowed deviation of the mapping, beyond this the emulation is considered
+// to be out of sync with the host clock.
+static const uint64_t MAX_DRIFT = 100000; // 100ms
+
+uint64_t MidiOutTimeMapper::map(EmuTime::param time, uint64_t now,
+                                uint64_t latency)
+{
+	uint64_t target = 0;
+	bool resync = !synced || (time < emuBase) || (latency != lastLatency);
+	if (!resync) {
+		auto delta = uint64_t(llround((time - emuBase).toDouble() * 1000000.0));
+		target = hostBase + delta;
+		// Emulation is behind (target already passed) or ahead (e.g.
+		// fast forward) of the host clock.
+		resync = (target < now) || (target > (now + latency + MAX_DRIFT));
+	}
+	if (resync) {
+		emuBase = time;
+		hostBase = now + latency;
+		lastLatency = latency;
+		synced = true;
+		target = hostBase;
+	}
+	last = std::max(last, target);
+	return last;
+}
+
+} // namespace openmsx
@@ -0,0 +1,46 @@
+#ifndef MIDIOUTTIMEMAPPER_HH
+#define MIDIOUTTIMEMAPPER_HH
+
+#include "EmuTime.hh"
+#include <cstdint>
+
+namespace openmsx {
+
+/** Maps the emulated time of outgoing MIDI messages onto the host clock.
+  *
+  * The emulation runs in bursts (a time slice is emulated as fast as possible
+  * and then it waits for the host to catch up), so sending messages as soon
+  * as they are produced results in audible jitter. Instead the messages can be
+  * scheduled at the host time that corresponds to their EmuTime, plus a fixed
+  * latency that is larger than the length of such a burst.
+  *
+  * When the emulation doesn't run in sync with the host clock (e.g. while
+  * paused, fast forwarding or when the host can't keep up) the mapping is
+  * reset so that the next message is again scheduled 'latency' from now.
+  */
+class MidiOutTimeMapper
+{
+public:
+	/** @param time The EmuTime of the message.
+	  * @param now The current host time, in microseconds.
+	  * @param latency The latency, in microseconds.
+	  * @return The host time (in microseconds) at which the message should
+	  *         be sent. Never earlier than the result of the previous call,
+	  *         so that the order of the messages is preserved.
+	  */
+	uint64_t map(EmuTime::param time, uint64_t now, uint64_t latency);
+
+	/** Forget the mapping, e.g. after the device was (re)connected. */
+	void reset() { synced = false; }
+
+private:
+	EmuTime emuBase = EmuTime::zero;
+	uint64_t hostBase = 0;
+	uint64_t lastLatency = 0;
+	uint64_t last = 0;
+	bool synced = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -1,8 +1,11 @@
 #include "MidiSessionALSA.hh"
 #include "CliComm.hh"
+#include "IntegerSetting.hh"
 #include "MidiOutDevice.hh"
+#include "MidiOutTimeMapper.hh"
 #include "PlugException.hh"
 #include "PluggingController.hh"
+#include "Timer.hh"
 #include "serialize.hh"
 
 #include <iostream>
@@ -17,7 +20,8 @@ class MidiOutALSA final : public MidiOutDevice {
 public:
 	MidiOutALSA(
 			snd_seq_t& seq,
-			snd_seq_client_info_t& cinfo, snd_seq_port_info_t& pinfo);
+			snd_seq_client_info_t& cinfo, snd_seq_port_info_t& pinfo,
+			std::shared_ptr<IntegerSetting> latencySetting);
 	~MidiOutALSA() override;
 
 	// Pluggable
@@ -39,6 +43,10 @@ private:
 
 	snd_seq_t& seq;
 	snd_midi_event_t* event_parser;
+	std::shared_ptr<IntegerSetting> latencySetting;
+	MidiOutTimeMapper timeMapper;
+	uint64_t queueStart; // host time at which 'queue' was started
+	int queue;
 	int sourcePort;
 	int destClient;
 	int destPort;
@@ -49,8 +57,12 @@ private:
 
 MidiOutALSA::MidiOutALSA(
 		snd_seq_t& seq_,
-		snd_seq_client_info_t& cinfo, snd_seq_port_info_t& pinfo)
+		snd_seq_client_info_t& cinfo, snd_seq_port_info_t& pinfo,
+		std::shared_ptr<IntegerSetting> latencySetting_)
 	: seq(seq_)
+	, latencySetting(std::move(latencySetting_))
+	, queueStart(0)
+	, queue(-1)
 	, sourcePort(-1)
 	, destClient(snd_seq_port_info_get_client(&pinfo))
 	, destPort(snd_seq_port_info_get_port(&pinfo))
@@ -97,11 +109,25 @@ void MidiOutALSA::connect()
 
 	snd_midi_event_new(MAX_MESSAGE_SIZE, &event_parser);
 
+	// A queue is needed to schedule events, without one (very unlikely)
+	// all events are sent directly.
+	queue = snd_seq_alloc_queue(&seq);
+	if (queue >= 0) {
+		snd_seq_start_queue(&seq, queue, nullptr);
+		snd_seq_drain_output(&seq);
+		queueStart = Timer::getTime();
+	}
+	timeMapper.reset();
+
 	connected = true;
 }
 
 void MidiOutALSA::disconnect()
 {
+	if (queue >= 0) {
+		snd_seq_free_queue(&seq, queue);
+		queue = -1;
+	}
 	snd_midi_event_free(event_parser);
 	snd_seq_disconnect_to(&seq, sourcePort, destClient, destPort);
 	snd_seq_delete_simple_port(&seq, sourcePort);
@@ -120,7 +146,7 @@ string_view MidiOutALSA::getDescription() const
 }
 
 void MidiOutALSA::recvMessage(
-		const std::vector<uint8_t>& message, EmuTime::param /*time*/)
+		const std::vector<uint8_t>& message, EmuTime::param time)
 {
 	snd_seq_event_t ev;
 	snd_seq_ev_clear(&ev);
@@ -144,8 +170,19 @@ void MidiOutALSA::recvMessage(
 		return;
 	}
 
-	// Send event.
-	snd_seq_ev_set_direct(&ev);
+	// Send event, either directly or scheduled relative to the start of
+	// our queue.
+	uint64_t latency = latencySetting->getInt() * 1000;
+	if ((latency == 0) || (queue < 0)) {
+		snd_seq_ev_set_direct(&ev);
+	} else {
+		uint64_t now = Timer::getTime();
+		uint64_t target = timeMapper.map(time, now, latency) - queueStart;
+		snd_seq_real_time_t rt;
+		rt.tv_sec  = unsigned(target / 1000000);
+		rt.tv_nsec = unsigned(target % 1000000) * 1000;
+		snd_seq_ev_schedule_real(&ev, queue, 0, &rt);
+	}
 	int err = snd_seq_event_output(&seq, &ev);
 	if (err < 0) {
 		std::cerr << "Error sending MIDI event: "
@@ -170,7 +207,8 @@ REGISTER_POLYMORPHIC_INITIALIZER(Pluggable, MidiOutALSA, "MidiOutALSA");
 std::unique_ptr<MidiSessionALSA> MidiSessionALSA::instance;
 
 void MidiSessionALSA::registerAll(
-		PluggingController& controller, CliComm& cliComm)
+		PluggingController& controller, CliComm& cliComm,
+		const std::shared_ptr<IntegerSetting>& latencySetting)
 {
 	if (!instance) {
 		// Open the sequencer.
@@ -184,7 +222,7 @@ void MidiSessionALSA::registerAll(
 		snd_seq_set_client_name(seq, "openMSX");
 		instance.reset(new MidiSessionALSA(*seq));
 	}
-	instance->scanClients(controller);
+	instance->scanClients(controller, latencySetting);
 }
 
 MidiSessionALSA::MidiSessionALSA(snd_seq_t& seq_)
@@ -199,7 +237,9 @@ MidiSessionALSA::~MidiSessionALSA()
 	snd_seq_close(&seq);
 }
 
-void MidiSessionALSA::scanClients(PluggingController& controller)
+void MidiSessionALSA::scanClients(
+		PluggingController& controller,
+		const std::shared_ptr<IntegerSetting>& latencySetting)
 {
 	// Iterate through all clients.
 	snd_seq_client_info_t* cinfo;
@@ -226,7 +266,7 @@ void MidiSessionALSA::scanClients(PluggingController& controller)
 					SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE;
 			if ((snd_seq_port_info_get_capability(pinfo) & wrcaps) == wrcaps) {
 				controller.registerPluggable(std::make_unique<MidiOutALSA>(
-						seq, *cinfo, *pinfo
+						seq, *cinfo, *pinfo, latencySetting
 						));
 			}
 		}
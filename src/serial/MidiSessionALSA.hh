@@ -9,6 +9,7 @@ namespace openmsx {
 
 class CliComm;
 class EventDistributor;
+class IntegerSetting;
 class Scheduler;
 class PluggingController;
 
@@ -18,7 +19,10 @@ class PluggingController;
 class MidiSessionALSA final
 {
 public:
-	static void registerAll(PluggingController& controller, CliComm& cliComm);
+	/** @param latencySetting Outgoing messages are scheduled this many
+	  *        milliseconds after their EmuTime, 0 sends them directly. */
+	static void registerAll(PluggingController& controller, CliComm& cliComm,
+	                        const std::shared_ptr<IntegerSetting>& latencySetting);
 
 	~MidiSessionALSA();
 
@@ -26,7 +30,8 @@ private:
 	static std::unique_ptr<MidiSessionALSA> instance;
 
 	explicit MidiSessionALSA(snd_seq_t& seq);
-	void scanClients(PluggingController& controller);
+	void scanClients(PluggingController& controller,
+	                 const std::shared_ptr<IntegerSetting>& latencySetting);
 
 	snd_seq_t& seq;
 };
@@ -0,0 +1,370 @@
+#ifndef _WIN32
+
+#include "RS232Net.hh"
+#include "RS232Connector.hh"
+#include "CliComm.hh"
+#include "CommandController.hh"
+#include "PlugException.hh"
+#include "EventDistributor.hh"
+#include "Scheduler.hh"
+#include "StringOp.hh"
+#include "serialize.hh"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace openmsx {
+
+// When this much output is pending, CTS is dropped. An MSX program that
+// doesn't look at CTS can still add more, up to the hard limit, beyond that
+// output is lost.
+static const size_t OUT_SOFT_LIMIT = 4096;
+static const size_t OUT_HARD_LIMIT = 1024 * 1024;
+
+RS232Net::RS232Net(EventDistributor& eventDistributor_,
+                   Scheduler& scheduler_,
+                   CommandController& commandController)
+	: eventDistributor(eventDistributor_), scheduler(scheduler_)
+	, cliComm(commandController.getCliComm())
+	, addressSetting(
+	        commandController, "rs232-net-address",
+	        "host:port of the TCP server the rs232-net pluggable connects "
+	        "to, or 'pty' to create a pseudo terminal instead",
+	        "127.0.0.1:2323")
+	, flowControlSetting(
+	        commandController, "rs232-net-flowcontrol",
+	        "hold back received data while the MSX deasserts RTS",
+	        true)
+{
+	eventDistributor.registerEventListener(OPENMSX_RS232_NET_EVENT, *this);
+}
+
+RS232Net::~RS232Net()
+{
+	eventDistributor.unregisterEventListener(OPENMSX_RS232_NET_EVENT, *this);
+}
+
+// Pluggable
+void RS232Net::plugHelper(Connector& connector_, EmuTime::param /*time*/)
+{
+	string_view address = addressSetting.getString();
+	if (address == "pty") {
+		openPty();
+	} else {
+		openSocket(address);
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	auto& rs232Connector = static_cast<RS232Connector&>(connector_);
+	rs232Connector.setDataBits(SerialDataInterface::DATA_8);	// 8 data bits
+	rs232Connector.setStopBits(SerialDataInterface::STOP_1);	// 1 stop bit
+	rs232Connector.setParityBit(false, SerialDataInterface::EVEN); // no parity
+
+	{
+		std::lock_guard<std::mutex> lock(outMutex);
+		outBuffer.clear();
+		outPos = 0;
+	}
+	clearQueue();
+	connected = true;
+	reportedClose = false;
+
+	setConnector(&connector_); // base class will do this in a moment,
+	                           // but thread already needs it
+	poller.reset();
+	thread = std::thread([this]() { run(); });
+}
+
+void RS232Net::openSocket(string_view address)
+{
+	string_view host, port;
+	StringOp::splitOnLast(address, ':', host, port);
+	if (host.empty() || port.empty()) {
+		throw PlugException("Invalid address, expected host:port: ",
+		                    address);
+	}
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo* infos;
+	if (int err = getaddrinfo(host.str().c_str(), port.str().c_str(),
+	                          &hints, &infos)) {
+		throw PlugException("Couldn't resolve ", address, ": ",
+		                    gai_strerror(err));
+	}
+	int error = 0;
+	for (addrinfo* info = infos; info; info = info->ai_next) {
+		fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+		if (fd == -1) {
+			error = errno;
+			continue;
+		}
+		if (connect(fd, info->ai_addr, info->ai_addrlen) == 0) break;
+		error = errno;
+		::close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(infos);
+	if (fd == -1) {
+		throw PlugException("Couldn't connect to ", address, ": ",
+		                    strerror(error));
+	}
+	// Serial data is often typed interactively, don't wait to fill
+	// packets.
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+	isSocket = true;
+}
+
+void RS232Net::openPty()
+{
+	fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if ((fd == -1) || grantpt(fd) || unlockpt(fd)) {
+		int error = errno;
+		if (fd != -1) ::close(fd);
+		fd = -1;
+		throw PlugException("Couldn't create pseudo terminal: ",
+		                    strerror(error));
+	}
+	const char* name = ptsname(fd);
+	ptySlave = name ? open(name, O_RDWR | O_NOCTTY) : -1;
+	if (ptySlave == -1) {
+		int error = errno;
+		::close(fd);
+		fd = -1;
+		throw PlugException("Couldn't open pseudo terminal: ",
+		                    strerror(error));
+	}
+	// Pass all bytes unmodified.
+	termios tio;
+	if (tcgetattr(ptySlave, &tio) == 0) {
+		cfmakeraw(&tio);
+		tcsetattr(ptySlave, TCSANOW, &tio);
+	}
+	isSocket = false;
+	cliComm.printInfo("RS232 is connected to pseudo terminal ", name);
+}
+
+void RS232Net::closeFd()
+{
+	if (ptySlave != -1) {
+		::close(ptySlave);
+		ptySlave = -1;
+	}
+	if (fd != -1) {
+		::close(fd);
+		fd = -1;
+	}
+}
+
+void RS232Net::unplugHelper(EmuTime::param /*time*/)
+{
+	poller.abort();
+	thread.join();
+	closeFd();
+	connected = false;
+	clearQueue();
+}
+
+const std::string& RS232Net::getName() const
+{
+	static const std::string name("rs232-net");
+	return name;
+}
+
+string_view RS232Net::getDescription() const
+{
+	return  "RS232 network pluggable. Connects the RS232 port to the TCP "
+		"server specified with the 'rs232-net-address' setting, or "
+		"to a new pseudo terminal when that setting is 'pty'.";
+}
+
+bool RS232Net::sendPending()
+{
+	// outMutex must be locked
+	while (outPos != outBuffer.size()) {
+		const byte* data = &outBuffer[outPos];
+		size_t size = outBuffer.size() - outPos;
+#ifdef MSG_NOSIGNAL
+		ssize_t n = isSocket ? send(fd, data, size, MSG_NOSIGNAL)
+		                     : write(fd, data, size);
+#else
+		ssize_t n = write(fd, data, size);
+#endif
+		if (n < 0) {
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) break;
+			if (errno == EINTR) continue;
+			return false;
+		}
+		outPos += n;
+	}
+	if (outPos == outBuffer.size()) {
+		outBuffer.clear();
+		outPos = 0;
+	}
+	return true;
+}
+
+void RS232Net::run()
+{
+	byte buf[1024];
+	size_t bufPos = 0; // bytes [bufPos, bufLen) are not yet in the queue
+	size_t bufLen = 0;
+	while (true) {
+		bool pushed = false;
+		while (bufPos != bufLen) {
+			if (!queue.push(buf[bufPos])) {
+				// Retry once after setting the flag, the main
+				// thread may have emptied the queue meanwhile.
+				readBlocked = true;
+				if (!queue.push(buf[bufPos])) break;
+			}
+			++bufPos;
+			pushed = true;
+		}
+		bool queueFull = bufPos != bufLen;
+		if (pushed && !eventPending.exchange(true)) {
+			eventDistributor.distributeEvent(
+				std::make_shared<SimpleEvent>(OPENMSX_RS232_NET_EVENT));
+		}
+
+		pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = queueFull ? 0 : POLLIN;
+		{
+			std::lock_guard<std::mutex> lock(outMutex);
+			if (!outBuffer.empty()) pfd.events |= POLLOUT;
+		}
+		if (poller.poll(&pfd, 1)) break;
+
+		if (pfd.revents & POLLOUT) {
+			std::lock_guard<std::mutex> lock(outMutex);
+			if (!sendPending()) break;
+		}
+		if (queueFull) {
+			// Only wait for room in the queue (or output). Don't
+			// spin on a hangup that will be handled later.
+			if (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			continue;
+		}
+		if (pfd.revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) {
+			ssize_t n = read(fd, buf, sizeof(buf));
+			if (n > 0) {
+				bufPos = 0;
+				bufLen = n;
+			} else if ((n == 0) ||
+			           ((errno != EAGAIN) && (errno != EWOULDBLOCK) &&
+			            (errno != EINTR))) {
+				break; // closed by the other side
+			}
+		}
+	}
+	if (!poller.aborted()) {
+		// Let the main thread report the closed connection.
+		connected = false;
+		eventDistributor.distributeEvent(
+			std::make_shared<SimpleEvent>(OPENMSX_RS232_NET_EVENT));
+	}
+}
+
+void RS232Net::clearQueue()
+{
+	byte dummy;
+	while (queue.pop(dummy)) /*empty*/;
+}
+
+// input
+void RS232Net::signal(EmuTime::param time)
+{
+	auto* conn = static_cast<RS232Connector*>(getConnector());
+	if (!conn->acceptsData()) {
+		clearQueue();
+		return;
+	}
+	if (!conn->ready()) return;
+	if (!rts && flowControlSetting.getBoolean()) return;
+
+	byte data;
+	if (!queue.pop(data)) return;
+	if (readBlocked.exchange(false)) {
+		poller.wakeUp();
+	}
+	conn->recvByte(data, time);
+}
+
+// EventListener
+int RS232Net::signalEvent(const std::shared_ptr<const Event>& /*event*/)
+{
+	eventPending = false;
+	if (isPluggedIn()) {
+		if (!connected && !reportedClose) {
+			reportedClose = true;
+			cliComm.printWarning("RS232 connection was closed.");
+		}
+		signal(scheduler.getCurrentTime());
+	} else {
+		clearQueue();
+	}
+	return 0;
+}
+
+// output
+void RS232Net::recvByte(byte value, EmuTime::param /*time*/)
+{
+	if (!connected) return;
+	std::lock_guard<std::mutex> lock(outMutex);
+	if (outBuffer.size() - outPos >= OUT_HARD_LIMIT) return;
+	bool wasEmpty = outBuffer.empty();
+	outBuffer.push_back(value);
+	if (wasEmpty) poller.wakeUp();
+}
+
+// control
+bool RS232Net::getCTS(EmuTime::param /*time*/) const
+{
+	std::lock_guard<std::mutex> lock(outMutex);
+	return (outBuffer.size() - outPos) < OUT_SOFT_LIMIT;
+}
+
+bool RS232Net::getDSR(EmuTime::param /*time*/) const
+{
+	return connected;
+}
+
+void RS232Net::setRTS(bool status, EmuTime::param time)
+{
+	bool resume = status && !rts;
+	rts = status;
+	if (resume && isPluggedIn()) {
+		// deliver the data that was held back
+		signal(time);
+	}
+}
+
+
+template<typename Archive>
+void RS232Net::serialize(Archive& /*ar*/, unsigned /*version*/)
+{
+	// don't try to resume a previous connection (see PrinterPortLogger)
+}
+INSTANTIATE_SERIALIZE_METHODS(RS232Net);
+REGISTER_POLYMORPHIC_INITIALIZER(Pluggable, RS232Net, "RS232Net");
+
+} // namespace openmsx
+
+#endif // _WIN32
@@ -0,0 +1,103 @@
+#ifndef RS232NET_HH
+#define RS232NET_HH
+
+#ifndef _WIN32
+
+#include "RS232Device.hh"
+#include "EventListener.hh"
+#include "StringSetting.hh"
+#include "BooleanSetting.hh"
+#include "MPSCQueue.hh"
+#include "Poller.hh"
+#include "openmsx.hh"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+class CliComm;
+class CommandController;
+class EventDistributor;
+class Scheduler;
+
+/** Connects the emulated RS232 port to a TCP socket or to a pseudo terminal
+  * on the host, e.g. to let MSX terminal or BBS software talk to a server.
+  *
+  * All host I/O is non-blocking and happens in blocks on a separate thread.
+  * Received data goes into a queue, from which the UART pulls the next byte
+  * each time it has received the previous one, so the data arrives at the
+  * emulated baud rate. Hardware flow control is emulated: while the MSX
+  * drops RTS no data is delivered (and reading from the host stops when the
+  * queue is full), while the output buffer is full CTS is dropped.
+  */
+class RS232Net final : public RS232Device, private EventListener
+{
+public:
+	RS232Net(EventDistributor& eventDistributor, Scheduler& scheduler,
+	         CommandController& commandController);
+	~RS232Net() override;
+
+	// Pluggable
+	void plugHelper(Connector& connector, EmuTime::param time) override;
+	void unplugHelper(EmuTime::param time) override;
+	const std::string& getName() const override;
+	string_view getDescription() const override;
+
+	// input
+	void signal(EmuTime::param time) override;
+
+	// output
+	void recvByte(byte value, EmuTime::param time) override;
+
+	// control
+	bool getCTS(EmuTime::param time) const override;
+	bool getDSR(EmuTime::param time) const override;
+	void setRTS(bool status, EmuTime::param time) override;
+
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
+
+private:
+	void openSocket(string_view address);
+	void openPty();
+	void closeFd();
+	void run();
+	bool sendPending();
+	void clearQueue();
+
+	// EventListener
+	int signalEvent(const std::shared_ptr<const Event>& event) override;
+
+	EventDistributor& eventDistributor;
+	Scheduler& scheduler;
+	CliComm& cliComm;
+	std::thread thread;
+	Poller poller;
+	int fd = -1;
+	int ptySlave = -1; // kept open, so the master doesn't report hangups
+	bool isSocket = false;
+
+	// input
+	MPSCQueue<byte, 4096> queue;
+	std::atomic_bool eventPending{false};
+	std::atomic_bool readBlocked{false}; // queue was full
+	bool rts = true;
+
+	// output
+	mutable std::mutex outMutex;
+	std::vector<byte> outBuffer; // protected by 'outMutex'
+	size_t outPos = 0;           // protected by 'outMutex'
+
+	std::atomic_bool connected{false};
+	bool reportedClose = false;
+
+	StringSetting addressSetting;
+	BooleanSetting flowControlSetting;
+};
+
+} // namespace openmsx
+
+#endif // _WIN32
+#endif // RS232NET_HH
@@ -1,15 +1,21 @@
 #include "serialize.hh"
+#include "EmuTime.hh"
 #include "Base64.hh"
 #include "HexDump.hh"
 #include "XMLLoader.hh"
 #include "XMLElement.hh"
-#include "ConfigException.hh"
 #include "XMLException.hh"
 #include "DeltaBlock.hh"
 #include "MemBuffer.hh"
 #include "FileOperations.hh"
 #include "Version.hh"
 #include "Date.hh"
+#include "File.hh"
+#include "endian.hh"
+#include "snappy.hh"
+#include "WorkerPool.hh"
+#include "ZlibInflate.hh"
+#include "ranges.hh"
 #include "stl.hh"
 #include "cstdiop.hh" // for dup()
 #include <cstring>
@@ -28,6 +34,7 @@ void ArchiveBase<Derived>::attribute(const char* name, const char* value)
 }
 template class ArchiveBase<MemOutputArchive>;
 template class ArchiveBase<XmlOutputArchive>;
+template class ArchiveBase<BinOutputArchive>;
 
 ////
 
@@ -69,6 +76,29 @@ unsigned OutputArchiveBase2::getID2(
 }
 
 
+static string gzBase64Encode(const uint8_t* data, size_t len)
+{
+	// TODO check for overflow?
+	auto dstLen = uLongf(len + len / 1000 + 12 + 1); // worst-case
+	MemBuffer<uint8_t> buf(dstLen);
+	if (compress2(buf.data(), &dstLen,
+	              reinterpret_cast<const Bytef*>(data),
+	              uLong(len), 9)
+	    != Z_OK) {
+		throw MSXException("Error while compressing blob.");
+	}
+	return Base64::encode(buf.data(), dstLen);
+}
+
+static void gzBase64Decode(string_view str, void* data, size_t len)
+{
+	auto p = Base64::decode(str);
+	if (!ZlibInflate::uncompress(span<const uint8_t>(p.first.data(), p.second),
+	                             static_cast<uint8_t*>(data), len)) {
+		throw MSXException("Error while decompressing blob.");
+	}
+}
+
 template<typename Derived>
 void OutputArchiveBase<Derived>::serialize_blob(
 	const char* tag, const void* data_, size_t len, bool /*diff*/)
@@ -86,16 +116,7 @@ void OutputArchiveBase<Derived>::serialize_blob(
 		tmp = Base64::encode(data, len);
 	} else {
 		encoding = "gz-base64";
-		// TODO check for overflow?
-		auto dstLen = uLongf(len + len / 1000 + 12 + 1); // worst-case
-		MemBuffer<uint8_t> buf(dstLen);
-		if (compress2(buf.data(), &dstLen,
-		              reinterpret_cast<const Bytef*>(data),
-		              uLong(len), 9)
-		    != Z_OK) {
-			throw MSXException("Error while compressing blob.");
-		}
-		tmp = Base64::encode(buf.data(), dstLen);
+		tmp = gzBase64Encode(data, len);
 	}
 	this->self().beginTag(tag);
 	this->self().attribute("encoding", encoding);
@@ -106,6 +127,7 @@ void OutputArchiveBase<Derived>::serialize_blob(
 
 template class OutputArchiveBase<MemOutputArchive>;
 template class OutputArchiveBase<XmlOutputArchive>;
+template class OutputArchiveBase<BinOutputArchive>;
 
 ////
 
@@ -141,14 +163,7 @@ void InputArchiveBase<Derived>::serialize_blob(
 	this->self().endTag(tag);
 
 	if (encoding == "gz-base64") {
-		auto p = Base64::decode(tmp);
-		auto dstLen = uLongf(len); // TODO check for overflow?
-		if ((uncompress(reinterpret_cast<Bytef*>(data), &dstLen,
-		                reinterpret_cast<const Bytef*>(p.first.data()), uLong(p.second))
-		     != Z_OK) ||
-		    (dstLen != len)) {
-			throw MSXException("Error while decompressing blob.");
-		}
+		gzBase64Decode(tmp, data, len);
 	} else if ((encoding == "hex") || (encoding == "base64")) {
 		bool ok = (encoding == "hex")
 		        ? HexDump::decode_inplace(tmp, static_cast<uint8_t*>(data), len)
@@ -165,6 +180,34 @@ void InputArchiveBase<Derived>::serialize_blob(
 
 template class InputArchiveBase<MemInputArchive>;
 template class InputArchiveBase<XmlInputArchive>;
+template class InputArchiveBase<BinInputArchive>;
+
+void XmlInputArchive::serialize_blob(const char* tag, void* data,
+                                     size_t len, bool diff)
+{
+	auto* from = elems.back().second;
+	auto* child = elems.back().first->findNextChild(tag, from);
+	auto* encoding = child ? child->findAttribute("encoding") : nullptr;
+	if (encoding && (*encoding == "ref")) {
+		beginTag(tag);
+		loadBlobRef(*child, data, len);
+		endTag(tag);
+		return;
+	}
+	auto it = ranges::lower_bound(decodedBlobs, child,
+		[](const DecodedBlob& b, const XMLDocument::Node* e) { return b.elem < e; });
+	if (child && (it != end(decodedBlobs)) && (it->elem == child) &&
+	    (it->size == len)) {
+		beginTag(tag);
+		memcpy(data, it->data.data(), len);
+		if (!it->referenced) {
+			it->data = MemBuffer<uint8_t>(); // no longer needed
+		}
+		endTag(tag);
+	} else {
+		InputArchiveBase<XmlInputArchive>::serialize_blob(tag, data, len, diff);
+	}
+}
 
 ////
 
@@ -222,6 +265,7 @@ void MemOutputArchive::serialize_blob(const char* /*tag*/, const void* data,
 				data, static_cast<const uint8_t*>(data), len)
 			: lastDeltaBlocks.createNullDiff(
 				data, static_cast<const uint8_t*>(data), len));
+		if (stats) stats->addBlob(deltaBlocks.back()->getAllocSize());
 	} else {
 		uint8_t* buf = buffer.allocate(len);
 		memcpy(buf, data, len);
@@ -229,6 +273,24 @@ void MemOutputArchive::serialize_blob(const char* /*tag*/, const void* data,
 
 }
 
+void MemOutputArchive::serialize_blob(const char* /*tag*/, const void* data,
+                                      size_t len, const DirtyPages& dirty)
+{
+	assert(reverseSnapshot);
+	if (len > SMALL_SIZE) {
+		auto deltaBlockIdx = unsigned(deltaBlocks.size());
+		save(deltaBlockIdx); // see comment below in MemInputArchive
+		auto* bytes = static_cast<const uint8_t*>(data);
+		deltaBlocks.push_back(dirty.anyDirty()
+			? lastDeltaBlocks.createNew(data, bytes, len, &dirty)
+			: lastDeltaBlocks.createNullDiff(data, bytes, len));
+		if (stats) stats->addBlob(deltaBlocks.back()->getAllocSize());
+	} else {
+		uint8_t* buf = buffer.allocate(len);
+		memcpy(buf, data, len);
+	}
+}
+
 void MemInputArchive::serialize_blob(const char* /*tag*/, void* data,
                                      size_t len, bool /*diff*/)
 {
@@ -251,23 +313,28 @@ void MemInputArchive::serialize_blob(const char* /*tag*/, void* data,
 
 ////
 
-XmlOutputArchive::XmlOutputArchive(const string& filename)
-	: root("serial")
+XmlOutputArchive::XmlOutputArchive(const string& filename,
+                                   int compressionLevel)
+	: depth(0), state(CHILDREN)
 {
-	root.addAttribute("openmsx_version", Version::full());
-	root.addAttribute("date_time", Date::toString(time(nullptr)));
-	root.addAttribute("platform", TARGET_PLATFORM);
 	{
 		auto f = FileOperations::openFile(filename, "wb");
 		if (!f) goto error;
 		int duped_fd = dup(fileno(f.get()));
 		if (duped_fd == -1) goto error;
-		file = gzdopen(duped_fd, "wb9");
+		assert((0 <= compressionLevel) && (compressionLevel <= 9));
+		char mode[] = { 'w', 'b', char('0' + compressionLevel), '\0' };
+		file = gzdopen(duped_fd, mode);
 		if (!file) {
 			::close(duped_fd);
 			goto error;
 		}
-		current.push_back(&root);
+		buffer = "<?xml version=\"1.0\" ?>\n"
+		         "<!DOCTYPE openmsx-serialize SYSTEM 'openmsx-serialize.dtd'>\n";
+		beginTag("serial");
+		attribute("openmsx_version", Version::full());
+		attribute("date_time", Date::toString(time(nullptr)));
+		attribute("platform", TARGET_PLATFORM);
 		return; // success
 		// on scope-exit 'File* f' is closed, and 'gzFile file'
 		// uses the dup()'ed file descriptor.
@@ -281,18 +348,13 @@ void XmlOutputArchive::close()
 {
 	if (!file) return; // already closed
 
-	assert(current.back() == &root);
-	const char* header =
-	    "<?xml version=\"1.0\" ?>\n"
-	    "<!DOCTYPE openmsx-serialize SYSTEM 'openmsx-serialize.dtd'>\n";
-	string dump = root.dump();
-	if ((gzwrite(file, const_cast<char*>(header), unsigned(strlen(header))) == 0) ||
-	    (gzwrite(file, const_cast<char*>(dump.data()), unsigned(dump.size())) == 0) ||
-	    (gzclose(file) != Z_OK)) {
+	assert(depth == 1);
+	endTag("serial");
+	gzFile f = file;
+	file = nullptr; // also when writing fails, don't try to close again
+	if (!write(f) || (gzclose(f) != Z_OK)) {
 		throw XMLException("Could not write savestate file.");
 	}
-
-	file = nullptr;
 }
 
 XmlOutputArchive::~XmlOutputArchive()
@@ -304,21 +366,43 @@ XmlOutputArchive::~XmlOutputArchive()
 	}
 }
 
+bool XmlOutputArchive::write(gzFile f)
+{
+	if (buffer.empty()) return true;
+	bool ok = gzwrite(f, const_cast<char*>(buffer.data()), unsigned(buffer.size())) != 0;
+	buffer.clear();
+	return ok;
+}
+
+void XmlOutputArchive::flush()
+{
+	// The XML is not built in memory, instead it's written (compressed)
+	// while the objects are serialized. Only bundle small writes.
+	if (buffer.size() < 64 * 1024) return;
+	if (!write(file)) {
+		throw XMLException("Could not write savestate file.");
+	}
+}
+
 void XmlOutputArchive::saveChar(char c)
 {
 	save(string(1, c));
 }
 void XmlOutputArchive::save(const string& str)
 {
-	assert(!current.empty());
-	assert(current.back()->getData().empty());
-	current.back()->setData(str);
+	assert(depth != 0);
+	assert(state == OPEN);
+	if (str.empty()) return; // written as an empty tag
+	strAppend(buffer, '>', XMLElement::XMLEscape(str));
+	state = DATA;
+	flush();
 }
 void XmlOutputArchive::save(bool b)
 {
-	assert(!current.empty());
-	assert(current.back()->getData().empty());
-	current.back()->setData(b ? "true" : "false");
+	assert(depth != 0);
+	assert(state == OPEN);
+	strAppend(buffer, '>', b ? "true" : "false");
+	state = DATA;
 }
 void XmlOutputArchive::save(unsigned char b)
 {
@@ -347,9 +431,10 @@ void XmlOutputArchive::save(unsigned long long ull)
 
 void XmlOutputArchive::attribute(const char* name, const string& str)
 {
-	assert(!current.empty());
-	assert(!current.back()->hasAttribute(name));
-	current.back()->addAttribute(name, str);
+	// attributes must come before the content of a tag
+	assert(depth != 0);
+	assert(state == OPEN);
+	strAppend(buffer, ' ', name, "=\"", XMLElement::XMLEscape(str), '"');
 }
 void XmlOutputArchive::attribute(const char* name, int i)
 {
@@ -360,30 +445,147 @@ void XmlOutputArchive::attribute(const char* name, unsigned u)
 	attributeImpl(name, u);
 }
 
+void XmlOutputArchive::serialize_blob(const char* tag, const void* data,
+                                      size_t len, bool diff)
+{
+	if (len <= SMALL_SIZE) {
+		OutputArchiveBase<XmlOutputArchive>::serialize_blob(tag, data, len, diff);
+		return;
+	}
+	auto sum = SHA1::calc(static_cast<const uint8_t*>(data), len);
+	auto it = blobIds.find(sum);
+	beginTag(tag);
+	if (it != end(blobIds)) {
+		// Same content as an earlier blob, only store a reference.
+		attribute("encoding", "ref");
+		attribute("blob", it->second);
+	} else {
+		auto id = unsigned(blobIds.size() + 1);
+		blobIds.emplace(sum, id);
+		attribute("encoding", "gz-base64");
+		attribute("blob", id);
+		save(gzBase64Encode(static_cast<const uint8_t*>(data), len));
+	}
+	endTag(tag);
+}
+
 void XmlOutputArchive::beginTag(const char* tag)
 {
-	assert(!current.empty());
-	auto& elem = current.back()->addChild(tag);
-	current.push_back(&elem);
+	assert(state != DATA);
+	if (state == OPEN) {
+		// first child of the current tag
+		buffer += ">\n";
+	}
+	strAppend(buffer, spaces(2 * depth), '<', tag);
+	++depth;
+	state = OPEN;
 }
 void XmlOutputArchive::endTag(const char* tag)
 {
-	assert(!current.empty());
-	assert(current.back()->getName() == tag); (void)tag;
-	current.pop_back();
+	assert(depth != 0);
+	--depth;
+	switch (state) {
+	case OPEN: // no content
+		buffer += "/>\n";
+		break;
+	case DATA:
+		strAppend(buffer, "</", tag, ">\n");
+		break;
+	case CHILDREN:
+		strAppend(buffer, spaces(2 * depth), "</", tag, ">\n");
+		break;
+	}
+	state = CHILDREN; // (from the point of view of the parent tag)
+	flush();
 }
 
 ////
 
 XmlInputArchive::XmlInputArchive(const string& filename)
-	: rootElem(XMLLoader::load(filename, "openmsx-serialize.dtd"))
+	: doc(XMLLoader::loadDocument(filename, "openmsx-serialize.dtd"))
 {
-	elems.emplace_back(&rootElem, 0);
+	elems.emplace_back(doc.getRoot(), doc.getRoot()->getFirstChild());
+	decodeBlobs();
+}
+
+static void collectBlobs(const XMLDocument::Node& elem,
+                         std::vector<const XMLDocument::Node*>& result,
+                         hash_map<unsigned, const XMLDocument::Node*>& ids,
+                         std::vector<unsigned>& refs)
+{
+	if (auto* encoding = elem.findAttribute("encoding")) {
+		unsigned id;
+		bool hasId = elem.findAttributeInt("blob", id);
+		if (*encoding == "gz-base64") {
+			result.push_back(&elem);
+			if (hasId) ids[id] = &elem;
+		} else if ((*encoding == "ref") && hasId) {
+			refs.push_back(id);
+		}
+	}
+	for (auto* c = elem.getFirstChild(); c; c = c->getNextSibling()) {
+		collectBlobs(*c, result, ids, refs);
+	}
+}
+
+void XmlInputArchive::decodeBlobs()
+{
+	// Decoding the blobs (mostly memory content) takes a big part of the
+	// loading time, especially for replays with many snapshots. Decode
+	// them all in parallel upfront, serialize_blob() then only has to
+	// copy the result.
+	std::vector<const XMLDocument::Node*> elements;
+	std::vector<unsigned> refs;
+	collectBlobs(*doc.getRoot(), elements, blobElems, refs);
+	if (elements.size() < 2) return;
+	ranges::sort(elements);
+
+	decodedBlobs.resize(elements.size());
+	WorkerPool workers;
+	workers.parallelFor(elements.size(), [&](size_t i) {
+		auto& blob = decodedBlobs[i];
+		blob.elem = elements[i];
+		auto p = Base64::decode(blob.elem->getData());
+		if (!ZlibInflate::uncompress(span<const uint8_t>(p.first.data(), p.second),
+		                             blob.data, blob.size,
+		                             std::max<size_t>(4 * p.second, 1024))) {
+			// ignore, decode again (and report the error) later
+			blob.size = size_t(-1);
+		}
+	});
+
+	for (auto id : refs) {
+		auto* elem = lookup(blobElems, id);
+		if (!elem) continue; // error is reported in loadBlobRef()
+		auto it = ranges::lower_bound(decodedBlobs, *elem,
+			[](const DecodedBlob& b, const XMLDocument::Node* e) { return b.elem < e; });
+		if ((it != end(decodedBlobs)) && (it->elem == *elem)) {
+			it->referenced = true;
+		}
+	}
+}
+
+void XmlInputArchive::loadBlobRef(const XMLDocument::Node& ref, void* data,
+                                  size_t len)
+{
+	unsigned id = 0;
+	ref.findAttributeInt("blob", id);
+	auto* elem = lookup(blobElems, id);
+	if (!elem) {
+		throw XMLException("Reference to unknown blob ", id);
+	}
+	auto it = ranges::lower_bound(decodedBlobs, *elem,
+		[](const DecodedBlob& b, const XMLDocument::Node* e) { return b.elem < e; });
+	if ((it != end(decodedBlobs)) && (it->elem == *elem) && (it->size == len)) {
+		memcpy(data, it->data.data(), len);
+	} else {
+		gzBase64Decode((*elem)->getData(), data, len);
+	}
 }
 
 string_view XmlInputArchive::loadStr()
 {
-	if (!elems.back().first->getChildren().empty()) {
+	if (elems.back().first->hasChildren()) {
 		throw XMLException("No child tags expected for primitive type");
 	}
 	return elems.back().first->getData();
@@ -510,7 +712,7 @@ void XmlInputArchive::beginTag(const char* tag)
 		throw XMLException("No child tag \"", tag,
 		                   "\" found at location \"", path, '\"');
 	}
-	elems.emplace_back(child, 0);
+	elems.emplace_back(child, child->getFirstChild());
 }
 void XmlInputArchive::endTag(const char* tag)
 {
@@ -519,18 +721,18 @@ void XmlInputArchive::endTag(const char* tag)
 		throw XMLException("End tag \"", elem.getName(),
 		                   "\" not equal to begin tag \"", tag, "\"");
 	}
-	auto& elem2 = const_cast<XMLElement&>(elem);
+	auto& elem2 = const_cast<XMLDocument::Node&>(elem);
 	elem2.clearName(); // mark this elem for later beginTag() calls
 	elems.pop_back();
 }
 
 void XmlInputArchive::attribute(const char* name, string& t)
 {
-	try {
-		t = elems.back().first->getAttribute(name);
-	} catch (ConfigException& e) {
-		throw XMLException(std::move(e).getMessage());
+	auto* value = elems.back().first->findAttribute(name);
+	if (!value) {
+		throw XMLException("Missing attribute \"", name, "\".");
 	}
+	t = value->str();
 }
 void XmlInputArchive::attribute(const char* name, int& i)
 {
@@ -542,7 +744,7 @@ void XmlInputArchive::attribute(const char* name, unsigned& u)
 }
 bool XmlInputArchive::hasAttribute(const char* name)
 {
-	return elems.back().first->hasAttribute(name);
+	return elems.back().first->findAttribute(name) != nullptr;
 }
 bool XmlInputArchive::findAttribute(const char* name, unsigned& value)
 {
@@ -550,7 +752,332 @@ bool XmlInputArchive::findAttribute(const char* name, unsigned& value)
 }
 int XmlInputArchive::countChildren() const
 {
-	return int(elems.back().first->getChildren().size());
+	return int(elems.back().first->numChildren());
+}
+
+////
+
+// Binary savestate file format:
+//   header:  8 bytes  magic "OMSXBIN2" (or "OMSXBIN1", see below)
+//            string   openMSX version
+//            string   date and time
+//            string   platform
+//   followed by the serialized data.
+// Integers (and also booleans and characters) are stored as a variable length
+// quantity: 7 bits per byte, least significant group first, the upper bit
+// indicates whether more bytes follow. Signed integers are first zigzag
+// encoded. Floating point numbers are stored as 8 byte little endian IEEE
+// doubles. Strings are stored as a length followed by the characters. Blobs
+// are stored as a length, a compression method (0 = raw, 1 = snappy, 2 =
+// reference) and (for snappy) the compressed length followed by the
+// (compressed) bytes. A reference is followed by the file offset of an
+// earlier blob with identical content. Sections start with an 8 byte little
+// endian length, so that they can be skipped.
+// Since version 2 the type name of a polymorphic object is stored as a number:
+// 0 followed by the name for the first object of that type, otherwise the
+// (1-based) index of that name in the order of first occurrence. Also since
+// version 2 the time stamps of a sequence (e.g. the event log of a replay) are
+// stored as a (zigzag encoded) difference with the previous time stamp.
+static const char BIN_MAGIC[8] = { 'O', 'M', 'S', 'X', 'B', 'I', 'N', '2' };
+static bool isBinMagic(const char* magic)
+{
+	// Only the last character (the format version) may differ.
+	return (memcmp(magic, BIN_MAGIC, sizeof(BIN_MAGIC) - 1) == 0) &&
+	       ((magic[7] == '1') || (magic[7] == '2'));
+}
+enum BlobMethod { BLOB_RAW = 0, BLOB_SNAPPY = 1, BLOB_REF = 2 };
+
+BinOutputArchive::BinOutputArchive(std::string filename_)
+	: filename(std::move(filename_))
+{
+	buffer.insert(BIN_MAGIC, sizeof(BIN_MAGIC));
+	save(Version::full());
+	save(Date::toString(time(nullptr)));
+	save(string(TARGET_PLATFORM));
+}
+
+void BinOutputArchive::close()
+{
+	if (closed) return;
+	closed = true;
+
+	assert(openSections.empty());
+	size_t size;
+	auto buf = buffer.release(size);
+	File file(filename, File::TRUNCATE);
+	file.write(buf.data(), size);
+}
+
+MemBuffer<uint8_t> BinOutputArchive::releaseBuffer(size_t& size)
+{
+	assert(!closed);
+	assert(openSections.empty());
+	closed = true;
+	return buffer.release(size);
+}
+
+BinOutputArchive::~BinOutputArchive()
+{
+	try {
+		close();
+	} catch (...) {
+		// Eat exception. Explicitly call close() if you want to handle errors.
+	}
+}
+
+void BinOutputArchive::saveVarint(uint64_t u)
+{
+	uint8_t* buf = buffer.allocate(10);
+	uint8_t* p = buf;
+	while (u >= 0x80) {
+		*p++ = uint8_t(u) | 0x80;
+		u >>= 7;
+	}
+	*p++ = uint8_t(u);
+	buffer.deallocate(p);
+}
+
+void BinOutputArchive::saveDouble(double d)
+{
+	uint64_t u;
+	memcpy(&u, &d, sizeof(u));
+	uint8_t buf[8];
+	Endian::write_UA_L64(buf, u);
+	buffer.insert(buf, sizeof(buf));
+}
+
+void BinOutputArchive::save(const string& str)
+{
+	saveVarint(str.size());
+	buffer.insert(str.data(), str.size());
+}
+
+void BinOutputArchive::serialize_blob(const char* /*tag*/, const void* data,
+                                      size_t len, bool /*diff*/)
+{
+	if (len > SMALL_SIZE) {
+		auto sum = SHA1::calc(static_cast<const uint8_t*>(data), len);
+		auto it = blobPositions.find(sum);
+		if (it != end(blobPositions)) {
+			saveVarint(len);
+			saveVarint(BLOB_REF);
+			saveVarint(it->second);
+			return;
+		}
+		blobPositions.emplace(sum, buffer.getPosition());
+	}
+	saveVarint(len);
+	if (len > SMALL_SIZE) {
+		size_t dstLen = snappy::maxCompressedLength(len);
+		MemBuffer<char> buf(dstLen);
+		snappy::compress(static_cast<const char*>(data), len,
+		                 buf.data(), dstLen);
+		if (dstLen < len) {
+			saveVarint(BLOB_SNAPPY);
+			saveVarint(dstLen);
+			buffer.insert(buf.data(), dstLen);
+			return;
+		}
+	}
+	saveVarint(BLOB_RAW);
+	buffer.insert(data, len);
+}
+
+void BinOutputArchive::beginSection()
+{
+	uint8_t skip[8] = {}; // filled in later
+	buffer.insert(skip, sizeof(skip));
+	openSections.push_back(buffer.getPosition());
+}
+
+void BinOutputArchive::endSection()
+{
+	assert(!openSections.empty());
+	size_t beginPos = openSections.back();
+	openSections.pop_back();
+	uint8_t skip[8];
+	Endian::write_UA_L64(skip, buffer.getPosition() - beginPos);
+	buffer.insertAt(beginPos - sizeof(skip), skip, sizeof(skip));
+}
+
+void BinOutputArchive::attribute(const char* name, const char* value)
+{
+	if (strcmp(name, "type") != 0) {
+		save(string(value));
+		return;
+	}
+	auto it = typeIds.find(value);
+	if (it != end(typeIds)) {
+		saveVarint(it->second);
+		return;
+	}
+	typeIds.emplace(value, unsigned(typeIds.size() + 1));
+	saveVarint(0);
+	save(string(value));
+}
+
+void BinOutputArchive::serializeTimeStamp(const char* /*tag*/, const EmuTime& time)
+{
+	uint64_t t = (time - EmuTime::zero).length();
+	save(int64_t(t - lastTimeStamp));
+	lastTimeStamp = t;
+}
+
+////
+
+BinInputArchive::BinInputArchive(const string& filename)
+{
+	File file(filename);
+	size_t size = file.getSize();
+	data.resize(size);
+	file.read(data.data(), size);
+	readHeader(size, filename);
+}
+
+BinInputArchive::BinInputArchive(const uint8_t* buf, size_t size)
+{
+	data.resize(size);
+	memcpy(data.data(), buf, size);
+	readHeader(size, "<memory>");
+}
+
+void BinInputArchive::readHeader(size_t size, string_view name)
+{
+	pos = data.data();
+	end = pos + size;
+
+	if ((size < sizeof(BIN_MAGIC)) ||
+	    !isBinMagic(reinterpret_cast<const char*>(get(sizeof(BIN_MAGIC))))) {
+		throw MSXException("Not a binary openMSX savestate: ", name);
+	}
+	formatVersion = char(data[sizeof(BIN_MAGIC) - 1]);
+	loadStr(); // openMSX version
+	loadStr(); // date and time
+	loadStr(); // platform
+}
+
+bool BinInputArchive::isBinArchive(const string& filename)
+{
+	try {
+		File file(filename);
+		char magic[sizeof(BIN_MAGIC)];
+		if (file.getSize() < sizeof(magic)) return false;
+		file.read(magic, sizeof(magic));
+		return isBinMagic(magic);
+	} catch (MSXException&) {
+		return false;
+	}
+}
+
+const uint8_t* BinInputArchive::get(size_t len)
+{
+	if (unlikely(size_t(end - pos) < len)) {
+		throw MSXException("Unexpected end of binary savestate.");
+	}
+	const uint8_t* result = pos;
+	pos += len;
+	return result;
+}
+
+uint64_t BinInputArchive::loadVarint()
+{
+	uint64_t result = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7) {
+		uint8_t b = *get(1);
+		result |= uint64_t(b & 0x7F) << shift;
+		if (!(b & 0x80)) return result;
+	}
+	throw MSXException("Invalid number in binary savestate.");
+}
+
+double BinInputArchive::loadDouble()
+{
+	uint64_t u = Endian::read_UA_L64(get(8));
+	double d;
+	memcpy(&d, &u, sizeof(d));
+	return d;
+}
+
+void BinInputArchive::load(string& t)
+{
+	t = loadStr().str();
+}
+
+string_view BinInputArchive::loadStr()
+{
+	size_t len = loadVarint();
+	auto* p = reinterpret_cast<const char*>(get(len));
+	return string_view(p, len);
+}
+
+void BinInputArchive::serialize_blob(const char* tag, void* data_,
+                                     size_t len, bool /*diff*/)
+{
+	if (loadVarint() != len) {
+		throw MSXException(
+			"Length of blob different from expected value (", len, ')');
+	}
+	auto method = loadVarint();
+	if (method == BLOB_RAW) {
+		memcpy(data_, get(len), len);
+	} else if (method == BLOB_SNAPPY) {
+		size_t srcLen = loadVarint();
+		snappy::uncompress(reinterpret_cast<const char*>(get(srcLen)),
+		                   srcLen, static_cast<char*>(data_), len);
+	} else if (method == BLOB_REF) {
+		// Decode the earlier blob again, it always precedes this one
+		// (so it can't be a reference itself).
+		size_t offset = loadVarint();
+		auto* current = pos;
+		auto* refEnd = end;
+		if (offset >= size_t(pos - data.data())) {
+			throw MSXException("Invalid blob reference in binary savestate.");
+		}
+		pos = data.data() + offset;
+		end = current; // forbid (recursive) forward references
+		serialize_blob(tag, data_, len);
+		pos = current;
+		end = refEnd;
+	} else {
+		throw MSXException("Unsupported blob encoding: ", method);
+	}
+}
+
+void BinInputArchive::skipSection(bool skip)
+{
+	size_t num = Endian::read_UA_L64(get(8));
+	if (skip) {
+		get(num);
+	}
+}
+
+void BinInputArchive::attribute(const char* name, string& str)
+{
+	if ((formatVersion == '1') || (strcmp(name, "type") != 0)) {
+		load(str);
+		return;
+	}
+	auto id = loadVarint();
+	if (id == 0) {
+		load(str);
+		typeNames.push_back(str);
+	} else if (id <= typeNames.size()) {
+		str = typeNames[id - 1];
+	} else {
+		throw MSXException("Invalid type in binary savestate.");
+	}
+}
+
+void BinInputArchive::serializeTimeStamp(const char* tag, EmuTime& time)
+{
+	if (formatVersion == '1') {
+		serialize(tag, time);
+		return;
+	}
+	int64_t delta;
+	load(delta);
+	lastTimeStamp += uint64_t(delta);
+	time = EmuTime::makeEmuTime(lastTimeStamp);
 }
 
 } // namespace openmsx
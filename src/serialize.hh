@@ -2,14 +2,18 @@
 #define SERIALIZE_HH
 
 #include "serialize_core.hh"
+#include "serialize_stats.hh"
 #include "SerializeBuffer.hh"
+#include "XMLDocument.hh"
 #include "XMLElement.hh"
 #include "MemBuffer.hh"
 #include "hash_map.hh"
 #include "inline.hh"
+#include "sha1.hh"
 #include "strCat.hh"
 #include "unreachable.hh"
 #include <zlib.h>
+#include <map>
 #include <string>
 #include <typeindex>
 #include <type_traits>
@@ -22,6 +26,8 @@ namespace openmsx {
 
 class LastDeltaBlocks;
 class DeltaBlock;
+class DirtyPages;
+class EmuTime;
 
 // TODO move somewhere in utils once we use this more often
 struct HashPair {
@@ -59,6 +65,14 @@ template<typename T> struct SerializeClassVersion;
 //      is not a design goal (e.g. simply changing a value will probably work,
 //      but swapping the position of two tag or adding or removing tags can
 //      easily break the stream).
+//   - Bin
+//      Stores the stream in a compact binary file. Like XML these files are
+//      portable (integers are stored as variable length little endian
+//      values, floating point numbers in IEEE format) and contain version
+//      information. Blobs are stored as raw (or snappy compressed) bytes
+//      instead of base64 encoded text. The main use case is storing many
+//      savestates, where the size of the files and the time to (de)code
+//      them matters more than being human readable.
 //   - Text
 //      This stores to stream in a flat ascii file (one item per line). This
 //      format is only written as a proof-of-concept to test the design. It's
@@ -145,6 +159,15 @@ public:
 	//   type).
 	//
 	//
+	// void serialize_blob(const char* tag, const void* data, size_t len,
+	//                     const DirtyPages& dirty)
+	//
+	//   Like above, but 'dirty' indicates which pages of the blob were
+	//   written since the previous reverse snapshot. Only use this when
+	//   isReverseSnapshot() returns true. Memory archives use this to only
+	//   delta-compress the dirty pages. Other archives ignore it.
+	//
+	//
 	// template<typename T> void serialize(const char* tag, const T& t)
 	//
 	//   This is much like the serializeWithID() method above, but it doesn't
@@ -258,6 +281,17 @@ public:
 		UNREACHABLE; return false;
 	}
 
+	/** Load/store the time stamp of an element in a time ordered sequence,
+	 * like the recorded events of a replay. Some archives store it
+	 * relative to the previous time stamp, therefore all time stamps of
+	 * such a sequence must be serialized in order (and not inside a
+	 * skippable section).
+	 */
+	template<typename T> void serializeTimeStamp(const char* tag, T& t)
+	{
+		self().serialize(tag, t);
+	}
+
 	/** Some archives (like XML archives) can count the number of subtags
 	 * that belong to the current tag. This method indicates whether that's
 	 * the case for this archive or not.
@@ -300,6 +334,19 @@ public:
 		// nothing
 	}
 
+	/** Mark the data serialized between these two calls as a separate
+	 * part (e.g. a device) in the savestate statistics, see
+	 * SerializeStats. Only MemOutputArchive uses this.
+	 */
+	void beginStats(string_view /*name*/)
+	{
+		// nothing
+	}
+	void endStats()
+	{
+		// nothing
+	}
+
 	// These (internal) methods should be implemented in the concrete
 	// archive classes.
 	//
@@ -458,6 +505,11 @@ public:
 	// the resulting string. But memory archives will memcpy the blob.
 	void serialize_blob(const char* tag, const void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    const DirtyPages& /*dirty*/)
+	{
+		this->self().serialize_blob(tag, data, len);
+	}
 
 	template<typename T> void serialize(const char* tag, const T& t)
 	{
@@ -553,6 +605,11 @@ public:
 	}
 	void serialize_blob(const char* tag, void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, void* data, size_t len,
+	                    const DirtyPages& /*dirty*/)
+	{
+		this->self().serialize_blob(tag, data, len);
+	}
 
 	template<typename T>
 	void serialize(const char* tag, T& t)
@@ -652,6 +709,32 @@ public:
 	bool needVersion() const { return false; }
 	bool isReverseSnapshot() const { return reverseSnapshot; }
 
+	/** Collect statistics (per top-level tag and per device) while
+	  * serializing, see SerializeStats. Pass nullptr to disable.
+	  */
+	void setStats(SerializeStats* stats_) { stats = stats_; }
+
+	void beginTag(const char* tag)
+	{
+		if (stats && (++tagDepth <= 2)) {
+			stats->beginPart(tag, buffer.getPosition());
+		}
+	}
+	void endTag(const char* /*tag*/)
+	{
+		if (stats && (tagDepth-- <= 2)) {
+			stats->endPart(buffer.getPosition());
+		}
+	}
+	void beginStats(string_view name)
+	{
+		if (stats) stats->beginPart(name, buffer.getPosition());
+	}
+	void endStats()
+	{
+		if (stats) stats->endPart(buffer.getPosition());
+	}
+
 	template <typename T> void save(const T& t)
 	{
 		put(&t, sizeof(t));
@@ -663,6 +746,8 @@ public:
 	void save(const std::string& s);
 	void serialize_blob(const char* tag, const void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    const DirtyPages& dirty);
 
 	using OutputArchiveBase<MemOutputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -745,6 +830,8 @@ private:
 	std::vector<size_t> openSections;
 	LastDeltaBlocks& lastDeltaBlocks;
 	std::vector<std::shared_ptr<DeltaBlock>>& deltaBlocks;
+	SerializeStats* stats = nullptr;
+	unsigned tagDepth = 0;
 	const bool reverseSnapshot;
 };
 
@@ -780,6 +867,7 @@ public:
 	string_view loadStr();
 	void serialize_blob(const char* tag, void* data, size_t len,
 	                    bool diff = true);
+	using InputArchiveBase<MemInputArchive>::serialize_blob;
 
 	using InputArchiveBase<MemInputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -862,7 +950,9 @@ private:
 class XmlOutputArchive final : public OutputArchiveBase<XmlOutputArchive>
 {
 public:
-	explicit XmlOutputArchive(const std::string& filename);
+	/** @param compressionLevel gzip compression level, 0-9 */
+	explicit XmlOutputArchive(const std::string& filename,
+	                          int compressionLevel = 9);
 	void close();
 	~XmlOutputArchive();
 
@@ -886,6 +976,10 @@ public:
 	void save(unsigned u);             // but having them non-inline
 	void save(unsigned long long ull); // saves quite a bit of code
 
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    bool diff = true);
+	using OutputArchiveBase<XmlOutputArchive>::serialize_blob;
+
 	void beginSection() { /*nothing*/ }
 	void endSection()   { /*nothing*/ }
 
@@ -921,9 +1015,20 @@ public:
 	void attribute(const char* name, unsigned u);
 
 private:
+	bool write(gzFile f);
+	void flush();
+
 	gzFile file;
-	XMLElement root;
-	std::vector<XMLElement*> current;
+	std::string buffer; // not yet written (compressed) output
+	unsigned depth; // number of open tags
+	enum State {
+		OPEN,    // start tag of the current tag is not yet closed
+		DATA,    // current tag has data content
+		CHILDREN // current tag has child tags (at least one)
+	} state;
+	// Content of the (large) blobs written so far, identical blobs (e.g.
+	// the same ROM in all snapshots of a replay) are only stored once.
+	std::map<Sha1Sum, unsigned> blobIds;
 };
 
 class XmlInputArchive final : public InputArchiveBase<XmlInputArchive>
@@ -957,6 +1062,9 @@ public:
 	void load(unsigned long long& ull); // saves quite a bit of code
 	void load(std::string& t);
 	string_view loadStr();
+	void serialize_blob(const char* tag, void* data, size_t len,
+	                    bool diff = true);
+	using InputArchiveBase<XmlInputArchive>::serialize_blob;
 
 	void skipSection(bool /*skip*/) { /*nothing*/ }
 
@@ -999,15 +1107,189 @@ public:
 	int countChildren() const;
 
 private:
-	XMLElement rootElem;
-	std::vector<std::pair<const XMLElement*, size_t>> elems;
+	void decodeBlobs();
+	void loadBlobRef(const XMLDocument::Node& ref, void* data, size_t len);
+
+	XMLDocument doc;
+	// current node and the position of the next findNextChild() search
+	std::vector<std::pair<const XMLDocument::Node*,
+	                      const XMLDocument::Node*>> elems;
+
+	struct DecodedBlob {
+		const XMLDocument::Node* elem = nullptr;
+		MemBuffer<uint8_t> data;
+		size_t size = 0;
+		bool referenced = false; // keep 'data' for later references
+	};
+	std::vector<DecodedBlob> decodedBlobs; // sorted on 'elem'
+	hash_map<unsigned, const XMLDocument::Node*> blobElems; // "blob" attribute -> elem
+};
+
+////
+
+class BinOutputArchive final : public OutputArchiveBase<BinOutputArchive>
+{
+public:
+	explicit BinOutputArchive(std::string filename);
+	void close();
+	~BinOutputArchive();
+
+	/** Instead of writing the data to the file (on close()), give it to
+	  * the caller. E.g. to write it from another thread. After this call
+	  * the archive is closed.
+	  */
+	MemBuffer<uint8_t> releaseBuffer(size_t& size);
+
+	template<typename T> void save(const T& t)
+	{
+		static_assert(std::is_arithmetic<T>::value, "must be a number");
+		saveNumber(t, std::is_floating_point<T>(), std::is_signed<T>());
+	}
+	void saveChar(char c) { save(c); }
+	void save(char c) { save(uint8_t(c)); } // char can be signed or unsigned
+	void save(const std::string& str);
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    bool diff = true);
+	using OutputArchiveBase<BinOutputArchive>::serialize_blob;
+
+	void beginSection();
+	void endSection();
+
+	// The type names of polymorphic objects are stored only once.
+	using OutputArchiveBase<BinOutputArchive>::attribute;
+	void attribute(const char* name, const char* value);
+	void serializeTimeStamp(const char* tag, const EmuTime& time);
+
+	// workaround(?) for visual studio 2015:
+	//   put the default here instead of in the base class
+	using OutputArchiveBase<BinOutputArchive>::serialize;
+	template<typename T, typename ...Args>
+	ALWAYS_INLINE void serialize(const char* tag, const T& t, Args&& ...args)
+	{
+		// by default just repeatedly call the single-pair serialize() variant
+		this->self().serialize(tag, t);
+		this->self().serialize(std::forward<Args>(args)...);
+	}
+
+//internal:
+	// Enum values can change between openMSX versions, their names are
+	// more stable.
+	inline bool translateEnumToString() const { return true; }
+
+private:
+	template<typename T> void saveNumber(T t, std::false_type, std::false_type)
+	{
+		saveVarint(uint64_t(t));
+	}
+	template<typename T> void saveNumber(T t, std::false_type, std::true_type)
+	{
+		// zigzag encoding: small negative numbers also become small
+		auto s = int64_t(t);
+		saveVarint((uint64_t(s) << 1) ^ uint64_t(s >> 63));
+	}
+	template<typename T, typename S> void saveNumber(T t, std::true_type, S)
+	{
+		saveDouble(double(t));
+	}
+	void saveVarint(uint64_t u);
+	void saveDouble(double d);
+
+	const std::string filename;
+	OutputBuffer buffer;
+	std::vector<size_t> openSections;
+	std::map<Sha1Sum, size_t> blobPositions; // see XmlOutputArchive::blobIds
+	std::map<std::string, unsigned> typeIds;
+	uint64_t lastTimeStamp = 0;
+	bool closed = false;
+};
+
+class BinInputArchive final : public InputArchiveBase<BinInputArchive>
+{
+public:
+	explicit BinInputArchive(const std::string& filename);
+	/** Load from a buffer in memory (the data is copied). */
+	BinInputArchive(const uint8_t* buf, size_t size);
+
+	/** Does the given file (probably) contain a binary savestate? */
+	static bool isBinArchive(const std::string& filename);
+
+	inline bool versionAtLeast(unsigned actual, unsigned required) const
+	{
+		return actual >= required;
+	}
+	inline bool versionBelow(unsigned actual, unsigned required) const
+	{
+		return actual < required;
+	}
+
+	template<typename T> void load(T& t)
+	{
+		static_assert(std::is_arithmetic<T>::value, "must be a number");
+		loadNumber(t, std::is_floating_point<T>(), std::is_signed<T>());
+	}
+	void loadChar(char& c) { load(c); }
+	void load(char& c) { c = char(loadVarint()); }
+	void load(bool& b) { b = loadVarint() != 0; }
+	void load(std::string& t);
+	string_view loadStr();
+	void serialize_blob(const char* tag, void* data, size_t len,
+	                    bool diff = true);
+	using InputArchiveBase<BinInputArchive>::serialize_blob;
+
+	void skipSection(bool skip);
+
+	using InputArchiveBase<BinInputArchive>::attribute;
+	void attribute(const char* name, std::string& str);
+	void serializeTimeStamp(const char* tag, EmuTime& time);
+
+	// workaround(?) for visual studio 2015:
+	//   put the default here instead of in the base class
+	using InputArchiveBase<BinInputArchive>::serialize;
+	template<typename T, typename ...Args>
+	ALWAYS_INLINE void serialize(const char* tag, T& t, Args&& ...args)
+	{
+		// by default just repeatedly call the single-pair serialize() variant
+		this->self().serialize(tag, t);
+		this->self().serialize(std::forward<Args>(args)...);
+	}
+
+//internal:
+	inline bool translateEnumToString() const { return true; }
+
+private:
+	template<typename T> void loadNumber(T& t, std::false_type, std::false_type)
+	{
+		t = T(loadVarint());
+	}
+	template<typename T> void loadNumber(T& t, std::false_type, std::true_type)
+	{
+		uint64_t u = loadVarint();
+		t = T(int64_t(u >> 1) ^ -int64_t(u & 1));
+	}
+	template<typename T, typename S> void loadNumber(T& t, std::true_type, S)
+	{
+		t = T(loadDouble());
+	}
+	uint64_t loadVarint();
+	double loadDouble();
+	const uint8_t* get(size_t len);
+	void readHeader(size_t size, string_view name);
+
+	MemBuffer<uint8_t> data;
+	const uint8_t* pos;
+	const uint8_t* end;
+	std::vector<std::string> typeNames;
+	uint64_t lastTimeStamp = 0;
+	char formatVersion;
 };
 
 #define INSTANTIATE_SERIALIZE_METHODS(CLASS) \
 template void CLASS::serialize(MemInputArchive&,   unsigned); \
 template void CLASS::serialize(MemOutputArchive&,  unsigned); \
 template void CLASS::serialize(XmlInputArchive&,   unsigned); \
-template void CLASS::serialize(XmlOutputArchive&,  unsigned);
+template void CLASS::serialize(XmlOutputArchive&,  unsigned); \
+template void CLASS::serialize(BinInputArchive&,   unsigned); \
+template void CLASS::serialize(BinOutputArchive&,  unsigned);
 
 } // namespace openmsx
 
@@ -47,4 +47,15 @@ unsigned loadVersionHelper(XmlInputArchive& ar, const char* className,
 	return version;
 }
 
+unsigned loadVersionHelper(BinInputArchive& ar, const char* className,
+                           unsigned latestVersion)
+{
+	unsigned version;
+	ar.attribute("version", version);
+	if (unlikely(version > latestVersion)) {
+		versionError(className, latestVersion, version);
+	}
+	return version;
+}
+
 } // namespace openmsx
@@ -0,0 +1,65 @@
+#include "serialize_stats.hh"
+#include "Timer.hh"
+#include "ranges.hh"
+#include "strCat.hh"
+#include <cassert>
+
+namespace openmsx {
+
+void SerializeStats::clear()
+{
+	assert(open.empty());
+	entries.clear();
+}
+
+void SerializeStats::beginPart(string_view name, size_t position)
+{
+	auto it = ranges::find_if(entries, [&](auto& e) { return e.name == name; });
+	if (it == end(entries)) {
+		entries.emplace_back();
+		entries.back().name = name.str();
+		it = end(entries) - 1;
+	}
+	open.push_back(Open{size_t(it - begin(entries)), position, Timer::getTime()});
+}
+
+void SerializeStats::endPart(size_t position)
+{
+	assert(!open.empty());
+	auto o = open.back();
+	open.pop_back();
+	auto bytes = position - o.position;
+	auto time = Timer::getTime() - o.time;
+	auto& e = entries[o.entry];
+	e.bytes += bytes - o.childBytes;
+	e.time  += time  - o.childTime;
+	if (!open.empty()) {
+		open.back().childBytes += bytes;
+		open.back().childTime  += time;
+	}
+}
+
+void SerializeStats::addBlob(size_t size)
+{
+	if (open.empty()) return;
+	auto& e = entries[open.back().entry];
+	e.blobBytes += size;
+	++e.blobs;
+}
+
+std::string SerializeStats::format() const
+{
+	auto sorted = entries;
+	ranges::sort(sorted, [](auto& x, auto& y) {
+		return (x.bytes + x.blobBytes) > (y.bytes + y.blobBytes);
+	});
+	std::string result;
+	for (auto& e : sorted) {
+		strAppend(result, e.name, ": ", e.bytes, " bytes, ",
+		          e.blobs, " blocks of ", e.blobBytes, " bytes, ",
+		          e.time, " us\n");
+	}
+	return result;
+}
+
+} // namespace openmsx
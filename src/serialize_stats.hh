@@ -0,0 +1,54 @@
+#ifndef SERIALIZE_STATS_HH
+#define SERIALIZE_STATS_HH
+
+#include "string_view.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Size and (serialize) time of the different parts of a savestate.
+ *
+ * A MemOutputArchive can collect these statistics, this is used to find the
+ * devices that make the reverse snapshots large or slow. The parts are the
+ * top-level tags of the machine and the individual devices (marked with
+ * beginStats()/endStats() in the serialize code). The numbers of a part
+ * don't include the numbers of the nested parts.
+ */
+class SerializeStats
+{
+public:
+	struct Entry {
+		std::string name;
+		size_t bytes = 0;     // in the savestate buffer
+		size_t blobBytes = 0; // memory used by the (delta) blocks
+		unsigned blobs = 0;   // number of delta blocks
+		uint64_t time = 0;    // in microseconds
+	};
+
+	void clear();
+	void beginPart(string_view name, size_t position);
+	void endPart(size_t position);
+	void addBlob(size_t size);
+
+	const std::vector<Entry>& getEntries() const { return entries; }
+
+	/** Multi-line text, sorted on (total) size, biggest first. */
+	std::string format() const;
+
+private:
+	struct Open {
+		size_t entry;
+		size_t position;
+		uint64_t time;
+		size_t childBytes = 0;
+		uint64_t childTime = 0;
+	};
+	std::vector<Entry> entries;
+	std::vector<Open> open;
+};
+
+} // namespace openmsx
+
+#endif
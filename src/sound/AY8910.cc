@@ -682,6 +682,24 @@ void AY8910::wrtReg(unsigned reg, byte value, EmuTime::param time)
 }
 
 void AY8910::generateChannels(float** bufs, unsigned num)
+{
+	generate(bufs, num);
+}
+
+bool AY8910::hasStepOutput() const
+{
+	return true;
+}
+
+void AY8910::generateChannelSteps(StepChannel** channels, unsigned num)
+{
+	generate(channels, num);
+}
+
+// Buf is either 'float' (write all samples) or 'StepChannel' (only pass on
+// the changes), the addFill() overloads hide the difference.
+template<typename Buf>
+void AY8910::generate(Buf** bufs, unsigned num)
 {
 	// Disable channels with volume 0: since the sample value doesn't matter,
 	// we can use the fastest path.
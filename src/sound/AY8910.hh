@@ -159,6 +159,9 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	void generateChannelSteps(StepChannel** channels, unsigned num) override;
+	bool hasStepOutput() const override;
+	template<typename Buf> void generate(Buf** bufs, unsigned num);
 	float getAmplificationFactorImpl() const override;
 
 	// Observer<Setting>
@@ -125,23 +125,46 @@ void BlipBuffer::addDelta(TimeIndex time, float delta)
 	}
 }
 
-static const float BASS_FACTOR = 511.0f / 512.0f;
+static constexpr float BASS_FACTOR  = 511.0f / 512.0f;
+static constexpr float BASS_FACTOR2 = BASS_FACTOR  * BASS_FACTOR;
+static constexpr float BASS_FACTOR3 = BASS_FACTOR2 * BASS_FACTOR;
+static constexpr float BASS_FACTOR4 = BASS_FACTOR3 * BASS_FACTOR;
 
 template<unsigned PITCH>
 void BlipBuffer::readSamplesHelper(float* __restrict out, unsigned samples) __restrict
 {
 	assert((offset + samples) <= BUFFER_SIZE);
 	auto acc = accum;
-	unsigned ofst = offset;
-	for (unsigned i = 0; i < samples; ++i) {
+	const float* __restrict in = &buffer[offset];
+
+	// Per sample this is 'out = acc; acc = acc * BASS_FACTOR + in'. That's
+	// one long dependency chain. Instead, per group of 4 samples, first
+	// integrate the input on its own (c1..c4, this doesn't depend on
+	// 'acc', so groups can overlap) and only then add the (decayed)
+	// accumulator. This leaves one multiply-add per 4 samples on the
+	// critical path and lets the compiler vectorize the output. The result
+	// can differ from the sequential loop in the last bits.
+	unsigned i = 0;
+	for (; (i + 4) <= samples; i += 4) {
+		float c1 = in[i + 0];
+		float c2 = c1 * BASS_FACTOR + in[i + 1];
+		float c3 = c2 * BASS_FACTOR + in[i + 2];
+		float c4 = c3 * BASS_FACTOR + in[i + 3];
+		out[(i + 0) * PITCH] = acc;
+		out[(i + 1) * PITCH] = acc * BASS_FACTOR  + c1;
+		out[(i + 2) * PITCH] = acc * BASS_FACTOR2 + c2;
+		out[(i + 3) * PITCH] = acc * BASS_FACTOR3 + c3;
+		acc = acc * BASS_FACTOR4 + c4;
+	}
+	for (; i < samples; ++i) {
 		out[i * PITCH] = acc;
 		acc *= BASS_FACTOR;
-		acc += buffer[ofst];
-		buffer[ofst] = 0.0f;
-		++ofst;
+		acc += in[i];
 	}
+	memset(&buffer[offset], 0, samples * sizeof(float));
+
 	accum = acc;
-	offset = ofst & BUFFER_MASK;
+	offset = (offset + samples) & BUFFER_MASK;
 }
 
 static bool isSilent(float x)
@@ -170,7 +193,15 @@ bool BlipBuffer::readSamples(float* __restrict out, unsigned samples)
 			return false; // muted
 		}
 		auto acc = accum;
-		for (unsigned i = 0; i < samples; ++i) {
+		unsigned i = 0;
+		for (; (i + 4) <= samples; i += 4) {
+			out[(i + 0) * PITCH] = acc;
+			out[(i + 1) * PITCH] = acc * BASS_FACTOR;
+			out[(i + 2) * PITCH] = acc * BASS_FACTOR2;
+			out[(i + 3) * PITCH] = acc * BASS_FACTOR3;
+			acc *= BASS_FACTOR4;
+		}
+		for (; i < samples; ++i) {
 			out[i * PITCH] = acc;
 			acc *= BASS_FACTOR;
 		}
@@ -1,8 +1,11 @@
 #include "MSXMixer.hh"
 #include "Mixer.hh"
 #include "SoundDevice.hh"
+#include "SoundMixOps.hh"
 #include "MSXMotherBoard.hh"
 #include "MSXCommandController.hh"
+#include "FrameProfiler.hh"
+#include "Reactor.hh"
 #include "TclObject.hh"
 #include "ThrottleManager.hh"
 #include "GlobalSettings.hh"
@@ -13,6 +16,7 @@
 #include "AviRecorder.hh"
 #include "Filename.hh"
 #include "CliComm.hh"
+#include "Instrumentation.hh"
 #include "stl.hh"
 #include "aligned.hh"
 #include "outer.hh"
@@ -20,9 +24,11 @@
 #include "unreachable.hh"
 #include "view.hh"
 #include "vla.hh"
+#include "xrange.hh"
 #include <cassert>
 #include <cmath>
 #include <cstring>
+#include <exception>
 #include <memory>
 #include <tuple>
 
@@ -167,6 +173,8 @@ void MSXMixer::updateStream(EmuTime::param time)
 #endif
 	};
 
+	FrameProfiler::Section section(
+		motherBoard.getReactor().getFrameProfiler(), FrameProfiler::SOUND);
 	unsigned count = prevTime.getTicksTill(time);
 	assert(count <= 8192);
 
@@ -185,100 +193,12 @@ void MSXMixer::updateStream(EmuTime::param time)
 }
 
 
-// Various (inner) loops that multiply one buffer by a constant and add the
-// result to a second buffer. Either buffer can be mono or stereo, so if
-// necessary the mono buffer is expanded to stereo. It's possible the
+// The inner loops that multiply one buffer by a constant and add the result to
+// a second buffer are in SoundMixOps.hh. Either buffer can be mono or stereo,
+// so if necessary the mono buffer is expanded to stereo. It's possible the
 // accumulation buffer is still empty (as-if it contains zeros), in that case
 // we skip the accumulation step.
-
-// buf[0:n] *= f
-static inline void mul(float* buf, int n, float f)
-{
-	// C++ version, unrolled 4x,
-	//   this allows gcc/clang to do much better auto-vectorization
-	// Note that this can process upto 3 samples too many, but that's OK.
-	assume_SSE_aligned(buf);
-	int i = 0;
-	do {
-		buf[i + 0] *= f;
-		buf[i + 1] *= f;
-		buf[i + 2] *= f;
-		buf[i + 3] *= f;
-		i += 4;
-	} while (i < n);
-}
-
-// acc[0:n] += mul[0:n] * f
-static inline void mulAcc(
-	float* __restrict acc, const float* __restrict mul, int n, float f)
-{
-	// C++ version, unrolled 4x, see comments above.
-	assume_SSE_aligned(acc);
-	assume_SSE_aligned(mul);
-	int i = 0;
-	do {
-		acc[i + 0] += mul[i + 0] * f;
-		acc[i + 1] += mul[i + 1] * f;
-		acc[i + 2] += mul[i + 2] * f;
-		acc[i + 3] += mul[i + 3] * f;
-		i += 4;
-	} while (i < n);
-}
-
-// buf[0:2n+0:2] = buf[0:n] * l
-// buf[1:2n+1:2] = buf[0:n] * r
-static inline void mulExpand(float* buf, int n, float l, float r)
-{
-	int i = n;
-	do {
-		--i; // back-to-front
-		auto t = buf[i];
-		buf[2 * i + 0] = l * t;
-		buf[2 * i + 1] = r * t;
-	} while (i != 0);
-}
-
-// acc[0:2n+0:2] += mul[0:n] * l
-// acc[1:2n+1:2] += mul[0:n] * r
-static inline void mulExpandAcc(
-	float* __restrict acc, const float* __restrict mul, int n,
-	float l, float r)
-{
-	int i = 0;
-	do {
-		auto t = mul[i];
-		acc[2 * i + 0] += l * t;
-		acc[2 * i + 1] += r * t;
-	} while (++i < n);
-}
-
-// buf[0:2n+0:2] = buf[0:2n+0:2] * l1 + buf[1:2n+1:2] * l2
-// buf[1:2n+1:2] = buf[0:2n+0:2] * r1 + buf[1:2n+1:2] * r2
-static inline void mulMix2(float* buf, int n, float l1, float l2, float r1, float r2)
-{
-	int i = 0;
-	do {
-		auto t1 = buf[2 * i + 0];
-		auto t2 = buf[2 * i + 1];
-		buf[2 * i + 0] = l1 * t1 + l2 * t2;
-		buf[2 * i + 1] = r1 * t1 + r2 * t2;
-	} while (++i < n);
-}
-
-// acc[0:2n+0:2] += mul[0:2n+0:2] * l1 + mul[1:2n+1:2] * l2
-// acc[1:2n+1:2] += mul[0:2n+0:2] * r1 + mul[1:2n+1:2] * r2
-static inline void mulMix2Acc(
-	float* __restrict acc, const float* __restrict mul, int n,
-	float l1, float l2, float r1, float r2)
-{
-	int i = 0;
-	do {
-		auto t1 = mul[2 * i + 0];
-		auto t2 = mul[2 * i + 1];
-		acc[2 * i + 0] += l1 * t1 + l2 * t2;
-		acc[2 * i + 1] += r1 * t1 + r2 * t2;
-	} while (++i < n);
-}
+using namespace SoundMixOps;
 
 
 // DC removal filter routines:
@@ -415,6 +335,7 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	// After these specialization this routine runs about two times
 	// faster for the common cases (mono output or no sound at all).
 	// In total emulation time this gave a speedup of about 2%.
+	INSTRUMENT_ZONE("MSXMixer::generate");
 
 	// When samples==0, call updateBuffer() but skip all further processing
 	// (handling this as a special case allows to simplify the code below).
@@ -436,32 +357,52 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	static const unsigned HAS_STEREO_FLAG = 2;
 	unsigned usedBuffers = 0;
 
+	// When generating in parallel, first let all devices produce their
+	// output in a private buffer. Afterwards that output is combined in
+	// the same order (and with the same operations) as in the serial
+	// case, so the result is bit-identical.
+	unsigned pitch = (2 * samples + 3 + 3) & ~3; // keep SSE alignment
+	bool parallel = (infos.size() > 1) && mixer.useParallelSound();
+	if (parallel) generateParallel(time, samples, pitch);
+	auto update = [&](size_t i, float* buf) {
+		if (!parallel) {
+			INSTRUMENT_ZONE(Instrumentation::intern(
+				infos[i].device->getName()));
+			return infos[i].device->updateBuffer(samples, buf, time);
+		}
+		if (!deviceGenerated[i]) return false;
+		unsigned num = (infos[i].device->isStereo() ? 2 : 1) * samples + 3;
+		memcpy(buf, &deviceBuffers[i * pitch], num * sizeof(float));
+		return true;
+	};
+
 	// FIXME: The Infos should be ordered such that all the mono
 	// devices are handled first
-	for (auto& info : infos) {
+	for (auto i : xrange(infos.size())) {
+		auto& info = infos[i];
 		SoundDevice& device = *info.device;
 		auto l1 = info.left1;
 		auto r1 = info.right1;
 		if (!device.isStereo()) {
 			if (l1 == r1) {
 				if (!(usedBuffers & HAS_MONO_FLAG)) {
-					if (device.updateBuffer(samples, monoBuf, time)) {
+					if (update(i, monoBuf)) {
 						usedBuffers |= HAS_MONO_FLAG;
 						mul(monoBuf, samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (update(i, tmpBuf)) {
 						mulAcc(monoBuf, tmpBuf, samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (update(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulExpand(stereoBuf, samples, l1, r1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (update(i, tmpBuf)) {
 						mulExpandAcc(stereoBuf, tmpBuf, samples, l1, r1);
 					}
 				}
@@ -473,23 +414,23 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 				assert(l2 == 0.0f);
 				assert(r1 == 0.0f);
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (update(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mul(stereoBuf, 2 * samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (update(i, tmpBuf)) {
 						mulAcc(stereoBuf, tmpBuf, 2 * samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (update(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulMix2(stereoBuf, samples, l1, l2, r1, r2);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (update(i, tmpBuf)) {
 						mulMix2Acc(stereoBuf, tmpBuf, samples, l1, l2, r1, r2);
 					}
 				}
@@ -536,6 +477,35 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	}
 }
 
+void MSXMixer::generateParallel(EmuTime::param time, unsigned samples, unsigned pitch)
+{
+	unsigned num = unsigned(infos.size());
+	if (deviceBuffersSize < num * pitch) {
+		deviceBuffersSize = num * pitch;
+		deviceBuffers.resize(deviceBuffersSize);
+	}
+	deviceGenerated.assign(num, false);
+	// Exceptions (e.g. while recording a channel to a .wav file) can't
+	// leave a worker thread, rethrow them here instead.
+	vector<std::exception_ptr> errors(num);
+
+	// Each device only touches its own state (and its own part of
+	// 'deviceBuffers'), so they can all run at the same time.
+	mixer.getSoundWorkers().parallelFor(num, [&](size_t i) {
+		try {
+			INSTRUMENT_ZONE(Instrumentation::intern(
+				infos[i].device->getName()));
+			deviceGenerated[i] = infos[i].device->updateBuffer(
+				samples, &deviceBuffers[i * pitch], time);
+		} catch (...) {
+			errors[i] = std::current_exception();
+		}
+	});
+	for (auto& e : errors) {
+		if (e) std::rethrow_exception(e);
+	}
+}
+
 bool MSXMixer::needStereoRecording() const
 {
 	return ranges::any_of(infos, [](auto& info) {
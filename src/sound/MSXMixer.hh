@@ -6,6 +6,8 @@
 #include "InfoTopic.hh"
 #include "EmuTime.hh"
 #include "DynamicClock.hh"
+#include "MemBuffer.hh"
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -132,6 +134,7 @@ private:
 	void reschedule();
 	void reschedule2();
 	void generate(float* output, EmuTime::param time, unsigned samples);
+	void generateParallel(EmuTime::param time, unsigned samples, unsigned pitch);
 
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
@@ -173,6 +176,12 @@ private:
 
 	unsigned muteCount;
 	float tl0, tr0; // internal DC-filter state
+
+	// Output of the individual sound devices when they are generated in
+	// parallel, see generateParallel().
+	MemBuffer<float, SSE2_ALIGNMENT> deviceBuffers;
+	std::vector<uint8_t> deviceGenerated; // not vector<bool>, written concurrently
+	unsigned deviceBuffersSize = 0;
 };
 
 } // namespace openmsx
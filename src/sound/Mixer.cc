@@ -4,7 +4,10 @@
 #include "SDLSoundDriver.hh"
 #include "CommandController.hh"
 #include "CliComm.hh"
+#include "Reactor.hh"
+#include "TclObject.hh"
 #include "MSXException.hh"
+#include "outer.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "build-info.hh"
@@ -48,11 +51,21 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	, samplesSetting(
 		commandController, "samples",
 		"mixer samples", defaultsamples, 64, 8192)
+	, adaptiveLatencySetting(
+		commandController, "adaptive_sound_latency",
+		"keep the amount of buffered sound data as small as possible "
+		"without causing buffer underruns", false)
+	, parallelSoundSetting(
+		commandController, "parallel_sound_generation",
+		"generate the sound of the different sound devices in parallel "
+		"on multiple CPU cores", false)
+	, soundStatsInfo(reactor.getOpenMSXInfoCommand())
 	, muteCount(0)
 {
 	muteSetting       .attach(*this);
 	frequencySetting  .attach(*this);
 	samplesSetting    .attach(*this);
+	adaptiveLatencySetting.attach(*this);
 	soundDriverSetting.attach(*this);
 
 	// Set correct initial mute state.
@@ -67,6 +80,7 @@ Mixer::~Mixer()
 	driver.reset();
 
 	soundDriverSetting.detach(*this);
+	adaptiveLatencySetting.detach(*this);
 	samplesSetting    .detach(*this);
 	frequencySetting  .detach(*this);
 	muteSetting       .detach(*this);
@@ -89,7 +103,8 @@ void Mixer::reloadDriver()
 			driver = std::make_unique<SDLSoundDriver>(
 				reactor,
 				frequencySetting.getInt(),
-				samplesSetting.getInt());
+				samplesSetting.getInt(),
+				adaptiveLatencySetting.getBoolean());
 			break;
 		default:
 			UNREACHABLE;
@@ -163,6 +178,7 @@ void Mixer::update(const Setting& setting)
 			unmute();
 		}
 	} else if ((&setting == &samplesSetting) ||
+	           (&setting == &adaptiveLatencySetting) ||
 	           (&setting == &soundDriverSetting) ||
 	           (&setting == &frequencySetting)) {
 		reloadDriver();
@@ -171,4 +187,28 @@ void Mixer::update(const Setting& setting)
 	}
 }
 
+
+// class SoundStatsInfoTopic
+
+Mixer::SoundStatsInfoTopic::SoundStatsInfoTopic(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "sound_stats")
+{
+}
+
+void Mixer::SoundStatsInfoTopic::execute(span<const TclObject> /*tokens*/,
+                                         TclObject& result) const
+{
+	auto& mixer = OUTER(Mixer, soundStatsInfo);
+	result.addListElement(
+		"underruns", int(mixer.driver->getUnderrunCount()),
+		"overruns",  int(mixer.driver->getOverrunCount()));
+}
+
+std::string Mixer::SoundStatsInfoTopic::help(const std::vector<std::string>& /*tokens*/) const
+{
+	return "Returns the number of buffer underruns and overruns of the "
+	       "sound driver. These are reset when the sound driver is "
+	       "reloaded (e.g. when changing the 'samples' setting).";
+}
+
 } // namespace openmsx
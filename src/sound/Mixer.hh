@@ -5,6 +5,9 @@
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
 #include "IntegerSetting.hh"
+#include "InfoTopic.hh"
+#include "WorkerPool.hh"
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -47,6 +50,12 @@ public:
 
 	IntegerSetting& getMasterVolume() { return masterVolume; }
 
+	/** Should the sound devices of a machine be generated in parallel?
+	  * If so, this pool should be used for it.
+	  */
+	bool useParallelSound() const { return parallelSoundSetting.getBoolean(); }
+	WorkerPool& getSoundWorkers() { return soundWorkers; }
+
 private:
 	void reloadDriver();
 	void muteHelper();
@@ -65,6 +74,16 @@ private:
 	IntegerSetting masterVolume;
 	IntegerSetting frequencySetting;
 	IntegerSetting samplesSetting;
+	BooleanSetting adaptiveLatencySetting;
+	BooleanSetting parallelSoundSetting;
+	WorkerPool soundWorkers;
+
+	struct SoundStatsInfoTopic final : InfoTopic {
+		explicit SoundStatsInfoTopic(InfoCommand& openMSXInfoCommand);
+		void execute(span<const TclObject> tokens,
+			     TclObject& result) const override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+	} soundStatsInfo;
 
 	int muteCount;
 };
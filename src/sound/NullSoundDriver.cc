@@ -24,4 +24,14 @@ void NullSoundDriver::uploadBuffer(float* /*buffer*/, unsigned /*len*/)
 {
 }
 
+unsigned NullSoundDriver::getUnderrunCount() const
+{
+	return 0;
+}
+
+unsigned NullSoundDriver::getOverrunCount() const
+{
+	return 0;
+}
+
 } // namespace openmsx
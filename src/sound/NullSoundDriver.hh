@@ -15,6 +15,8 @@ public:
 	unsigned getSamples() const override;
 
 	void uploadBuffer(float* buffer, unsigned len) override;
+	unsigned getUnderrunCount() const override;
+	unsigned getOverrunCount() const override;
 };
 
 } // namespace openmsx
@@ -19,59 +19,96 @@ ResampleBlip<CHANNELS>::ResampleBlip(
 	ranges::fill(lastInput, 0.0f);
 }
 
+template <unsigned CHANNELS>
+void ResampleBlip<CHANNELS>::generateSamples(EmuTime::param emu1,
+                                             unsigned emuNum)
+{
+	// 3 extra for padding, CHANNELS extra for sentinel
+	// Clang will produce a link error if the length expression is put
+	// inside the macro.
+	const unsigned len = emuNum * CHANNELS + std::max(3u, CHANNELS);
+	VLA_SSE_ALIGNED(float, buf, len);
+	if (input.generateInput(buf, emuNum)) {
+		FP pos1;
+		hostClock.getTicksTill(emu1, pos1);
+		for (unsigned ch = 0; ch < CHANNELS; ++ch) {
+			// In case of PSG (and to a lesser degree SCC) it happens
+			// very often that two consecutive samples have the same
+			// value. We can benefit from this by setting a sentinel
+			// at the end of the buffer and move the end-of-loop test
+			// into the 'samples differ' branch.
+			assert(emuNum > 0);
+			buf[CHANNELS * emuNum + ch] =
+				buf[CHANNELS * (emuNum - 1) + ch] + 1.0f;
+			FP pos = pos1;
+			auto last = lastInput[ch]; // local var is slightly faster
+			for (unsigned i = 0; /**/; ++i) {
+				auto delta = buf[CHANNELS * i + ch] - last;
+				if (unlikely(delta != 0)) {
+					if (i == emuNum) {
+						break;
+					}
+					last = buf[CHANNELS * i + ch];
+					blip[ch].addDelta(
+						BlipBuffer::TimeIndex(pos),
+						delta);
+				}
+				pos += step;
+			}
+			lastInput[ch] = last;
+		}
+	} else {
+		// input all zero
+		BlipBuffer::TimeIndex pos;
+		hostClock.getTicksTill(emu1, pos);
+		for (unsigned ch = 0; ch < CHANNELS; ++ch) {
+			if (lastInput[ch] != 0.0f) {
+				auto delta = -lastInput[ch];
+				lastInput[ch] = 0.0f;
+				blip[ch].addDelta(pos, delta);
+			}
+		}
+	}
+}
+
+template <unsigned CHANNELS>
+void ResampleBlip<CHANNELS>::generateSteps(EmuTime::param emu1, unsigned emuNum)
+{
+	FP pos1;
+	hostClock.getTicksTill(emu1, pos1);
+	if (!stepsValid) {
+		// Continue from the current output level: assign all of it to
+		// the first channel, the first change of that channel then
+		// produces the correct delta.
+		steps.resize(input.getNumChannels());
+		for (auto& s : steps) s.setLast(0.0f);
+		steps[0].setLast(lastInput[0]);
+		stepsValid = true;
+	}
+	for (auto& s : steps) s.start(blip[0], pos1, step);
+
+	if (!input.generateStepInput(steps.data(), emuNum)) {
+		// input all zero
+		for (auto& s : steps) s.fill(0.0f, emuNum);
+	}
+	float last = 0.0f;
+	for (auto& s : steps) last += s.getLast();
+	lastInput[0] = last;
+}
+
 template <unsigned CHANNELS>
 bool ResampleBlip<CHANNELS>::generateOutput(float* dataOut, unsigned hostNum,
                                             EmuTime::param time)
 {
 	unsigned emuNum = emuClock.getTicksTill(time);
 	if (emuNum > 0) {
-		// 3 extra for padding, CHANNELS extra for sentinel
-		// Clang will produce a link error if the length expression is put
-		// inside the macro.
-		const unsigned len = emuNum * CHANNELS + std::max(3u, CHANNELS);
-		VLA_SSE_ALIGNED(float, buf, len);
 		EmuTime emu1 = emuClock.getFastAdd(1); // time of 1st emu-sample
 		assert(emu1 > hostClock.getTime());
-		if (input.generateInput(buf, emuNum)) {
-			FP pos1;
-			hostClock.getTicksTill(emu1, pos1);
-			for (unsigned ch = 0; ch < CHANNELS; ++ch) {
-				// In case of PSG (and to a lesser degree SCC) it happens
-				// very often that two consecutive samples have the same
-				// value. We can benefit from this by setting a sentinel
-				// at the end of the buffer and move the end-of-loop test
-				// into the 'samples differ' branch.
-				assert(emuNum > 0);
-				buf[CHANNELS * emuNum + ch] =
-					buf[CHANNELS * (emuNum - 1) + ch] + 1.0f;
-				FP pos = pos1;
-				auto last = lastInput[ch]; // local var is slightly faster
-				for (unsigned i = 0; /**/; ++i) {
-					auto delta = buf[CHANNELS * i + ch] - last;
-					if (unlikely(delta != 0)) {
-						if (i == emuNum) {
-							break;
-						}
-						last = buf[CHANNELS * i + ch];
-						blip[ch].addDelta(
-							BlipBuffer::TimeIndex(pos),
-							delta);
-					}
-					pos += step;
-				}
-				lastInput[ch] = last;
-			}
+		if ((CHANNELS == 1) && input.canGenerateSteps()) {
+			generateSteps(emu1, emuNum);
 		} else {
-			// input all zero
-			BlipBuffer::TimeIndex pos;
-			hostClock.getTicksTill(emu1, pos);
-			for (unsigned ch = 0; ch < CHANNELS; ++ch) {
-				if (lastInput[ch] != 0.0f) {
-					auto delta = -lastInput[ch];
-					lastInput[ch] = 0.0f;
-					blip[ch].addDelta(pos, delta);
-				}
-			}
+			stepsValid = false;
+			generateSamples(emu1, emuNum);
 		}
 		emuClock += emuNum;
 		assert(emuClock.getTime() <= time);
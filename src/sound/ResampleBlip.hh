@@ -4,6 +4,8 @@
 #include "ResampleAlgo.hh"
 #include "BlipBuffer.hh"
 #include "DynamicClock.hh"
+#include "StepChannel.hh"
+#include <vector>
 
 namespace openmsx {
 
@@ -20,6 +22,9 @@ public:
 	                    EmuTime::param time) override;
 
 private:
+	void generateSamples(EmuTime::param emu1, unsigned emuNum);
+	void generateSteps(EmuTime::param emu1, unsigned emuNum);
+
 	BlipBuffer blip[CHANNELS];
 	ResampledSoundDevice& input;
 	const DynamicClock& hostClock; // time of the last host-sample,
@@ -29,6 +34,12 @@ private:
 	using FP = FixedPoint<16>;
 	const FP step;
 	float lastInput[CHANNELS];
+
+	// Only for devices that can directly produce steps (mono only). When
+	// 'stepsValid' is false, the levels in 'steps' don't (yet) correspond
+	// to 'lastInput' (e.g. after generateInput() was used).
+	std::vector<StepChannel> steps;
+	bool stepsValid = false;
 };
 
 } // namespace openmsx
@@ -45,6 +45,11 @@ static const int COEFF_HALF_LEN = COEFF_LEN - 1;
 static const unsigned TAB_LEN = 4096;
 static const unsigned HALF_TAB_LEN = TAB_LEN / 2;
 
+// Polyphase filter bank: for a given resample ratio, row 't' of the table
+// holds the (interpolated and normalized) filter taps for output position
+// 't / TAB_LEN' between two input samples. The table only depends on the
+// ratio, so all ResampleHQ instances with the same ratio (typically all
+// sound chips running at the same emulated sample rate) share one table.
 class ResampleCoeffs
 {
 public:
@@ -23,6 +23,15 @@ public:
 	  */
 	bool generateInput(float* buffer, unsigned num);
 
+	/** Alternative for generateInput() that passes the output of each
+	  * channel as steps to a BlipBuffer (see mixChannelSteps()). Only
+	  * possible when canGenerateSteps() returns true.
+	  */
+	bool canGenerateSteps() const { return canMixSteps(); }
+	bool generateStepInput(StepChannel* channels, unsigned num) {
+		return mixChannelSteps(channels, num);
+	}
+
 protected:
 	ResampledSoundDevice(MSXMotherBoard& motherBoard, string_view name,
 	                     string_view description, unsigned channels,
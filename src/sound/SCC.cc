@@ -104,6 +104,8 @@
 #include "ranges.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 
 using std::string;
@@ -464,18 +466,52 @@ void SCC::setDeformRegHelper(byte value)
 }
 
 void SCC::generateChannels(float** bufs, unsigned num)
+{
+	generate(bufs, num);
+}
+
+bool SCC::hasStepOutput() const
+{
+	return true;
+}
+
+void SCC::generateChannelSteps(StepChannel** channels, unsigned num)
+{
+	generate(channels, num);
+}
+
+// Buf is either 'float' (write all samples) or 'StepChannel' (only pass on
+// the changes), the addFill() overloads hide the difference.
+//
+// The output of a channel only changes when its counter wraps, so instead of
+// stepping the counter per sample, calculate the length of each run of
+// samples with the same waveform position and fill those at once. Channels
+// that are disabled, have volume zero, or that produce a constant zero
+// output (a period that's too small to be stepped) are skipped entirely.
+template<typename Buf>
+void SCC::generate(Buf** bufs, unsigned num)
 {
 	unsigned enable = ch_enable;
 	for (unsigned i = 0; i < 5; ++i, enable >>= 1) {
-		if ((enable & 1) && (volume[i] || out[i])) {
+		unsigned incr2 = incr[i];
+		if ((enable & 1) && (volume[i] || out[i]) &&
+		    ((incr2 != 0) || (out[i] != 0.0f))) {
+			auto* buf = bufs[i];
 			auto out2 = out[i];
 			unsigned count2 = count[i];
 			unsigned pos2 = pos[i];
-			unsigned incr2 = incr[i];
 			unsigned period2 = period[i] + 1;
-			for (unsigned j = 0; j < num; ++j) {
-				bufs[i][j] += out2;
-				count2 += incr2;
+			unsigned remaining = num;
+			while (remaining) {
+				// the number of samples till the counter wraps
+				assert(count2 < period2);
+				unsigned n = remaining;
+				if (incr2) {
+					n = std::min(n, (period2 - count2 + incr2 - 1) / incr2);
+				}
+				addFill(buf, out2, n);
+				remaining -= n;
+				count2 += n * incr2;
 				// Note: only for very small periods
 				//       this will take more than 1 iteration
 				while (unlikely(count2 >= period2)) {
@@ -489,16 +525,21 @@ void SCC::generateChannels(float** bufs, unsigned num)
 			pos[i] = pos2;
 		} else {
 			bufs[i] = nullptr; // channel muted
-			// Update phase counter.
-			unsigned newCount = count[i] + num * incr[i];
-			count[i] = newCount % (period[i] + 1);
-			pos[i] = (pos[i] + newCount / (period[i] + 1)) % 32;
-			// Channel stays off until next waveform index.
-			out[i] = 0.0f;
+			skipChannel(i, num);
 		}
 	}
 }
 
+void SCC::skipChannel(unsigned i, unsigned num)
+{
+	// Update phase counter.
+	unsigned newCount = count[i] + num * incr[i];
+	count[i] = newCount % (period[i] + 1);
+	pos[i] = (pos[i] + newCount / (period[i] + 1)) % 32;
+	// Channel stays off until next waveform index.
+	out[i] = 0.0f;
+}
+
 
 // Debuggable
 
@@ -32,6 +32,10 @@ private:
 	// SoundDevice
 	float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	void generateChannelSteps(StepChannel** channels, unsigned num) override;
+	bool hasStepOutput() const override;
+	template<typename Buf> void generate(Buf** bufs, unsigned num);
+	void skipChannel(unsigned i, unsigned num);
 
 	inline float adjust(signed char wav, byte vol);
 	byte readWave(unsigned channel, unsigned address, EmuTime::param time) const;
@@ -14,8 +14,12 @@
 namespace openmsx {
 
 SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
-                               unsigned wantedFreq, unsigned wantedSamples)
+                               unsigned wantedFreq, unsigned wantedSamples,
+                               bool adaptive_)
 	: reactor(reactor_)
+	, adaptive(adaptive_)
+	, readIdx(0), writeIdx(0)
+	, underruns(0), overruns(0)
 	, muted(true)
 {
 	SDL_AudioSpec desired;
@@ -36,7 +40,11 @@ SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
 	frequency = obtained.freq;
 	fragmentSize = obtained.samples;
 
-	mixBufferSize = 3 * (obtained.size / sizeof(float)) + 2;
+	// In adaptive mode the fill level starts at 2 fragments and can grow
+	// up to 8 fragments. Otherwise it's fixed at 3 fragments.
+	unsigned fragmentFloats = obtained.size / sizeof(float);
+	mixBufferSize = (adaptive ? 8 : 3) * fragmentFloats + 2;
+	bufferLimit   = (adaptive ? 2 : 3) * fragmentFloats;
 	mixBuffer.resize(mixBufferSize);
 	reInit();
 }
@@ -48,6 +56,8 @@ SDLSoundDriver::~SDLSoundDriver()
 
 void SDLSoundDriver::reInit()
 {
+	// Only called while the audio device is paused (or not yet started),
+	// the lock is just to be sure the callback isn't running anymore.
 	SDL_LockAudioDevice(deviceID);
 	readIdx  = 0;
 	writeIdx = 0;
@@ -88,81 +98,124 @@ void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
 		audioCallback(reinterpret_cast<float*>(strm), len / sizeof(float));
 }
 
-unsigned SDLSoundDriver::getBufferFilled() const
+unsigned SDLSoundDriver::getUnderrunCount() const
 {
-	int result = writeIdx - readIdx;
+	return underruns;
+}
+
+unsigned SDLSoundDriver::getOverrunCount() const
+{
+	return overruns;
+}
+
+unsigned SDLSoundDriver::getBufferFilled(unsigned readIdx_, unsigned writeIdx_) const
+{
+	int result = writeIdx_ - readIdx_;
 	if (result < 0) result += mixBufferSize;
 	assert((0 <= result) && (unsigned(result) < mixBufferSize));
 	return result;
 }
 
-unsigned SDLSoundDriver::getBufferFree() const
+unsigned SDLSoundDriver::getBufferFree(unsigned readIdx_, unsigned writeIdx_) const
 {
 	// we can't distinguish completely filled from completely empty
 	// (in both cases readIx would be equal to writeIdx), so instead
 	// we define full as '(writeIdx + 2) == readIdx' (note that index
 	// increases in steps of 2 (stereo)).
-	int result = mixBufferSize - 2 - getBufferFilled();
-	assert((0 <= result) && (unsigned(result) < mixBufferSize));
-	return result;
+	// In adaptive mode the limit may have been lowered below the current
+	// fill level, in that case there's temporarily no free space.
+	assert(bufferLimit <= (mixBufferSize - 2));
+	int result = bufferLimit - getBufferFilled(readIdx_, writeIdx_);
+	return std::max(result, 0);
 }
 
 void SDLSoundDriver::audioCallback(float* stream, unsigned len)
 {
 	assert((len & 1) == 0); // stereo
-	unsigned available = getBufferFilled();
+	// acquire: the data before 'writeIdx' is completely written
+	unsigned wIdx = writeIdx.load(std::memory_order_acquire);
+	unsigned rIdx = readIdx.load(std::memory_order_relaxed);
+	unsigned available = getBufferFilled(rIdx, wIdx);
 	unsigned num = std::min(len, available);
-	if ((readIdx + num) < mixBufferSize) {
-		memcpy(stream, &mixBuffer[readIdx], num * sizeof(float));
-		readIdx += num;
+	if ((rIdx + num) < mixBufferSize) {
+		memcpy(stream, &mixBuffer[rIdx], num * sizeof(float));
+		rIdx += num;
 	} else {
-		unsigned len1 = mixBufferSize - readIdx;
-		memcpy(stream, &mixBuffer[readIdx], len1 * sizeof(float));
+		unsigned len1 = mixBufferSize - rIdx;
+		memcpy(stream, &mixBuffer[rIdx], len1 * sizeof(float));
 		unsigned len2 = num - len1;
 		memcpy(&stream[len1], &mixBuffer[0], len2 * sizeof(float));
-		readIdx = len2;
+		rIdx = len2;
 	}
+	// release: we're done reading the data before 'readIdx'
+	readIdx.store(rIdx, std::memory_order_release);
+
 	int missing = len - available;
 	if (missing > 0) {
 		// buffer underrun
 		memset(&stream[available], 0, missing * sizeof(float));
+		underruns.fetch_add(1, std::memory_order_relaxed);
 	}
 }
 
+void SDLSoundDriver::adaptBufferLimit(unsigned len)
+{
+	// Grow quickly (half a fragment per underrun) and shrink slowly (an
+	// eighth of a fragment after 5 seconds without underruns).
+	unsigned fragmentFloats = 2 * fragmentSize;
+	unsigned maxLimit = mixBufferSize - 2;
+	unsigned minLimit = std::min(maxLimit, std::max(fragmentFloats, len));
+
+	unsigned newUnderruns = underruns.load(std::memory_order_relaxed);
+	if (newUnderruns != prevUnderruns) {
+		prevUnderruns = newUnderruns;
+		bufferLimit += fragmentFloats / 2;
+		quietSamples = 0;
+	} else {
+		quietSamples += len;
+		if (quietSamples >= 2 * 5 * frequency) {
+			bufferLimit -= std::min(bufferLimit, fragmentFloats / 8);
+			quietSamples = 0;
+		}
+	}
+	bufferLimit = std::min(std::max(bufferLimit, minLimit), maxLimit) & ~1;
+}
+
 void SDLSoundDriver::uploadBuffer(float* buffer, unsigned len)
 {
-	SDL_LockAudioDevice(deviceID);
 	len *= 2; // stereo
-	unsigned free = getBufferFree();
+	if (adaptive) adaptBufferLimit(len);
+	unsigned wIdx = writeIdx.load(std::memory_order_relaxed);
+	// acquire: the audio thread is done with the data before 'readIdx'
+	unsigned free = getBufferFree(readIdx.load(std::memory_order_acquire), wIdx);
 	if (len > free) {
 		if (reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
 			do {
-				SDL_UnlockAudioDevice(deviceID);
 				Timer::sleep(5000); // 5ms
-				SDL_LockAudioDevice(deviceID);
 				if (MSXMotherBoard* board = reactor.getMotherBoard()) {
 					board->getRealTime().resync();
 				}
-				free = getBufferFree();
+				free = getBufferFree(readIdx.load(std::memory_order_acquire), wIdx);
 			} while (len > free);
 		} else {
 			// drop excess samples
 			len = free;
+			overruns.fetch_add(1, std::memory_order_relaxed);
 		}
 	}
 	assert(len <= free);
-	if ((writeIdx + len) < mixBufferSize) {
-		memcpy(&mixBuffer[writeIdx], buffer, len * sizeof(float));
-		writeIdx += len;
+	if ((wIdx + len) < mixBufferSize) {
+		memcpy(&mixBuffer[wIdx], buffer, len * sizeof(float));
+		wIdx += len;
 	} else {
-		unsigned len1 = mixBufferSize - writeIdx;
-		memcpy(&mixBuffer[writeIdx], buffer, len1 * sizeof(float));
+		unsigned len1 = mixBufferSize - wIdx;
+		memcpy(&mixBuffer[wIdx], buffer, len1 * sizeof(float));
 		unsigned len2 = len - len1;
 		memcpy(&mixBuffer[0], &buffer[len1], len2 * sizeof(float));
-		writeIdx = len2;
+		wIdx = len2;
 	}
-
-	SDL_UnlockAudioDevice(deviceID);
+	// release: publish the data before 'writeIdx'
+	writeIdx.store(wIdx, std::memory_order_release);
 }
 
 } // namespace openmsx
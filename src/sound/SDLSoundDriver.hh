@@ -5,6 +5,7 @@
 #include "SDLSurfacePtr.hh"
 #include "MemBuffer.hh"
 #include <SDL.h>
+#include <atomic>
 
 namespace openmsx {
 
@@ -16,7 +17,12 @@ public:
 	SDLSoundDriver(const SDLSoundDriver&) = delete;
 	SDLSoundDriver& operator=(const SDLSoundDriver&) = delete;
 
-	SDLSoundDriver(Reactor& reactor, unsigned wantedFreq, unsigned samples);
+	/** When 'adaptive' is set, the amount of buffered sound data is kept
+	  * as low as possible: it grows on buffer underruns and slowly shrinks
+	  * again as long as there are none.
+	  */
+	SDLSoundDriver(Reactor& reactor, unsigned wantedFreq, unsigned samples,
+	               bool adaptive);
 	~SDLSoundDriver() override;
 
 	void mute() override;
@@ -26,11 +32,14 @@ public:
 	unsigned getSamples() const override;
 
 	void uploadBuffer(float* buffer, unsigned len) override;
+	unsigned getUnderrunCount() const override;
+	unsigned getOverrunCount() const override;
 
 private:
 	void reInit();
-	unsigned getBufferFilled() const;
-	unsigned getBufferFree() const;
+	unsigned getBufferFilled(unsigned readIdx, unsigned writeIdx) const;
+	unsigned getBufferFree  (unsigned readIdx, unsigned writeIdx) const;
+	void adaptBufferLimit(unsigned len);
 	static void audioCallbackHelper(void* userdata, uint8_t* strm, int len);
 	void audioCallback(float* stream, unsigned len);
 
@@ -40,7 +49,18 @@ private:
 	unsigned mixBufferSize;
 	unsigned frequency;
 	unsigned fragmentSize;
-	unsigned readIdx, writeIdx;
+	// Max number of floats in 'mixBuffer' before uploadBuffer() blocks
+	// (or drops samples). Only changes when 'adaptive' is set.
+	unsigned bufferLimit;
+	unsigned prevUnderruns = 0; // underrun count at last adaptation
+	unsigned quietSamples = 0;  // floats uploaded since last shrink/grow
+	const bool adaptive;
+	// 'mixBuffer' is a single-producer (uploadBuffer(), main thread),
+	// single-consumer (audioCallback(), SDL audio thread) ring buffer.
+	// Only the producer changes 'writeIdx' and only the consumer changes
+	// 'readIdx', so no lock is needed.
+	std::atomic<unsigned> readIdx, writeIdx;
+	std::atomic<unsigned> underruns, overruns;
 	bool muted;
 	SDLSubSystemInitializer<SDL_INIT_AUDIO> audioInitializer;
 };
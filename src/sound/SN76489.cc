@@ -206,8 +206,19 @@ void SN76489::writeRegister(unsigned reg, word value, EmuTime::param time)
  * channel are in phase, but do end up in their own separate mixing buffers.
  */
 
-template <bool NOISE> void SN76489::synthesizeChannel(
-		float*& buffer, unsigned num, unsigned generator)
+// The output is low: skip samples (they're zero in the buffer), or for step
+// output make the channel go to zero.
+static inline void skipFill(float*& buffer, unsigned num)
+{
+	buffer += num;
+}
+static inline void skipFill(StepChannel*& channel, unsigned num)
+{
+	channel->fill(0.0f, num);
+}
+
+template <bool NOISE, typename Buf> void SN76489::synthesizeChannel(
+		Buf*& buffer, unsigned num, unsigned generator)
 {
 	unsigned period;
 	if (generator == 3) {
@@ -250,7 +261,7 @@ template <bool NOISE> void SN76489::synthesizeChannel(
 			if (NOISE ? noiseShifter.getOutput() : output) {
 				addFill(buf, volume, ticks);
 			} else {
-				buf += ticks;
+				skipFill(buf, ticks);
 			}
 			counter -= ticks;
 			remaining -= ticks;
@@ -279,6 +290,22 @@ template <bool NOISE> void SN76489::synthesizeChannel(
 }
 
 void SN76489::generateChannels(float** buffers, unsigned num)
+{
+	generate(buffers, num);
+}
+
+bool SN76489::hasStepOutput() const
+{
+	return true;
+}
+
+void SN76489::generateChannelSteps(StepChannel** channels, unsigned num)
+{
+	generate(channels, num);
+}
+
+template<typename Buf>
+void SN76489::generate(Buf** buffers, unsigned num)
 {
 	// Channel 3: noise.
 	if ((regs[6] & 3) == 3) {
@@ -29,6 +29,8 @@ public:
 
 	// ResampledSoundDevice
 	void generateChannels(float** buffers, unsigned num) override;
+	void generateChannelSteps(StepChannel** channels, unsigned num) override;
+	bool hasStepOutput() const override;
 
 	void reset(EmuTime::param time);
 	void write(byte value, EmuTime::param time);
@@ -86,8 +88,9 @@ private:
 
 	word peekRegister(unsigned reg, EmuTime::param time) const;
 	void writeRegister(unsigned reg, word value, EmuTime::param time);
-	template <bool NOISE> void synthesizeChannel(
-		float*& buffer, unsigned num, unsigned generator);
+	template<typename Buf> void generate(Buf** buffers, unsigned num);
+	template <bool NOISE, typename Buf> void synthesizeChannel(
+		Buf*& buffer, unsigned num, unsigned generator);
 
 	unsigned volTable[16];
 
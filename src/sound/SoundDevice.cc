@@ -7,9 +7,11 @@
 #include "StringOp.hh"
 #include "MemoryOps.hh"
 #include "MemBuffer.hh"
+#include "SoundMixOps.hh"
 #include "MSXException.hh"
 #include "likely.hh"
 #include "ranges.hh"
+#include "unreachable.hh"
 #include "vla.hh"
 #include "xrange.hh"
 #include <cassert>
@@ -19,8 +21,9 @@ using std::string;
 
 namespace openmsx {
 
-static MemBuffer<float, SSE2_ALIGNMENT> mixBuffer;
-static unsigned mixBufferSize = 0;
+// Scratch buffer shared by all sound devices that are mixed on this thread.
+static thread_local MemBuffer<float, SSE2_ALIGNMENT> mixBuffer;
+static thread_local unsigned mixBufferSize = 0;
 
 static void allocateMixBuffer(unsigned size)
 {
@@ -64,6 +67,7 @@ SoundDevice::SoundDevice(MSXMixer& mixer_, string_view name_, string_view descri
 	, stereo(stereo_ ? 2 : 1)
 	, numRecordChannels(0)
 	, balanceCenter(true)
+	, suspended(false)
 {
 	assert(numChannels <= MAX_CHANNELS);
 	assert(stereo == 1 || stereo == 2);
@@ -87,6 +91,22 @@ float SoundDevice::getAmplificationFactorImpl() const
 	return 1.0f / 32768.0f;
 }
 
+bool SoundDevice::staysSilent()
+{
+	return false;
+}
+
+void SoundDevice::generateChannelSteps(StepChannel** /*channels*/,
+                                       unsigned /*num*/)
+{
+	UNREACHABLE;
+}
+
+bool SoundDevice::hasStepOutput() const
+{
+	return false;
+}
+
 void SoundDevice::registerSound(const DeviceConfig& config)
 {
 	const XMLElement& soundConfig = config.getChild("sound");
@@ -136,6 +156,9 @@ void SoundDevice::unregisterSound()
 void SoundDevice::updateStream(EmuTime::param time)
 {
 	mixer.updateStream(time);
+	// Something (e.g. a register) is about to change, so the device
+	// might start producing sound again.
+	suspended = false;
 }
 
 void SoundDevice::setSoftwareVolume(float volume, EmuTime::param time)
@@ -191,6 +214,11 @@ bool SoundDevice::mixChannels(float* dataOut, unsigned samples)
 	assert((uintptr_t(dataOut) & 15) == 0); // must be 16-byte aligned
 #endif
 	if (samples == 0) return true;
+	if (numRecordChannels == 0) {
+		// (When recording we must still write silence to the files.)
+		if (!suspended) suspended = staysSilent();
+		if (suspended) return false;
+	}
 	unsigned outputStereo = isStereo() ? 2 : 1;
 
 	static_assert(sizeof(float) == sizeof(uint32_t), "");
@@ -279,60 +307,39 @@ bool SoundDevice::mixChannels(float* dataOut, unsigned samples)
 
 	// actually mix channels
 	if (!balanceCenter) {
-		unsigned i = 0;
-		do {
-			float left0  = 0.0f;
-			float right0 = 0.0f;
-			float left1  = 0.0f;
-			float right1 = 0.0f;
-			unsigned j = 0;
-			do {
-				if (mixBalance[j] <= 0) {
-					left0  += bufs[j][i + 0];
-					left1  += bufs[j][i + 1];
-				}
-				if (mixBalance[j] >= 0) {
-					right0 += bufs[j][i + 0];
-					right1 += bufs[j][i + 1];
-				}
-				j++;
-			} while (j < numMix);
-			dataOut[i * 2 + 0] = left0;
-			dataOut[i * 2 + 1] = right0;
-			dataOut[i * 2 + 2] = left1;
-			dataOut[i * 2 + 3] = right1;
-			i += 2;
-		} while (i < samples);
-
-		return true;
+		SoundMixOps::mixBalance(dataOut, bufs, mixBalance, numMix, samples);
+	} else {
+		SoundMixOps::sumChannels(dataOut, bufs, numMix, samples * stereo);
 	}
+	return true;
+}
 
-	// In the past we had ARM and x86-SSE2 optimized assembly routines for
-	// the stuff below. Currently this code is only rarely used anymore
-	// (only when recording or muting individual soundchip channels), so
-	// it's not worth the extra complexity anymore.
-	unsigned num = samples * stereo;
-	unsigned i = 0;
-	do {
-		auto out0 = dataOut[i + 0];
-		auto out1 = dataOut[i + 1];
-		auto out2 = dataOut[i + 2];
-		auto out3 = dataOut[i + 3];
-		unsigned j = 0;
-		do {
-			out0 += bufs[j][i + 0];
-			out1 += bufs[j][i + 1];
-			out2 += bufs[j][i + 2];
-			out3 += bufs[j][i + 3];
-			++j;
-		} while (j < numMix);
-		dataOut[i + 0] = out0;
-		dataOut[i + 1] = out1;
-		dataOut[i + 2] = out2;
-		dataOut[i + 3] = out3;
-		i += 4;
-	} while (i < num);
+bool SoundDevice::canMixSteps() const
+{
+	// isStereo() is also true for a mono device with panned channels
+	return hasStepOutput() && !isStereo() && (numRecordChannels == 0) &&
+	       ranges::none_of(xrange(numChannels),
+	                       [&](auto i) { return channelMuted[i]; });
+}
 
+bool SoundDevice::mixChannelSteps(StepChannel* channels, unsigned samples)
+{
+	assert(canMixSteps());
+	if (samples == 0) return true;
+	if (!suspended) suspended = staysSilent();
+	if (suspended) return false;
+
+	VLA(StepChannel*, chans, numChannels);
+	for (unsigned i = 0; i < numChannels; ++i) {
+		chans[i] = &channels[i];
+	}
+	generateChannelSteps(chans, samples);
+	for (unsigned i = 0; i < numChannels; ++i) {
+		if (!chans[i]) {
+			// channel silent (set to nullptr by the device)
+			channels[i].fill(0.0f, samples);
+		}
+	}
 	return true;
 }
 
@@ -3,6 +3,7 @@
 
 #include "MSXMixer.hh"
 #include "EmuTime.hh"
+#include "StepChannel.hh"
 #include "string_view.hh"
 #include <memory>
 
@@ -33,6 +34,9 @@ public:
 	  */
 	bool isStereo() const;
 
+	/** The number of channels of this device (see generateChannels()). */
+	unsigned getNumChannels() const { return numChannels; }
+
 	/** Gets this device its 'amplification factor'.
 	  *
 	  * Each sample generated by the 'updateBuffer' method will get
@@ -147,6 +151,11 @@ protected:
 	  * @param num The number of samples.
 	  */
 	static void addFill(float*& buffer, float value, unsigned num);
+	/** Same as above, but for the step output of a channel (see
+	  * generateChannelSteps()). */
+	static void addFill(StepChannel*& channel, float value, unsigned num) {
+		channel->fill(value, num);
+	}
 
 	/** Abstract method to generate the actual sound data.
 	  * @param buffers An array of pointer to buffers. Each buffer must
@@ -163,6 +172,29 @@ protected:
 	  */
 	virtual void generateChannels(float** buffers, unsigned num) = 0;
 
+	/** Like generateChannels(), but instead of writing all samples in a
+	  * buffer, only the changes of the output of each channel are passed
+	  * on (see StepChannel). The result must be the same as writing the
+	  * samples with generateChannels(). Setting a channel to nullptr
+	  * again means that channel is silent.
+	  * Only called when hasStepOutput() returns true.
+	  */
+	virtual void generateChannelSteps(StepChannel** channels, unsigned num);
+
+	/** Does this device implement generateChannelSteps()?
+	  * The default implementation returns false.
+	  */
+	virtual bool hasStepOutput() const;
+
+	/** Is this device guaranteed to stay silent until the next call to
+	  * updateStream() (normally that's done right before each register
+	  * write)? If so, generateChannels() isn't called anymore until then.
+	  * This also means the internal state of the device doesn't advance
+	  * during that time, so only return true when that doesn't matter.
+	  * The default implementation returns false.
+	  */
+	virtual bool staysSilent();
+
 	/** Calls generateChannels() and combines the output to a single
 	  * channel.
 	  * @param dataOut Output buffer, must be big enough to hold
@@ -177,6 +209,22 @@ protected:
 	  */
 	bool mixChannels(float* dataOut, unsigned samples);
 
+	/** Can mixChannelSteps() be used instead of mixChannels()? That's
+	  * only possible when the device supports it and when the output of
+	  * its channels doesn't have to be kept separate (no muted, recorded
+	  * or panned channels).
+	  */
+	bool canMixSteps() const;
+
+	/** Calls generateChannelSteps(), the counterpart of mixChannels().
+	  * @param channels Array of getNumChannels() StepChannels, all
+	  *                 started at the position of the first sample.
+	  * @param samples The number of samples
+	  * @result false iff the device stays silent (see staysSilent()),
+	  *         then nothing was passed to the channels.
+	  */
+	bool mixChannelSteps(StepChannel* channels, unsigned samples);
+
 	/** See MSXMixer::getHostSampleClock(). */
 	const DynamicClock& getHostSampleClock() const;
 	double getEffectiveSpeed() const;
@@ -197,6 +245,7 @@ private:
 	int channelBalance[MAX_CHANNELS];
 	bool channelMuted[MAX_CHANNELS];
 	bool balanceCenter;
+	bool suspended; // see staysSilent()
 };
 
 } // namespace openmsx
@@ -28,6 +28,16 @@ public:
 
 	virtual void uploadBuffer(float* buffer, unsigned len) = 0;
 
+	/** Number of times the sound output ran out of data, so silence had
+	  * to be inserted (buffer underrun).
+	  */
+	virtual unsigned getUnderrunCount() const = 0;
+
+	/** Number of times uploadBuffer() had to drop samples because the
+	  * buffer was full (buffer overrun).
+	  */
+	virtual unsigned getOverrunCount() const = 0;
+
 protected:
 	SoundDriver() = default;
 };
@@ -0,0 +1,269 @@
+#ifndef SOUNDMIXOPS_HH
+#define SOUNDMIXOPS_HH
+
+#include "aligned.hh"
+#include <cassert>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Inner loops used by SoundDevice and MSXMixer to combine the output of the
+// individual sound channels/devices.
+//
+// All buffers must be SSE aligned. Routines that work on groups of 4 values
+// can process upto 3 values more than requested, so buffers must have room
+// for (and their content must be rounded up to) a multiple of 4 values. The
+// SSE2 versions calculate exactly the same results as the C++ versions (same
+// operations in the same order).
+
+namespace openmsx {
+namespace SoundMixOps {
+
+// buf[0:n] *= f
+inline void mul(float* buf, int n, float f)
+{
+	// C++ version, unrolled 4x,
+	//   this allows gcc/clang to do much better auto-vectorization
+	// Note that this can process upto 3 samples too many, but that's OK.
+	assume_SSE_aligned(buf);
+	int i = 0;
+	do {
+		buf[i + 0] *= f;
+		buf[i + 1] *= f;
+		buf[i + 2] *= f;
+		buf[i + 3] *= f;
+		i += 4;
+	} while (i < n);
+}
+
+// acc[0:n] += mul[0:n] * f
+inline void mulAcc(
+	float* __restrict acc, const float* __restrict mul, int n, float f)
+{
+	// C++ version, unrolled 4x, see comments above.
+	assume_SSE_aligned(acc);
+	assume_SSE_aligned(mul);
+	int i = 0;
+	do {
+		acc[i + 0] += mul[i + 0] * f;
+		acc[i + 1] += mul[i + 1] * f;
+		acc[i + 2] += mul[i + 2] * f;
+		acc[i + 3] += mul[i + 3] * f;
+		i += 4;
+	} while (i < n);
+}
+
+// buf[0:2n+0:2] = buf[0:n] * l
+// buf[1:2n+1:2] = buf[0:n] * r
+inline void mulExpand(float* buf, int n, float l, float r)
+{
+	int i = n;
+#ifdef __SSE2__
+	// Back-to-front, so that the (in-place) output doesn't overwrite
+	// input that's still needed. First the samples that don't fill a
+	// complete group of 4.
+	while (i & 3) {
+		--i;
+		auto t = buf[i];
+		buf[2 * i + 0] = l * t;
+		buf[2 * i + 1] = r * t;
+	}
+	auto lr = _mm_setr_ps(l, r, l, r);
+	while (i != 0) {
+		i -= 4;
+		auto t = _mm_load_ps(buf + i);
+		auto lo = _mm_mul_ps(lr, _mm_unpacklo_ps(t, t));
+		auto hi = _mm_mul_ps(lr, _mm_unpackhi_ps(t, t));
+		_mm_store_ps(buf + 2 * i + 0, lo);
+		_mm_store_ps(buf + 2 * i + 4, hi);
+	}
+#else
+	do {
+		--i; // back-to-front
+		auto t = buf[i];
+		buf[2 * i + 0] = l * t;
+		buf[2 * i + 1] = r * t;
+	} while (i != 0);
+#endif
+}
+
+// acc[0:2n+0:2] += mul[0:n] * l
+// acc[1:2n+1:2] += mul[0:n] * r
+inline void mulExpandAcc(
+	float* __restrict acc, const float* __restrict mul, int n,
+	float l, float r)
+{
+	int i = 0;
+#ifdef __SSE2__
+	auto lr = _mm_setr_ps(l, r, l, r);
+	for (; (i + 4) <= n; i += 4) {
+		auto t = _mm_load_ps(mul + i);
+		auto a0 = _mm_load_ps(acc + 2 * i + 0);
+		auto a1 = _mm_load_ps(acc + 2 * i + 4);
+		a0 = _mm_add_ps(a0, _mm_mul_ps(lr, _mm_unpacklo_ps(t, t)));
+		a1 = _mm_add_ps(a1, _mm_mul_ps(lr, _mm_unpackhi_ps(t, t)));
+		_mm_store_ps(acc + 2 * i + 0, a0);
+		_mm_store_ps(acc + 2 * i + 4, a1);
+	}
+#endif
+	for (; i < n; ++i) {
+		auto t = mul[i];
+		acc[2 * i + 0] += l * t;
+		acc[2 * i + 1] += r * t;
+	}
+}
+
+// buf[0:2n+0:2] = buf[0:2n+0:2] * l1 + buf[1:2n+1:2] * l2
+// buf[1:2n+1:2] = buf[0:2n+0:2] * r1 + buf[1:2n+1:2] * r2
+inline void mulMix2(float* buf, int n, float l1, float l2, float r1, float r2)
+{
+	int i = 0;
+#ifdef __SSE2__
+	auto c1 = _mm_setr_ps(l1, r1, l1, r1);
+	auto c2 = _mm_setr_ps(l2, r2, l2, r2);
+	for (; (i + 2) <= n; i += 2) {
+		auto x = _mm_load_ps(buf + 2 * i);
+		auto t1 = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 0, 0));
+		auto t2 = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 1, 1));
+		_mm_store_ps(buf + 2 * i,
+		             _mm_add_ps(_mm_mul_ps(c1, t1), _mm_mul_ps(c2, t2)));
+	}
+#endif
+	for (; i < n; ++i) {
+		auto t1 = buf[2 * i + 0];
+		auto t2 = buf[2 * i + 1];
+		buf[2 * i + 0] = l1 * t1 + l2 * t2;
+		buf[2 * i + 1] = r1 * t1 + r2 * t2;
+	}
+}
+
+// acc[0:2n+0:2] += mul[0:2n+0:2] * l1 + mul[1:2n+1:2] * l2
+// acc[1:2n+1:2] += mul[0:2n+0:2] * r1 + mul[1:2n+1:2] * r2
+inline void mulMix2Acc(
+	float* __restrict acc, const float* __restrict mul, int n,
+	float l1, float l2, float r1, float r2)
+{
+	int i = 0;
+#ifdef __SSE2__
+	auto c1 = _mm_setr_ps(l1, r1, l1, r1);
+	auto c2 = _mm_setr_ps(l2, r2, l2, r2);
+	for (; (i + 2) <= n; i += 2) {
+		auto x = _mm_load_ps(mul + 2 * i);
+		auto t1 = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 0, 0));
+		auto t2 = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 1, 1));
+		auto m = _mm_add_ps(_mm_mul_ps(c1, t1), _mm_mul_ps(c2, t2));
+		_mm_store_ps(acc + 2 * i, _mm_add_ps(_mm_load_ps(acc + 2 * i), m));
+	}
+#endif
+	for (; i < n; ++i) {
+		auto t1 = mul[2 * i + 0];
+		auto t2 = mul[2 * i + 1];
+		acc[2 * i + 0] += l1 * t1 + l2 * t2;
+		acc[2 * i + 1] += r1 * t1 + r2 * t2;
+	}
+}
+
+// out[0:n] += bufs[0][0:n] + bufs[1][0:n] + ... + bufs[num-1][0:n]
+// Processes values in groups of 4 (n is rounded up).
+inline void sumChannels(float* __restrict out, float* const* bufs,
+                        unsigned num, unsigned n)
+{
+	assert(num > 0);
+	unsigned i = 0;
+#ifdef __SSE2__
+	// 2 groups of 4 per iteration, that hides the latency of the
+	// additions a bit better.
+	for (; (i + 8) <= n; i += 8) {
+		auto out0 = _mm_load_ps(out + i + 0);
+		auto out1 = _mm_load_ps(out + i + 4);
+		unsigned j = 0;
+		do {
+			out0 = _mm_add_ps(out0, _mm_load_ps(bufs[j] + i + 0));
+			out1 = _mm_add_ps(out1, _mm_load_ps(bufs[j] + i + 4));
+		} while (++j < num);
+		_mm_store_ps(out + i + 0, out0);
+		_mm_store_ps(out + i + 4, out1);
+	}
+	for (; i < n; i += 4) {
+		auto out0 = _mm_load_ps(out + i);
+		unsigned j = 0;
+		do {
+			out0 = _mm_add_ps(out0, _mm_load_ps(bufs[j] + i));
+		} while (++j < num);
+		_mm_store_ps(out + i, out0);
+	}
+#else
+	do {
+		auto out0 = out[i + 0];
+		auto out1 = out[i + 1];
+		auto out2 = out[i + 2];
+		auto out3 = out[i + 3];
+		unsigned j = 0;
+		do {
+			out0 += bufs[j][i + 0];
+			out1 += bufs[j][i + 1];
+			out2 += bufs[j][i + 2];
+			out3 += bufs[j][i + 3];
+		} while (++j < num);
+		out[i + 0] = out0;
+		out[i + 1] = out1;
+		out[i + 2] = out2;
+		out[i + 3] = out3;
+		i += 4;
+	} while (i < n);
+#endif
+}
+
+// Mix mono channels to a stereo output buffer. Channels with a negative
+// balance only go to the left, with a positive balance only to the right and
+// with balance zero to both sides:
+//   out[0:2n+0:2] = sum(bufs[j][0:n]) for all j with balance[j] <= 0
+//   out[1:2n+1:2] = sum(bufs[j][0:n]) for all j with balance[j] >= 0
+// Processes samples in groups of 2 (n is rounded up).
+inline void mixBalance(float* __restrict out, float* const* bufs,
+                       const int* balance, unsigned num, unsigned n)
+{
+	assert(num > 0);
+	unsigned i = 0;
+#ifdef __SSE2__
+	for (; (i + 4) <= n; i += 4) {
+		auto left  = _mm_setzero_ps();
+		auto right = _mm_setzero_ps();
+		unsigned j = 0;
+		do {
+			auto t = _mm_load_ps(bufs[j] + i);
+			if (balance[j] <= 0) left  = _mm_add_ps(left,  t);
+			if (balance[j] >= 0) right = _mm_add_ps(right, t);
+		} while (++j < num);
+		_mm_store_ps(out + 2 * i + 0, _mm_unpacklo_ps(left, right));
+		_mm_store_ps(out + 2 * i + 4, _mm_unpackhi_ps(left, right));
+	}
+#endif
+	for (; i < n; i += 2) {
+		float left0  = 0.0f;
+		float right0 = 0.0f;
+		float left1  = 0.0f;
+		float right1 = 0.0f;
+		unsigned j = 0;
+		do {
+			if (balance[j] <= 0) {
+				left0  += bufs[j][i + 0];
+				left1  += bufs[j][i + 1];
+			}
+			if (balance[j] >= 0) {
+				right0 += bufs[j][i + 0];
+				right1 += bufs[j][i + 1];
+			}
+		} while (++j < num);
+		out[i * 2 + 0] = left0;
+		out[i * 2 + 1] = right0;
+		out[i * 2 + 2] = left1;
+		out[i * 2 + 3] = right1;
+	}
+}
+
+} // namespace SoundMixOps
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef STEPCHANNEL_HH
+#define STEPCHANNEL_HH
+
+#include "BlipBuffer.hh"
+#include "FixedPoint.hh"
+
+namespace openmsx {
+
+/** The output of one channel of a sound device as a sequence of steps.
+  *
+  * Instead of writing every sample in a buffer (see
+  * SoundDevice::generateChannels()), only the changes of the output value
+  * are passed to a BlipBuffer, at the matching (fractional) position in host
+  * samples. For sound chips that produce (mostly) square waves, like the
+  * PSG, consecutive samples are very often equal, so this is a lot cheaper
+  * than generating all samples and resampling them afterwards.
+  */
+class StepChannel
+{
+public:
+	using FP = FixedPoint<16>;
+
+	/** Start a new block of samples: the first sample is at position
+	  * 'pos' in the BlipBuffer, each next sample 'step' further. */
+	void start(BlipBuffer& blip_, FP pos_, FP step_) {
+		blip = &blip_;
+		pos = pos_;
+		step = step_;
+	}
+
+	/** The next 'num' samples all have the given value. */
+	void fill(float value, unsigned num) {
+		if (value != last) {
+			blip->addDelta(BlipBuffer::TimeIndex(pos), value - last);
+			last = value;
+		}
+		pos += step * int(num);
+	}
+
+	/** The value of the last sample. */
+	float getLast() const { return last; }
+	void setLast(float value) { last = value; }
+
+private:
+	BlipBuffer* blip = nullptr;
+	FP pos;
+	FP step;
+	float last = 0.0f;
+};
+
+} // namespace openmsx
+
+#endif
@@ -18,6 +18,32 @@ class WavData
 	};
 
 public:
+	/** Format and location of the sample data in a .wav file. */
+	struct Format {
+		unsigned freq;
+		unsigned bits; // 8 or 16
+		unsigned channels;
+		unsigned length; // number of samples (per channel)
+		size_t dataOffset;
+	};
+
+	/** Parse the header of a .wav file, checks that all sample data is
+	  * present.
+	  * @throws MSXException
+	  */
+	static Format parseFormat(span<uint8_t> raw);
+
+	/** Get the (first channel of the) sample at the given position
+	  * converted to 16 bit. 'pos' must be smaller than format.length.
+	  */
+	static int16_t getRawSample(const Format& format, span<uint8_t> raw,
+	                            unsigned pos) {
+		const uint8_t* p = raw.data() + format.dataOffset +
+			size_t(pos) * format.channels * (format.bits / 8);
+		return (format.bits == 8) ? int16_t((int(*p) - 0x80) * 256)
+		                          : int16_t(Endian::read_UA_L16(p));
+	}
+
 	/** Construct empty wav. */
 	WavData() = default;
 
@@ -56,11 +82,9 @@ inline const T* WavData::read(span<uint8_t> raw, size_t offset, size_t count)
 	return reinterpret_cast<const T*>(raw.data() + offset);
 }
 
-template<typename Filter>
-inline WavData::WavData(File file, Filter filter)
+inline WavData::Format WavData::parseFormat(span<uint8_t> raw)
 {
 	// Read and check header
-	auto raw = file.mmap();
 	struct WavHeader {
 		char riffID[4];
 		Endian::L32 riffSize;
@@ -80,12 +104,14 @@ inline WavData::WavData(File file, Filter filter)
 	    memcmp(header->fmtID, "fmt ", 4)) {
 		throw MSXException("Invalid WAV file.");
 	}
-	unsigned bits = header->wBitsPerSample;
-	if ((header->wFormatTag != 1) || ((bits != 8) && (bits != 16))) {
+	Format format;
+	format.bits = header->wBitsPerSample;
+	if ((header->wFormatTag != 1) ||
+	    ((format.bits != 8) && (format.bits != 16))) {
 		throw MSXException("WAV format unsupported, must be 8 or 16 bit PCM.");
 	}
-	freq = header->dwSamplesPerSec;
-	unsigned channels = header->wChannels;
+	format.freq = header->dwSamplesPerSec;
+	format.channels = header->wChannels;
 
 	// Skip any extra format bytes
 	size_t pos = 20 + header->fmtSize;
@@ -105,22 +131,27 @@ inline WavData::WavData(File file, Filter filter)
 		pos += dataHeader->chunkSize;
 	}
 
+	format.length = dataHeader->chunkSize /
+	                ((format.bits / 8) * format.channels);
+	format.dataOffset = pos;
+	read<uint8_t>(raw, pos, size_t(format.length) * format.channels *
+	                        (format.bits / 8)); // check size
+	return format;
+}
+
+template<typename Filter>
+inline WavData::WavData(File file, Filter filter)
+{
+	auto raw = file.mmap();
+	auto format = parseFormat(raw);
+	freq = format.freq;
+	length = format.length;
+
 	// Read and convert sample data
-	length = dataHeader->chunkSize / ((bits / 8) * channels);
 	buffer.resize(length);
 	filter.setFreq(freq);
-	auto convertLoop = [&](const auto* in, auto convertFunc) {
-		for (unsigned i = 0; i < length; ++i) {
-			buffer[i] = filter(convertFunc(*in));
-			in += channels; // discard all but the first channel
-		}
-	};
-	if (bits == 8) {
-		convertLoop(read<uint8_t>(raw, pos, length * channels),
-		            [](uint8_t u8) { return (int16_t(u8) - 0x80) << 8; });
-	} else {
-		convertLoop(read<Endian::L16>(raw, pos, length * channels),
-		            [](Endian::L16 s16) { return int16_t(s16); });
+	for (unsigned i = 0; i < length; ++i) {
+		buffer[i] = filter(getRawSample(format, raw, i));
 	}
 }
 
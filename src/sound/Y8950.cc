@@ -14,6 +14,7 @@
 #include "outer.hh"
 #include "ranges.hh"
 #include "serialize.hh"
+#include "vla.hh"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
@@ -831,6 +832,12 @@ bool Y8950::checkMuteHelper()
 	return adpcm.isMuted();
 }
 
+bool Y8950::staysSilent()
+{
+	// FM slots and ADPCM only start again via a register write
+	return checkMuteHelper();
+}
+
 void Y8950::generateChannels(float** bufs, unsigned num)
 {
 	// TODO implement per-channel mute (instead of all-or-nothing)
@@ -844,6 +851,14 @@ void Y8950::generateChannels(float** bufs, unsigned num)
 		return;
 	}
 
+	// First calculate the LFO and noise values for the whole block, those
+	// are shared by all channels. Then calculate the channels one after
+	// the other, that keeps the inner loops small.
+	VLA(int, lfoAm, num);
+	VLA(int, lfoPm, num);
+	VLA(int, whiteNoise, num);
+	VLA(int, noiseA, num);
+	VLA(int, noiseB, num);
 	for (unsigned sample = 0; sample < num; ++sample) {
 		// Amplitude modulation: 27 output levels (triangle waveform);
 		// 1 level takes one of: 192, 256 or 448 samples
@@ -852,44 +867,58 @@ void Y8950::generateChannels(float** bufs, unsigned num)
 		++am_phase;
 		if (am_phase == (LFO_AM_TAB_ELEMENTS * 64)) am_phase = 0;
 		unsigned tmp = lfo_am_table[am_phase / 64];
-		int lfo_am = am_mode ? tmp : tmp / 4;
+		lfoAm[sample] = am_mode ? tmp : tmp / 4;
 
 		pm_phase = (pm_phase + PM_DPHASE) & (PM_DP_WIDTH - 1);
-		int lfo_pm = pm.table[pm_mode][pm_phase >> (PM_DP_BITS - PM_PG_BITS)];
+		lfoPm[sample] = pm.table[pm_mode][pm_phase >> (PM_DP_BITS - PM_PG_BITS)];
 
 		if (noise_seed & 1) {
 			noise_seed ^= 0x24000;
 		}
 		noise_seed >>= 1;
-		int whitenoise = noise_seed & 1 ? DB_POS(6) : DB_NEG(6);
+		whiteNoise[sample] = noise_seed & 1 ? DB_POS(6) : DB_NEG(6);
 
 		noiseA_phase += noiseA_dphase;
 		noiseA_phase &= (0x40 << 11) - 1;
 		if ((noiseA_phase >> 11) == 0x3f) {
 			noiseA_phase = 0;
 		}
-		int noiseA = noiseA_phase & (0x03 << 11) ? DB_POS(6) : DB_NEG(6);
+		noiseA[sample] = noiseA_phase & (0x03 << 11) ? DB_POS(6) : DB_NEG(6);
 
 		noiseB_phase += noiseB_dphase;
 		noiseB_phase &= (0x10 << 11) - 1;
-		int noiseB = noiseB_phase & (0x0A << 11) ? DB_POS(6) : DB_NEG(6);
-
-		int m = rythm_mode ? 6 : 9;
-		for (int i = 0; i < m; ++i) {
-			if (ch[i].slot[CAR].isActive()) {
-				bufs[i][sample] += ch[i].alg
-					? ch[i].slot[CAR].calc_slot_car(lfo_pm, lfo_am, 0) +
-					       ch[i].slot[MOD].calc_slot_mod(lfo_pm, lfo_am)
-					: ch[i].slot[CAR].calc_slot_car(lfo_pm, lfo_am,
-					       ch[i].slot[MOD].calc_slot_mod(lfo_pm, lfo_am));
-			} else {
-				//bufs[i][sample] += 0;
-			}
+		noiseB[sample] = noiseB_phase & (0x0A << 11) ? DB_POS(6) : DB_NEG(6);
+	}
+
+	// A slot that isn't active only becomes active again via a register
+	// write, so such a channel stays silent for the whole block.
+	int m = rythm_mode ? 6 : 9;
+	for (int i = 0; i < 9; ++i) {
+		auto& car = ch[i].slot[CAR];
+		auto& mod = ch[i].slot[MOD];
+		if ((i >= m) || !car.isActive()) {
+			bufs[i] = nullptr;
+			continue;
 		}
-		if (rythm_mode) {
-			//bufs[6][sample] += 0;
-			//bufs[7][sample] += 0;
-			//bufs[8][sample] += 0;
+		auto* buf = bufs[i];
+		for (unsigned sample = 0; sample < num; ++sample) {
+			if (!car.isActive()) break;
+			int lfo_pm = lfoPm[sample];
+			int lfo_am = lfoAm[sample];
+			buf[sample] += ch[i].alg
+				? car.calc_slot_car(lfo_pm, lfo_am, 0) +
+				       mod.calc_slot_mod(lfo_pm, lfo_am)
+				: car.calc_slot_car(lfo_pm, lfo_am,
+				       mod.calc_slot_mod(lfo_pm, lfo_am));
+		}
+	}
+
+	if (rythm_mode) {
+		for (unsigned sample = 0; sample < num; ++sample) {
+			int lfo_pm = lfoPm[sample];
+			int lfo_am = lfoAm[sample];
+			int a = noiseA[sample];
+			int b = noiseB[sample];
 
 			// TODO wasn't in original source either
 			ch[7].slot[MOD].calc_phase(lfo_pm);
@@ -900,26 +929,28 @@ void Y8950::generateChannels(float** bufs, unsigned num)
 						    ch[6].slot[MOD].calc_slot_mod(lfo_pm, lfo_am))
 				: 0;
 			bufs[10][sample] += (ch[7].slot[CAR].isActive())
-				? 2 * ch[7].slot[CAR].calc_slot_snare(lfo_pm, lfo_am, whitenoise)
+				? 2 * ch[7].slot[CAR].calc_slot_snare(lfo_pm, lfo_am, whiteNoise[sample])
 				: 0;
 			bufs[11][sample] += (ch[8].slot[CAR].isActive())
-				? 2 * ch[8].slot[CAR].calc_slot_cym(lfo_am, noiseA, noiseB)
+				? 2 * ch[8].slot[CAR].calc_slot_cym(lfo_am, a, b)
 				: 0;
 			bufs[12][sample] += (ch[7].slot[MOD].isActive())
-				? 2 * ch[7].slot[MOD].calc_slot_hat(lfo_am, noiseA, noiseB, whitenoise)
+				? 2 * ch[7].slot[MOD].calc_slot_hat(lfo_am, a, b, whiteNoise[sample])
 				: 0;
 			bufs[13][sample] += (ch[8].slot[MOD].isActive())
 				? 2 * ch[8].slot[MOD].calc_slot_tom(lfo_pm, lfo_am)
 				: 0;
-		} else {
-			//bufs[ 9] += 0;
-			//bufs[10] += 0;
-			//bufs[11] += 0;
-			//bufs[12] += 0;
-			//bufs[13] += 0;
 		}
+	} else {
+		for (int i = 9; i < 14; ++i) {
+			bufs[i] = nullptr;
+		}
+	}
 
-		bufs[14][sample] += adpcm.calcSample();
+	if (adpcm.isMuted()) {
+		bufs[14] = nullptr;
+	} else {
+		adpcm.calcSamples(bufs[14], num);
 	}
 }
 
@@ -936,12 +967,13 @@ void Y8950::writeReg(byte rg, byte data, EmuTime::param time)
 		-1, -1, -1, -1, -1, -1, -1, -1
 	};
 
-	// TODO only for registers that influence sound
-	// TODO also ADPCM
-	//if (rg >= 0x20) {
+	// The timer, keyboard and I/O registers don't influence the sound.
+	// Music replayers typically write the timer registers on every
+	// interrupt, so it's worth skipping those.
+	if (!(((0x02 <= rg) && (rg <= 0x06)) || (rg == 0x18) || (rg == 0x19))) {
 		// update the output buffer before changing the register
 		updateStream(time);
-	//}
+	}
 
 	switch (rg & 0xe0) {
 	case 0x00: {
@@ -1172,7 +1204,7 @@ void Y8950::writeReg(byte rg, byte data, EmuTime::param time)
 
 byte Y8950::readReg(byte rg, EmuTime::param time)
 {
-	updateStream(time); // TODO only when necessary
+	// no need to call updateStream(time)
 
 	byte result;
 	switch (rg) {
@@ -76,6 +76,7 @@ private:
 	// SoundDevice
 	float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	bool staysSilent() override;
 
 	inline void keyOn_BD();
 	inline void keyOn_SD();
@@ -15,6 +15,7 @@
 #include "MSXMotherBoard.hh"
 #include "Math.hh"
 #include "serialize.hh"
+#include <algorithm>
 
 namespace openmsx {
 
@@ -106,9 +107,7 @@ void Y8950Adpcm::sync(EmuTime::param time)
 {
 	if (isPlaying()) { // optimization, also correct without this test
 		unsigned ticks = clock.getTicksTill(time);
-		for (unsigned i = 0; isPlaying() && (i < ticks); ++i) {
-			calcSample(true); // ignore result
-		}
+		calcSamples(true, nullptr, ticks);
 	}
 	clock.advance(time);
 }
@@ -299,7 +298,7 @@ void Y8950Adpcm::writeData(byte data)
 
 byte Y8950Adpcm::readReg(byte rg, EmuTime::param time)
 {
-	sync(time); // TODO only when needed
+	if (dependsOnPlayback(rg)) sync(time);
 	byte result = (rg == 0x0F)
 	            ? readData()   // ADPCM-DATA
 	            : peekReg(rg); // other
@@ -308,10 +307,19 @@ byte Y8950Adpcm::readReg(byte rg, EmuTime::param time)
 
 byte Y8950Adpcm::peekReg(byte rg, EmuTime::param time) const
 {
-	const_cast<Y8950Adpcm*>(this)->sync(time); // TODO only when needed
+	if (dependsOnPlayback(rg)) {
+		const_cast<Y8950Adpcm*>(this)->sync(time);
+	}
 	return peekReg(rg);
 }
 
+bool Y8950Adpcm::dependsOnPlayback(byte rg)
+{
+	// these are the only registers for which peekReg() doesn't return a
+	// constant
+	return (rg == 0x0F) || (rg == 0x13) || (rg == 0x14);
+}
+
 byte Y8950Adpcm::peekReg(byte rg) const
 {
 	switch (rg) {
@@ -427,12 +435,47 @@ byte Y8950Adpcm::readMemory(unsigned memPntr) const
 	}
 }
 
-int Y8950Adpcm::calcSample()
+void Y8950Adpcm::calcSamples(float* buf, unsigned num)
 {
 	// called by audio thread
-	if (!isPlaying()) return 0;
-	int output = calcSample(false);
-	return (reg7 & R07_SP_OFF) ? 0 : output;
+	assert(!isMuted());
+	calcSamples(false, buf, num);
+}
+
+// Calculate the next 'num' samples, when 'buf' isn't nullptr they're added
+// to it. A new nibble is only decoded once every 1/delta samples, in between
+// the output changes linearly. So only the samples where a new nibble starts
+// need the full calcSample() routine, the others are handled in a tight loop.
+void Y8950Adpcm::calcSamples(bool doEmu, float* buf, unsigned num)
+{
+	PlayData& pd = doEmu ? emu : aud;
+	unsigned i = 0;
+	while ((i < num) && isPlaying()) {
+		// Number of samples before the next nibble: those for which
+		// 'nowStep + delta' doesn't overflow STEP_MASK.
+		unsigned plain = num - i;
+		if (pd.nowStep > unsigned(STEP_MASK)) {
+			plain = 0;
+		} else if (delta != 0) {
+			plain = std::min(plain, (STEP_MASK - pd.nowStep) / delta);
+		}
+		if (buf) {
+			for (unsigned j = 0; j < plain; ++j) {
+				pd.output += pd.sampleStep;
+				buf[i + j] += pd.output >> 12;
+			}
+		} else {
+			pd.output = int(unsigned(pd.output) +
+			                plain * unsigned(pd.sampleStep));
+		}
+		pd.nowStep += plain * delta;
+		i += plain;
+		if (i == num) break;
+
+		int output = calcSample(doEmu);
+		if (buf) buf[i] += output;
+		++i;
+	}
 }
 
 int Y8950Adpcm::calcSample(bool doEmu)
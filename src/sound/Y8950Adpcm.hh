@@ -24,7 +24,8 @@ public:
 	void writeReg(byte rg, byte data, EmuTime::param time);
 	byte readReg(byte rg, EmuTime::param time);
 	byte peekReg(byte rg, EmuTime::param time) const;
-	int calcSample();
+	/** Add the next 'num' samples to 'buf'. Only allowed when !isMuted(). */
+	void calcSamples(float* buf, unsigned num);
 	void sync(EmuTime::param time);
 	void resetStatus();
 
@@ -53,10 +54,12 @@ private:
 	bool isPlaying() const;
 	void writeData(byte data);
 	byte peekReg(byte rg) const;
+	static bool dependsOnPlayback(byte rg);
 	byte readData();
 	byte peekData() const;
 	void writeMemory(unsigned memPntr, byte value);
 	byte readMemory(unsigned memPntr) const;
+	void calcSamples(bool doEmu, float* buf, unsigned num);
 	int calcSample(bool doEmu);
 
 	Y8950& y8950;
@@ -10,6 +10,7 @@
 #include "cstd.hh"
 #include "ranges.hh"
 #include "serialize.hh"
+#include "vla.hh"
 #include <cmath>
 #include <cstring>
 
@@ -933,7 +934,7 @@ unsigned YM2151::volumeCalc(YM2151Operator* OP, unsigned AM)
 	return OP->tl + unsigned(OP->volume) + (AM & OP->AMmask);
 }
 
-void YM2151::chanCalc(unsigned chan)
+void YM2151::chanCalc(unsigned chan, unsigned am)
 {
 	m2 = c1 = c2 = mem = 0;
 	YM2151Operator* op = &oper[chan*4]; // M1
@@ -941,7 +942,7 @@ void YM2151::chanCalc(unsigned chan)
 
 	unsigned AM = 0;
 	if (op->ams) {
-		AM = lfa << (op->ams-1);
+		AM = am << (op->ams-1);
 	}
 	unsigned env = volumeCalc(op, AM);
 	{
@@ -979,7 +980,7 @@ void YM2151::chanCalc(unsigned chan)
 	op->mem_value = mem;
 }
 
-void YM2151::chan7Calc()
+void YM2151::chan7Calc(unsigned am, unsigned noiseRng)
 {
 	m2 = c1 = c2 = mem = 0;
 	YM2151Operator* op = &oper[7 * 4]; // M1
@@ -988,7 +989,7 @@ void YM2151::chan7Calc()
 
 	unsigned AM = 0;
 	if (op->ams) {
-		AM = lfa << (op->ams - 1);
+		AM = am << (op->ams - 1);
 	}
 	unsigned env = volumeCalc(op, AM);
 	{
@@ -1025,7 +1026,7 @@ void YM2151::chan7Calc()
 		if (env < 0x3ff) {
 			noiseout = (env ^ 0x3ff) * 2; // range of the YM2151 noise output is -2044 to 2040
 		}
-		chanout[7] += (noise_rng & 0x10000) ? noiseout : unsigned(-int(noiseout)); // bit 16 -> output
+		chanout[7] += (noiseRng & 0x10000) ? noiseout : unsigned(-int(noiseout)); // bit 16 -> output
 	} else {
 		if (env < ENV_QUIET) {
 			chanout[7] += opCalc(op + 3, env, c2);
@@ -1250,52 +1251,57 @@ void YM2151::advanceEG()
 
 	// envelope generator
 	for (auto& op : oper) {
-		switch (op.state) {
-		case EG_ATT: // attack phase
-			if (!(eg_cnt & ((1 << op.eg_sh_ar) - 1))) {
-				op.volume += (~op.volume *
-						(eg_inc[op.eg_sel_ar + ((eg_cnt >> op.eg_sh_ar) & 7)])
-					      ) >> 4;
-				if (op.volume <= MIN_ATT_INDEX) {
-					op.volume = MIN_ATT_INDEX;
-					op.state = EG_DEC;
-				}
+		advanceEG(&op, eg_cnt);
+	}
+}
+
+void YM2151::advanceEG(YM2151Operator* op, unsigned egCnt)
+{
+	switch (op->state) {
+	case EG_ATT: // attack phase
+		if (!(egCnt & ((1 << op->eg_sh_ar) - 1))) {
+			op->volume += (~op->volume *
+					(eg_inc[op->eg_sel_ar + ((egCnt >> op->eg_sh_ar) & 7)])
+				      ) >> 4;
+			if (op->volume <= MIN_ATT_INDEX) {
+				op->volume = MIN_ATT_INDEX;
+				op->state = EG_DEC;
 			}
-			break;
+		}
+		break;
 
-		case EG_DEC: // decay phase
-			if (!(eg_cnt & ((1 << op.eg_sh_d1r) - 1))) {
-				op.volume += eg_inc[op.eg_sel_d1r + ((eg_cnt >> op.eg_sh_d1r) & 7)];
-				if (unsigned(op.volume) >= op.d1l) {
-					op.state = EG_SUS;
-				}
+	case EG_DEC: // decay phase
+		if (!(egCnt & ((1 << op->eg_sh_d1r) - 1))) {
+			op->volume += eg_inc[op->eg_sel_d1r + ((egCnt >> op->eg_sh_d1r) & 7)];
+			if (unsigned(op->volume) >= op->d1l) {
+				op->state = EG_SUS;
 			}
-			break;
+		}
+		break;
 
-		case EG_SUS: // sustain phase
-			if (!(eg_cnt & ((1 << op.eg_sh_d2r) - 1))) {
-				op.volume += eg_inc[op.eg_sel_d2r + ((eg_cnt >> op.eg_sh_d2r) & 7)];
-				if (op.volume >= MAX_ATT_INDEX) {
-					op.volume = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+	case EG_SUS: // sustain phase
+		if (!(egCnt & ((1 << op->eg_sh_d2r) - 1))) {
+			op->volume += eg_inc[op->eg_sel_d2r + ((egCnt >> op->eg_sh_d2r) & 7)];
+			if (op->volume >= MAX_ATT_INDEX) {
+				op->volume = MAX_ATT_INDEX;
+				op->state = EG_OFF;
 			}
-			break;
+		}
+		break;
 
-		case EG_REL: // release phase
-			if (!(eg_cnt & ((1 << op.eg_sh_rr) - 1))) {
-				op.volume += eg_inc[op.eg_sel_rr + ((eg_cnt >> op.eg_sh_rr) & 7)];
-				if (op.volume >= MAX_ATT_INDEX) {
-					op.volume = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+	case EG_REL: // release phase
+		if (!(egCnt & ((1 << op->eg_sh_rr) - 1))) {
+			op->volume += eg_inc[op->eg_sel_rr + ((egCnt >> op->eg_sh_rr) & 7)];
+			if (op->volume >= MAX_ATT_INDEX) {
+				op->volume = MAX_ATT_INDEX;
+				op->state = EG_OFF;
 			}
-			break;
 		}
+		break;
 	}
 }
 
-void YM2151::advance()
+void YM2151::advanceLFO()
 {
 	// LFO
 	if (test & 2) {
@@ -1387,40 +1393,44 @@ void YM2151::advance()
 		unsigned j = ((noise_rng ^ (noise_rng >> 3)) & 1) ^ 1;
 		noise_rng = (j << 16) | (noise_rng >> 1);
 	}
+}
 
-	// phase generator
-	YM2151Operator* op = &oper[0]; // CH 0 M1
-	i = 8;
-	do {
-		// only when phase modulation from LFO is enabled for this channel
-		if (op->pms) {
-			int mod_ind = lfp; // -128..+127 (8bits signed)
-			if (op->pms < 6) {
-				mod_ind >>= (6 - op->pms);
-			} else {
-				mod_ind <<= (op->pms - 5);
-			}
-			if (mod_ind) {
-				unsigned kc_channel = op->kc_i + mod_ind;
-				(op + 0)->phase += ((freq[kc_channel + (op + 0)->dt2] + (op + 0)->dt1) * (op + 0)->mul) >> 1;
-				(op + 1)->phase += ((freq[kc_channel + (op + 1)->dt2] + (op + 1)->dt1) * (op + 1)->mul) >> 1;
-				(op + 2)->phase += ((freq[kc_channel + (op + 2)->dt2] + (op + 2)->dt1) * (op + 2)->mul) >> 1;
-				(op + 3)->phase += ((freq[kc_channel + (op + 3)->dt2] + (op + 3)->dt1) * (op + 3)->mul) >> 1;
-			} else { // phase modulation from LFO is equal to zero
-				(op + 0)->phase += (op + 0)->freq;
-				(op + 1)->phase += (op + 1)->freq;
-				(op + 2)->phase += (op + 2)->freq;
-				(op + 3)->phase += (op + 3)->freq;
-			}
-		} else { // phase modulation from LFO is disabled
-			(op + 0)->phase += (op + 0)->freq;
-			(op + 1)->phase += (op + 1)->freq;
-			(op + 2)->phase += (op + 2)->freq;
-			(op + 3)->phase += (op + 3)->freq;
+// phase generator of the 4 operators of one channel
+void YM2151::advancePhase(YM2151Operator* op, int pm)
+{
+	// only when phase modulation from LFO is enabled for this channel
+	if (op->pms) {
+		int mod_ind = pm; // -128..+127 (8bits signed)
+		if (op->pms < 6) {
+			mod_ind >>= (6 - op->pms);
+		} else {
+			mod_ind <<= (op->pms - 5);
+		}
+		if (mod_ind) {
+			unsigned kc_channel = op->kc_i + mod_ind;
+			(op + 0)->phase += ((freq[kc_channel + (op + 0)->dt2] + (op + 0)->dt1) * (op + 0)->mul) >> 1;
+			(op + 1)->phase += ((freq[kc_channel + (op + 1)->dt2] + (op + 1)->dt1) * (op + 1)->mul) >> 1;
+			(op + 2)->phase += ((freq[kc_channel + (op + 2)->dt2] + (op + 2)->dt1) * (op + 2)->mul) >> 1;
+			(op + 3)->phase += ((freq[kc_channel + (op + 3)->dt2] + (op + 3)->dt1) * (op + 3)->mul) >> 1;
+			return;
 		}
-		op += 4;
-		i--;
-	} while (i);
+		// phase modulation from LFO is equal to zero
+	}
+	// phase modulation from LFO is disabled (or zero)
+	(op + 0)->phase += (op + 0)->freq;
+	(op + 1)->phase += (op + 1)->freq;
+	(op + 2)->phase += (op + 2)->freq;
+	(op + 3)->phase += (op + 3)->freq;
+}
+
+void YM2151::advance()
+{
+	advanceLFO();
+
+	// phase generator
+	for (int chan = 0; chan < 8; ++chan) {
+		advancePhase(&oper[4 * chan], lfp);
+	}
 
 	// CSM is calculated *after* the phase generator calculations (verified
 	// on real chip)
@@ -1432,27 +1442,36 @@ void YM2151::advance()
 	// the sound played is the same as after normal KEY ON.
 	if (csm_req) { // CSM KEYON/KEYOFF seqeunce request
 		if (csm_req == 2) { // KEY ON
-			op = &oper[0]; // CH 0 M1
-			i = 32;
-			do {
-				keyOn(op, 2);
-				op++;
-				i--;
-			} while (i);
+			for (auto& op : oper) {
+				keyOn(&op, 2);
+			}
 			csm_req = 1;
 		} else { // KEY OFF
-			op = &oper[0]; // CH 0 M1
-			i = 32;
-			do {
-				keyOff(op,unsigned(~2));
-				op++;
-				i--;
-			} while (i);
+			for (auto& op : oper) {
+				keyOff(&op, unsigned(~2));
+			}
 			csm_req = 0;
 		}
 	}
 }
 
+bool YM2151::staysSilent()
+{
+	// In CSM mode, timer A can key-on all slots without a register write.
+	return checkMuteHelper() && !(irq_enable & 0x80) && !csm_req;
+}
+
+bool YM2151::isIdle(unsigned chan) const
+{
+	// All operators are off (so their output is zero till the next key-on)
+	// and there's no feedback or delayed (MEM) sample left.
+	const YM2151Operator* op = &oper[4 * chan];
+	return (op[0].state == EG_OFF) && (op[1].state == EG_OFF) &&
+	       (op[2].state == EG_OFF) && (op[3].state == EG_OFF) &&
+	       (op->fb_out_prev == 0) && (op->fb_out_curr == 0) &&
+	       (op->mem_value == 0);
+}
+
 void YM2151::generateChannels(float** bufs, unsigned num)
 {
 	if (checkMuteHelper()) {
@@ -1463,21 +1482,75 @@ void YM2151::generateChannels(float** bufs, unsigned num)
 		return;
 	}
 
-	for (unsigned i = 0; i < num; ++i) {
-		advanceEG();
+	if (csm_req) {
+		// A CSM key-on/off changes all operators in the middle of this
+		// block, so calculate all channels together, sample per sample.
+		for (unsigned i = 0; i < num; ++i) {
+			advanceEG();
 
-		for (int j = 0; j < 8-1; ++j) {
-			chanout[j] = 0;
-			chanCalc(j);
+			for (int j = 0; j < 8-1; ++j) {
+				chanout[j] = 0;
+				chanCalc(j, lfa);
+			}
+			chanout[7] = 0;
+			chan7Calc(lfa, noise_rng); // special case for channel 7
+
+			for (int j = 0; j < 8; ++j) {
+				bufs[j][2 * i + 0] += int(chanout[j] & pan[2 * j + 0]);
+				bufs[j][2 * i + 1] += int(chanout[j] & pan[2 * j + 1]);
+			}
+			advance();
+		}
+		return;
+	}
+
+	// Otherwise the channels are independent: only the envelope timer,
+	// the LFO and the noise generator are shared, so first calculate
+	// those for the whole block and then each channel on its own.
+	VLA(bool,     egTick, num); // does the envelope generator run?
+	VLA(unsigned, egCnt,  num);
+	VLA(unsigned, lfaBuf, num); // AM for chanCalc()
+	VLA(int,      lfpBuf, num); // PM for the (following) phase update
+	VLA(unsigned, noiseBuf, num);
+	for (unsigned i = 0; i < num; ++i) {
+		egTick[i] = eg_timer++ == 3; // see advanceEG()
+		if (egTick[i]) {
+			eg_timer = 0;
+			eg_cnt++;
 		}
-		chanout[7] = 0;
-		chan7Calc(); // special case for channel 7
+		egCnt[i] = eg_cnt;
+		lfaBuf[i] = lfa;
+		noiseBuf[i] = noise_rng;
+		advanceLFO();
+		lfpBuf[i] = lfp;
+	}
 
-		for (int j = 0; j < 8; ++j) {
+	for (int j = 0; j < 8; ++j) {
+		YM2151Operator* op = &oper[4 * j];
+		if (isIdle(j)) {
+			// The envelopes stay off, only the phases still change.
+			bufs[j] = nullptr;
+			for (unsigned i = 0; i < num; ++i) {
+				advancePhase(op, lfpBuf[i]);
+			}
+			continue;
+		}
+		for (unsigned i = 0; i < num; ++i) {
+			if (egTick[i]) {
+				for (int k = 0; k < 4; ++k) {
+					advanceEG(op + k, egCnt[i]);
+				}
+			}
+			chanout[j] = 0;
+			if (j != 7) {
+				chanCalc(j, lfaBuf[i]);
+			} else {
+				chan7Calc(lfaBuf[i], noiseBuf[i]);
+			}
 			bufs[j][2 * i + 0] += int(chanout[j] & pan[2 * j + 0]);
 			bufs[j][2 * i + 1] += int(chanout[j] & pan[2 * j + 1]);
+			advancePhase(op, lfpBuf[i]);
 		}
-		advance();
 	}
 }
 
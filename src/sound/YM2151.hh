@@ -119,6 +119,7 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	bool staysSilent() override;
 
 	void callback(byte flag) override;
 	void setStatus(byte flags);
@@ -137,10 +138,14 @@ private:
 	inline void keyOff(YM2151Operator* op, unsigned keyClear);
 
 	// general chip mehods
-	void chanCalc(unsigned chan);
-	void chan7Calc();
+	void chanCalc(unsigned chan, unsigned am);
+	void chan7Calc(unsigned am, unsigned noiseRng);
+	bool isIdle(unsigned chan) const;
 
 	void advanceEG();
+	inline void advanceEG(YM2151Operator* op, unsigned egCnt);
+	void advanceLFO();
+	inline void advancePhase(YM2151Operator* op, int pm);
 	void advance();
 
 	bool checkMuteHelper();
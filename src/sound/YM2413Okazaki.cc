@@ -11,10 +11,16 @@
 #include "ranges.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
+#include "vla.hh"
+#include <algorithm>
 #include <cstring>
 #include <cassert>
 #include <iostream>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace openmsx {
 namespace YM2413Okazaki {
 
@@ -929,6 +935,39 @@ ALWAYS_INLINE unsigned Slot::calc_phase(unsigned lfo_pm)
 	return cphase >> DP_BASE_BITS;
 }
 
+// Phases for the next 'num' samples (at once). Only allowed when the phase
+// counter doesn't get reset during those samples (so not in SETTLE state).
+template<bool HAS_PM>
+void Slot::calc_phases(const byte* lfo_pm, unsigned* out, unsigned num)
+{
+	if (HAS_PM) {
+		unsigned p = cphase;
+		for (unsigned i = 0; i < num; ++i) {
+			p += dphase[lfo_pm[i]];
+			out[i] = p >> DP_BASE_BITS;
+		}
+		cphase = p;
+	} else {
+		unsigned c = cphase;
+		unsigned d = dphase[0];
+#ifdef __SSE2__
+		// 4 samples at a time, can calculate upto 3 values too many.
+		auto p    = _mm_setr_epi32(c + d, c + 2 * d, c + 3 * d, c + 4 * d);
+		auto step = _mm_set1_epi32(4 * d);
+		for (unsigned i = 0; i < num; i += 4) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+			                 _mm_srli_epi32(p, DP_BASE_BITS));
+			p = _mm_add_epi32(p, step);
+		}
+#else
+		for (unsigned i = 0; i < num; ++i) {
+			out[i] = (c + (i + 1) * d) >> DP_BASE_BITS;
+		}
+#endif
+		cphase = c + num * d;
+	}
+}
+
 // EG
 void Slot::calc_envelope_outline(unsigned& out)
 {
@@ -1002,6 +1041,38 @@ template <bool HAS_AM> unsigned Slot::calc_fixed_env() const
 	return out;
 }
 
+// Envelope for the next 'num' samples (at once). Only allowed when this
+// doesn't end in a SETTLE->ATTACK transition.
+template<bool HAS_AM, bool FIXED_ENV>
+void Slot::calc_envelopes(const int* lfo_am, unsigned* out, unsigned num)
+{
+	assert(state != SETTLE);
+	if (FIXED_ENV) {
+		unsigned fixed_env = calc_fixed_env<HAS_AM>();
+		if (HAS_AM) {
+#ifdef __SSE2__
+			// 4 samples at a time, can calculate upto 3 values too many.
+			auto env   = _mm_set1_epi32(fixed_env);
+			auto three = _mm_set1_epi32(3);
+			for (unsigned i = 0; i < num; i += 4) {
+				auto am = _mm_loadu_si128(
+					reinterpret_cast<const __m128i*>(lfo_am + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+					_mm_or_si128(_mm_add_epi32(env, am), three));
+			}
+			return;
+#endif
+		}
+		for (unsigned i = 0; i < num; ++i) {
+			out[i] = calc_envelope<HAS_AM, true>(lfo_am[i], fixed_env);
+		}
+	} else {
+		for (unsigned i = 0; i < num; ++i) {
+			out[i] = calc_envelope<HAS_AM, false>(lfo_am[i], 0);
+		}
+	}
+}
+
 // CARRIER
 template<bool HAS_AM, bool FIXED_ENV>
 ALWAYS_INLINE int Slot::calc_slot_car(unsigned lfo_pm, int lfo_am, int fm, unsigned fixed_env)
@@ -1152,10 +1223,133 @@ ALWAYS_INLINE void YM2413::calcChannel(Channel& ch, float* buf, unsigned num)
 	} while (sample < num);
 }
 
+static void calcSlotPhases(Slot& slot, const byte* lfo_pm, unsigned* out, unsigned num)
+{
+	if (slot.patch.AMPM & 1) {
+		slot.calc_phases<true >(lfo_pm, out, num);
+	} else {
+		slot.calc_phases<false>(lfo_pm, out, num);
+	}
+}
+
+static void calcSlotEnvelopes(Slot& slot, bool fixedEnv, const int* lfo_am,
+                              unsigned* out, unsigned num)
+{
+	switch (((slot.patch.AMPM & 2) ? 1 : 0) | (fixedEnv ? 2 : 0)) {
+	case 0: slot.calc_envelopes<false, false>(lfo_am, out, num); break;
+	case 1: slot.calc_envelopes<true,  false>(lfo_am, out, num); break;
+	case 2: slot.calc_envelopes<false, true >(lfo_am, out, num); break;
+	case 3: slot.calc_envelopes<true,  true >(lfo_am, out, num); break;
+	default: UNREACHABLE;
+	}
+}
+
+// Calculate a number of (melodic) channels together, in blocks of samples.
+// Per channel, first the phases and envelopes of both slots are calculated
+// for the whole block. What remains are table lookups. For the carrier these
+// are independent of each other, but for the modulator (with feedback) each
+// sample depends on the previous one. To hide the latency of that chain, the
+// modulators of all channels are calculated interleaved.
+// Gives exactly the same result as calcChannel(), but requires that the phase
+// counters don't get reset halfway (so the carriers can't be in SETTLE state).
+void YM2413::calcChannels(const unsigned* chans, const bool* carFixedEnv,
+                          const bool* modFixedEnv, unsigned numChans,
+                          float** bufs, unsigned num,
+                          const byte* lfoPm, const int* lfoAm)
+{
+	static const unsigned BLOCK = 64; // must be a multiple of 4
+	struct Temp {
+		unsigned modPhase[BLOCK];
+		unsigned modEnv[BLOCK];
+		unsigned carPhase[BLOCK];
+		unsigned carEnv[BLOCK];
+		int fm[BLOCK];
+	} temp[9];
+	// modulator state, as local copies
+	const unsigned* modWF[9];
+	int modFeedback[9], modOutput[9];
+	unsigned modFB[9], fbMask[9];
+	for (unsigned c = 0; c < numChans; ++c) {
+		Slot& mod = channels[chans[c]].mod;
+		modWF[c] = mod.patch.WF;
+		modFeedback[c] = mod.feedback;
+		modOutput[c] = mod.output;
+		modFB[c] = mod.patch.FB;
+		fbMask[c] = mod.patch.FB ? ~0u : 0u;
+	}
+
+	for (unsigned pos = 0; pos < num; pos += BLOCK) {
+		unsigned n = std::min(BLOCK, num - pos);
+		for (unsigned c = 0; c < numChans; ++c) {
+			Channel& ch = channels[chans[c]];
+			assert(ch.car.state != SETTLE);
+			Temp& t = temp[c];
+			calcSlotPhases(ch.mod, lfoPm + pos, t.modPhase, n);
+			calcSlotPhases(ch.car, lfoPm + pos, t.carPhase, n);
+			calcSlotEnvelopes(ch.mod, modFixedEnv[c], lfoAm + pos, t.modEnv, n);
+			calcSlotEnvelopes(ch.car, carFixedEnv[c], lfoAm + pos, t.carEnv, n);
+		}
+		// see calc_slot_mod()
+		for (unsigned i = 0; i < n; ++i) {
+			for (unsigned c = 0; c < numChans; ++c) {
+				Temp& t = temp[c];
+				unsigned phase = t.modPhase[i] +
+					((wave2_8pi(modFeedback[c]) >> modFB[c]) & fbMask[c]);
+				int newOutput = dB2Lin.tab[modWF[c][phase & PG_MASK] + t.modEnv[i]];
+				modFeedback[c] = (modOutput[c] + newOutput) >> 1;
+				modOutput[c] = newOutput;
+				t.fm[i] = modFeedback[c];
+			}
+		}
+		// see calc_slot_car()
+		for (unsigned c = 0; c < numChans; ++c) {
+			Slot& car = channels[chans[c]].car;
+			Temp& t = temp[c];
+			const unsigned* wf = car.patch.WF;
+			int output = car.output;
+			float* buf = bufs[chans[c]] + pos;
+			for (unsigned i = 0; i < n; ++i) {
+				unsigned phase = t.carPhase[i] + wave2_8pi(t.fm[i]);
+				int newOutput = dB2Lin.tab[wf[phase & PG_MASK] + t.carEnv[i]];
+				output = (output + newOutput) >> 1;
+				buf[i] += output;
+			}
+			car.output = output;
+		}
+	}
+	for (unsigned c = 0; c < numChans; ++c) {
+		Slot& mod = channels[chans[c]].mod;
+		mod.feedback = modFeedback[c];
+		mod.output = modOutput[c];
+	}
+}
+
 void YM2413::generateChannels(float* bufs[9 + 5], unsigned num)
 {
 	assert(num != 0);
 
+	// The LFO values are the same for all channels that use the block
+	// routine, calculate them only once (see calcChannel()).
+	VLA(byte, lfoPm, num);
+	VLA(int,  lfoAm, num + 3); // +3 for calc_envelopes()
+	unsigned tmp_pm_phase = pm_phase;
+	unsigned tmp_am_phase = am_phase;
+	for (unsigned sample = 0; sample < num; ++sample) {
+		++tmp_pm_phase;
+		lfoPm[sample] = (tmp_pm_phase >> 10) & 7;
+		++tmp_am_phase;
+		if (tmp_am_phase == (LFO_AM_TAB_ELEMENTS * 64)) {
+			tmp_am_phase = 0;
+		}
+		lfoAm[sample] = lfo_am_table[tmp_am_phase / 64];
+	}
+	lfoAm[num + 0] = lfoAm[num + 1] = lfoAm[num + 2] = 0;
+
+	unsigned blockChans[9];
+	bool blockCarFixedEnv[9];
+	bool blockModFixedEnv[9];
+	unsigned numBlockChans = 0;
+
 	unsigned m = isRhythm() ? 6 : 9;
 	for (unsigned i = 0; i < m; ++i) {
 		Channel& ch = channels[i];
@@ -1169,6 +1363,14 @@ void YM2413::generateChannels(float* bufs[9 + 5], unsigned num)
 			                   (ch.mod.state == FINISH);
 			if (ch.car.state == SETTLE) {
 				modFixedEnv = false;
+			} else {
+				// No phase reset halfway, so we can use the
+				// (faster) block routine, see below.
+				blockChans[numBlockChans] = i;
+				blockCarFixedEnv[numBlockChans] = carFixedEnv;
+				blockModFixedEnv[numBlockChans] = modFixedEnv;
+				++numBlockChans;
+				continue;
 			}
 			unsigned flags = ( ch.car.patch.AMPM     << 0) |
 			                 ( ch.mod.patch.AMPM     << 2) |
@@ -1310,6 +1512,10 @@ void YM2413::generateChannels(float* bufs[9 + 5], unsigned num)
 			bufs[i] = nullptr;
 		}
 	}
+	if (numBlockChans) {
+		calcChannels(blockChans, blockCarFixedEnv, blockModFixedEnv,
+		             numBlockChans, bufs, num, lfoPm, lfoAm);
+	}
 	// update AM, PM unit
 	pm_phase += num;
 	am_phase = (am_phase + num) % (LFO_AM_TAB_ELEMENTS * 64);
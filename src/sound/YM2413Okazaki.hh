@@ -70,9 +70,13 @@ public:
 	inline void setVolume(unsigned value);
 
 	inline unsigned calc_phase(unsigned lfo_pm);
+	template<bool HAS_PM>
+	void calc_phases(const byte* lfo_pm, unsigned* out, unsigned num);
 	template <bool HAS_AM, bool FIXED_ENV>
 	inline unsigned calc_envelope(int lfo_am, unsigned fixed_env);
 	template <bool HAS_AM> unsigned calc_fixed_env() const;
+	template<bool HAS_AM, bool FIXED_ENV>
+	void calc_envelopes(const int* lfo_am, unsigned* out, unsigned num);
 	void calc_envelope_outline(unsigned& out);
 	template<bool HAS_AM, bool FIXED_ENV>
 	inline int calc_slot_car(unsigned lfo_pm, int lfo_am, int fm, unsigned fixed_env);
@@ -153,6 +157,10 @@ public:
 
 	template <unsigned FLAGS>
 	inline void calcChannel(Channel& ch, float* buf, unsigned num);
+	void calcChannels(const unsigned* chans, const bool* carFixedEnv,
+	                  const bool* modFixedEnv, unsigned numChans,
+	                  float** bufs, unsigned num,
+	                  const byte* lfoPm, const int* lfoAm);
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
@@ -746,6 +746,18 @@ void YMF262::Channel::chan_calc_ext(unsigned lfo_am)
 	*car.connect += car.op_calc(car.Cnt.toInt() + phase_modulation, lfo_am);
 }
 
+// Both operators are off and there's no feedback left, so chan_calc() would
+// only add zeros to the output (and keep op1_out at zero). This only changes
+// by a key-on, so if it holds at the start of a block it holds for the whole
+// block.
+inline bool YMF262::Channel::isIdle() const
+{
+	auto& mod = slot[MOD];
+	auto& car = slot[CAR];
+	return (mod.state == EG_OFF) && (car.state == EG_OFF) &&
+	       (mod.op1_out[0] == 0) && (mod.op1_out[1] == 0);
+}
+
 // operators used in the rhythm sounds generation process:
 //
 // Envelope Generator:
@@ -1069,7 +1081,11 @@ void YMF262::writeReg(unsigned r, byte v, EmuTime::param time)
 }
 void YMF262::writeReg512(unsigned r, byte v, EmuTime::param time)
 {
-	updateStream(time); // TODO optimize only for regs that directly influence sound
+	if ((r < 0x02) || (0x04 < r)) {
+		// Timer registers don't influence the sound, all others
+		// (potentially) do.
+		updateStream(time);
+	}
 	writeRegDirect(r, v, time);
 }
 void YMF262::writeRegDirect(unsigned r, byte v, EmuTime::param time)
@@ -1553,6 +1569,12 @@ float YMF262::getAmplificationFactorImpl() const
 	return 1.0f / 4096.0f;
 }
 
+bool YMF262::staysSilent()
+{
+	// all slots stay off (or inaudible) until the next key-on
+	return checkMuteHelper();
+}
+
 void YMF262::generateChannels(float** bufs, unsigned num)
 {
 	// TODO implement per-channel mute (instead of all-or-nothing)
@@ -1567,6 +1589,29 @@ void YMF262::generateChannels(float** bufs, unsigned num)
 
 	bool rhythmEnabled = (rhythm & 0x20) != 0;
 
+	// Skip the channels that stay silent during this whole block. The two
+	// halves of a 4op channel can only be skipped together (the first half
+	// modulates the second). The rhythm channels are always calculated.
+	bool idle[18];
+	for (int i = 0; i < 18; ++i) {
+		idle[i] = channel[i].isIdle();
+	}
+	for (int k = 0; k <= 9; k += 9) {
+		for (int i = 0; i < 3; ++i) {
+			if (channel[k + i].extended) {
+				bool both = idle[k + i + 0] && idle[k + i + 3];
+				idle[k + i + 0] = both;
+				idle[k + i + 3] = both;
+			}
+		}
+	}
+	if (rhythmEnabled) {
+		idle[6] = idle[7] = idle[8] = false;
+	}
+	for (int i = 0; i < 18; ++i) {
+		if (idle[i]) bufs[i] = nullptr;
+	}
+
 	for (unsigned j = 0; j < num; ++j) {
 		// Amplitude modulation: 27 output levels (triangle waveform);
 		// 1 level takes one of: 192, 256 or 448 samples
@@ -1589,33 +1634,34 @@ void YMF262::generateChannels(float** bufs, unsigned num)
 				auto& ch0 = channel[k + i + 0];
 				auto& ch3 = channel[k + i + 3];
 				// extended 4op ch#0 part 1 or 2op ch#0
-				ch0.chan_calc(lfo_am);
+				if (!idle[k + i + 0]) ch0.chan_calc(lfo_am);
 				if (ch0.extended) {
 					// extended 4op ch#0 part 2
-					ch3.chan_calc_ext(lfo_am);
+					if (!idle[k + i + 3]) ch3.chan_calc_ext(lfo_am);
 				} else {
 					// standard 2op ch#3
-					ch3.chan_calc(lfo_am);
+					if (!idle[k + i + 3]) ch3.chan_calc(lfo_am);
 				}
 			}
 		}
 
 		// channels 6,7,8 rhythm or 2op mode
 		if (!rhythmEnabled) {
-			channel[6].chan_calc(lfo_am);
-			channel[7].chan_calc(lfo_am);
-			channel[8].chan_calc(lfo_am);
+			for (int i = 6; i < 9; ++i) {
+				if (!idle[i]) channel[i].chan_calc(lfo_am);
+			}
 		} else {
 			// Rhythm part
 			chan_calc_rhythm(lfo_am);
 		}
 
 		// channels 15,16,17 are fixed 2-operator channels only
-		channel[15].chan_calc(lfo_am);
-		channel[16].chan_calc(lfo_am);
-		channel[17].chan_calc(lfo_am);
+		for (int i = 15; i < 18; ++i) {
+			if (!idle[i]) channel[i].chan_calc(lfo_am);
+		}
 
 		for (int i = 0; i < 18; ++i) {
+			if (idle[i]) continue;
 			bufs[i][2 * j + 0] += int(chanout[i] & pan[4 * i + 0]);
 			bufs[i][2 * j + 1] += int(chanout[i] & pan[4 * i + 1]);
 			// unused c        += int(chanout[i] & pan[4 * i + 2]);
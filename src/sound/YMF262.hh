@@ -117,6 +117,7 @@ private:
 		Channel();
 		void chan_calc(unsigned lfo_am);
 		void chan_calc_ext(unsigned lfo_am);
+		inline bool isIdle() const;
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -144,6 +145,7 @@ private:
 	// SoundDevice
 	float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	bool staysSilent() override;
 
 	void callback(byte flag) override;
 
@@ -323,99 +323,99 @@ uint16_t YMF278::Slot::compute_am() const
 }
 
 
-void YMF278::advance()
+// Advance the envelope generator, the LFO and the TL interpolation of this
+// slot by one sample. 'eg_cnt' is the (already incremented) value of the
+// global envelope generator counter for that sample.
+void YMF278::Slot::advance(unsigned eg_cnt)
 {
-	eg_cnt++;
-
-	// modulo counters for volume interpolation
-	int tl_int_cnt  =  eg_cnt % 9;      // 0 .. 8
-	int tl_int_step = (eg_cnt / 9) % 3; // 0 .. 2
-
-	for (auto& op : slots) {
-		// volume interpolation
+	// volume interpolation
+	if (TL != TLdest) {
+		// modulo counters for volume interpolation
+		int tl_int_cnt  =  eg_cnt % 9;      // 0 .. 8
+		int tl_int_step = (eg_cnt / 9) % 3; // 0 .. 2
 		if (tl_int_cnt == 0) {
 			if (tl_int_step == 0) {
 				// decrease volume by one step every 27 samples
-				if (op.TL < op.TLdest) ++op.TL;
+				if (TL < TLdest) ++TL;
 			} else {
 				// increase volume by one step every 13.5 samples
-				if (op.TL > op.TLdest) --op.TL;
+				if (TL > TLdest) --TL;
 			}
 		}
+	}
 
-		if (op.lfo_active) {
-			op.lfo_cnt = (op.lfo_cnt + lfo_period[op.lfo]) & (LFO_PERIOD - 1);
-		}
+	if (lfo_active) {
+		lfo_cnt = (lfo_cnt + lfo_period[lfo]) & (LFO_PERIOD - 1);
+	}
 
-		// Envelope Generator
-		switch (op.state) {
-		case EG_ATT: { // attack phase
-			uint8_t rate = op.compute_rate(op.AR);
-			// Verified by HW recording (and matches Nemesis' tests of the YM2612):
-			// AR = 0xF during KeyOn results in instant switch to EG_DEC. (see keyOnHelper)
-			// Setting AR = 0xF while the attack phase is in progress freezes the envelope.
-			if (rate >= 63) {
-				break;
-			}
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				// >>4 makes the attack phase's shape match the actual chip -Valley Bell
-				op.env_vol += (~op.env_vol * eg_inc[select + ((eg_cnt >> shift) & 7)]) >> 4;
-				if (op.env_vol <= MIN_ATT_INDEX) {
-					op.env_vol = MIN_ATT_INDEX;
-					// TODO does the real HW skip EG_DEC completely,
-					//      or is it active for 1 sample?
-					op.state = op.DL ? EG_DEC : EG_SUS;
-				}
-			}
+	// Envelope Generator
+	switch (state) {
+	case EG_ATT: { // attack phase
+		uint8_t rate = compute_rate(AR);
+		// Verified by HW recording (and matches Nemesis' tests of the YM2612):
+		// AR = 0xF during KeyOn results in instant switch to EG_DEC. (see keyOnHelper)
+		// Setting AR = 0xF while the attack phase is in progress freezes the envelope.
+		if (rate >= 63) {
 			break;
 		}
-		case EG_DEC: { // decay phase
-			uint8_t rate = op.compute_decay_rate(op.D1R);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= op.DL) {
-					op.state = (op.env_vol < MAX_ATT_INDEX) ? EG_SUS : EG_OFF;
-				}
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(eg_cnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			// >>4 makes the attack phase's shape match the actual chip -Valley Bell
+			env_vol += (~env_vol * eg_inc[select + ((eg_cnt >> shift) & 7)]) >> 4;
+			if (env_vol <= MIN_ATT_INDEX) {
+				env_vol = MIN_ATT_INDEX;
+				// TODO does the real HW skip EG_DEC completely,
+				//      or is it active for 1 sample?
+				state = DL ? EG_DEC : EG_SUS;
 			}
-			break;
 		}
-		case EG_SUS: { // sustain phase
-			uint8_t rate = op.compute_decay_rate(op.D2R);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= MAX_ATT_INDEX) {
-					op.env_vol = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+		break;
+	}
+	case EG_DEC: { // decay phase
+		uint8_t rate = compute_decay_rate(D1R);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(eg_cnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
+			if (env_vol >= DL) {
+				state = (env_vol < MAX_ATT_INDEX) ? EG_SUS : EG_OFF;
 			}
-			break;
 		}
-		case EG_REL: { // release phase
-			uint8_t rate = op.compute_decay_rate(op.RR);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= MAX_ATT_INDEX) {
-					op.env_vol = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+		break;
+	}
+	case EG_SUS: { // sustain phase
+		uint8_t rate = compute_decay_rate(D2R);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(eg_cnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
+			if (env_vol >= MAX_ATT_INDEX) {
+				env_vol = MAX_ATT_INDEX;
+				state = EG_OFF;
 			}
-			break;
 		}
-		case EG_OFF:
-			// nothing
-			break;
-
-		default:
-			UNREACHABLE;
+		break;
+	}
+	case EG_REL: { // release phase
+		uint8_t rate = compute_decay_rate(RR);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(eg_cnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
+			if (env_vol >= MAX_ATT_INDEX) {
+				env_vol = MAX_ATT_INDEX;
+				state = EG_OFF;
+			}
 		}
+		break;
+	}
+	case EG_OFF:
+		// nothing
+		break;
+
+	default:
+		UNREACHABLE;
 	}
 }
 
@@ -489,6 +489,11 @@ void YMF278::setMixLevel(uint8_t x, EmuTime::param time)
 	setSoftwareVolume(level[x & 7], level[(x >> 3) & 7], time);
 }
 
+bool YMF278::staysSilent()
+{
+	return !anyActive();
+}
+
 void YMF278::generateChannels(float** bufs, unsigned num)
 {
 	if (!anyActive()) {
@@ -500,59 +505,81 @@ void YMF278::generateChannels(float** bufs, unsigned num)
 		return;
 	}
 
-	for (unsigned j = 0; j < num; ++j) {
-		for (int i = 0; i < 24; ++i) {
-			auto& sl = slots[i];
-			if (sl.state == EG_OFF) {
-				//bufs[i][2 * j + 0] += 0;
-				//bufs[i][2 * j + 1] += 0;
-				continue;
+	// Slots are independent of each other (they only share the envelope
+	// counter), so calculate a whole block per slot. That keeps the slot
+	// state in registers and allows to hoist the per-slot setup out of the
+	// inner loop.
+	for (int i = 0; i < 24; ++i) {
+		auto& sl = slots[i];
+		if (sl.state == EG_OFF) {
+			// Only a key-on (a register write) can change this, so
+			// the slot stays silent for the whole block. But TL
+			// interpolation and the LFO do keep running.
+			bufs[i] = nullptr;
+			if (sl.TL == sl.TLdest) {
+				// shortcut for the common case
+				if (sl.lfo_active) {
+					sl.lfo_cnt = (sl.lfo_cnt + num * lfo_period[sl.lfo]) & (LFO_PERIOD - 1);
+				}
+			} else {
+				for (unsigned j = 0; j < num; ++j) {
+					sl.advance(eg_cnt + 1 + j);
+				}
 			}
+			continue;
+		}
 
-			int16_t sample = (sl.sample1 * (0x10000 - sl.stepptr) +
-			                  sl.sample2 * sl.stepptr) >> 16;
-			// TL levels are 00..FF internally (TL register value 7F is mapped to TL level FF)
-			// Envelope levels have 4x the resolution (000..3FF)
-			// Volume levels are approximate logarithmic. -6dB result in half volume. Steps in between use linear interpolation.
-			// A volume of -60dB or lower results in silence. (value 0x280..0x3FF).
-			// Recordings from actual hardware indicate that TL level and envelope level are applied separarely.
-			// Each of them is clipped to silence below -60dB, but TL+envelope might result in a lower volume. -Valley Bell
-			uint16_t envVol = std::min(sl.env_vol + ((sl.lfo_active && sl.AM) ? sl.compute_am() : 0),
-			                           MAX_ATT_INDEX);
-			int smplOut = vol_factor(vol_factor(sample, envVol), sl.TL << TL_SHIFT);
-
-			// Panning is also done separately. (low-volume TL + low-volume panning goes below -60dB)
-			// I'll be taking wild guess and assume that -3dB is approximated with 75%. (same as with TL and envelope levels)
-			// The same applies to the PCM mix level.
-			int32_t volLeft  = pan_left [sl.pan]; // note: register 0xF9 is handled externally
-			int32_t volRight = pan_right[sl.pan];
-			// 0 -> 0x20, 8 -> 0x18, 16 -> 0x10, 24 -> 0x0C, etc. (not using vol_factor here saves array boundary checks)
-			volLeft  = (0x20 - (volLeft  & 0x0f)) >> (volLeft  >> 4);
-			volRight = (0x20 - (volRight & 0x0f)) >> (volRight >> 4);
-
-			bufs[i][2 * j + 0] += (smplOut * volLeft ) >> 5;
-			bufs[i][2 * j + 1] += (smplOut * volRight) >> 5;
-
-			unsigned step = (sl.lfo_active && sl.vib)
-			              ? calcStep(sl.OCT, sl.FN, sl.compute_vib())
-			              : sl.step;
-			sl.stepptr += step;
-
-			// If there is a 4-sample loop and you advance 12 samples per step,
-			// it may exceed the end offset.
-			// This is abused by the "Lizard Star" song to generate noise at 0:52. -Valley Bell
-			if (sl.stepptr >= 0x10000) {
-				sl.sample1 = sl.sample2;
-				sl.sample2 = getSample(sl);
-				sl.pos += (sl.stepptr >> 16);
-				sl.stepptr &= 0xffff;
-				if ((uint32_t(sl.pos) + sl.endaddr) >= 0x10000) { // check position >= (negated) end address
-					sl.pos += sl.endaddr + sl.loopaddr; // This is how the actual chip does it.
+		// Panning is also done separately. (low-volume TL + low-volume panning goes below -60dB)
+		// I'll be taking wild guess and assume that -3dB is approximated with 75%. (same as with TL and envelope levels)
+		// The same applies to the PCM mix level.
+		int32_t volLeft  = pan_left [sl.pan]; // note: register 0xF9 is handled externally
+		int32_t volRight = pan_right[sl.pan];
+		// 0 -> 0x20, 8 -> 0x18, 16 -> 0x10, 24 -> 0x0C, etc. (not using vol_factor here saves array boundary checks)
+		volLeft  = (0x20 - (volLeft  & 0x0f)) >> (volLeft  >> 4);
+		volRight = (0x20 - (volRight & 0x0f)) >> (volRight >> 4);
+		bool useAM  = sl.lfo_active && sl.AM;
+		bool useVib = sl.lfo_active && sl.vib;
+
+		float* buf = bufs[i];
+		for (unsigned j = 0; j < num; ++j) {
+			if (sl.state != EG_OFF) {
+				int16_t sample = (sl.sample1 * (0x10000 - sl.stepptr) +
+				                  sl.sample2 * sl.stepptr) >> 16;
+				// TL levels are 00..FF internally (TL register value 7F is mapped to TL level FF)
+				// Envelope levels have 4x the resolution (000..3FF)
+				// Volume levels are approximate logarithmic. -6dB result in half volume. Steps in between use linear interpolation.
+				// A volume of -60dB or lower results in silence. (value 0x280..0x3FF).
+				// Recordings from actual hardware indicate that TL level and envelope level are applied separarely.
+				// Each of them is clipped to silence below -60dB, but TL+envelope might result in a lower volume. -Valley Bell
+				uint16_t envVol = std::min(sl.env_vol + (useAM ? sl.compute_am() : 0),
+				                           MAX_ATT_INDEX);
+				int smplOut = vol_factor(vol_factor(sample, envVol), sl.TL << TL_SHIFT);
+
+				buf[2 * j + 0] += (smplOut * volLeft ) >> 5;
+				buf[2 * j + 1] += (smplOut * volRight) >> 5;
+
+				unsigned step = useVib
+				              ? calcStep(sl.OCT, sl.FN, sl.compute_vib())
+				              : sl.step;
+				sl.stepptr += step;
+
+				// If there is a 4-sample loop and you advance 12 samples per step,
+				// it may exceed the end offset.
+				// This is abused by the "Lizard Star" song to generate noise at 0:52. -Valley Bell
+				if (sl.stepptr >= 0x10000) {
+					sl.sample1 = sl.sample2;
+					sl.sample2 = getSample(sl);
+					sl.pos += (sl.stepptr >> 16);
+					sl.stepptr &= 0xffff;
+					if ((uint32_t(sl.pos) + sl.endaddr) >= 0x10000) { // check position >= (negated) end address
+						sl.pos += sl.endaddr + sl.loopaddr; // This is how the actual chip does it.
+					}
 				}
 			}
+			sl.advance(eg_cnt + 1 + j);
 		}
-		advance();
 	}
+	eg_cnt += num;
 }
 
 void YMF278::keyOnHelper(YMF278::Slot& slot)
@@ -31,5 +31,16 @@ void sleep(uint64_t us)
 	std::this_thread::sleep_for(std::chrono::microseconds(us));
 }
 
+void waitUntil(uint64_t time, uint64_t spin)
+{
+	uint64_t now = getTime();
+	if ((now + spin) < time) {
+		sleep(time - spin - now);
+	}
+	while (getTime() < time) {
+		std::this_thread::yield();
+	}
+}
+
 } // namespace Timer
 } // namespace openmsx
@@ -15,6 +15,14 @@ namespace Timer {
 	  */
 	void sleep(uint64_t us);
 
+	/** Wait till getTime() reaches the given time. Sleeping often takes
+	  * longer than requested (the granularity of the OS scheduler can be
+	  * several ms), so the last 'spin' us before that time are instead
+	  * waited for in a loop that only yields the CPU. That's a lot more
+	  * precise, but keeps a CPU core busy.
+	  */
+	void waitUntil(uint64_t time, uint64_t spin);
+
 } // namespace Timer
 } // namespace openmsx
 
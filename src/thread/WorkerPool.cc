@@ -0,0 +1,36 @@
+#include "WorkerPool.hh"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace openmsx {
+
+void WorkerPool::parallelFor(size_t num, const std::function<void(size_t)>& func)
+{
+	if (workers.empty()) {
+		static const unsigned MAX_WORKERS = 8;
+		unsigned numWorkers = std::max(1u, std::min(
+			std::thread::hardware_concurrency(), MAX_WORKERS));
+		for (unsigned i = 0; i < numWorkers; ++i) {
+			workers.push_back(std::make_unique<WorkerThread>());
+		}
+	}
+	// Each worker takes the next not yet started item, so that a few big
+	// items don't block the others.
+	std::atomic<size_t> next(0);
+	for (auto& w : workers) {
+		w->push([&] {
+			while (true) {
+				size_t i = next++;
+				if (i >= num) break;
+				func(i);
+			}
+		});
+	}
+	// Waiting here also ensures the references captured above stay valid.
+	for (auto& w : workers) {
+		w->waitIdle();
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,32 @@
+#ifndef WORKERPOOL_HH
+#define WORKERPOOL_HH
+
+#include "WorkerThread.hh"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace openmsx {
+
+/**
+ * A small set of WorkerThreads (up to one per CPU core) to spread a batch of
+ * independent work items over. Like for WorkerThread, the threads are only
+ * started on first use.
+ */
+class WorkerPool final
+{
+public:
+	/** Execute func(0), func(1), ..., func(num - 1), spread over all
+	  * threads in the pool. Returns when all calls are finished. The
+	  * calls must be independent of each other.
+	  */
+	void parallelFor(size_t num, const std::function<void(size_t)>& func);
+
+private:
+	std::vector<std::unique_ptr<WorkerThread>> workers;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,55 @@
+#include "WorkerThread.hh"
+
+namespace openmsx {
+
+WorkerThread::~WorkerThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.clear();
+		exitLoop = true;
+	}
+	jobCond.notify_one();
+	if (thread.joinable()) thread.join();
+}
+
+void WorkerThread::push(Job job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+		if (!thread.joinable()) {
+			thread = std::thread([this]() { run(); });
+		}
+	}
+	jobCond.notify_one();
+}
+
+void WorkerThread::waitIdle()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idleCond.wait(lock, [&] { return jobs.empty() && !busy; });
+}
+
+void WorkerThread::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		jobCond.wait(lock, [&] { return exitLoop || !jobs.empty(); });
+		if (exitLoop) break;
+
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		busy = true;
+		lock.unlock();
+		job();
+		job = nullptr; // release resources outside the lock
+		lock.lock();
+		busy = false;
+		if (jobs.empty()) idleCond.notify_all();
+	}
+	busy = false;
+	idleCond.notify_all();
+}
+
+} // namespace openmsx
@@ -0,0 +1,52 @@
+#ifndef WORKERTHREAD_HH
+#define WORKERTHREAD_HH
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace openmsx {
+
+/**
+ * A single background thread that executes jobs in the order in which they
+ * were submitted. The thread is only started when the first job is pushed,
+ * so objects that never use it don't pay for it.
+ *
+ * Jobs must be self-contained: on destruction jobs that didn't start yet are
+ * discarded (a job that is already running is finished first). So a job
+ * should hold (shared) ownership of all the data it touches.
+ */
+class WorkerThread final
+{
+public:
+	using Job = std::function<void()>;
+
+	WorkerThread() = default;
+	~WorkerThread();
+
+	WorkerThread(const WorkerThread&) = delete;
+	WorkerThread& operator=(const WorkerThread&) = delete;
+
+	/** Queue a job for execution on the worker thread. */
+	void push(Job job);
+
+	/** Block until all previously pushed jobs have finished. */
+	void waitIdle();
+
+private:
+	void run();
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable jobCond;  // new job or exit request
+	std::condition_variable idleCond; // all jobs finished
+	std::deque<Job> jobs;
+	bool busy = false;
+	bool exitLoop = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -87,3 +87,42 @@ TEST_CASE("AdhocCliCommParser")
 		      vector<string>{});
 	}
 }
+
+static string frame(char kind, const string& payload)
+{
+	auto n = payload.size();
+	string result = { char(n >> 0), char(n >> 8), char(n >> 16), char(n >> 24), kind };
+	return result + payload;
+}
+
+TEST_CASE("AdhocCliCommParser: binary protocol")
+{
+	vector<string> result;
+	AdhocCliCommParser parser([&](const string& cmd) { result.push_back(cmd); });
+	parser.setBinary(true);
+	auto feed = [&](const string& s) { parser.parse(s.data(), s.size()); };
+
+	SECTION("multiple commands") {
+		feed(frame('C', "foo") + frame('C', "") + frame('C', string(300, 'x')));
+		CHECK(result == (vector<string>{"foo", "", string(300, 'x')}));
+	}
+	SECTION("no escaping") {
+		feed(frame('C', string("<&>\0\n", 5)));
+		CHECK(result == vector<string>{string("<&>\0\n", 5)});
+	}
+	SECTION("split over multiple chunks") {
+		string s = frame('C', "hello") + frame('C', "world");
+		for (char c : s) parser.parse(&c, 1);
+		CHECK(result == (vector<string>{"hello", "world"}));
+	}
+	SECTION("unknown kinds are ignored") {
+		feed(frame('X', "foo") + frame('C', "bar"));
+		CHECK(result == vector<string>{"bar"});
+	}
+	SECTION("switch back to XML") {
+		feed(frame('C', "foo"));
+		parser.setBinary(false);
+		feed("<command>bar</command>");
+		CHECK(result == (vector<string>{"foo", "bar"}));
+	}
+}
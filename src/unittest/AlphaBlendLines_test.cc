@@ -0,0 +1,116 @@
+#include "catch.hpp"
+#include "LineScalers.hh"
+#include "PixelOperations.hh"
+#include "MemBuffer.hh"
+#include "build-info.hh"
+#include <SDL.h>
+#include <cstdint>
+
+using namespace openmsx;
+
+// The SIMD versions of AlphaBlendLines must give the same result as
+// PixelOperations::alphaBlend() (and the scalar loops), also for the pixels
+// in the scalar tail of the lines (odd widths).
+template<typename Pixel>
+static void fillLines(MemBuffer<Pixel>& in1, MemBuffer<Pixel>& in2,
+                      size_t width, Pixel key)
+{
+	uint32_t state = 1;
+	auto random = [&] {
+		state = state * 1664525 + 1013904223;
+		return state;
+	};
+	for (size_t x = 0; x < width; ++x) {
+		in1[x] = Pixel(random());
+		in2[x] = Pixel(random());
+		if ((x % 3) == 0) in1[x] = key; // transparent
+	}
+}
+
+#if HAVE_32BPP
+TEST_CASE("AlphaBlendLines: 32bpp")
+{
+	SDL_PixelFormat format = {};
+	format.BitsPerPixel = 32;
+	format.BytesPerPixel = 4;
+	SECTION("ARGB") {
+		format.Amask = 0xFF000000; format.Ashift = 24;
+		format.Rmask = 0x00FF0000; format.Rshift = 16;
+		format.Gmask = 0x0000FF00; format.Gshift =  8;
+		format.Bmask = 0x000000FF; format.Bshift =  0;
+	}
+	SECTION("RGBA") {
+		format.Rmask = 0xFF000000; format.Rshift = 24;
+		format.Gmask = 0x00FF0000; format.Gshift = 16;
+		format.Bmask = 0x0000FF00; format.Bshift =  8;
+		format.Amask = 0x000000FF; format.Ashift =  0;
+	}
+	PixelOperations<uint32_t> pixelOps(format);
+	AlphaBlendLines<uint32_t> blend(pixelOps);
+
+	for (size_t width : {1, 7, 320, 643}) {
+		MemBuffer<uint32_t> in1(width), in2(width), out(width);
+		fillLines<uint32_t>(in1, in2, width, 0);
+
+		blend(in1.data(), in2.data(), out.data(), width);
+		unsigned errors = 0;
+		for (size_t x = 0; x < width; ++x) {
+			if (out[x] != pixelOps.alphaBlend(in1[x], in2[x])) ++errors;
+		}
+		CHECK(errors == 0);
+
+		// single (semi-transparent) color
+		for (unsigned alpha : {1, 100, 128, 254}) {
+			uint32_t color = (0x00C0FFEE & ~format.Amask) |
+			                 (alpha << format.Ashift);
+			blend(color, in2.data(), out.data(), width);
+			unsigned alpha2 = 256 - alpha;
+			uint32_t colorM = pixelOps.multiply(color, alpha);
+			errors = 0;
+			for (size_t x = 0; x < width; ++x) {
+				uint32_t expected = colorM + pixelOps.multiply(in2[x], alpha2);
+				if (out[x] != expected) ++errors;
+			}
+			CHECK(errors == 0);
+		}
+
+		// in place
+		MemBuffer<uint32_t> expected(width);
+		for (size_t x = 0; x < width; ++x) {
+			expected[x] = pixelOps.alphaBlend(in1[x], in2[x]);
+		}
+		blend(in1.data(), in2.data(), in2.data(), width);
+		errors = 0;
+		for (size_t x = 0; x < width; ++x) {
+			if (in2[x] != expected[x]) ++errors;
+		}
+		CHECK(errors == 0);
+	}
+}
+#endif
+
+#if HAVE_16BPP
+TEST_CASE("AlphaBlendLines: 16bpp")
+{
+	SDL_PixelFormat format = {};
+	format.BitsPerPixel = 16;
+	format.BytesPerPixel = 2;
+	format.Rmask = 0xF800; format.Rshift = 11; format.Rloss = 3;
+	format.Gmask = 0x07E0; format.Gshift =  5; format.Gloss = 2;
+	format.Bmask = 0x001F; format.Bshift =  0; format.Bloss = 3;
+	PixelOperations<uint16_t> pixelOps(format);
+	AlphaBlendLines<uint16_t> blend(pixelOps);
+
+	for (size_t width : {1, 7, 320, 643}) {
+		MemBuffer<uint16_t> in1(width), in2(width), out(width);
+		fillLines<uint16_t>(in1, in2, width, 0x0001); // color key
+
+		blend(in1.data(), in2.data(), out.data(), width);
+		unsigned errors = 0;
+		for (size_t x = 0; x < width; ++x) {
+			if (out[x] != pixelOps.alphaBlend(in1[x], in2[x])) ++errors;
+		}
+		CHECK(errors == 0);
+	}
+}
+#endif
@@ -1,5 +1,7 @@
 #include "catch.hpp"
 #include "Base64.hh"
+#include <cstring>
+#include <vector>
 
 static void test_decode(const std::string& encoded, const std::string& decoded)
 {
@@ -46,3 +48,26 @@ TEST_CASE("Base64")
 	test_decode("MDEyMzQ1Njc4OUFCQ0RFRkdISUpLTE1OT1BRUlNUVVZXWFlaYWJjZGVmZ2hpamtsbW5vcHFyc3R1dnd4eXoK",
 	            "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz\n");
 }
+
+TEST_CASE("Base64: round trip")
+{
+	// All lengths around the line length (57 bytes per line) and the
+	// block sizes of the SIMD code, with all 64 digits in the output.
+	std::string data;
+	for (unsigned i = 0; i < 300; ++i) {
+		data += char((i * 97 + 13) ^ (i >> 3));
+	}
+	for (size_t len = 0; len <= data.size(); ++len) {
+		auto* in = reinterpret_cast<const uint8_t*>(data.data());
+		auto encoded = Base64::encode(in, len);
+		auto p = Base64::decode(encoded);
+		REQUIRE(p.second == len);
+		CHECK(memcmp(p.first.data(), in, len) == 0);
+
+		std::vector<uint8_t> buf(len + 1);
+		CHECK(Base64::decode_inplace(encoded, buf.data(), len));
+		CHECK(memcmp(buf.data(), in, len) == 0);
+		CHECK(!Base64::decode_inplace(encoded, buf.data(), len + 1));
+		if (len) CHECK(!Base64::decode_inplace(encoded, buf.data(), len - 1));
+	}
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+#include "BitmapConverter.hh"
+#include "Math.hh"
+#include <cstdint>
+#include <vector>
+
+using namespace openmsx;
+
+// Straightforward implementation of the YJK/YAE color calculation (for one
+// group of 4 pixels), the optimized code should give the same result.
+static void refYJK(const uint8_t p[4], bool yae, uint32_t out[4])
+{
+	int j = (p[2] & 7) + ((p[3] & 3) << 3) - ((p[3] & 4) << 3);
+	int k = (p[0] & 7) + ((p[1] & 3) << 3) - ((p[1] & 4) << 3);
+	for (int n = 0; n < 4; ++n) {
+		if (yae && (p[n] & 0x08)) {
+			out[n] = 0x10000 + (p[n] >> 4);
+		} else {
+			int y = p[n] >> 3;
+			int r = Math::clip<0, 31>(y + j);
+			int g = Math::clip<0, 31>(y + k);
+			int b = Math::clip<0, 31>((5 * y - 2 * j - k) / 4);
+			out[n] = (r << 10) + (g << 5) + b;
+		}
+	}
+}
+
+static void test(bool yae)
+{
+	// palette entries are equal to their index, so that the output pixels
+	// directly show which palette entry was used
+	std::vector<uint32_t> palette16(32), palette256(256), palette32768(32768);
+	for (unsigned i = 0; i < 32;    ++i) palette16[i]    = 0x10000 + i;
+	for (unsigned i = 0; i < 256;   ++i) palette256[i]   = 0x20000 + i;
+	for (unsigned i = 0; i < 32768; ++i) palette32768[i] = i;
+	BitmapConverter<uint32_t> converter(
+		palette16.data(), palette256.data(), palette32768.data());
+	// graphic7 (M5..M3 in reg 0) with YJK and possibly YAE (in reg 25)
+	converter.setDisplayMode(DisplayMode(0x0E, 0x00, yae ? 0x18 : 0x08));
+
+	uint32_t state = 1;
+	for (int line = 0; line < 200; ++line) {
+		uint8_t vram0[128], vram1[128];
+		for (int i = 0; i < 128; ++i) {
+			state = state * 1664525 + 1013904223;
+			vram0[i] = state >> 24;
+			vram1[i] = state >> 16;
+		}
+		uint32_t pixels[256];
+		converter.convertLinePlanar(pixels, vram0, vram1);
+
+		for (int i = 0; i < 64; ++i) {
+			uint8_t p[4] = { vram0[2 * i + 0], vram1[2 * i + 0],
+			                 vram0[2 * i + 1], vram1[2 * i + 1] };
+			uint32_t expected[4];
+			refYJK(p, yae, expected);
+			for (int n = 0; n < 4; ++n) {
+				CHECK(pixels[4 * i + n] == expected[n]);
+			}
+		}
+	}
+}
+
+TEST_CASE("BitmapConverter: YJK")
+{
+	test(false);
+}
+
+TEST_CASE("BitmapConverter: YAE")
+{
+	test(true);
+}
@@ -0,0 +1,51 @@
+#include "catch.hpp"
+#include "BlipBuffer.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace openmsx;
+
+// Add the same (pseudo random) deltas to both buffers.
+static void addDeltas(BlipBuffer& blip1, BlipBuffer& blip2, unsigned samples)
+{
+	uint32_t state = 1;
+	for (unsigned i = 0; i < 50; ++i) {
+		state = state * 1664525 + 1013904223;
+		auto time = BlipBuffer::TimeIndex::create((state >> 8) % (samples << 10));
+		float delta = float(int((state >> 20) % 512) - 256);
+		blip1.addDelta(time, delta);
+		blip2.addDelta(time, delta);
+	}
+}
+
+TEST_CASE("BlipBuffer")
+{
+	// Reading one sample at a time is the plain sequential calculation,
+	// reading many at once takes the blocked code path.
+	BlipBuffer ref, blip;
+	for (unsigned samples : {1, 3, 4, 7, 100, 1000, 735, 5000, 9000}) {
+		addDeltas(ref, blip, samples);
+		std::vector<float> out1(samples), out2(2 * samples);
+		for (unsigned i = 0; i < samples; ++i) {
+			REQUIRE(ref.readSamples<1>(&out1[i], 1));
+		}
+		REQUIRE(blip.readSamples<2>(out2.data(), samples));
+		// The rounding errors are relative to the biggest values in the
+		// signal, not to each individual value.
+		float peak = 1.0f;
+		for (float f : out1) peak = std::max(peak, std::abs(f));
+		unsigned errors = 0;
+		for (unsigned i = 0; i < samples; ++i) {
+			if (std::abs(out1[i] - out2[2 * i]) > 1e-5f * peak) ++errors;
+		}
+		CHECK(errors == 0);
+	}
+	// Both decay to silence (and also get there in the blocked case).
+	std::vector<float> out(20000);
+	for (unsigned i = 0; i < 20; ++i) {
+		blip.readSamples<1>(out.data(), 20000);
+	}
+	CHECK(!blip.readSamples<1>(out.data(), 4));
+}
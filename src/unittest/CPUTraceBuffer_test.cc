@@ -0,0 +1,90 @@
+#include "catch.hpp"
+#include "CPUTraceBuffer.hh"
+#include "Dasm.hh"
+
+using namespace openmsx;
+
+static void add(CPUTraceBuffer& buffer, uint16_t pc)
+{
+	auto& r = buffer.add();
+	r.time = pc * 10;
+	r.pc = pc;
+	r.af = r.bc = r.de = r.hl = r.ix = r.iy = r.sp = 0;
+	r.opcode[0] = r.opcode[1] = r.opcode[2] = r.opcode[3] = 0;
+}
+
+TEST_CASE("CPUTraceBuffer: ring")
+{
+	CPUTraceBuffer buffer;
+	CHECK(!buffer.isActive());
+	CHECK(buffer.size() == 0);
+
+	buffer.start(4);
+	CHECK(buffer.isActive());
+	add(buffer, 1); add(buffer, 2); add(buffer, 3);
+	REQUIRE(buffer.size() == 3);
+	CHECK(buffer[0].pc == 1);
+	CHECK(buffer[2].pc == 3);
+
+	// when full the oldest records are overwritten
+	add(buffer, 4); add(buffer, 5); add(buffer, 6);
+	REQUIRE(buffer.size() == 4);
+	CHECK(buffer[0].pc == 3);
+	CHECK(buffer[1].pc == 4);
+	CHECK(buffer[2].pc == 5);
+	CHECK(buffer[3].pc == 6);
+	CHECK(buffer[3].time == 60);
+
+	// stop keeps the records, start discards them
+	buffer.stop();
+	CHECK(!buffer.isActive());
+	CHECK(buffer.size() == 4);
+	buffer.start(2);
+	CHECK(buffer.size() == 0);
+	add(buffer, 7); add(buffer, 8); add(buffer, 9);
+	REQUIRE(buffer.size() == 2);
+	CHECK(buffer[0].pc == 8);
+	CHECK(buffer[1].pc == 9);
+
+	buffer.clear();
+	CHECK(buffer.size() == 0);
+	CHECK(buffer.isActive());
+}
+
+TEST_CASE("CPUTraceBuffer: format")
+{
+	CPUTraceBuffer::Record r;
+	r.time = 1234;
+	r.pc = 0x4000;
+	r.af = 0x1234; r.bc = 0x5678; r.de = 0x9ABC; r.hl = 0xDEF0;
+	r.ix = 0x1111; r.iy = 0x2222; r.sp = 0xF000;
+	r.opcode[0] = 0x21; r.opcode[1] = 0x34; r.opcode[2] = 0x12; r.opcode[3] = 0xFF;
+	CHECK(CPUTraceBuffer::format(r) ==
+	      "1234 4000 : ld     hl,#1234    "
+	      " AF=1234 BC=5678 DE=9abc HL=def0 IX=1111 IY=2222 SP=f000");
+
+	r.opcode[0] = 0x18; r.opcode[1] = 0xFE; // jr to itself
+	CHECK(CPUTraceBuffer::format(r) ==
+	      "1234 4000 : jr     #4000       "
+	      " AF=1234 BC=5678 DE=9abc HL=def0 IX=1111 IY=2222 SP=f000");
+}
+
+TEST_CASE("CPUTraceBuffer: format with DasmCache")
+{
+	CPUTraceBuffer::Record r;
+	r.time = 0;
+	r.af = r.bc = r.de = r.hl = r.ix = r.iy = r.sp = 0;
+	DasmCache cache;
+	// twice: first fill the cache, then the result must come from the cache
+	for (int pass = 0; pass < 2; ++pass) {
+		for (unsigned i = 0; i < 0x10000; i += 7) {
+			r.pc = i ^ 0x5A5A;
+			r.opcode[0] = i >> 8;
+			r.opcode[1] = i & 0xFF;
+			r.opcode[2] = i * 3;
+			r.opcode[3] = i * 5;
+			CHECK(CPUTraceBuffer::format(r, &cache) ==
+			      CPUTraceBuffer::format(r));
+		}
+	}
+}
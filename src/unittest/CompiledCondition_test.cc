@@ -0,0 +1,103 @@
+#include "catch.hpp"
+#include "CompiledCondition.hh"
+#include <cstdint>
+
+using namespace openmsx;
+
+struct TestContext final : CompiledCondition::Context
+{
+	unsigned read(CompiledCondition::Source source, unsigned address) override
+	{
+		switch (source) {
+		case CompiledCondition::CPU_REGS:       return regs[address % 28];
+		case CompiledCondition::MEMORY:         return mem[address & 0xFFFF];
+		case CompiledCondition::IO_PORTS:       return (address == 0xA8) ? primSlot : 0xFF;
+		case CompiledCondition::SLOTTED_MEMORY: return subSlot;
+		}
+		return 0;
+	}
+	bool isExpanded(int ps) override { return ps == 3; }
+
+	uint8_t regs[28] = {};
+	uint8_t mem[0x10000] = {};
+	uint8_t primSlot = 0;
+	uint8_t subSlot = 0xFF; // inverted
+};
+
+static bool eval(TestContext& context, const char* expr)
+{
+	auto cond = CompiledCondition::compile(expr);
+	REQUIRE(cond);
+	return cond->evaluate(context);
+}
+
+TEST_CASE("CompiledCondition: unsupported expressions")
+{
+	for (const char* expr : {
+			"", "$a == 1", "[reg A", "[reg XYZ] == 1", "[peek 0x10 memory]",
+			"[reg A] eq 1", "017 == 15", "1 +", "(1 == 1", "[clock] > 1",
+			"[pc_in_slot 1 2 3]", "[pc_in_slot 4]", "5 / 2", "1 ? 2 : 3"}) {
+		INFO(expr);
+		CHECK(!CompiledCondition::compile(expr));
+	}
+}
+
+TEST_CASE("CompiledCondition: operators")
+{
+	TestContext c;
+	CHECK( eval(c, "1"));
+	CHECK(!eval(c, "0"));
+	CHECK( eval(c, "1 + 2 * 3 == 7"));
+	CHECK( eval(c, "(1 + 2) * 3 == 9"));
+	CHECK( eval(c, "10 - 3 - 2 == 5"));
+	CHECK( eval(c, "-3 + 5 == 2"));
+	CHECK( eval(c, "!0 && !!7"));
+	CHECK( eval(c, "~0 == -1"));
+	CHECK( eval(c, "1 << 4 == 16"));
+	CHECK( eval(c, "0x80 >> 3 == 0b10000"));
+	CHECK( eval(c, "3 < 4 && 4 <= 4 && 5 > 4 && 4 >= 4"));
+	CHECK(!eval(c, "3 > 4 || 4 != 4"));
+	CHECK( eval(c, "(0x0F & 0x3C) == 0x0C"));
+	CHECK( eval(c, "(0x0F | 0x30) == 0x3F"));
+	CHECK( eval(c, "(0x0F ^ 0x3C) == 0x33"));
+	// precedence: '==' binds stronger than '&'
+	CHECK(!eval(c, "6 & 3 == 3"));
+}
+
+TEST_CASE("CompiledCondition: registers and memory")
+{
+	TestContext c;
+	c.regs[0] = 0x12;                  // A
+	c.regs[6] = 0xC0; c.regs[7] = 0x01; // HL
+	c.regs[20] = 0x40; c.regs[21] = 0x10; // PC
+	c.mem[0xC001] = 0x34;
+	c.mem[0xC002] = 0x56;
+
+	CHECK( eval(c, "[reg A] == 0x12"));
+	CHECK( eval(c, "[reg a]==18"));
+	CHECK( eval(c, "[reg HL] == 0xC001"));
+	CHECK( eval(c, "[reg PC] == 0x4010"));
+	CHECK( eval(c, "[reg PCh] == 0x40"));
+	CHECK( eval(c, "[peek 0xC001] == 0x34"));
+	CHECK( eval(c, "[peek [reg HL]] == 0x34"));
+	CHECK( eval(c, "[peek16 [reg HL]] == 0x5634"));
+	CHECK( eval(c, "[reg A] == 0x12 && [peek 0xC002] == 0x56"));
+	CHECK(!eval(c, "[reg A] == 0x12 && [peek 0xC002] == 0x57"));
+}
+
+TEST_CASE("CompiledCondition: pc_in_slot")
+{
+	TestContext c;
+	c.regs[20] = 0x40; // PC = 0x4000 -> page 1
+	c.primSlot = 0x04; // page 1 in slot 1
+	CHECK( eval(c, "[pc_in_slot 1]"));
+	CHECK(!eval(c, "[pc_in_slot 2]"));
+	CHECK( eval(c, "[pc_in_slot 1 2]")); // slot 1 not expanded
+	CHECK( eval(c, "[pc_in_slot X]"));
+
+	c.primSlot = 0x0C; // page 1 in slot 3 (expanded)
+	c.subSlot = uint8_t(~0x08); // page 1 in subslot 2
+	CHECK( eval(c, "[pc_in_slot 3 2]"));
+	CHECK(!eval(c, "[pc_in_slot 3 1]"));
+	CHECK( eval(c, "[pc_in_slot 3 X]"));
+}
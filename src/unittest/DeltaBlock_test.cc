@@ -0,0 +1,133 @@
+#include "catch.hpp"
+#include "DeltaBlock.hh"
+#include "MemBuffer.hh"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace openmsx;
+
+static void checkApply(const DeltaBlock& block, const std::vector<uint8_t>& expected)
+{
+	MemBuffer<uint8_t> buf(expected.size());
+	block.apply(buf.data(), expected.size());
+	CHECK(memcmp(buf.data(), expected.data(), expected.size()) == 0);
+}
+
+TEST_CASE("DeltaBlock")
+{
+	const size_t SIZE = 4096;
+	std::vector<uint8_t> data(SIZE, 0);
+	int id; // only the address is used
+	LastDeltaBlocks lastBlocks;
+
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<std::vector<uint8_t>> snapshots;
+	for (int i = 0; i < 100; ++i) {
+		// A few small changes per snapshot, so that there's a mix of
+		// diff blocks and (compressed) reference blocks.
+		for (int j = 0; j < 8; ++j) {
+			data[(i * 37 + j * 501) % SIZE] = uint8_t(i + j);
+		}
+		blocks.push_back(lastBlocks.createNew(&id, data.data(), SIZE));
+		snapshots.push_back(data);
+	}
+	// Applying must give the original data, also while reference blocks
+	// are (possibly) still being compressed in the background.
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		CHECK(blocks[i]->getBlockSize() == SIZE);
+		checkApply(*blocks[i], snapshots[i]);
+	}
+
+	lastBlocks.clear();
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		checkApply(*blocks[i], snapshots[i]);
+	}
+}
+
+TEST_CASE("DeltaBlock, dirty pages")
+{
+	const size_t SIZE = 10 * DirtyPages::PAGE_SIZE + 123; // partial last page
+	std::vector<uint8_t> data(SIZE, 0);
+	int id;
+	LastDeltaBlocks lastBlocks;
+	DirtyPages dirty(SIZE);
+	CHECK(dirty.getNumPages() == 11);
+	CHECK(dirty.anyDirty());
+
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<std::vector<uint8_t>> snapshots;
+	for (int i = 0; i < 50; ++i) {
+		size_t addr = (i * 997) % SIZE;
+		data[addr] = uint8_t(i + 1);
+		dirty.markDirty(addr);
+		if (i & 1) {
+			// also a multi-page write, ending in the last page
+			size_t start = SIZE - 2000;
+			memset(&data[start], i, 2000);
+			dirty.markDirty(start, 2000);
+		}
+		blocks.push_back(lastBlocks.createNew(&id, data.data(), SIZE, &dirty));
+		snapshots.push_back(data);
+		dirty.clear();
+		CHECK(!dirty.anyDirty());
+	}
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		checkApply(*blocks[i], snapshots[i]);
+	}
+}
+
+TEST_CASE("DeltaBlock, mismatch runs")
+{
+	// Runs of changed and unchanged bytes of many different lengths and
+	// alignments, to exercise the (vectorized) scan loops.
+	const size_t SIZE = 8192;
+	std::vector<uint8_t> data(SIZE, 0);
+	int id;
+	LastDeltaBlocks lastBlocks;
+
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<std::vector<uint8_t>> snapshots;
+	for (int i = 0; i < 30; ++i) {
+		size_t pos = i * 7;
+		while (pos < SIZE) {
+			size_t len = std::min<size_t>((pos * 13 + i) % 97 + 1, SIZE - pos);
+			for (size_t j = 0; j < len; ++j) ++data[pos + j];
+			pos += len + (pos * 31 + i) % 151;
+		}
+		blocks.push_back(lastBlocks.createNew(&id, data.data(), SIZE));
+		snapshots.push_back(data);
+	}
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		checkApply(*blocks[i], snapshots[i]);
+	}
+}
+
+// Not run by default, use:  unittest "[.benchmark]"
+TEST_CASE("DeltaBlock benchmark", "[.benchmark]")
+{
+	const size_t SIZE = 4 * 1024 * 1024; // e.g. a large memory mapper
+	const int REPEAT = 20;
+	std::vector<uint8_t> data(SIZE, 0);
+	int id;
+
+	BENCHMARK("few changes") {
+		LastDeltaBlocks lastBlocks;
+		for (int r = 0; r < REPEAT; ++r) {
+			for (int j = 0; j < 64; ++j) {
+				data[(r * 4099 + j * 65537) % SIZE] = uint8_t(r + j);
+			}
+			lastBlocks.createNew(&id, data.data(), SIZE);
+		}
+	}
+	BENCHMARK("many changes") {
+		LastDeltaBlocks lastBlocks;
+		for (int r = 0; r < REPEAT; ++r) {
+			for (size_t j = r & 7; j < SIZE; j += 3) {
+				++data[j];
+			}
+			lastBlocks.createNew(&id, data.data(), SIZE);
+		}
+	}
+}
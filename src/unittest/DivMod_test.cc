@@ -9,6 +9,7 @@ static void test(const DivModByConst<DIVISOR>& c, const DivModBySame& s,
                  uint64_t dividend)
 {
 	uint64_t rd = dividend / DIVISOR;
+	CHECK(s.div64(dividend) == rd);
 	if (uint32_t(rd) == rd) {
 		CHECK(c.div(dividend) == (dividend / DIVISOR));
 		CHECK(s.div(dividend) == (dividend / DIVISOR));
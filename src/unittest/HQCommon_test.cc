@@ -0,0 +1,63 @@
+#include "catch.hpp"
+#include "HQCommon.hh"
+#include <cstdint>
+#include <vector>
+
+using namespace openmsx;
+
+// Pixels with small random differences, so that both edges and non-edges
+// occur often.
+template<typename Pixel>
+static std::vector<Pixel> randomLine(unsigned width, uint32_t& state)
+{
+	std::vector<Pixel> result;
+	Pixel p = 0;
+	for (unsigned i = 0; i < width; ++i) {
+		state = state * 1664525 + 1013904223;
+		if ((state >> 28) == 0) {
+			p = Pixel(state >> 8); // completely different color
+		} else {
+			p ^= Pixel((state >> 12) & 0x1F1F1F1F); // small change
+		}
+		result.push_back(p);
+	}
+	return result;
+}
+
+template<typename Pixel>
+static void test(EdgeHQ edgeOp)
+{
+	uint32_t state = 1;
+	for (unsigned width : {1, 7, 8, 9, 17, 256, 320, 512, 640}) {
+		for (int i = 0; i < 20; ++i) {
+			auto curr = randomLine<Pixel>(width, state);
+			auto next = randomLine<Pixel>(width, state);
+			std::vector<uint8_t> edges(width);
+			calcEdgesHQ(curr.data(), next.data(), width, edges.data(), edgeOp);
+
+			for (unsigned x = 0; x < width; ++x) {
+				unsigned x1 = std::min(x + 1, width - 1);
+				uint32_t c5 = readPixel(curr[x]);
+				uint32_t c6 = readPixel(curr[x1]);
+				uint32_t c8 = readPixel(next[x]);
+				uint32_t c9 = readPixel(next[x1]);
+				CHECK(((edges[x] & 1) != 0) == edgeOp(c5, c8));
+				CHECK(((edges[x] & 2) != 0) == edgeOp(c5, c9));
+				CHECK(((edges[x] & 4) != 0) == edgeOp(c6, c8));
+				CHECK(((edges[x] & 8) != 0) == edgeOp(c5, c6));
+			}
+		}
+	}
+}
+
+TEST_CASE("HQCommon: calcEdgesHQ 16bpp")
+{
+	test<uint16_t>(EdgeHQ(0, 8, 16));
+}
+
+TEST_CASE("HQCommon: calcEdgesHQ 32bpp")
+{
+	test<uint32_t>(EdgeHQ(16, 8, 0));
+	test<uint32_t>(EdgeHQ(0, 8, 16));
+	test<uint32_t>(EdgeHQ(24, 16, 8));
+}
@@ -0,0 +1,73 @@
+#include "catch.hpp"
+#include "MPSCQueue.hh"
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("MPSCQueue: single thread")
+{
+	MPSCQueue<int, 4> queue;
+	int v = -1;
+	CHECK(!queue.pop(v));
+
+	CHECK(queue.push(1));
+	CHECK(queue.push(2));
+	CHECK(queue.pop(v)); CHECK(v == 1);
+
+	// wrap around the ring a few times
+	for (int i = 3; i < 20; ++i) {
+		CHECK(queue.push(i));
+		CHECK(queue.pop(v)); CHECK(v == (i - 1));
+	}
+	CHECK(queue.pop(v)); CHECK(v == 19);
+	CHECK(!queue.pop(v));
+
+	// full
+	for (int i = 0; i < 4; ++i) CHECK(queue.push(i));
+	CHECK(!queue.push(4));
+	CHECK(queue.pop(v)); CHECK(v == 0);
+	CHECK(queue.push(4));
+	for (int i = 1; i <= 4; ++i) {
+		CHECK(queue.pop(v)); CHECK(v == i);
+	}
+	CHECK(!queue.pop(v));
+}
+
+TEST_CASE("MPSCQueue: multiple producers")
+{
+	static const int NUM_THREADS = 4;
+	static const int NUM = 20000;
+	MPSCQueue<int, 64> queue;
+
+	std::vector<std::thread> producers;
+	for (int t = 0; t < NUM_THREADS; ++t) {
+		producers.emplace_back([&queue, t] {
+			for (int i = 0; i < NUM; ++i) {
+				while (!queue.push(t * NUM + i)) {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	// per producer the elements arrive in order
+	std::vector<int> next(NUM_THREADS, 0);
+	int count = 0;
+	bool ok = true;
+	while (count < NUM_THREADS * NUM) {
+		int v;
+		if (!queue.pop(v)) {
+			std::this_thread::yield();
+			continue;
+		}
+		int t = v / NUM;
+		if ((t >= NUM_THREADS) || ((v % NUM) != next[t])) ok = false;
+		if (t < NUM_THREADS) ++next[t];
+		++count;
+	}
+	for (auto& p : producers) p.join();
+	CHECK(ok);
+	int v;
+	CHECK(!queue.pop(v));
+}
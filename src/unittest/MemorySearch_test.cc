@@ -0,0 +1,98 @@
+#include "catch.hpp"
+#include "MemorySearch.hh"
+#include <cstdint>
+#include <vector>
+
+using namespace openmsx;
+
+static std::vector<uint8_t> randomData(unsigned size, uint32_t& state)
+{
+	std::vector<uint8_t> result(size);
+	for (auto& r : result) {
+		state = state * 1664525 + 1013904223;
+		// few different values, so that all relations occur often
+		r = 126 + ((state >> 24) % 4);
+	}
+	return result;
+}
+
+static bool compare(uint8_t a, uint8_t b, MemorySearch::Op op)
+{
+	switch (op) {
+		case MemorySearch::EQ: return a == b;
+		case MemorySearch::NE: return a != b;
+		case MemorySearch::LT: return a <  b;
+		case MemorySearch::LE: return a <= b;
+		case MemorySearch::GT: return a >  b;
+		default:               return a >= b;
+	}
+}
+
+static std::vector<unsigned> getCandidates(const MemorySearch& search)
+{
+	std::vector<unsigned> result;
+	search.forEach([&](unsigned addr) { result.push_back(addr); return true; });
+	return result;
+}
+
+// Sizes around multiples of the group size, so that the tail handling gets
+// exercised. Values around 128 check that the comparisons are unsigned.
+TEST_CASE("MemorySearch: filter")
+{
+	static const MemorySearch::Op ops[] = {
+		MemorySearch::EQ, MemorySearch::NE, MemorySearch::LT,
+		MemorySearch::LE, MemorySearch::GT, MemorySearch::GE,
+	};
+	uint32_t state = 1;
+	for (unsigned size : {0, 1, 15, 63, 64, 65, 130, 1000}) {
+		for (auto op1 : ops) {
+			for (auto op2 : ops) {
+				INFO("size " << size << " ops " << op1 << ' ' << op2);
+				auto data0 = randomData(size, state);
+				auto data1 = randomData(size, state);
+				auto data2 = randomData(size, state);
+				std::vector<unsigned> expected;
+				for (unsigned i = 0; i < size; ++i) {
+					if (compare(data1[i], data0[i], op1) &&
+					    compare(data2[i], 127, op2)) {
+						expected.push_back(i);
+					}
+				}
+
+				MemorySearch search;
+				search.start(data0);
+				CHECK(search.count() == size);
+				search.filter(data1, op1);
+				search.filter(data2, op2, 127);
+				CHECK(getCandidates(search) == expected);
+				CHECK(search.count() == expected.size());
+				for (auto addr : expected) {
+					CHECK(search.getValue(addr) == data2[addr]);
+					CHECK(search.getPrevious(addr) == data1[addr]);
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("MemorySearch: keep")
+{
+	std::vector<uint8_t> data(100, 0);
+	MemorySearch search;
+	search.start(data);
+	data[3] = data[70] = 5;
+	search.filter(data, MemorySearch::GT);
+	CHECK(getCandidates(search) == std::vector<unsigned>{3, 70});
+
+	data[3] = 7;
+	unsigned addrs[] = { 1, 70, 3000 };
+	search.keep(addrs, data);
+	CHECK(getCandidates(search) == std::vector<unsigned>{70});
+	CHECK(search.getValue(3) == 7);
+	CHECK(search.getPrevious(3) == 5);
+	CHECK(search.isCandidate(70));
+	CHECK(!search.isCandidate(3));
+
+	search.clear();
+	CHECK(!search.isActive());
+}
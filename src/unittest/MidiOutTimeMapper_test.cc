@@ -0,0 +1,49 @@
+#include "catch.hpp"
+#include "MidiOutTimeMapper.hh"
+
+using namespace openmsx;
+
+static EmuTime ms(unsigned t)
+{
+	return EmuTime::zero + EmuDuration::msec(t);
+}
+
+TEST_CASE("MidiOutTimeMapper")
+{
+	MidiOutTimeMapper mapper;
+	const uint64_t latency = 20000; // 20ms
+
+	// The first message is sent after the latency.
+	CHECK(mapper.map(ms(1000), 5000000, latency) == 5020000);
+
+	// Messages of the same burst keep their relative timing.
+	CHECK(mapper.map(ms(1002), 5000100, latency) == 5022000);
+	CHECK(mapper.map(ms(1010), 5000200, latency) == 5030000);
+
+	// Host clock catches up, the mapping stays the same.
+	CHECK(mapper.map(ms(1030), 5025000, latency) == 5050000);
+
+	SECTION("emulation is too slow") {
+		// Target time already passed: resync.
+		CHECK(mapper.map(ms(1040), 5100000, latency) == 5120000);
+		CHECK(mapper.map(ms(1041), 5100000, latency) == 5121000);
+	}
+	SECTION("emulation is too fast") {
+		// More than latency + 100ms ahead: resync.
+		CHECK(mapper.map(ms(1200), 5030000, latency) == 5050000);
+		CHECK(mapper.map(ms(1201), 5030000, latency) == 5051000);
+	}
+	SECTION("order is preserved") {
+		// After a resync to an earlier host time, messages are not
+		// scheduled before the ones that were already sent.
+		CHECK(mapper.map(ms(1500), 5025000, latency) == 5050000);
+		CHECK(mapper.map(ms(1500), 5025000, 0) == 5050000);
+		CHECK(mapper.map(ms(1510), 5030000, 0) == 5050000);
+	}
+	SECTION("reset") {
+		mapper.reset();
+		CHECK(mapper.map(ms(1031), 5026000, latency) == 5050000);
+		CHECK(mapper.map(ms(1032), 5026000, latency) == 5050000);
+		CHECK(mapper.map(ms(1040), 5026000, latency) == 5055000);
+	}
+}
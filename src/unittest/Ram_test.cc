@@ -0,0 +1,42 @@
+#include "catch.hpp"
+#include "Ram.hh"
+#include "XMLElement.hh"
+#include "xrange.hh"
+
+using namespace openmsx;
+
+TEST_CASE("Ram")
+{
+	XMLElement xml("ram");
+
+	SECTION("small") {
+		Ram ram(xml, 0x100);
+		for (auto i : xrange(0x100)) CHECK(ram[i] == 0xFF);
+		ram[0x10] = 0x12;
+		CHECK(ram[0x10] == 0x12);
+		ram.clear(0x34);
+		for (auto i : xrange(0x100)) CHECK(ram[i] == 0x34);
+	}
+	SECTION("large") {
+		// Large memories are lazily committed (when possible), this
+		// should not be observable.
+		const unsigned SIZE = 0x100000;
+		Ram ram(xml, SIZE);
+		CHECK(ram[0] == 0xFF);
+		CHECK(ram[SIZE - 1] == 0xFF);
+		ram[0x1234] = 0x56;
+		CHECK(ram[0x1234] == 0x56);
+		CHECK(ram[0x1235] == 0xFF);
+
+		Ram ram2(xml, SIZE); // shares the pattern
+		CHECK(ram2[0x1234] == 0xFF);
+
+		ram.clear(0);
+		for (unsigned i = 0; i < SIZE; i += 0x800) CHECK(ram[i] == 0);
+		ram[0x5678] = 0x9A;
+		CHECK(ram[0x5678] == 0x9A);
+		ram.clear(0xFF);
+		CHECK(ram[0x5678] == 0xFF);
+		CHECK(ram2[0x5678] == 0xFF);
+	}
+}
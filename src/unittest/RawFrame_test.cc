@@ -0,0 +1,41 @@
+#include "catch.hpp"
+#include "RawFrame.hh"
+#include <SDL.h>
+#include <cstdint>
+
+using namespace openmsx;
+
+TEST_CASE("RawFrame: line hashes")
+{
+	SDL_PixelFormat format = {};
+	format.BitsPerPixel = 32;
+	format.BytesPerPixel = 4;
+	RawFrame frame1(format, 320, 4);
+	RawFrame frame2(format, 320, 4);
+
+	auto fill = [](RawFrame& frame, unsigned y, uint32_t color) {
+		auto* pixels = frame.getLinePtrDirect<uint32_t>(y);
+		for (unsigned x = 0; x < 320; ++x) pixels[x] = color;
+		frame.setLineWidth(y, 320);
+	};
+	for (unsigned y = 0; y < 4; ++y) {
+		fill(frame1, y, 0x123456);
+		fill(frame2, y, 0x123456);
+	}
+	for (unsigned y = 0; y < 4; ++y) {
+		CHECK(frame1.getLineHash(y) == frame2.getLineHash(y));
+	}
+
+	// modify a single pixel
+	uint32_t oldHash = frame2.getLineHash(1);
+	frame2.getLinePtrDirect<uint32_t>(1)[200] = 0x654321;
+	CHECK(frame2.getLineHash(1) != oldHash);
+	CHECK(frame2.getLineHash(1) != frame1.getLineHash(1));
+	CHECK(frame2.getLineHash(2) == frame1.getLineHash(2));
+
+	// blank line vs full line of the same color
+	frame2.setBlank(3, uint32_t(0x123456));
+	CHECK(frame2.getLineHash(3) != frame1.getLineHash(3));
+	frame1.setBlank(3, uint32_t(0x123456));
+	CHECK(frame2.getLineHash(3) == frame1.getLineHash(3));
+}
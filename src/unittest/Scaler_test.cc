@@ -0,0 +1,196 @@
+#include "catch.hpp"
+#include "RawFrame.hh"
+#include "PixelOperations.hh"
+#include "ScalerOutput.hh"
+#include "Scaler1.hh"
+#include "SaI2xScaler.hh"
+#include "Scale2xScaler.hh"
+#include "HQ2xScaler.hh"
+#include "HQ2xLiteScaler.hh"
+#include "MLAAScaler.hh"
+#include "SaI3xScaler.hh"
+#include "Scale3xScaler.hh"
+#include "HQ3xScaler.hh"
+#include "HQ3xLiteScaler.hh"
+#include "MemBuffer.hh"
+#include <SDL.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+using namespace openmsx;
+
+using Pixel = uint32_t;
+
+static SDL_PixelFormat getFormat()
+{
+	SDL_PixelFormat format = {};
+	format.BitsPerPixel = 32;
+	format.BytesPerPixel = 4;
+	format.Rmask = 0x00FF0000; format.Rshift = 16;
+	format.Gmask = 0x0000FF00; format.Gshift =  8;
+	format.Bmask = 0x000000FF; format.Bshift =  0;
+	return format;
+}
+
+// Scaler output that simply stores the scaled image in memory.
+class MemScalerOutput final : public ScalerOutput<Pixel>
+{
+public:
+	MemScalerOutput(unsigned width_, unsigned height_)
+		: buffer(width_ * height_), width(width_), height(height_) {}
+
+	unsigned getWidth()  const override { return width; }
+	unsigned getHeight() const override { return height; }
+	Pixel* acquireLine(unsigned y) override { return &buffer[y * width]; }
+	void releaseLine(unsigned /*y*/, Pixel* /*buf*/) override {}
+	void fillLine(unsigned y, Pixel color) override {
+		for (unsigned x = 0; x < width; ++x) buffer[y * width + x] = color;
+	}
+
+	MemBuffer<Pixel> buffer;
+	const unsigned width;
+	const unsigned height;
+};
+
+// The kind of image content a scaler gets to see for some typical MSX
+// display modes. The scalers only look at the pixels (not at the VDP state),
+// but their speed does depend on the amount of detail (edges) in the image.
+enum Content { TEXT, TILES, BITMAP };
+
+static void fillFrame(RawFrame& frame, unsigned width, Content content)
+{
+	static const Pixel palette[16] = {
+		0x000000, 0x000000, 0x24DA24, 0x6DFF6D, 0x2424FF, 0x486DFF,
+		0xB62424, 0x48DAFF, 0xFF2424, 0xFF6D6D, 0xDADA24, 0xDADA91,
+		0x249124, 0xDA48B6, 0xB6B6B6, 0xFFFFFF,
+	};
+	uint32_t state = 1;
+	auto random = [&] {
+		state = state * 1664525 + 1013904223;
+		return state >> 16;
+	};
+	for (unsigned y = 0; y < frame.getHeight(); ++y) {
+		auto* line = frame.getLinePtrDirect<Pixel>(y);
+		switch (content) {
+		case TEXT: {
+			// foreground/background, characters of 6 pixels wide
+			// with an empty line in between rows of characters
+			unsigned pattern = random();
+			for (unsigned x = 0; x < width; ++x) {
+				if ((x % 6) == 0) pattern = random();
+				bool fg = ((y & 7) != 7) && ((pattern >> (x % 6)) & 1);
+				line[x] = palette[fg ? 15 : 4];
+			}
+			break;
+		}
+		case TILES:
+			// 8x8 blocks of two colors from a 16 color palette
+			for (unsigned x = 0; x < width; x += 8) {
+				Pixel c0 = palette[(x / 8 + y / 8) & 15];
+				Pixel c1 = palette[(x / 8 * 3 + 5) & 15];
+				for (unsigned i = 0; i < 8; ++i) {
+					line[x + i] = ((x + y + i) & 2) ? c1 : c0;
+				}
+			}
+			break;
+		case BITMAP:
+			// horizontal runs of random length and color (256 colors)
+			for (unsigned x = 0; x < width; /**/) {
+				Pixel c = random() & 0xE0E0C0;
+				unsigned n = 1 + (random() & 7);
+				for (unsigned i = 0; i < n && x < width; ++i) {
+					line[x++] = c;
+				}
+			}
+			break;
+		}
+		frame.setLineWidth(y, width);
+	}
+}
+
+static void scaleFrame(Scaler<Pixel>& scaler, RawFrame& frame, unsigned width,
+                       MemScalerOutput& output)
+{
+	scaler.scaleImage(frame, nullptr, 0, frame.getHeight(), width,
+	                  output, 0, output.getHeight());
+}
+
+TEST_CASE("Scaler: constant image")
+{
+	// Every scaler must reproduce a single-color image exactly (for a color
+	// that survives the reduced precision of the hq scalers).
+	auto format = getFormat();
+	PixelOperations<Pixel> pixelOps(format);
+	RawFrame frame(format, 640, 240);
+	for (unsigned y = 0; y < 240; ++y) {
+		auto* line = frame.getLinePtrDirect<Pixel>(y);
+		for (unsigned x = 0; x < 320; ++x) line[x] = 0xFF00FF;
+		frame.setLineWidth(y, 320);
+	}
+
+	std::unique_ptr<Scaler<Pixel>> scalers[] = {
+		std::make_unique<Scale2xScaler <Pixel>>(pixelOps),
+		std::make_unique<HQ2xScaler    <Pixel>>(pixelOps),
+		std::make_unique<HQ2xLiteScaler<Pixel>>(pixelOps),
+		std::make_unique<SaI2xScaler   <Pixel>>(pixelOps),
+	};
+	for (auto& scaler : scalers) {
+		INFO("scaler " << (&scaler - &scalers[0]));
+		MemScalerOutput output(640, 480);
+		scaleFrame(*scaler, frame, 320, output);
+		unsigned wrong = 0;
+		for (unsigned i = 0; i < 640 * 480; ++i) {
+			if (output.buffer[i] != 0xFF00FF) ++wrong;
+		}
+		CHECK(wrong == 0);
+	}
+}
+
+// Not run by default, use:  unittest "[.benchmark]"
+// Reports the time to scale one (240 line) frame for each combination of
+// scaler, content and source width (320 for the 256 pixel wide display
+// modes, 640 for the 512 pixel wide modes, both including the border).
+TEST_CASE("Scaler benchmark", "[.benchmark]")
+{
+	auto format = getFormat();
+	PixelOperations<Pixel> pixelOps(format);
+
+	struct Entry {
+		const char* name;
+		unsigned factor;
+		std::unique_ptr<Scaler<Pixel>> scaler;
+	};
+	Entry entries[] = {
+		{ "1x",       1, std::make_unique<Scaler1       <Pixel>>(pixelOps) },
+		{ "scale2x",  2, std::make_unique<Scale2xScaler <Pixel>>(pixelOps) },
+		{ "sai2x",    2, std::make_unique<SaI2xScaler   <Pixel>>(pixelOps) },
+		{ "hq2x",     2, std::make_unique<HQ2xScaler    <Pixel>>(pixelOps) },
+		{ "hq2xlite", 2, std::make_unique<HQ2xLiteScaler<Pixel>>(pixelOps) },
+		{ "mlaa2x",   2, std::make_unique<MLAAScaler    <Pixel>>(640, pixelOps) },
+		{ "scale3x",  3, std::make_unique<Scale3xScaler <Pixel>>(pixelOps) },
+		{ "sai3x",    3, std::make_unique<SaI3xScaler   <Pixel>>(pixelOps) },
+		{ "hq3x",     3, std::make_unique<HQ3xScaler    <Pixel>>(pixelOps) },
+		{ "hq3xlite", 3, std::make_unique<HQ3xLiteScaler<Pixel>>(pixelOps) },
+	};
+	static const char* const contentNames[] = { "text", "tiles", "bitmap" };
+	static const int REPEAT = 100;
+
+	RawFrame frame(format, 640, 240);
+	for (unsigned width : {320, 640}) {
+		for (Content content : {TEXT, TILES, BITMAP}) {
+			fillFrame(frame, width, content);
+			for (auto& e : entries) {
+				MemScalerOutput output(320 * e.factor, 240 * e.factor);
+				BENCHMARK(std::string(e.name) + ' ' +
+				          contentNames[content] + ' ' +
+				          std::to_string(width) + " x" +
+				          std::to_string(REPEAT)) {
+					for (int r = 0; r < REPEAT; ++r) {
+						scaleFrame(*e.scaler, frame, width, output);
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,128 @@
+#include "catch.hpp"
+#include "Scanline.hh"
+#include "PixelOperations.hh"
+#include "MemBuffer.hh"
+#include "build-info.hh"
+#include <SDL.h>
+#include <cstdint>
+
+using namespace openmsx;
+
+// The SIMD versions of Scanline::draw() must give the same result as
+// this straightforward scalar code.
+#if HAVE_32BPP
+static uint32_t refDraw32(uint32_t p1, uint32_t p2, unsigned factor)
+{
+	uint32_t result = 0;
+	for (int shift = 0; shift < 32; shift += 8) {
+		unsigned c1 = (p1 >> shift) & 255;
+		unsigned c2 = (p2 >> shift) & 255;
+#if defined(__SSE2__) || defined(__ARM_NEON)
+		unsigned avg = (c1 + c2 + 1) / 2; // same as _mm_avg_epu8()
+#else
+		unsigned avg = (c1 + c2) / 2;
+#endif
+		result |= ((avg * factor) >> 8) << shift;
+	}
+	return result;
+}
+#endif
+
+#if HAVE_16BPP
+static uint16_t refDraw16(uint16_t p1, uint16_t p2, unsigned factor,
+                          const SDL_PixelFormat& format)
+{
+	uint16_t result = 0;
+	for (uint16_t mask : {uint16_t(format.Rmask), uint16_t(format.Gmask),
+	                      uint16_t(format.Bmask)}) {
+		unsigned c1 = p1 & mask;
+		unsigned c2 = p2 & mask;
+		// rounds down within the component, like avgDown()
+		unsigned avg = ((c1 + c2) / 2) & mask;
+		result |= ((avg * factor) >> 8) & mask;
+	}
+	return result;
+}
+#endif
+
+// Random pixels, only using the bits that are part of a color component.
+template<typename Pixel>
+static void fillLines(MemBuffer<Pixel, SSE2_ALIGNMENT>& in1,
+                      MemBuffer<Pixel, SSE2_ALIGNMENT>& in2, size_t width,
+                      Pixel mask)
+{
+	uint32_t state = 1;
+	auto random = [&] {
+		state = state * 1664525 + 1013904223;
+		return state >> 8;
+	};
+	for (size_t x = 0; x < width; ++x) {
+		in1[x] = Pixel(random()) & mask;
+		in2[x] = Pixel(random()) & mask;
+	}
+	// also some extreme values
+	in1[0] = 0;    in2[0] = mask;
+	in1[1] = mask; in2[1] = mask;
+}
+
+#if HAVE_32BPP
+TEST_CASE("Scanline: 32bpp")
+{
+	SDL_PixelFormat format = {};
+	format.BitsPerPixel = 32;
+	format.BytesPerPixel = 4;
+	format.Rmask = 0x00FF0000; format.Rshift = 16;
+	format.Gmask = 0x0000FF00; format.Gshift =  8;
+	format.Bmask = 0x000000FF; format.Bshift =  0;
+	PixelOperations<uint32_t> pixelOps(format);
+	Scanline<uint32_t> scanline(pixelOps);
+
+	for (size_t width : {320, 640, 960}) {
+		MemBuffer<uint32_t, SSE2_ALIGNMENT> in1(width), in2(width), out(width);
+		fillLines<uint32_t>(in1, in2, width, 0xFFFFFFFF);
+		for (unsigned factor : {0, 1, 100, 128, 200, 255}) {
+			scanline.draw(in1.data(), in2.data(), out.data(), factor, width);
+			unsigned errors = 0;
+			for (size_t x = 0; x < width; ++x) {
+				if (out[x] != refDraw32(in1[x], in2[x], factor)) ++errors;
+			}
+			CHECK(errors == 0);
+		}
+	}
+}
+#endif
+
+#if HAVE_16BPP
+TEST_CASE("Scanline: 16bpp")
+{
+	SDL_PixelFormat format = {};
+	format.BitsPerPixel = 16;
+	format.BytesPerPixel = 2;
+	SECTION("RGB565") {
+		format.Rmask = 0xF800; format.Rshift = 11; format.Rloss = 3;
+		format.Gmask = 0x07E0; format.Gshift =  5; format.Gloss = 2;
+		format.Bmask = 0x001F; format.Bshift =  0; format.Bloss = 3;
+	}
+	SECTION("BGR555") {
+		format.Rmask = 0x001F; format.Rshift =  0; format.Rloss = 3;
+		format.Gmask = 0x03E0; format.Gshift =  5; format.Gloss = 3;
+		format.Bmask = 0x7C00; format.Bshift = 10; format.Bloss = 3;
+	}
+	PixelOperations<uint16_t> pixelOps(format);
+	Scanline<uint16_t> scanline(pixelOps);
+
+	for (size_t width : {320, 640, 960}) {
+		MemBuffer<uint16_t, SSE2_ALIGNMENT> in1(width), in2(width), out(width);
+		fillLines<uint16_t>(in1, in2, width,
+			format.Rmask | format.Gmask | format.Bmask);
+		for (unsigned factor : {0, 1, 100, 128, 200, 255}) {
+			scanline.draw(in1.data(), in2.data(), out.data(), factor, width);
+			unsigned errors = 0;
+			for (size_t x = 0; x < width; ++x) {
+				if (out[x] != refDraw16(in1[x], in2[x], factor, format)) ++errors;
+			}
+			CHECK(errors == 0);
+		}
+	}
+}
+#endif
@@ -0,0 +1,121 @@
+#include "catch.hpp"
+#include "SchedulerQueue.hh"
+#include "SchedulerHeap.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+struct Item {
+	uint64_t time;
+	int id;
+};
+
+struct LessItem {
+	bool operator()(const Item& x, const Item& y) const {
+		return x.time < y.time;
+	}
+};
+
+static void setSentinel(Item& item) { item.time = uint64_t(-1); }
+
+// Simple pseudo random number generator, so that both queues (and each run)
+// see exactly the same sequence of operations.
+struct Lcg {
+	uint32_t operator()() {
+		state = state * 1664525 + 1013904223;
+		return state >> 8;
+	}
+	uint32_t state = 12345;
+};
+
+// Mimics the access pattern of the Scheduler: repeatedly take the earliest
+// sync point, 'execute' it and schedule a new one for the same device some
+// (device specific) time later. Sometimes a device cancels its pending sync
+// point and schedules a different one. Returns the order in which the items
+// were taken from the queue.
+template<typename Queue>
+static std::vector<int> simulate(Queue& queue, int numDevices, int steps)
+{
+	Lcg rnd;
+	std::vector<uint64_t> periods;
+	for (int i = 0; i < numDevices; ++i) {
+		// small range of periods, to have many equal times
+		periods.push_back(1 + rnd() % 16);
+		queue.insert(Item{periods.back(), i}, setSentinel, LessItem());
+	}
+
+	std::vector<int> result;
+	for (int step = 0; step < steps; ++step) {
+		Item item = queue.front();
+		queue.remove_front();
+		result.push_back(item.id);
+		queue.insert(Item{item.time + periods[item.id], item.id},
+		             setSentinel, LessItem());
+
+		if ((rnd() % 8) == 0) {
+			int id = rnd() % numDevices;
+			uint64_t time = 0;
+			for (auto& e : queue) {
+				if (e.id == id) time = e.time;
+			}
+			CHECK(queue.remove([&](const Item& e) { return e.id == id; }));
+			queue.insert(Item{time + rnd() % 4, id}, setSentinel, LessItem());
+		}
+	}
+	return result;
+}
+
+TEST_CASE("SchedulerQueue, SchedulerHeap")
+{
+	for (int numDevices : {1, 3, 10, 40}) {
+		SchedulerQueue<Item> queue;
+		SchedulerHeap<Item, LessItem> heap;
+		CHECK(simulate(queue, numDevices, 2000) ==
+		      simulate(heap,  numDevices, 2000));
+		CHECK(queue.size() == size_t(numDevices));
+		CHECK(heap .size() == size_t(numDevices));
+	}
+}
+
+TEST_CASE("SchedulerHeap, remove_all")
+{
+	SchedulerHeap<Item, LessItem> heap;
+	for (int i = 0; i < 100; ++i) {
+		heap.insert(Item{uint64_t((i * 37) % 50), i}, setSentinel, LessItem());
+	}
+	heap.remove_all([](const Item& e) { return (e.id % 3) == 0; });
+	CHECK(heap.size() == 66);
+
+	uint64_t prevTime = 0;
+	int prevId = -1;
+	while (!heap.empty()) {
+		auto& item = heap.front();
+		CHECK((item.id % 3) != 0);
+		CHECK(prevTime <= item.time);
+		if (prevTime == item.time) {
+			// equal times are returned in insertion order
+			CHECK(prevId < item.id);
+		}
+		prevTime = item.time;
+		prevId = item.id;
+		heap.remove_front();
+	}
+}
+
+// Not run by default, use:  unittest "[.benchmark]"
+TEST_CASE("SchedulerQueue, SchedulerHeap benchmark", "[.benchmark]")
+{
+	for (int numDevices : {8, 16, 32, 64}) {
+		INFO("devices: " << numDevices);
+		BENCHMARK("SchedulerQueue " + std::to_string(numDevices)) {
+			SchedulerQueue<Item> queue;
+			simulate(queue, numDevices, 1000000);
+		}
+		BENCHMARK("SchedulerHeap " + std::to_string(numDevices)) {
+			SchedulerHeap<Item, LessItem> heap;
+			simulate(heap, numDevices, 1000000);
+		}
+	}
+}
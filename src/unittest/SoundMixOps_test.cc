@@ -0,0 +1,168 @@
+#include "catch.hpp"
+#include "SoundMixOps.hh"
+#include "MemBuffer.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+using namespace openmsx::SoundMixOps;
+
+using Buffer = MemBuffer<float, SSE2_ALIGNMENT>;
+
+static Buffer randomBuffer(unsigned size, uint32_t& state)
+{
+	Buffer result(size);
+	for (unsigned i = 0; i < size; ++i) {
+		state = state * 1664525 + 1013904223;
+		result[i] = float(int32_t(state) >> 8) / (1 << 23);
+	}
+	return result;
+}
+
+static Buffer copyOf(const Buffer& buf, unsigned size)
+{
+	Buffer result(size);
+	for (unsigned i = 0; i < size; ++i) result[i] = buf[i];
+	return result;
+}
+
+static void checkEqual(const Buffer& x, const Buffer& y, unsigned size)
+{
+	for (unsigned i = 0; i < size; ++i) {
+		INFO("index " << i);
+		REQUIRE(x[i] == Approx(y[i]));
+	}
+}
+
+// Test all sizes upto a few times the (SSE) group size, so that all the
+// head/tail handling code gets exercised.
+TEST_CASE("SoundMixOps: volume")
+{
+	uint32_t state = 1;
+	const float l1 = 0.75f, l2 = -0.25f, r1 = 0.5f, r2 = 1.5f;
+	for (int n = 1; n < 20; ++n) {
+		INFO("n = " << n);
+		unsigned size = 2 * n + 8;
+		auto in  = randomBuffer(size, state);
+		auto acc = randomBuffer(size, state);
+
+		auto buf = copyOf(in, size);
+		mulExpand(buf.data(), n, l1, r1);
+		auto ref = copyOf(in, size);
+		for (int i = 0; i < n; ++i) {
+			ref[2 * i + 0] = l1 * in[i];
+			ref[2 * i + 1] = r1 * in[i];
+		}
+		checkEqual(buf, ref, 2 * n);
+
+		buf = copyOf(acc, size);
+		mulExpandAcc(buf.data(), in.data(), n, l1, r1);
+		ref = copyOf(acc, size);
+		for (int i = 0; i < n; ++i) {
+			ref[2 * i + 0] += l1 * in[i];
+			ref[2 * i + 1] += r1 * in[i];
+		}
+		checkEqual(buf, ref, 2 * n);
+
+		buf = copyOf(in, size);
+		mulMix2(buf.data(), n, l1, l2, r1, r2);
+		ref = copyOf(in, size);
+		for (int i = 0; i < n; ++i) {
+			ref[2 * i + 0] = l1 * in[2 * i] + l2 * in[2 * i + 1];
+			ref[2 * i + 1] = r1 * in[2 * i] + r2 * in[2 * i + 1];
+		}
+		checkEqual(buf, ref, 2 * n);
+
+		buf = copyOf(acc, size);
+		mulMix2Acc(buf.data(), in.data(), n, l1, l2, r1, r2);
+		ref = copyOf(acc, size);
+		for (int i = 0; i < n; ++i) {
+			ref[2 * i + 0] += l1 * in[2 * i] + l2 * in[2 * i + 1];
+			ref[2 * i + 1] += r1 * in[2 * i] + r2 * in[2 * i + 1];
+		}
+		checkEqual(buf, ref, 2 * n);
+	}
+}
+
+TEST_CASE("SoundMixOps: channels")
+{
+	uint32_t state = 2;
+	const int balance[] = { 0, -1, 1, 0, 1, -1, -1 };
+	for (unsigned num = 1; num <= 7; ++num) {
+		for (unsigned n = 1; n < 20; ++n) {
+			INFO("num = " << num << ", n = " << n);
+			unsigned pitch = (n + 3) & ~3;
+			std::vector<Buffer> channels;
+			std::vector<float*> bufs;
+			for (unsigned j = 0; j < num; ++j) {
+				channels.push_back(randomBuffer(pitch, state));
+				bufs.push_back(channels.back().data());
+			}
+
+			auto out = randomBuffer(pitch, state);
+			auto ref = copyOf(out, pitch);
+			sumChannels(out.data(), bufs.data(), num, n);
+			for (unsigned i = 0; i < n; ++i) {
+				for (unsigned j = 0; j < num; ++j) {
+					ref[i] += bufs[j][i];
+				}
+			}
+			checkEqual(out, ref, n);
+
+			Buffer stereo(2 * pitch);
+			mixBalance(stereo.data(), bufs.data(), balance, num, n);
+			for (unsigned i = 0; i < n; ++i) {
+				float left = 0.0f, right = 0.0f;
+				for (unsigned j = 0; j < num; ++j) {
+					if (balance[j] <= 0) left  += bufs[j][i];
+					if (balance[j] >= 0) right += bufs[j][i];
+				}
+				CHECK(stereo[2 * i + 0] == Approx(left));
+				CHECK(stereo[2 * i + 1] == Approx(right));
+			}
+		}
+	}
+}
+
+// Not run by default, use:  unittest "[.benchmark]"
+TEST_CASE("SoundMixOps benchmark", "[.benchmark]")
+{
+	static const unsigned N = 2048; // stereo samples per buffer
+	static const int REPEAT = 10000;
+	uint32_t state = 3;
+	auto in  = randomBuffer(2 * N, state);
+	auto acc = randomBuffer(2 * N, state);
+
+	BENCHMARK("mulExpandAcc") {
+		for (int r = 0; r < REPEAT; ++r) {
+			mulExpandAcc(acc.data(), in.data(), N, 0.5f, 0.25f);
+		}
+	}
+	BENCHMARK("mulMix2Acc") {
+		for (int r = 0; r < REPEAT; ++r) {
+			mulMix2Acc(acc.data(), in.data(), N, 0.5f, 0.25f, 0.1f, 0.7f);
+		}
+	}
+
+	for (unsigned num : {2, 3, 9}) {
+		std::vector<Buffer> channels;
+		std::vector<float*> bufs;
+		std::vector<int> balance;
+		for (unsigned j = 0; j < num; ++j) {
+			channels.push_back(randomBuffer(N, state));
+			bufs.push_back(channels.back().data());
+			balance.push_back(int(j % 3) - 1);
+		}
+		BENCHMARK("sumChannels " + std::to_string(num)) {
+			for (int r = 0; r < REPEAT; ++r) {
+				sumChannels(acc.data(), bufs.data(), num, N);
+			}
+		}
+		BENCHMARK("mixBalance " + std::to_string(num)) {
+			for (int r = 0; r < REPEAT; ++r) {
+				mixBalance(acc.data(), bufs.data(), balance.data(), num, N);
+			}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+#include "StepChannel.hh"
+#include "BlipBuffer.hh"
+#include <cstdint>
+#include <vector>
+
+using namespace openmsx;
+
+using FP = StepChannel::FP;
+
+// Runs of equal samples: {value, length}
+struct Run { float value; unsigned num; };
+
+static std::vector<Run> makeRuns()
+{
+	std::vector<Run> result;
+	uint32_t state = 12345;
+	for (int i = 0; i < 200; ++i) {
+		state = state * 1664525 + 1013904223;
+		float value = float((state >> 8) % 16) / 16.0f;
+		unsigned num = 1 + (state >> 24) % 20;
+		result.push_back({value, num});
+	}
+	return result;
+}
+
+TEST_CASE("StepChannel")
+{
+	auto runs = makeRuns();
+	FP step = FP::roundRatioDown(44100, 111861);
+	FP pos1 = FP(0.25);
+
+	// reference: per sample, like ResampleBlip does
+	BlipBuffer ref;
+	{
+		FP pos = pos1;
+		float last = 0.0f;
+		for (auto& r : runs) {
+			for (unsigned i = 0; i < r.num; ++i) {
+				if (r.value != last) {
+					ref.addDelta(BlipBuffer::TimeIndex(pos),
+					             r.value - last);
+					last = r.value;
+				}
+				pos += step;
+			}
+		}
+	}
+
+	// same input, but via (two) channels that each produce a part
+	BlipBuffer blip;
+	StepChannel ch[2];
+	ch[0].start(blip, pos1, step);
+	ch[1].start(blip, pos1, step);
+	for (auto& r : runs) {
+		// split the value over the two channels
+		ch[0].fill(r.value * 0.5f, r.num);
+		ch[1].fill(r.value * 0.5f, r.num);
+	}
+	CHECK(ch[0].getLast() + ch[1].getLast() == runs.back().value);
+
+	unsigned total = 0;
+	for (auto& r : runs) total += r.num;
+	unsigned hostNum = unsigned((FP(total) * step).toInt());
+
+	std::vector<float> out1(hostNum), out2(hostNum);
+	REQUIRE(ref .readSamples<1>(out1.data(), hostNum));
+	REQUIRE(blip.readSamples<1>(out2.data(), hostNum));
+	for (unsigned i = 0; i < hostNum; ++i) {
+		CHECK(out2[i] == Approx(out1[i]).margin(1e-5));
+	}
+}
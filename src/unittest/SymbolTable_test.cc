@@ -0,0 +1,52 @@
+#include "catch.hpp"
+#include "SymbolTable.hh"
+
+using namespace openmsx;
+
+TEST_CASE("SymbolTable")
+{
+	SymbolTable table;
+	CHECK(table.empty());
+	CHECK(table.lookup(0x1234) == nullptr);
+
+	unsigned num = table.parse(
+		"; generated by some assembler\n"
+		"CHPUT: equ 0x00A2\n"
+		"init:\tEQU\t4010h ; comment\n"
+		"main %equ $4100\r\n"
+		"loop equ #4123\n"
+		"count equ 42\n"
+		"not a symbol\n"
+		"big: equ 0x12345\n"
+		"bad: equ 12xy\n"
+		"Label: EQU 0x00004200\n");
+	CHECK(num == 6);
+	CHECK(!table.empty());
+
+	auto check = [&](uint16_t addr, const char* name, uint16_t symAddr) {
+		INFO("address " << addr);
+		auto* sym = table.lookup(addr);
+		REQUIRE(sym != nullptr);
+		CHECK(sym->name == name);
+		CHECK(sym->address == symAddr);
+	};
+	CHECK(table.lookup(0x0029) == nullptr);
+	check(0x002A, "count", 0x002A);
+	check(0x00A1, "count", 0x002A);
+	check(0x00A2, "CHPUT", 0x00A2);
+	check(0x4010, "init",  0x4010);
+	check(0x40FF, "init",  0x4010);
+	check(0x4100, "main",  0x4100);
+	check(0x4123, "loop",  0x4123);
+	check(0x4200, "Label", 0x4200);
+	check(0xFFFF, "Label", 0x4200);
+
+	// symbols are added to the existing ones
+	CHECK(table.parse("high: equ 0xC000\n") == 1);
+	check(0xC001, "high", 0xC000);
+	check(0x4200, "Label", 0x4200);
+
+	table.clear();
+	CHECK(table.empty());
+	CHECK(table.lookup(0xC001) == nullptr);
+}
@@ -177,6 +177,25 @@ TEST_CASE("TclObject, operator=")
 	}
 }
 
+TEST_CASE("TclObject, small integers")
+{
+	// Small integers share a cached Tcl_Obj, modifying one TclObject must
+	// not affect the others.
+	Interpreter interp;
+	TclObject t1(7);
+	TclObject t2(7);
+	CHECK(t1.getTclObject() == t2.getTclObject());
+	t1 = 8;
+	CHECK(t1.getString() == "8");
+	CHECK(t2.getString() == "7");
+	t2.addListElement(9);
+	CHECK(t2.getString() == "7 9");
+	CHECK(TclObject(7).getString() == "7");
+	CHECK(TclObject(255u).getString() == "255");
+	CHECK(TclObject(256).getString() == "256");
+	CHECK(TclObject(-1).getString() == "-1");
+}
+
 TEST_CASE("TclObject, addListElement")
 {
 	Interpreter interp;
@@ -2,6 +2,7 @@
 #include "TigerTree.hh"
 #include "tiger.hh"
 #include <cstring>
+#include <vector>
 
 using namespace openmsx;
 
@@ -79,3 +80,49 @@ TEST_CASE("TigerTree")
 		       "SJUYB3QVIJXNKZMSQZGIMHA7GA2MYU2UECDA26A");
 	}
 }
+
+// Straightforward (non-incremental) calculation, for data that consists of
+// only full blocks.
+static TigerHash referenceHash(uint8_t* buffer, size_t numBlocks)
+{
+	std::vector<TigerHash> level(numBlocks);
+	for (size_t i = 0; i < numBlocks; ++i) {
+		tiger_leaf(buffer + 1024 * i, level[i]);
+	}
+	while (level.size() > 1) {
+		std::vector<TigerHash> next((level.size() + 1) / 2);
+		for (size_t i = 0; i + 1 < level.size(); i += 2) {
+			tiger_int(level[i], level[i + 1], next[i / 2]);
+		}
+		if (level.size() & 1) next.back() = level.back();
+		level.swap(next);
+	}
+	return level[0];
+}
+
+TEST_CASE("TigerTree, many blocks")
+{
+	// large enough to hash the leaf blocks in parallel
+	static const size_t NUM_BLOCKS = 1500;
+	std::vector<uint8_t> buffer_(NUM_BLOCKS * 1024 + 1);
+	uint8_t* buffer = buffer_.data() + 1;
+	uint32_t x = 1;
+	for (size_t i = 0; i < NUM_BLOCKS * 1024; ++i) {
+		x = x * 1664525 + 1013904223;
+		buffer[i] = uint8_t(x >> 24);
+	}
+	TTTestData data;
+	data.buffer = buffer;
+	auto dummyCallback = [](size_t, size_t) {};
+
+	TigerTree tt(data, NUM_BLOCKS * 1024, "many blocks");
+	CHECK(tt.calcHash(dummyCallback).toString() ==
+	      referenceHash(buffer, NUM_BLOCKS).toString());
+
+	memset(buffer + 5000, 1, 100);
+	tt.notifyChange(5000, 100, 0); // a single block
+	memset(buffer + 200 * 1024, 2, 300 * 1024);
+	tt.notifyChange(200 * 1024, 300 * 1024, 0); // many blocks
+	CHECK(tt.calcHash(dummyCallback).toString() ==
+	      referenceHash(buffer, NUM_BLOCKS).toString());
+}
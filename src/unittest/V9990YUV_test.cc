@@ -0,0 +1,49 @@
+#include "catch.hpp"
+#include "V9990YUV.hh"
+
+using namespace openmsx;
+using namespace openmsx::V9990YUV;
+
+template<bool YJK> static void test()
+{
+	// Each pixel only depends on its own byte and on the low 3 bits of the
+	// 4 bytes in its group. Try all those combinations in both groups.
+	unsigned errors = 0;
+	for (int pos = 0; pos < 4; ++pos) {
+		for (unsigned value = 0; value < 256; ++value) {
+			for (unsigned low = 0; low < 512; ++low) {
+				uint8_t data[8];
+				int bit = 0;
+				for (int i = 0; i < 4; ++i) {
+					if (i == pos) {
+						data[i] = value;
+					} else {
+						data[i] = 0xA8 | ((low >> bit) & 7);
+						bit += 3;
+					}
+					data[7 - i] = data[i] ^ 0x55;
+				}
+				uint16_t expected[8], actual[8];
+				for (int i = 0; i < 8; i += 4) {
+					int u = getU(&data[i]);
+					int v = getV(&data[i]);
+					for (int j = 0; j < 4; ++j) {
+						expected[i + j] = toColor15<YJK>(
+							(data[i + j] & 0xF8) >> 3, u, v);
+					}
+				}
+				convert8<YJK>(data, actual);
+				for (int i = 0; i < 8; ++i) {
+					if (actual[i] != expected[i]) ++errors;
+				}
+			}
+		}
+	}
+	CHECK(errors == 0);
+}
+
+TEST_CASE("V9990YUV: convert8")
+{
+	SECTION("YUV") { test<false>(); }
+	SECTION("YJK") { test<true>(); }
+}
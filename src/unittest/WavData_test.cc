@@ -174,3 +174,25 @@ TEST_CASE("WavData, content")
 		CHECK(wav.getSample(4) ==  0); // past end
 	}
 }
+
+TEST_CASE("WavData, parseFormat")
+{
+	// same content as "stereo, 8 bit", but with an extra chunk
+	uint8_t buffer[] = {
+		'R', 'I', 'F', 'F',  0x04,0x05,0x06,0x07, 'W', 'A', 'V', 'E',  'f', 'm', 't' ,' ',
+		0x10,0x00,0x00,0x00, 0x01,0x00,0x02,0x00, 0x44,0xac,0x00,0x00, 0x44,0xac,0x00,0x00,
+		0x02,0x00,0x08,0x00,
+		'L', 'I', 'S', 'T',  0x02,0x00,0x00,0x00, 0x12,0x34,
+		'd', 'a', 't', 'a',  0x08,0x00,0x00,0x00,
+		0x00,0xff, 0x40,0xef, 0x80,0xdf, 0xc0,0xcf
+	};
+	auto format = WavData::parseFormat(buffer);
+	CHECK(format.freq == 44100);
+	CHECK(format.bits == 8);
+	CHECK(format.channels == 2);
+	CHECK(format.length == 4);
+	CHECK(format.dataOffset == 54);
+	CHECK(WavData::getRawSample(format, buffer, 0) == -0x8000);
+	CHECK(WavData::getRawSample(format, buffer, 1) == -0x4000);
+	CHECK(WavData::getRawSample(format, buffer, 3) ==  0x4000);
+}
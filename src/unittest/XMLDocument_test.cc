@@ -0,0 +1,101 @@
+#include "catch.hpp"
+#include "XMLDocument.hh"
+#include "XMLElement.hh"
+#include "XMLException.hh"
+#include "rapidsax.hh"
+#include <cstring>
+
+using namespace openmsx;
+
+static void parse(XMLDocument& doc, const char* text)
+{
+	auto len = strlen(text);
+	MemBuffer<char> buf(len + rapidsax::EXTRA_BUFFER_SPACE);
+	memcpy(buf.data(), text, len + 1);
+	doc.parse(std::move(buf));
+}
+
+TEST_CASE("XMLDocument: structure")
+{
+	XMLDocument doc;
+	parse(doc, "<!DOCTYPE a SYSTEM \"test.dtd\">"
+	           "<a x=\"1\" y=\"&lt;2\"><b>one</b><c/><b> two </b></a>");
+	CHECK(doc.getSystemID() == "test.dtd");
+
+	auto* root = doc.getRoot();
+	REQUIRE(root);
+	CHECK(root->getName() == "a");
+	CHECK(root->numChildren() == 3);
+	REQUIRE(root->findAttribute("y"));
+	CHECK(*root->findAttribute("y") == "<2");
+	CHECK(!root->findAttribute("z"));
+	unsigned x = 0;
+	CHECK(root->findAttributeInt("x", x));
+	CHECK(x == 1);
+
+	auto* b = root->getFirstChild();
+	REQUIRE(b);
+	CHECK(b->getName() == "b");
+	CHECK(b->getData() == "one");
+	CHECK(!b->hasChildren());
+	auto* c = b->getNextSibling();
+	REQUIRE(c);
+	CHECK(c->getName() == "c");
+	CHECK(c->getData().empty());
+	auto* b2 = c->getNextSibling();
+	REQUIRE(b2);
+	CHECK(b2->getData() == "two"); // whitespace is trimmed
+	CHECK(!b2->getNextSibling());
+}
+
+TEST_CASE("XMLDocument: findNextChild")
+{
+	XMLDocument doc;
+	parse(doc, "<a><b>1</b><c>2</c><b>3</b></a>");
+	auto* root = doc.getRoot();
+	auto* from = root->getFirstChild();
+	CHECK(root->findNextChild("b", from)->getData() == "1");
+	CHECK(root->findNextChild("b", from)->getData() == "3");
+	CHECK(from == nullptr);
+	CHECK(root->findNextChild("b", from)->getData() == "1"); // wraps
+	CHECK(root->findNextChild("c", from)->getData() == "2");
+	CHECK(root->findNextChild("d", from) == nullptr);
+}
+
+TEST_CASE("XMLDocument: many nodes")
+{
+	// more nodes than fit in the first arena block
+	std::string text = "<a>";
+	for (int i = 0; i < 10000; ++i) text += "<b x=\"1\"/>";
+	text += "</a>";
+	XMLDocument doc;
+	parse(doc, text.c_str());
+	CHECK(doc.getRoot()->numChildren() == 10000);
+	unsigned count = 0;
+	for (auto* c = doc.getRoot()->getFirstChild(); c; c = c->getNextSibling()) {
+		count += (c->getName() == "b") && c->findAttribute("x");
+	}
+	CHECK(count == 10000);
+}
+
+TEST_CASE("XMLDocument: errors")
+{
+	XMLDocument doc1;
+	CHECK_THROWS_AS(parse(doc1, "<a x=\"1\" x=\"2\"/>"), XMLException);
+	XMLDocument doc2;
+	CHECK_THROWS_AS(parse(doc2, "<a><b/>text</a>"), XMLException);
+	XMLDocument doc3;
+	CHECK_THROWS_AS(parse(doc3, "<a><b></a>"), rapidsax::ParseError);
+}
+
+TEST_CASE("XMLDocument: convert to XMLElement")
+{
+	XMLDocument doc;
+	parse(doc, "<a x=\"1\"><b>one</b><c y=\"2\"/></a>");
+	XMLElement elem(*doc.getRoot());
+	CHECK(elem.getName() == "a");
+	CHECK(elem.getAttribute("x") == "1");
+	REQUIRE(elem.getChildren().size() == 2);
+	CHECK(elem.getChildData("b") == "one");
+	CHECK(elem.getChild("c").getAttribute("y") == "2");
+}
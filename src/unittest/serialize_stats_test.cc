@@ -0,0 +1,40 @@
+#include "catch.hpp"
+#include "serialize_stats.hh"
+
+using namespace openmsx;
+
+TEST_CASE("SerializeStats")
+{
+	SerializeStats stats;
+	stats.beginPart("machine", 0);
+	stats.beginPart("cpu", 10);
+	stats.endPart(30);
+	stats.beginPart("config", 30);
+	stats.beginPart("RAM", 40);
+	stats.addBlob(1000);
+	stats.endPart(45);
+	stats.endPart(50);
+	stats.beginPart("cpu", 50); // same name is merged
+	stats.endPart(52);
+	stats.endPart(60);
+
+	auto& entries = stats.getEntries();
+	REQUIRE(entries.size() == 4);
+	CHECK(entries[0].name == "machine");
+	CHECK(entries[0].bytes == 18); // nested parts not included
+	CHECK(entries[1].name == "cpu");
+	CHECK(entries[1].bytes == 22);
+	CHECK(entries[2].name == "config");
+	CHECK(entries[2].bytes == 15);
+	CHECK(entries[2].blobs == 0);
+	CHECK(entries[3].name == "RAM");
+	CHECK(entries[3].bytes == 5);
+	CHECK(entries[3].blobs == 1);
+	CHECK(entries[3].blobBytes == 1000);
+
+	// sorted on total size
+	CHECK(stats.format().substr(0, 4) == "RAM:");
+
+	stats.clear();
+	CHECK(stats.getEntries().empty());
+}
@@ -1,6 +1,8 @@
 #include "catch.hpp"
 #include "sha1.hh"
+#include <algorithm>
 #include <sstream>
+#include <vector>
 
 using namespace openmsx;
 
@@ -131,3 +133,35 @@ TEST_CASE("sha1: update,digest")
 		CHECK(sum.toString() == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
 	}
 }
+
+TEST_CASE("sha1: buffer sizes and alignment")
+{
+	// Feed the same data in various chunk sizes and at various alignments,
+	// this exercises both the partial and the multi-block code paths.
+	std::vector<uint8_t> data(5000 + 64);
+	for (size_t i = 0; i < data.size(); ++i) data[i] = uint8_t(i * 7 + (i >> 8));
+	for (size_t offset : {0, 1, 3}) {
+		const uint8_t* p = &data[offset];
+		Sha1Sum expected = SHA1::calc(p, 5000);
+		for (size_t chunk : {1, 13, 63, 64, 65, 200, 1024, 5000}) {
+			INFO("offset " << offset << " chunk " << chunk);
+			SHA1 sha1;
+			for (size_t i = 0; i < 5000; i += chunk) {
+				sha1.update(p + i, std::min(chunk, 5000 - i));
+			}
+			CHECK(sha1.digest() == expected);
+		}
+	}
+	CHECK(SHA1::calc(data.data(), 5000).toString() ==
+	      "d24a12e5f523e404dad2296f9023bd868e2b1e1e");
+}
+
+// Not run by default, use:  unittest "[.benchmark]"
+TEST_CASE("sha1: benchmark", "[.benchmark]")
+{
+	std::vector<uint8_t> data(16 * 1024 * 1024);
+	for (size_t i = 0; i < data.size(); ++i) data[i] = uint8_t(i);
+	BENCHMARK("sha1 16MB") {
+		SHA1::calc(data.data(), data.size());
+	}
+}
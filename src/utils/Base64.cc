@@ -1,7 +1,12 @@
 #include "Base64.hh"
+#include "Math.hh"
 #include "likely.hh"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace Base64 {
 
@@ -35,6 +40,95 @@ static inline uint8_t decode(uint8_t c)
 	}
 }
 
+#ifdef __SSE2__
+// Encode 12 input bytes (reads 13) into 16 characters.
+static inline void encodeSSE2(const uint8_t* input, char* output)
+{
+	// One group of 3 bytes per 32-bit lane: x = b0 | b1 << 8 | b2 << 16.
+	uint32_t g[4];
+	for (int i = 0; i < 4; ++i) memcpy(&g[i], input + 3 * i, 4);
+	__m128i x = _mm_set_epi32(g[3], g[2], g[1], g[0]);
+
+	// Spread the 24 bits over 4 bytes of 6 bits, in output order.
+	auto m = [](int v) { return _mm_set1_epi32(v); };
+	__m128i v = _mm_or_si128(
+		_mm_or_si128(
+			_mm_and_si128(_mm_srli_epi32(x,  2), m(0x0000003F)),
+			_mm_or_si128(
+				_mm_and_si128(_mm_slli_epi32(x, 12), m(0x00003000)),
+				_mm_and_si128(_mm_srli_epi32(x,  4), m(0x00000F00)))),
+		_mm_or_si128(
+			_mm_or_si128(
+				_mm_and_si128(_mm_slli_epi32(x, 10), m(0x003C0000)),
+				_mm_and_si128(_mm_srli_epi32(x,  6), m(0x00030000))),
+			_mm_and_si128(_mm_slli_epi32(x,  8), m(0x3F000000))));
+
+	// Translate 0..63 to the base64 alphabet, see encode(uint8_t) above.
+	auto b = [](char c) { return _mm_set1_epi8(c); };
+	__m128i off = b(65);
+	off = _mm_add_epi8(off, _mm_and_si128(_mm_cmpgt_epi8(v, b(25)), b(  6)));
+	off = _mm_add_epi8(off, _mm_and_si128(_mm_cmpgt_epi8(v, b(51)), b(-75)));
+	off = _mm_add_epi8(off, _mm_and_si128(_mm_cmpgt_epi8(v, b(61)), b(-15)));
+	off = _mm_add_epi8(off, _mm_and_si128(_mm_cmpgt_epi8(v, b(62)), b(  3)));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_add_epi8(v, off));
+}
+
+// Decode 16 characters into 12 output bytes (writes 14). Returns false
+// (without writing anything) when not all characters are base64 digits,
+// 'numValid' is then the number of leading digits.
+static inline bool decodeSSE2(const char* input, uint8_t* output,
+                              unsigned& numValid)
+{
+	auto b = [](char c) { return _mm_set1_epi8(c); };
+	auto inRange = [&](__m128i x, char lo, char hi) {
+		return _mm_and_si128(_mm_cmpgt_epi8(x, b(lo - 1)),
+		                     _mm_cmplt_epi8(x, b(hi + 1)));
+	};
+	__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+	__m128i upper = inRange(c, 'A', 'Z');
+	__m128i lower = inRange(c, 'a', 'z');
+	__m128i digit = inRange(c, '0', '9');
+	__m128i plus  = _mm_cmpeq_epi8(c, b('+'));
+	__m128i slash = _mm_cmpeq_epi8(c, b('/'));
+	__m128i valid = _mm_or_si128(_mm_or_si128(upper, lower),
+	                             _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+	unsigned mask = _mm_movemask_epi8(valid);
+	if (mask != 0xFFFF) {
+		numValid = Math::findFirstSet(~mask) - 1;
+		return false;
+	}
+
+	// Translate to 0..63, see decode(uint8_t) above.
+	__m128i off = _mm_or_si128(
+		_mm_or_si128(_mm_and_si128(upper, b(-65)), _mm_and_si128(lower, b(-71))),
+		_mm_or_si128(_mm_and_si128(digit, b(  4)),
+		             _mm_or_si128(_mm_and_si128(plus,  b(19)),
+		                          _mm_and_si128(slash, b(16)))));
+	__m128i v = _mm_add_epi8(c, off);
+
+	// Combine pairs of 6 bits into 12 bits, then pairs of those into 24
+	// bits: w = a << 18 | b << 12 | c << 6 | d in each 32-bit lane.
+	__m128i pairs = _mm_or_si128(
+		_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00FF)), 6),
+		_mm_srli_epi16(v, 8));
+	__m128i w = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+	// Swap bytes 0 and 2, so that the bytes are in memory order.
+	w = _mm_or_si128(
+		_mm_or_si128(_mm_and_si128(_mm_slli_epi32(w, 16), _mm_set1_epi32(0xFF0000)),
+		             _mm_and_si128(w, _mm_set1_epi32(0x00FF00))),
+		_mm_and_si128(_mm_srli_epi32(w, 16), _mm_set1_epi32(0x0000FF)));
+	// Remove the empty 4th byte of each lane: 6 bytes per 64-bit half.
+	__m128i r = _mm_or_si128(
+		_mm_and_si128(w, _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF)),
+		_mm_and_si128(_mm_srli_epi64(w, 8),
+		              _mm_set_epi32(0xFFFF, 0xFF000000, 0xFFFF, 0xFF000000)));
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(output + 0), r);
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(output + 6),
+	                 _mm_unpackhi_epi64(r, r));
+	return true;
+}
+#endif
+
 string encode(const uint8_t* input, size_t inSize)
 {
 	static const int CHUNKS = 19;
@@ -49,6 +143,14 @@ string encode(const uint8_t* input, size_t inSize)
 		if (out) ret[out++] = '\n';
 		auto n2 = std::min<size_t>(IN_CHUNKS, inSize);
 		auto n = unsigned(n2);
+#ifdef __SSE2__
+		// 4 blocks of 12 bytes per line, encodeSSE2() reads 1 byte more
+		for (/**/; (n >= 12) && (inSize - (n2 - n)) >= 13; n -= 12) {
+			encodeSSE2(input, &ret[out]);
+			input += 12;
+			out += 16;
+		}
+#endif
 		for (/**/; n >= 3; n -= 3) {
 			ret[out++] = encode( (input[0] & 0xfc) >> 2);
 			ret[out++] = encode(((input[0] & 0x03) << 4) +
@@ -85,23 +187,42 @@ string encode(const uint8_t* input, size_t inSize)
 	return ret;
 }
 
-std::pair<MemBuffer<uint8_t>, size_t> decode(string_view input)
+// Decode at most 'outSize' bytes. Returns the number of decoded bytes, or
+// a number bigger than 'outSize' when the input decodes to more bytes.
+static size_t decode(string_view input, uint8_t* output, size_t outSize)
 {
-	auto outSize = (input.size() * 3 + 3) / 4; // overestimation
-	MemBuffer<uint8_t> ret(outSize); // too big
-
 	unsigned i = 0;
 	size_t out = 0;
 	uint8_t buf4[4];
-	for (auto c : input) {
-		uint8_t d = decode(c);
+	const char* p = input.data();
+	const char* end = p + input.size();
+#ifdef __SSE2__
+	const char* scalarUntil = p; // no SIMD before this position
+#endif
+	while (p != end) {
+#ifdef __SSE2__
+		// Between the newlines there are blocks of 16 valid characters.
+		while ((i == 0) && (p >= scalarUntil) && ((end - p) >= 16) &&
+		       ((out + 16) <= outSize)) {
+			unsigned numValid;
+			if (!decodeSSE2(p, output + out, numValid)) {
+				scalarUntil = p + numValid + 1;
+				break;
+			}
+			p += 16;
+			out += 12;
+		}
+		if (p == end) break;
+#endif
+		uint8_t d = decode(*p++);
 		if (d == uint8_t(-1)) continue;
 		buf4[i++] = d;
 		if (i == 4) {
 			i = 0;
-			ret[out++] = char(((buf4[0] & 0xff) << 2) + ((buf4[1] & 0x30) >> 4));
-			ret[out++] = char(((buf4[1] & 0x0f) << 4) + ((buf4[2] & 0x3c) >> 2));
-			ret[out++] = char(((buf4[2] & 0x03) << 6) + ((buf4[3] & 0xff) >> 0));
+			if (unlikely((out + 3) > outSize)) return outSize + 1;
+			output[out++] = char(((buf4[0] & 0xff) << 2) + ((buf4[1] & 0x30) >> 4));
+			output[out++] = char(((buf4[1] & 0x0f) << 4) + ((buf4[2] & 0x3c) >> 2));
+			output[out++] = char(((buf4[2] & 0x03) << 6) + ((buf4[3] & 0xff) >> 0));
 		}
 	}
 	if (i) {
@@ -113,10 +234,18 @@ std::pair<MemBuffer<uint8_t>, size_t> decode(string_view input)
 		buf3[1] = ((buf4[1] & 0x0f) << 4) + ((buf4[2] & 0x3c) >> 2);
 		buf3[2] = ((buf4[2] & 0x03) << 6) + ((buf4[3] & 0xff) >> 0);
 		for (unsigned j = 0; (j < i - 1); ++j) {
-			ret[out++] = buf3[j];
+			if (unlikely(out == outSize)) return outSize + 1;
+			output[out++] = buf3[j];
 		}
 	}
+	return out;
+}
 
+std::pair<MemBuffer<uint8_t>, size_t> decode(string_view input)
+{
+	auto outSize = (input.size() * 3 + 3) / 4; // overestimation
+	MemBuffer<uint8_t> ret(outSize); // too big
+	size_t out = decode(input, ret.data(), outSize);
 	assert(outSize >= out);
 	ret.resize(out); // shrink to correct size
 	return std::make_pair(std::move(ret), out);
@@ -124,36 +253,7 @@ std::pair<MemBuffer<uint8_t>, size_t> decode(string_view input)
 
 bool decode_inplace(string_view input, uint8_t* output, size_t outSize)
 {
-	unsigned i = 0;
-	size_t out = 0;
-	uint8_t buf4[4];
-	for (auto c : input) {
-		uint8_t d = decode(c);
-		if (d == uint8_t(-1)) continue;
-		buf4[i++] = d;
-		if (i == 4) {
-			i = 0;
-			if (unlikely((out + 3) > outSize)) return false;
-			output[out++] = char(((buf4[0] & 0xff) << 2) + ((buf4[1] & 0x30) >> 4));
-			output[out++] = char(((buf4[1] & 0x0f) << 4) + ((buf4[2] & 0x3c) >> 2));
-			output[out++] = char(((buf4[2] & 0x03) << 6) + ((buf4[3] & 0xff) >> 0));
-		}
-	}
-	if (i) {
-		for (unsigned j = i; j < 4; ++j) {
-			buf4[j] = 0;
-		}
-		uint8_t buf3[3];
-		buf3[0] = ((buf4[0] & 0xff) << 2) + ((buf4[1] & 0x30) >> 4);
-		buf3[1] = ((buf4[1] & 0x0f) << 4) + ((buf4[2] & 0x3c) >> 2);
-		buf3[2] = ((buf4[2] & 0x03) << 6) + ((buf4[3] & 0xff) >> 0);
-		for (unsigned j = 0; (j < i - 1); ++j) {
-			if (unlikely(out == outSize)) return false;
-			output[out++] = buf3[j];
-		}
-	}
-
-	return out == outSize;
+	return decode(input, output, outSize) == outSize;
 }
 
 } // namespace Base64
@@ -1,7 +1,9 @@
 #include "DeltaBlock.hh"
+#include "Math.hh"
 #include "likely.hh"
 #include "ranges.hh"
 #include "snappy.hh"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <tuple>
@@ -116,6 +118,24 @@ static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
 		} while (reinterpret_cast<uintptr_t>(p) & (WORD_SIZE - 1));
 	}
 
+#ifdef __SSE2__
+	// Very fast path for long equal runs (the common case, most memory
+	// doesn't change between snapshots). Compare 64 bytes per iteration
+	// with a single test. The loop below finds the exact word (and it
+	// needs at least one full word for the sentinel).
+	while ((p_end - p) >= (5 * WORD_SIZE)) {
+		auto* pp = reinterpret_cast<const __m128i*>(p);
+		auto* qq = reinterpret_cast<const __m128i*>(q);
+		__m128i d0 = _mm_cmpeq_epi8(_mm_load_si128(pp + 0), _mm_load_si128(qq + 0));
+		__m128i d1 = _mm_cmpeq_epi8(_mm_load_si128(pp + 1), _mm_load_si128(qq + 1));
+		__m128i d2 = _mm_cmpeq_epi8(_mm_load_si128(pp + 2), _mm_load_si128(qq + 2));
+		__m128i d3 = _mm_cmpeq_epi8(_mm_load_si128(pp + 3), _mm_load_si128(qq + 3));
+		__m128i d = _mm_and_si128(_mm_and_si128(d0, d1), _mm_and_si128(d2, d3));
+		if (_mm_movemask_epi8(d) != 0xffff) break;
+		p += 4 * WORD_SIZE; q += 4 * WORD_SIZE;
+	}
+#endif
+
 	// Fast path. Compare words-at-a-time.
 	{
 		// Place a sentinel in the last full word. This ensures we'll
@@ -149,13 +169,26 @@ end:	return std::mismatch(p, p_end, q);
 // buffer cannot be read-only memory.
 //
 // Unlike scan_mismatch() it's less obvious how to perform this function
-// word-at-a-time (it's possible with some bit hacks). Though luckily this
-// function is also less performance critical.
+// word-at-a-time (it's possible with some bit hacks). With SSE2 it is easy
+// though: compare 16 bytes and find the first equal byte in the mask. This
+// helps for blocks that were (largely) overwritten, e.g. VRAM.
 static std::pair<const uint8_t*, const uint8_t*> scan_match(
 	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
 {
 	assert((p_end - p) == (q_end - q));
 
+#ifdef __SSE2__
+	while ((p_end - p) >= 16) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+		if (unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) {
+			unsigned i = Math::findFirstSet(mask) - 1;
+			return {p + i, q + i};
+		}
+		p += 16; q += 16;
+	}
+#endif
+
 	// Code below is functionally equivalent to:
 	//   while ((p != p_end) && (*p != *q)) { ++p; ++q; }
 	//   return {p, q};
@@ -182,10 +215,45 @@ static std::pair<const uint8_t*, const uint8_t*> scan_match(
 //   n2 number of bytes are different, and here are the bytes
 //   n3 number of bytes are equal
 //   ...
-static vector<uint8_t> calcDelta(const uint8_t* oldBuf, const uint8_t* newBuf, size_t size)
+class DeltaWriter
 {
-	vector<uint8_t> result;
+public:
+	/** The delta is built in 'buffer' (a scratch buffer that is reused
+	  * for all deltas, so it doesn't need to grow each time), finish()
+	  * returns a copy of exactly the right size.
+	  */
+	explicit DeltaWriter(vector<uint8_t>& buffer)
+		: result(buffer)
+	{
+		result.clear();
+	}
 
+	void equal(size_t n) { pendingEqual += n; }
+	void different(const uint8_t* data, size_t n)
+	{
+		storeUleb(result, pendingEqual);
+		storeUleb(result, n);
+		result.insert(result.end(), data, data + n);
+		pendingEqual = 0;
+	}
+	MemBuffer<uint8_t> finish()
+	{
+		if (pendingEqual || result.empty()) {
+			storeUleb(result, pendingEqual);
+		}
+		MemBuffer<uint8_t> copy(result.size());
+		memcpy(copy.data(), result.data(), result.size());
+		return copy;
+	}
+
+private:
+	vector<uint8_t>& result;
+	size_t pendingEqual = 0;
+};
+
+static void calcDelta(const uint8_t* oldBuf, const uint8_t* newBuf, size_t size,
+                      DeltaWriter& writer)
+{
 	auto* p = oldBuf;
 	auto* q = newBuf;
 	auto* p_end = p + size;
@@ -194,8 +262,7 @@ static vector<uint8_t> calcDelta(const uint8_t* oldBuf, const uint8_t* newBuf, s
 	// scan equal bytes (possibly zero)
 	auto* q1 = q;
 	std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
-	auto n1 = q - q1;
-	storeUleb(result, n1);
+	writer.equal(q - q1);
 
 	while (q != q_end) {
 		assert(*p != *q);
@@ -203,21 +270,45 @@ static vector<uint8_t> calcDelta(const uint8_t* oldBuf, const uint8_t* newBuf, s
 		auto* q2 = q;
 	different:
 		std::tie(p, q) = scan_match(p + 1, p_end, q + 1, q_end);
-		auto n2 = q - q2;
 
 		auto* q3 = q;
 		std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
 		auto n3 = q - q3;
 		if ((q != q_end) && (n3 <= 2)) goto different;
 
-		storeUleb(result, n2);
-		result.insert(result.end(), q2, q3);
+		writer.different(q2, q3 - q2);
+		writer.equal(n3);
+	}
+}
 
-		if (n3 != 0) storeUleb(result, n3);
+static MemBuffer<uint8_t> calcDelta(const uint8_t* oldBuf, const uint8_t* newBuf, size_t size,
+                                    const DirtyPages* dirty, vector<uint8_t>& scratch)
+{
+	DeltaWriter writer(scratch);
+	if (!dirty) {
+		calcDelta(oldBuf, newBuf, size, writer);
+		return writer.finish();
 	}
 
-	result.shrink_to_fit();
-	return result;
+	// Only compare (runs of) dirty pages, clean pages are known equal.
+	size_t numPages = dirty->getNumPages();
+	assert(numPages == (size + DirtyPages::PAGE_SIZE - 1) / DirtyPages::PAGE_SIZE);
+	size_t page = 0;
+	while (page < numPages) {
+		bool isDirty = dirty->isDirty(page);
+		size_t first = page;
+		do {
+			++page;
+		} while ((page < numPages) && (dirty->isDirty(page) == isDirty));
+		size_t begin = first * DirtyPages::PAGE_SIZE;
+		size_t end = std::min(page * DirtyPages::PAGE_SIZE, size);
+		if (isDirty) {
+			calcDelta(oldBuf + begin, newBuf + begin, end - begin, writer);
+		} else {
+			writer.equal(end - begin);
+		}
+	}
+	return writer.finish();
 }
 
 // Apply a previously calculated 'delta' to 'oldBuf' to get 'newbuf'.
@@ -255,7 +346,8 @@ DeltaBlock::~DeltaBlock()
 // class DeltaBlockCopy
 
 DeltaBlockCopy::DeltaBlockCopy(const uint8_t* data, size_t size)
-	: block(size)
+	: DeltaBlock(size)
+	, block(size)
 	, compressedSize(0)
 {
 #ifdef DEBUG
@@ -273,6 +365,7 @@ DeltaBlockCopy::DeltaBlockCopy(const uint8_t* data, size_t size)
 
 void DeltaBlockCopy::apply(uint8_t* dst, size_t size) const
 {
+	std::lock_guard<std::mutex> lock(mutex);
 	if (compressed()) {
 		snappy::uncompress(
 			reinterpret_cast<const char*>(block.data()), compressedSize,
@@ -287,8 +380,13 @@ void DeltaBlockCopy::apply(uint8_t* dst, size_t size) const
 
 void DeltaBlockCopy::compress(size_t size)
 {
-	if (compressed()) return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (compressed()) return;
+	}
 
+	// While uncompressed the content of 'block' doesn't change anymore,
+	// so it's safe to read it without holding the lock.
 	size_t dstLen = snappy::maxCompressedLength(size);
 	MemBuffer<uint8_t> buf2(dstLen);
 	snappy::compress(reinterpret_cast<const char*>(block.data()), size,
@@ -297,10 +395,14 @@ void DeltaBlockCopy::compress(size_t size)
 		// compression isn't beneficial
 		return;
 	}
-	compressedSize = dstLen;
-	block.swap(buf2);
-	block.resize(compressedSize); // shrink to fit
-	assert(compressed());
+	buf2.resize(dstLen); // shrink to fit
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (compressed()) return; // compressed concurrently
+		compressedSize = dstLen;
+		block.swap(buf2);
+		assert(compressed());
+	}
 #ifdef DEBUG
 	MemBuffer<uint8_t> buf3(size);
 	apply(buf3.data(), size);
@@ -315,6 +417,12 @@ void DeltaBlockCopy::compress(size_t size)
 #endif
 }
 
+size_t DeltaBlockCopy::getAllocSize() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return compressed() ? compressedSize : getBlockSize();
+}
+
 const uint8_t* DeltaBlockCopy::getData()
 {
 	assert(!compressed());
@@ -326,9 +434,13 @@ const uint8_t* DeltaBlockCopy::getData()
 
 DeltaBlockDiff::DeltaBlockDiff(
 		std::shared_ptr<DeltaBlockCopy> prev_,
-		const uint8_t* data, size_t size)
-	: prev(std::move(prev_))
-	, delta(calcDelta(prev->getData(), data, size))
+		const uint8_t* data, size_t size, const DirtyPages* dirty,
+		std::vector<uint8_t>& scratch)
+	: DeltaBlock(size)
+	, prev(std::move(prev_))
+	, delta(calcDelta(prev->getData(), data, size, dirty, scratch))
+	, deltaSize(scratch.size()) // calcDelta() left the delta in 'scratch'
+
 {
 #ifdef DEBUG
 	sha1 = SHA1::calc(data, size);
@@ -338,7 +450,7 @@ DeltaBlockDiff::DeltaBlockDiff(
 	assert(memcmp(buf.data(), data, size) == 0);
 #endif
 #if STATISTICS
-	allocSize = delta.size();
+	allocSize = deltaSize;
 	globalAllocSize += allocSize;
 	std::cout << "stat: DeltaBlockDiff " << globalAllocSize
 	          << " (+" << allocSize << ")\n";
@@ -354,16 +466,22 @@ void DeltaBlockDiff::apply(uint8_t* dst, size_t size) const
 #endif
 }
 
+size_t DeltaBlockDiff::getAllocSize() const
+{
+	return getDeltaSize();
+}
+
 size_t DeltaBlockDiff::getDeltaSize() const
 {
-	return delta.size();
+	return deltaSize;
 }
 
 
 // class LastDeltaBlocks
 
 std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
-		const void* id, const uint8_t* data, size_t size)
+		const void* id, const uint8_t* data, size_t size,
+		const DirtyPages* dirty)
 {
 	auto it = ranges::lower_bound(infos, std::make_tuple(id, size),
 		[](const Info& info, const std::tuple<const void*, size_t>& info2) {
@@ -380,7 +498,7 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 		if (ref) {
 			// We will switch to a new DeltaBlockCopy object. So
 			// now is a good time to compress the old one.
-			ref->compress(size);
+			compressInBackground(std::move(ref), size);
 		}
 		// Heuristic: create a new block when too many small
 		// differences have accumulated.
@@ -388,11 +506,18 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 		it->ref = b;
 		it->last = b;
 		it->accSize = 0;
+		it->accDirty.clear();
 		return b;
 	} else {
 		// Create diff based on earlier reference block.
 		// Reference remains unchanged.
-		auto b = std::make_shared<DeltaBlockDiff>(ref, data, size);
+		if (dirty) {
+			it->accDirty.merge(*dirty);
+		} else {
+			it->accDirty.markAllDirty();
+		}
+		auto b = std::make_shared<DeltaBlockDiff>(
+			ref, data, size, &it->accDirty, scratch);
 		it->last = b;
 		it->accSize += b->getDeltaSize();
 		return b;
@@ -417,6 +542,7 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
 		it->ref = b;
 		it->last = b;
 		it->accSize = 0;
+		it->accDirty.clear();
 		return b;
 	} else {
 #ifdef DEBUG
@@ -430,10 +556,19 @@ void LastDeltaBlocks::clear()
 {
 	for (const Info& info : infos) {
 		if (auto ref = info.ref.lock()) {
-			ref->compress(info.size);
+			compressInBackground(std::move(ref), info.size);
 		}
 	}
 	infos.clear();
 }
 
+void LastDeltaBlocks::compressInBackground(
+	std::shared_ptr<DeltaBlockCopy> ref, size_t size)
+{
+	compressor.push([ref, size]() {
+		// Skip blocks that got dropped before we got to them.
+		if (ref.use_count() > 1) ref->compress(size);
+	});
+}
+
 } // namespace openmsx
@@ -3,9 +3,12 @@
 
 #define STATISTICS 0
 
+#include "DirtyPages.hh"
 #include "MemBuffer.hh"
+#include "WorkerThread.hh"
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <vector>
 #ifdef DEBUG
 #include "sha1.hh"
@@ -23,8 +26,22 @@ public:
 #endif
 	virtual void apply(uint8_t* dst, size_t size) const = 0;
 
+	/** Size of the (uncompressed) block of data represented by this
+	  * object. This is the 'size' parameter that should be passed to
+	  * apply().
+	  */
+	size_t getBlockSize() const { return blockSize; }
+
+	/** Approximation of the amount of memory used by this object. This
+	  * does not include the memory of the reference block of a diff.
+	  */
+	virtual size_t getAllocSize() const = 0;
+
 protected:
-	DeltaBlock() = default;
+	explicit DeltaBlock(size_t blockSize_) : blockSize(blockSize_) {}
+
+private:
+	const size_t blockSize;
 
 #ifdef DEBUG
 public:
@@ -44,12 +61,20 @@ class DeltaBlockCopy final : public DeltaBlock
 public:
 	DeltaBlockCopy(const uint8_t* data, size_t size);
 	void apply(uint8_t* dst, size_t size) const override;
+	size_t getAllocSize() const override;
+
+	/** Compress the stored block (if that's beneficial).
+	  * This may run on a different thread than apply(): the (lengthy)
+	  * compression itself is done without holding a lock, only the final
+	  * swap of the buffer is protected.
+	  */
 	void compress(size_t size);
 	const uint8_t* getData();
 
 private:
 	bool compressed() const { return compressedSize != 0; }
 
+	mutable std::mutex mutex; // protects 'block' and 'compressedSize'
 	MemBuffer<uint8_t> block;
 	size_t compressedSize;
 };
@@ -58,39 +83,67 @@ private:
 class DeltaBlockDiff final : public DeltaBlock
 {
 public:
+	/** Create a diff between 'data' and the reference block 'prev_'.
+	  * When 'dirty' is given, only the dirty pages can differ from the
+	  * reference, so only those pages are compared. 'scratch' is used as
+	  * temporary buffer while calculating the diff.
+	  */
 	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev_,
-	               const uint8_t* data, size_t size);
+	               const uint8_t* data, size_t size,
+	               const DirtyPages* dirty,
+	               std::vector<uint8_t>& scratch);
 	void apply(uint8_t* dst, size_t size) const override;
+	size_t getAllocSize() const override;
 	size_t getDeltaSize() const;
 
 private:
 	const std::shared_ptr<DeltaBlockCopy> prev;
-	const std::vector<uint8_t> delta; // TODO could be tweaked to use OutputBuffer
+	const MemBuffer<uint8_t> delta;
+	const size_t deltaSize;
 };
 
 
 class LastDeltaBlocks
 {
 public:
+	/** Create a new block for 'data'.
+	  * Optionally 'dirty' indicates which pages were written since the
+	  * previous call for the same 'id' (all other pages are known to be
+	  * unchanged). When nullptr, every page is possibly changed.
+	  */
 	std::shared_ptr<DeltaBlock> createNew(
-		const void* id, const uint8_t* data, size_t size);
+		const void* id, const uint8_t* data, size_t size,
+		const DirtyPages* dirty = nullptr);
 	std::shared_ptr<DeltaBlock> createNullDiff(
 		const void* id, const uint8_t* data, size_t size);
 	void clear();
 
 private:
+	void compressInBackground(std::shared_ptr<DeltaBlockCopy> ref,
+	                          size_t size);
+
 	struct Info {
 		Info(const void* id_, size_t size_)
-			: id(id_), size(size_), accSize(0) {}
+			: id(id_), size(size_), accSize(0), accDirty(size_) {}
 
 		const void* id;
 		size_t size;
 		std::weak_ptr<DeltaBlockCopy> ref;
 		std::weak_ptr<DeltaBlock> last;
 		size_t accSize;
+		// pages that (possibly) differ from the 'ref' block
+		DirtyPages accDirty;
 	};
 
 	std::vector<Info> infos;
+
+	// Reused between calls to avoid growing a new buffer for every diff.
+	std::vector<uint8_t> scratch;
+
+	// Reference blocks that are no longer used as base for new diffs get
+	// compressed on this thread, so the emulation thread only has to pay
+	// for the initial copy.
+	WorkerThread compressor;
 };
 
 } // namespace openmsx
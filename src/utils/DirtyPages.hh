@@ -0,0 +1,73 @@
+#ifndef DIRTYPAGES_HH
+#define DIRTYPAGES_HH
+
+#include "ranges.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+/** Keeps track of which (fixed size) pages of a memory block were written.
+  *
+  * This is used to speed up the delta-compression of reverse snapshots:
+  * pages that weren't written since the previous snapshot can't be different,
+  * so there's no need to compare them. See DeltaBlock.hh.
+  *
+  * Pages are tracked with one byte per page (instead of one bit) so that
+  * marking a page dirty is a single store without read-modify-write.
+  */
+class DirtyPages
+{
+public:
+	static const unsigned PAGE_BITS = 10;
+	static const size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+	/** Track a block of 'size' bytes, initially all pages are dirty. */
+	explicit DirtyPages(size_t size)
+		: pages((size + PAGE_SIZE - 1) >> PAGE_BITS, 1) {}
+
+	size_t getNumPages() const { return pages.size(); }
+
+	void markDirty(size_t addr) {
+		assert((addr >> PAGE_BITS) < pages.size());
+		pages[addr >> PAGE_BITS] = 1;
+	}
+	void markDirty(size_t addr, size_t num) {
+		if (num == 0) return;
+		size_t first = addr >> PAGE_BITS;
+		size_t last = (addr + num - 1) >> PAGE_BITS;
+		assert(last < pages.size());
+		std::fill(pages.begin() + first, pages.begin() + last + 1, 1);
+	}
+	void markAllDirty() {
+		ranges::fill(pages, 1);
+	}
+	void clear() {
+		ranges::fill(pages, 0);
+	}
+
+	bool isDirty(size_t page) const {
+		return pages[page] != 0;
+	}
+	bool anyDirty() const {
+		return ranges::any_of(pages, [](uint8_t p) { return p != 0; });
+	}
+
+	/** Also mark all pages dirty that are dirty in 'other'. */
+	void merge(const DirtyPages& other) {
+		assert(other.pages.size() == pages.size());
+		for (size_t i = 0; i < pages.size(); ++i) {
+			pages[i] |= other.pages[i];
+		}
+	}
+
+private:
+	std::vector<uint8_t> pages;
+};
+
+} // namespace openmsx
+
+#endif
@@ -27,6 +27,17 @@ public:
 	inline uint32_t getDivisor() const { return divisor; }
 
 	uint32_t div(uint64_t dividend) const
+	{
+		uint64_t result = div64(dividend);
+	#ifdef DEBUG
+		// we don't even want this overhead in devel builds
+		assert(result == uint32_t(result));
+	#endif
+		return uint32_t(result);
+	}
+
+	/** Like div(), but the quotient doesn't have to fit in 32 bits. */
+	uint64_t div64(uint64_t dividend) const
 	{
 	#if defined __x86_64 && !defined _MSC_VER
 		uint64_t t = (__uint128_t(dividend) * m + a) >> 64;
@@ -36,7 +47,7 @@ public:
 	#endif
 	}
 
-	inline uint32_t divinC(uint64_t dividend) const
+	inline uint64_t divinC(uint64_t dividend) const
 	{
 		uint64_t t1 = uint64_t(uint32_t(dividend)) * uint32_t(m);
 		uint64_t t2 = (dividend >> 32) * uint32_t(m);
@@ -48,12 +59,7 @@ public:
 		uint64_t s3 = uint64_t(uint32_t(s2)) + uint32_t(t3);
 		uint64_t s4 = (s3 >> 32) + (s2 >> 32) + (t3 >> 32) + t4;
 
-		uint64_t result = s4 >> s;
-	#ifdef DEBUG
-		// we don't even want this overhead in devel builds
-		assert(result == uint32_t(result));
-	#endif
-		return uint32_t(result);
+		return s4 >> s;
 	}
 
 	uint32_t mod(uint64_t dividend) const
@@ -66,10 +72,10 @@ public:
 	}
 
 private:
-	uint64_t m;
-	uint64_t a;
-	uint32_t s;
-	uint32_t divisor; // only used by mod() and getDivisor()
+	uint64_t m = 0;
+	uint64_t a = 0;
+	uint32_t s = 0;
+	uint32_t divisor = 0; // only used by mod() and getDivisor()
 };
 
 } // namespace openmsx
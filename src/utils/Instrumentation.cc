@@ -0,0 +1,172 @@
+#include "Instrumentation.hh"
+
+#ifdef OPENMSX_INSTRUMENTATION
+
+#include "demangle.hh"
+#include "ranges.hh"
+#include "xrange.hh"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace openmsx {
+namespace Instrumentation {
+
+std::atomic<bool> recording(false);
+
+namespace {
+
+struct Event {
+	const char* name;
+	uint64_t start;
+	uint64_t stop;
+};
+
+// The zones of one thread. The lock is only contended while the recording
+// is written.
+struct ThreadBuffer {
+	std::mutex mutex;
+	std::vector<Event> events;
+	uint64_t dropped = 0;
+};
+
+// Limit the memory usage (24 bytes per event) of long recordings.
+const size_t MAX_EVENTS_PER_THREAD = 16 * 1024 * 1024;
+
+std::mutex globalMutex; // protects all below
+std::vector<std::unique_ptr<ThreadBuffer>> buffers; // never shrinks
+std::set<std::string, std::less<>> internedNames;
+std::unordered_map<const std::type_info*, const char*> typeNames;
+uint64_t startTime = 0;
+
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+void writeName(std::ostream& os, const char* name)
+{
+	os << '"';
+	for (const char* p = name; *p; ++p) {
+		char c = *p;
+		if ((c == '"') || (c == '\\')) {
+			os << '\\' << c;
+		} else if (static_cast<unsigned char>(c) >= 0x20) {
+			os << c;
+		}
+	}
+	os << '"';
+}
+
+// Microseconds since the start of the recording, as expected by the format.
+void writeTime(std::ostream& os, uint64_t ns)
+{
+	os << ns / 1000 << '.' << char('0' + (ns / 100) % 10)
+	   << char('0' + (ns / 10) % 10) << char('0' + ns % 10);
+}
+
+} // namespace
+
+uint64_t now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void record(const char* name, uint64_t start_, uint64_t stop_)
+{
+	if (!threadBuffer) {
+		std::lock_guard<std::mutex> lock(globalMutex);
+		buffers.push_back(std::make_unique<ThreadBuffer>());
+		threadBuffer = buffers.back().get();
+	}
+	std::lock_guard<std::mutex> lock(threadBuffer->mutex);
+	if (threadBuffer->events.size() < MAX_EVENTS_PER_THREAD) {
+		threadBuffer->events.push_back({name, start_, stop_});
+	} else {
+		++threadBuffer->dropped;
+	}
+}
+
+const char* intern(string_view name)
+{
+	std::lock_guard<std::mutex> lock(globalMutex);
+	auto it = internedNames.find(name);
+	if (it == internedNames.end()) {
+		it = internedNames.insert(name.str()).first;
+	}
+	return it->c_str();
+}
+
+const char* typeName(const std::type_info& type)
+{
+	std::lock_guard<std::mutex> lock(globalMutex);
+	auto& result = typeNames[&type];
+	if (!result) {
+		result = internedNames.insert(demangle(type.name())).first->c_str();
+	}
+	return result;
+}
+
+void start()
+{
+	recording = false;
+	std::lock_guard<std::mutex> lock(globalMutex);
+	for (auto& b : buffers) {
+		std::lock_guard<std::mutex> lock2(b->mutex);
+		b->events.clear();
+		b->dropped = 0;
+	}
+	startTime = now();
+	recording = true;
+}
+
+void stop()
+{
+	recording = false;
+}
+
+uint64_t write(std::ostream& os)
+{
+	std::lock_guard<std::mutex> lock(globalMutex);
+	uint64_t count = 0;
+	os << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (auto tid : xrange(buffers.size())) {
+		auto& b = *buffers[tid];
+		std::lock_guard<std::mutex> lock2(b.mutex);
+		if (b.events.empty()) continue;
+		// Zones are recorded when they end, so nested zones come before
+		// the enclosing zone. Some viewers expect them in start order.
+		ranges::sort(b.events, [](const Event& x, const Event& y) {
+			return (x.start != y.start) ? (x.start < y.start)
+			                            : (x.stop > y.stop);
+		});
+		if (!first) os << ",\n";
+		first = false;
+		os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+		   << tid << ",\"args\":{\"name\":\"thread " << tid;
+		if (b.dropped) os << " (" << b.dropped << " zones dropped)";
+		os << "\"}}";
+		for (auto& e : b.events) {
+			if (e.start < startTime) continue; // started before 'start'
+			os << ",\n{\"name\":";
+			writeName(os, e.name);
+			os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+			writeTime(os, e.start - startTime);
+			os << ",\"dur\":";
+			writeTime(os, e.stop - e.start);
+			os << '}';
+			++count;
+		}
+	}
+	os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+	return count;
+}
+
+} // namespace Instrumentation
+} // namespace openmsx
+
+#endif // OPENMSX_INSTRUMENTATION
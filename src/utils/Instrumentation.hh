@@ -0,0 +1,88 @@
+#ifndef INSTRUMENTATION_HH
+#define INSTRUMENTATION_HH
+
+/** Named zones in the hot paths (scheduler, CPU slices, device I/O, sound
+  * chips, rendering, serialization, file I/O), to be shown on a timeline by
+  * an external tool. A sampling profiler can't tell which emulated device is
+  * responsible for the time spent inside the big CPUCore switch, these zones
+  * can.
+  *
+  * This is only compiled in when OPENMSX_INSTRUMENTATION is defined (with
+  * meson: -Dinstrumentation=true), otherwise the INSTRUMENT_ZONE macros
+  * expand to nothing. When compiled in, zones are only recorded between the
+  * 'instrumentation start' and 'instrumentation stop' commands. The result
+  * is written in the Chrome trace event format (JSON), which can be opened
+  * in Perfetto (ui.perfetto.dev) or converted with Tracy's 'import-chrome'
+  * tool.
+  *
+  * Usage:
+  *   INSTRUMENT_ZONE("Scheduler");   // until the end of the enclosing scope
+  *   INSTRUMENT_ZONE(Instrumentation::intern(device.getName()));
+  * The name must stay valid till the recording is written, so either a
+  * string literal or a name returned by intern() or typeName(). The name
+  * expression is only evaluated while recording.
+  */
+
+#ifdef OPENMSX_INSTRUMENTATION
+
+#include "string_view.hh"
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <typeinfo>
+
+namespace openmsx {
+namespace Instrumentation {
+
+extern std::atomic<bool> recording;
+
+/** Host time in nanoseconds. */
+uint64_t now();
+/** Add a zone to the recording of the current thread. */
+void record(const char* name, uint64_t start, uint64_t stop);
+
+/** Returns a copy of the given name that stays valid till the program
+  * exits. Only meant for a limited set of names (e.g. device names). */
+const char* intern(string_view name);
+/** The (demangled) name of the given type, also stays valid. */
+const char* typeName(const std::type_info& type);
+
+/** Discard the previous recording and start a new one. */
+void start();
+/** Stop recording (so the recording can be written). */
+void stop();
+/** Write the recorded zones in the Chrome trace event format. Returns the
+  * number of written zones. */
+uint64_t write(std::ostream& os);
+
+class Zone
+{
+public:
+	explicit Zone(const char* name_)
+		: name(name_), startTime(name ? now() : 0) {}
+	~Zone() { if (name) record(name, startTime, now()); }
+	Zone(const Zone&) = delete;
+	Zone& operator=(const Zone&) = delete;
+
+private:
+	const char* const name; // nullptr when not recording
+	const uint64_t startTime;
+};
+
+} // namespace Instrumentation
+} // namespace openmsx
+
+#define INSTRUMENT_CAT2(a, b) a##b
+#define INSTRUMENT_CAT(a, b) INSTRUMENT_CAT2(a, b)
+#define INSTRUMENT_ZONE(name) \
+	::openmsx::Instrumentation::Zone INSTRUMENT_CAT(instrumentZone, __LINE__)( \
+		::openmsx::Instrumentation::recording.load(std::memory_order_relaxed) \
+			? (name) : nullptr)
+
+#else
+
+#define INSTRUMENT_ZONE(name) do {} while (0)
+
+#endif // OPENMSX_INSTRUMENTATION
+
+#endif
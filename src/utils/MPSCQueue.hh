@@ -0,0 +1,100 @@
+#ifndef MPSCQUEUE_HH
+#define MPSCQUEUE_HH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace openmsx {
+
+/** Bounded lock-free multi-producer / single-consumer queue.
+  *
+  * Any thread can push(), only one thread (at a time) may pop(). Both
+  * never block and never allocate: the elements are stored in a fixed
+  * ring of SIZE slots (must be a power of 2), each slot has a sequence
+  * number that tells whether it's free or filled for the current lap of
+  * the ring (see Dmitry Vyukov's bounded MPMC queue, this is the same
+  * algorithm but simplified for a single consumer).
+  *
+  * Elements pushed by one thread are popped in the same order.
+  */
+template<typename T, size_t SIZE>
+class MPSCQueue
+{
+	static_assert((SIZE & (SIZE - 1)) == 0, "SIZE must be a power of 2");
+	static const size_t MASK = SIZE - 1;
+
+public:
+	MPSCQueue() {
+		for (size_t i = 0; i < SIZE; ++i) {
+			slots[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+	MPSCQueue(const MPSCQueue&) = delete;
+	MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+	/** Add an element. Can be called from any thread.
+	  * @return false iff the queue is full (the element is not added).
+	  */
+	bool push(const T& element) {
+		size_t pos = pushPos.load(std::memory_order_relaxed);
+		Slot* slot;
+		while (true) {
+			slot = &slots[pos & MASK];
+			size_t seq = slot->seq.load(std::memory_order_acquire);
+			auto diff = intptr_t(seq) - intptr_t(pos);
+			if (diff == 0) {
+				// slot is free, try to claim it
+				if (pushPos.compare_exchange_weak(
+					pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (diff < 0) {
+				return false; // full
+			} else {
+				// another producer claimed it first
+				pos = pushPos.load(std::memory_order_relaxed);
+			}
+		}
+		slot->value = element;
+		slot->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Remove the oldest element. May only be called from the consumer
+	  * thread.
+	  * @return false iff there's no (completely pushed) element.
+	  */
+	bool pop(T& element) {
+		Slot& slot = slots[popPos & MASK];
+		size_t seq = slot.seq.load(std::memory_order_acquire);
+		if (seq != (popPos + 1)) return false; // empty
+		element = std::move(slot.value);
+		slot.value = T();
+		slot.seq.store(popPos + SIZE, std::memory_order_release);
+		++popPos;
+		return true;
+	}
+
+	/** Is there no (completely pushed) element? May only be called from
+	  * the consumer thread.
+	  */
+	bool empty() const {
+		const Slot& slot = slots[popPos & MASK];
+		return slot.seq.load(std::memory_order_acquire) != (popPos + 1);
+	}
+
+private:
+	struct Slot {
+		std::atomic<size_t> seq;
+		T value;
+	};
+	Slot slots[SIZE];
+	alignas(64) std::atomic<size_t> pushPos{0};
+	alignas(64) size_t popPos = 0; // only accessed by the consumer
+};
+
+} // namespace openmsx
+
+#endif
@@ -15,6 +15,11 @@
 #if ASM_X86 && defined _MSC_VER
 #include <intrin.h>	// for __stosd intrinsic
 #endif
+#ifdef _WIN32
+#include <windows.h>
+#elif HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
@@ -294,5 +299,70 @@ void freeAligned(void* aligned)
 #endif
 }
 
+
+static bool hugePages = false;
+
+void setHugePages(bool enabled)
+{
+	hugePages = enabled;
+}
+
+#ifdef _WIN32
+static size_t roundHuge(size_t size)
+{
+	size_t large = GetLargePageMinimum();
+	return (size + large - 1) & ~(large - 1);
+}
+#endif
+
+void* mallocHuge(size_t size)
+{
+	if (!hugePages || (size < HUGE_PAGE_SIZE)) return nullptr;
+#ifdef _WIN32
+	if (GetLargePageMinimum() == 0) return nullptr;
+	// Fails without SeLockMemoryPrivilege (not granted by default).
+	return VirtualAlloc(nullptr, roundHuge(size),
+	                    MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+	                    PAGE_READWRITE);
+#elif HAVE_MMAP && defined(MADV_HUGEPAGE)
+	// The kernel only uses huge pages for the parts of a mapping that are
+	// aligned to the huge page size. So map a bit more and cut off the
+	// unaligned head and tail.
+	size_t len = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+	void* m = mmap(nullptr, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+	               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (m == MAP_FAILED) return nullptr;
+	auto start = reinterpret_cast<uintptr_t>(m);
+	auto aligned = (start + HUGE_PAGE_SIZE - 1) & ~uintptr_t(HUGE_PAGE_SIZE - 1);
+	auto* result = reinterpret_cast<char*>(aligned);
+	if (size_t head = aligned - start) {
+		munmap(m, head);
+	}
+	if (size_t tail = HUGE_PAGE_SIZE - (aligned - start)) {
+		munmap(result + len, tail);
+	}
+	// Only a hint, e.g. when THP is disabled system wide the memory is
+	// still usable.
+	madvise(result, len, MADV_HUGEPAGE);
+	return result;
+#else
+	return nullptr;
+#endif
+}
+
+void freeHuge(void* p, size_t size)
+{
+	if (!p) return;
+#ifdef _WIN32
+	(void)size;
+	VirtualFree(p, 0, MEM_RELEASE);
+#elif HAVE_MMAP && defined(MADV_HUGEPAGE)
+	munmap(p, (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+#else
+	(void)size;
+	assert(false);
+#endif
+}
+
 } // namespace MemoryOps
 } // namespace openmsx
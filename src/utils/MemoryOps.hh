@@ -18,6 +18,24 @@ namespace MemoryOps {
 	void* mallocAligned(size_t alignment, size_t size);
 	void freeAligned(void* aligned);
 
+	/** Huge pages only make sense for buffers of at least this size. */
+	const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	/** Enable/disable the use of huge pages by mallocHuge(). Only
+	  * influences later allocations. Disabled by default. */
+	void setHugePages(bool enabled);
+	/** Allocate a (zero-filled) block of memory that is backed by huge
+	  * pages: on Linux transparent huge pages (madvise), on Windows large
+	  * pages (these require the 'lock pages in memory' privilege).
+	  * Meant for large buffers that live long and are accessed randomly
+	  * (emulated memory), there it reduces the number of TLB misses.
+	  * Returns nullptr when huge pages are disabled, not supported or
+	  * 'size' is smaller than HUGE_PAGE_SIZE, the caller should then
+	  * fall back to a normal allocation. */
+	void* mallocHuge(size_t size);
+	/** Free a block returned by mallocHuge(), 'size' must be the same. */
+	void freeHuge(void* p, size_t size);
+
 } // namespace MemoryOps
 } // namespace openmsx
 
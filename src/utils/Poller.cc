@@ -1,6 +1,8 @@
 #include "Poller.hh"
 
 #ifndef _WIN32
+#include "vla.hh"
+#include <cerrno>
 #include <cstdio>
 #include <poll.h>
 #include <unistd.h>
@@ -39,6 +41,20 @@ void Poller::abort()
 #endif
 }
 
+void Poller::reset()
+{
+	abortFlag = false;
+#ifndef _WIN32
+	// Drain the wakeup pipe, without blocking.
+	while (true) {
+		struct pollfd fds = { .fd = wakeupPipe[0], .events = POLLIN, .revents = 0 };
+		if ((::poll(&fds, 1, 0) != 1) || !(fds.revents & POLLIN)) break;
+		char buf[64];
+		if (read(wakeupPipe[0], buf, sizeof(buf)) <= 0) break;
+	}
+#endif
+}
+
 #ifndef _WIN32
 bool Poller::poll(int fd)
 {
@@ -59,6 +75,47 @@ bool Poller::poll(int fd)
 		}
 	}
 }
+
+void Poller::wakeUp()
+{
+	char dummy = 'W';
+	if (write(wakeupPipe[1], &dummy, sizeof(dummy)) == -1) {
+		// Nothing we can do here; we'll have to rely on the poll() timeout.
+	}
+}
+
+bool Poller::poll(pollfd* fds, unsigned num)
+{
+	if (abortFlag) return true;
+
+	// The wakeup pipe goes in the last entry.
+	VLA(pollfd, all, num + 1);
+	for (unsigned i = 0; i < num; ++i) {
+		all[i] = fds[i];
+		all[i].revents = 0;
+	}
+	all[num] = { .fd = wakeupPipe[0], .events = POLLIN, .revents = 0 };
+	int pollResult = ::poll(all, num + 1, 1000);
+	if (abortFlag) {
+		return true;
+	}
+	if (pollResult == -1) {
+		// interrupted by a signal is not an error
+		return errno != EINTR;
+	}
+	for (unsigned i = 0; i < num; ++i) {
+		fds[i].revents = all[i].revents;
+	}
+	if (all[num].revents & POLLIN) {
+		// Consume the pending wakeUp() requests. The pipe is readable,
+		// so this doesn't block.
+		char buf[64];
+		if (read(wakeupPipe[0], buf, sizeof(buf)) == -1) {
+			// ignore
+		}
+	}
+	return false;
+}
 #endif
 
 } // namespace openmsx
@@ -3,9 +3,13 @@
 
 #include <atomic>
 
+#ifndef _WIN32
+struct pollfd;
+#endif
+
 namespace openmsx {
 
-/** Polls for events on a given file descriptor.
+/** Polls for events on a given file descriptor (or a set of them).
   * It is possible to abort this poll from another thread.
   * This class exists because in POSIX there is no straightforward way to
   * abort a blocking I/O operation.
@@ -21,6 +25,20 @@ public:
 	  * Returns true iff abort() was called or an error occurred.
 	  */
 	bool poll(int fd);
+
+	/** Waits for an event to occur on any of the given file descriptors
+	  * (the 'revents' fields are filled in), till wakeUp() is called or
+	  * till some timeout expires. Unlike poll(int) this doesn't loop, the
+	  * caller typically recalculates the set of file descriptors and
+	  * polls again.
+	  * Returns true iff abort() was called or an error occurred.
+	  */
+	bool poll(pollfd* fds, unsigned num);
+
+	/** Wakes up a poll in progress (or the next one), but unlike abort()
+	  * only once.
+	  */
+	void wakeUp();
 #endif
 
 	/** Returns true iff abort() was called.
@@ -33,6 +51,11 @@ public:
 	  */
 	void abort();
 
+	/** Undo abort(), so that this poller can be used again (e.g. by a new
+	  * thread). There may not be a poll in progress.
+	  */
+	void reset();
+
 private:
 #ifndef _WIN32
 	int wakeupPipe[2];
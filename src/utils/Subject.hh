@@ -65,6 +65,9 @@ template <typename T> void Subject<T>::detach(Observer<T>& observer)
 
 template <typename T> void Subject<T>::notify() const
 {
+	// Often nobody is interested (e.g. a Probe without debugger), keep
+	// that case cheap.
+	if (observers.empty()) return;
 	assert(notifyState == IDLE);
 	notifyState = IN_PROGRESS;
 
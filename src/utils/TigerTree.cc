@@ -1,8 +1,14 @@
 #include "TigerTree.hh"
 #include "tiger.hh"
+#include "File.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
 #include "Math.hh"
 #include "MemBuffer.hh"
+#include "sha1.hh"
+#include "xrange.hh"
 #include <map>
+#include <vector>
 #include <cstring>
 #include <cassert>
 
@@ -10,6 +16,18 @@ namespace openmsx {
 
 static const size_t BLOCK_SIZE = 1024;
 
+// Number of leaf blocks that are read and then hashed in parallel in one go.
+static const size_t BATCH_SIZE = 1024;
+// Below this number of leaf blocks it's not worth to start the worker threads.
+static const size_t MIN_PARALLEL = 16;
+
+// Only the nodes at this level (or higher) are stored in the persistent
+// cache, each covers 1MB of data. So for a 4GB image that's 8192 nodes. When
+// (after loading the cache) such a node gets invalidated, at most 1MB needs
+// to be rehashed.
+static const size_t CACHE_LEVEL = 1024;
+static const char CACHE_MAGIC[8] = { 't','t','h','c','a','c','h','1' };
+
 struct TTCacheEntry
 {
 	MemBuffer<TigerHash> hash;
@@ -17,7 +35,24 @@ struct TTCacheEntry
 	size_t numNodes;
 	time_t time = -1;
 	size_t numNodesValid;
+	bool modified = false; // persistent cache needs to be (re)written
+};
+
+struct TTCacheHeader
+{
+	char magic[8];
+	uint64_t dataSize;
+	int64_t time;
+	uint64_t numNodes;
+	uint64_t count; // number of following (node-number, hash) records
+};
+
+struct TTCacheRecord
+{
+	uint64_t n;
+	TigerHash hash;
 };
+
 // Typically contains 0 or 1 element, and only rarely 2 or more. But we need
 // the address of existing elements to remain stable when new elements are
 // inserted. So still use std::map instead of std::vector.
@@ -29,8 +64,80 @@ static size_t calcNumNodes(size_t dataSize)
 	return (numBlocks == 0) ? 1 : 2 * numBlocks - 1;
 }
 
+// The level of node 'n' in the linearized tree (see below).
+static size_t getLevel(size_t n)
+{
+	return (n + 1) & ~n;
+}
+
+static std::string getCacheDir()
+{
+	return FileOperations::getUserDataDir() + "/tthcache";
+}
+
+static std::string getCacheFilename(const std::string& name)
+{
+	auto sum = SHA1::calc(reinterpret_cast<const uint8_t*>(name.data()),
+	                      name.size());
+	return getCacheDir() + '/' + sum.toString();
+}
+
+static void loadPersistentCache(
+	TTCacheEntry& entry, size_t dataSize, const std::string& name)
+{
+	try {
+		File file(getCacheFilename(name));
+		TTCacheHeader header;
+		file.read(&header, sizeof(header));
+		if ((memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) ||
+		    (header.dataSize != dataSize) ||
+		    (header.time != entry.time) ||
+		    (header.numNodes != entry.numNodes) ||
+		    (header.count > entry.numNodes)) {
+			return; // stale or corrupt
+		}
+		std::vector<TTCacheRecord> records(header.count);
+		file.read(records.data(), records.size() * sizeof(TTCacheRecord));
+		for (auto& r : records) {
+			if ((r.n >= entry.numNodes) || entry.valid[r.n]) continue;
+			entry.hash[r.n] = r.hash;
+			entry.valid[r.n] = true;
+			entry.numNodesValid++;
+		}
+	} catch (FileException&) {
+		// no (valid) cache, ignore
+	}
+}
+
+static void savePersistentCache(
+	const TTCacheEntry& entry, size_t dataSize, const std::string& name,
+	size_t topNode)
+{
+	std::vector<TTCacheRecord> records;
+	for (auto n : xrange(entry.numNodes)) {
+		if (entry.valid[n] &&
+		    ((getLevel(n) >= CACHE_LEVEL) || (n == topNode))) {
+			records.push_back({n, entry.hash[n]});
+		}
+	}
+	TTCacheHeader header;
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.dataSize = dataSize;
+	header.time = entry.time;
+	header.numNodes = entry.numNodes;
+	header.count = records.size();
+	try {
+		FileOperations::mkdirp(getCacheDir());
+		File file(getCacheFilename(name), File::TRUNCATE);
+		file.write(&header, sizeof(header));
+		file.write(records.data(), records.size() * sizeof(TTCacheRecord));
+	} catch (FileException&) {
+		// ignore, it's only a cache
+	}
+}
+
 static TTCacheEntry& getCacheEntry(
-	TTData& data, size_t dataSize, const std::string& name)
+	TTData& data, size_t dataSize, const std::string& name, bool persistent)
 {
 	auto& result = ttCache[std::make_pair(dataSize, name)];
 	if (!data.isCacheStillValid(result.time)) { // note: has side effect
@@ -40,46 +147,127 @@ static TTCacheEntry& getCacheEntry(
 		result.numNodes = numNodes;
 		memset(result.valid.data(), 0, numNodes); // all invalid
 		result.numNodesValid = 0;
+		result.modified = false;
+		if (persistent) loadPersistentCache(result, dataSize, name);
 	}
 	return result;
 }
 
-TigerTree::TigerTree(TTData& data_, size_t dataSize_, const std::string& name)
+TigerTree::TigerTree(TTData& data_, size_t dataSize_, const std::string& name_,
+                     bool persistent_)
 	: data(data_)
 	, dataSize(dataSize_)
-	, entry(getCacheEntry(data, dataSize, name))
+	, name(name_)
+	, persistent(persistent_)
+	, entry(getCacheEntry(data, dataSize, name, persistent))
 {
 }
 
+TigerTree::~TigerTree()
+{
+	if (persistent && entry.modified) {
+		savePersistentCache(entry, dataSize, name, getTop().n);
+		entry.modified = false;
+	}
+}
+
 const TigerHash& TigerTree::calcHash(const std::function<void(size_t, size_t)>& progressCallback)
 {
-	return calcHash(getTop(), progressCallback);
+	auto top = getTop();
+	if (!entry.valid[top.n]) {
+		calcLeaves(top, progressCallback);
+	}
+	return calcHash(top, progressCallback);
 }
 
 void TigerTree::notifyChange(size_t offset, size_t len, time_t time)
 {
-	entry.time = time;
+	if (entry.time != time) {
+		entry.time = time;
+		entry.modified = true;
+	}
 
 	assert((offset + len) <= dataSize);
 	if (len == 0) return;
 
-	if (entry.valid[getTop().n]) {
-		entry.valid[getTop().n] = false; // set sentinel
-		entry.numNodesValid--;
-	}
+	auto top = getTop().n;
 	auto first = offset / BLOCK_SIZE;
 	auto last = (offset + len - 1) / BLOCK_SIZE;
 	assert(first <= last); // requires len != 0
 	do {
+		// Nodes loaded from the persistent cache can be valid while
+		// (some of) their children are not. So we can't stop at the
+		// first invalid node, instead always walk up to the top.
 		auto node = getLeaf(first);
-		while (entry.valid[node.n]) {
-			entry.valid[node.n] = false;
-			entry.numNodesValid--;
+		while (true) {
+			if (entry.valid[node.n]) {
+				entry.valid[node.n] = false;
+				entry.numNodesValid--;
+				entry.modified = true;
+			}
+			if (node.n == top) break;
 			node = getParent(node);
 		}
 	} while (++first <= last);
 }
 
+// Calls f(n) for every invalid full (not the partial last block) leaf node
+// that's needed to calculate the hash of the given node.
+template<typename F> void TigerTree::forEachInvalidLeaf(Node node, F f)
+{
+	if (entry.valid[node.n]) return;
+	if (node.l == 1) {
+		size_t b = node.n * (BLOCK_SIZE / 2);
+		if ((dataSize - b) >= BLOCK_SIZE) f(node.n);
+	} else {
+		forEachInvalidLeaf(getLeftChild (node), f);
+		forEachInvalidLeaf(getRightChild(node), f);
+	}
+}
+
+// Calculate the hash of (most of) the invalid leaf nodes below the given node.
+// Fetching the data goes via TTData, so that's done in this thread. But the
+// actual hash calculations are spread over several threads.
+void TigerTree::calcLeaves(Node node, const std::function<void(size_t, size_t)>& progressCallback)
+{
+	// Each block is preceded by some padding, tiger_leaf() temporarily
+	// overwrites the byte before the block.
+	static const size_t PAD = 8;
+	static const size_t STRIDE = PAD + BLOCK_SIZE;
+	MemBuffer<uint8_t> buffer;
+	std::vector<size_t> batch;
+	batch.reserve(BATCH_SIZE);
+
+	auto hashBatch = [&] {
+		buffer.resize(batch.size() * STRIDE);
+		for (auto i : xrange(batch.size())) {
+			size_t b = batch[i] * (BLOCK_SIZE / 2);
+			memcpy(&buffer[i * STRIDE + PAD], data.getData(b, BLOCK_SIZE),
+			       BLOCK_SIZE);
+		}
+		auto hashOne = [&](size_t i) {
+			tiger_leaf(&buffer[i * STRIDE + PAD], entry.hash[batch[i]]);
+		};
+		if (batch.size() < MIN_PARALLEL) {
+			for (auto i : xrange(batch.size())) hashOne(i);
+		} else {
+			workers.parallelFor(batch.size(), hashOne);
+		}
+		for (auto n : batch) entry.valid[n] = true;
+		entry.numNodesValid += batch.size();
+		if (progressCallback) {
+			progressCallback(entry.numNodesValid, entry.numNodes);
+		}
+		batch.clear();
+	};
+
+	forEachInvalidLeaf(node, [&](size_t n) {
+		batch.push_back(n);
+		if (batch.size() == BATCH_SIZE) hashBatch();
+	});
+	if (!batch.empty()) hashBatch();
+}
+
 const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t, size_t)>& progressCallback)
 {
 	auto n = node.n;
@@ -110,6 +298,7 @@ const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t,
 		}
 		entry.valid[n] = true;
 		entry.numNodesValid++;
+		if (getLevel(n) >= CACHE_LEVEL) entry.modified = true;
 		if (progressCallback) {
 			progressCallback(entry.numNodesValid, entry.numNodes);
 		}
@@ -28,6 +28,7 @@
 #ifndef TIGERTREE_HH
 #define TIGERTREE_HH
 
+#include "WorkerPool.hh"
 #include <string>
 #include <cstdint>
 #include <ctime>
@@ -73,9 +74,15 @@ class TigerTree
 {
 public:
 	/** Create TigerTree calculator for the given (abstract) data block
-	 * of given size.
+	 * of given size. When 'persistent' is set, the (upper part of the)
+	 * tree is also stored on disk, so that a later session doesn't need
+	 * to rehash all data. This requires that 'name' is a (resolved)
+	 * filename and TTData::isCacheStillValid() checks the modification
+	 * time of that file.
 	 */
-	TigerTree(TTData& data, size_t dataSize, const std::string& name);
+	TigerTree(TTData& data, size_t dataSize, const std::string& name,
+	          bool persistent = false);
+	~TigerTree();
 
 	/** Calculate the hash value.
 	 */
@@ -102,10 +109,15 @@ private:
 	Node getRightChild(Node node) const;
 
 	const TigerHash& calcHash(Node node, const std::function<void(size_t, size_t)>& progressCallback);
+	void calcLeaves(Node node, const std::function<void(size_t, size_t)>& progressCallback);
+	template<typename F> void forEachInvalidLeaf(Node node, F f);
 
 	TTData& data;
 	const size_t dataSize;
+	const std::string name;
+	const bool persistent;
 	TTCacheEntry& entry;
+	WorkerPool workers;
 };
 
 } // namespace openmsx
@@ -0,0 +1,24 @@
+#ifndef DEMANGLE_HH
+#define DEMANGLE_HH
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+/** Returns the readable form of a name returned by std::type_info::name().
+  * (MSVC already returns a readable name.) */
+inline std::string demangle(const char* name)
+{
+#ifdef __GNUC__
+	int status = 0;
+	std::unique_ptr<char, decltype(&std::free)> demangled(
+		abi::__cxa_demangle(name, nullptr, nullptr, &status), &std::free);
+	if (status == 0) return demangled.get();
+#endif
+	return name;
+}
+
+#endif
@@ -28,6 +28,13 @@ A million repetitions of "a"
 #ifdef __SSE2__
 #include <emmintrin.h> // SSE2
 #endif
+#if defined(__SHA__) && defined(__SSE4_1__)
+#include <immintrin.h> // SHA, SSE4.1
+#define SHA1_X86_SHA 1
+#elif defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+#include <arm_neon.h>
+#define SHA1_ARM_CRYPTO 1
+#endif
 
 using std::string;
 
@@ -266,16 +273,252 @@ SHA1::SHA1()
 	m_finalized = false;
 }
 
-void SHA1::transform(const uint8_t buffer[64])
+#if defined(SHA1_X86_SHA)
+
+// Version using the x86 SHA extensions. Processes 4 rounds per step, the
+// message schedule for later steps is calculated in parallel.
+template<int I> static inline void shaniRounds(
+	__m128i& abcd, __m128i& e0, __m128i& e1, __m128i msg[4],
+	const uint8_t* data, __m128i mask)
+{
+	__m128i& e    = (I & 1) ? e1 : e0;
+	__m128i& next = (I & 1) ? e0 : e1;
+	if (I < 4) {
+		msg[I % 4] = _mm_shuffle_epi8(_mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + 16 * (I % 4))), mask);
+	}
+	e = (I == 0) ? _mm_add_epi32(e, msg[0])
+	             : _mm_sha1nexte_epu32(e, msg[I % 4]);
+	next = abcd;
+	if ((3 <= I) && (I <= 18)) {
+		msg[(I + 1) % 4] = _mm_sha1msg2_epu32(msg[(I + 1) % 4], msg[I % 4]);
+	}
+	abcd = _mm_sha1rnds4_epu32(abcd, e, I / 5);
+	if ((1 <= I) && (I <= 16)) {
+		msg[(I + 3) % 4] = _mm_sha1msg1_epu32(msg[(I + 3) % 4], msg[I % 4]);
+	}
+	if ((2 <= I) && (I <= 17)) {
+		msg[(I + 2) % 4] = _mm_xor_si128(msg[(I + 2) % 4], msg[I % 4]);
+	}
+}
+
+static void transformBlocks(uint32_t state[5], const uint8_t* data, size_t numBlocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+	__m128i abcd = _mm_shuffle_epi32(
+		_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+	__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+	__m128i e1;
+	__m128i msg[4];
+
+	for (/**/; numBlocks != 0; --numBlocks, data += 64) {
+		__m128i abcdSave = abcd;
+		__m128i e0Save = e0;
+		shaniRounds< 0>(abcd, e0, e1, msg, data, mask);
+		shaniRounds< 1>(abcd, e0, e1, msg, data, mask);
+		shaniRounds< 2>(abcd, e0, e1, msg, data, mask);
+		shaniRounds< 3>(abcd, e0, e1, msg, data, mask);
+		shaniRounds< 4>(abcd, e0, e1, msg, data, mask);
+		shaniRounds< 5>(abcd, e0, e1, msg, data, mask);
+		shaniRounds< 6>(abcd, e0, e1, msg, data, mask);
+		shaniRounds< 7>(abcd, e0, e1, msg, data, mask);
+		shaniRounds< 8>(abcd, e0, e1, msg, data, mask);
+		shaniRounds< 9>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<10>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<11>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<12>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<13>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<14>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<15>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<16>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<17>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<18>(abcd, e0, e1, msg, data, mask);
+		shaniRounds<19>(abcd, e0, e1, msg, data, mask);
+		e0 = _mm_sha1nexte_epu32(e0, e0Save);
+		abcd = _mm_add_epi32(abcd, abcdSave);
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+	                 _mm_shuffle_epi32(abcd, 0x1B));
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+
+#elif defined(SHA1_ARM_CRYPTO)
+
+// Version using the ARMv8 crypto extensions.
+static void transformBlocks(uint32_t state[5], const uint8_t* data, size_t numBlocks)
+{
+	const uint32x4_t k0 = vdupq_n_u32(0x5A827999);
+	const uint32x4_t k1 = vdupq_n_u32(0x6ED9EBA1);
+	const uint32x4_t k2 = vdupq_n_u32(0x8F1BBCDC);
+	const uint32x4_t k3 = vdupq_n_u32(0xCA62C1D6);
+
+	uint32x4_t abcd = vld1q_u32(state);
+	uint32_t e0 = state[4];
+
+	for (/**/; numBlocks != 0; --numBlocks, data += 64) {
+		uint32x4_t abcdSave = abcd;
+		uint32_t e0Save = e0;
+		uint32_t e1;
+
+		uint32x4_t msg0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data +  0)));
+		uint32x4_t msg1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16)));
+		uint32x4_t msg2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 32)));
+		uint32x4_t msg3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 48)));
+
+		uint32x4_t tmp0 = vaddq_u32(msg0, k0);
+		uint32x4_t tmp1 = vaddq_u32(msg1, k0);
+
+		// Rounds 0-3
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1cq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg2, k0);
+		msg0 = vsha1su0q_u32(msg0, msg1, msg2);
+
+		// Rounds 4-7
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1cq_u32(abcd, e1, tmp1);
+		tmp1 = vaddq_u32(msg3, k0);
+		msg0 = vsha1su1q_u32(msg0, msg3);
+		msg1 = vsha1su0q_u32(msg1, msg2, msg3);
+
+		// Rounds 8-11
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1cq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg0, k0);
+		msg1 = vsha1su1q_u32(msg1, msg0);
+		msg2 = vsha1su0q_u32(msg2, msg3, msg0);
+
+		// Rounds 12-15
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1cq_u32(abcd, e1, tmp1);
+		tmp1 = vaddq_u32(msg1, k1);
+		msg2 = vsha1su1q_u32(msg2, msg1);
+		msg3 = vsha1su0q_u32(msg3, msg0, msg1);
+
+		// Rounds 16-19
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1cq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg2, k1);
+		msg3 = vsha1su1q_u32(msg3, msg2);
+		msg0 = vsha1su0q_u32(msg0, msg1, msg2);
+
+		// Rounds 20-23
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e1, tmp1);
+		tmp1 = vaddq_u32(msg3, k1);
+		msg0 = vsha1su1q_u32(msg0, msg3);
+		msg1 = vsha1su0q_u32(msg1, msg2, msg3);
+
+		// Rounds 24-27
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg0, k1);
+		msg1 = vsha1su1q_u32(msg1, msg0);
+		msg2 = vsha1su0q_u32(msg2, msg3, msg0);
+
+		// Rounds 28-31
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e1, tmp1);
+		tmp1 = vaddq_u32(msg1, k1);
+		msg2 = vsha1su1q_u32(msg2, msg1);
+		msg3 = vsha1su0q_u32(msg3, msg0, msg1);
+
+		// Rounds 32-35
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg2, k2);
+		msg3 = vsha1su1q_u32(msg3, msg2);
+		msg0 = vsha1su0q_u32(msg0, msg1, msg2);
+
+		// Rounds 36-39
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e1, tmp1);
+		tmp1 = vaddq_u32(msg3, k2);
+		msg0 = vsha1su1q_u32(msg0, msg3);
+		msg1 = vsha1su0q_u32(msg1, msg2, msg3);
+
+		// Rounds 40-43
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1mq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg0, k2);
+		msg1 = vsha1su1q_u32(msg1, msg0);
+		msg2 = vsha1su0q_u32(msg2, msg3, msg0);
+
+		// Rounds 44-47
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1mq_u32(abcd, e1, tmp1);
+		tmp1 = vaddq_u32(msg1, k2);
+		msg2 = vsha1su1q_u32(msg2, msg1);
+		msg3 = vsha1su0q_u32(msg3, msg0, msg1);
+
+		// Rounds 48-51
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1mq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg2, k2);
+		msg3 = vsha1su1q_u32(msg3, msg2);
+		msg0 = vsha1su0q_u32(msg0, msg1, msg2);
+
+		// Rounds 52-55
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1mq_u32(abcd, e1, tmp1);
+		tmp1 = vaddq_u32(msg3, k3);
+		msg0 = vsha1su1q_u32(msg0, msg3);
+		msg1 = vsha1su0q_u32(msg1, msg2, msg3);
+
+		// Rounds 56-59
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1mq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg0, k3);
+		msg1 = vsha1su1q_u32(msg1, msg0);
+		msg2 = vsha1su0q_u32(msg2, msg3, msg0);
+
+		// Rounds 60-63
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e1, tmp1);
+		tmp1 = vaddq_u32(msg1, k3);
+		msg2 = vsha1su1q_u32(msg2, msg1);
+		msg3 = vsha1su0q_u32(msg3, msg0, msg1);
+
+		// Rounds 64-67
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg2, k3);
+		msg3 = vsha1su1q_u32(msg3, msg2);
+
+		// Rounds 68-71
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e1, tmp1);
+		tmp1 = vaddq_u32(msg3, k3);
+
+		// Rounds 72-75
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e0, tmp0);
+
+		// Rounds 76-79
+		e0 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1pq_u32(abcd, e1, tmp1);
+
+		e0 += e0Save;
+		abcd = vaddq_u32(abcdSave, abcd);
+	}
+
+	vst1q_u32(state, abcd);
+	state[4] = e0;
+}
+
+#else
+
+static void transformScalar(uint32_t state[5], const uint8_t buffer[64])
 {
 	WorkspaceBlock block(buffer);
 
-	// Copy m_state[] to working vars
-	uint32_t a = m_state.a[0];
-	uint32_t b = m_state.a[1];
-	uint32_t c = m_state.a[2];
-	uint32_t d = m_state.a[3];
-	uint32_t e = m_state.a[4];
+	// Copy state[] to working vars
+	uint32_t a = state[0];
+	uint32_t b = state[1];
+	uint32_t c = state[2];
+	uint32_t d = state[3];
+	uint32_t e = state[4];
 
 	// 4 rounds of 20 operations each. Loop unrolled
 	block.r0(a,b,c,d,e, 0); block.r0(e,a,b,c,d, 1); block.r0(d,e,a,b,c, 2);
@@ -306,12 +549,26 @@ void SHA1::transform(const uint8_t buffer[64])
 	block.r4(a,b,c,d,e,75); block.r4(e,a,b,c,d,76); block.r4(d,e,a,b,c,77);
 	block.r4(c,d,e,a,b,78); block.r4(b,c,d,e,a,79);
 
-	// Add the working vars back into m_state[]
-	m_state.a[0] += a;
-	m_state.a[1] += b;
-	m_state.a[2] += c;
-	m_state.a[3] += d;
-	m_state.a[4] += e;
+	// Add the working vars back into state[]
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+static void transformBlocks(uint32_t state[5], const uint8_t* data, size_t numBlocks)
+{
+	for (/**/; numBlocks != 0; --numBlocks, data += 64) {
+		transformScalar(state, data);
+	}
+}
+
+#endif
+
+void SHA1::transform(const uint8_t* data, size_t numBlocks)
+{
+	transformBlocks(m_state.a, data, numBlocks);
 }
 
 // Use this function to hash in binary data and strings
@@ -325,10 +582,10 @@ void SHA1::update(const uint8_t* data, size_t len)
 	size_t i;
 	if ((j + len) > 63) {
 		memcpy(&m_buffer[j], data, (i = 64 - j));
-		transform(m_buffer);
-		for (; i + 63 < len; i += 64) {
-			transform(&data[i]);
-		}
+		transform(m_buffer, 1);
+		size_t numBlocks = (len - i) / 64;
+		transform(&data[i], numBlocks);
+		i += 64 * numBlocks;
 		j = 0;
 	} else {
 		i = 0;
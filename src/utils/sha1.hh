@@ -91,7 +91,9 @@ public:
 	static Sha1Sum calc(const uint8_t* data, size_t len);
 
 private:
-	void transform(const uint8_t buffer[64]);
+	/** Process 'numBlocks' consecutive blocks of 64 bytes. Depending on
+	  * the target CPU this uses the x86 SHA or ARMv8 crypto instructions. */
+	void transform(const uint8_t* data, size_t numBlocks);
 	void finalize();
 
 	uint64_t m_count;
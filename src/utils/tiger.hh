@@ -52,7 +52,7 @@ void tiger_int(const TigerHash& h0, const TigerHash& h1, TigerHash& result);
 /** Use for tiger-tree leaf node hash calculations.
  * Take a 1024-byte input block, add some marker/padding/length bytes
  * before/after and calculate a tiger-hash.
- * This function is not reentrant.
+ * This function is reentrant (it can run in parallel on different blocks).
  * This function requires that data[-1] can be (temporarily) overridden (so
  * after the function returns the data buffer is unchanged, but temporarily
  * it is changed, hence the parameter cannot be const).
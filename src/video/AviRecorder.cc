@@ -1,5 +1,6 @@
 #include "AviRecorder.hh"
 #include "AviWriter.hh"
+#include "PipeEncoder.hh"
 #include "WavWriter.hh"
 #include "Reactor.hh"
 #include "MSXMotherBoard.hh"
@@ -12,12 +13,19 @@
 #include "Filename.hh"
 #include "CliComm.hh"
 #include "FileOperations.hh"
+#include "FrameSource.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
+#include "Timer.hh"
+#include "build-info.hh"
 #include "outer.hh"
+#include "strCat.hh"
 #include "view.hh"
 #include "vla.hh"
+#include "xrange.hh"
+#include <SDL.h>
 #include <cassert>
+#include <cstring>
 #include <memory>
 
 using std::string;
@@ -32,17 +40,20 @@ AviRecorder::AviRecorder(Reactor& reactor_)
 	, duration(EmuDuration::infinity)
 	, prevTime(EmuTime::infinity)
 	, frameHeight(0)
+	, writeError(false)
+	, queuedFrames(0)
 {
 }
 
 AviRecorder::~AviRecorder()
 {
-	assert(!aviWriter);
+	assert(!videoWriter);
 	assert(!wavWriter);
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
-                        bool recordStereo, const Filename& filename)
+                        bool recordStereo, const Filename& filename,
+                        const string& pipeCommand)
 {
 	stop();
 	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
@@ -79,14 +90,23 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		}
 		// any source is fine because they all have the same bpp
 		unsigned bpp = postProcessors.front()->getBpp();
+		pixelSize = (bpp == 32) ? 4 : 2;
 		warnedFps = false;
 		duration = EmuDuration::infinity;
 		prevTime = EmuTime::infinity;
 
 		try {
-			aviWriter = std::make_unique<AviWriter>(
-				filename, frameWidth, frameHeight, bpp,
-				(recordAudio && stereo) ? 2 : 1, sampleRate);
+			unsigned channels = (recordAudio && stereo) ? 2 : 1;
+			if (pipeCommand.empty()) {
+				videoWriter = std::make_unique<AviWriter>(
+					filename, frameWidth, frameHeight, bpp,
+					channels, sampleRate);
+			} else {
+				videoWriter = std::make_unique<PipeEncoder>(
+					pipeCommand, filename.getResolved(),
+					frameWidth, frameHeight, channels,
+					recordAudio ? sampleRate : 0);
+			}
 		} catch (MSXException& e) {
 			throw CommandException("Can't start recording: ",
 			                       e.getMessage());
@@ -96,6 +116,12 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		wavWriter = std::make_unique<Wav16Writer>(
 			filename, stereo ? 2 : 1, sampleRate);
 	}
+	writeError = false;
+	warnedWriteError = false;
+	queuedFrames = 0;
+	droppedFrames = 0;
+	startRealTime = Timer::getTime();
+	recordedSamples = 0;
 	// only set recorders when all errors are checked for
 	for (auto* pp : postProcessors) {
 		pp->setRecorder(this);
@@ -114,8 +140,44 @@ void AviRecorder::stop()
 		mixer = nullptr;
 	}
 	sampleRate = 0;
-	aviWriter.reset();
-	wavWriter.reset();
+	if (videoWriter || wavWriter) {
+		if (wavWriter) flushWave();
+		writerThread.waitIdle();
+		warnWriteError();
+		videoWriter.reset();
+		wavWriter.reset();
+	}
+	framePool.clear();
+	audioBuf.clear();
+}
+
+void AviRecorder::warnWriteError()
+{
+	if (writeError && !warnedWriteError) {
+		warnedWriteError = true;
+		reactor.getCliComm().printWarning(
+			"Error while writing ", (videoWriter ? "video" : "sound"),
+			" recording: ", writeErrorMsg);
+	}
+}
+
+void AviRecorder::flushWave()
+{
+	if (audioBuf.empty()) return;
+	// Hand the converted samples over to the worker thread. The writer
+	// itself is only destroyed in stop(), after all jobs have finished.
+	unsigned channels = stereo ? 2 : 1;
+	writerThread.push([this, channels, buf = std::move(audioBuf)] {
+		if (writeError) return;
+		try {
+			wavWriter->write(buf.data(), channels,
+			                 unsigned(buf.size() / channels));
+		} catch (MSXException& e) {
+			writeErrorMsg = e.getMessage();
+			writeError = true;
+		}
+	});
+	audioBuf.clear(); // moved-from, but now in a known state
 }
 
 static int16_t float2int16(float f)
@@ -137,12 +199,7 @@ void AviRecorder::addWave(unsigned num, float* fdata)
 		for (unsigned i = 0; i < 2 * num; ++i) {
 			buf[i] = float2int16(fdata[i]);
 		}
-		if (wavWriter) {
-			wavWriter->write(buf, 2, num);
-		} else {
-			assert(aviWriter);
-			audioBuf.insert(end(audioBuf), buf, buf + 2 * num);
-		}
+		audioBuf.insert(end(audioBuf), buf, buf + 2 * num);
 	} else {
 		VLA(int16_t, buf, num);
 		unsigned i = 0;
@@ -162,12 +219,43 @@ void AviRecorder::addWave(unsigned num, float* fdata)
 			buf[i] = float2int16((fdata[2 * i + 0] + fdata[2 * i + 1]) * 0.5f);
 		}
 
-		if (wavWriter) {
-			wavWriter->write(buf, 1, num);
-		} else {
-			assert(aviWriter);
-			audioBuf.insert(end(audioBuf), buf, buf + num);
+		audioBuf.insert(end(audioBuf), buf, buf + num);
+	}
+	recordedSamples += num;
+
+	if (wavWriter) {
+		warnWriteError();
+		// Write in chunks of about 0.25s, for AVI files the audio is
+		// written together with the next video frame.
+		if (audioBuf.size() >= (sampleRate / 4) * (stereo ? 2 : 1)) {
+			flushWave();
 		}
+	} else {
+		assert(videoWriter);
+	}
+}
+
+namespace {
+// A frame (and the audio that goes with it) on its way to the encoder.
+struct VideoFrame {
+	MemBuffer<uint8_t> pixels; // empty for a dropped frame
+	SDL_PixelFormat format;
+	std::vector<int16_t> audio;
+};
+}
+
+template<typename Pixel>
+void AviRecorder::copyFrame(FrameSource& frame, Pixel* dst)
+{
+	for (auto y : xrange(frameHeight)) {
+		const Pixel* line;
+		switch (frameHeight) {
+		case 240: line = frame.getLinePtr320_240(y, dst); break;
+		case 480: line = frame.getLinePtr640_480(y, dst); break;
+		default:  line = frame.getLinePtr960_720(y, dst); break;
+		}
+		if (line != dst) memcpy(dst, line, frameWidth * sizeof(Pixel));
+		dst += frameWidth;
 	}
 }
 
@@ -184,15 +272,66 @@ void AviRecorder::addImage(FrameSource* frame, EmuTime::param time)
 		}
 	} else if (prevTime != EmuTime::infinity) {
 		duration = time - prevTime;
-		aviWriter->setFps(1.0 / duration.toDouble());
+		float fps = 1.0 / duration.toDouble();
+		writerThread.push([this, fps] { videoWriter->setFps(fps); });
 	}
 	prevTime = time;
 
 	if (mixer) {
 		mixer->updateStream(time);
 	}
-	aviWriter->addFrame(frame, unsigned(audioBuf.size()), audioBuf.data());
-	audioBuf.clear();
+	warnWriteError();
+
+	// Only the emulation thread can access the frame, so copy it. The
+	// encoding happens on the writer thread.
+	auto f = std::make_shared<VideoFrame>();
+	f->format = frame->getSDLPixelFormat();
+	f->audio = std::move(audioBuf);
+	audioBuf.clear(); // moved-from, but now in a known state
+	if (queuedFrames < MAX_QUEUED_FRAMES) {
+		++queuedFrames;
+		{
+			std::lock_guard<std::mutex> lock(framePoolMutex);
+			if (!framePool.empty()) {
+				f->pixels = std::move(framePool.back());
+				framePool.pop_back();
+			}
+		}
+		if (f->pixels.empty()) {
+			f->pixels.resize(frameWidth * frameHeight * pixelSize);
+		}
+#if HAVE_32BPP
+		if (pixelSize == 4) {
+			copyFrame(*frame, reinterpret_cast<uint32_t*>(f->pixels.data()));
+		} else
+#endif
+		{
+#if HAVE_16BPP
+			copyFrame(*frame, reinterpret_cast<uint16_t*>(f->pixels.data()));
+#endif
+		}
+	} else {
+		++droppedFrames;
+	}
+
+	writerThread.push([this, f] {
+		bool dropped = f->pixels.empty();
+		if (!writeError) {
+			try {
+				videoWriter->addFrame(
+					dropped ? nullptr : f->pixels.data(), f->format,
+					unsigned(f->audio.size()), f->audio.data());
+			} catch (MSXException& e) {
+				writeErrorMsg = e.getMessage();
+				writeError = true;
+			}
+		}
+		if (!dropped) {
+			std::lock_guard<std::mutex> lock(framePoolMutex);
+			framePool.push_back(std::move(f->pixels));
+			--queuedFrames;
+		}
+	});
 }
 
 // TODO: Can this be dropped?
@@ -210,8 +349,10 @@ void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens
 	bool recordStereo = false;
 	bool doubleSize   = false;
 	bool tripleSize   = false;
+	string pipeCommand;
 	ArgsInfo info[] = {
 		valueArg("-prefix", prefix),
+		valueArg("-pipe", pipeCommand),
 		flagArg("-audioonly", audioOnly),
 		flagArg("-videoonly", videoOnly),
 		flagArg("-mono",      recordMono),
@@ -233,6 +374,9 @@ void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens
 	if (videoOnly && (recordStereo || recordMono)) {
 		throw CommandException("Can't have both -videoonly and -stereo or -mono.");
 	}
+	if (audioOnly && !pipeCommand.empty()) {
+		throw CommandException("Can't have both -audioonly and -pipe.");
+	}
 	string_view filenameArg;
 	switch (arguments.size()) {
 	case 0:
@@ -257,16 +401,23 @@ void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens
 	bool recordAudio = !videoOnly;
 	bool recordVideo = !audioOnly;
 	string directory = recordVideo ? "videos" : "soundlogs";
-	string extension = recordVideo ? ".avi"   : ".wav";
+	string extension = !recordVideo         ? ".wav"
+	                 : pipeCommand.empty() ? ".avi"
+	                                       : ".mkv";
 	string filename = FileOperations::parseCommandFileArgument(
 		filenameArg, directory, prefix, extension);
 
-	if (aviWriter || wavWriter) {
+	if (videoWriter || wavWriter) {
 		result = "Already recording.";
 	} else {
 		start(recordAudio, recordVideo, recordMono, recordStereo,
-				Filename(filename));
-		result = "Recording to " + filename;
+				Filename(filename), pipeCommand);
+		if (!pipeCommand.empty() && recordAudio) {
+			result = strCat("Recording to ", filename, ", audio to ",
+			                PipeEncoder::getAudioFilename(filename));
+		} else {
+			result = "Recording to " + filename;
+		}
 	}
 }
 
@@ -277,7 +428,7 @@ void AviRecorder::processStop(span<const TclObject> /*tokens*/)
 
 void AviRecorder::processToggle(Interpreter& interp, span<const TclObject> tokens, TclObject& result)
 {
-	if (aviWriter || wavWriter) {
+	if (videoWriter || wavWriter) {
 		// drop extra tokens
 		processStop(tokens.first<2>());
 	} else {
@@ -287,7 +438,22 @@ void AviRecorder::processToggle(Interpreter& interp, span<const TclObject> token
 
 void AviRecorder::status(span<const TclObject> /*tokens*/, TclObject& result) const
 {
-	result.addDictKeyValue("status", (aviWriter || wavWriter) ? "recording" : "idle");
+	bool recording = videoWriter || wavWriter;
+	result.addDictKeyValue("status", recording ? "recording" : "idle");
+	if (recording && mixer) {
+		// Recorded (emulated) time versus elapsed real time, e.g. to
+		// monitor unthrottled offline rendering.
+		double seconds = double(recordedSamples) / sampleRate;
+		double elapsed = (Timer::getTime() - startRealTime) / 1000000.0;
+		result.addDictKeyValue("duration", seconds);
+		if (elapsed > 0.0) {
+			result.addDictKeyValue("realtime_factor", seconds / elapsed);
+		}
+	}
+	if (videoWriter) {
+		result.addDictKeyValue("queued_frames", int(queuedFrames));
+		result.addDictKeyValue("dropped_frames", int(droppedFrames));
+	}
 }
 
 // class AviRecorder::Cmd
@@ -322,10 +488,15 @@ string AviRecorder::Cmd::help(const vector<string>& /*tokens*/) const
 	       "record start -prefix foo  Record to file 'fooNNNN.avi'\n"
 	       "record stop               Stop recording\n"
 	       "record toggle             Toggle recording (useful as keybinding)\n"
-	       "record status             Query recording state\n"
+	       "record status             Query recording state (including queued\n"
+	       "                          and dropped frames for videos)\n"
 	       "\n"
 	       "The start subcommand also accepts an optional -audioonly, -videoonly, "
 	       " -mono, -stereo, -doublesize, -triplesize flag.\n"
+	       "With '-pipe <command>' the frames are sent (as raw rgb24) to the "
+	       "standard input of an external encoder instead, e.g. ffmpeg. In "
+	       "the command {width}, {height}, {fps} and {output} are replaced by "
+	       "their values. The audio is then written to a separate .wav file.\n"
 	       "Videos are recorded in a 320x240 size by default, at 640x480 when the "
 	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.";
 }
@@ -340,7 +511,7 @@ void AviRecorder::Cmd::tabCompletion(vector<string>& tokens) const
 	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
 		static const char* const options[] = {
 			"-prefix", "-videoonly", "-audioonly", "-doublesize", "-triplesize",
-			"-mono", "-stereo",
+			"-mono", "-stereo", "-pipe",
 		};
 		completeFileName(tokens, userFileContext(), options);
 	}
@@ -3,14 +3,18 @@
 
 #include "Command.hh"
 #include "EmuTime.hh"
+#include "MemBuffer.hh"
+#include "WorkerThread.hh"
 #include "span.hh"
+#include <atomic>
 #include <cstdint>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <memory>
 
 namespace openmsx {
 
-class AviWriter;
 class Filename;
 class FrameSource;
 class Interpreter;
@@ -18,6 +22,7 @@ class MSXMixer;
 class PostProcessor;
 class Reactor;
 class TclObject;
+class VideoEncoder;
 class Wav16Writer;
 
 class AviRecorder
@@ -33,8 +38,12 @@ public:
 
 private:
 	void start(bool recordAudio, bool recordVideo, bool recordMono,
-		   bool recordStereo, const Filename& filename);
+		   bool recordStereo, const Filename& filename,
+		   const std::string& pipeCommand);
 	void status(span<const TclObject> tokens, TclObject& result) const;
+	void flushWave();
+	void warnWriteError();
+	template<typename Pixel> void copyFrame(FrameSource& frame, Pixel* dst);
 
 	void processStart (Interpreter& interp, span<const TclObject> tokens, TclObject& result);
 	void processStop  (span<const TclObject> tokens);
@@ -50,8 +59,8 @@ private:
 	} recordCommand;
 
 	std::vector<int16_t> audioBuf;
-	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
-	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
+	std::unique_ptr<VideoEncoder> videoWriter; // can be nullptr
+	std::unique_ptr<Wav16Writer>  wavWriter;   // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
 	MSXMixer* mixer;
 	EmuDuration duration;
@@ -63,6 +72,27 @@ private:
 	bool warnedSampleRate;
 	bool warnedStereo;
 	bool stereo;
+
+	// Recordings are written to disk on a background thread, so that
+	// (unthrottled) emulation doesn't wait for file I/O. For videos also
+	// the encoding of the frames is done on that thread.
+	WorkerThread writerThread;
+	std::string writeErrorMsg; // only valid when 'writeError' is set
+	std::atomic<bool> writeError;
+	bool warnedWriteError;
+
+	// Copied frames that still have to be encoded. When the encoder can't
+	// keep up and there are MAX_QUEUED_FRAMES, new frames are dropped
+	// (the previous frame is repeated, so audio and video stay in sync).
+	static const unsigned MAX_QUEUED_FRAMES = 8;
+	std::atomic<unsigned> queuedFrames;
+	unsigned droppedFrames;
+	unsigned pixelSize;
+	std::mutex framePoolMutex;
+	std::vector<MemBuffer<uint8_t>> framePool; // buffers for reuse
+
+	uint64_t startRealTime;   // in us
+	uint64_t recordedSamples; // per channel
 };
 
 } // namespace openmsx
@@ -249,12 +249,13 @@ void AviWriter::addAviChunk(const char* tag, unsigned size, void* data, unsigned
 	index[idxSize + 3] = size;
 }
 
-void AviWriter::addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData)
+void AviWriter::addFrame(const void* pixels, const SDL_PixelFormat& pixelFormat,
+                         unsigned samples, int16_t* sampleData)
 {
 	bool keyFrame = (frames++ % 300 == 0);
 	void* buffer;
 	unsigned size;
-	codec.compressFrame(keyFrame, frame, buffer, size);
+	codec.compressFrame(keyFrame, pixels, pixelFormat, buffer, size);
 	addAviChunk("00dc", size, buffer, keyFrame ? 0x10 : 0x0);
 
 	if (samples) {
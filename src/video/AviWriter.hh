@@ -3,6 +3,7 @@
 #ifndef AVIWRITER_HH
 #define AVIWRITER_HH
 
+#include "VideoEncoder.hh"
 #include "ZMBVEncoder.hh"
 #include "File.hh"
 #include "endian.hh"
@@ -12,16 +13,17 @@
 namespace openmsx {
 
 class Filename;
-class FrameSource;
 
-class AviWriter
+/** Writes ZMBV compressed video (and uncompressed audio) to an AVI file. */
+class AviWriter final : public VideoEncoder
 {
 public:
 	AviWriter(const Filename& filename, unsigned width, unsigned height,
 	          unsigned bpp, unsigned channels, unsigned freq);
-	~AviWriter();
-	void addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData);
-	void setFps(float fps_) { fps = fps_; }
+	~AviWriter() override;
+	void addFrame(const void* pixels, const SDL_PixelFormat& pixelFormat,
+	              unsigned samples, int16_t* sampleData) override;
+	void setFps(float fps_) override { fps = fps_; }
 
 private:
 	void addAviChunk(const char* tag, unsigned size, void* data, unsigned flags);
@@ -5,6 +5,9 @@
 #include "build-info.hh"
 #include "components.hh"
 #include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -272,12 +275,94 @@ void BitmapConverter<Pixel>::renderGraphic7(
 	}
 }
 
+#ifdef __SSE2__
+// Calculate the color index for 8 pixels (2 groups of 4 pixels). The input
+// contains one VRAM byte per 16-bit lane, in display order. The result is an
+// index in palette32768, or for YAE pixels (only when YAE=true) an index in
+// palette16 with bit 15 set.
+template<bool YAE> static inline __m128i yjkIndices(__m128i p)
+{
+	// j and k are stored in the low 3 bits of 2 bytes each (low part
+	// unsigned, high part signed):
+	//   k = (p0 & 7) + 8 * sext3(p1 & 7)
+	//   j = (p2 & 7) + 8 * sext3(p3 & 7)
+	const __m128i oddLanes = _mm_set_epi16(4, 0, 4, 0, 4, 0, 4, 0);
+	const __m128i weights  = _mm_set_epi16(8, 1, 8, 1, 8, 1, 8, 1);
+	__m128i t = _mm_and_si128(p, _mm_set1_epi16(7));
+	t = _mm_sub_epi16(_mm_xor_si128(t, oddLanes), oddLanes); // sign extend
+	__m128i kj32 = _mm_madd_epi16(t, weights); // k0 j0 k1 j1 (32-bit)
+	__m128i kj = _mm_packs_epi32(kj32, kj32);
+	// broadcast to all 4 pixels in the group
+	__m128i k = _mm_shufflehi_epi16(_mm_shufflelo_epi16(kj, 0x00), 0xAA);
+	__m128i j = _mm_shufflehi_epi16(_mm_shufflelo_epi16(kj, 0x55), 0xFF);
+
+	// Note: 'b' uses an arithmetic shift instead of a division by 4. This
+	// only differs for negative values, which are clipped to 0 anyway.
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max  = _mm_set1_epi16(31);
+	__m128i y = _mm_srli_epi16(p, 3);
+	__m128i y5 = _mm_add_epi16(_mm_slli_epi16(y, 2), y);
+	__m128i b0 = _mm_sub_epi16(_mm_sub_epi16(y5, _mm_add_epi16(j, j)), k);
+	__m128i r = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, j), zero), max);
+	__m128i g = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, k), zero), max);
+	__m128i b = _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(b0, 2), zero), max);
+	__m128i col = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 10),
+	                                        _mm_slli_epi16(g, 5)),
+	                           b);
+	if (YAE) {
+		const __m128i yaeBit = _mm_set1_epi16(0x08);
+		__m128i isYae = _mm_cmpeq_epi16(_mm_and_si128(p, yaeBit), yaeBit);
+		__m128i idx16 = _mm_or_si128(_mm_srli_epi16(p, 4),
+		                             _mm_set1_epi16(-0x8000));
+		col = _mm_or_si128(_mm_and_si128   (isYae, idx16),
+		                   _mm_andnot_si128(isYae, col));
+	}
+	return col;
+}
+
+// The color calculations are done in SSE registers, only the final palette
+// lookups are done one pixel at a time.
+template<bool YAE, typename Pixel>
+static inline void renderYJKSSE2(
+	Pixel*      __restrict pixelPtr,
+	const byte* __restrict vramPtr0,
+	const byte* __restrict vramPtr1,
+	const Pixel* __restrict palette16,
+	const Pixel* __restrict palette32768)
+{
+	const __m128i zero = _mm_setzero_si128();
+	for (unsigned i = 0; i < 128; i += 16) {
+		// 32 pixels per iteration
+		__m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr0 + i));
+		__m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr1 + i));
+		__m128i lo = _mm_unpacklo_epi8(v0, v1);
+		__m128i hi = _mm_unpackhi_epi8(v0, v1);
+		alignas(16) uint16_t idx[32];
+		auto* idx128 = reinterpret_cast<__m128i*>(idx);
+		_mm_store_si128(idx128 + 0, yjkIndices<YAE>(_mm_unpacklo_epi8(lo, zero)));
+		_mm_store_si128(idx128 + 1, yjkIndices<YAE>(_mm_unpackhi_epi8(lo, zero)));
+		_mm_store_si128(idx128 + 2, yjkIndices<YAE>(_mm_unpacklo_epi8(hi, zero)));
+		_mm_store_si128(idx128 + 3, yjkIndices<YAE>(_mm_unpackhi_epi8(hi, zero)));
+		for (unsigned n = 0; n < 32; ++n) {
+			unsigned c = idx[n];
+			pixelPtr[2 * i + n] = (YAE && (c & 0x8000))
+			                    ? palette16[c & 15]
+			                    : palette32768[c];
+		}
+	}
+}
+#endif
+
 template <class Pixel>
 void BitmapConverter<Pixel>::renderYJK(
 	Pixel*      __restrict pixelPtr,
 	const byte* __restrict vramPtr0,
 	const byte* __restrict vramPtr1)
 {
+#ifdef __SSE2__
+	renderYJKSSE2<false>(pixelPtr, vramPtr0, vramPtr1,
+	                     palette16, palette32768);
+#else
 	for (unsigned i = 0; i < 64; ++i) {
 		unsigned p[4];
 		p[0] = vramPtr0[2 * i + 0];
@@ -297,6 +382,7 @@ void BitmapConverter<Pixel>::renderYJK(
 			pixelPtr[4 * i + n] = palette32768[col];
 		}
 	}
+#endif
 }
 
 template <class Pixel>
@@ -305,6 +391,10 @@ void BitmapConverter<Pixel>::renderYAE(
 	const byte* __restrict vramPtr0,
 	const byte* __restrict vramPtr1)
 {
+#ifdef __SSE2__
+	renderYJKSSE2<true>(pixelPtr, vramPtr0, vramPtr1,
+	                    palette16, palette32768);
+#else
 	for (unsigned i = 0; i < 64; ++i) {
 		unsigned p[4];
 		p[0] = vramPtr0[2 * i + 0];
@@ -331,6 +421,7 @@ void BitmapConverter<Pixel>::renderYAE(
 			pixelPtr[4 * i + n] = pix;
 		}
 	}
+#endif
 }
 
 template <class Pixel>
@@ -92,6 +92,30 @@ static inline __m128i select(__m128i a0, __m128i a1, __m128i mask)
 template<typename Pixel> static inline void draw6(
 	Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, byte pattern)
 {
+#ifdef __SSE2__
+	// SSE2 version, 32bpp
+	if (sizeof(Pixel) == 4) {
+		const __m128i m74 = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+		const __m128i m32 = _mm_set_epi32(0x00, 0x00, 0x04, 0x08);
+		const __m128i zero = _mm_setzero_si128();
+
+		__m128i fg4 = _mm_set1_epi32(fg);
+		__m128i bg4 = _mm_set1_epi32(bg);
+		__m128i pat = _mm_set1_epi32(pattern);
+
+		__m128i b74 = _mm_cmpeq_epi32(_mm_and_si128(pat, m74), zero);
+		__m128i b32 = _mm_cmpeq_epi32(_mm_and_si128(pat, m32), zero);
+
+		auto* out = reinterpret_cast<__m128i*>(pixelPtr);
+		_mm_storeu_si128(out + 0, select(fg4, bg4, b74));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pixelPtr + 4),
+		                 select(fg4, bg4, b32));
+		pixelPtr += 6;
+		return;
+	}
+#endif
+
+	// C++ version
 	pixelPtr[0] = (pattern & 0x80) ? fg : bg;
 	pixelPtr[1] = (pattern & 0x40) ? fg : bg;
 	pixelPtr[2] = (pattern & 0x20) ? fg : bg;
@@ -105,7 +129,7 @@ template<typename Pixel> static inline void draw8(
 	Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, byte pattern)
 {
 #ifdef __SSE2__
-	// SSE2 version, 32bpp  (16bpp is possible, but not worth it anymore)
+	// SSE2 version, 32bpp
 	if (sizeof(Pixel) == 4) {
 		const __m128i m74 = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
 		const __m128i m30 = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
@@ -124,6 +148,23 @@ template<typename Pixel> static inline void draw8(
 		pixelPtr += 8;
 		return;
 	}
+	// SSE2 version, 16bpp  (all 8 pixels in one register)
+	if (sizeof(Pixel) == 2) {
+		const __m128i m70 = _mm_set_epi16(
+			0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+		const __m128i zero = _mm_setzero_si128();
+
+		__m128i fg8 = _mm_set1_epi16(fg);
+		__m128i bg8 = _mm_set1_epi16(bg);
+		__m128i pat = _mm_set1_epi16(pattern);
+
+		__m128i b70 = _mm_cmpeq_epi16(_mm_and_si128(pat, m70), zero);
+
+		auto* out = reinterpret_cast<__m128i*>(pixelPtr);
+		_mm_storeu_si128(out, select(fg8, bg8, b70));
+		pixelPtr += 8;
+		return;
+	}
 #endif
 
 	// C++ version
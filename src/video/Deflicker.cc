@@ -7,6 +7,8 @@
 #include <memory>
 #ifdef __SSE2__
 #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
 #endif
 
 namespace openmsx {
@@ -115,6 +117,41 @@ static __m128i compare(__m128i x, __m128i y)
 		return _mm_cmpeq_epi16(x, y);
 	}
 }
+
+#elif defined(__ARM_NEON)
+// NEON versions of the above. In NEON the register type depends on the element
+// type, uint8x16_t is used as the common 'raw' type.
+template<typename Pixel>
+static uint8x16_t blend(uint8x16_t x, uint8x16_t y, Pixel blendMask)
+{
+	if (sizeof(Pixel) == 4) {
+		// 32bpp, same rounding as _mm_avg_epu8()
+		return vrhaddq_u8(x, y);
+	} else {
+		// 16bpp,  (x & y) + (((x ^ y) & blendMask) >> 1)
+		uint16x8_t x16 = vreinterpretq_u16_u8(x);
+		uint16x8_t y16 = vreinterpretq_u16_u8(y);
+		uint16x8_t m = vdupq_n_u16(uint16_t(blendMask));
+		uint16x8_t a = vandq_u16(x16, y16);
+		uint16x8_t b = veorq_u16(x16, y16);
+		uint16x8_t c = vandq_u16(b, m);
+		uint16x8_t d = vshrq_n_u16(c, 1);
+		return vreinterpretq_u8_u16(vaddq_u16(a, d));
+	}
+}
+
+template<typename Pixel>
+static uint8x16_t compare(uint8x16_t x, uint8x16_t y)
+{
+	static_assert(sizeof(Pixel) == 4 || sizeof(Pixel) == 2, "");
+	if (sizeof(Pixel) == 4) {
+		return vreinterpretq_u8_u32(vceqq_u32(
+			vreinterpretq_u32_u8(x), vreinterpretq_u32_u8(y)));
+	} else {
+		return vreinterpretq_u8_u16(vceqq_u16(
+			vreinterpretq_u16_u8(x), vreinterpretq_u16_u8(y)));
+	}
+}
 #endif
 
 template<typename Pixel>
@@ -178,6 +215,32 @@ const void* DeflickerImpl<Pixel>::getLineInfo(
 		byteOffst += sizeof(__m128i);
 	}
 	remaining &= pixelsPerSSE - 1;
+#elif defined(__ARM_NEON)
+	size_t pixelsPerNEON = sizeof(uint8x16_t) / sizeof(Pixel);
+	size_t widthNEON = remaining & ~(pixelsPerNEON - 1);
+
+	Pixel blendMask = pixelOps.getBlendMask();
+	for (size_t x = 0; x < widthNEON; x += pixelsPerNEON) {
+		uint8x16_t a0 = vld1q_u8(reinterpret_cast<const uint8_t*>(line0 + x));
+		uint8x16_t a1 = vld1q_u8(reinterpret_cast<const uint8_t*>(line1 + x));
+		uint8x16_t a2 = vld1q_u8(reinterpret_cast<const uint8_t*>(line2 + x));
+		uint8x16_t a3 = vld1q_u8(reinterpret_cast<const uint8_t*>(line3 + x));
+
+		uint8x16_t e02 = compare<Pixel>(a0, a2); // a0 == a2
+		uint8x16_t e13 = compare<Pixel>(a1, a3); // a1 == a3
+		uint8x16_t cnd = vandq_u8(e02, e13); // (a0==a2) && (a1==a3)
+
+		uint8x16_t a01 = blend(a0, a1, blendMask);
+		uint8x16_t r = vbslq_u8(cnd, a01, a0); // select(a0, a01, cnd)
+
+		vst1q_u8(reinterpret_cast<uint8_t*>(dst + x), r);
+	}
+	line0 += widthNEON;
+	line1 += widthNEON;
+	line2 += widthNEON;
+	line3 += widthNEON;
+	dst   += widthNEON;
+	remaining &= pixelsPerNEON - 1;
 #endif
 	for (unsigned x = 0; x < remaining; ++x) {
 		dst[x] = ((line0[x] == line2[x]) && (line1[x] == line3[x]))
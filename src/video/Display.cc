@@ -3,10 +3,14 @@
 #include "Layer.hh"
 #include "VideoSystem.hh"
 #include "VideoLayer.hh"
+#include "PostProcessor.hh"
+#include "PNG.hh"
 #include "EventDistributor.hh"
 #include "FinishFrameEvent.hh"
 #include "FileOperations.hh"
 #include "FileContext.hh"
+#include "FrameProfiler.hh"
+#include "Instrumentation.hh"
 #include "InputEvents.hh"
 #include "CliComm.hh"
 #include "Timer.hh"
@@ -24,12 +28,14 @@
 #include "Version.hh"
 #include "build-info.hh"
 #include "checked_cast.hh"
+#include "optional.hh"
 #include "outer.hh"
 #include "ranges.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "view.hh"
 #include <cassert>
+#include <cstdio>
 
 using std::string;
 using std::vector;
@@ -40,11 +46,14 @@ Display::Display(Reactor& reactor_)
 	: RTSchedulable(reactor_.getRTScheduler())
 	, screenShotCmd(reactor_.getCommandController())
 	, fpsInfo(reactor_.getOpenMSXInfoCommand())
+	, framesInfo(reactor_.getOpenMSXInfoCommand())
 	, osdGui(reactor_.getCommandController(), *this)
 	, reactor(reactor_)
 	, renderSettings(reactor.getCommandController())
 	, commandConsole(reactor.getGlobalCommandController(),
 	                 reactor.getEventDistributor(), *this)
+	, screenShotWriter(reactor.getCommandController(),
+	                   reactor.getEventDistributor())
 	, currentRenderer(RenderSettings::UNINITIALIZED)
 	, switchInProgress(false)
 {
@@ -54,6 +63,8 @@ Display::Display(Reactor& reactor_)
 		frameDurationSum += 20;
 	}
 	prevTimeStamp = Timer::getTime();
+	paintedFrames = 0;
+	lastSpeedUpdate = prevTimeStamp;
 
 	EventDistributor& eventDistributor = reactor.getEventDistributor();
 	eventDistributor.registerEventListener(OPENMSX_FINISH_FRAME_EVENT,
@@ -339,13 +350,17 @@ void Display::repaint()
 
 	cancelRT(); // cancel delayed repaint
 
+	auto& frameProfiler = reactor.getFrameProfiler();
 	if (!renderFrozen) {
+		FrameProfiler::Section section(frameProfiler, FrameProfiler::PAINT);
 		assert(videoSystem);
 		if (OutputSurface* surface = videoSystem->getOutputSurface()) {
 			repaint(*surface);
+			INSTRUMENT_ZONE("VideoSystem::flush");
 			videoSystem->flush();
 		}
 	}
+	frameProfiler.endFrame();
 
 	// update fps statistics
 	auto now = Timer::getTime();
@@ -353,12 +368,42 @@ void Display::repaint()
 	prevTimeStamp = now;
 	frameDurationSum += duration - frameDurations.removeBack();
 	frameDurations.addFront(duration);
+	++paintedFrames;
+
+	if ((now - lastSpeedUpdate) >= 1000000) {
+		sendSpeedUpdate(now);
+	}
+}
+
+void Display::sendSpeedUpdate(uint64_t now)
+{
+	// Once per second, so that external applications don't have to poll
+	// 'openmsx_info fps'. (GlobalCliComm drops unchanged values.)
+	auto& cliComm = getCliComm();
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%.1f",
+	         1000000.0 * NUM_FRAME_DURATIONS / frameDurationSum);
+	cliComm.update(CliComm::SPEED, "fps", buf);
+
+	// The emulation speed relative to a real MSX, in percent.
+	if (auto* board = reactor.getMotherBoard()) {
+		double emuTime = (board->getCurrentTime() - EmuTime::zero).toDouble();
+		double emuDelta = emuTime - lastSpeedEmuTime;
+		lastSpeedEmuTime = emuTime;
+		if (emuDelta >= 0.0) { // not after switching machines
+			snprintf(buf, sizeof(buf), "%.0f",
+			         100.0 * emuDelta * 1000000.0 / (now - lastSpeedUpdate));
+			cliComm.update(CliComm::SPEED, "emulation", buf);
+		}
+	}
+	lastSpeedUpdate = now;
 }
 
 void Display::repaint(OutputSurface& surface)
 {
 	for (auto it = baseLayer(); it != end(layers); ++it) {
 		if ((*it)->getCoverage() != Layer::COVER_NONE) {
+			INSTRUMENT_ZONE(Instrumentation::typeName(typeid(**it)));
 			(*it)->paint(surface);
 		}
 	}
@@ -373,6 +418,21 @@ void Display::repaintDelayed(uint64_t delta)
 	scheduleRT(unsigned(delta));
 }
 
+void Display::renderOnDemand()
+{
+	bool rendered = false;
+	for (auto* layer : layers) {
+		if (auto* postProcessor = dynamic_cast<PostProcessor*>(layer)) {
+			rendered |= postProcessor->renderOnDemand();
+		}
+	}
+	if (rendered && !renderFrozen && videoSystem) {
+		if (OutputSurface* surface = videoSystem->getOutputSurface()) {
+			repaint(*surface);
+		}
+	}
+}
+
 void Display::addLayer(Layer& layer)
 {
 	int z = layer.getZ();
@@ -402,6 +462,19 @@ Display::ScreenShotCmd::ScreenShotCmd(CommandController& commandController_)
 {
 }
 
+static PNG::Filter parseFilter(string_view name)
+{
+	if (name == "none")    return PNG::Filter::NONE;
+	if (name == "sub")     return PNG::Filter::SUB;
+	if (name == "up")      return PNG::Filter::UP;
+	if (name == "average") return PNG::Filter::AVERAGE;
+	if (name == "paeth")   return PNG::Filter::PAETH;
+	if (name == "all")     return PNG::Filter::ALL;
+	throw CommandException("Invalid filter: ", name,
+	                       ", expected one of none, sub, up, average, "
+	                       "paeth or all.");
+}
+
 void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& result)
 {
 	string_view prefix = "openmsx";
@@ -409,12 +482,20 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 	bool msxOnly = false;
 	bool doubleSize = false;
 	bool withOsd = false;
+	bool async = false;
+	optional<TclObject> command;
+	optional<int> compression;
+	optional<string_view> filter;
 	ArgsInfo info[] = {
 		valueArg("-prefix", prefix),
 		flagArg("-raw", rawShot),
 		flagArg("-msxonly", msxOnly),
 		flagArg("-doublesize", doubleSize),
-		flagArg("-with-osd", withOsd)
+		flagArg("-with-osd", withOsd),
+		flagArg("-async", async),
+		valueArg("-command", command),
+		valueArg("-compression", compression),
+		valueArg("-filter", filter),
 	};
 	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
 
@@ -434,6 +515,24 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 		throw CommandException("-with-osd cannot be used in "
 		                       "combination with -raw");
 	}
+	if (command) async = true;
+
+	// When encoding in the background, by default favour speed over
+	// file size.
+	PNG::Options options;
+	if (async) {
+		options.compression = 1;
+		options.filter = PNG::Filter::SUB;
+	}
+	if (compression) {
+		if ((*compression < 0) || (*compression > 9)) {
+			throw CommandException("Compression level must be in range [0, 9].");
+		}
+		options.compression = *compression;
+	}
+	if (filter) {
+		options.filter = parseFilter(*filter);
+	}
 
 	string_view fname;
 	switch (arguments.size()) {
@@ -449,31 +548,35 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 	string filename = FileOperations::parseCommandFileArgument(
 		fname, "screenshots", prefix, ".png");
 
-	if (!rawShot) {
-		// include all layers (OSD stuff, console)
-		try {
-			display.getVideoSystem().takeScreenShot(filename, withOsd);
-		} catch (MSXException& e) {
-			throw CommandException(
-				"Failed to take screenshot: ", e.getMessage());
-		}
-	} else {
-		auto videoLayer = dynamic_cast<VideoLayer*>(
-			display.findActiveLayer());
-		if (!videoLayer) {
-			throw CommandException(
-				"Current renderer doesn't support taking screenshots.");
-		}
-		unsigned height = doubleSize ? 480 : 240;
-		try {
-			videoLayer->takeRawScreenShot(height, filename);
-		} catch (MSXException& e) {
-			throw CommandException(
-				"Failed to take screenshot: ", e.getMessage());
+	display.renderOnDemand();
+	try {
+		PNG::Image image = [&] {
+			if (!rawShot) {
+				// include all layers (OSD stuff, console)
+				return display.getVideoSystem().takeScreenShot(withOsd);
+			}
+			auto videoLayer = dynamic_cast<VideoLayer*>(
+				display.findActiveLayer());
+			if (!videoLayer) {
+				throw CommandException(
+					"Current renderer doesn't support taking screenshots.");
+			}
+			return videoLayer->takeRawScreenShot(doubleSize ? 480 : 240);
+		}();
+		if (async) {
+			display.screenShotWriter.write(
+				std::move(image), filename, options,
+				command ? std::move(*command) : TclObject());
+		} else {
+			PNG::save(image, filename, options);
+			display.getCliComm().printInfo("Screen saved to ", filename);
 		}
+	} catch (CommandException&) {
+		throw;
+	} catch (MSXException& e) {
+		throw CommandException(
+			"Failed to take screenshot: ", e.getMessage());
 	}
-
-	display.getCliComm().printInfo("Screen saved to ", filename);
 	result = filename;
 }
 
@@ -486,13 +589,28 @@ string Display::ScreenShotCmd::help(const vector<string>& /*tokens*/) const
 	       "screenshot -raw              320x240 raw screenshot (of MSX screen only)\n"
 	       "screenshot -raw -doublesize  640x480 raw screenshot (of MSX screen only)\n"
 	       "screenshot -with-osd         Include OSD elements in the screenshot\n"
-	       "screenshot -no-sprites       Don't include sprites in the screenshot\n";
+	       "screenshot -no-sprites       Don't include sprites in the screenshot\n"
+	       "screenshot -async            Copy the screen and write the file in the background\n"
+	       "screenshot -command <cmd>    Like -async, executes <cmd> with 'ok' and the filename\n"
+	       "                             or 'error' and the error message when done\n"
+	       "screenshot -compression <n>  PNG compression level, 0 (none) to 9 (best)\n"
+	       "screenshot -filter <name>    PNG filter: none, sub, up, average, paeth or all\n"
+	       "By default background screenshots are written with level 1 and filter 'sub' "
+	       "(fast), other screenshots with level 6 and all filters (small).\n";
 }
 
 void Display::ScreenShotCmd::tabCompletion(vector<string>& tokens) const
 {
+	if ((tokens.size() >= 3) && (tokens[tokens.size() - 2] == "-filter")) {
+		static const char* const filters[] = {
+			"none", "sub", "up", "average", "paeth", "all",
+		};
+		completeString(tokens, filters);
+		return;
+	}
 	static const char* const extra[] = {
 		"-prefix", "-raw", "-doublesize", "-with-osd", "-no-sprites",
+		"-async", "-command", "-compression", "-filter",
 	};
 	completeFileName(tokens, userFileContext(), extra);
 }
@@ -517,4 +635,24 @@ string Display::FpsInfoTopic::help(const vector<string>& /*tokens*/) const
 	return "Returns the current rendering speed in frames per second.";
 }
 
+
+// FramesInfoTopic
+
+Display::FramesInfoTopic::FramesInfoTopic(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "frames")
+{
+}
+
+void Display::FramesInfoTopic::execute(span<const TclObject> /*tokens*/,
+                           TclObject& result) const
+{
+	auto& display = OUTER(Display, framesInfo);
+	result = int64_t(display.paintedFrames);
+}
+
+string Display::FramesInfoTopic::help(const vector<string>& /*tokens*/) const
+{
+	return "Returns the number of frames painted since openMSX was started.";
+}
+
 } // namespace openmsx
@@ -11,6 +11,7 @@
 #include "RTSchedulable.hh"
 #include "Observer.hh"
 #include "CircularBuffer.hh"
+#include "ScreenShotWriter.hh"
 #include <memory>
 #include <vector>
 #include <cstdint>
@@ -51,6 +52,13 @@ public:
 	void repaint(OutputSurface& surface);
 	void repaintDelayed(uint64_t delta);
 
+	/** Render the current frame of all video sources that skipped it
+	  * because of the 'render_on_demand' setting. If needed the output
+	  * surface is repainted (but not shown). Called before taking a
+	  * screenshot.
+	  */
+	void renderOnDemand();
+
 	void addLayer(Layer& layer);
 	void removeLayer(Layer& layer);
 
@@ -76,6 +84,8 @@ private:
 	// Observer<Setting> interface
 	void update(const Setting& setting) override;
 
+	void sendSpeedUpdate(uint64_t now);
+
 	void checkRendererSwitch();
 	void doRendererSwitch();
 	void doRendererSwitch2();
@@ -97,6 +107,11 @@ private:
 	CircularBuffer<uint64_t, NUM_FRAME_DURATIONS> frameDurations;
 	uint64_t frameDurationSum;
 	uint64_t prevTimeStamp;
+	uint64_t paintedFrames; // total number of repaints
+
+	// for the CliComm::SPEED updates
+	uint64_t lastSpeedUpdate;
+	double lastSpeedEmuTime = 0.0; // in seconds
 
 	struct ScreenShotCmd final : Command {
 		explicit ScreenShotCmd(CommandController& commandController);
@@ -112,11 +127,19 @@ private:
 		std::string help(const std::vector<std::string>& tokens) const override;
 	} fpsInfo;
 
+	struct FramesInfoTopic final : InfoTopic {
+		explicit FramesInfoTopic(InfoCommand& openMSXInfoCommand);
+		void execute(span<const TclObject> tokens,
+			     TclObject& result) const override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+	} framesInfo;
+
 	OSDGUI osdGui;
 
 	Reactor& reactor;
 	RenderSettings renderSettings;
 	CommandConsole commandConsole;
+	ScreenShotWriter screenShotWriter;
 
 	// the current renderer
 	RenderSettings::RendererID currentRenderer;
@@ -6,6 +6,7 @@
 #include "Scaler.hh"
 #include "ScalerFactory.hh"
 #include "OutputSurface.hh"
+#include "WorkerThread.hh"
 #include "Math.hh"
 #include "aligned.hh"
 #include "random.hh"
@@ -15,6 +16,8 @@
 #include <cmath>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
+#include <thread>
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
@@ -25,6 +28,11 @@ static const unsigned NOISE_SHIFT = 8192;
 static const unsigned NOISE_BUF_SIZE = 2 * NOISE_SHIFT;
 SSE_ALIGNED(static signed char noiseBuf[NOISE_BUF_SIZE]);
 
+// Scaling an image is split over at most this many threads, and each part is
+// at least this many (destination) lines high.
+static const unsigned MAX_SCALE_BANDS = 4;
+static const unsigned MIN_BAND_HEIGHT = 64;
+
 template <class Pixel>
 void FBPostProcessor<Pixel>::preCalcNoise(float factor)
 {
@@ -237,6 +245,8 @@ FBPostProcessor<Pixel>::FBPostProcessor(MSXMotherBoard& motherBoard_,
 		canDoInterlace_)
 	, noiseShift(screen.getHeight())
 	, pixelOps(screen.getSDLFormat())
+	, maxBands(Math::clip<1, MAX_SCALE_BANDS>(
+		int(std::thread::hardware_concurrency())))
 {
 	scaleAlgorithm = RenderSettings::NO_SCALER;
 	scaleFactor = unsigned(-1);
@@ -253,6 +263,155 @@ FBPostProcessor<Pixel>::~FBPostProcessor()
 	renderSettings.getNoiseSetting().detach(*this);
 }
 
+template <class Pixel>
+void FBPostProcessor<Pixel>::scaleRegion(
+	OutputSurface& output, unsigned inWidth,
+	unsigned srcStartY, unsigned srcEndY, unsigned lineWidth,
+	unsigned dstStartY, unsigned dstEndY,
+	unsigned srcStep, unsigned dstStep)
+{
+	auto scalePart = [&](unsigned srcY0, unsigned srcY1,
+	                     unsigned dstY0, unsigned dstY1) {
+		// each part needs its own ScalerOutput (it has internal buffers)
+		std::unique_ptr<ScalerOutput<Pixel>> dst(
+			StretchScalerOutputFactory<Pixel>::create(
+				output, pixelOps, inWidth));
+		currScaler->scaleImage(
+			*paintFrame, superImposeVideoFrame,
+			srcY0, srcY1, lineWidth, *dst, dstY0, dstY1);
+	};
+
+	unsigned numBands = 1;
+	if (currScaler->isParallelizable()) {
+		numBands = std::min(maxBands, (dstEndY - dstStartY) / MIN_BAND_HEIGHT);
+	}
+	if (numBands <= 1) {
+		scalePart(srcStartY, srcEndY, dstStartY, dstEndY);
+		return;
+	}
+
+	// Split in bands that each contain a whole number of (srcStep,
+	// dstStep) units. Scalers that look at neighbouring source lines
+	// fetch those directly from the frame, so the bands don't need to
+	// overlap.
+	while (workers.size() < (numBands - 1)) {
+		workers.push_back(std::make_unique<WorkerThread>());
+	}
+	unsigned units = (dstEndY - dstStartY) / dstStep;
+	assert(units * dstStep == (dstEndY - dstStartY));
+	unsigned srcY = srcStartY;
+	unsigned dstY = dstStartY;
+	for (unsigned b = 0; b < numBands; ++b) {
+		unsigned bandUnits = (units * (b + 1)) / numBands
+		                   - (units *  b     ) / numBands;
+		unsigned srcY1 = srcY + bandUnits * srcStep;
+		unsigned dstY1 = dstY + bandUnits * dstStep;
+		if (b == (numBands - 1)) {
+			assert(dstY1 == dstEndY);
+			scalePart(srcY, srcEndY, dstY, dstEndY);
+		} else {
+			workers[b]->push([=, &scalePart] {
+				scalePart(srcY, srcY1, dstY, dstY1);
+			});
+		}
+		srcY = srcY1;
+		dstY = dstY1;
+	}
+	for (unsigned b = 0; b < (numBands - 1); ++b) {
+		workers[b]->waitIdle();
+	}
+}
+
+// Number of neighbouring source lines (above and below) that a parallelizable
+// scaler might look at.
+static const unsigned NEIGHBOUR_LINES = 2;
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::storeOutput(
+	OutputSurface& output, unsigned dstStartY, unsigned dstEndY)
+{
+	unsigned width = output.getWidth();
+	for (unsigned y = dstStartY; y < dstEndY; ++y) {
+		memcpy(&prevOutput[y * width], output.getLinePtrDirect<Pixel>(y),
+		       width * sizeof(Pixel));
+	}
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::reuseOutput(
+	OutputSurface& output, unsigned dstStartY, unsigned dstEndY)
+{
+	unsigned width = output.getWidth();
+	for (unsigned y = dstStartY; y < dstEndY; ++y) {
+		memcpy(output.getLinePtrDirect<Pixel>(y), &prevOutput[y * width],
+		       width * sizeof(Pixel));
+	}
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::scaleOrReuseRegion(
+	OutputSurface& output, unsigned inWidth,
+	unsigned srcStartY, unsigned srcEndY, unsigned lineWidth,
+	unsigned dstStartY, unsigned dstEndY,
+	unsigned srcStep, unsigned dstStep)
+{
+	auto scale = [&](unsigned srcY0, unsigned srcY1,
+	                 unsigned dstY0, unsigned dstY1) {
+		scaleRegion(output, inWidth, srcY0, srcY1, lineWidth,
+		            dstY0, dstY1, srcStep, dstStep);
+		storeOutput(output, dstY0, dstY1);
+	};
+	if (!reuse) {
+		scale(srcStartY, srcEndY, dstStartY, dstEndY);
+		return;
+	}
+
+	// The region can be split (see scaleRegion()) in units of (srcStep,
+	// dstStep) lines. A unit must be scaled again when one of its source
+	// lines, or one of the neighbouring lines that the scaler looks at,
+	// changed. Otherwise the previous output is still valid.
+	unsigned srcHeight = unsigned(changedLines.size());
+	auto isDirty = [&](unsigned srcY0, unsigned srcY1) {
+		unsigned y0 = (srcY0 > NEIGHBOUR_LINES) ? srcY0 - NEIGHBOUR_LINES : 0;
+		unsigned y1 = std::min(srcY1 + NEIGHBOUR_LINES, srcHeight);
+		for (unsigned y = y0; y < y1; ++y) {
+			if (changedLines[y]) return true;
+		}
+		return false;
+	};
+	if (!currScaler->isParallelizable()) {
+		// Such a scaler might look at any line of the frame, so it
+		// can only be skipped when nothing changed at all.
+		if (isDirty(0, srcHeight)) {
+			scale(srcStartY, srcEndY, dstStartY, dstEndY);
+		} else {
+			reuseOutput(output, dstStartY, dstEndY);
+		}
+		return;
+	}
+	unsigned srcY = srcStartY;
+	unsigned dstY = dstStartY;
+	while (dstY < dstEndY) {
+		// find a maximal run of units that are all dirty or all clean
+		bool dirty = isDirty(srcY, srcY + srcStep);
+		unsigned srcY1 = srcY + srcStep;
+		unsigned dstY1 = dstY + dstStep;
+		while ((dstY1 < dstEndY) &&
+		       (isDirty(srcY1, srcY1 + srcStep) == dirty)) {
+			srcY1 += srcStep;
+			dstY1 += dstStep;
+		}
+		if (dstY1 == dstEndY) srcY1 = srcEndY;
+		if (dirty) {
+			scale(srcY, srcY1, dstY, dstY1);
+		} else {
+			reuseOutput(output, dstY, dstY1);
+		}
+		srcY = srcY1;
+		dstY = dstY1;
+	}
+}
+
 template <class Pixel>
 void FBPostProcessor<Pixel>::paint(OutputSurface& output)
 {
@@ -275,11 +434,41 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output)
 		currScaler = ScalerFactory<Pixel>::createScaler(
 			PixelOperations<Pixel>(output.getSDLFormat()),
 			renderSettings);
+		prevValid = false;
 	}
 
 	// Scale image.
 	const unsigned srcHeight = paintFrame->getHeight();
 	const unsigned dstHeight = output.getHeight();
+	float horStretch = renderSettings.getHorizontalStretch();
+	unsigned inWidth = lrintf(horStretch);
+
+	// Which source lines changed since the previous paint? This is only
+	// known when painting a RawFrame directly (so e.g. not when
+	// deinterlacing or superimposing).
+	OutputParams params = {
+		unsigned(output.getWidth()), dstHeight, inWidth, srcHeight,
+		renderSettings.getScanlineFactor(), renderSettings.getBlurFactor(),
+		renderSettings.getScanlineGap()
+	};
+	const RawFrame* rawFrame =
+		((paintFrame == lastFrames[0].get()) && !superImposeVideoFrame)
+		? lastFrames[0].get() : nullptr;
+	reuse = prevValid && rawFrame && (params == prevParams);
+	if (rawFrame) {
+		prevHashes.resize(srcHeight);
+		changedLines.resize(srcHeight);
+		for (unsigned y = 0; y < srcHeight; ++y) {
+			uint32_t hash = rawFrame->getLineHash(y);
+			changedLines[y] = prevHashes[y] != hash;
+			prevHashes[y] = hash;
+		}
+	}
+	if (!(params == prevParams)) {
+		prevOutput.resize(size_t(params.width) * params.height);
+		prevParams = params;
+	}
+	prevValid = rawFrame != nullptr;
 
 	unsigned g = Math::gcd(srcHeight, dstHeight);
 	unsigned srcStep = srcHeight / g;
@@ -308,15 +497,10 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output)
 		//fprintf(stderr, "post processing lines %d-%d: %d\n",
 		//	srcStartY, srcEndY, lineWidth );
 		output.lock();
-		float horStretch = renderSettings.getHorizontalStretch();
-		unsigned inWidth = lrintf(horStretch);
-		std::unique_ptr<ScalerOutput<Pixel>> dst(
-			StretchScalerOutputFactory<Pixel>::create(
-				output, pixelOps, inWidth));
-		currScaler->scaleImage(
-			*paintFrame, superImposeVideoFrame,
-			srcStartY, srcEndY, lineWidth, // source
-			*dst, dstStartY, dstEndY); // dest
+		scaleOrReuseRegion(output, inWidth,
+		            srcStartY, srcEndY, lineWidth, // source
+		            dstStartY, dstEndY,            // dest
+		            srcStep, dstStep);
 
 		// next region
 		srcStartY = srcEndY;
@@ -4,6 +4,9 @@
 #include "PostProcessor.hh"
 #include "RenderSettings.hh"
 #include "PixelOperations.hh"
+#include "MemBuffer.hh"
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace openmsx {
@@ -11,6 +14,7 @@ namespace openmsx {
 class MSXMotherBoard;
 class Display;
 template<typename Pixel> class Scaler;
+class WorkerThread;
 
 /** Rasterizer using SDL.
   */
@@ -31,6 +35,16 @@ public:
 		std::unique_ptr<RawFrame> finishedFrame, EmuTime::param time) override;
 
 private:
+	void scaleRegion(OutputSurface& output, unsigned inWidth,
+	                 unsigned srcStartY, unsigned srcEndY, unsigned lineWidth,
+	                 unsigned dstStartY, unsigned dstEndY,
+	                 unsigned srcStep, unsigned dstStep);
+	void scaleOrReuseRegion(OutputSurface& output, unsigned inWidth,
+	                 unsigned srcStartY, unsigned srcEndY, unsigned lineWidth,
+	                 unsigned dstStartY, unsigned dstEndY,
+	                 unsigned srcStep, unsigned dstStep);
+	void storeOutput(OutputSurface& output, unsigned dstStartY, unsigned dstEndY);
+	void reuseOutput(OutputSurface& output, unsigned dstStartY, unsigned dstEndY);
 	void preCalcNoise(float factor);
 	void drawNoise(OutputSurface& output);
 	void drawNoiseLine(Pixel* buf, signed char* noise,
@@ -56,6 +70,35 @@ private:
 	std::vector<unsigned> noiseShift;
 
 	PixelOperations<Pixel> pixelOps;
+
+	/** Helper threads to scale parts of the image in parallel (only
+	  * created when needed). The main thread also scales one part.
+	  */
+	std::vector<std::unique_ptr<WorkerThread>> workers;
+	unsigned maxBands;
+
+	/** The scaled output of the previous paint() (before adding noise)
+	  * and what it was made from. When (parts of) the next frame are the
+	  * same, the output is copied from here instead of scaled again, e.g.
+	  * while emulation is paused.
+	  */
+	struct OutputParams {
+		unsigned width, height, inWidth, srcHeight;
+		int scanline, blur;
+		float scanlineGap;
+		bool operator==(const OutputParams& o) const {
+			return (width == o.width) && (height == o.height) &&
+			       (inWidth == o.inWidth) && (srcHeight == o.srcHeight) &&
+			       (scanline == o.scanline) && (blur == o.blur) &&
+			       (scanlineGap == o.scanlineGap);
+		}
+	};
+	MemBuffer<Pixel> prevOutput;
+	OutputParams prevParams;
+	std::vector<uint32_t> prevHashes; // RawFrame hash per source line
+	std::vector<bool> changedLines; // of the current frame vs prevHashes
+	bool prevValid = false; // is the content of 'prevOutput' usable
+	bool reuse; // during paint(): may 'prevOutput' be reused
 };
 
 } // namespace openmsx
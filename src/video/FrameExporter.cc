@@ -0,0 +1,295 @@
+#include "FrameExporter.hh"
+#include "CommandException.hh"
+#include "Display.hh"
+#include "FrameSource.hh"
+#include "PostProcessor.hh"
+#include "Reactor.hh"
+#include "TclArgParser.hh"
+#include "TclObject.hh"
+#include "build-info.hh"
+#include "outer.hh"
+#include "systemfuncs.hh"
+#include "xrange.hh"
+#include <SDL.h>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#if HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using std::string;
+using std::vector;
+
+namespace openmsx {
+
+static const char MAGIC[8] = { 'O', 'M', 'S', 'X', 'F', 'R', 'M', '1' };
+static const unsigned HEADER_SIZE = 64;
+static const unsigned SLOT_HEADER_SIZE = 64;
+
+// offsets in the header
+static const unsigned OFF_HEADER_SIZE = 8;
+static const unsigned OFF_NUM_SLOTS   = 12;
+static const unsigned OFF_WIDTH       = 16;
+static const unsigned OFF_HEIGHT      = 20;
+static const unsigned OFF_PITCH       = 24;
+static const unsigned OFF_BPP         = 28;
+static const unsigned OFF_RMASK       = 32;
+static const unsigned OFF_GMASK       = 36;
+static const unsigned OFF_BMASK       = 40;
+static const unsigned OFF_SEQUENCE    = 48;
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "shared memory layout requires plain 64-bit atomics");
+
+static void store32(uint8_t* p, uint32_t value)
+{
+	memcpy(p, &value, sizeof(value));
+}
+
+static void publish(uint8_t* p, uint64_t value)
+{
+	reinterpret_cast<std::atomic<uint64_t>*>(p)->store(
+		value, std::memory_order_release);
+}
+
+FrameExporter::FrameExporter(Reactor& reactor_)
+	: reactor(reactor_)
+	, exportCommand(reactor.getCommandController())
+{
+}
+
+FrameExporter::~FrameExporter()
+{
+	stop();
+}
+
+void FrameExporter::start(const string& name, unsigned width_,
+                          unsigned height_, unsigned numSlots_)
+{
+#if HAVE_MMAP
+	stop();
+	postProcessors.clear();
+	for (auto* l : reactor.getDisplay().getAllLayers()) {
+		if (auto* pp = dynamic_cast<PostProcessor*>(l)) {
+			postProcessors.push_back(pp);
+		}
+	}
+	if (postProcessors.empty()) {
+		throw CommandException(
+			"Current renderer doesn't support frame export.");
+	}
+	// any source is fine because they all have the same bpp
+	bpp = postProcessors.front()->getBpp();
+	width = width_;
+	height = height_;
+	numSlots = numSlots_;
+	pitch = width * ((bpp == 32) ? 4 : 2);
+	slotSize = (SLOT_HEADER_SIZE + size_t(pitch) * height + 63) & ~size_t(63);
+	size_t size = HEADER_SIZE + numSlots * slotSize;
+
+	int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fd == -1) {
+		postProcessors.clear();
+		throw CommandException("Couldn't create shared memory ", name,
+		                       ": ", strerror(errno));
+	}
+	void* mem = MAP_FAILED;
+	if (ftruncate(fd, size) == 0) {
+		mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	int error = errno;
+	close(fd);
+	if (mem == MAP_FAILED) {
+		shm_unlink(name.c_str());
+		postProcessors.clear();
+		throw CommandException("Couldn't map shared memory ", name,
+		                       ": ", strerror(error));
+	}
+	shm = static_cast<uint8_t*>(mem);
+	shmSize = size;
+	shmName = name;
+	sequence = 0;
+
+	// ftruncate() zero-filled the segment, so all slots are empty
+	memcpy(shm, MAGIC, sizeof(MAGIC));
+	store32(shm + OFF_HEADER_SIZE, HEADER_SIZE);
+	store32(shm + OFF_NUM_SLOTS,   numSlots);
+	store32(shm + OFF_WIDTH,       width);
+	store32(shm + OFF_HEIGHT,      height);
+	store32(shm + OFF_PITCH,       pitch);
+	store32(shm + OFF_BPP,         bpp);
+
+	// only set exporters when all errors are checked for
+	for (auto* pp : postProcessors) {
+		pp->setFrameExporter(this);
+	}
+#else
+	(void)name; (void)width_; (void)height_; (void)numSlots_;
+	throw CommandException(
+		"Frame export is not supported on this platform.");
+#endif
+}
+
+void FrameExporter::stop()
+{
+	for (auto* pp : postProcessors) {
+		pp->setFrameExporter(nullptr);
+	}
+	postProcessors.clear();
+#if HAVE_MMAP
+	if (shm) {
+		munmap(shm, shmSize);
+		shm_unlink(shmName.c_str());
+	}
+#endif
+	shm = nullptr;
+	shmSize = 0;
+	shmName.clear();
+}
+
+template<typename Pixel>
+void FrameExporter::copyFrame(FrameSource& frame, uint8_t* dst)
+{
+	for (auto y : xrange(height)) {
+		// Let the frame scale directly into the shared memory,
+		// only when it returns a pointer to its own buffer an
+		// extra copy is needed.
+		auto* dstLine = reinterpret_cast<Pixel*>(dst + y * pitch);
+		const Pixel* line = (height == 240)
+		                  ? frame.getLinePtr320_240(y, dstLine)
+		                  : frame.getLinePtr640_480(y, dstLine);
+		if (line != dstLine) {
+			memcpy(dstLine, line, pitch);
+		}
+	}
+}
+
+void FrameExporter::addFrame(FrameSource* frame, EmuTime::param time)
+{
+	assert(shm);
+	uint8_t* slot = shm + HEADER_SIZE + (sequence % numSlots) * slotSize;
+	++sequence;
+
+	publish(slot, 0); // mark slot as being written
+	uint64_t ticks = (time - EmuTime::zero).length();
+	memcpy(slot + 8, &ticks, sizeof(ticks));
+	const auto& format = frame->getSDLPixelFormat();
+	store32(shm + OFF_RMASK, format.Rmask);
+	store32(shm + OFF_GMASK, format.Gmask);
+	store32(shm + OFF_BMASK, format.Bmask);
+#if HAVE_32BPP
+	if (bpp == 32) {
+		copyFrame<uint32_t>(*frame, slot + SLOT_HEADER_SIZE);
+	} else
+#endif
+	{
+#if HAVE_16BPP
+		copyFrame<uint16_t>(*frame, slot + SLOT_HEADER_SIZE);
+#endif
+	}
+	publish(slot, sequence);
+	publish(shm + OFF_SEQUENCE, sequence);
+}
+
+void FrameExporter::processStart(Interpreter& interp, span<const TclObject> tokens,
+                                 TclObject& result)
+{
+	bool doubleSize = false;
+	int slots = 4;
+	ArgsInfo info[] = {
+		flagArg("-doublesize", doubleSize),
+		valueArg("-slots", slots),
+	};
+	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
+	string name = "/openmsx-frames";
+	switch (arguments.size()) {
+	case 0:
+		break;
+	case 1:
+		name = arguments[0].getString().str();
+		break;
+	default:
+		throw SyntaxError();
+	}
+	if (name.empty() || (name[0] != '/')) {
+		name.insert(0, 1, '/');
+	}
+	if ((slots < 1) || (slots > 64)) {
+		throw CommandException("Number of slots must be in range [1, 64].");
+	}
+	if (shm) {
+		result = "Already exporting.";
+	} else {
+		start(name, doubleSize ? 640 : 320, doubleSize ? 480 : 240, slots);
+		result = "Exporting frames to shared memory " + name;
+	}
+}
+
+void FrameExporter::status(TclObject& result) const
+{
+	result.addDictKeyValue("status", shm ? "exporting" : "idle");
+	if (shm) {
+		result.addDictKeyValue("name", shmName);
+		result.addDictKeyValue("width", int(width));
+		result.addDictKeyValue("height", int(height));
+		result.addDictKeyValue("slots", int(numSlots));
+		result.addDictKeyValue("frames", int64_t(sequence));
+	}
+}
+
+
+// class FrameExporter::Cmd
+
+FrameExporter::Cmd::Cmd(CommandController& commandController_)
+	: Command(commandController_, "export_frames")
+{
+}
+
+void FrameExporter::Cmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& exporter = OUTER(FrameExporter, exportCommand);
+	executeSubCommand(tokens[1].getString(),
+		"start",  [&]{ exporter.processStart(getInterpreter(), tokens, result); },
+		"stop",   [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			exporter.stop(); },
+		"status", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			exporter.status(result); });
+}
+
+string FrameExporter::Cmd::help(const vector<string>& /*tokens*/) const
+{
+	return "Publishes every displayed frame in a POSIX shared memory "
+	       "segment, so that other processes can read them.\n"
+	       "export_frames start [<name>]  Export to the given shared "
+	       "memory object (default '/openmsx-frames')\n"
+	       "export_frames stop            Stop exporting, removes the "
+	       "shared memory object\n"
+	       "export_frames status          Query exporting state\n"
+	       "\n"
+	       "The start subcommand also accepts the options '-doublesize' "
+	       "(export at 640x480 instead of 320x240) and '-slots <n>' (size "
+	       "of the ring of frames, default 4).\n"
+	       "The format of the shared memory is described in "
+	       "src/video/FrameExporter.hh. Only rendered frames are exported, "
+	       "use 'set maxframeskip 0' to get all of them.";
+}
+
+void FrameExporter::Cmd::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const cmds[] = { "start", "stop", "status" };
+		completeString(tokens, cmds);
+	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
+		static const char* const options[] = { "-doublesize", "-slots" };
+		completeString(tokens, options);
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,91 @@
+#ifndef FRAMEEXPORTER_HH
+#define FRAMEEXPORTER_HH
+
+#include "Command.hh"
+#include "EmuTime.hh"
+#include "span.hh"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class FrameSource;
+class Interpreter;
+class PostProcessor;
+class Reactor;
+class TclObject;
+
+/** Publishes the emulated frames in a POSIX shared memory segment, so
+  * that external processes can consume them at full rate without any
+  * encoding (like screenshots) or going through Tcl.
+  *
+  * Layout of the segment (all values in host byte order):
+  *   header (64 bytes):
+  *     char[8]   magic "OMSXFRM1"
+  *     uint32_t  size of this header (64)
+  *     uint32_t  number of slots in the ring (N)
+  *     uint32_t  width and height of the frames in pixels
+  *     uint32_t  pitch, number of bytes per line
+  *     uint32_t  bits per pixel (32 or 16)
+  *     uint32_t  red, green and blue pixel masks
+  *     uint32_t  (padding)
+  *     uint64_t  number of published frames
+  *     (padding up to 64 bytes)
+  *   followed by N slots of 'slot size' bytes (the frame size plus 64,
+  *   rounded up to a multiple of 64), each slot:
+  *     uint64_t  sequence number of the frame in this slot, 0 while
+  *               the slot is being (over)written
+  *     uint64_t  emulated time of the frame (in EmuTime ticks)
+  *     (padding up to 64 bytes)
+  *     pixel data, 'height' lines of 'pitch' bytes
+  *
+  * Frame 'n' (counting from 1) is written to slot '(n - 1) % N'. A
+  * consumer reads the number of published frames, reads the pixels of
+  * that frame directly from its slot and afterwards checks that the
+  * sequence number of the slot didn't change (otherwise the frame was
+  * overwritten in the mean time and should be dropped).
+  */
+class FrameExporter
+{
+public:
+	explicit FrameExporter(Reactor& reactor);
+	~FrameExporter();
+
+	void addFrame(FrameSource* frame, EmuTime::param time);
+	void stop();
+
+private:
+	void start(const std::string& name, unsigned width, unsigned height,
+	           unsigned numSlots);
+	void processStart(Interpreter& interp, span<const TclObject> tokens,
+	                  TclObject& result);
+	void status(TclObject& result) const;
+	template<typename Pixel> void copyFrame(FrameSource& frame, uint8_t* dst);
+
+	Reactor& reactor;
+
+	struct Cmd final : Command {
+		explicit Cmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} exportCommand;
+
+	std::vector<PostProcessor*> postProcessors;
+	std::string shmName; // empty when not exporting
+	uint8_t* shm = nullptr;
+	size_t shmSize = 0;
+	size_t slotSize;
+	uint64_t sequence;
+	unsigned numSlots;
+	unsigned width;
+	unsigned height;
+	unsigned pitch;
+	unsigned bpp;
+};
+
+} // namespace openmsx
+
+#endif
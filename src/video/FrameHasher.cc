@@ -0,0 +1,321 @@
+#include "FrameHasher.hh"
+#include "CliComm.hh"
+#include "CommandController.hh"
+#include "CommandException.hh"
+#include "Display.hh"
+#include "Event.hh"
+#include "EventDistributor.hh"
+#include "FinishFrameEvent.hh"
+#include "Interpreter.hh"
+#include "PNG.hh"
+#include "Reactor.hh"
+#include "TclArgParser.hh"
+#include "VideoLayer.hh"
+#include "checked_cast.hh"
+#include "optional.hh"
+#include "outer.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+#include "xxhash.hh"
+#include <cstdlib>
+#include <utility>
+
+using std::string;
+using std::vector;
+
+namespace openmsx {
+
+static unsigned countBits(uint64_t x)
+{
+	unsigned bits = 0;
+	for (; x; x &= x - 1) ++bits;
+	return bits;
+}
+
+FrameHasher::FrameHasher(Reactor& reactor_)
+	: reactor(reactor_)
+	, hashCommand(reactor.getCommandController())
+{
+	reactor.getEventDistributor().registerEventListener(
+		OPENMSX_FINISH_FRAME_EVENT, *this);
+}
+
+FrameHasher::~FrameHasher()
+{
+	reactor.getEventDistributor().unregisterEventListener(
+		OPENMSX_FINISH_FRAME_EVENT, *this);
+}
+
+uint32_t FrameHasher::exactHash(const PNG::Image& image)
+{
+	return xxhash(string_view(
+		reinterpret_cast<const char*>(image.pixels.data()),
+		size_t(image.width) * image.height * 3));
+}
+
+uint64_t FrameHasher::perceptualHash(const PNG::Image& image)
+{
+	static const unsigned COLS = 9;
+	static const unsigned ROWS = 8;
+	uint64_t sum[ROWS][COLS] = {};
+	unsigned count[ROWS][COLS] = {};
+	for (auto y : xrange(image.height)) {
+		unsigned row = y * ROWS / image.height;
+		const uint8_t* line = image.getLinePtr(y);
+		for (auto x : xrange(image.width)) {
+			unsigned col = x * COLS / image.width;
+			const uint8_t* p = &line[3 * x];
+			sum[row][col] += 77 * p[0] + 150 * p[1] + 29 * p[2];
+			++count[row][col];
+		}
+	}
+	uint64_t hash = 0;
+	for (auto row : xrange(ROWS)) {
+		for (auto col : xrange(COLS - 1)) {
+			// compare averages, without dividing
+			uint64_t left  = sum[row][col + 0] * count[row][col + 1];
+			uint64_t right = sum[row][col + 1] * count[row][col + 0];
+			hash = (hash << 1) | (right > left);
+		}
+	}
+	return hash;
+}
+
+uint64_t FrameHasher::computeHash(const Params& params)
+{
+	auto& display = reactor.getDisplay();
+	display.renderOnDemand();
+	auto* videoLayer = dynamic_cast<VideoLayer*>(display.findActiveLayer());
+	if (!videoLayer) {
+		throw CommandException(
+			"Current renderer doesn't support frame hashing.");
+	}
+	PNG::Image image = videoLayer->takeRawScreenShot(params.doubleSize ? 480 : 240);
+	return params.perceptual ? perceptualHash(image) : exactHash(image);
+}
+
+string FrameHasher::formatHash(uint64_t hash, bool perceptual)
+{
+	return perceptual ? strCat(hex_string<16>(hash))
+	                  : strCat(hex_string<8>(uint32_t(hash)));
+}
+
+uint64_t FrameHasher::parseHash(string_view str)
+{
+	string s = str.str();
+	char* end;
+	uint64_t hash = strtoull(s.c_str(), &end, 16);
+	if (s.empty() || (s.size() > 16) || (*end != '\0')) {
+		throw CommandException("Invalid hash: ", str);
+	}
+	return hash;
+}
+
+void FrameHasher::get(Interpreter& interp, span<const TclObject> tokens,
+                      TclObject& result)
+{
+	Params params;
+	ArgsInfo info[] = {
+		flagArg("-perceptual", params.perceptual),
+		flagArg("-doublesize", params.doubleSize),
+	};
+	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
+	if (!arguments.empty()) throw SyntaxError();
+	try {
+		result = formatHash(computeHash(params), params.perceptual);
+	} catch (CommandException&) {
+		throw;
+	} catch (MSXException& e) {
+		throw CommandException("Failed to hash frame: ", e.getMessage());
+	}
+}
+
+void FrameHasher::wait(Interpreter& interp, span<const TclObject> tokens,
+                       TclObject& result)
+{
+	Wait w;
+	int maxDistance = 0;
+	int timeout = -1;
+	optional<TclObject> command;
+	ArgsInfo info[] = {
+		flagArg("-perceptual", w.params.perceptual),
+		flagArg("-doublesize", w.params.doubleSize),
+		valueArg("-maxdistance", maxDistance),
+		valueArg("-timeout", timeout),
+		valueArg("-command", command),
+	};
+	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
+	if (arguments.size() != 1) throw SyntaxError();
+	w.hash = parseHash(arguments[0].getString());
+	if ((maxDistance < 0) || (maxDistance > 64)) {
+		throw CommandException("Maximum distance must be in range [0, 64].");
+	}
+	if ((maxDistance != 0) && !w.params.perceptual) {
+		throw CommandException("-maxdistance can only be used in "
+		                       "combination with -perceptual");
+	}
+	w.maxDistance = maxDistance;
+	w.framesLeft = timeout;
+	if (command) w.command = std::move(*command);
+	unsigned id = ++lastId;
+	waits.emplace(id, std::move(w));
+	result = strCat("frame_hash#", id);
+}
+
+void FrameHasher::cancel(span<const TclObject> tokens)
+{
+	string_view name = tokens[2].getString();
+	for (auto it = begin(waits); it != end(waits); ++it) {
+		if (name == strCat("frame_hash#", it->first)) {
+			waits.erase(it);
+			return;
+		}
+	}
+	throw CommandException("No such wait: ", name);
+}
+
+void FrameHasher::distance(span<const TclObject> tokens, TclObject& result)
+{
+	result = int(countBits(parseHash(tokens[2].getString()) ^
+	                        parseHash(tokens[3].getString())));
+}
+
+int FrameHasher::signalEvent(const std::shared_ptr<const Event>& event)
+{
+	if (waits.empty()) return 0;
+	auto& ffe = checked_cast<const FinishFrameEvent&>(*event);
+	if (ffe.getSource() != ffe.getSelectedSource()) return 0;
+
+	// Compute each kind of hash at most once per frame. The callbacks
+	// are only executed afterwards, because they may add or remove waits.
+	std::map<std::pair<bool, bool>, uint64_t> hashes;
+	vector<TclObject> done;
+	string error;
+	for (auto it = begin(waits); it != end(waits); /**/) {
+		auto& w = it->second;
+		auto key = std::make_pair(w.params.perceptual, w.params.doubleSize);
+		string status;
+		uint64_t hash = 0;
+		if (error.empty()) {
+			auto h = hashes.find(key);
+			if (h != end(hashes)) {
+				hash = h->second;
+			} else {
+				try {
+					hash = computeHash(w.params);
+					hashes[key] = hash;
+				} catch (MSXException& e) {
+					error = e.getMessage();
+				}
+			}
+		}
+		if (!error.empty()) {
+			status = "error";
+		} else {
+			if (countBits(hash ^ w.hash) <= w.maxDistance) {
+				status = "ok";
+			} else if (w.framesLeft > 0) {
+				--w.framesLeft;
+			}
+			if (status.empty() && (w.framesLeft == 0)) {
+				status = "timeout";
+			}
+		}
+		if (status.empty()) {
+			++it;
+			continue;
+		}
+		if (!w.command.getString().empty()) {
+			TclObject command = std::move(w.command);
+			command.addListElement(status, status == "error"
+				? error : formatHash(hash, w.params.perceptual));
+			done.push_back(std::move(command));
+		}
+		it = waits.erase(it);
+	}
+
+	auto& commandController = reactor.getCommandController();
+	for (auto& command : done) {
+		try {
+			commandController.getInterpreter().executeProfiled(
+				command, false, "frame_hash");
+		} catch (CommandException& e) {
+			commandController.getCliComm().printWarning(
+				"Error in frame_hash callback: ", e.getMessage());
+		}
+	}
+	return 0;
+}
+
+
+// class FrameHasher::Cmd
+
+FrameHasher::Cmd::Cmd(CommandController& commandController_)
+	: Command(commandController_, "frame_hash")
+{
+}
+
+void FrameHasher::Cmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& hasher = OUTER(FrameHasher, hashCommand);
+	executeSubCommand(tokens[1].getString(),
+		"get",      [&]{ hasher.get(getInterpreter(), tokens, result); },
+		"wait",     [&]{ hasher.wait(getInterpreter(), tokens, result); },
+		"cancel",   [&]{
+			checkNumArgs(tokens, 3, "id");
+			hasher.cancel(tokens); },
+		"distance", [&]{
+			checkNumArgs(tokens, 4, "hash1 hash2");
+			hasher.distance(tokens, result); });
+}
+
+string FrameHasher::Cmd::help(const vector<string>& /*tokens*/) const
+{
+	return "Computes a hash of the current (raw, 320x240) MSX frame, to "
+	       "check the screen content in automated tests without writing "
+	       "screenshots.\n"
+	       "frame_hash get [<options>]\n"
+	       "    Returns the hash of the current frame.\n"
+	       "frame_hash wait <hash> [<options>] [-timeout <frames>] "
+	       "[-maxdistance <bits>] [-command <command>]\n"
+	       "    Checks the hash at the end of every frame until it equals "
+	       "<hash> or until <frames> frames are checked. Then <command> "
+	       "is executed with two extra arguments: 'ok', 'timeout' or "
+	       "'error' and the last hash (or the error message). Returns an "
+	       "id for the cancel subcommand.\n"
+	       "frame_hash cancel <id>\n"
+	       "    Stops waiting, without executing the command.\n"
+	       "frame_hash distance <hash1> <hash2>\n"
+	       "    Returns the number of bits that differ between two hashes.\n"
+	       "\n"
+	       "Options:\n"
+	       "  -doublesize   hash the frame at 640x480\n"
+	       "  -perceptual   compute a perceptual hash (64 bits) instead "
+	       "of an exact hash (32 bits): similar frames have hashes with a "
+	       "small distance, with -maxdistance 'wait' also accepts such "
+	       "frames.";
+}
+
+void FrameHasher::Cmd::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const cmds[] = {
+			"get", "wait", "cancel", "distance",
+		};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() >= 3) && (tokens[1] == "get")) {
+		static const char* const options[] = {
+			"-perceptual", "-doublesize",
+		};
+		completeString(tokens, options);
+	} else if ((tokens.size() >= 3) && (tokens[1] == "wait")) {
+		static const char* const options[] = {
+			"-perceptual", "-doublesize", "-maxdistance", "-timeout",
+			"-command",
+		};
+		completeString(tokens, options);
+	}
+}
+
+} // namespace openmsx
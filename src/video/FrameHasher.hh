@@ -0,0 +1,84 @@
+#ifndef FRAMEHASHER_HH
+#define FRAMEHASHER_HH
+
+#include "Command.hh"
+#include "EventListener.hh"
+#include "TclObject.hh"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class Interpreter;
+class Reactor;
+namespace PNG { struct Image; }
+
+/** Computes hashes of the (raw) emulated frame, so that automated tests can
+  * check the screen content without writing and comparing screenshots.
+  *
+  * There are two kinds of hashes:
+  *  - exact: xxhash of the RGB pixels, any change gives a different hash.
+  *  - perceptual: a 64-bit 'difference hash'. The frame is reduced to 9x8
+  *    blocks of average brightness and each bit tells whether a block is
+  *    brighter than its left neighbour. Similar frames give hashes that
+  *    differ in only a few bits.
+  * The frame is hashed at 320x240 (or 640x480), like 'screenshot -raw', so
+  * the hashes don't depend on the renderer or the scaler settings.
+  *
+  * Waiting for a certain hash is checked at the end of every frame of the
+  * active video source, without going through Tcl.
+  */
+class FrameHasher final : private EventListener
+{
+public:
+	explicit FrameHasher(Reactor& reactor);
+	~FrameHasher();
+
+	static uint32_t exactHash(const PNG::Image& image);
+	static uint64_t perceptualHash(const PNG::Image& image);
+
+private:
+	struct Params {
+		bool perceptual = false;
+		bool doubleSize = false;
+	};
+	struct Wait {
+		Params params;
+		uint64_t hash;
+		unsigned maxDistance;
+		int framesLeft; // -1 means no timeout
+		TclObject command;
+	};
+
+	uint64_t computeHash(const Params& params);
+	static std::string formatHash(uint64_t hash, bool perceptual);
+	static uint64_t parseHash(string_view str);
+
+	void get(Interpreter& interp, span<const TclObject> tokens,
+	         TclObject& result);
+	void wait(Interpreter& interp, span<const TclObject> tokens,
+	          TclObject& result);
+	void cancel(span<const TclObject> tokens);
+	void distance(span<const TclObject> tokens, TclObject& result);
+
+	// EventListener
+	int signalEvent(const std::shared_ptr<const Event>& event) override;
+
+	Reactor& reactor;
+
+	struct Cmd final : Command {
+		explicit Cmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} hashCommand;
+
+	std::map<unsigned, Wait> waits;
+	unsigned lastId = 0;
+};
+
+} // namespace openmsx
+
+#endif
@@ -10,27 +10,17 @@ std::unique_ptr<Context> context;
 
 Context::Context(int width, int height)
 {
-	VertexShader   texVertexShader  ("texture.vert");
-	FragmentShader texFragmentShader("texture.frag");
 	progTex.allocate();
-	progTex.attach(texVertexShader);
-	progTex.attach(texFragmentShader);
-	progTex.bindAttribLocation(0, "a_position");
-	progTex.bindAttribLocation(1, "a_texCoord");
-	progTex.link();
+	progTex.build({}, "texture.vert", "texture.frag",
+	              {"a_position", "a_texCoord"});
 	progTex.activate();
 	glUniform1i(progTex.getUniformLocation("u_tex"), 0);
 	unifTexColor = progTex.getUniformLocation("u_color");
 	unifTexMvp   = progTex.getUniformLocation("u_mvpMatrix");
 
-	VertexShader   fillVertexShader  ("fill.vert");
-	FragmentShader fillFragmentShader("fill.frag");
 	progFill.allocate();
-	progFill.attach(fillVertexShader);
-	progFill.attach(fillFragmentShader);
-	progFill.bindAttribLocation(0, "a_position");
-	progFill.bindAttribLocation(1, "a_color");
-	progFill.link();
+	progFill.build({}, "fill.vert", "fill.frag",
+	               {"a_position", "a_color"});
 	progFill.activate();
 	unifFillMvp = progFill.getUniformLocation("u_mvpMatrix");
 
@@ -114,6 +114,13 @@ GLImage::GLImage(OutputSurface& /*output*/, SDLSurfacePtr image)
 {
 }
 
+GLImage::GLImage(OutputSurface& /*output*/, SDLSurfacePtr image, ivec2 size_)
+	: texture(loadTexture(std::move(image), size))
+{
+	checkSize(size_);
+	size = size_;
+}
+
 void GLImage::draw(OutputSurface& /*output*/, ivec2 pos, uint8_t r, uint8_t g, uint8_t b, uint8_t alpha)
 {
 	// 4-----------------7
@@ -15,6 +15,7 @@ class GLImage final : public BaseImage
 public:
 	GLImage(OutputSurface& output, const std::string& filename);
 	GLImage(OutputSurface& output, SDLSurfacePtr image);
+	GLImage(OutputSurface& output, SDLSurfacePtr image, gl::ivec2 size);
 	GLImage(OutputSurface& output, const std::string& filename, float scaleFactor);
 	GLImage(OutputSurface& output, const std::string& filename, gl::ivec2 size);
 	GLImage(OutputSurface& output, gl::ivec2 size, unsigned rgba);
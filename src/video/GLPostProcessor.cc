@@ -11,7 +11,9 @@
 #include "random.hh"
 #include "ranges.hh"
 #include "stl.hh"
+#include "unreachable.hh"
 #include "vla.hh"
+#include "xrange.hh"
 #include <cassert>
 #include <cstdint>
 
@@ -41,6 +43,7 @@ GLPostProcessor::GLPostProcessor(
 	scaleAlgorithm = static_cast<RenderSettings::ScaleAlgorithm>(-1); // not a valid scaler
 
 	frameCounter = 0;
+	pboIndex = 0;
 	noiseX = noiseY = 0.0f;
 	preCalcNoise(renderSettings.getNoise());
 
@@ -60,14 +63,14 @@ GLPostProcessor::GLPostProcessor(
 		fbo[i] = FrameBufferObject(colorTex[i]);
 	}
 
-	VertexShader   vertexShader  ("monitor3D.vert");
-	FragmentShader fragmentShader("monitor3D.frag");
-	monitor3DProg.attach(vertexShader);
-	monitor3DProg.attach(fragmentShader);
-	monitor3DProg.bindAttribLocation(0, "a_position");
-	monitor3DProg.bindAttribLocation(1, "a_normal");
-	monitor3DProg.bindAttribLocation(2, "a_texCoord");
-	monitor3DProg.link();
+	monitor3DProg.build({}, "monitor3D.vert", "monitor3D.frag",
+	                    {"a_position", "a_normal", "a_texCoord"});
+	noiseProg.build({}, "noise.vert", "noise.frag",
+	                {"a_position", "a_texCoord", "a_noiseCoord"});
+	noiseProg.activate();
+	glUniform1i(noiseProg.getUniformLocation("u_tex"),    0);
+	glUniform1i(noiseProg.getUniformLocation("u_noiseA"), 1);
+	glUniform1i(noiseProg.getUniformLocation("u_noiseB"), 2);
 	preCalcMonitor3D(renderSettings.getHorizontalStretch());
 
 	renderSettings.getNoiseSetting().attach(*this);
@@ -189,7 +192,14 @@ void GLPostProcessor::paint(OutputSurface& /*output*/)
 		//GLUtil::checkGLError("GLPostProcessor::paint");
 	}
 
-	drawNoise();
+	// When the frame is drawn from a texture anyway (and that texture isn't
+	// needed for the glow effect), the noise is added while doing that.
+	// That's one pass instead of two (blended) passes over the whole
+	// frame.
+	bool noise = renderSettings.getNoise() != 0.0f;
+	bool fuseNoise = noise && renderToTexture && (glow == 0) &&
+	                 (deform != RenderSettings::DEFORM_3D);
+	if (!fuseNoise) drawNoise();
 	drawGlow(glow);
 
 	if (renderToTexture) {
@@ -204,6 +214,11 @@ void GLPostProcessor::paint(OutputSurface& /*output*/)
 		} else {
 			float x1 = (320.0f - float(horStretch)) / (2.0f * 320.0f);
 			float x2 = 1.0f - x1;
+			if (fuseNoise) {
+				drawFrameWithNoise(x1, x2);
+				storedFrame = true;
+				return;
+			}
 
 			static const vec2 pos[4] = {
 				vec2(-1, 1), vec2(-1,-1), vec2( 1,-1), vec2( 1, 1)
@@ -260,15 +275,30 @@ void GLPostProcessor::uploadFrame()
 {
 	createRegions();
 
+	pboIndex = (pboIndex + 1) % NUM_PBOS;
+
+	// All regions with the same line width go to the same texture (and
+	// pixel buffer). Upload them together, so that the pixel buffer only
+	// needs to be mapped once.
 	const unsigned srcHeight = paintFrame->getHeight();
-	for (auto& r : regions) {
-		// upload data
-		// TODO get before/after data from scaler
-		unsigned before = 1;
-		unsigned after  = 1;
-		uploadBlock(std::max<int>(0,         r.srcStartY - before),
-		            std::min<int>(srcHeight, r.srcEndY   + after),
-		            r.lineWidth);
+	std::vector<bool> done(regions.size(), false);
+	std::vector<std::pair<unsigned, unsigned>> blocks;
+	for (auto i : xrange(regions.size())) {
+		if (done[i]) continue;
+		unsigned lineWidth = regions[i].lineWidth;
+		blocks.clear();
+		for (auto j : xrange(i, regions.size())) {
+			auto& r = regions[j];
+			if (r.lineWidth != lineWidth) continue;
+			done[j] = true;
+			// TODO get before/after data from scaler
+			unsigned before = 1;
+			unsigned after  = 1;
+			blocks.emplace_back(
+				std::max<int>(0,         r.srcStartY - before),
+				std::min<int>(srcHeight, r.srcEndY   + after));
+		}
+		uploadBlocks(lineWidth, blocks);
 	}
 
 	if (superImposeVideoFrame) {
@@ -293,8 +323,8 @@ void GLPostProcessor::uploadFrame()
 	}
 }
 
-void GLPostProcessor::uploadBlock(
-	unsigned srcStartY, unsigned srcEndY, unsigned lineWidth)
+void GLPostProcessor::uploadBlocks(
+	unsigned lineWidth, span<const std::pair<unsigned, unsigned>> blocks)
 {
 	// create texture/pbo if needed
 	auto it = ranges::find_if(textures, EqualTupleValue<0>(lineWidth));
@@ -302,88 +332,137 @@ void GLPostProcessor::uploadBlock(
 		TextureData textureData;
 
 		textureData.tex.resize(lineWidth, height * 2); // *2 for interlace
+		textureData.lineHashes.resize(height * 2);
+		textureData.hashKnown.resize(height * 2, false);
 
-		if (textureData.pbo.openGLSupported()) {
-			textureData.pbo.setImage(lineWidth, height * 2);
+		for (auto& p : textureData.pbo) {
+			if (p.openGLSupported()) {
+				p.setImage(lineWidth, height * 2);
+			}
 		}
 
 		textures.emplace_back(lineWidth, std::move(textureData));
 		it = end(textures) - 1;
 	}
 	auto& tex = it->second.tex;
-	auto& pbo = it->second.pbo;
+	auto& pbo = it->second.pbo[pboIndex];
+	auto& lineHashes = it->second.lineHashes;
+	auto& hashKnown  = it->second.hashKnown;
+
+	// Skip lines that didn't change since they were last uploaded to this
+	// texture. This is only known when we're painting a RawFrame directly
+	// (so e.g. not when deinterlacing or superimposing).
+	const RawFrame* rawFrame =
+		(paintFrame == lastFrames[0].get()) ? lastFrames[0].get() : nullptr;
+	std::vector<std::pair<unsigned, unsigned>> changed;
+	for (auto& b : blocks) {
+		for (unsigned y = b.first; y < b.second; ++y) {
+			if (rawFrame) {
+				uint32_t hash = rawFrame->getLineHash(y);
+				bool same = hashKnown[y] && (lineHashes[y] == hash);
+				lineHashes[y] = hash;
+				hashKnown[y] = true;
+				if (same) continue;
+			} else {
+				hashKnown[y] = false;
+			}
+			if (!changed.empty() && (changed.back().second == y)) {
+				++changed.back().second;
+			} else {
+				changed.emplace_back(y, y + 1);
+			}
+		}
+	}
+#if defined(__APPLE__)
+	// The nVidia GL driver for the GeForce 8000/9000 series seems to hang
+	// on texture data replacements that are 1 pixel wide and start on a
+	// line number that is a non-zero multiple of 16.
+	if (lineWidth == 1) {
+		for (auto& c : changed) {
+			if (c.first != 0 && c.first % 16 == 0) {
+				c.first--;
+			}
+		}
+	}
+#endif
 
 	// bind texture
 	tex.bind();
 
 	// upload data
 	uint32_t* mapped;
-	if (pbo.openGLSupported()) {
+	if (changed.empty()) {
+		mapped = nullptr;
+	} else if (pbo.openGLSupported()) {
 		pbo.bind();
 		mapped = pbo.mapWrite();
 	} else {
 		mapped = nullptr;
 	}
 	if (mapped) {
-		for (unsigned y = srcStartY; y < srcEndY; ++y) {
-			auto* dest = mapped + y * lineWidth;
-			auto* data = paintFrame->getLinePtr(y, lineWidth, dest);
-			if (data != dest) {
-				memcpy(dest, data, lineWidth * sizeof(uint32_t));
+		for (auto& b : changed) {
+			for (unsigned y = b.first; y < b.second; ++y) {
+				auto* dest = mapped + y * lineWidth;
+				auto* data = paintFrame->getLinePtr(y, lineWidth, dest);
+				if (data != dest) {
+					memcpy(dest, data, lineWidth * sizeof(uint32_t));
+				}
 			}
 		}
 		pbo.unmap();
-#if defined(__APPLE__)
-		// The nVidia GL driver for the GeForce 8000/9000 series seems to hang
-		// on texture data replacements that are 1 pixel wide and start on a
-		// line number that is a non-zero multiple of 16.
-		if (lineWidth == 1 && srcStartY != 0 && srcStartY % 16 == 0) {
-			srcStartY--;
+		for (auto& b : changed) {
+			unsigned srcStartY = b.first;
+			unsigned srcEndY   = b.second;
+			glTexSubImage2D(
+				GL_TEXTURE_2D,       // target
+				0,                   // level
+				0,                   // offset x
+				srcStartY,           // offset y
+				lineWidth,           // width
+				srcEndY - srcStartY, // height
+				GL_BGRA,             // format
+				GL_UNSIGNED_BYTE,    // type
+				pbo.getOffset(0, srcStartY)); // data
 		}
-#endif
-		glTexSubImage2D(
-			GL_TEXTURE_2D,       // target
-			0,                   // level
-			0,                   // offset x
-			srcStartY,           // offset y
-			lineWidth,           // width
-			srcEndY - srcStartY, // height
-			GL_BGRA,             // format
-			GL_UNSIGNED_BYTE,    // type
-			pbo.getOffset(0, srcStartY)); // data
 	}
-	if (pbo.openGLSupported()) {
+	if (mapped) {
 		pbo.unbind();
-	}
-	if (!mapped) {
+	} else if (!changed.empty()) {
+		if (pbo.openGLSupported()) {
+			pbo.unbind();
+		}
 		glPixelStorei(GL_UNPACK_ROW_LENGTH, paintFrame->getRowLength());
-		unsigned y = srcStartY;
-		unsigned remainingLines = srcEndY - srcStartY;
 		VLA_SSE_ALIGNED(uint32_t, buf, lineWidth);
-		while (remainingLines) {
-			unsigned lines;
-			auto* data = paintFrame->getMultiLinePtr(
-				y, remainingLines, lines, lineWidth, buf);
-			glTexSubImage2D(
-				GL_TEXTURE_2D,     // target
-				0,                 // level
-				0,                 // offset x
-				y,                 // offset y
-				lineWidth,         // width
-				lines,             // height
-				GL_BGRA,           // format
-				GL_UNSIGNED_BYTE,  // type
-				data);             // data
-
-			y += lines;
-			remainingLines -= lines;
+		for (auto& b : changed) {
+			unsigned y = b.first;
+			unsigned remainingLines = b.second - b.first;
+			while (remainingLines) {
+				unsigned lines;
+				auto* data = paintFrame->getMultiLinePtr(
+					y, remainingLines, lines, lineWidth, buf);
+				glTexSubImage2D(
+					GL_TEXTURE_2D,     // target
+					0,                 // level
+					0,                 // offset x
+					y,                 // offset y
+					lineWidth,         // width
+					lines,             // height
+					GL_BGRA,           // format
+					GL_UNSIGNED_BYTE,  // type
+					data);             // data
+
+				y += lines;
+				remainingLines -= lines;
+			}
 		}
 		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0); // restore default
 	}
 
 	// possibly upload scaler specific data
 	if (currScaler) {
-		currScaler->uploadBlock(srcStartY, srcEndY, lineWidth, *paintFrame);
+		for (auto& b : blocks) {
+			currScaler->uploadBlock(b.first, b.second, lineWidth, *paintFrame);
+		}
 	}
 }
 
@@ -454,29 +533,34 @@ void GLPostProcessor::preCalcNoise(float factor)
 		buf2);            // data
 }
 
+// Rotate and mirror noise texture in consecutive frames to avoid
+// seeing 'patterns' in the noise.
+static const vec2 noisePos[8][4] = {
+	{ { -1, -1 }, {  1, -1 }, {  1,  1 }, { -1,  1 } },
+	{ { -1,  1 }, {  1,  1 }, {  1, -1 }, { -1, -1 } },
+	{ { -1,  1 }, { -1, -1 }, {  1, -1 }, {  1,  1 } },
+	{ {  1,  1 }, {  1, -1 }, { -1, -1 }, { -1,  1 } },
+	{ {  1,  1 }, { -1,  1 }, { -1, -1 }, {  1, -1 } },
+	{ {  1, -1 }, { -1, -1 }, { -1,  1 }, {  1,  1 } },
+	{ {  1, -1 }, {  1,  1 }, { -1,  1 }, { -1, -1 } },
+	{ { -1, -1 }, { -1,  1 }, {  1,  1 }, {  1, -1 } }
+};
+
+void GLPostProcessor::getNoiseTexCoords(vec2 (&tex)[4]) const
+{
+	vec2 noise(noiseX, noiseY);
+	tex[0] = noise + vec2(0.0f, 1.875f);
+	tex[1] = noise + vec2(2.0f, 1.875f);
+	tex[2] = noise + vec2(2.0f, 0.0f  );
+	tex[3] = noise + vec2(0.0f, 0.0f  );
+}
+
 void GLPostProcessor::drawNoise()
 {
 	if (renderSettings.getNoise() == 0.0f) return;
 
-	// Rotate and mirror noise texture in consecutive frames to avoid
-	// seeing 'patterns' in the noise.
-	static const vec2 pos[8][4] = {
-		{ { -1, -1 }, {  1, -1 }, {  1,  1 }, { -1,  1 } },
-		{ { -1,  1 }, {  1,  1 }, {  1, -1 }, { -1, -1 } },
-		{ { -1,  1 }, { -1, -1 }, {  1, -1 }, {  1,  1 } },
-		{ {  1,  1 }, {  1, -1 }, { -1, -1 }, { -1,  1 } },
-		{ {  1,  1 }, { -1,  1 }, { -1, -1 }, {  1, -1 } },
-		{ {  1, -1 }, { -1, -1 }, { -1,  1 }, {  1,  1 } },
-		{ {  1, -1 }, {  1,  1 }, { -1,  1 }, { -1, -1 } },
-		{ { -1, -1 }, { -1,  1 }, {  1,  1 }, {  1, -1 } }
-	};
-	vec2 noise(noiseX, noiseY);
-	const vec2 tex[4] = {
-		noise + vec2(0.0f, 1.875f),
-		noise + vec2(2.0f, 1.875f),
-		noise + vec2(2.0f, 0.0f  ),
-		noise + vec2(0.0f, 0.0f  )
-	};
+	vec2 tex[4];
+	getNoiseTexCoords(tex);
 
 	gl::context->progTex.activate();
 
@@ -487,7 +571,7 @@ void GLPostProcessor::drawNoise()
 	glUniformMatrix4fv(gl::context->unifTexMvp, 1, GL_FALSE, &I[0][0]);
 
 	unsigned seq = frameCounter & 7;
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, pos[seq]);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, noisePos[seq]);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, tex);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
@@ -504,6 +588,59 @@ void GLPostProcessor::drawNoise()
 	glDisable(GL_BLEND);
 }
 
+void GLPostProcessor::drawFrameWithNoise(float x1, float x2)
+{
+	// Same as drawNoise(), but the noise texture coordinates are mapped
+	// to the corners of the (horizontally stretched) quad.
+	vec2 noiseTex[4];
+	getNoiseTexCoords(noiseTex);
+	const auto& noisePosSeq = noisePos[frameCounter & 7];
+	auto noiseAt = [&](vec2 p) { // p in [-1, 1] x [-1, 1]
+		for (int i = 0; i < 4; ++i) {
+			if ((noisePosSeq[i][0] == p[0]) &&
+			    (noisePosSeq[i][1] == p[1])) {
+				return noiseTex[i];
+			}
+		}
+		UNREACHABLE;
+		return vec2();
+	};
+	vec2 n00 = noiseAt(vec2(-1, -1));
+	vec2 n10 = noiseAt(vec2( 1, -1));
+	vec2 n01 = noiseAt(vec2(-1,  1));
+	auto noiseCoord = [&](float u, float v) { // u, v in [0, 1]
+		return n00 + (n10 - n00) * u + (n01 - n00) * v;
+	};
+
+	static const vec2 pos[4] = {
+		vec2(-1, 1), vec2(-1,-1), vec2( 1,-1), vec2( 1, 1)
+	};
+	const vec2 tex[4] = {
+		vec2(x1, 1), vec2(x1, 0), vec2(x2, 0), vec2(x2, 1)
+	};
+	const vec2 noise[4] = {
+		noiseCoord(x1, 1), noiseCoord(x1, 0),
+		noiseCoord(x2, 0), noiseCoord(x2, 1)
+	};
+
+	noiseProg.activate();
+	glActiveTexture(GL_TEXTURE1);
+	noiseTextureA.bind();
+	glActiveTexture(GL_TEXTURE2);
+	noiseTextureB.bind();
+	glActiveTexture(GL_TEXTURE0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, pos);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, tex);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, noise);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	glDisableVertexAttribArray(2);
+	glDisableVertexAttribArray(1);
+	glDisableVertexAttribArray(0);
+}
+
 static const int GRID_SIZE = 16;
 static const int GRID_SIZE1 = GRID_SIZE + 1;
 static const int NUM_INDICES = (GRID_SIZE1 * 2 + 2) * GRID_SIZE - 2;
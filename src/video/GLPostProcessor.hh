@@ -4,6 +4,9 @@
 #include "PostProcessor.hh"
 #include "RenderSettings.hh"
 #include "GLUtil.hh"
+#include "gl_vec.hh"
+#include "span.hh"
+#include <cstdint>
 #include <utility>
 #include <vector>
 #include <memory>
@@ -15,6 +18,12 @@ class MSXMotherBoard;
 class Display;
 
 /** Rasterizer using SDL.
+  * TODO: The MSX image itself is still rasterized on the CPU (SDLRasterizer)
+  *       and only uploaded here. Rasterizing on the GPU needs the same
+  *       per-draw snapshot of VRAM, sprite and VDP register state as a
+  *       threaded rasterizer (see PixelRenderer), plus a shader for each
+  *       display mode and for the sprite modes. Per-line content hashes
+  *       (see RawFrame) already limit the upload to the changed lines.
   */
 class GLPostProcessor final : public PostProcessor
 {
@@ -38,11 +47,13 @@ protected:
 private:
 	void createRegions();
 	void uploadFrame();
-	void uploadBlock(unsigned srcStartY, unsigned srcEndY,
-	                 unsigned lineWidth);
+	void uploadBlocks(unsigned lineWidth,
+	                  span<const std::pair<unsigned, unsigned>> blocks);
 
 	void preCalcNoise(float factor);
+	void getNoiseTexCoords(gl::vec2 (&tex)[4]) const;
 	void drawNoise();
+	void drawFrameWithNoise(float x1, float x2);
 	void drawGlow(int glow);
 
 	void preCalcMonitor3D(float width);
@@ -60,9 +71,19 @@ private:
 	gl::Texture noiseTextureB;
 	float noiseX, noiseY;
 
+	/** Each texture has a ring of pixel buffers which are used in turn
+	  * (one per frame). Because the GPU might still be transferring data
+	  * from the buffer of the previous frame, reusing that buffer
+	  * immediately could stall until that transfer is finished.
+	  */
+	static const unsigned NUM_PBOS = 3;
 	struct TextureData {
 		gl::ColorTexture tex;
-		gl::PixelBuffer<unsigned> pbo;
+		gl::PixelBuffer<unsigned> pbo[NUM_PBOS];
+		// RawFrame line hashes of the data currently in the texture,
+		// only meaningful when the corresponding 'hashKnown' is set.
+		std::vector<uint32_t> lineHashes;
+		std::vector<bool> hashKnown;
 	};
 	std::vector<std::pair<unsigned, TextureData>> textures;
 
@@ -87,12 +108,14 @@ private:
 
 	unsigned height;
 	unsigned frameCounter;
+	unsigned pboIndex;
 
 	/** Currently active scale algorithm, used to detect scaler changes.
 	  */
 	RenderSettings::ScaleAlgorithm scaleAlgorithm;
 
 	gl::ShaderProgram monitor3DProg;
+	gl::ShaderProgram noiseProg; // copy a texture and add noise
 	gl::BufferObject arrayBuffer;
 	gl::BufferObject elementbuffer;
 
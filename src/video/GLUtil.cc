@@ -1,10 +1,14 @@
 #include "GLUtil.hh"
+#include "DecodedFileCache.hh"
 #include "File.hh"
 #include "FileContext.hh"
 #include "FileException.hh"
 #include "InitException.hh"
+#include "sha1.hh"
+#include "strCat.hh"
 #include "vla.hh"
 #include "Version.hh"
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <cstdio>
@@ -159,17 +163,27 @@ Shader::Shader(GLenum type, const string& header, const string& filename)
 	init(type, header, filename);
 }
 
-void Shader::init(GLenum type, const string& header, const string& filename)
+static bool loadShaderSource(const string& header, const string& filename,
+                             string& source)
 {
-	// Load shader source.
-	string source = "#version 110\n" + header;
+	source = "#version 110\n" + header;
 	try {
 		File file(systemFileContext().resolve("shaders/" + filename));
 		auto mmap = file.mmap();
 		source.append(reinterpret_cast<const char*>(mmap.data()),
 		              mmap.size());
+		return true;
 	} catch (FileException& e) {
 		std::cerr << "Cannot find shader: " << e.getMessage() << '\n';
+		return false;
+	}
+}
+
+void Shader::init(GLenum type, const string& header, const string& filename)
+{
+	// Load shader source.
+	string source;
+	if (!loadShaderSource(header, filename, source)) {
 		handle = 0;
 		return;
 	}
@@ -296,6 +310,106 @@ void ShaderProgram::link()
 	}
 }
 
+// Can linked programs be stored (and loaded again)? Some drivers support the
+// extension but don't offer any binary format.
+static bool programBinarySupported()
+{
+	static const bool supported = [] {
+		if (!GLEW_ARB_get_program_binary) return false;
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		return numFormats > 0;
+	}();
+	return supported;
+}
+
+static const char* getGLString(GLenum name)
+{
+	auto* str = reinterpret_cast<const char*>(glGetString(name));
+	return str ? str : "";
+}
+
+void ShaderProgram::build(const string& header, const string& vertFilename,
+                          const string& fragFilename,
+                          std::initializer_list<const char*> attributes)
+{
+	// Sanity check on this program.
+	if (handle == 0) return;
+
+	// A program binary is only valid for the exact same driver, so that's
+	// part of the key, next to (a hash of) everything that went into the
+	// program.
+	string cacheKey;
+	if (programBinarySupported()) {
+		string vertSource, fragSource;
+		if (loadShaderSource(header, vertFilename, vertSource) &&
+		    loadShaderSource(header, fragFilename, fragSource)) {
+			string input = strCat(vertSource, '\0', fragSource);
+			for (auto* name : attributes) strAppend(input, '\0', name);
+			auto sum = SHA1::calc(
+				reinterpret_cast<const uint8_t*>(input.data()),
+				input.size());
+			cacheKey = strCat(getGLString(GL_VENDOR), '\n',
+			                  getGLString(GL_RENDERER), '\n',
+			                  getGLString(GL_VERSION), '\n',
+			                  sum.toString());
+			if (loadBinary(cacheKey)) return;
+		}
+	}
+
+	VertexShader   vShader(header, vertFilename);
+	FragmentShader fShader(header, fragFilename);
+	attach(vShader);
+	attach(fShader);
+	unsigned index = 0;
+	for (auto* name : attributes) bindAttribLocation(index++, name);
+	if (!cacheKey.empty()) {
+		glProgramParameteri(handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+		                    GL_TRUE);
+	}
+	link();
+	if (!cacheKey.empty() && isOK()) storeBinary(cacheKey);
+}
+
+bool ShaderProgram::loadBinary(const string& key)
+{
+	File file;
+	size_t size;
+	string extra;
+	if (!DecodedFileCache::open("glprogram", key, 0, file, size, extra)) {
+		return false;
+	}
+	GLenum format;
+	if (extra.size() != sizeof(format)) return false;
+	memcpy(&format, extra.data(), sizeof(format));
+	try {
+		MemBuffer<uint8_t> buf(size);
+		file.read(buf.data(), size);
+		glProgramBinary(handle, format, buf.data(), GLsizei(size));
+	} catch (FileException&) {
+		return false;
+	}
+	// Fails e.g. when the driver was updated without changing its version
+	// string, then the program is built from source again.
+	return isOK();
+}
+
+void ShaderProgram::storeBinary(const string& key)
+{
+	GLint length = 0;
+	glGetProgramiv(handle, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+	MemBuffer<uint8_t> buf(length);
+	GLsizei written = 0;
+	GLenum format = 0;
+	glGetProgramBinary(handle, length, &written, &format, buf.data());
+	if (written <= 0) return;
+	DecodedFileCache::store(
+		"glprogram", key, 0, buf.data(), written,
+		string_view(reinterpret_cast<const char*>(&format),
+		            sizeof(format)));
+}
+
 void ShaderProgram::bindAttribLocation(unsigned index, const char* name)
 {
 	glBindAttribLocation(handle, index, name);
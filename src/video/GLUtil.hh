@@ -16,8 +16,9 @@
 
 #include "MemBuffer.hh"
 #include "build-info.hh"
-#include <string>
 #include <cassert>
+#include <initializer_list>
+#include <string>
 
 namespace gl {
 
@@ -430,6 +431,16 @@ public:
 	  */
 	void link();
 
+	/** Compile the given vertex and fragment shader (both get the same
+	  * header), bind the given attribute names to locations 0, 1, ...
+	  * and link them into this program. When the driver supports it, the
+	  * linked program is stored in the DecodedFileCache, so that next time
+	  * the (slow) compile and link steps can be skipped.
+	  */
+	void build(const std::string& header, const std::string& vertFilename,
+	           const std::string& fragFilename,
+	           std::initializer_list<const char*> attributes);
+
 	/** Bind the given name for a vertex shader attribute to the given
 	  * location.
 	  */
@@ -449,6 +460,9 @@ public:
 	void validate();
 
 private:
+	bool loadBinary(const std::string& key);
+	void storeBinary(const std::string& key);
+
 	GLuint handle;
 };
 
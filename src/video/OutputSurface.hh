@@ -1,6 +1,7 @@
 #ifndef OUTPUTSURFACE_HH
 #define OUTPUTSURFACE_HH
 
+#include "PNG.hh"
 #include "gl_vec.hh"
 #include <string>
 #include <cassert>
@@ -126,10 +127,11 @@ public:
 	  */
 	virtual void flushFrameBuffer();
 
-	/** Save the content of this OutputSurface to a PNG file.
-	  * @throws MSXException If creating the PNG file fails.
+	/** Copy the content of this OutputSurface to an image (that can be
+	  * saved with PNG::save()).
+	  * @throws MSXException If reading the pixels fails.
 	  */
-	virtual void saveScreenshot(const std::string& filename) = 0;
+	virtual PNG::Image grabScreenshot() = 0;
 
 	/** Clear screen (paint it black).
 	 */
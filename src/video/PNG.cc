@@ -294,8 +294,21 @@ static void flushData(png_structp ctx)
 	file->flush();
 }
 
+static int toPNGFilter(Filter filter)
+{
+	switch (filter) {
+		case Filter::NONE:    return PNG_FILTER_NONE;
+		case Filter::SUB:     return PNG_FILTER_SUB;
+		case Filter::UP:      return PNG_FILTER_UP;
+		case Filter::AVERAGE: return PNG_FILTER_AVG;
+		case Filter::PAETH:   return PNG_FILTER_PAETH;
+		default:              return PNG_ALL_FILTERS;
+	}
+}
+
 static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
-                           const std::string& filename, bool color)
+                           const std::string& filename, bool color,
+                           const Options& options = Options())
 {
 	try {
 		File file(filename, File::TRUNCATE);
@@ -318,6 +331,11 @@ static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
 		// Set up the output control.
 		png_set_write_fn(png.ptr, &file, writeData, flushData);
 
+		if (options.compression != -1) {
+			png_set_compression_level(png.ptr, options.compression);
+		}
+		png_set_filter(png.ptr, PNG_FILTER_TYPE_BASE, toPNGFilter(options.filter));
+
 		// Mark this image as being generated by openMSX and add creation time.
 		std::string version = Version::full();
 		png_text text[2];
@@ -364,25 +382,9 @@ static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
 	}
 }
 
-static void save(SDL_Surface* image, const std::string& filename)
-{
-	SDLAllocFormatPtr frmt24(SDL_AllocFormat(
-		OPENMSX_BIGENDIAN ? SDL_PIXELFORMAT_BGR24 : SDL_PIXELFORMAT_RGB24));
-	SDLSurfacePtr surf24(SDL_ConvertSurface(image, frmt24.get(), 0));
-
-	// Create the array of pointers to image data
-	VLA(const void*, row_pointers, image->h);
-	for (int i = 0; i < image->h; ++i) {
-		row_pointers[i] = surf24.getLinePtr(i);
-	}
-
-	IMG_SavePNG_RW(image->w, image->h, row_pointers, filename, true);
-}
-
-void save(unsigned width, unsigned height, const void** rowPointers,
-          const SDL_PixelFormat& format, const std::string& filename)
+Image convert(unsigned width, unsigned height, const void** rowPointers,
+              const SDL_PixelFormat& format)
 {
-	// this implementation creates 1 extra copy, can be optimized if required
 	SDLSurfacePtr surface(
 		width, height, format.BitsPerPixel,
 		format.Rmask, format.Gmask, format.Bmask, format.Amask);
@@ -390,13 +392,26 @@ void save(unsigned width, unsigned height, const void** rowPointers,
 		memcpy(surface.getLinePtr(y),
 		       rowPointers[y], width * format.BytesPerPixel);
 	}
-	save(surface.get(), filename);
+	SDLAllocFormatPtr frmt24(SDL_AllocFormat(
+		OPENMSX_BIGENDIAN ? SDL_PIXELFORMAT_BGR24 : SDL_PIXELFORMAT_RGB24));
+	SDLSurfacePtr surf24(SDL_ConvertSurface(surface.get(), frmt24.get(), 0));
+
+	Image image(width, height);
+	for (unsigned y = 0; y < height; ++y) {
+		memcpy(image.getLinePtr(y), surf24.getLinePtr(y), width * 3);
+	}
+	return image;
 }
 
-void save(unsigned width, unsigned height,
-          const void** rowPointers, const std::string& filename)
+void save(const Image& image, const std::string& filename,
+          const Options& options)
 {
-	IMG_SavePNG_RW(width, height, rowPointers, filename, true);
+	VLA(const void*, rowPointers, image.height);
+	for (unsigned y = 0; y < image.height; ++y) {
+		rowPointers[y] = image.getLinePtr(y);
+	}
+	IMG_SavePNG_RW(image.width, image.height, rowPointers, filename, true,
+	               options);
 }
 
 void saveGrayscale(unsigned width, unsigned height,
@@ -1,7 +1,9 @@
 #ifndef PNG_HH
 #define PNG_HH
 
+#include "MemBuffer.hh"
 #include "SDLSurfacePtr.hh"
+#include <cstdint>
 #include <string>
 
 struct SDL_PixelFormat;
@@ -19,10 +21,45 @@ namespace PNG {
 	 */
 	SDLSurfacePtr load(const std::string& filename, bool want32bpp);
 
-	void save(unsigned width, unsigned height, const void** rowPointers,
-	          const SDL_PixelFormat& format, const std::string& filename);
-	void save(unsigned width, unsigned height, const void** rowPointers,
-	          const std::string& filename);
+	/** Row filter(s) that are tried before compressing a line. Trying
+	  * all of them gives the smallest files, a single fixed filter is a
+	  * lot faster.
+	  */
+	enum class Filter { NONE, SUB, UP, AVERAGE, PAETH, ALL };
+
+	/** Speed versus size trade-off when writing a PNG file. The defaults
+	  * are those of libpng.
+	  */
+	struct Options {
+		int compression = -1; // zlib level 0 (none) - 9 (best), -1 = default
+		Filter filter = Filter::ALL;
+	};
+
+	/** A RGB24 image that owns its pixels. Unlike the row pointers passed
+	  * to save(), this can outlive the source of the pixels (e.g. to
+	  * encode the image on another thread).
+	  */
+	struct Image {
+		Image(unsigned width_, unsigned height_)
+			: width(width_), height(height_)
+			, pixels(size_t(width_) * height_ * 3) {}
+
+		uint8_t* getLinePtr(unsigned y) { return &pixels[size_t(y) * width * 3]; }
+		const uint8_t* getLinePtr(unsigned y) const { return &pixels[size_t(y) * width * 3]; }
+
+		unsigned width;
+		unsigned height;
+		MemBuffer<uint8_t> pixels;
+	};
+
+	/** Copy (and convert) the lines of a picture in the given pixel format
+	  * to a RGB24 image.
+	  */
+	Image convert(unsigned width, unsigned height, const void** rowPointers,
+	              const SDL_PixelFormat& format);
+
+	void save(const Image& image, const std::string& filename,
+	          const Options& options = Options());
 	void saveGrayscale(unsigned width, unsigned height,
 	                   const void** rowPointers, const std::string& filename);
 
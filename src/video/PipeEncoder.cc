@@ -0,0 +1,148 @@
+#include "PipeEncoder.hh"
+#include "FileOperations.hh"
+#include "Filename.hh"
+#include "MSXException.hh"
+#include "PixelOperations.hh"
+#include "WavWriter.hh"
+#include "build-info.hh"
+#include "cstdiop.hh" // for snprintf
+#include "strCat.hh"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+namespace openmsx {
+
+static void replaceAll(std::string& str, const char* from, const std::string& to)
+{
+	size_t len = strlen(from);
+	size_t pos = 0;
+	while ((pos = str.find(from, pos)) != std::string::npos) {
+		str.replace(pos, len, to);
+		pos += to.size();
+	}
+}
+
+PipeEncoder::PipeEncoder(std::string command_, std::string output_,
+                         unsigned width_, unsigned height_,
+                         unsigned channels_, unsigned freq)
+	: command(std::move(command_))
+	, output(std::move(output_))
+	, frame(3 * width_ * height_, 0)
+	, width(width_)
+	, height(height_)
+	, channels(channels_)
+{
+	if (freq != 0) {
+		wavWriter = std::make_unique<Wav16Writer>(
+			Filename(getAudioFilename(output)), channels, freq);
+	}
+}
+
+PipeEncoder::~PipeEncoder()
+{
+	try {
+		if (pending && !pipe) {
+			// a recording of a single frame, the frame rate is unknown
+			fps = 50.0f;
+			startProcess();
+		}
+		if (pending) writeFrame();
+	} catch (MSXException&) {
+		// nothing we can do about it here
+	}
+	if (pipe) {
+#ifdef _WIN32
+		_pclose(pipe);
+#else
+		pclose(pipe);
+#endif
+	}
+}
+
+std::string PipeEncoder::getAudioFilename(const std::string& output)
+{
+	return strCat(FileOperations::stripExtension(output), ".wav");
+}
+
+void PipeEncoder::setFps(float fps_)
+{
+	fps = fps_;
+}
+
+void PipeEncoder::startProcess()
+{
+	char fpsStr[32];
+	snprintf(fpsStr, sizeof(fpsStr), "%.3f", fps);
+	std::string cmd = command;
+	replaceAll(cmd, "{width}",  strCat(width));
+	replaceAll(cmd, "{height}", strCat(height));
+	replaceAll(cmd, "{fps}",    fpsStr);
+	replaceAll(cmd, "{output}", output);
+#ifdef _WIN32
+	pipe = _popen(cmd.c_str(), "wb");
+#else
+	// a write error is reported by fwrite(), don't get killed by SIGPIPE
+	signal(SIGPIPE, SIG_IGN);
+	pipe = popen(cmd.c_str(), "w");
+#endif
+	if (!pipe) {
+		throw MSXException("Couldn't start encoder '", cmd, "': ",
+		                   strerror(errno));
+	}
+}
+
+void PipeEncoder::writeFrame()
+{
+	if (fwrite(frame.data(), 1, frame.size(), pipe) != frame.size()) {
+		throw MSXException("Error writing to the encoder, "
+		                   "did it exit prematurely?");
+	}
+	pending = false;
+}
+
+template<typename Pixel>
+void PipeEncoder::convert(const Pixel* pixels, const SDL_PixelFormat& pixelFormat)
+{
+	PixelOperations<Pixel> pixelOps(pixelFormat);
+	uint8_t* dst = frame.data();
+	for (unsigned i = 0; i < (width * height); ++i) {
+		dst[0] = pixelOps.red256  (pixels[i]);
+		dst[1] = pixelOps.green256(pixels[i]);
+		dst[2] = pixelOps.blue256 (pixels[i]);
+		dst += 3;
+	}
+}
+
+void PipeEncoder::addFrame(const void* pixels, const SDL_PixelFormat& pixelFormat,
+                           unsigned samples, int16_t* sampleData)
+{
+	if (!pipe && (fps != 0.0f)) {
+		startProcess();
+		if (pending) writeFrame(); // still holds the previous frame
+	}
+	if (pixels) {
+#if HAVE_32BPP
+		if (pixelFormat.BytesPerPixel == 4) {
+			convert(static_cast<const uint32_t*>(pixels), pixelFormat);
+		} else
+#endif
+		{
+#if HAVE_16BPP
+			convert(static_cast<const uint16_t*>(pixels), pixelFormat);
+#endif
+		}
+	}
+	// else repeat the previous frame
+	if (pipe) {
+		writeFrame();
+	} else {
+		pending = true;
+	}
+
+	if (wavWriter && samples) {
+		wavWriter->write(sampleData, channels, samples / channels);
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,57 @@
+#ifndef PIPEENCODER_HH
+#define PIPEENCODER_HH
+
+#include "VideoEncoder.hh"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class Wav16Writer;
+
+/** Sends the frames of a video recording to an external encoder program
+  * (e.g. ffmpeg, which can use codecs like x264 or FFV1 and hardware
+  * encoders) via its standard input, as raw 'rgb24' frames. The program
+  * is started (via the shell) when the frame rate is known. In the command
+  * '{width}', '{height}', '{fps}' and '{output}' are replaced by their
+  * actual values.
+  *
+  * The audio is written to a separate WAV file, next to the output file.
+  */
+class PipeEncoder final : public VideoEncoder
+{
+public:
+	PipeEncoder(std::string command, std::string output, unsigned width,
+	            unsigned height, unsigned channels, unsigned freq);
+	~PipeEncoder() override;
+
+	void setFps(float fps) override;
+	void addFrame(const void* pixels, const SDL_PixelFormat& pixelFormat,
+	              unsigned samples, int16_t* sampleData) override;
+
+	/** Name of the WAV file, derived from the output file name. */
+	static std::string getAudioFilename(const std::string& output);
+
+private:
+	void startProcess();
+	void writeFrame();
+	template<typename Pixel>
+	void convert(const Pixel* pixels, const SDL_PixelFormat& pixelFormat);
+
+	const std::string command;
+	const std::string output;
+	std::vector<uint8_t> frame; // last frame, in rgb24 format
+	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
+	FILE* pipe = nullptr;
+	const unsigned width;
+	const unsigned height;
+	const unsigned channels;
+	float fps = 0.0f;
+	bool pending = false; // frame not yet sent (process not started)
+};
+
+} // namespace openmsx
+
+#endif
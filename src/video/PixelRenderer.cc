@@ -16,6 +16,8 @@ TODO:
 #include "SpriteChecker.hh"
 #include "EventDistributor.hh"
 #include "FinishFrameEvent.hh"
+#include "FrameProfiler.hh"
+#include "Instrumentation.hh"
 #include "RealTime.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
@@ -125,6 +127,10 @@ PixelRenderer::PixelRenderer(VDP& vdp_, Display& display)
 
 	renderSettings.getMaxFrameSkipSetting().attach(*this);
 	renderSettings.getMinFrameSkipSetting().attach(*this);
+
+	if (auto* postProcessor = getPostProcessor()) {
+		postProcessor->setRenderOnDemand([this] { return renderOnDemand(); });
+	}
 }
 
 PixelRenderer::~PixelRenderer()
@@ -147,12 +153,14 @@ void PixelRenderer::reInit()
 
 	rasterizer->reset();
 	displayEnabled = vdp.isDisplayEnabled();
+	updateVRAMNotify();
 }
 
 void PixelRenderer::updateDisplayEnabled(bool enabled, EmuTime::param time)
 {
 	sync(time, true);
 	displayEnabled = enabled;
+	updateVRAMNotify();
 }
 
 void PixelRenderer::frameStart(EmuTime::param time)
@@ -161,10 +169,15 @@ void PixelRenderer::frameStart(EmuTime::param time)
 		frameSkipCounter = 999;
 		renderFrame = false;
 		prevRenderFrame = false;
+		updateVRAMNotify();
 		return;
 	}
 	prevRenderFrame = renderFrame;
-	if (vdp.isInterlaced() && renderSettings.getDeinterlace() &&
+	if (renderSettings.getRenderOnDemand()) {
+		// Only render when recording, other frames are rendered when
+		// requested, see renderOnDemand().
+		renderFrame = rasterizer->isRecording();
+	} else if (vdp.isInterlaced() && renderSettings.getDeinterlace() &&
 	    vdp.getEvenOdd() && vdp.isEvenOddEnabled()) {
 		// deinterlaced odd frame, do same as even frame
 	} else {
@@ -187,6 +200,7 @@ void PixelRenderer::frameStart(EmuTime::param time)
 			}
 		}
 	}
+	updateVRAMNotify();
 	if (!renderFrame) return;
 
 	rasterizer->frameStart(time);
@@ -209,7 +223,10 @@ void PixelRenderer::frameEnd(EmuTime::param time)
 
 		// Let underlying graphics system finish rendering this frame.
 		auto time1 = Timer::getTime();
-		rasterizer->frameEnd();
+		{
+			INSTRUMENT_ZONE("Rasterizer::frameEnd");
+			rasterizer->frameEnd();
+		}
 		auto time2 = Timer::getTime();
 		auto current = time2 - time1;
 		const float ALPHA = 0.2f;
@@ -234,6 +251,49 @@ void PixelRenderer::frameEnd(EmuTime::param time)
 	}
 }
 
+bool PixelRenderer::renderOnDemand()
+{
+	// Only needed when the current frame is skipped because of the
+	// 'render_on_demand' setting (otherwise the last completely rendered
+	// frame is already available).
+	if (renderFrame || !renderSettings.getRenderOnDemand() ||
+	    !rasterizer->isActive()) {
+		return false;
+	}
+	EmuTime time = vdp.getCurrentTime();
+
+	// We can't go back to the start of this frame, so render a complete
+	// frame from the current VDP state. Raster effects are lost, and lines
+	// below the current beam position use the sprites of the previous
+	// frame, but for static images this is pixel-exact.
+	vram.sync(time);
+	if (vdp.spritesEnabled()) {
+		spriteChecker.checkUntil(time);
+	}
+	rasterizer->frameStart(time);
+	accuracy = renderSettings.getAccuracy();
+	nextX = 0;
+	nextY = 0;
+	textModeCounter = 0;
+
+	bool savedDisplayEnabled = displayEnabled;
+	int displayStart = vdp.getLineZero();
+	int displayEnd = displayStart + vdp.getNumberOfLines();
+	int numLines = vdp.getTicksPerFrame() / VDP::TICKS_PER_LINE;
+	displayEnabled = false;
+	drawUntil(0, displayStart);
+	displayEnabled = vdp.isBlankingDisabled();
+	drawUntil(0, displayEnd);
+	displayEnabled = false;
+	drawUntil(0, numLines);
+	displayEnabled = savedDisplayEnabled;
+
+	rasterizer->frameEnd();
+	// Pass the frame to the PostProcessor (it becomes the paint frame).
+	rasterizer->frameStart(time);
+	return true;
+}
+
 void PixelRenderer::updateHorizontalScrollLow(
 	byte scroll, EmuTime::param time)
 {
@@ -408,9 +468,9 @@ inline bool PixelRenderer::checkSync(int offset, EmuTime::param time)
 
 	// If display is disabled, VRAM changes will not affect the
 	// renderer output, therefore sync is not necessary.
-	// TODO: Have bitmapVisibleWindow disabled in this case.
+	// Note: updateVRAMNotify() already suppresses the updateVRAM() calls
+	//       in this case and during skipped frames.
 	if (!displayEnabled) return false;
-	//if (frameSkipCounter != 0) return false; // TODO
 	if (accuracy == RenderSettings::ACC_SCREEN) return false;
 
 	// Calculate what display lines are scanned between current
@@ -487,10 +547,17 @@ inline bool PixelRenderer::checkSync(int offset, EmuTime::param time)
 	}
 }
 
+void PixelRenderer::updateVRAMNotify()
+{
+	// Skip the updateVRAM() calls when they would be ignored anyway.
+	vram.bitmapVisibleWindow.setNotifyEnabled(renderFrame && displayEnabled);
+}
+
 void PixelRenderer::updateVRAM(unsigned offset, EmuTime::param time)
 {
 	// Note: No need to sync if display is disabled, because then the
 	//       output does not depend on VRAM (only on background color).
+	//       See also updateVRAMNotify().
 	if (renderFrame && displayEnabled && checkSync(offset, time)) {
 		//fprintf(stderr, "vram sync @ line %d\n",
 		//	vdp.getTicksThisFrame(time) / VDP::TICKS_PER_LINE);
@@ -521,7 +588,6 @@ void PixelRenderer::sync(EmuTime::param time, bool force)
 	// the past.
 	// TODO: I wonder if it's possible to enforce this synchronisation
 	//       scheme at a higher level. Probably. But how...
-	//if ((frameSkipCounter == 0) && TODO
 	if (accuracy != RenderSettings::ACC_SCREEN || force) {
 		vram.sync(time);
 		renderUntil(time);
@@ -563,12 +629,20 @@ void PixelRenderer::renderUntil(EmuTime::param time)
 	// Also it is a small performance optimisation.
 	if (limitX == nextX && limitY == nextY) return;
 
-	if (displayEnabled) {
-		if (vdp.spritesEnabled()) {
-			// Update sprite checking, so that rasterizer can call getSprites.
-			spriteChecker.checkUntil(time);
-		}
+	FrameProfiler::Section section(
+		vdp.getReactor().getFrameProfiler(), FrameProfiler::VDP);
+	INSTRUMENT_ZONE("PixelRenderer::renderUntil");
+	if (displayEnabled && vdp.spritesEnabled()) {
+		// Update sprite checking, so that rasterizer can call getSprites.
+		INSTRUMENT_ZONE("SpriteChecker::checkUntil");
+		spriteChecker.checkUntil(time);
+	}
+	drawUntil(limitX, limitY);
+}
 
+void PixelRenderer::drawUntil(int limitX, int limitY)
+{
+	if (displayEnabled) {
 		// Calculate start and end of borders in ticks since start of line.
 		// The 0..7 extra horizontal scroll low pixels should be drawn in
 		// border color. These will be drawn together with the border,
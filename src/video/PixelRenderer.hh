@@ -22,6 +22,25 @@ class VideoSourceSetting;
 
 /** Generic implementation of a pixel-based Renderer.
   * Uses a Rasterizer to plot actual pixels for a specific video system.
+  *
+  * TODO: Rasterize in a separate thread. The draw calls from this class
+  *       alone can't be moved to another thread (or be recorded and
+  *       replayed later): during a draw the rasterizer (and the bitmap/
+  *       character/sprite converters it uses) directly reads VRAM, the
+  *       SpriteChecker buffers and many VDP registers (scroll, adjust,
+  *       even/odd, multi-page, ...), and all of those only have the right
+  *       value at the moment of the draw. A render thread would need its
+  *       own copy of that state, so:
+  *        - an ordered log of the VRAM writes inside the observed windows
+  *          (each write already triggers a draw first, see updateVRAM()),
+  *          applied to a VRAM copy owned by the render thread,
+  *        - every VDP state change (the update*() methods below) recorded
+  *          in the same stream instead of queried via 'vdp',
+  *        - the per-line sprite info, copied when the line is drawn,
+  *        - recycling RawFrames between the threads in rotateFrames().
+  *       Until then the cost is reduced by skipping unneeded frames
+  *       (frameskip, render_on_demand) and by scaling on multiple threads
+  *       in FBPostProcessor.
   */
 class PixelRenderer final : public Renderer, private Observer<Setting>
 {
@@ -99,6 +118,22 @@ private:
 	  */
 	void renderUntil(EmuTime::param time);
 
+	/** Render lines until the specified position (in the current frame).
+	  * Unlike renderUntil() this doesn't update the sprite checker.
+	  */
+	void drawUntil(int limitX, int limitY);
+
+	/** (Re)enable or suppress the updateVRAM() calls, depending on
+	  * whether the current frame is rendered and the display is enabled.
+	  */
+	void updateVRAMNotify();
+
+	/** Render the current frame (from the current VDP state) when it was
+	  * skipped because of the 'render_on_demand' setting.
+	  * @return true iff a frame was rendered.
+	  */
+	bool renderOnDemand();
+
 	/** The VDP of which the video output is being rendered.
 	  */
 	VDP& vdp;
@@ -9,6 +9,7 @@
 #include "RenderSettings.hh"
 #include "RawFrame.hh"
 #include "AviRecorder.hh"
+#include "FrameExporter.hh"
 #include "CliComm.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
@@ -35,6 +36,7 @@ PostProcessor::PostProcessor(MSXMotherBoard& motherBoard_,
 	, screen(screen_)
 	, paintFrame(nullptr)
 	, recorder(nullptr)
+	, frameExporter(nullptr)
 	, superImposeVideoFrame(nullptr)
 	, superImposeVdpFrame(nullptr)
 	, interleaveCount(0)
@@ -73,6 +75,12 @@ PostProcessor::~PostProcessor()
 			"during recording.");
 		recorder->stop();
 	}
+	if (frameExporter) {
+		getCliComm().printWarning(
+			"Frame export stopped, because you changed machine "
+			"or changed a video setting during exporting.");
+		frameExporter->stop();
+	}
 }
 
 CliComm& PostProcessor::getCliComm()
@@ -190,6 +198,9 @@ std::unique_ptr<RawFrame> PostProcessor::rotateFrames(
 			assert(!recorder);
 		}
 	}
+	if (frameExporter && needRecord()) {
+		frameExporter->addFrame(paintFrame, time);
+	}
 
 	// Return recycled frame to the caller
 	if (canDoInterlace) {
@@ -255,7 +266,7 @@ static void getScaledFrame(FrameSource& paintFrame, unsigned bpp,
 	}
 }
 
-void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filename)
+PNG::Image PostProcessor::takeRawScreenShot(unsigned height2)
 {
 	if (!paintFrame) {
 		throw CommandException("TODO");
@@ -265,7 +276,7 @@ void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filen
 	WorkBuffer workBuffer;
 	getScaledFrame(*paintFrame, getBpp(), height2, lines, workBuffer);
 	unsigned width = (height2 == 240) ? 320 : 640;
-	PNG::save(width, height2, lines, paintFrame->getSDLPixelFormat(), filename);
+	return PNG::convert(width, height2, lines, paintFrame->getSDLPixelFormat());
 }
 
 unsigned PostProcessor::getBpp() const
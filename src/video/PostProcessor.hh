@@ -4,6 +4,7 @@
 #include "VideoLayer.hh"
 #include "Schedulable.hh"
 #include "EmuTime.hh"
+#include <functional>
 #include <memory>
 
 namespace openmsx {
@@ -15,6 +16,7 @@ class DeinterlacedFrame;
 class Display;
 class DoubledFrame;
 class EventDistributor;
+class FrameExporter;
 class FrameSource;
 class RawFrame;
 class RenderSettings;
@@ -75,6 +77,12 @@ public:
 	  */
 	bool isRecording() const { return recorder != nullptr; }
 
+	/** Start/stop exporting frames to shared memory.
+	  * @param exporter_ Finished frames are also pushed to this
+	  *                  FrameExporter. nullptr means not exporting.
+	  */
+	void setFrameExporter(FrameExporter* exporter_) { frameExporter = exporter_; }
+
 	/** Get the number of bits per pixel for the pixels in these frames.
 	  * @return Possible values are 15, 16 or 32
 	  */
@@ -86,8 +94,24 @@ public:
 	  */
 	FrameSource* getPaintFrame() const { return paintFrame; }
 
+	/** Set the function that renders the current frame when the renderer
+	  * skipped it because of the 'render_on_demand' setting. This
+	  * function should return true iff it actually rendered a new frame.
+	  */
+	void setRenderOnDemand(std::function<bool()> callback) {
+		renderOnDemandCallback = std::move(callback);
+	}
+
+	/** Make sure the paint frame is up-to-date, also when frames are
+	  * only rendered on demand. E.g. called before taking a screenshot.
+	  * @return true iff a new frame was rendered.
+	  */
+	bool renderOnDemand() {
+		return renderOnDemandCallback && renderOnDemandCallback();
+	}
+
 	// VideoLayer
-	void takeRawScreenShot(unsigned height, const std::string& filename) override;
+	PNG::Image takeRawScreenShot(unsigned height) override;
 
 
 	CliComm& getCliComm();
@@ -132,6 +156,9 @@ protected:
 	/** Video recorder, nullptr when not recording. */
 	AviRecorder* recorder;
 
+	/** Shared memory frame exporter, nullptr when not exporting. */
+	FrameExporter* frameExporter;
+
 	/** Video frame on which to superimpose the (VDP) output.
 	  * nullptr when not superimposing. */
 	const RawFrame* superImposeVideoFrame;
@@ -156,6 +183,8 @@ private:
 
 	EmuTime lastRotate;
 	EventDistributor& eventDistributor;
+
+	std::function<bool()> renderOnDemandCallback;
 };
 
 } // namespace openmsx
@@ -1,4 +1,5 @@
 #include "RawFrame.hh"
+#include "xxhash.hh"
 #include <cstdint>
 #include <SDL.h>
 
@@ -8,6 +9,8 @@ RawFrame::RawFrame(
 		const SDL_PixelFormat& format, unsigned maxWidth_, unsigned height_)
 	: FrameSource(format)
 	, lineWidths(height_)
+	, lineHashes(height_)
+	, lineDirty(height_)
 	, maxWidth(maxWidth_)
 {
 	setHeight(height_);
@@ -47,6 +50,21 @@ const void* RawFrame::getLineInfo(
 	return data.data() + line * pitch;
 }
 
+uint32_t RawFrame::getLineHash(unsigned line) const
+{
+	assert(line < getHeight());
+	if (lineDirty[line]) {
+		// The hashed size includes the line width, so e.g. a blank line
+		// doesn't collide with a full line of the same color.
+		auto* pixels = reinterpret_cast<const uint8_t*>(
+			data.data() + line * pitch);
+		size_t size = lineWidths[line] * getSDLPixelFormat().BytesPerPixel;
+		lineHashes[line] = xxhash_impl<true>(pixels, size);
+		lineDirty[line] = false;
+	}
+	return lineHashes[line];
+}
+
 unsigned RawFrame::getRowLength() const
 {
 	return maxWidth; // in pixels (not in bytes)
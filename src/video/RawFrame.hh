@@ -5,6 +5,7 @@
 #include "MemBuffer.hh"
 #include "openmsx.hh"
 #include <cassert>
+#include <cstdint>
 
 namespace openmsx {
 
@@ -29,6 +30,7 @@ public:
 
 	template<typename Pixel>
 	Pixel* getLinePtrDirect(unsigned y) {
+		lineDirty[y] = true; // assume the caller will modify this line
 		return reinterpret_cast<Pixel*>(data.data() + y * pitch);
 	}
 
@@ -40,6 +42,7 @@ public:
 		assert(line < getHeight());
 		assert(width <= maxWidth);
 		lineWidths[line] = width;
+		lineDirty[line] = true;
 	}
 
 	template <class Pixel>
@@ -48,8 +51,19 @@ public:
 		auto* pixels = getLinePtrDirect<Pixel>(line);
 		pixels[0] = color;
 		lineWidths[line] = 1;
+		lineDirty[line] = true;
 	}
 
+	/** Returns a hash of the content (pixels and width) of the given line.
+	  * When the hash of a line equals the hash of the same line in an
+	  * earlier frame, the line is (with very high probability) unchanged.
+	  * Consumers can use this to skip work on unchanged lines.
+	  * The hash is (re)calculated lazily, after the line was modified via
+	  * getLinePtrDirect(), setLineWidth() or setBlank(). So only call
+	  * this once the frame is completely rendered.
+	  */
+	uint32_t getLineHash(unsigned line) const;
+
 	unsigned getRowLength() const override;
 
 	// RawFrame is mostly agnostic of the border info struct. The only
@@ -66,6 +80,8 @@ protected:
 private:
 	MemBuffer<char, 64> data;
 	MemBuffer<unsigned> lineWidths;
+	mutable MemBuffer<uint32_t> lineHashes;
+	mutable MemBuffer<bool> lineDirty;
 	unsigned maxWidth;
 	unsigned pitch;
 
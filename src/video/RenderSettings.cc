@@ -75,6 +75,12 @@ RenderSettings::RenderSettings(CommandController& commandController)
 	, minFrameSkipSetting(commandController,
 		"minframeskip", "set the min amount of frameskip", 0, 0, 100)
 
+	, renderOnDemandSetting(commandController,
+		"render_on_demand", "only render a frame when it's needed for a "
+		"screenshot or video recording (this disables normal video "
+		"output, intended for automated runs)",
+		false, Setting::DONT_SAVE)
+
 	, fullScreenSetting(commandController,
 		"fullscreen", "full screen display on/off", false)
 
@@ -64,6 +64,10 @@ public:
 	IntegerSetting& getMinFrameSkipSetting() { return minFrameSkipSetting; }
 	int getMinFrameSkip() const { return minFrameSkipSetting.getInt(); }
 
+	/** Only render frames when they're actually needed (for screenshots
+	  * or video recording)? Intended for headless/automated runs. */
+	bool getRenderOnDemand() const { return renderOnDemandSetting.getBoolean(); }
+
 	/** Full screen [on, off]. */
 	BooleanSetting& getFullScreenSetting() { return fullScreenSetting; }
 	bool getFullScreen() const { return fullScreenSetting.getBoolean(); }
@@ -205,6 +209,7 @@ private:
 	BooleanSetting deflickerSetting;
 	IntegerSetting maxFrameSkipSetting;
 	IntegerSetting minFrameSkipSetting;
+	BooleanSetting renderOnDemandSetting;
 	BooleanSetting fullScreenSetting;
 	FloatSetting gammaSetting;
 	FloatSetting brightnessSetting;
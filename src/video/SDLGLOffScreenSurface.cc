@@ -40,9 +40,9 @@ void SDLGLOffScreenSurface::clearScreen()
 	SDLGLOutputSurface::clearScreen();
 }
 
-void SDLGLOffScreenSurface::saveScreenshot(const std::string& filename)
+PNG::Image SDLGLOffScreenSurface::grabScreenshot()
 {
-	SDLGLOutputSurface::saveScreenshot(filename, *this);
+	return SDLGLOutputSurface::grabScreenshot(*this);
 }
 
 } // namespace openmsx
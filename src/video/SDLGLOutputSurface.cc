@@ -4,9 +4,8 @@
 #include "PNG.hh"
 #include "build-info.hh"
 #include "Math.hh"
-#include "MemBuffer.hh"
-#include "vla.hh"
 #include <SDL.h>
+#include <algorithm>
 
 using namespace gl;
 
@@ -103,19 +102,19 @@ void SDLGLOutputSurface::clearScreen()
 	glClear(GL_COLOR_BUFFER_BIT);
 }
 
-void SDLGLOutputSurface::saveScreenshot(
-	const std::string& filename, const OutputSurface& output) const
+PNG::Image SDLGLOutputSurface::grabScreenshot(const OutputSurface& output) const
 {
 	gl::ivec2 offset = output.getViewOffset();
 	gl::ivec2 size   = output.getViewSize();
 
-	VLA(const void*, rowPointers, size[1]);
-	MemBuffer<uint8_t> buffer(size[0] * size[1] * 3);
-	for (int i = 0; i < size[1]; ++i) {
-		rowPointers[size[1] - 1 - i] = &buffer[size[0] * 3 * i];
+	PNG::Image image(size[0], size[1]);
+	glReadPixels(offset[0], offset[1], size[0], size[1], GL_RGB, GL_UNSIGNED_BYTE, image.pixels.data());
+	// openGL returns the lines bottom to top
+	for (int i = 0; i < size[1] / 2; ++i) {
+		std::swap_ranges(image.getLinePtr(i), image.getLinePtr(i) + size[0] * 3,
+		                 image.getLinePtr(size[1] - 1 - i));
 	}
-	glReadPixels(offset[0], offset[1], size[0], size[1], GL_RGB, GL_UNSIGNED_BYTE, buffer.data());
-	PNG::save(size[0], size[1], rowPointers, filename);
+	return image;
 }
 
 } // namespace openmsx
@@ -3,6 +3,7 @@
 
 #include "GLUtil.hh"
 #include "MemBuffer.hh"
+#include "PNG.hh"
 #include <string>
 
 namespace openmsx {
@@ -30,8 +31,7 @@ protected:
 	void init(OutputSurface& output);
 	void flushFrameBuffer(unsigned width, unsigned height);
 	void clearScreen();
-	void saveScreenshot(const std::string& filename,
-	                    const OutputSurface& output) const;
+	PNG::Image grabScreenshot(const OutputSurface& output) const;
 
 private:
 	float texCoordX, texCoordY;
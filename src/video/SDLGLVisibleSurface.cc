@@ -28,6 +28,10 @@ SDLGLVisibleSurface::SDLGLVisibleSurface(
 	//flags |= SDL_RESIZABLE;
 	createSurface(width, height, flags);
 	glContext = SDL_GL_CreateContext(window.get());
+	if (!glContext) {
+		throw InitException(
+			"Could not create openGL context: ", SDL_GetError());
+	}
 
 	// From the glew documentation:
 	//   GLEW obtains information on the supported extensions from the
@@ -46,6 +50,13 @@ SDLGLVisibleSurface::SDLGLVisibleSurface(
 	// This must happen after GL itself is initialised, which is done by
 	// the SDL_SetVideoMode() call in createSurface().
 	GLenum glew_error = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// A GLEW that was built for GLX also tries to load the GLX extensions,
+	// that fails when the context was created via EGL (e.g. with SDL's
+	// 'offscreen' video driver, for rendering without a display). The GL
+	// functions themselves did get loaded.
+	if (glew_error == GLEW_ERROR_NO_GLX_DISPLAY) glew_error = GLEW_OK;
+#endif
 	if (glew_error != GLEW_OK) {
 		throw InitException(
 			"Failed to init GLEW: ",
@@ -96,9 +107,9 @@ void SDLGLVisibleSurface::clearScreen()
 	SDLGLOutputSurface::clearScreen();
 }
 
-void SDLGLVisibleSurface::saveScreenshot(const std::string& filename)
+PNG::Image SDLGLVisibleSurface::grabScreenshot()
 {
-	SDLGLOutputSurface::saveScreenshot(filename, *this);
+	return SDLGLOutputSurface::grabScreenshot(*this);
 }
 
 void SDLGLVisibleSurface::finish()
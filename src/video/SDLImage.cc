@@ -244,6 +244,13 @@ SDLImage::SDLImage(OutputSurface& output, SDLSurfacePtr image)
 {
 }
 
+SDLImage::SDLImage(OutputSurface& output, SDLSurfacePtr image, ivec2 size_)
+	: texture(toTexture(output, *image))
+	, flipX(size_[0] < 0), flipY(size_[1] < 0)
+{
+	size = size_; // replace image size
+}
+
 SDLTexturePtr SDLImage::toTexture(OutputSurface& output, SDL_Surface& surface)
 {
 	SDLTexturePtr result(SDL_CreateTextureFromSurface(
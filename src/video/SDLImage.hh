@@ -12,6 +12,7 @@ class SDLImage final : public BaseImage
 public:
 	SDLImage(OutputSurface& output, const std::string& filename);
 	SDLImage(OutputSurface& output, SDLSurfacePtr image);
+	SDLImage(OutputSurface& output, SDLSurfacePtr image, gl::ivec2 size);
 	SDLImage(OutputSurface& output, const std::string& filename, float scaleFactor);
 	SDLImage(OutputSurface& output, const std::string& filename, gl::ivec2 size);
 	SDLImage(OutputSurface& output, gl::ivec2 size, unsigned rgba);
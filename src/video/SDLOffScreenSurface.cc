@@ -34,9 +34,9 @@ SDLOffScreenSurface::SDLOffScreenSurface(const SDL_Surface& proto)
 	setSDLRenderer(renderer.get());
 }
 
-void SDLOffScreenSurface::saveScreenshot(const std::string& filename)
+PNG::Image SDLOffScreenSurface::grabScreenshot()
 {
-	SDLVisibleSurface::saveScreenshotSDL(*this, filename);
+	return SDLVisibleSurface::grabScreenshotSDL(*this);
 }
 
 void SDLOffScreenSurface::clearScreen()
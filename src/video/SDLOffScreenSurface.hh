@@ -14,7 +14,7 @@ public:
 
 private:
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	PNG::Image grabScreenshot() override;
 	void clearScreen() override;
 
 	MemBuffer<char, SSE2_ALIGNMENT> buffer;
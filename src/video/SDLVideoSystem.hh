@@ -41,7 +41,7 @@ public:
 #endif
 	bool checkSettings() override;
 	void flush() override;
-	void takeScreenShot(const std::string& filename, bool withOsd) override;
+	PNG::Image takeScreenShot(bool withOsd) override;
 	void updateWindowTitle() override;
 	OutputSurface* getOutputSurface() override;
 
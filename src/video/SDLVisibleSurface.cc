@@ -6,7 +6,6 @@
 #include "OSDGUILayer.hh"
 #include "MSXException.hh"
 #include "unreachable.hh"
-#include "vla.hh"
 #include "build-info.hh"
 #include <cstdint>
 #include <memory>
@@ -82,27 +81,22 @@ std::unique_ptr<OutputSurface> SDLVisibleSurface::createOffScreenSurface()
 	return std::make_unique<SDLOffScreenSurface>(*getSDLSurface());
 }
 
-void SDLVisibleSurface::saveScreenshot(const std::string& filename)
+PNG::Image SDLVisibleSurface::grabScreenshot()
 {
-	saveScreenshotSDL(*this, filename);
+	return grabScreenshotSDL(*this);
 }
 
-void SDLVisibleSurface::saveScreenshotSDL(
-	OutputSurface& output, const std::string& filename)
+PNG::Image SDLVisibleSurface::grabScreenshotSDL(OutputSurface& output)
 {
 	unsigned width = output.getWidth();
 	unsigned height = output.getHeight();
-	VLA(const void*, rowPointers, height);
-	MemBuffer<uint8_t> buffer(width * height * 3);
-	for (unsigned i = 0; i < height; ++i) {
-		rowPointers[i] = &buffer[width * 3 * i];
-	}
+	PNG::Image image(width, height);
 	if (SDL_RenderReadPixels(
 			output.getSDLRenderer(), nullptr,
-			SDL_PIXELFORMAT_RGB24, buffer.data(), width * 3)) {
+			SDL_PIXELFORMAT_RGB24, image.pixels.data(), width * 3)) {
 		throw MSXException("Couldn't acquire screenshot pixels: ", SDL_GetError());
 	}
-	PNG::save(width, height, rowPointers, filename);
+	return image;
 }
 
 void SDLVisibleSurface::clearScreen()
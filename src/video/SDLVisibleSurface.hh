@@ -15,12 +15,11 @@ public:
 	                  InputEventGenerator& inputEventGenerator,
 	                  CliComm& cliComm);
 
-	static void saveScreenshotSDL(OutputSurface& output,
-	                              const std::string& filename);
+	static PNG::Image grabScreenshotSDL(OutputSurface& output);
 
 private:
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	PNG::Image grabScreenshot() override;
 	void clearScreen() override;
 
 	// VisibleSurface
@@ -0,0 +1,116 @@
+#include "ScreenShotWriter.hh"
+#include "CliComm.hh"
+#include "CommandController.hh"
+#include "CommandException.hh"
+#include "Event.hh"
+#include "EventDistributor.hh"
+#include "File.hh"
+#include "Interpreter.hh"
+#include "MSXException.hh"
+#include <algorithm>
+#include <thread>
+
+namespace openmsx {
+
+// Each image is about 1MB (640x480 RGB24) or more (-with-osd).
+static const unsigned MAX_PENDING = 16;
+
+ScreenShotWriter::ScreenShotWriter(CommandController& commandController_,
+                                   EventDistributor& eventDistributor_)
+	: commandController(commandController_)
+	, eventDistributor(eventDistributor_)
+{
+	eventDistributor.registerEventListener(OPENMSX_SCREENSHOT_DONE_EVENT, *this);
+}
+
+ScreenShotWriter::~ScreenShotWriter()
+{
+	// Don't lose screenshots that were already taken.
+	for (auto& w : workers) {
+		w->waitIdle();
+	}
+	eventDistributor.unregisterEventListener(OPENMSX_SCREENSHOT_DONE_EVENT, *this);
+}
+
+void ScreenShotWriter::write(PNG::Image image, std::string filename,
+                             const PNG::Options& options, TclObject callback)
+{
+	if (workers.empty()) {
+		static const unsigned MAX_WORKERS = 8;
+		unsigned numWorkers = std::max(1u, std::min(
+			std::thread::hardware_concurrency(), MAX_WORKERS));
+		for (unsigned i = 0; i < numWorkers; ++i) {
+			workers.push_back(std::make_unique<WorkerThread>());
+		}
+	}
+	// Already create the (empty) file. This reports errors like a wrong
+	// directory immediately and it reserves the name, so that the next
+	// numbered screenshot doesn't get the same name.
+	{ File file(filename, File::TRUNCATE); }
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCond.wait(lock, [&] { return pending < MAX_PENDING; });
+		++pending;
+	}
+	unsigned id = ++lastId;
+	if (!callback.getString().empty()) {
+		callbacks[id] = std::move(callback);
+	}
+
+	// Jobs must be copyable, so share the (move-only) image.
+	auto img = std::make_shared<PNG::Image>(std::move(image));
+	workers[nextWorker]->push([this, id, img, filename, options] {
+		Result r{id, true, filename};
+		try {
+			PNG::save(*img, filename, options);
+		} catch (MSXException& e) {
+			r.ok = false;
+			r.value = e.getMessage();
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			results.push_back(std::move(r));
+			--pending;
+		}
+		doneCond.notify_one();
+		eventDistributor.distributeEvent(
+			std::make_shared<SimpleEvent>(OPENMSX_SCREENSHOT_DONE_EVENT));
+	});
+	nextWorker = (nextWorker + 1) % workers.size();
+}
+
+int ScreenShotWriter::signalEvent(const std::shared_ptr<const Event>& /*event*/)
+{
+	std::deque<Result> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::swap(finished, results);
+	}
+	auto& cliComm = commandController.getCliComm();
+	for (auto& r : finished) {
+		if (r.ok) {
+			cliComm.printInfo("Screen saved to ", r.value);
+		}
+		auto it = callbacks.find(r.id);
+		if (it == end(callbacks)) {
+			if (!r.ok) {
+				cliComm.printWarning("Failed to save screenshot: ", r.value);
+			}
+			continue;
+		}
+		TclObject command = std::move(it->second);
+		callbacks.erase(it);
+		command.addListElement(r.ok ? "ok" : "error", r.value);
+		try {
+			commandController.getInterpreter().executeProfiled(
+				command, false, "screenshot");
+		} catch (CommandException& e) {
+			cliComm.printWarning("Error in screenshot callback: ",
+			                     e.getMessage());
+		}
+	}
+	return 0;
+}
+
+} // namespace openmsx
@@ -0,0 +1,74 @@
+#ifndef SCREENSHOTWRITER_HH
+#define SCREENSHOTWRITER_HH
+
+#include "EventListener.hh"
+#include "PNG.hh"
+#include "TclObject.hh"
+#include "WorkerThread.hh"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class CommandController;
+class EventDistributor;
+
+/** Encodes screenshots to PNG files on background threads, so that taking
+  * (many) screenshots doesn't stall the emulation.
+  *
+  * The images are spread over a few worker threads (up to one per CPU
+  * core). When an image is written, the result is passed back to the main
+  * thread via an event, where the optional callback command is executed.
+  * To bound the memory usage, write() blocks while too many images are
+  * waiting to be encoded. On destruction all pending images are still
+  * written (but their callbacks are not executed anymore).
+  */
+class ScreenShotWriter final : private EventListener
+{
+public:
+	ScreenShotWriter(CommandController& commandController,
+	                 EventDistributor& eventDistributor);
+	~ScreenShotWriter();
+
+	/** Queue an image to be written to the given file. When done, the
+	  * (non-empty) callback is executed with two extra arguments: 'ok'
+	  * and the filename, or 'error' and the error message.
+	  * @throws MSXException If the file can't be created.
+	  */
+	void write(PNG::Image image, std::string filename,
+	           const PNG::Options& options, TclObject callback);
+
+private:
+	struct Result {
+		unsigned id;
+		bool ok;
+		std::string value;
+	};
+
+	// EventListener
+	int signalEvent(const std::shared_ptr<const Event>& event) override;
+
+	CommandController& commandController;
+	EventDistributor& eventDistributor;
+
+	std::vector<std::unique_ptr<WorkerThread>> workers; // created on first use
+	size_t nextWorker = 0;
+
+	// only accessed by the main thread
+	std::map<unsigned, TclObject> callbacks;
+	unsigned lastId = 0;
+
+	std::mutex mutex;
+	std::condition_variable doneCond;
+	std::deque<Result> results; // protected by 'mutex'
+	unsigned pending = 0;       // protected by 'mutex'
+};
+
+} // namespace openmsx
+
+#endif
@@ -338,6 +338,11 @@ private:
 	Clock<VDP::TICKS_PER_SECOND> frameStartTime;
 
 	/** Sprites are checked up to and excluding this display line.
+	  * Lines before this one are never checked again in the same frame:
+	  * a VRAM write only brings the check up to the time of that write
+	  * (updateVRAM()), it doesn't invalidate earlier lines. So each line
+	  * is calculated exactly once per frame, and there's nothing to gain
+	  * from caching results between VRAM changes.
 	  */
 	int currentLine;
 
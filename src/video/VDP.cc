@@ -21,6 +21,7 @@ TODO:
 #include "VDPVRAM.hh"
 #include "VDPCmdEngine.hh"
 #include "SpriteChecker.hh"
+#include "VDPImageCommand.hh"
 #include "Display.hh"
 #include "HardwareConfig.hh"
 #include "RendererFactory.hh"
@@ -200,6 +201,9 @@ VDP::VDP(const DeviceConfig& config)
 	cmdEngine = std::make_unique<VDPCmdEngine>(*this, getCommandController());
 	vram->setCmdEngine(cmdEngine.get());
 
+	imageCommand = std::make_unique<VDPImageCommand>(
+		getCommandController(), *this);
+
 	// Initialise renderer.
 	createRenderer();
 
@@ -952,6 +956,23 @@ byte VDP::readIO(word port, EmuTime::param time)
 	}
 }
 
+bool VDP::isIdlePollIO(word port) const
+{
+	if ((port & (isMSX1VDP() ? 0x01 : 0x03)) != 1) return false;
+	// VBLANK (S#0) and the line interrupt flag (S#1, but only when line
+	// interrupts are enabled) are only set at a sync point. The other
+	// status bits (e.g. HR, VR or the command engine status) depend on
+	// the time at which they're read.
+	switch (controlRegs[15]) {
+	case 0:
+		return true;
+	case 1:
+		return (controlRegs[0] & 0x10) != 0;
+	default:
+		return false;
+	}
+}
+
 byte VDP::peekIO(word /*port*/, EmuTime::param /*time*/) const
 {
 	// TODO not implemented
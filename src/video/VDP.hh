@@ -24,6 +24,7 @@ class VDPCmdEngine;
 class VDPVRAM;
 class MSXCPU;
 class SpriteChecker;
+class VDPImageCommand;
 class Display;
 class RawFrame;
 class Setting;
@@ -78,6 +79,7 @@ public:
 	void reset(EmuTime::param time) override;
 	byte readIO(word port, EmuTime::param time) override;
 	byte peekIO(word port, EmuTime::param time) const override;
+	bool isIdlePollIO(word port) const override;
 	void writeIO(word port, byte value, EmuTime::param time) override;
 
 	/** Used by Video9000 to be able to couple the VDP and V9990 output.
@@ -238,6 +240,14 @@ public:
 		return isDisplayArea && displayEnabled;
 	}
 
+	/** Is the display enabled in the display area?
+	  * Like isDisplayEnabled(), but ignoring the border (only forced
+	  * blanking is taken into account).
+	  */
+	inline bool isBlankingDisabled() const {
+		return displayEnabled;
+	}
+
 	/** Are sprites enabled?
 	  * @return True iff blanking is off, the current mode supports
 	  *   sprites and sprites are not disabled.
@@ -315,6 +325,13 @@ public:
 		return displayStart / TICKS_PER_LINE;
 	}
 
+	/** Gets the number of display lines per screen.
+	  * @return 192 or 212.
+	  */
+	inline int getNumberOfLines() const {
+		return controlRegs[9] & 0x80 ? 212 : 192;
+	}
+
 	/** Is PAL timing active?
 	  * This setting is fixed at start of frame.
 	  * @return True if PAL timing, false if NTSC timing.
@@ -654,13 +671,6 @@ private:
 	void execSetBlank(EmuTime::param time);
 	void execCpuVramAccess(EmuTime::param time);
 
-	/** Gets the number of display lines per screen.
-	  * @return 192 or 212.
-	  */
-	inline int getNumberOfLines() const {
-		return controlRegs[9] & 0x80 ? 212 : 192;
-	}
-
 	/** Returns the amount of vertical set-adjust 0..15.
 	  * Neutral set-adjust (that is 'set adjust(0,0)') returns the value '7'.
 	  */
@@ -900,6 +910,10 @@ private:
 	  */
 	std::unique_ptr<VDPVRAM> vram;
 
+	/** The 'vdp_image' command, renders VRAM tables for debug tools.
+	  */
+	std::unique_ptr<VDPImageCommand> imageCommand;
+
 	/** Is there an external video source which we must superimpose
 	  * upon?
 	  */
@@ -406,6 +406,28 @@ inline byte NonBitmapMode::duplicate(byte color)
 	return color;
 }
 
+/** Check whether the (remaining part of the) destination row of a byte based
+  * command (HMMV/HMMM/YMMM) lies outside all observed VRAM windows. If
+  * so the bytes in this row can be written without notifying the renderer
+  * and sprite checker, see VDPVRAM::cmdWriteUnobserved(). Only for the
+  * non-extended VRAM.
+  */
+template<typename Mode>
+static inline bool isUnobservedRow(
+	const VDPVRAM& vram, unsigned x, unsigned y, int tx, unsigned num)
+{
+	unsigned first = Mode::addressOf(x, y, false);
+	if ((num > 1) &&
+	    ((Mode::addressOf(x + tx, y, false) ^ first) & 0x10000)) {
+		// In the planar modes (SCREEN7/8) consecutive bytes alternate
+		// between both banks. The range then (conservatively) covers
+		// nearly all VRAM, so don't even bother checking.
+		return false;
+	}
+	unsigned last = Mode::addressOf(x + (num - 1) * tx, y, false);
+	return vram.isUnobserved(first, last);
+}
+
 /** Incremental address calculation (byte based, no extended VRAM)
  */
 struct IncrByteAddr4
@@ -1340,10 +1362,14 @@ void VDPCmdEngine::executeHmmv(EmuTime::param limit)
 		ADX, ANX << Mode::PIXELS_PER_BYTE_SHIFT, ARG );
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset = !dstExt || hasExtendedVRAM;
+	bool fastRow = !dstExt && isUnobservedRow<Mode>(vram, ADX, DY, TX, ANX);
 	auto calculator = getSlotCalculator(limit);
 
 	while (!calculator.limitReached()) {
-		if (likely(doPset)) {
+		if (fastRow) {
+			vram.cmdWriteUnobserved(Mode::addressOf(ADX, DY, false),
+			                        COL, calculator.getTime());
+		} else if (likely(doPset)) {
 			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
 			              COL, calculator.getTime());
 		}
@@ -1357,6 +1383,8 @@ void VDPCmdEngine::executeHmmv(EmuTime::param limit)
 				commandDone(calculator.getTime());
 				break;
 			}
+			fastRow = !dstExt &&
+			          isUnobservedRow<Mode>(vram, ADX, DY, TX, ANX);
 		}
 		calculator.next(delta);
 	}
@@ -1448,6 +1476,7 @@ void VDPCmdEngine::executeHmmm(EmuTime::param limit)
 	bool dstExt  = (ARG & MXD) != 0;
 	bool doPoint = !srcExt || hasExtendedVRAM;
 	bool doPset  = !dstExt || hasExtendedVRAM;
+	bool fastRow = !dstExt && isUnobservedRow<Mode>(vram, ADX, DY, TX, ANX);
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
@@ -1461,7 +1490,10 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 		// fall-through
 	case 1: {
 		if (unlikely(calculator.limitReached())) { phase = 1; break; }
-		if (likely(doPset)) {
+		if (fastRow) {
+			vram.cmdWriteUnobserved(Mode::addressOf(ADX, DY, false),
+			                        tmpSrc, calculator.getTime());
+		} else if (likely(doPset)) {
 			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
 			              tmpSrc, calculator.getTime());
 		}
@@ -1475,6 +1507,8 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 				commandDone(calculator.getTime());
 				break;
 			}
+			fastRow = !dstExt &&
+			          isUnobservedRow<Mode>(vram, ADX, DY, TX, ANX);
 		}
 		calculator.next(delta);
 		goto loop;
@@ -1582,6 +1616,7 @@ void VDPCmdEngine::executeYmmm(EmuTime::param limit)
 	//  OTOH YMMM also uses DX for both read and write
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset  = !dstExt || hasExtendedVRAM;
+	bool fastRow = !dstExt && isUnobservedRow<Mode>(vram, ADX, DY, TX, ANX);
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
@@ -1595,7 +1630,10 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 		// fall-through
 	case 1:
 		if (unlikely(calculator.limitReached())) { phase = 1; break; }
-		if (likely(doPset)) {
+		if (fastRow) {
+			vram.cmdWriteUnobserved(Mode::addressOf(ADX, DY, false),
+			                        tmpSrc, calculator.getTime());
+		} else if (likely(doPset)) {
 			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
 			              tmpSrc, calculator.getTime());
 		}
@@ -1608,6 +1646,8 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 				commandDone(calculator.getTime());
 				break;
 			}
+			fastRow = !dstExt &&
+			          isUnobservedRow<Mode>(vram, ADX, DY, TX, ANX);
 		}
 		calculator.next(DELTA_40);
 		goto loop;
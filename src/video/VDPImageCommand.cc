@@ -0,0 +1,216 @@
+#include "VDPImageCommand.hh"
+#include "VDP.hh"
+#include "VDPVRAM.hh"
+#include "CharacterConverter.hh"
+#include "DisplayMode.hh"
+#include "CommandException.hh"
+#include "TclObject.hh"
+#include "build-info.hh"
+#include "span.hh"
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+using Pixel = uint32_t;
+
+// Pixels are stored as R, G, B, A bytes (in that order in memory).
+static Pixel rgba(unsigned r, unsigned g, unsigned b, unsigned a = 255)
+{
+	return OPENMSX_BIGENDIAN
+	     ? ((r << 24) | (g << 16) | (b <<  8) | (a << 0))
+	     : ((r <<  0) | (g <<  8) | (b << 16) | (a << 24));
+}
+
+// Without the gamma/color correction of the renderer, that doesn't matter
+// for debug views.
+static void getPalette(const VDP& vdp, Pixel palette[16])
+{
+	if (vdp.isMSX1VDP()) {
+		auto msx1 = vdp.getMSX1Palette();
+		for (int i = 0; i < 16; ++i) {
+			palette[i] = rgba(msx1[i][0], msx1[i][1], msx1[i][2]);
+		}
+	} else {
+		for (int i = 0; i < 16; ++i) {
+			int grb = vdp.getPalette(i);
+			palette[i] = rgba(((grb >> 4) & 7) * 255 / 7,
+			                  ((grb >> 8) & 7) * 255 / 7,
+			                  ((grb >> 0) & 7) * 255 / 7);
+		}
+	}
+	if (vdp.getTransparency()) {
+		palette[0] = palette[vdp.getBackgroundColor() & 15];
+	}
+}
+
+static void draw8(Pixel* p, Pixel fg, Pixel bg, unsigned pattern)
+{
+	for (int i = 0; i < 8; ++i) {
+		p[i] = (pattern & (0x80 >> i)) ? fg : bg;
+	}
+}
+
+// All pattern tables are shown as a grid of 32 'tiles' per row.
+static unsigned renderPatterns(VDP& vdp, std::vector<Pixel>& pixels)
+{
+	auto& vram = vdp.getVRAM();
+	DisplayMode mode = vdp.getDisplayMode();
+	if (mode.isBitmapMode()) {
+		throw CommandException("No pattern table in bitmap display modes");
+	}
+	Pixel palette[16];
+	getPalette(vdp, palette);
+	Pixel fg = palette[vdp.getForegroundColor() & 15];
+	Pixel bg = palette[vdp.getBackgroundColor() & 15];
+
+	byte base = mode.getBase();
+	bool graphic23 = (base == DisplayMode::GRAPHIC2) ||
+	                 (base == DisplayMode::GRAPHIC3);
+	unsigned numTiles = graphic23 ? 3 * 256 : 256;
+	unsigned height = numTiles / 32 * 8;
+	pixels.resize(256 * height);
+	// Indices in the tables have the unused bits set to 1.
+	unsigned unused = graphic23 ? (~0u << 13) : (~0u << 11);
+	for (unsigned tile = 0; tile < numTiles; ++tile) {
+		Pixel* p = &pixels[(tile / 32) * 8 * 256 + (tile % 32) * 8];
+		for (unsigned y = 0; y < 8; ++y, p += 256) {
+			unsigned index = unused | (tile * 8) | y;
+			unsigned pattern = vram.patternTable.readNP(index);
+			if (graphic23) {
+				unsigned color = vram.colorTable.readNP(index);
+				draw8(p, palette[color >> 4], palette[color & 15],
+				      pattern);
+			} else if (base == DisplayMode::GRAPHIC1) {
+				unsigned color = vram.colorTable.readNP(
+					(~0u << 6) | (tile / 8));
+				draw8(p, palette[color >> 4], palette[color & 15],
+				      pattern);
+			} else if ((base == DisplayMode::MULTICOLOR) ||
+			           (base == DisplayMode::MULTIQ)) {
+				// each byte contains two colors
+				draw8(p, palette[pattern >> 4], palette[pattern & 15],
+				      0xF0);
+			} else {
+				// text modes
+				draw8(p, fg, bg, pattern);
+			}
+		}
+	}
+	return height;
+}
+
+// The screen as rendered from the name table, without sprites and borders.
+static unsigned renderNames(VDP& vdp, std::vector<Pixel>& pixels,
+                            unsigned& width)
+{
+	DisplayMode mode = vdp.getDisplayMode();
+	if (mode.isBitmapMode()) {
+		throw CommandException("No name table in bitmap display modes");
+	}
+	Pixel palette[16];
+	getPalette(vdp, palette);
+	CharacterConverter<Pixel> converter(vdp, palette, palette);
+	converter.setDisplayMode(mode);
+
+	width = mode.getLineWidth();
+	if (mode.isTextMode()) width = width / 256 * 240; // 40 or 80 columns
+	unsigned height = vdp.getNumberOfLines();
+	pixels.resize(width * height);
+	Pixel line[512];
+	for (unsigned y = 0; y < height; ++y) {
+		converter.convertLine(line, y);
+		std::copy(line, line + width, &pixels[y * width]);
+	}
+	return height;
+}
+
+// The sprite pattern table: 8x8 sprites are shown in a grid of 32 per row,
+// 16x16 sprites in a grid of 16 per row.
+static unsigned renderSprites(VDP& vdp, std::vector<Pixel>& pixels)
+{
+	auto& vram = vdp.getVRAM();
+	DisplayMode mode = vdp.getDisplayMode();
+	if (mode.getSpriteMode(vdp.isMSX1VDP()) == 0) {
+		throw CommandException("No sprites in this display mode");
+	}
+	bool planar = mode.isPlanar();
+	auto read = [&](unsigned index) {
+		index |= ~0u << 11;
+		return planar ? vram.spritePatternTable.readPlanar(index)
+		              : vram.spritePatternTable.readNP(index);
+	};
+	const Pixel white = rgba(255, 255, 255);
+	const Pixel transparent = rgba(0, 0, 0, 0);
+
+	pixels.resize(256 * 64);
+	unsigned size = vdp.getSpriteSize();
+	unsigned perRow = 256 / size;
+	unsigned num = (size == 8) ? 256 : 64;
+	for (unsigned sprite = 0; sprite < num; ++sprite) {
+		unsigned x0 = (sprite % perRow) * size;
+		unsigned y0 = (sprite / perRow) * size;
+		// 16x16 sprites consist of 4 patterns: top-left, bottom-left,
+		// top-right, bottom-right
+		for (unsigned q = 0; q < (size * size / 64); ++q) {
+			unsigned x = x0 + (q / 2) * 8;
+			unsigned y = y0 + (q % 2) * 8;
+			unsigned index = (sprite * size * size / 64 + q) * 8;
+			for (unsigned l = 0; l < 8; ++l) {
+				draw8(&pixels[(y + l) * 256 + x], white, transparent,
+				      read(index + l));
+			}
+		}
+	}
+	return 64;
+}
+
+VDPImageCommand::VDPImageCommand(CommandController& controller, VDP& vdp_)
+	: Command(controller, "vdp_image")
+	, vdp(vdp_)
+{
+}
+
+void VDPImageCommand::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 2, "patterns|names|sprites");
+	std::vector<Pixel> pixels;
+	unsigned width = 256;
+	unsigned height = 0;
+	executeSubCommand(tokens[1].getString(),
+		"patterns", [&]{ height = renderPatterns(vdp, pixels); },
+		"names",    [&]{ height = renderNames(vdp, pixels, width); },
+		"sprites",  [&]{ height = renderSprites(vdp, pixels); });
+	result.addListElement(
+		int(width), int(height),
+		span<const uint8_t>(reinterpret_cast<const uint8_t*>(pixels.data()),
+		                    pixels.size() * sizeof(Pixel)));
+}
+
+std::string VDPImageCommand::help(const std::vector<std::string>& /*tokens*/) const
+{
+	return "vdp_image patterns|names|sprites\n"
+	       "Render a VDP table to an image and return it as a list of "
+	       "width, height and the RGBA pixel data (4 bytes per pixel, as "
+	       "binary string). The result can be shown with "
+	       "'osd configure <widget> -imagedata <image>'.\n"
+	       "  patterns  the pattern table, 32 tiles per row, with the "
+	       "colors of the color table (if any)\n"
+	       "  names     the screen as rendered from the name table (without "
+	       "sprites)\n"
+	       "  sprites   the sprite pattern table, white on transparent\n"
+	       "Only the character display modes have a pattern and name "
+	       "table.";
+}
+
+void VDPImageCommand::tabCompletion(std::vector<std::string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static const char* const subCmds[] = {
+			"patterns", "names", "sprites",
+		};
+		completeString(tokens, subCmds);
+	}
+}
+
+} // namespace openmsx
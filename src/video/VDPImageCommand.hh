@@ -0,0 +1,30 @@
+#ifndef VDPIMAGECOMMAND_HH
+#define VDPIMAGECOMMAND_HH
+
+#include "Command.hh"
+
+namespace openmsx {
+
+class VDP;
+
+/** Renders the pattern, name and sprite tables of the VDP to an image, for
+  * debug tools like the tile and sprite viewers. The result can directly be
+  * shown with 'osd configure <widget> -imagedata'. Doing this natively is
+  * orders of magnitude faster than composing the image in Tcl with vpeek.
+  */
+class VDPImageCommand final : public Command
+{
+public:
+	VDPImageCommand(CommandController& controller, VDP& vdp);
+
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	std::string help(const std::vector<std::string>& tokens) const override;
+	void tabCompletion(std::vector<std::string>& tokens) const override;
+
+private:
+	VDP& vdp;
+};
+
+} // namespace openmsx
+
+#endif
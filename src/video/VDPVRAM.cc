@@ -1,9 +1,12 @@
 #include "VDPVRAM.hh"
 #include "SpriteChecker.hh"
+#include "Debugger.hh"
 #include "Renderer.hh"
+#include "MSXMotherBoard.hh"
 #include "Math.hh"
 #include "outer.hh"
 #include "serialize.hh"
+#include "xrange.hh"
 #include <algorithm>
 #include <cstring>
 
@@ -17,6 +20,7 @@ VRAMWindow::VRAMWindow(Ram& vram)
 	: data(&vram[0])
 {
 	observer = &dummyObserver;
+	notifyEnabled = true;
 	baseAddr  = -1; // disable window
 	origBaseMask = 0;
 	effectiveBaseMask = 0;
@@ -69,6 +73,24 @@ void VDPVRAM::LogicalVRAMDebuggable::write(
 	vram.cpuWrite(transform(address), value, time);
 }
 
+void VDPVRAM::LogicalVRAMDebuggable::readBlock(
+	unsigned address, byte* output, unsigned num)
+{
+	// Sync the command engine only once for the whole block. Unlike read()
+	// this doesn't take access slots away from the command engine.
+	auto& vram = OUTER(VDPVRAM, logicalVRAMDebug);
+	vram.sync(getMotherBoard().getCurrentTime());
+	if (vram.vdp.getDisplayMode().isPlanar()) {
+		for (auto i : xrange(num)) {
+			output[i] = vram.data[transform(address + i) & vram.sizeMask];
+		}
+	} else {
+		for (auto i : xrange(num)) {
+			output[i] = vram.data[(address + i) & vram.sizeMask];
+		}
+	}
+}
+
 
 // class PhysicalVRAMDebuggable
 
@@ -94,6 +116,16 @@ void VDPVRAM::PhysicalVRAMDebuggable::write(
 	vram.cpuWrite(address, value, time);
 }
 
+void VDPVRAM::PhysicalVRAMDebuggable::readBlock(
+	unsigned address, byte* output, unsigned num)
+{
+	// See LogicalVRAMDebuggable::readBlock(), the physical VRAM is always
+	// completely present in the buffer.
+	auto& vram = OUTER(VDPVRAM, physicalVRAMDebug);
+	vram.sync(getMotherBoard().getCurrentTime());
+	memcpy(output, &vram.data[address], num);
+}
+
 
 // class VDPVRAM
 
@@ -112,6 +144,9 @@ VDPVRAM::VDPVRAM(VDP& vdp_, unsigned size, EmuTime::param time)
 	, data(*vdp_.getDeviceConfig2().getXML(), bufferSize(size))
 	, logicalVRAMDebug (vdp)
 	, physicalVRAMDebug(vdp, size)
+	, heatmap(vdp.getMotherBoard().getDebugger(),
+	          vdp.getName() == "VDP" ? "VRAM" : vdp.getName() + " VRAM",
+	          "CPU accesses to (physical) VRAM.", size)
 	#ifdef DEBUG
 	, vramTime(EmuTime::zero)
 	#endif
@@ -5,6 +5,7 @@
 #include "VDP.hh"
 #include "VDPCmdEngine.hh"
 #include "SimpleDebuggable.hh"
+#include "Heatmap.hh"
 #include "Ram.hh"
 #include "Math.hh"
 #include "openmsx.hh"
@@ -278,12 +279,30 @@ public:
 	  */
 	inline void setObserver(VRAMObserver* newObserver) {
 		observer = newObserver;
+		notifyEnabled = true;
 	}
 
 	/** Unregister the observer of this VRAM window.
 	  */
 	inline void resetObserver() {
 		observer = &dummyObserver;
+		notifyEnabled = true;
+	}
+
+	/** Temporarily suppress (or again allow) the updateVRAM() calls on
+	  * the observer of this window. The observer can use this while it
+	  * ignores VRAM changes anyway (e.g. the renderer during a skipped
+	  * frame), that saves a virtual call per written byte. Window changes
+	  * are still reported.
+	  */
+	inline void setNotifyEnabled(bool enabled) {
+		notifyEnabled = enabled;
+	}
+
+	/** Will VRAM changes inside this window be reported to the observer?
+	  */
+	inline bool isNotifyEnabled() const {
+		return notifyEnabled;
 	}
 
 	/** Test whether an address is inside this window.
@@ -297,13 +316,25 @@ public:
 		return (address & combiMask) == unsigned(baseAddr);
 	}
 
+	/** Test whether this window might contain an address of the form
+	  *    0bCCCCCCCCCCXXXXXXXX (with C constant and X varying)
+	  * 'address' provides the C part, the 1-bits in 'areaBits' correspond
+	  * with the X part (see also isContinuous(unsigned)). This check is
+	  * conservative: it can return true even if no such address is
+	  * inside this window.
+	  */
+	inline bool mayOverlap(unsigned address, unsigned areaBits) const {
+		return (address & combiMask & ~areaBits) ==
+		       (unsigned(baseAddr) & ~areaBits);
+	}
+
 	/** Notifies the observer of this window of a VRAM change,
 	  * if the changes address is inside this window.
 	  * @param address The address to test.
 	  * @param time The moment in emulated time the change occurs.
 	  */
 	inline void notify(unsigned address, EmuTime::param time) {
-		if (isInside(address)) {
+		if (notifyEnabled && isInside(address)) {
 			observer->updateVRAM(address - baseAddr, time);
 		}
 	}
@@ -374,6 +405,10 @@ private:
 	  */
 	int sizeMask;
 
+	/** See setNotifyEnabled().
+	  */
+	bool notifyEnabled;
+
 	static DummyVRAMOBserver dummyObserver;
 };
 
@@ -424,10 +459,49 @@ public:
 			// to range [0x4000,0x8000)
 			return;
 		}
+		if (unlikely(heatmap.isEnabled())) heatmap.write(address);
 
 		writeCommon(address, value, time);
 	}
 
+	/** Check whether none of the observed windows contain any address in
+	  * the range [first, last] (the order of the two doesn't matter). If
+	  * so, the command engine can write in this range via
+	  * cmdWriteUnobserved(). This check is conservative, it may return
+	  * false for a range that isn't actually observed.
+	  * Note: this remains valid as long as the windows don't change, so
+	  * within a single command engine sync.
+	  */
+	inline bool isUnobserved(unsigned first, unsigned last) const {
+		first &= sizeMask;
+		last  &= sizeMask;
+		unsigned areaBits = Math::floodRight(first ^ last);
+		return !(bitmapVisibleWindow.isNotifyEnabled() &&
+		         bitmapVisibleWindow.mayOverlap(first, areaBits)) &&
+		       !spriteAttribTable  .mayOverlap(first, areaBits) &&
+		       !spritePatternTable .mayOverlap(first, areaBits);
+	}
+
+	/** Same as cmdWrite(), but without notifying the observers. Only
+	  * allowed for an address in a range for which isUnobserved()
+	  * returned true.
+	  */
+	inline void cmdWriteUnobserved(unsigned address, byte value, EmuTime::param time) {
+		#ifdef DEBUG
+		assert(time >= vramTime);
+		vramTime = time;
+		#endif
+		assert(vdp.isInsideFrame(time)); (void)time;
+
+		address &= sizeMask;
+		if (unlikely(address >= actualSize)) return; // see cmdWrite()
+		assert(!bitmapVisibleWindow.isNotifyEnabled() ||
+		       !bitmapVisibleWindow.isInside(address));
+		assert(!spriteAttribTable  .isInside(address));
+		assert(!spritePatternTable .isInside(address));
+		data[address] = value;
+	}
+
 	/** Write a byte to VRAM through the CPU interface.
 	  * @param address The address to write.
 	  * @param value The value to write.
@@ -477,6 +551,9 @@ public:
 		assert(vdp.isInsideFrame(time));
 
 		address &= sizeMask;
+		if (unlikely(heatmap.isEnabled()) && (address < actualSize)) {
+			heatmap.read(address);
+		}
 		if (cmdWriteWindow.isInside(address)) {
 			cmdEngine->sync(time);
 		}
@@ -615,6 +692,7 @@ private:
 		explicit LogicalVRAMDebuggable(VDP& vdp);
 		byte read(unsigned address, EmuTime::param time) override;
 		void write(unsigned address, byte value, EmuTime::param time) override;
+		void readBlock(unsigned address, byte* output, unsigned num) override;
 	private:
 		unsigned transform(unsigned address);
 	} logicalVRAMDebug;
@@ -627,8 +705,12 @@ private:
 		PhysicalVRAMDebuggable(VDP& vdp, unsigned actualSize);
 		byte read(unsigned address, EmuTime::param time) override;
 		void write(unsigned address, byte value, EmuTime::param time) override;
+		void readBlock(unsigned address, byte* output, unsigned num) override;
 	} physicalVRAMDebug;
 
+	/** Counts the CPU accesses per page of (physical) VRAM. */
+	Heatmap heatmap;
+
 	// TODO: Renderer field can be removed, if updateDisplayMode
 	//       and updateDisplayEnabled are moved back to VDP.
 	//       Is that a good idea?
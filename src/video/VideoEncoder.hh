@@ -0,0 +1,37 @@
+#ifndef VIDEOENCODER_HH
+#define VIDEOENCODER_HH
+
+#include <cstdint>
+
+struct SDL_PixelFormat;
+
+namespace openmsx {
+
+/** Interface for the writers of video recordings, see AviRecorder. All
+  * methods are called on the background thread of the recorder.
+  */
+class VideoEncoder
+{
+public:
+	virtual ~VideoEncoder() = default;
+
+	/** Set the frame rate. Called once, after the first frame. */
+	virtual void setFps(float fps) = 0;
+
+	/** Add a frame plus the audio that goes with it.
+	  * @param pixels 'height' lines of 'width' pixels (no padding), or
+	  *               nullptr to repeat the previous frame.
+	  * @param pixelFormat Format of the pixels.
+	  * @param samples Number of audio samples (times number of channels).
+	  * @param sampleData The (interleaved) audio samples.
+	  */
+	virtual void addFrame(const void* pixels, const SDL_PixelFormat& pixelFormat,
+	                      unsigned samples, int16_t* sampleData) = 0;
+
+protected:
+	VideoEncoder() = default;
+};
+
+} // namespace openmsx
+
+#endif
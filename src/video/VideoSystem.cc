@@ -8,8 +8,7 @@ bool VideoSystem::checkSettings()
 	return true;
 }
 
-void VideoSystem::takeScreenShot(
-	const std::string& /*filename*/, bool /*withOsd*/)
+PNG::Image VideoSystem::takeScreenShot(bool /*withOsd*/)
 {
 	throw MSXException(
 		"Taking screenshot not possible with current renderer.");
@@ -1,7 +1,6 @@
 // Code based on DOSBox-0.65
 
 #include "ZMBVEncoder.hh"
-#include "FrameSource.hh"
 #include "PixelOperations.hh"
 #include "endian.hh"
 #include "ranges.hh"
@@ -10,6 +9,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -180,6 +182,7 @@ void ZMBVEncoder::setupBuffers(unsigned bpp)
 	unsigned xblocks = width / BLOCK_WIDTH;
 	unsigned yblocks = height / BLOCK_HEIGHT;
 	blockOffsets.resize(xblocks * yblocks);
+	blockChanges.resize(xblocks * yblocks);
 	for (unsigned y = 0; y < yblocks; ++y) {
 		for (unsigned x = 0; x < xblocks; ++x) {
 			blockOffsets[y * xblocks + x] =
@@ -215,9 +218,38 @@ unsigned ZMBVEncoder::possibleBlock(int vx, int vy, unsigned offset)
 template<class P>
 unsigned ZMBVEncoder::compareBlock(int vx, int vy, unsigned offset)
 {
-	int ret = 0;
 	auto* pold = &(reinterpret_cast<P*>(oldframe.data()))[offset + (vy * pitch) + vx];
 	auto* pnew = &(reinterpret_cast<P*>(newframe.data()))[offset];
+#ifdef __SSE2__
+	// Count the equal pixels, each lane of 'acc' counts for one pixel
+	// position (for 16bpp the maximum count per lane is 32).
+	static const unsigned CHUNKS = (BLOCK_WIDTH * sizeof(P)) / 16;
+	static_assert((CHUNKS * 16) == (BLOCK_WIDTH * sizeof(P)), "");
+	__m128i acc = _mm_setzero_si128();
+	for (unsigned y = 0; y < BLOCK_HEIGHT; ++y) {
+		auto* o = reinterpret_cast<const __m128i*>(pold);
+		auto* n = reinterpret_cast<const __m128i*>(pnew);
+		for (unsigned i = 0; i < CHUNKS; ++i) {
+			__m128i a = _mm_loadu_si128(o + i);
+			__m128i b = _mm_loadu_si128(n + i);
+			// equal -> -1, different -> 0
+			if (sizeof(P) == 4) {
+				acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(a, b));
+			} else {
+				acc = _mm_sub_epi16(acc, _mm_cmpeq_epi16(a, b));
+			}
+		}
+		pold += pitch;
+		pnew += pitch;
+	}
+	if (sizeof(P) == 2) {
+		acc = _mm_madd_epi16(acc, _mm_set1_epi16(1)); // 32-bit lanes
+	}
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+	return BLOCK_WIDTH * BLOCK_HEIGHT - unsigned(_mm_cvtsi128_si32(acc));
+#else
+	int ret = 0;
 	for (unsigned y = 0; y < BLOCK_HEIGHT; ++y) {
 		for (unsigned x = 0; x < BLOCK_WIDTH; ++x) {
 			if (pold[x] != pnew[x]) ++ret;
@@ -226,6 +258,7 @@ unsigned ZMBVEncoder::compareBlock(int vx, int vy, unsigned offset)
 		pnew += pitch;
 	}
 	return ret;
+#endif
 }
 
 template<class P>
@@ -260,33 +293,44 @@ void ZMBVEncoder::addXorFrame(const SDL_PixelFormat& pixelFormat, unsigned& work
 	// Align the following xor data on 4 byte boundary
 	workUsed = (workUsed + blockcount * 2 + 3) & ~3;
 
-	int bestvx = 0;
-	int bestvy = 0;
-	for (unsigned b = 0; b < blockcount; ++b) {
-		unsigned offset = blockOffsets[b];
-		// first try best vector of previous block
-		unsigned bestchange = compareBlock<P>(bestvx, bestvy, offset);
-		if (bestchange >= 4) {
-			int possibles = 64;
-			for (auto& v : vectorTable) {
-				if (possibleBlock<P>(v.x, v.y, offset) < 4) {
-					unsigned testchange = compareBlock<P>(v.x, v.y, offset);
-					if (testchange < bestchange) {
-						bestchange = testchange;
-						bestvx = v.x;
-						bestvy = v.y;
-						if (bestchange < 4) break;
+	// The motion search is done in parallel, one row of blocks per work
+	// item (so within a row the best vector of the previous block can be
+	// tried first). The data for the blocks is added in order afterwards.
+	workers.parallelFor(yblocks, [&](size_t row) {
+		int bestvx = 0;
+		int bestvy = 0;
+		for (unsigned b = unsigned(row) * xblocks;
+		     b < (unsigned(row) + 1) * xblocks; ++b) {
+			unsigned offset = blockOffsets[b];
+			// first try best vector of previous block
+			unsigned bestchange = compareBlock<P>(bestvx, bestvy, offset);
+			if (bestchange >= 4) {
+				int possibles = 64;
+				for (auto& v : vectorTable) {
+					if (possibleBlock<P>(v.x, v.y, offset) < 4) {
+						unsigned testchange = compareBlock<P>(v.x, v.y, offset);
+						if (testchange < bestchange) {
+							bestchange = testchange;
+							bestvx = v.x;
+							bestvy = v.y;
+							if (bestchange < 4) break;
+						}
+						--possibles;
+						if (possibles == 0) break;
 					}
-					--possibles;
-					if (possibles == 0) break;
 				}
 			}
+			vectors[b * 2 + 0] = (bestvx << 1);
+			vectors[b * 2 + 1] = (bestvy << 1);
+			blockChanges[b] = bestchange;
 		}
-		vectors[b * 2 + 0] = (bestvx << 1);
-		vectors[b * 2 + 1] = (bestvy << 1);
-		if (bestchange) {
+	});
+	for (unsigned b = 0; b < blockcount; ++b) {
+		if (blockChanges[b]) {
 			vectors[b * 2 + 0] |= 1;
-			addXorBlock<P>(pixelOps, bestvx, bestvy, offset, workUsed);
+			addXorBlock<P>(pixelOps, vectors[b * 2 + 0] >> 1,
+			               vectors[b * 2 + 1] >> 1,
+			               blockOffsets[b], workUsed);
 		}
 	}
 }
@@ -310,43 +354,8 @@ void ZMBVEncoder::addFullFrame(const SDL_PixelFormat& pixelFormat, unsigned& wor
 	}
 }
 
-const void* ZMBVEncoder::getScaledLine(FrameSource* frame, unsigned y, void* workBuf_)
-{
-#if HAVE_32BPP
-	if (pixelSize == 4) { // 32bpp
-		auto* workBuf = static_cast<uint32_t*>(workBuf_);
-		switch (height) {
-		case 240:
-			return frame->getLinePtr320_240(y, workBuf);
-		case 480:
-			return frame->getLinePtr640_480(y, workBuf);
-		case 720:
-			return frame->getLinePtr960_720(y, workBuf);
-		default:
-			UNREACHABLE;
-		}
-	}
-#endif
-#if HAVE_16BPP
-	if (pixelSize == 2) { // 15bpp or 16bpp
-		auto* workBuf = static_cast<uint16_t*>(workBuf_);
-		switch (height) {
-		case 240:
-			return frame->getLinePtr320_240(y, workBuf);
-		case 480:
-			return frame->getLinePtr640_480(y, workBuf);
-		case 720:
-			return frame->getLinePtr960_720(y, workBuf);
-		default:
-			UNREACHABLE;
-		}
-	}
-#endif
-	UNREACHABLE;
-	return nullptr; // avoid warning
-}
-
-void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
+void ZMBVEncoder::compressFrame(bool keyFrame, const void* pixels,
+                                const SDL_PixelFormat& pixelFormat,
                                 void*& buffer, unsigned& written)
 {
 	std::swap(newframe, oldframe); // replace oldframe with newframe
@@ -374,12 +383,23 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 	// copy lines (to add black border)
 	unsigned linePitch = pitch * pixelSize;
 	unsigned lineWidth = width * pixelSize;
-	uint8_t* dest =
-		&newframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
-	for (unsigned i = 0; i < height; ++i) {
-		auto* scaled = getScaledLine(frame, i, dest);
-		if (scaled != dest) memcpy(dest, scaled, lineWidth);
-		dest += linePitch;
+	unsigned start = pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch);
+	uint8_t* dest = &newframe[start];
+	if (pixels) {
+		auto* src = static_cast<const uint8_t*>(pixels);
+		for (unsigned i = 0; i < height; ++i) {
+			memcpy(dest, src, lineWidth);
+			src += lineWidth;
+			dest += linePitch;
+		}
+	} else {
+		// repeat previous frame
+		const uint8_t* src = &oldframe[start];
+		for (unsigned i = 0; i < height; ++i) {
+			memcpy(dest, src, lineWidth);
+			src += linePitch;
+			dest += linePitch;
+		}
 	}
 
 	// Add the frame data.
@@ -388,12 +408,12 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addFullFrame<uint16_t>(frame->getSDLPixelFormat(), workUsed);
+			addFullFrame<uint16_t>(pixelFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addFullFrame<uint32_t>(frame->getSDLPixelFormat(), workUsed);
+			addFullFrame<uint32_t>(pixelFormat, workUsed);
 			break;
 #endif
 		default:
@@ -404,12 +424,12 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addXorFrame<uint16_t>(frame->getSDLPixelFormat(), workUsed);
+			addXorFrame<uint16_t>(pixelFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addXorFrame<uint32_t>(frame->getSDLPixelFormat(), workUsed);
+			addXorFrame<uint32_t>(pixelFormat, workUsed);
 			break;
 #endif
 		default:
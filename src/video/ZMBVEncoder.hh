@@ -4,6 +4,7 @@
 #define ZMBVENCODER_HH
 
 #include "MemBuffer.hh"
+#include "WorkerPool.hh"
 #include <cstdint>
 #include <zlib.h>
 
@@ -11,7 +12,6 @@ struct SDL_PixelFormat;
 
 namespace openmsx {
 
-class FrameSource;
 template<class P> class PixelOperations;
 
 class ZMBVEncoder
@@ -21,7 +21,12 @@ public:
 
 	ZMBVEncoder(unsigned width, unsigned height, unsigned bpp);
 
-	void compressFrame(bool keyFrame, FrameSource* frame,
+	/** Compress one frame.
+	  * @param pixels 'height' lines of 'width' pixels (no padding), or
+	  *               nullptr to repeat the previous frame.
+	  */
+	void compressFrame(bool keyFrame, const void* pixels,
+	                   const SDL_PixelFormat& pixelFormat,
 	                   void*& buffer, unsigned& written);
 
 private:
@@ -39,16 +44,17 @@ private:
 	template<class P> void addXorBlock(
 		const PixelOperations<P>& pixelOps, int vx, int vy,
 		unsigned offset, unsigned& workUsed);
-	const void* getScaledLine(FrameSource* frame, unsigned y, void* workBuf);
 
 	MemBuffer<uint8_t, SSE2_ALIGNMENT> oldframe;
 	MemBuffer<uint8_t, SSE2_ALIGNMENT> newframe;
 	MemBuffer<uint8_t, SSE2_ALIGNMENT> work;
 	MemBuffer<uint8_t> output;
 	MemBuffer<unsigned> blockOffsets;
+	MemBuffer<unsigned> blockChanges; // result of the motion search
 	unsigned outputSize;
 
 	z_stream zstream;
+	WorkerPool workers; // for the motion search
 
 	const unsigned width;
 	const unsigned height;
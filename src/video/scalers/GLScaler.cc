@@ -12,13 +12,8 @@ GLScaler::GLScaler(const string& progName)
 {
 	for (int i = 0; i < 2; ++i) {
 		string header = strCat("#define SUPERIMPOSE ", char('0' + i), '\n');
-		VertexShader   vShader(header, progName + ".vert");
-		FragmentShader fShader(header, progName + ".frag");
-		program[i].attach(vShader);
-		program[i].attach(fShader);
-		program[i].bindAttribLocation(0, "a_position");
-		program[i].bindAttribLocation(1, "a_texCoord");
-		program[i].link();
+		program[i].build(header, progName + ".vert", progName + ".frag",
+		                 {"a_position", "a_texCoord"});
 		program[i].activate();
 		glUniform1i(program[i].getUniformLocation("tex"), 0);
 		if (i == 1) {
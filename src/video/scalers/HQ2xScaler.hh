@@ -14,6 +14,8 @@ class HQ2xScaler final : public Scaler2<Pixel>
 public:
 	explicit HQ2xScaler(const PixelOperations<Pixel>& pixelOps);
 
+	bool isParallelizable() const override { return true; }
+
 	void scale1x1to3x2(FrameSource& src,
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
@@ -10,6 +10,9 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -74,6 +77,11 @@ public:
 
 		return false;
 	}
+
+	unsigned getShiftR() const { return shiftR; }
+	unsigned getShiftG() const { return shiftG; }
+	unsigned getShiftB() const { return shiftB; }
+
 private:
 	const unsigned shiftR;
 	const unsigned shiftG;
@@ -92,6 +100,110 @@ EdgeHQ createEdgeHQ(const PixelOperations<Pixel>& pixelOps)
 	}
 }
 
+#ifdef __SSE2__
+// Color components of 8 pixels, one component per 16-bit lane.
+struct EdgeHQComponents
+{
+	__m128i r, g, b;
+};
+
+static inline EdgeHQComponents loadEdgeHQComponents(
+	const uint16_t* p, const EdgeHQ& /*edgeOp*/)
+{
+	// same as readPixel() followed by the component extraction in
+	// EdgeHQ (with shifts 0, 8, 16)
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	__m128i mask = _mm_set1_epi16(0xF8);
+	return { _mm_and_si128(_mm_slli_epi16(v, 3), mask),
+	         _mm_and_si128(_mm_srli_epi16(v, 3), mask),
+	         _mm_and_si128(_mm_srli_epi16(v, 8), mask) };
+}
+
+static inline EdgeHQComponents loadEdgeHQComponents(
+	const uint32_t* p, const EdgeHQ& edgeOp)
+{
+	// same as readPixel()
+	__m128i m = _mm_set1_epi32(0xF8F8F8F8);
+	__m128i v0 = _mm_and_si128(m, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0)));
+	__m128i v1 = _mm_and_si128(m, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4)));
+	__m128i mask = _mm_set1_epi32(0xFF);
+	auto comp = [&](unsigned shift) {
+		__m128i s = _mm_cvtsi32_si128(shift);
+		return _mm_packs_epi32(_mm_and_si128(_mm_srl_epi32(v0, s), mask),
+		                       _mm_and_si128(_mm_srl_epi32(v1, s), mask));
+	};
+	return { comp(edgeOp.getShiftR()),
+	         comp(edgeOp.getShiftG()),
+	         comp(edgeOp.getShiftB()) };
+}
+
+static inline __m128i abs16(__m128i x)
+{
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+// Vector version of EdgeHQ::operator(), returns all ones in the 16-bit lanes
+// that contain an edge.
+static inline __m128i edgeHQ(const EdgeHQComponents& c1,
+                             const EdgeHQComponents& c2)
+{
+	__m128i dr = _mm_sub_epi16(c1.r, c2.r);
+	__m128i dg = _mm_sub_epi16(c1.g, c2.g);
+	__m128i db = _mm_sub_epi16(c1.b, c2.b);
+	__m128i dy = _mm_add_epi16(_mm_add_epi16(dr, dg), db);
+	__m128i du = _mm_sub_epi16(dr, db);
+	__m128i dv = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(dg, dg), dg), dy);
+	return _mm_or_si128(
+		_mm_or_si128(_mm_cmpgt_epi16(abs16(dy), _mm_set1_epi16(0xC0)),
+		             _mm_cmpgt_epi16(abs16(du), _mm_set1_epi16(0x1C))),
+		_mm_cmpgt_epi16(abs16(dv), _mm_set1_epi16(0x30)));
+}
+#endif
+
+/** Calculate (for a whole line at once) the edges between the current pixel
+  * (c5), its right neighbour (c6) and the corresponding pixels on the next
+  * line (c8, c9). These are the edges in the pattern that don't overlap with
+  * the previous pixel or previous line:
+  *   bit 0: c5-c8   bit 1: c5-c9   bit 2: c6-c8   bit 3: c5-c6
+  * For the last pixel on the line, c6 and c9 are the same as c5 and c8.
+  */
+template <typename Pixel>
+static void calcEdgesHQ(
+	const Pixel* __restrict curr, const Pixel* __restrict next,
+	unsigned srcWidth, uint8_t* __restrict edges, EdgeHQ edgeOp)
+{
+	unsigned x = 0;
+#ifdef __SSE2__
+	for (/* */; (x + 8) < srcWidth; x += 8) {
+		// 8 pixels per iteration, reads up to curr[x + 8]
+		auto c5 = loadEdgeHQComponents(curr + x + 0, edgeOp);
+		auto c6 = loadEdgeHQComponents(curr + x + 1, edgeOp);
+		auto c8 = loadEdgeHQComponents(next + x + 0, edgeOp);
+		auto c9 = loadEdgeHQComponents(next + x + 1, edgeOp);
+		__m128i bits = _mm_or_si128(
+			_mm_or_si128(
+				_mm_and_si128(edgeHQ(c5, c8), _mm_set1_epi16(1)),
+				_mm_and_si128(edgeHQ(c5, c9), _mm_set1_epi16(2))),
+			_mm_or_si128(
+				_mm_and_si128(edgeHQ(c6, c8), _mm_set1_epi16(4)),
+				_mm_and_si128(edgeHQ(c5, c6), _mm_set1_epi16(8))));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(edges + x),
+		                 _mm_packus_epi16(bits, bits));
+	}
+#endif
+	for (/* */; x < srcWidth; ++x) {
+		unsigned x1 = std::min(x + 1, srcWidth - 1);
+		uint32_t c5 = readPixel(curr[x]);
+		uint32_t c6 = readPixel(curr[x1]);
+		uint32_t c8 = readPixel(next[x]);
+		uint32_t c9 = readPixel(next[x1]);
+		edges[x] = (edgeOp(c5, c8) ? 1 : 0)
+		         | (edgeOp(c5, c9) ? 2 : 0)
+		         | (edgeOp(c6, c8) ? 4 : 0)
+		         | (edgeOp(c5, c6) ? 8 : 0);
+	}
+}
+
 struct EdgeHQLite
 {
 	inline bool operator()(uint32_t c1, uint32_t c2) const
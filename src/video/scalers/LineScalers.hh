@@ -1089,12 +1089,63 @@ AlphaBlendLines<Pixel>::AlphaBlendLines(PixelOperations<Pixel> pixelOps_)
 {
 }
 
+#ifdef __SSE2__
+// SSE2 versions of PixelOperations::alphaBlend() on 4 (32bpp) or 8 (16bpp)
+// pixels, they give bit-exact the same result.
+static inline __m128i alphaBlend32(__m128i p1, __m128i p2, __m128i shift)
+{
+	// alpha of each pixel of p1, duplicated in the 16-bit halves
+	__m128i a = _mm_and_si128(_mm_srl_epi32(p1, shift), _mm_set1_epi32(0xFF));
+	a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+	__m128i aLo = _mm_unpacklo_epi32(a, a);
+	__m128i aHi = _mm_unpackhi_epi32(a, a);
+
+	// Per component: c2 + ((c1 - c2) * a) >> 8. The bits of the product
+	// that end up in the result all fit in a 16-bit lane, also when
+	// (c1 - c2) is negative.
+	__m128i zero = _mm_setzero_si128();
+	__m128i p1Lo = _mm_unpacklo_epi8(p1, zero);
+	__m128i p1Hi = _mm_unpackhi_epi8(p1, zero);
+	__m128i p2Lo = _mm_unpacklo_epi8(p2, zero);
+	__m128i p2Hi = _mm_unpackhi_epi8(p2, zero);
+	__m128i mLo = _mm_srli_epi16(_mm_mullo_epi16(_mm_sub_epi16(p1Lo, p2Lo), aLo), 8);
+	__m128i mHi = _mm_srli_epi16(_mm_mullo_epi16(_mm_sub_epi16(p1Hi, p2Hi), aHi), 8);
+	__m128i mask = _mm_set1_epi16(0xFF);
+	__m128i rLo = _mm_and_si128(_mm_add_epi16(p2Lo, mLo), mask);
+	__m128i rHi = _mm_and_si128(_mm_add_epi16(p2Hi, mHi), mask);
+	return _mm_packus_epi16(rLo, rHi);
+}
+
+static inline __m128i alphaBlend16(__m128i p1, __m128i p2)
+{
+	// TODO keep magic value in sync with OutputSurface::getKeyColor()
+	__m128i key = _mm_cmpeq_epi16(p1, _mm_set1_epi16(0x0001));
+	return _mm_or_si128(_mm_and_si128   (key, p2),
+	                    _mm_andnot_si128(key, p1));
+}
+#endif
+
 template <typename Pixel>
 void AlphaBlendLines<Pixel>::operator()(
 	const Pixel* in1, const Pixel* in2, Pixel* out, size_t width)
 {
 	// It _IS_ allowed that the output is the same as one of the inputs.
-	for (size_t i = 0; i < width; ++i) {
+	size_t i = 0;
+#ifdef __SSE2__
+	// All 16 bytes of the inputs are loaded before the output is stored,
+	// so in-place operation still works.
+	const size_t N = sizeof(__m128i) / sizeof(Pixel);
+	size_t n = width & ~(N - 1);
+	__m128i shift = _mm_cvtsi32_si128(pixelOps.getAshift());
+	for (/**/; i < n; i += N) {
+		__m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in1[i]));
+		__m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in2[i]));
+		__m128i r = (sizeof(Pixel) == 4) ? alphaBlend32(p1, p2, shift)
+		                                 : alphaBlend16(p1, p2);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), r);
+	}
+#endif
+	for (/**/; i < width; ++i) {
 		out[i] = pixelOps.alphaBlend(in1[i], in2[i]);
 	}
 }
@@ -1119,7 +1170,24 @@ void AlphaBlendLines<Pixel>::operator()(
 	//    }
 	Pixel in1M = pixelOps.multiply(in1, alpha);
 	unsigned alpha2 = 256 - alpha;
-	for (size_t i = 0; i < width; ++i) {
+	size_t i = 0;
+#ifdef __SSE2__
+	// Same calculation on 4 pixels at once, multiply() is (c * x) >> 8
+	// per component, which fits in 16 bits. The sum with 'in1M' can't
+	// overflow a component, so it can be done on the packed pixels.
+	__m128i zero = _mm_setzero_si128();
+	__m128i m = _mm_set1_epi32(in1M);
+	__m128i a2 = _mm_set1_epi16(alpha2);
+	size_t n = width & ~3;
+	for (/**/; i < n; i += 4) {
+		__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in2[i]));
+		__m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), a2), 8);
+		__m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), a2), 8);
+		__m128i r = _mm_add_epi8(m, _mm_packus_epi16(lo, hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), r);
+	}
+#endif
+	for (/**/; i < width; ++i) {
 		out[i] = in1M + pixelOps.multiply(in2[i], alpha2);
 	}
 }
@@ -2,16 +2,30 @@
 #include "FrameSource.hh"
 #include "ScalerOutput.hh"
 #include "Math.hh"
-#include "MemBuffer.hh"
 #include "vla.hh"
-#include "build-info.hh"
 #include <algorithm>
-#include <vector>
 #include <cassert>
-#include <cstdint>
+#include <cstring>
 
 namespace openmsx {
 
+// Calls func(i) for all i in [0, num). Consecutive items are grouped in bands
+// of 'bandSize' and the bands are spread over the worker pool, so func must
+// only write data that belongs to its own item.
+template<typename F>
+static void parallelBands(WorkerPool& pool, unsigned num, unsigned bandSize,
+                          const F& func)
+{
+	unsigned numBands = (num + bandSize - 1) / bandSize;
+	pool.parallelFor(numBands, [&](size_t band) {
+		unsigned begin = unsigned(band) * bandSize;
+		unsigned end = std::min(begin + bandSize, num);
+		for (unsigned i = begin; i < end; ++i) {
+			func(i);
+		}
+	});
+}
+
 template <class Pixel>
 MLAAScaler<Pixel>::MLAAScaler(
 		unsigned dstWidth_, const PixelOperations<Pixel>& pixelOps_)
@@ -42,44 +56,35 @@ void MLAAScaler<Pixel>::scaleImage(
 	const int srcNumLines = srcEndY - srcStartY;
 	VLA(const Pixel*, srcLinePtrsArray, srcNumLines + 2);
 	auto** srcLinePtrs = &srcLinePtrsArray[1];
-	std::vector<MemBuffer<Pixel, SSE2_ALIGNMENT>> workBuffer;
+	if (srcWidth > workBufferWidth) {
+		workBuffers.clear();
+		workBufferWidth = srcWidth;
+	}
 	const Pixel* line = nullptr;
 	Pixel* work = nullptr;
+	size_t workUsed = 0;
 	for (int y = -1; y < srcNumLines + 1; y++) {
 		if (line == work) {
-			// Allocate new workBuffer when needed
+			// Take the next workBuffer when needed
 			// e.g. when used in previous iteration
-			workBuffer.emplace_back(srcWidth);
-			work = workBuffer.back().data();
+			if (workUsed == workBuffers.size()) {
+				workBuffers.emplace_back(workBufferWidth);
+			}
+			work = workBuffers[workUsed++].data();
 		}
 		line = src.getLinePtr(srcStartY + y, srcWidth, work);
 		srcLinePtrs[y] = line;
 	}
 
-	enum { UP = 1 << 0, RIGHT = 1 << 1, DOWN = 1 << 2, LEFT = 1 << 3 };
-	MemBuffer<uint8_t> edges(srcNumLines * srcWidth);
-	uint8_t* edgeGenPtr = edges.data();
-	for (int y = 0; y < srcNumLines; y++) {
-		auto* srcLinePtr = srcLinePtrs[y];
-		for (unsigned x = 0; x < srcWidth; x++) {
-			Pixel colMid = srcLinePtr[x];
-			uint8_t pixEdges = 0;
-			if (x > 0 && srcLinePtr[x - 1] != colMid) {
-				pixEdges |= LEFT;
-			}
-			if (x < srcWidth - 1 && srcLinePtr[x + 1] != colMid) {
-				pixEdges |= RIGHT;
-			}
-			if (srcLinePtrs[y - 1][x] != colMid) {
-				pixEdges |= UP;
-			}
-			if (srcLinePtrs[y + 1][x] != colMid) {
-				pixEdges |= DOWN;
-			}
-			*edgeGenPtr++ = pixEdges;
-		}
+	const size_t numPixels = size_t(srcNumLines) * srcWidth;
+	if (numPixels > edgeBufferSize) {
+		edges.resize(numPixels);
+		horizontals.resize(numPixels);
+		verticals.resize(numPixels);
+		edgeBufferSize = numPixels;
 	}
 
+	enum { UP = 1 << 0, RIGHT = 1 << 1, DOWN = 1 << 2, LEFT = 1 << 3 };
 	enum {
 		// Is this pixel part of an edge?
 		// And if so, where on the edge is it?
@@ -104,11 +109,33 @@ void MLAAScaler<Pixel>::scaleImage(
 	};
 	assert(srcWidth <= SPAN_MASK);
 
-	// Find horizontal edges.
-	MemBuffer<unsigned> horizontals(srcNumLines * srcWidth);
-	unsigned* horizontalGenPtr = horizontals.data();
-	const uint8_t* edgePtr = edges.data();
-	for (int y = 0; y < srcNumLines; y++) {
+	// Lines are independent for the edge detection and for finding the
+	// horizontal edges, so both are done per band of lines.
+	parallelBands(workers, srcNumLines, 16, [&](int y) {
+		// Find the edges of each pixel. These loops are written without
+		// branches (the borders are handled separately) so that the compiler
+		// can vectorize the comparisons.
+		auto* srcTopLinePtr = srcLinePtrs[y - 1];
+		auto* srcCurLinePtr = srcLinePtrs[y + 0];
+		auto* srcBotLinePtr = srcLinePtrs[y + 1];
+		uint8_t* edgeGenPtr = &edges[y * srcWidth];
+		for (unsigned x = 0; x < srcWidth; x++) {
+			edgeGenPtr[x] =
+				((srcTopLinePtr[x] != srcCurLinePtr[x]) ? UP   : 0) |
+				((srcBotLinePtr[x] != srcCurLinePtr[x]) ? DOWN : 0);
+		}
+		for (unsigned x = 1; x < srcWidth; x++) {
+			edgeGenPtr[x] |=
+				(srcCurLinePtr[x - 1] != srcCurLinePtr[x]) ? LEFT : 0;
+		}
+		for (unsigned x = 0; x < srcWidth - 1; x++) {
+			edgeGenPtr[x] |=
+				(srcCurLinePtr[x + 1] != srcCurLinePtr[x]) ? RIGHT : 0;
+		}
+
+		// Find horizontal edges.
+		unsigned* horizontalGenPtr = &horizontals[y * srcWidth];
+		const uint8_t* edgePtr = edgeGenPtr;
 		unsigned x = 0;
 		while (x < srcWidth) {
 			// Check which corners are part of a slope.
@@ -183,15 +210,12 @@ void MLAAScaler<Pixel>::scaleImage(
 			}
 		}
 		assert(x == srcWidth);
-		edgePtr += srcWidth;
-	}
-	assert(unsigned(edgePtr - edges.data()) == srcNumLines * srcWidth);
-	assert(unsigned(horizontalGenPtr - horizontals.data()) == srcNumLines * srcWidth);
+		assert(horizontalGenPtr == horizontals.data() + (y + 1) * srcWidth);
+	});
 
-	// Find vertical edges.
-	MemBuffer<unsigned> verticals(srcNumLines * srcWidth);
-	edgePtr = edges.data();
-	for (unsigned x = 0; x < srcWidth; x++) {
+	// Find vertical edges, per band of columns.
+	parallelBands(workers, srcWidth, 32, [&](unsigned x) {
+		const uint8_t* edgePtr = &edges[x];
 		unsigned* verticalGenPtr = &verticals[x];
 		int y = 0;
 		while (y < srcNumLines) {
@@ -274,34 +298,36 @@ void MLAAScaler<Pixel>::scaleImage(
 		}
 		assert(y == srcNumLines);
 		assert(unsigned(verticalGenPtr - verticals.data()) == x + srcNumLines * srcWidth);
-		edgePtr++;
-	}
-	assert(unsigned(edgePtr - edges.data()) == srcWidth);
+	});
 
 	VLA(Pixel*, dstLines, dst.getHeight());
 	for (unsigned i = dstStartY; i < dstEndY; ++i) {
 		dstLines[i] = dst.acquireLine(i);
 	}
 
-	// Do a mosaic scale so every destination pixel has a color.
-	unsigned dstY = dstStartY;
-	for (int y = 0; y < srcNumLines; y++) {
+	// The mosaic scale and the horizontal edges of a source line only write
+	// the destination lines of that source line, so these are done per band
+	// of lines.
+	parallelBands(workers, srcNumLines, 16, [&](int y) {
+		const unsigned dstY = dstStartY + y * zoomFactorY;
+
+		// Do a mosaic scale so every destination pixel has a color.
+		// Only the first line is scaled, the others are copies of it.
 		auto* srcLinePtr = srcLinePtrs[y];
+		auto* dstFirstLinePtr = dstLines[dstY];
 		for (unsigned x = 0; x < srcWidth; x++) {
 			Pixel col = srcLinePtr[x];
-			for (unsigned iy = 0; iy < zoomFactorY; ++iy) {
-				for (unsigned ix = 0; ix < zoomFactorX; ++ix) {
-					dstLines[dstY + iy][x * zoomFactorX + ix] = col;
-				}
+			for (unsigned ix = 0; ix < zoomFactorX; ++ix) {
+				dstFirstLinePtr[x * zoomFactorX + ix] = col;
 			}
 		}
-		dstY += zoomFactorY;
-	}
+		for (unsigned iy = 1; iy < zoomFactorY; ++iy) {
+			memcpy(dstLines[dstY + iy], dstFirstLinePtr,
+			       srcWidth * zoomFactorX * sizeof(Pixel));
+		}
 
-	// Render the horizontal edges.
-	const unsigned* horizontalPtr = horizontals.data();
-	dstY = dstStartY;
-	for (int y = 0; y < srcNumLines; y++) {
+		// Render the horizontal edges.
+		const unsigned* horizontalPtr = &horizontals[y * srcWidth];
 		unsigned x = 0;
 		while (x < srcWidth) {
 			// Fetch information about the edge, if any, at the current pixel.
@@ -465,12 +491,13 @@ void MLAAScaler<Pixel>::scaleImage(
 			}
 		}
 		assert(x == srcWidth);
-		dstY += zoomFactorY;
-	}
-	assert(unsigned(horizontalPtr - horizontals.data()) == srcNumLines * srcWidth);
+		assert(horizontalPtr == horizontals.data() + (y + 1) * srcWidth);
+	});
 
-	// Render the vertical edges.
-	for (unsigned x = 0; x < srcWidth; x++) {
+	// Render the vertical edges. These overwrite the result of the previous
+	// step, they only write the destination columns of their own source
+	// column, so these are done per band of columns.
+	parallelBands(workers, srcWidth, 32, [&](unsigned x) {
 		const unsigned* verticalPtr = &verticals[x];
 		int y = 0;
 		while (y < srcNumLines) {
@@ -637,7 +664,8 @@ void MLAAScaler<Pixel>::scaleImage(
 			}
 		}
 		assert(y == srcNumLines);
-	}
+	});
+	const unsigned dstY = dstStartY + srcNumLines * zoomFactorY;
 
 	// TODO: This is compensation for the fact that we do not support
 	//       non-integer zoom factors yet.
@@ -3,6 +3,11 @@
 
 #include "Scaler.hh"
 #include "PixelOperations.hh"
+#include "MemBuffer.hh"
+#include "WorkerPool.hh"
+#include "build-info.hh"
+#include <cstdint>
+#include <vector>
 
 namespace openmsx {
 
@@ -28,6 +33,16 @@ public:
 private:
 	const PixelOperations<Pixel> pixelOps;
 	const unsigned dstWidth;
+
+	// Reused between frames, they only grow.
+	std::vector<MemBuffer<Pixel, SSE2_ALIGNMENT>> workBuffers;
+	unsigned workBufferWidth = 0;
+	MemBuffer<uint8_t> edges;
+	MemBuffer<unsigned> horizontals;
+	MemBuffer<unsigned> verticals;
+	size_t edgeBufferSize = 0;
+
+	WorkerPool workers; // for the bands of lines / columns
 };
 
 } // namespace openmsx
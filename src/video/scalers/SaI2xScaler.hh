@@ -14,6 +14,9 @@ class SaI2xScaler final : public Scaler2<Pixel>
 {
 public:
 	explicit SaI2xScaler(const PixelOperations<Pixel>& pixelOps);
+
+	bool isParallelizable() const override { return true; }
+
 	void scaleBlank1to2(
 		FrameSource& src, unsigned srcStartY, unsigned srcEndY,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
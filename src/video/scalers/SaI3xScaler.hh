@@ -14,6 +14,9 @@ class SaI3xScaler final : public Scaler3<Pixel>
 {
 public:
 	explicit SaI3xScaler(const PixelOperations<Pixel>& pixelOps);
+
+	bool isParallelizable() const override { return true; }
+
 	void scaleBlank1to3(
 		FrameSource& src, unsigned srcStartY, unsigned srcEndY,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
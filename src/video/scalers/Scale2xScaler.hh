@@ -13,6 +13,8 @@ class Scale2xScaler final : public Scaler2<Pixel>
 public:
 	explicit Scale2xScaler(const PixelOperations<Pixel>& pixelOps);
 
+	bool isParallelizable() const override { return true; }
+
 	void scale1x1to2x2(FrameSource& src,
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
@@ -30,6 +30,14 @@ public:
 	virtual void scaleImage(FrameSource& src, const RawFrame* superImpose,
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) = 0;
+
+	/** Can scaleImage() run concurrently (from different threads) on
+	  * different parts of the same image? This requires that scaling
+	  * doesn't modify any state in the scaler object and that the result
+	  * of a line doesn't depend on how the image is split in parts (though
+	  * it may look at neighbouring source lines).
+	  */
+	virtual bool isParallelizable() const { return false; }
 };
 
 } // namespace openmsx
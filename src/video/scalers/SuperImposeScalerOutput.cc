@@ -1,7 +1,6 @@
 #include "SuperImposeScalerOutput.hh"
 #include "RawFrame.hh"
 #include "LineScalers.hh"
-#include "MemoryOps.hh"
 #include "unreachable.hh"
 #include "vla.hh"
 #include "build-info.hh"
@@ -52,25 +51,27 @@ void SuperImposeScalerOutput<Pixel>::releaseLine(unsigned y, Pixel* buf)
 template<typename Pixel>
 void SuperImposeScalerOutput<Pixel>::fillLine(unsigned y, Pixel color)
 {
+	if (pixelOps.isFullyOpaque(color)) {
+		// The superimposed image is not visible, so let the wrapped
+		// output fill the line itself. E.g. a StretchScalerOutput
+		// then doesn't need to stretch a work buffer full of 'color'.
+		output.fillLine(y, color);
+		return;
+	}
 	auto* dstLine = output.acquireLine(y);
 	unsigned width = output.getWidth();
-	if (pixelOps.isFullyOpaque(color)) {
-		MemoryOps::MemSet<Pixel> memset;
-		memset(dstLine, width, color);
-	} else {
-		auto* srcLine = getSrcLine(y, dstLine);
-		if (pixelOps.isFullyTransparent(color)) {
-			// optimization: use destination as work buffer, in case
-			// that buffer got used, we don't need to make a copy
-			// anymore
-			if (srcLine != dstLine) {
-				Scale_1on1<Pixel> copy;
-				copy(srcLine, dstLine, width);
-			}
-		} else {
-			AlphaBlendLines<Pixel> alphaBlend(pixelOps);
-			alphaBlend(color, srcLine, dstLine, width); // possibly srcLine == dstLine
+	auto* srcLine = getSrcLine(y, dstLine);
+	if (pixelOps.isFullyTransparent(color)) {
+		// optimization: use destination as work buffer, in case
+		// that buffer got used, we don't need to make a copy
+		// anymore
+		if (srcLine != dstLine) {
+			Scale_1on1<Pixel> copy;
+			copy(srcLine, dstLine, width);
 		}
+	} else {
+		AlphaBlendLines<Pixel> alphaBlend(pixelOps);
+		alphaBlend(color, srcLine, dstLine, width); // possibly srcLine == dstLine
 	}
 	output.releaseLine(y, dstLine);
 }
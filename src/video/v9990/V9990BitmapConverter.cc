@@ -1,7 +1,7 @@
 #include "V9990BitmapConverter.hh"
 #include "V9990VRAM.hh"
 #include "V9990.hh"
-#include "Math.hh"
+#include "V9990YUV.hh"
 #include "unreachable.hh"
 #include "build-info.hh"
 #include "components.hh"
@@ -33,22 +33,36 @@ static inline void draw_YJK_YUV_PAL(
 	for (auto& d : data) {
 		d = vram.readVRAMBx(address++);
 	}
-
-	int u = (data[2] & 7) + ((data[3] & 3) << 3) - ((data[3] & 4) << 3);
-	int v = (data[0] & 7) + ((data[1] & 3) << 3) - ((data[1] & 4) << 3);
+	uint16_t rgb[4];
+	V9990YUV::convert4<YJK>(data, rgb);
 
 	for (int i = SKIP ? firstX : 0; i < 4; ++i) {
 		if (PAL && (data[i] & 0x08)) {
 			*out++ = color.lookup64(data[i] >> 4);
 		} else {
-			int y = (data[i] & 0xF8) >> 3;
-			int r = Math::clip<0, 31>(y + u);
-			int g = Math::clip<0, 31>((5 * y - 2 * u - v) / 4);
-			int b = Math::clip<0, 31>(y + v);
-			// The only difference between YUV and YJK is that
-			// green and blue are swapped.
-			if (YJK) std::swap(g, b);
-			*out++ = color.lookup32768((g << 10) + (r << 5) + b);
+			*out++ = color.lookup32768(rgb[i]);
+		}
+	}
+}
+
+// Same as above, but for 2 groups of 4 pixels at once.
+template<bool YJK, bool PAL, typename Pixel, typename ColorLookup>
+static inline void draw_YJK_YUV_PAL_8(
+	ColorLookup color, V9990VRAM& vram,
+	Pixel* __restrict& out, unsigned& address)
+{
+	byte data[8];
+	for (auto& d : data) {
+		d = vram.readVRAMBx(address++);
+	}
+	uint16_t rgb[8];
+	V9990YUV::convert8<YJK>(data, rgb);
+
+	for (int i = 0; i < 8; ++i) {
+		if (PAL && (data[i] & 0x08)) {
+			*out++ = color.lookup64(data[i] >> 4);
+		} else {
+			*out++ = color.lookup32768(rgb[i]);
 		}
 	}
 }
@@ -64,6 +78,9 @@ static void rasterBYUV(
 			color, vram, out, address, x & 3);
 		nrPixels -= 4 - (x & 3);
 	}
+	for (/**/; nrPixels >= 8; nrPixels -= 8) {
+		draw_YJK_YUV_PAL_8<false, false>(color, vram, out, address);
+	}
 	for (/**/; nrPixels > 0; nrPixels -= 4) {
 		draw_YJK_YUV_PAL<false, false, false>(
 			color, vram, out, address);
@@ -84,6 +101,9 @@ static void rasterBYUVP(
 			color, vram, out, address, x & 3);
 		nrPixels -= 4 - (x & 3);
 	}
+	for (/**/; nrPixels >= 8; nrPixels -= 8) {
+		draw_YJK_YUV_PAL_8<false, true>(color, vram, out, address);
+	}
 	for (/**/; nrPixels > 0; nrPixels -= 4) {
 		draw_YJK_YUV_PAL<false, true, false>(
 			color, vram, out, address);
@@ -102,6 +122,9 @@ static void rasterBYJK(
 			color, vram, out, address, x & 3);
 		nrPixels -= 4 - (x & 3);
 	}
+	for (/**/; nrPixels >= 8; nrPixels -= 8) {
+		draw_YJK_YUV_PAL_8<true, false>(color, vram, out, address);
+	}
 	for (/**/; nrPixels > 0; nrPixels -= 4) {
 		draw_YJK_YUV_PAL<true, false, false>(
 			color, vram, out, address);
@@ -122,6 +145,9 @@ static void rasterBYJKP(
 			color, vram, out, address, x & 3);
 		nrPixels -= 4 - (x & 3);
 	}
+	for (/**/; nrPixels >= 8; nrPixels -= 8) {
+		draw_YJK_YUV_PAL_8<true, true>(color, vram, out, address);
+	}
 	for (/**/; nrPixels > 0; nrPixels -= 4) {
 		draw_YJK_YUV_PAL<true, true, false>(
 			color, vram, out, address);
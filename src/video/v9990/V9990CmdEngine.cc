@@ -11,7 +11,9 @@
 #include "serialize.hh"
 #include "likely.hh"
 #include "unreachable.hh"
+#include <cassert>
 #include <iostream>
+#include <type_traits>
 
 namespace openmsx {
 
@@ -657,6 +659,63 @@ inline void V9990CmdEngine::V9990Bpp16::psetColor(
 	vram.writeVRAMDirect(addr + 0x40000, result >> 8);
 }
 
+// --------------------------------------------------------------------
+
+// Returns the number of steps of duration 'delta' (starting at 'time') that
+// can be started before 'limit', but not more than 'max'. The caller must
+// already have checked that 'time < limit'.
+static inline unsigned stepsBefore(EmuTime::param time, EmuTime::param limit,
+                                   EmuDuration::param delta, unsigned max)
+{
+	assert(time < limit);
+	EmuDuration dur = limit - time;
+	if ((delta == EmuDuration::zero) || (dur >= delta * max)) return max;
+	return dur.divUp(delta);
+}
+
+// Apply Mode::psetColor() on 'num' consecutive pixels of a row, starting at
+// 'x' in direction 'dx'. Pixels that together form a complete VRAM byte are
+// handled in a single step. This gives the same result as setting them one by
+// one because the logical operation tables operate on each pixel in a byte
+// independently.
+template<typename Mode>
+static inline void psetColorRow(
+	V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch, unsigned num,
+	int dx, word color, word mask, const byte* lut, byte op,
+	std::true_type /*multiple pixels per byte*/)
+{
+	const unsigned PPB = Mode::PIXELS_PER_BYTE;
+	const unsigned first = (dx > 0) ? 0 : (PPB - 1);
+	while (num) {
+		if ((num >= PPB) && ((x & (PPB - 1)) == first)) {
+			unsigned addr = Mode::addressOf(x, y, pitch);
+			byte srcColor = (addr & 0x40000) ? (color >> 8) : (color & 0xFF);
+			byte dstColor = vram.readVRAMDirect(addr);
+			byte newColor = Mode::logOp(lut, srcColor, dstColor);
+			byte mask1 = (addr & 0x40000) ? (mask >> 8) : (mask & 0xFF);
+			byte result = (dstColor & ~mask1) | (newColor & mask1);
+			vram.writeVRAMDirect(addr, result);
+			x += PPB * dx;
+			num -= PPB;
+		} else {
+			Mode::psetColor(vram, x, y, pitch, color, mask, lut, op);
+			x += dx;
+			--num;
+		}
+	}
+}
+template<typename Mode>
+static inline void psetColorRow(
+	V9990VRAM& vram, unsigned x, unsigned y, unsigned pitch, unsigned num,
+	int dx, word color, word mask, const byte* lut, byte op,
+	std::false_type /*multiple pixels per byte*/)
+{
+	for (unsigned i = 0; i < num; ++i) {
+		Mode::psetColor(vram, x, y, pitch, color, mask, lut, op);
+		x += dx;
+	}
+}
+
 // ====================================================================
 /** Constructor
   */
@@ -1020,19 +1079,21 @@ void V9990CmdEngine::startLMMV(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMV(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(LMMV_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
 	while (engineTime < limit) {
-		engineTime += delta;
-		Mode::psetColor(vram, DX, DY, pitch, fgCol, WM, lut, LOG);
-
-		DX += dx;
-		if (!--(ANX)) {
+		// as many pixels of the current row as fit before 'limit'
+		unsigned num = stepsBefore(engineTime, limit, delta, ANX);
+		engineTime += delta * num;
+		psetColorRow<Mode>(vram, DX, DY, pitch, num, dx, fgCol, WM, lut, LOG,
+		                   std::integral_constant<bool, (Mode::PIXELS_PER_BYTE > 1)>());
+
+		DX += num * dx;
+		ANX -= num;
+		if (!ANX) {
 			DX -= (NX * dx);
 			DY += dy;
 			if (!--(ANY)) {
@@ -1112,22 +1173,25 @@ void V9990CmdEngine::startLMMM(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMM(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(LMMM_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
 	while (engineTime < limit) {
-		engineTime += delta;
-		auto src = Mode::point(vram, SX, SY, pitch);
-		src = Mode::shift(src, SX, DX);
-		Mode::pset(vram, DX, DY, pitch, src, WM, lut, LOG);
+		// as many pixels of the current row as fit before 'limit'
+		unsigned num = stepsBefore(engineTime, limit, delta, ANX);
+		engineTime += delta * num;
+		for (unsigned i = 0; i < num; ++i) {
+			auto src = Mode::point(vram, SX, SY, pitch);
+			src = Mode::shift(src, SX, DX);
+			Mode::pset(vram, DX, DY, pitch, src, WM, lut, LOG);
+			DX += dx;
+			SX += dx;
+		}
 
-		DX += dx;
-		SX += dx;
-		if (!--(ANX)) {
+		ANX -= num;
+		if (!ANX) {
 			DX -= (NX * dx);
 			SX -= (NX * dx);
 			DY += dy;
@@ -189,21 +189,17 @@ void V9990P1Converter<Pixel>::determineVisibleSprites(
 
 	int index = 0;
 	int index_max = 16;
-	for (unsigned sprite = 0; sprite < 125; ++sprite) {
+	for (unsigned sprite : spriteIndex.getSprites(vram, displayY)) {
 		unsigned spriteInfo = spriteTable + 4 * sprite;
-		byte spriteY = vram.readVRAMP1(spriteInfo) + 1;
-		byte posY = displayY - spriteY;
-		if (posY < 16) {
-			byte attr = vram.readVRAMP1(spriteInfo + 3);
-			if (attr & 0x10) {
-				// Invisible sprites do contribute towards the
-				// 16-sprites-per-line limit.
-				index_max--;
-			} else {
-				visibleSprites[index++] = sprite;
-			}
-			if (index == index_max) break;
+		byte attr = vram.readVRAMP1(spriteInfo + 3);
+		if (attr & 0x10) {
+			// Invisible sprites do contribute towards the
+			// 16-sprites-per-line limit.
+			index_max--;
+		} else {
+			visibleSprites[index++] = sprite;
 		}
+		if (index == index_max) break;
 	}
 	// draw sprites in reverse order
 	std::reverse(visibleSprites, visibleSprites + index);
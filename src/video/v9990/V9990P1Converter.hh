@@ -1,6 +1,7 @@
 #ifndef V9990P1CONVERTER_HH
 #define V9990P1CONVERTER_HH
 
+#include "V9990SpriteIndex.hh"
 #include "openmsx.hh"
 
 namespace openmsx {
@@ -23,6 +24,7 @@ private:
 	V9990& vdp;
 	V9990VRAM& vram;
 	const Pixel* const palette64;
+	V9990SpriteIndex spriteIndex;
 
 	void renderPattern(Pixel* buffer, unsigned width1, unsigned width2,
 	                   unsigned displayAX, unsigned displayAY,
@@ -1,6 +1,7 @@
 #ifndef V9990P2CONVERTER_HH
 #define V9990P2CONVERTER_HH
 
+#include "V9990SpriteIndex.hh"
 #include "openmsx.hh"
 
 namespace openmsx {
@@ -28,6 +29,7 @@ private:
 	V9990& vdp;
 	V9990VRAM& vram;
 	const Pixel* const palette64;
+	V9990SpriteIndex spriteIndex;
 };
 
 } // namespace openmsx
@@ -8,6 +8,8 @@
 #include "VideoSystem.hh"
 #include "VideoSourceSetting.hh"
 #include "FinishFrameEvent.hh"
+#include "FrameProfiler.hh"
+#include "Instrumentation.hh"
 #include "RealTime.hh"
 #include "Timer.hh"
 #include "EventDistributor.hh"
@@ -111,7 +113,10 @@ void V9990PixelRenderer::frameEnd(EmuTime::param time)
 		sync(time, true);
 
 		auto time1 = Timer::getTime();
-		rasterizer->frameEnd(time);
+		{
+			INSTRUMENT_ZONE("V9990Rasterizer::frameEnd");
+			rasterizer->frameEnd(time);
+		}
 		auto time2 = Timer::getTime();
 		auto current = time2 - time1;
 		const float ALPHA = 0.2f;
@@ -173,6 +178,10 @@ void V9990PixelRenderer::renderUntil(EmuTime::param time)
 
 	if ((toX == lastX) && (toY == lastY)) return;
 
+	FrameProfiler::Section section(
+		vdp.getReactor().getFrameProfiler(), FrameProfiler::VDP);
+	INSTRUMENT_ZONE("V9990PixelRenderer::renderUntil");
+
 	// edges of the DISPLAY part of the vdp output
 	int left       = vdp.getLeftBorder();
 	int right      = vdp.getRightBorder();
@@ -0,0 +1,66 @@
+#ifndef V9990SPRITEINDEX_HH
+#define V9990SPRITEINDEX_HH
+
+#include "V9990VRAM.hh"
+#include "span.hh"
+#include <cstdint>
+
+namespace openmsx {
+
+/** For each (8-bit) line number, the P1/P2 sprites that cover that line,
+  * in increasing sprite number order. So the converters don't have to scan
+  * the whole sprite attribute table for each line. Which of these sprites
+  * are visible (and the 16 sprites per line limit) is still determined per
+  * line.
+  *
+  * The index is rebuilt when the sprite attribute table changed, so
+  * typically at most once per frame.
+  */
+class V9990SpriteIndex
+{
+public:
+	static const unsigned NUM_SPRITES = 125;
+
+	span<const uint8_t> getSprites(V9990VRAM& vram, uint8_t line) {
+		if (!valid || (version != vram.getSpriteTableVersion())) {
+			update(vram);
+		}
+		return span<const uint8_t>(&entries[start[line]],
+		                           start[line + 1] - start[line]);
+	}
+
+private:
+	void update(V9990VRAM& vram) {
+		// counting sort on line number, keeps the sprite order per line
+		uint8_t spriteY[NUM_SPRITES];
+		unsigned count[256] = {};
+		for (unsigned sprite = 0; sprite < NUM_SPRITES; ++sprite) {
+			spriteY[sprite] = vram.readVRAMDirect(
+				V9990VRAM::SPRITE_TABLE + 4 * sprite) + 1;
+			for (unsigned y = 0; y < 16; ++y) {
+				++count[uint8_t(spriteY[sprite] + y)];
+			}
+		}
+		start[0] = 0;
+		for (unsigned line = 0; line < 256; ++line) {
+			start[line + 1] = start[line] + count[line];
+			count[line] = start[line];
+		}
+		for (unsigned sprite = 0; sprite < NUM_SPRITES; ++sprite) {
+			for (unsigned y = 0; y < 16; ++y) {
+				entries[count[uint8_t(spriteY[sprite] + y)]++] = sprite;
+			}
+		}
+		version = vram.getSpriteTableVersion();
+		valid = true;
+	}
+
+	uint16_t start[256 + 1];
+	uint8_t entries[NUM_SPRITES * 16];
+	unsigned version = 0;
+	bool valid = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -18,6 +18,7 @@ void V9990VRAM::clear()
 	auto size = data.getSize();
 	assert((size % 1024) == 0);
 	auto* d = data.getWriteBackdoor();
+	++spriteTableVersion;
 	auto* e = d + size;
 	while (d != e) {
 		memset(d, 0x00, 512); d += 512;
@@ -48,13 +49,14 @@ byte V9990VRAM::readVRAMCPU(unsigned address, EmuTime::param time)
 void V9990VRAM::writeVRAMCPU(unsigned address, byte value, EmuTime::param time)
 {
 	sync(time);
-	data.write(mapAddress(address), value);
+	write(mapAddress(address), value);
 }
 
 template<typename Archive>
 void V9990VRAM::serialize(Archive& ar, unsigned /*version*/)
 {
 	ar.serialize("data", data);
+	if (ar.isLoader()) ++spriteTableVersion;
 }
 INSTANTIATE_SERIALIZE_METHODS(V9990VRAM);
 
@@ -62,22 +62,28 @@ public:
 	}
 
 	inline void writeVRAMBx(unsigned address, byte value) {
-		data.write(transformBx(address), value);
+		write(transformBx(address), value);
 	}
 	inline void writeVRAMP1(unsigned address, byte value) {
-		data.write(transformP1(address), value);
+		write(transformP1(address), value);
 	}
 	inline void writeVRAMP2(unsigned address, byte value) {
-		data.write(transformP2(address), value);
+		write(transformP2(address), value);
 	}
 
 	inline byte readVRAMDirect(unsigned address) {
 		return data[address];
 	}
 	inline void writeVRAMDirect(unsigned address, byte value) {
-		data.write(address, value);
+		write(address, value);
 	}
 
+	/** The (physical) address of the P1/P2 sprite attribute table. */
+	static const unsigned SPRITE_TABLE = 0x3FE00;
+	/** Changes each time the sprite attribute table (possibly) changes.
+	  * Allows to cache information derived from that table. */
+	unsigned getSpriteTableVersion() const { return spriteTableVersion; }
+
 	byte readVRAMCPU(unsigned address, EmuTime::param time);
 	void writeVRAMCPU(unsigned address, byte val, EmuTime::param time);
 
@@ -89,6 +95,11 @@ public:
 private:
 	unsigned mapAddress(unsigned address);
 
+	inline void write(unsigned address, byte value) {
+		if ((address & ~0x1FF) == SPRITE_TABLE) ++spriteTableVersion;
+		data.write(address, value);
+	}
+
 	/** V9990 VDP this VRAM belongs to.
 	  */
 	V9990& vdp;
@@ -98,6 +109,7 @@ private:
 	/** V9990 VRAM data.
 	  */
 	TrackedRam data;
+	unsigned spriteTableVersion = 0;
 };
 
 } // namespace openmsx
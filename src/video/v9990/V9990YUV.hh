@@ -0,0 +1,104 @@
+#ifndef V9990YUV_HH
+#define V9990YUV_HH
+
+#include "Math.hh"
+#include <cstdint>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Conversion of the V9990 YUV and YJK bitmap modes to 15-bit colors (the
+// index in the 32768-color palette, bits GGGGGRRRRRBBBBB). Each group of 4
+// pixels (4 bytes of VRAM) shares the same U/J and V/K values, each pixel
+// has its own Y value.
+//
+// The SSE2 version calculates exactly the same results as the C++ version.
+
+namespace openmsx {
+namespace V9990YUV {
+
+inline int getU(const uint8_t* data)
+{
+	return (data[2] & 7) + ((data[3] & 3) << 3) - ((data[3] & 4) << 3);
+}
+inline int getV(const uint8_t* data)
+{
+	return (data[0] & 7) + ((data[1] & 3) << 3) - ((data[1] & 4) << 3);
+}
+
+template<bool YJK> inline unsigned toColor15(int y, int u, int v)
+{
+	int r = Math::clip<0, 31>(y + u);
+	int g = Math::clip<0, 31>((5 * y - 2 * u - v) / 4);
+	int b = Math::clip<0, 31>(y + v);
+	// The only difference between YUV and YJK is that green and blue are
+	// swapped.
+	if (YJK) std::swap(g, b);
+	return (g << 10) + (r << 5) + b;
+}
+
+// Convert one group of 4 pixels.
+template<bool YJK> inline void convert4(const uint8_t* data, uint16_t* out)
+{
+	int u = getU(data);
+	int v = getV(data);
+	for (int i = 0; i < 4; ++i) {
+		out[i] = toColor15<YJK>((data[i] & 0xF8) >> 3, u, v);
+	}
+}
+
+// Convert two groups of 4 pixels (8 bytes of VRAM).
+template<bool YJK> inline void convert8(const uint8_t* data, uint16_t* out)
+{
+#ifdef __SSE2__
+	// One 16-bit lane per pixel.
+	__m128i d = _mm_unpacklo_epi8(
+		_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)),
+		_mm_setzero_si128());
+	// data[0..3] of each group, broadcast to all lanes of that group
+	__m128i d0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0x00), 0x00);
+	__m128i d1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0x55), 0x55);
+	__m128i d2 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xAA), 0xAA);
+	__m128i d3 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xFF), 0xFF);
+	__m128i m3 = _mm_set1_epi16(3);
+	__m128i m4 = _mm_set1_epi16(4);
+	__m128i m7 = _mm_set1_epi16(7);
+	__m128i u = _mm_sub_epi16(
+		_mm_add_epi16(_mm_and_si128(d2, m7),
+		              _mm_slli_epi16(_mm_and_si128(d3, m3), 3)),
+		_mm_slli_epi16(_mm_and_si128(d3, m4), 3));
+	__m128i v = _mm_sub_epi16(
+		_mm_add_epi16(_mm_and_si128(d0, m7),
+		              _mm_slli_epi16(_mm_and_si128(d1, m3), 3)),
+		_mm_slli_epi16(_mm_and_si128(d1, m4), 3));
+	__m128i y = _mm_srli_epi16(d, 3);
+
+	__m128i zero = _mm_setzero_si128();
+	__m128i max = _mm_set1_epi16(31);
+	auto clip = [&](__m128i x) {
+		return _mm_min_epi16(_mm_max_epi16(x, zero), max);
+	};
+	__m128i r = clip(_mm_add_epi16(y, u));
+	// (5 * y - 2 * u - v) / 4: the shift rounds negative values down
+	// instead of towards zero, but those are clipped to 0 anyway
+	__m128i t = _mm_sub_epi16(
+		_mm_add_epi16(_mm_slli_epi16(y, 2), y),
+		_mm_add_epi16(_mm_add_epi16(u, u), v));
+	__m128i g = clip(_mm_srai_epi16(t, 2));
+	__m128i b = clip(_mm_add_epi16(y, v));
+	if (YJK) std::swap(g, b);
+	__m128i result = _mm_or_si128(
+		_mm_or_si128(_mm_slli_epi16(g, 10), _mm_slli_epi16(r, 5)), b);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), result);
+#else
+	convert4<YJK>(data + 0, out + 0);
+	convert4<YJK>(data + 4, out + 4);
+#endif
+}
+
+} // namespace V9990YUV
+} // namespace openmsx
+
+#endif